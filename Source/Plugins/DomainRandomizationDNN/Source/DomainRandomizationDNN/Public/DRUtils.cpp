@@ -452,10 +452,16 @@ const int32 MAX_LOADED_ASSETS_BUFFER = 20;
 // How many texture to be async loaded at a time
 const int32 MAX_ASYNC_LOAD_ASSETS_COUNT = 5;
 
+namespace
+{
+    FThreadSafeCounter AsyncLoadingStreamerCounter;
+}
+
 FRandomAssetStreamer::FRandomAssetStreamer()
 {
     AssetDirectories.Reset();
     ManagedAssetClass = nullptr;
+    bIsAsyncLoadingBatch = false;
 
     StreamerCallbackPtr = TSharedPtr<FRandomAssetStreamerCallback>(new FRandomAssetStreamerCallback());
     if (StreamerCallbackPtr.IsValid())
@@ -466,6 +472,7 @@ FRandomAssetStreamer::FRandomAssetStreamer()
 
 FRandomAssetStreamer::FRandomAssetStreamer(const FRandomAssetStreamer& OtherStreamer)
 {
+    bIsAsyncLoadingBatch = false;
     AssetDirectories = OtherStreamer.AssetDirectories;
     ManagedAssetClass = OtherStreamer.ManagedAssetClass;
 
@@ -488,6 +495,7 @@ FRandomAssetStreamer::~FRandomAssetStreamer()
         StreamableHandlePtr->ReleaseHandle();
         StreamableHandlePtr = nullptr;
     }
+    SetAsyncLoadingBatch(false);
 
     AssetDirectories.Reset();
     ManagedAssetClass = nullptr;
@@ -649,6 +657,7 @@ void FRandomAssetStreamer::LoadNextBatch(bool bAsyncLoad/*= true*/)
 
     if (bAsyncLoad)
     {
+        SetAsyncLoadingBatch(true);
         StreamableHandlePtr = AssetStreamer.RequestAsyncLoad(LoadingAssetReferences,
                               FStreamableDelegate::CreateSP(StreamerCallbackPtr.ToSharedRef(), &FRandomAssetStreamerCallback::Callback),
                               FStreamableManager::DefaultAsyncLoadPriority, true);
@@ -660,8 +669,31 @@ void FRandomAssetStreamer::LoadNextBatch(bool bAsyncLoad/*= true*/)
     }
 }
 
+int32 FRandomAssetStreamer::GetAsyncLoadingStreamerCount()
+{
+    return AsyncLoadingStreamerCounter.GetValue();
+}
+
+void FRandomAssetStreamer::SetAsyncLoadingBatch(bool bNewAsyncLoadingBatch)
+{
+    if (bIsAsyncLoadingBatch != bNewAsyncLoadingBatch)
+    {
+        bIsAsyncLoadingBatch = bNewAsyncLoadingBatch;
+        if (bIsAsyncLoadingBatch)
+        {
+            AsyncLoadingStreamerCounter.Increment();
+        }
+        else
+        {
+            AsyncLoadingStreamerCounter.Decrement();
+        }
+    }
+}
+
 void FRandomAssetStreamer::OnAssetBatchLoaded()
 {
+    SetAsyncLoadingBatch(false);
+
     const int32 NewLoadedAssetCount = LoadingAssetReferences.Num();
     if (NewLoadedAssetCount <= 0)
     {
@@ -325,9 +325,13 @@ public:
 
     bool IsLoadingAssets() const;
 
+    /// Number of streamers which are asynchronously loading a batch of assets
+    static int32 GetAsyncLoadingStreamerCount();
+
 protected:
     void LoadNextBatch(bool bAsyncLoad = true);
     void OnAssetBatchLoaded();
+    void SetAsyncLoadingBatch(bool bNewAsyncLoadingBatch);
 
 private:
 
@@ -379,6 +383,9 @@ protected: // Transient properties
 
     TSharedPtr<FStreamableHandle> StreamableHandlePtr;
     TSharedPtr<FRandomAssetStreamerCallback> StreamerCallbackPtr;
+
+    // Whether this streamer is counted in the async loading streamers
+    bool bIsAsyncLoadingBatch;
 };
 
 // This enum is used by random material components to select which components it should modify material
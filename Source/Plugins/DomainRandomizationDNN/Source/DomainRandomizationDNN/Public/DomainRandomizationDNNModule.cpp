@@ -7,17 +7,31 @@
 #include "DomainRandomizationDNNPCH.h"
 #include "DomainRandomizationDNNModule.h"
 #include "ModuleManager.h"
+#include "DRUtils.h"
+#include "NVCaptureReadiness.h"
 
 IMPLEMENT_GAME_MODULE(FDomainRandomizationDNNModule, DomainRandomizationDNN);
 
 #define LOCTEXT_NAMESPACE "DomainRandomizationDNNModule"
 
+namespace
+{
+    const FName RandomAssetStreamingConditionName(TEXT("RandomAssetStreaming"));
+}
+
 void FDomainRandomizationDNNModule::StartupModule()
 {
+    // Don't let the scene capturers start capturing while the randomized assets are still streaming in
+    FNVCaptureReadinessGate::RegisterGlobalCondition(MakeShared<FNVCaptureReadinessCondition_Predicate>(RandomAssetStreamingConditionName,
+        [](UWorld* World)
+    {
+        return (FRandomAssetStreamer::GetAsyncLoadingStreamerCount() <= 0);
+    }));
 }
 
 void FDomainRandomizationDNNModule::ShutdownModule()
 {
+    FNVCaptureReadinessGate::UnregisterGlobalCondition(RandomAssetStreamingConditionName);
 }
 
 #undef LOCTEXT_NAMESPACE
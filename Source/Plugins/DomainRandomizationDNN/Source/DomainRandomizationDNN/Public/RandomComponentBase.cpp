@@ -6,6 +6,7 @@
 
 #include "DomainRandomizationDNNPCH.h"
 #include "RandomComponentBase.h"
+#include "NVSceneCapturerActor.h"
 
 // Sets default values
 URandomComponentBase::URandomComponentBase()
@@ -25,6 +26,7 @@ URandomComponentBase::URandomComponentBase()
 
     bOnlyRandomizeOnce = false;
     bAlreadyRandomized = false;
+    bRandomizeOnRejectedFrame = true;
 }
 
 bool URandomComponentBase::ShouldRandomize() const
@@ -48,10 +50,22 @@ void URandomComponentBase::Randomize(bool bForce)
     if (bForce || ShouldRandomize())
     {
         OnRandomization();
+        MarkOwnerAnnotationDirty();
         bAlreadyRandomized = true;
     }
 }
 
+void URandomComponentBase::MarkOwnerAnnotationDirty()
+{
+    // NOTE: The capturers cache the annotation data of the actors which don't change, let them know this one may have
+    const AActor* OwnerActor = GetOwner();
+    UNVCapturableActorTag* OwnerTag = OwnerActor ? OwnerActor->FindComponentByClass<UNVCapturableActorTag>() : nullptr;
+    if (OwnerTag)
+    {
+        OwnerTag->MarkAnnotationDirty();
+    }
+}
+
 void URandomComponentBase::PostLoad()
 {
     Super::PostLoad();
@@ -82,6 +96,11 @@ void URandomComponentBase::BeginPlay()
 {
     Super::BeginPlay();
 
+    if (bRandomizeOnRejectedFrame)
+    {
+        FrameRejectedHandle = ANVSceneCapturerActor::OnFrameRejected().AddUObject(this, &URandomComponentBase::OnSceneCapturerFrameRejected);
+    }
+
     UpdateRandomization();
     // NOTE: Since the order of the randomizing components matter, just don't mark the component to be already randomized from BeginPlay and wait after its 1rst time randomizing
     bAlreadyRandomized = false;
@@ -90,6 +109,11 @@ void URandomComponentBase::BeginPlay()
 void URandomComponentBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
     CountdownUntilNextRandomization = -1.f;
+    if (FrameRejectedHandle.IsValid())
+    {
+        ANVSceneCapturerActor::OnFrameRejected().Remove(FrameRejectedHandle);
+        FrameRejectedHandle.Reset();
+    }
 
     Super::EndPlay(EndPlayReason);
 }
@@ -108,11 +132,21 @@ void URandomComponentBase::OnFinishedRandomization()
     }
 }
 
+void URandomComponentBase::OnSceneCapturerFrameRejected(ANVSceneCapturerActor* SceneCapturer)
+{
+    // NOTE: Only the scene of the capturer's world need to change
+    if (bRandomizeOnRejectedFrame && SceneCapturer && (SceneCapturer->GetWorld() == GetWorld()))
+    {
+        UpdateRandomization();
+    }
+}
+
 void URandomComponentBase::UpdateRandomization()
 {
     if (ShouldRandomize())
     {
         OnRandomization();
+        MarkOwnerAnnotationDirty();
 
         OnFinishedRandomization();
 
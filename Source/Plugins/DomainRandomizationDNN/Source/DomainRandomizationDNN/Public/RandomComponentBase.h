@@ -36,6 +36,9 @@ protected:
 
     virtual void OnFinishedRandomization();
 
+    /// Randomize again when a scene capturer reject the frame since it doesn't see enough training objects
+    void OnSceneCapturerFrameRejected(class ANVSceneCapturerActor* SceneCapturer);
+
 protected: // Editor properties
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = Randomization)
     bool bShouldRandomize;
@@ -58,12 +61,21 @@ protected: // Editor properties
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Randomization)
     bool bOnlyRandomizeOnce;
 
+    // If true, this component randomize again right away when a scene capturer reject a frame (see the capturer's FrameVisibilitySettings)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Randomization, meta = (EditCondition = bShouldRandomize))
+    bool bRandomizeOnRejectedFrame;
+
 protected: // Transient properties
     UPROPERTY(Transient)
     float CountdownUntilNextRandomization;
     UPROPERTY(Transient)
     bool bAlreadyRandomized;
 
+    FDelegateHandle FrameRejectedHandle;
+
 private:
     void UpdateRandomization();
+
+    /// Let the scene capturers know the owner actor's annotation data must be recomputed
+    void MarkOwnerAnnotationDirty();
 };
@@ -0,0 +1,122 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVActorAnnotationCache.h"
+#include "NVSceneCapturerUtils.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+
+const int32 FNVActorAnnotationCache::MaxUnusedFrameCount = 60;
+
+//================================== FNVActorAnnotationCacheStats ==================================
+FString FNVActorAnnotationCacheStats::ToString() const
+{
+    return FString::Printf(TEXT("Lookups: %lld - Hits: %lld (%.1f%%) - Occlusion hits: %lld"),
+                           LookupCount, HitCount, GetHitRate() * 100.f, OcclusionHitCount);
+}
+
+//================================== FNVActorAnnotationCache::FActorState ==================================
+void FNVActorAnnotationCache::FActorState::Update(const AActor* CheckActor, uint32 InInstanceId)
+{
+    InstanceId = InInstanceId;
+    MeshAssets.Reset();
+    if (!CheckActor)
+    {
+        return;
+    }
+
+    ActorToWorld = CheckActor->GetActorTransform();
+    Bounds = CheckActor->GetComponentsBoundingBox(true);
+
+    TArray<UMeshComponent*> MeshComponents;
+    CheckActor->GetComponents(MeshComponents);
+    for (const UMeshComponent* CheckMeshComp : MeshComponents)
+    {
+        if (const UStaticMeshComponent* StaticMeshComp = Cast<UStaticMeshComponent>(CheckMeshComp))
+        {
+            MeshAssets.Add(FObjectKey(StaticMeshComp->GetStaticMesh()));
+        }
+        else if (const USkeletalMeshComponent* SkeletalMeshComp = Cast<USkeletalMeshComponent>(CheckMeshComp))
+        {
+            MeshAssets.Add(FObjectKey(SkeletalMeshComp->GetSkeletalMeshAsset()));
+        }
+    }
+
+    const UNVCapturableActorTag* Tag = CheckActor->FindComponentByClass<UNVCapturableActorTag>();
+    AnnotationVersion = Tag ? Tag->GetAnnotationVersion() : 0;
+}
+
+bool FNVActorAnnotationCache::FActorState::Equals(const FActorState& Other) const
+{
+    // NOTE: The cached data must be the same as the recomputed one so there's no tolerance
+    return (InstanceId == Other.InstanceId)
+           && (AnnotationVersion == Other.AnnotationVersion)
+           && ActorToWorld.Equals(Other.ActorToWorld, 0.f)
+           && (Bounds.IsValid == Other.Bounds.IsValid) && (Bounds.Min == Other.Bounds.Min) && (Bounds.Max == Other.Bounds.Max)
+           && (MeshAssets == Other.MeshAssets);
+}
+
+//================================== FNVActorAnnotationCache ==================================
+FNVActorAnnotationCache::FNVActorAnnotationCache()
+{
+    FrameCounter = 0;
+}
+
+void FNVActorAnnotationCache::BeginFrame()
+{
+    ensure(IsInGameThread());
+
+    FrameCounter++;
+    for (auto It = Entries.CreateIterator(); It; ++It)
+    {
+        if ((FrameCounter - It.Value().LastUsedFrame) > MaxUnusedFrameCount)
+        {
+            It.RemoveCurrent();
+        }
+    }
+}
+
+FNVActorAnnotationCache::FEntry* FNVActorAnnotationCache::Find(const AActor* CheckActor, const FActorState& CurrentState)
+{
+    Stats.LookupCount++;
+
+    FEntry* CachedEntry = Entries.Find(FObjectKey(CheckActor));
+    if (!CachedEntry || !CachedEntry->State.Equals(CurrentState))
+    {
+        return nullptr;
+    }
+
+    Stats.HitCount++;
+    CachedEntry->LastUsedFrame = FrameCounter;
+    return CachedEntry;
+}
+
+bool FNVActorAnnotationCache::FindOcclusion(const FEntry& CachedEntry, const FVector& ViewLocation, int32& OutOccludedVertexCount)
+{
+    if ((CachedEntry.OccludedVertexCount == INDEX_NONE) || (CachedEntry.OcclusionViewLocation != ViewLocation))
+    {
+        return false;
+    }
+
+    Stats.OcclusionHitCount++;
+    OutOccludedVertexCount = CachedEntry.OccludedVertexCount;
+    return true;
+}
+
+void FNVActorAnnotationCache::Add(const AActor* CheckActor, FEntry&& NewEntry)
+{
+    NewEntry.LastUsedFrame = FrameCounter;
+    Entries.Add(FObjectKey(CheckActor), MoveTemp(NewEntry));
+}
+
+void FNVActorAnnotationCache::Reset()
+{
+    Entries.Reset();
+    Stats = FNVActorAnnotationCacheStats();
+    FrameCounter = 0;
+}
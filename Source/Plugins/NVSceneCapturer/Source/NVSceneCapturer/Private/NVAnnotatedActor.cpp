@@ -7,6 +7,7 @@
 #include "NVSceneCapturerUtils.h"
 #include "NVAnnotatedActor.h"
 #include "NVCoordinateComponent.h"
+#include "NVMeshGeometry.h"
 #include "Components/StaticMeshComponent.h"
 #include "Engine.h"
 #if WITH_EDITOR
@@ -143,78 +144,14 @@ void ANVAnnotatedActor::UpdateMeshCuboid()
 
 FMatrix ANVAnnotatedActor::CalculatePCA(const UStaticMesh *Mesh)
 {
-    FMatrix TransformMatrix = FMatrix::Identity;
-
-    if (!Mesh)
-        return TransformMatrix;
-
-    // ✅ UE5-safe: access render data properly
-    const FStaticMeshRenderData *RenderData = Mesh->GetRenderData();
-    if (!RenderData || RenderData->LODResources.Num() == 0)
-        return TransformMatrix;
-
-    const FPositionVertexBuffer &MeshVertexBuffer = RenderData->LODResources[0].VertexBuffers.PositionVertexBuffer;
-    const uint32 VertexCount = MeshVertexBuffer.GetNumVertices();
-    if (VertexCount == 0)
-        return TransformMatrix;
-
-    // Collect all vertices
-    TArray<FVector> MeshVertices;
-    MeshVertices.Reserve(VertexCount);
-    for (uint32 i = 0; i < VertexCount; i++)
-    {
-        // UE5: VertexPosition() returns FVector3f (float) → convert to FVector (double)
-        const FVector3f VertexPosF = MeshVertexBuffer.VertexPosition(i);
-        MeshVertices.Add(FVector(VertexPosF));
-    }
-
-    // Compute mean vertex
-    FVector MeanVertex = FVector::ZeroVector;
-    for (const FVector &V : MeshVertices)
-        MeanVertex += V;
-    MeanVertex /= VertexCount;
-
-    // Compute covariance matrix
-    FMatrix Covariance = FMatrix::Identity;
-    for (int i = 0; i < 3; i++)
-    {
-        for (int j = 0; j < 3; j++)
-        {
-            double Cij = 0.0;
-            for (const FVector &V : MeshVertices)
-            {
-                Cij += (V[i] - MeanVertex[i]) * (V[j] - MeanVertex[j]);
-            }
-            Cij /= VertexCount;
-            Covariance.M[i][j] = static_cast<float>(Cij);
-        }
-    }
-
-    // Eigen decomposition (dominant eigenvector via power method)
-    FVector ZAxis = ComputeEigenVector(Covariance);
-    FVector XAxis, YAxis;
-    ZAxis.FindBestAxisVectors(YAxis, XAxis);
-
-    TransformMatrix = FMatrix(XAxis, YAxis, ZAxis, MeanVertex);
-    return TransformMatrix;
+    // NOTE: The PCA of the mesh is computed once per mesh (or baked in the mesh asset) and shared by all its instances
+    const FNVMeshGeometryData* MeshGeometry = FNVMeshGeometryCache::FindOrBuild(Mesh);
+    return MeshGeometry ? MeshGeometry->GetPCAMatrix() : FMatrix::Identity;
 }
 
 FVector ANVAnnotatedActor::ComputeEigenVector(const FMatrix& Mat)
 {
-    // NOTES: Copied from function ComputeEigenVector in PhysicsASsetUtils.cpp
-    //using the power method: this is ok because we only need the dominate eigenvector and speed is not critical:
-    // http://en.wikipedia.org/wiki/Power_iteration
-    FVector EVector = FVector(0, 0, 1.f);
-    for (int32 i = 0; i < 32; ++i)
-    {
-        float Length = EVector.Size();
-        if (Length > 0.f)
-        {
-            EVector = Mat.TransformVector(EVector) / Length;
-        }
-    }
-
-    return EVector.GetSafeNormal();
+    return FNVMeshGeometryMath::ComputeDominantEigenVector(Mat);
 }
 
 void ANVAnnotatedActor::UpdateStaticMesh()
@@ -0,0 +1,827 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVAnnotationCompression.h"
+#include "Json.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "ThirdParty/zlib/1.3/include/zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+    const uint32 BlockMagic = 0x425A564E; // "NVZB"
+
+    /// The block is compressed with zlib and a preset dictionary
+    const uint8 BlockFlag_Dictionary = 1 << 0;
+
+    struct FCompressedBlockHeader
+    {
+        uint32 Magic;
+        uint8 Format;
+        uint8 Flags;
+        uint8 Reserved[2];
+        uint32 UncompressedSize;
+        uint32 CompressedSize;
+    };
+    static_assert(sizeof(FCompressedBlockHeader) == 16, "The block header must stay the same on all the platforms");
+
+    const TCHAR* const StreamFileExtension = TEXT(".jsonl");
+    const TCHAR* const DictionaryFileExtension = TEXT(".dict");
+
+    int32 GetStreamFileIndex(int32 FrameIndex, int32 FramesPerFile)
+    {
+        return (FramesPerFile > 0) ? (FMath::Max(FrameIndex, 0) / FramesPerFile) : 0;
+    }
+
+    FString MakeStreamFilePath(const FString& StreamFilePathPrefix, int32 FileIndex)
+    {
+        return FString::Printf(TEXT("%s.%06d%s%s"), *StreamFilePathPrefix, FileIndex, StreamFileExtension, *NVAnnotationCompression::CompressedFileExtension);
+    }
+
+    void WriteBlockHeader(TArray<uint8>& OutBlockData, int32 HeaderOffset, ENVAnnotationCompressionFormat CompressionFormat, uint8 Flags,
+                          int32 UncompressedSize, int32 CompressedSize)
+    {
+        FCompressedBlockHeader BlockHeader;
+        BlockHeader.Magic = BlockMagic;
+        BlockHeader.Format = uint8(CompressionFormat);
+        BlockHeader.Flags = Flags;
+        FMemory::Memzero(BlockHeader.Reserved);
+        BlockHeader.UncompressedSize = uint32(UncompressedSize);
+        BlockHeader.CompressedSize = uint32(CompressedSize);
+        FMemory::Memcpy(OutBlockData.GetData() + HeaderOffset, &BlockHeader, sizeof(BlockHeader));
+    }
+
+    /// Decompress a zlib block compressed with a preset dictionary
+    bool InflateWithDictionary(const TArray<uint8>& Dictionary, uint8* UncompressedData, int32 UncompressedSize, const uint8* CompressedData, int32 CompressedSize)
+    {
+        z_stream InflateStream;
+        FMemory::Memzero(InflateStream);
+        if (inflateInit(&InflateStream) != Z_OK)
+        {
+            return false;
+        }
+        InflateStream.next_in = const_cast<Bytef*>(CompressedData);
+        InflateStream.avail_in = uInt(CompressedSize);
+        InflateStream.next_out = UncompressedData;
+        InflateStream.avail_out = uInt(UncompressedSize);
+
+        int Result = inflate(&InflateStream, Z_FINISH);
+        if (Result == Z_NEED_DICT)
+        {
+            // NOTE: zlib check the dictionary is the one the block is compressed with
+            Result = inflateSetDictionary(&InflateStream, Dictionary.GetData(), uInt(Dictionary.Num()));
+            if (Result == Z_OK)
+            {
+                Result = inflate(&InflateStream, Z_FINISH);
+            }
+            else
+            {
+                UE_LOG(LogNVSceneCapturer, Warning, TEXT("The annotation data block is compressed with another dictionary."));
+            }
+        }
+        const bool bResult = (Result == Z_STREAM_END) && (InflateStream.total_out == uLong(UncompressedSize));
+        inflateEnd(&InflateStream);
+        return bResult;
+    }
+
+    //====== Dictionary training ======
+    /// The dictionary is built from the segments of the samples, scored by how many samples share their k-mers
+    const int32 DictionaryKmerSize = 8;
+    const int32 DictionarySegmentSize = 256;
+
+    struct FDictionarySegment
+    {
+        int32 SampleIndex;
+        int32 Offset;
+        int32 Size;
+        int64 Score;
+    };
+
+    uint64 ReadKmer(const uint8* Data)
+    {
+        uint64 Kmer = 0;
+        FMemory::Memcpy(&Kmer, Data, DictionaryKmerSize);
+        return Kmer;
+    }
+
+    /// Score of a segment: the number of other samples sharing each of its k-mers
+    /// NOTE: The k-mers already in the dictionary have a count of 0 so the segments repeating them are worth less
+    int64 ScoreSegment(const FDictionarySegment& Segment, const TArray<TArray<uint8>>& Samples, const TMap<uint64, int32>& KmerCounts, TSet<uint64>& SegmentKmers)
+    {
+        SegmentKmers.Reset();
+        int64 Score = 0;
+        const uint8* SegmentData = Samples[Segment.SampleIndex].GetData() + Segment.Offset;
+        for (int32 KmerOffset = 0; KmerOffset + DictionaryKmerSize <= Segment.Size; KmerOffset++)
+        {
+            const uint64 Kmer = ReadKmer(SegmentData + KmerOffset);
+            bool bAlreadyInSegment = false;
+            SegmentKmers.Add(Kmer, &bAlreadyInSegment);
+            if (!bAlreadyInSegment)
+            {
+                const int32* KmerCount = KmerCounts.Find(Kmer);
+                Score += KmerCount ? FMath::Max(*KmerCount - 1, 0) : 0;
+            }
+        }
+        return Score;
+    }
+}
+
+//================================== NVAnnotationCompression ==================================
+namespace NVAnnotationCompression
+{
+    const FString CompressedFileExtension = TEXT(".nvz");
+    const int32 MaxDictionarySize = 32 * 1024;
+
+    FName GetCompressionFormatName(ENVAnnotationCompressionFormat CompressionFormat)
+    {
+        switch (CompressionFormat)
+        {
+        case ENVAnnotationCompressionFormat::Zlib:
+            return NAME_Zlib;
+        case ENVAnnotationCompressionFormat::Gzip:
+            return NAME_Gzip;
+        case ENVAnnotationCompressionFormat::LZ4:
+            return NAME_LZ4;
+        default:
+            return NAME_Oodle;
+        }
+    }
+
+    bool CompressBlock(ENVAnnotationCompressionFormat CompressionFormat, const uint8* UncompressedData, int32 UncompressedSize, TArray<uint8>& OutBlockData)
+    {
+        if (!UncompressedData || (UncompressedSize <= 0))
+        {
+            return false;
+        }
+
+        const FName FormatName = GetCompressionFormatName(CompressionFormat);
+        const int32 HeaderOffset = OutBlockData.Num();
+        const int32 DataOffset = HeaderOffset + sizeof(FCompressedBlockHeader);
+        int32 CompressedSize = FCompression::CompressMemoryBound(FormatName, UncompressedSize);
+        OutBlockData.SetNumUninitialized(DataOffset + CompressedSize, EAllowShrinking::No);
+        if (!FCompression::CompressMemory(FormatName, OutBlockData.GetData() + DataOffset, CompressedSize, UncompressedData, UncompressedSize))
+        {
+            UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't compress the annotation data with %s."), *FormatName.ToString());
+            OutBlockData.SetNum(HeaderOffset, EAllowShrinking::No);
+            return false;
+        }
+        OutBlockData.SetNum(DataOffset + CompressedSize, EAllowShrinking::No);
+
+        WriteBlockHeader(OutBlockData, HeaderOffset, CompressionFormat, 0, UncompressedSize, CompressedSize);
+        return true;
+    }
+
+    bool DecompressBlocks(const TArray<uint8>& BlockData, TArray<uint8>& OutUncompressedData, const TArray<uint8>* Dictionary)
+    {
+        int64 ReadOffset = 0;
+        while (ReadOffset < BlockData.Num())
+        {
+            FCompressedBlockHeader BlockHeader;
+            if ((ReadOffset + int64(sizeof(BlockHeader))) > BlockData.Num())
+            {
+                // NOTE: A crash can leave the last block of a stream incomplete
+                UE_LOG(LogNVSceneCapturer, Warning, TEXT("The last block of the compressed annotation data is incomplete, it's skipped."));
+                return false;
+            }
+            FMemory::Memcpy(&BlockHeader, BlockData.GetData() + ReadOffset, sizeof(BlockHeader));
+            ReadOffset += sizeof(BlockHeader);
+
+            const bool bUseDictionary = (BlockHeader.Flags & BlockFlag_Dictionary) != 0;
+            if ((BlockHeader.Magic != BlockMagic) || (BlockHeader.Format >= uint8(ENVAnnotationCompressionFormat::NVAnnotationCompressionFormat_MAX))
+                || (bUseDictionary && (BlockHeader.Format != uint8(ENVAnnotationCompressionFormat::Zlib)))
+                || ((ReadOffset + BlockHeader.CompressedSize) > uint64(BlockData.Num())))
+            {
+                UE_LOG(LogNVSceneCapturer, Warning, TEXT("The compressed annotation data has an invalid block at offset %lld."), ReadOffset - int64(sizeof(BlockHeader)));
+                return false;
+            }
+            if (bUseDictionary && (!Dictionary || (Dictionary->Num() == 0)))
+            {
+                UE_LOG(LogNVSceneCapturer, Warning, TEXT("The compressed annotation data block at offset %lld need its dictionary."), ReadOffset - int64(sizeof(BlockHeader)));
+                return false;
+            }
+
+            const FName FormatName = GetCompressionFormatName(ENVAnnotationCompressionFormat(BlockHeader.Format));
+            const int32 UncompressedOffset = OutUncompressedData.Num();
+            OutUncompressedData.AddUninitialized(BlockHeader.UncompressedSize);
+            uint8* UncompressedData = OutUncompressedData.GetData() + UncompressedOffset;
+            const uint8* CompressedData = BlockData.GetData() + ReadOffset;
+            const bool bDecompressed = bUseDictionary ? InflateWithDictionary(*Dictionary, UncompressedData, BlockHeader.UncompressedSize, CompressedData, BlockHeader.CompressedSize)
+                                                      : FCompression::UncompressMemory(FormatName, UncompressedData, BlockHeader.UncompressedSize, CompressedData, BlockHeader.CompressedSize);
+            if (!bDecompressed)
+            {
+                UE_LOG(LogNVSceneCapturer, Warning, TEXT("Can't decompress the annotation data block at offset %lld."), ReadOffset - int64(sizeof(BlockHeader)));
+                OutUncompressedData.SetNum(UncompressedOffset, EAllowShrinking::No);
+                return false;
+            }
+            ReadOffset += BlockHeader.CompressedSize;
+        }
+        return true;
+    }
+
+    bool LoadCompressedFileToString(const FString& FilePath, FString& OutFileContent, const TArray<uint8>* Dictionary)
+    {
+        TArray<uint8> BlockData;
+        if (!FFileHelper::LoadFileToArray(BlockData, *FilePath))
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("Can't read the compressed annotation file: %s"), *FilePath);
+            return false;
+        }
+
+        TArray<uint8> UncompressedData;
+        const bool bResult = DecompressBlocks(BlockData, UncompressedData, Dictionary);
+        FFileHelper::BufferToString(OutFileContent, UncompressedData.GetData(), UncompressedData.Num());
+        return bResult;
+    }
+
+    bool TrainDictionary(const TArray<TArray<uint8>>& Samples, int32 MaxSize, TArray<uint8>& OutDictionary)
+    {
+        OutDictionary.Reset();
+        MaxSize = FMath::Min(MaxSize, MaxDictionarySize);
+        if (MaxSize <= 0)
+        {
+            return false;
+        }
+
+        // Count the samples each k-mer is in, a k-mer repeated in a sample is only counted once
+        TMap<uint64, int32> KmerCounts;
+        TSet<uint64> SampleKmers;
+        for (const TArray<uint8>& Sample : Samples)
+        {
+            SampleKmers.Reset();
+            for (int32 KmerOffset = 0; KmerOffset + DictionaryKmerSize <= Sample.Num(); KmerOffset++)
+            {
+                bool bAlreadyInSample = false;
+                const uint64 Kmer = ReadKmer(Sample.GetData() + KmerOffset);
+                SampleKmers.Add(Kmer, &bAlreadyInSample);
+                if (!bAlreadyInSample)
+                {
+                    KmerCounts.FindOrAdd(Kmer)++;
+                }
+            }
+        }
+
+        TArray<FDictionarySegment> SegmentHeap;
+        TSet<uint64> SegmentKmers;
+        for (int32 SampleIndex = 0; SampleIndex < Samples.Num(); SampleIndex++)
+        {
+            const int32 SampleSize = Samples[SampleIndex].Num();
+            for (int32 SegmentOffset = 0; SegmentOffset + DictionaryKmerSize <= SampleSize; SegmentOffset += DictionarySegmentSize)
+            {
+                FDictionarySegment Segment{ SampleIndex, SegmentOffset, FMath::Min(DictionarySegmentSize, SampleSize - SegmentOffset), 0 };
+                Segment.Score = ScoreSegment(Segment, Samples, KmerCounts, SegmentKmers);
+                if (Segment.Score > 0)
+                {
+                    SegmentHeap.Add(Segment);
+                }
+            }
+        }
+
+        auto SegmentScorePredicate = [](const FDictionarySegment& A, const FDictionarySegment& B)
+        {
+            return A.Score > B.Score;
+        };
+        SegmentHeap.Heapify(SegmentScorePredicate);
+
+        // Pick the best segments greedily, the score of a segment only go down when other segments are picked
+        // so it only need to be scored again when it's at the top of the heap
+        TArray<FDictionarySegment> SelectedSegments;
+        int32 DictionarySize = 0;
+        while ((SegmentHeap.Num() > 0) && (DictionarySize < MaxSize))
+        {
+            FDictionarySegment BestSegment;
+            SegmentHeap.HeapPop(BestSegment, SegmentScorePredicate, EAllowShrinking::No);
+            BestSegment.Score = ScoreSegment(BestSegment, Samples, KmerCounts, SegmentKmers);
+            if (BestSegment.Score <= 0)
+            {
+                continue;
+            }
+            if ((SegmentHeap.Num() > 0) && (BestSegment.Score < SegmentHeap.HeapTop().Score))
+            {
+                SegmentHeap.HeapPush(BestSegment, SegmentScorePredicate);
+                continue;
+            }
+
+            for (const uint64 Kmer : SegmentKmers)
+            {
+                if (int32* KmerCount = KmerCounts.Find(Kmer))
+                {
+                    *KmerCount = 0;
+                }
+            }
+            BestSegment.Size = FMath::Min(BestSegment.Size, MaxSize - DictionarySize);
+            DictionarySize += BestSegment.Size;
+            SelectedSegments.Add(BestSegment);
+        }
+
+        // NOTE: zlib encode the closest matches with the fewest bits, the best segments go at the end of the dictionary
+        OutDictionary.Reserve(DictionarySize);
+        for (int32 SegmentIndex = SelectedSegments.Num() - 1; SegmentIndex >= 0; SegmentIndex--)
+        {
+            const FDictionarySegment& Segment = SelectedSegments[SegmentIndex];
+            OutDictionary.Append(Samples[Segment.SampleIndex].GetData() + Segment.Offset, Segment.Size);
+        }
+        return OutDictionary.Num() > 0;
+    }
+}
+
+//================================== FNVAnnotationDictionaryCompressor ==================================
+FNVAnnotationDictionaryCompressor::FNVAnnotationDictionaryCompressor(const TArray<uint8>& InDictionary)
+    : Dictionary(InDictionary)
+{
+    DeflateStream = new z_stream;
+    FMemory::Memzero(*DeflateStream);
+    if (deflateInit(DeflateStream, Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't initialize the annotation dictionary compressor."));
+        delete DeflateStream;
+        DeflateStream = nullptr;
+    }
+}
+
+FNVAnnotationDictionaryCompressor::~FNVAnnotationDictionaryCompressor()
+{
+    if (DeflateStream)
+    {
+        deflateEnd(DeflateStream);
+        delete DeflateStream;
+        DeflateStream = nullptr;
+    }
+}
+
+bool FNVAnnotationDictionaryCompressor::CompressBlock(const uint8* UncompressedData, int32 UncompressedSize, TArray<uint8>& OutBlockData)
+{
+    if (!DeflateStream || !UncompressedData || (UncompressedSize <= 0))
+    {
+        return false;
+    }
+
+    // NOTE: Without dictionary the block is a plain zlib block, any reader can decompress it
+    const bool bUseDictionary = (Dictionary.Num() > 0);
+    if ((deflateReset(DeflateStream) != Z_OK)
+        || (bUseDictionary && (deflateSetDictionary(DeflateStream, Dictionary.GetData(), uInt(Dictionary.Num())) != Z_OK)))
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't reset the annotation dictionary compressor."));
+        return false;
+    }
+
+    const int32 HeaderOffset = OutBlockData.Num();
+    const int32 DataOffset = HeaderOffset + sizeof(FCompressedBlockHeader);
+    const int32 CompressedSizeBound = int32(deflateBound(DeflateStream, uLong(UncompressedSize)));
+    OutBlockData.SetNumUninitialized(DataOffset + CompressedSizeBound, EAllowShrinking::No);
+
+    DeflateStream->next_in = const_cast<Bytef*>(UncompressedData);
+    DeflateStream->avail_in = uInt(UncompressedSize);
+    DeflateStream->next_out = OutBlockData.GetData() + DataOffset;
+    DeflateStream->avail_out = uInt(CompressedSizeBound);
+    if (deflate(DeflateStream, Z_FINISH) != Z_STREAM_END)
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't compress the annotation data with the dictionary."));
+        OutBlockData.SetNum(HeaderOffset, EAllowShrinking::No);
+        return false;
+    }
+    const int32 CompressedSize = int32(DeflateStream->total_out);
+    OutBlockData.SetNum(DataOffset + CompressedSize, EAllowShrinking::No);
+
+    WriteBlockHeader(OutBlockData, HeaderOffset, ENVAnnotationCompressionFormat::Zlib, bUseDictionary ? BlockFlag_Dictionary : 0, UncompressedSize, CompressedSize);
+    return true;
+}
+
+//================================== FNVCompressedAnnotationStreamWriter ==================================
+struct FNVCompressedAnnotationStreamWriter::FStream
+{
+    struct FStreamFile
+    {
+        TUniquePtr<IFileHandle> FileHandle;
+        /// The records not compressed yet in Stream mode
+        TArray<uint8> PendingRecordData;
+        /// The compressed blocks not written yet
+        TArray<uint8> PendingBlockData;
+    };
+
+    FStream(const FString& InStreamFilePathPrefix, const FNVCompressedAnnotationStreamWriter& Writer)
+        : StreamFilePathPrefix(InStreamFilePathPrefix)
+        , CompressionMode(Writer.CompressionMode)
+        , CompressionFormat(Writer.CompressionFormat)
+        , FramesPerFile(Writer.FramesPerFile)
+        , BlockSize(Writer.BlockSize)
+        , DictionaryTrainingFrameCount(Writer.DictionaryTrainingFrameCount)
+        , bAppend(Writer.bAppendToStreamFiles)
+        , bIsStarted(false)
+        , bIsClosed(false)
+    {
+    }
+
+    /// Add a record to its stream file
+    bool WriteRecord(int32 FrameIndex, const uint8* RecordData, int32 RecordSize);
+    void Flush();
+    void Close();
+
+protected:
+    void Start();
+    FStreamFile* FindOrOpenStreamFile(int32 FileIndex);
+    bool WriteDictionaryRecord(int32 FileIndex, const uint8* RecordData, int32 RecordSize);
+    bool TrainDictionary();
+    bool WritePendingData(FStreamFile& StreamFile);
+
+public:
+    /// Guard all the state of the stream, the records of a stream are compressed and written in order
+    FCriticalSection StreamLock;
+
+protected:
+    const FString StreamFilePathPrefix;
+    const ENVAnnotationCompressionMode CompressionMode;
+    const ENVAnnotationCompressionFormat CompressionFormat;
+    const int32 FramesPerFile;
+    const int32 BlockSize;
+    const int32 DictionaryTrainingFrameCount;
+    const bool bAppend;
+
+    /// The opened stream files, by file index
+    TMap<int32, TUniquePtr<FStreamFile>> StreamFileMap;
+    /// The files opened in this session, a file reopened for a late frame is appended to
+    TSet<int32> OpenedFileIndexes;
+
+    /// The compressor of the DictionaryRecords mode, only valid once the dictionary is ready
+    TUniquePtr<FNVAnnotationDictionaryCompressor> DictionaryCompressor;
+    /// The records held back until the dictionary is trained on them
+    TArray<TArray<uint8>> TrainingRecords;
+    TArray<int32> TrainingRecordFileIndexes;
+
+    bool bIsStarted;
+    bool bIsClosed;
+};
+
+void FNVCompressedAnnotationStreamWriter::FStream::Start()
+{
+    bIsStarted = true;
+    if (CompressionMode != ENVAnnotationCompressionMode::DictionaryRecords)
+    {
+        return;
+    }
+
+    // The records already in the stream files of a resumed session need the dictionary they're compressed with
+    const FString DictionaryFilePath = GetDictionaryFilePath(StreamFilePathPrefix);
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    if (!bAppend)
+    {
+        PlatformFile.DeleteFile(*DictionaryFilePath);
+    }
+    else if (PlatformFile.FileExists(*DictionaryFilePath))
+    {
+        TArray<uint8> Dictionary;
+        if (FFileHelper::LoadFileToArray(Dictionary, *DictionaryFilePath) && (Dictionary.Num() > 0))
+        {
+            DictionaryCompressor = MakeUnique<FNVAnnotationDictionaryCompressor>(Dictionary);
+        }
+        else
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("Can't read the annotation compression dictionary, a new one is trained: %s"), *DictionaryFilePath);
+        }
+    }
+}
+
+FNVCompressedAnnotationStreamWriter::FStream::FStreamFile* FNVCompressedAnnotationStreamWriter::FStream::FindOrOpenStreamFile(int32 FileIndex)
+{
+    TUniquePtr<FStreamFile>* ExistingStreamFile = StreamFileMap.Find(FileIndex);
+    if (ExistingStreamFile)
+    {
+        return (*ExistingStreamFile)->FileHandle.IsValid() ? ExistingStreamFile->Get() : nullptr;
+    }
+
+    // The frames come roughly in order: when the stream roll over to a new file, the files before the previous one are done
+    for (auto StreamFileIt = StreamFileMap.CreateIterator(); StreamFileIt; ++StreamFileIt)
+    {
+        if (StreamFileIt.Key() < FileIndex - 1)
+        {
+            FStreamFile& CheckStreamFile = *StreamFileIt.Value();
+            WritePendingData(CheckStreamFile);
+            if (CheckStreamFile.FileHandle.IsValid())
+            {
+                CheckStreamFile.FileHandle->Flush(true);
+            }
+            StreamFileIt.RemoveCurrent();
+        }
+    }
+
+    // NOTE: The stream file is kept even if it can't be opened so the error is only reported once
+    TUniquePtr<FStreamFile>& NewStreamFile = StreamFileMap.Add(FileIndex, MakeUnique<FStreamFile>());
+
+    const FString StreamFilePath = MakeStreamFilePath(StreamFilePathPrefix, FileIndex);
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const FString StreamDirectoryPath = FPaths::GetPath(StreamFilePath);
+    if (!PlatformFile.DirectoryExists(*StreamDirectoryPath))
+    {
+        PlatformFile.CreateDirectoryTree(*StreamDirectoryPath);
+    }
+
+    // NOTE: The blocks are independent, a file closed earlier in the session (late frame) is simply appended to
+    bool bAlreadyOpened = false;
+    OpenedFileIndexes.Add(FileIndex, &bAlreadyOpened);
+    if (!bAppend && !bAlreadyOpened)
+    {
+        PlatformFile.DeleteFile(*StreamFilePath);
+    }
+
+    NewStreamFile->FileHandle.Reset(PlatformFile.OpenWrite(*StreamFilePath, true));
+    if (!NewStreamFile->FileHandle.IsValid())
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't open the compressed annotation stream file for writing: %s"), *StreamFilePath);
+        return nullptr;
+    }
+    return NewStreamFile.Get();
+}
+
+bool FNVCompressedAnnotationStreamWriter::FStream::WritePendingData(FStreamFile& StreamFile)
+{
+    bool bResult = true;
+    if (StreamFile.PendingRecordData.Num() > 0)
+    {
+        bResult = NVAnnotationCompression::CompressBlock(CompressionFormat, StreamFile.PendingRecordData.GetData(), StreamFile.PendingRecordData.Num(), StreamFile.PendingBlockData);
+        StreamFile.PendingRecordData.Reset();
+    }
+    if ((StreamFile.PendingBlockData.Num() > 0) && StreamFile.FileHandle.IsValid())
+    {
+        bResult = StreamFile.FileHandle->Write(StreamFile.PendingBlockData.GetData(), StreamFile.PendingBlockData.Num()) && bResult;
+    }
+    StreamFile.PendingBlockData.Reset();
+    return bResult;
+}
+
+bool FNVCompressedAnnotationStreamWriter::FStream::WriteDictionaryRecord(int32 FileIndex, const uint8* RecordData, int32 RecordSize)
+{
+    FStreamFile* StreamFile = FindOrOpenStreamFile(FileIndex);
+    if (!StreamFile || !DictionaryCompressor->CompressBlock(RecordData, RecordSize, StreamFile->PendingBlockData))
+    {
+        return false;
+    }
+    // NOTE: Each record is its own block, the blocks are only buffered to not write each small record on its own
+    return (StreamFile->PendingBlockData.Num() >= BlockSize) ? WritePendingData(*StreamFile) : true;
+}
+
+bool FNVCompressedAnnotationStreamWriter::FStream::TrainDictionary()
+{
+    TArray<uint8> Dictionary;
+    const FString DictionaryFilePath = GetDictionaryFilePath(StreamFilePathPrefix);
+    if (!NVAnnotationCompression::TrainDictionary(TrainingRecords, NVAnnotationCompression::MaxDictionarySize, Dictionary))
+    {
+        UE_LOG(LogNVSceneCapturer, Warning, TEXT("The first frames of the annotation stream have nothing in common, its records are compressed without dictionary: %s"), *StreamFilePathPrefix);
+    }
+    else if (!FFileHelper::SaveArrayToFile(Dictionary, *DictionaryFilePath))
+    {
+        // NOTE: The records can't be read back without their dictionary
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't save the annotation compression dictionary, the records are compressed without it: %s"), *DictionaryFilePath);
+        Dictionary.Reset();
+    }
+    DictionaryCompressor = MakeUnique<FNVAnnotationDictionaryCompressor>(Dictionary);
+
+    bool bResult = true;
+    for (int32 RecordIndex = 0; RecordIndex < TrainingRecords.Num(); RecordIndex++)
+    {
+        const TArray<uint8>& Record = TrainingRecords[RecordIndex];
+        bResult = WriteDictionaryRecord(TrainingRecordFileIndexes[RecordIndex], Record.GetData(), Record.Num()) && bResult;
+    }
+    TrainingRecords.Empty();
+    TrainingRecordFileIndexes.Empty();
+    return bResult;
+}
+
+bool FNVCompressedAnnotationStreamWriter::FStream::WriteRecord(int32 FrameIndex, const uint8* RecordData, int32 RecordSize)
+{
+    if (bIsClosed)
+    {
+        return false;
+    }
+    if (!bIsStarted)
+    {
+        Start();
+    }
+
+    const int32 FileIndex = GetStreamFileIndex(FrameIndex, FramesPerFile);
+    if (CompressionMode == ENVAnnotationCompressionMode::DictionaryRecords)
+    {
+        if (DictionaryCompressor.IsValid())
+        {
+            return WriteDictionaryRecord(FileIndex, RecordData, RecordSize);
+        }
+
+        TrainingRecords.Emplace(RecordData, RecordSize);
+        TrainingRecordFileIndexes.Add(FileIndex);
+        return (TrainingRecords.Num() >= DictionaryTrainingFrameCount) ? TrainDictionary() : true;
+    }
+
+    FStreamFile* StreamFile = FindOrOpenStreamFile(FileIndex);
+    if (!StreamFile)
+    {
+        return false;
+    }
+    StreamFile->PendingRecordData.Append(RecordData, RecordSize);
+    return (StreamFile->PendingRecordData.Num() >= BlockSize) ? WritePendingData(*StreamFile) : true;
+}
+
+void FNVCompressedAnnotationStreamWriter::FStream::Flush()
+{
+    if (bIsClosed)
+    {
+        return;
+    }
+
+    // NOTE: The records held back for the training must be on the disk too, the dictionary is trained on the frames received so far
+    if (TrainingRecords.Num() > 0)
+    {
+        TrainDictionary();
+    }
+    for (auto& CheckStreamFile : StreamFileMap)
+    {
+        WritePendingData(*CheckStreamFile.Value);
+        if (CheckStreamFile.Value->FileHandle.IsValid())
+        {
+            CheckStreamFile.Value->FileHandle->Flush(true);
+        }
+    }
+}
+
+void FNVCompressedAnnotationStreamWriter::FStream::Close()
+{
+    Flush();
+    StreamFileMap.Reset();
+    DictionaryCompressor.Reset();
+    bIsClosed = true;
+}
+
+FNVCompressedAnnotationStreamWriter::FNVCompressedAnnotationStreamWriter()
+{
+    CompressionMode = ENVAnnotationCompressionMode::Stream;
+    CompressionFormat = ENVAnnotationCompressionFormat::Oodle;
+    FramesPerFile = 0;
+    BlockSize = 0;
+    DictionaryTrainingFrameCount = 0;
+    bIsOpen = false;
+    bAppendToStreamFiles = false;
+}
+
+FNVCompressedAnnotationStreamWriter::~FNVCompressedAnnotationStreamWriter()
+{
+    Close();
+}
+
+void FNVCompressedAnnotationStreamWriter::Open(ENVAnnotationCompressionMode InCompressionMode, ENVAnnotationCompressionFormat InCompressionFormat, int32 InFramesPerFile,
+                                               int32 InBlockSize, int32 InDictionaryTrainingFrameCount, bool bAppend)
+{
+    Close();
+
+    FScopeLock ScopeLock(&WriterLock);
+    CompressionMode = InCompressionMode;
+    CompressionFormat = InCompressionFormat;
+    FramesPerFile = InFramesPerFile;
+    BlockSize = FMath::Max(InBlockSize, 1);
+    DictionaryTrainingFrameCount = FMath::Max(InDictionaryTrainingFrameCount, 1);
+    bAppendToStreamFiles = bAppend;
+    bIsOpen = true;
+}
+
+void FNVCompressedAnnotationStreamWriter::Close()
+{
+    TArray<FStreamPtr> ClosingStreams;
+    {
+        FScopeLock ScopeLock(&WriterLock);
+        StreamMap.GenerateValueArray(ClosingStreams);
+        StreamMap.Reset();
+        bIsOpen = false;
+    }
+
+    // NOTE: The frames being written to a closing stream wait for it then fail, the stream is closed
+    for (const FStreamPtr& ClosingStream : ClosingStreams)
+    {
+        FScopeLock StreamScopeLock(&ClosingStream->StreamLock);
+        ClosingStream->Close();
+    }
+}
+
+bool FNVCompressedAnnotationStreamWriter::IsOpen() const
+{
+    FScopeLock ScopeLock(&WriterLock);
+    return bIsOpen;
+}
+
+FString FNVCompressedAnnotationStreamWriter::GetStreamFilePath(const FString& StreamFilePathPrefix, int32 FrameIndex) const
+{
+    FScopeLock ScopeLock(&WriterLock);
+    return MakeStreamFilePath(StreamFilePathPrefix, GetStreamFileIndex(FrameIndex, FramesPerFile));
+}
+
+FString FNVCompressedAnnotationStreamWriter::GetDictionaryFilePath(const FString& StreamFilePathPrefix)
+{
+    return StreamFilePathPrefix + DictionaryFileExtension;
+}
+
+FNVCompressedAnnotationStreamWriter::FStreamPtr FNVCompressedAnnotationStreamWriter::FindOrAddStream(const FString& StreamFilePathPrefix)
+{
+    FScopeLock ScopeLock(&WriterLock);
+    if (!bIsOpen)
+    {
+        return nullptr;
+    }
+
+    FStreamPtr& Stream = StreamMap.FindOrAdd(StreamFilePathPrefix);
+    if (!Stream.IsValid())
+    {
+        Stream = MakeShared<FStream, ESPMode::ThreadSafe>(StreamFilePathPrefix, *this);
+    }
+    return Stream;
+}
+
+bool FNVCompressedAnnotationStreamWriter::WriteFrame(const FString& StreamFilePathPrefix, int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)
+{
+    if (!AnnotationData.IsValid())
+    {
+        return false;
+    }
+
+    // Serialize the record outside of the locks, the other frames don't wait for it
+    TSharedRef<FJsonObject> RecordJsonObj = MakeShared<FJsonObject>();
+    RecordJsonObj->SetNumberField(TEXT("frame_index"), FrameIndex);
+    for (const auto& SceneField : AnnotationData->Values)
+    {
+        RecordJsonObj->SetField(SceneField.Key, SceneField.Value);
+    }
+    // NOTE: Each record must be on a single line
+    FString RecordLine;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&RecordLine);
+    FJsonSerializer::Serialize(RecordJsonObj, JsonWriter);
+    RecordLine += TEXT("\n");
+    FTCHARToUTF8 UTF8Line(*RecordLine);
+
+    // The writer lock is only held to find the stream, the record is compressed and written under the stream's own lock
+    FStreamPtr Stream = FindOrAddStream(StreamFilePathPrefix);
+    if (!Stream.IsValid())
+    {
+        return false;
+    }
+    FScopeLock StreamScopeLock(&Stream->StreamLock);
+    return Stream->WriteRecord(FrameIndex, reinterpret_cast<const uint8*>(UTF8Line.Get()), UTF8Line.Length());
+}
+
+void FNVCompressedAnnotationStreamWriter::Flush()
+{
+    TArray<FStreamPtr> FlushingStreams;
+    {
+        FScopeLock ScopeLock(&WriterLock);
+        StreamMap.GenerateValueArray(FlushingStreams);
+    }
+
+    for (const FStreamPtr& FlushingStream : FlushingStreams)
+    {
+        FScopeLock StreamScopeLock(&FlushingStream->StreamLock);
+        FlushingStream->Flush();
+    }
+}
+
+bool FNVCompressedAnnotationStreamWriter::ReadStreamFile(const FString& StreamFilePath, TFunctionRef<void(int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)> FrameCallback)
+{
+    // The dictionary is next to the stream files: <prefix>.dict for <prefix>.<file index>.jsonl.nvz
+    FString StreamFilePathPrefix = StreamFilePath;
+    StreamFilePathPrefix.RemoveFromEnd(NVAnnotationCompression::CompressedFileExtension);
+    StreamFilePathPrefix.RemoveFromEnd(StreamFileExtension);
+    int32 FileIndexSeparator = INDEX_NONE;
+    if (StreamFilePathPrefix.FindLastChar(TEXT('.'), FileIndexSeparator) && StreamFilePathPrefix.Mid(FileIndexSeparator + 1).IsNumeric())
+    {
+        StreamFilePathPrefix.LeftInline(FileIndexSeparator);
+    }
+    const FString DictionaryFilePath = GetDictionaryFilePath(StreamFilePathPrefix);
+    TArray<uint8> Dictionary;
+    if (FPaths::FileExists(DictionaryFilePath))
+    {
+        FFileHelper::LoadFileToArray(Dictionary, *DictionaryFilePath);
+    }
+
+    FString StreamFileContent;
+    bool bResult = NVAnnotationCompression::LoadCompressedFileToString(StreamFilePath, StreamFileContent, (Dictionary.Num() > 0) ? &Dictionary : nullptr);
+
+    TArray<FString> RecordLines;
+    StreamFileContent.ParseIntoArrayLines(RecordLines);
+    for (int32 LineIndex = 0; LineIndex < RecordLines.Num(); LineIndex++)
+    {
+        TSharedPtr<FJsonObject> RecordJsonObj;
+        TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<TCHAR>::Create(RecordLines[LineIndex]);
+        int32 FrameIndex = INDEX_NONE;
+        if (!FJsonSerializer::Deserialize(JsonReader, RecordJsonObj) || !RecordJsonObj.IsValid() || !RecordJsonObj->TryGetNumberField(TEXT("frame_index"), FrameIndex))
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("Record %d of the compressed annotation stream file '%s' is invalid, it's skipped."), LineIndex, *StreamFilePath);
+            bResult = false;
+            continue;
+        }
+
+        // Give back the same data the per-frame json file would have
+        RecordJsonObj->RemoveField(TEXT("frame_index"));
+        FrameCallback(FrameIndex, RecordJsonObj);
+    }
+    return bResult;
+}
@@ -0,0 +1,167 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVAnnotationSchema.h"
+#include "NVSceneCapturerUtils.h"
+#include "JsonObjectConverter.h"
+
+namespace
+{
+    /// The data each field is computed from and the properties of FCapturedObjectData it's exported as
+    /// NOTE: Every property of FCapturedObjectData belong to a field (or identify the objects) so the full schema export the same objects as before the schema existed
+    struct FAnnotationFieldInfo
+    {
+        ENVAnnotationField Field;
+        ENVAnnotationInput Inputs;
+        const TCHAR* PropertyNames[5];
+    };
+
+    const FAnnotationFieldInfo AnnotationFieldInfos[] =
+    {
+        { ENVAnnotationField::Location,                ENVAnnotationInput::None,
+          { TEXT("location_worldspace"), TEXT("location"), TEXT("viewpoint_azimuth_angle"), TEXT("viewpoint_altitude_angle"), TEXT("distance_scale") } },
+        { ENVAnnotationField::Rotation,                ENVAnnotationInput::None,
+          { TEXT("rotation_worldspace"), TEXT("quaternion_worldspace"), TEXT("rotation"), TEXT("quaternion_xyzw"), TEXT("bounding_box_forward_direction") } },
+        { ENVAnnotationField::PoseTransform,           ENVAnnotationInput::None,
+          { TEXT("actor_to_world_matrix_ue4"), TEXT("actor_to_world_matrix_opencv"), TEXT("actor_to_camera_matrix"), TEXT("pose_transform") } },
+        { ENVAnnotationField::CuboidCentroid,          ENVAnnotationInput::Cuboid,
+          { TEXT("dimensions_worldspace"), TEXT("bounding_box_center_worldspace"), TEXT("cuboid_centroid") } },
+        { ENVAnnotationField::ProjectedCuboidCentroid, ENVAnnotationInput::Cuboid,       { TEXT("projected_cuboid_centroid"), TEXT("bounding_box_forward_direction_imagespace") } },
+        { ENVAnnotationField::BoundingBox,             ENVAnnotationInput::MeshVertexes, { TEXT("truncated"), TEXT("bounding_box") } },
+        { ENVAnnotationField::Cuboid,                  ENVAnnotationInput::Cuboid,       { TEXT("cuboid") } },
+        { ENVAnnotationField::ProjectedCuboid,         ENVAnnotationInput::Cuboid,       { TEXT("projected_cuboid") } },
+        { ENVAnnotationField::Visibility,              ENVAnnotationInput::Occlusion,    { TEXT("occluded"), TEXT("occlusion"), TEXT("visibility") } },
+        { ENVAnnotationField::Sockets,                 ENVAnnotationInput::Sockets,      { TEXT("socket_data") } },
+        // NOTE: The custom data isn't a property, it's added to the exported objects as is
+        { ENVAnnotationField::CustomData,              ENVAnnotationInput::CustomData,   {} },
+    };
+    static_assert(UE_ARRAY_COUNT(AnnotationFieldInfos) == uint32(ENVAnnotationField::NVAnnotationField_MAX), "All the annotation fields must be described");
+
+    /// The properties which identify the objects, always exported
+    const TCHAR* const IdentityPropertyNames[] = { TEXT("Name"), TEXT("Class"), TEXT("instance_id") };
+
+    /// Inputs which need other inputs to be gathered
+    const TPair<ENVAnnotationInput, ENVAnnotationInput> AnnotationInputDependencies[] =
+    {
+        // The occlusion is traced toward the cuboid's vertexes
+        { ENVAnnotationInput::Occlusion, ENVAnnotationInput::Cuboid },
+    };
+}
+
+//=================================== FNVAnnotationSchema ===================================
+FNVAnnotationSchema::FNVAnnotationSchema()
+{
+    for (const FAnnotationFieldInfo& FieldInfo : AnnotationFieldInfos)
+    {
+        ExportedFields.Add(FieldInfo.Field);
+    }
+}
+
+//=================================== FNVAnnotationFieldSet ===================================
+FNVAnnotationFieldSet::FNVAnnotationFieldSet()
+{
+    FieldMask = 0;
+    ExportedFieldMask = 0;
+    Inputs = ENVAnnotationInput::None;
+}
+
+FNVAnnotationFieldSet FNVAnnotationFieldSet::Resolve(const FNVAnnotationSchema& Schema, bool bUseInstanceMaskBoundingBox)
+{
+    FNVAnnotationFieldSet FieldSet;
+    for (ENVAnnotationField ExportedField : Schema.ExportedFields)
+    {
+        if (ExportedField < ENVAnnotationField::NVAnnotationField_MAX)
+        {
+            FieldSet.ExportedFieldMask |= GetFieldBit(ExportedField);
+        }
+    }
+    FieldSet.FieldMask = FieldSet.ExportedFieldMask;
+
+    // The bounding box filled in from the instance mask start as the bounds of the projected cuboid, used when the mask never come
+    if (bUseInstanceMaskBoundingBox && FieldSet.HasField(ENVAnnotationField::BoundingBox))
+    {
+        FieldSet.FieldMask |= GetFieldBit(ENVAnnotationField::ProjectedCuboid);
+    }
+
+    for (const FAnnotationFieldInfo& FieldInfo : AnnotationFieldInfos)
+    {
+        if (FieldSet.HasField(FieldInfo.Field))
+        {
+            const bool bUseMaskInsteadOfVertexes = bUseInstanceMaskBoundingBox && (FieldInfo.Field == ENVAnnotationField::BoundingBox);
+            FieldSet.Inputs |= bUseMaskInsteadOfVertexes ? ENVAnnotationInput::None : FieldInfo.Inputs;
+        }
+    }
+
+    // Add the inputs the gathered inputs depend on until none is added
+    bool bAddedInput = true;
+    while (bAddedInput)
+    {
+        bAddedInput = false;
+        for (const TPair<ENVAnnotationInput, ENVAnnotationInput>& InputDependency : AnnotationInputDependencies)
+        {
+            if (FieldSet.NeedInput(InputDependency.Key) && !FieldSet.NeedInput(InputDependency.Value))
+            {
+                FieldSet.Inputs |= InputDependency.Value;
+                bAddedInput = true;
+            }
+        }
+    }
+
+    // Find the properties to export, keep their declaration order so the exported objects look the same as before
+    TSet<FName> ExportedPropertyNames;
+    for (const TCHAR* IdentityPropertyName : IdentityPropertyNames)
+    {
+        ExportedPropertyNames.Add(IdentityPropertyName);
+    }
+    for (const FAnnotationFieldInfo& FieldInfo : AnnotationFieldInfos)
+    {
+        if (FieldSet.IsFieldExported(FieldInfo.Field))
+        {
+            for (const TCHAR* PropertyName : FieldInfo.PropertyNames)
+            {
+                if (PropertyName)
+                {
+                    ExportedPropertyNames.Add(PropertyName);
+                }
+            }
+        }
+    }
+    for (TFieldIterator<FProperty> PropertyIt(FCapturedObjectData::StaticStruct()); PropertyIt; ++PropertyIt)
+    {
+        if (ExportedPropertyNames.Contains(PropertyIt->GetFName()))
+        {
+            FieldSet.ExportedProperties.Add(*PropertyIt);
+        }
+    }
+    ensure(FieldSet.ExportedProperties.Num() == ExportedPropertyNames.Num());
+
+    return FieldSet;
+}
+
+TSharedPtr<FJsonObject> FNVAnnotationFieldSet::ObjectDataToJsonObject(const FCapturedObjectData& ObjectData) const
+{
+    FJsonObjectConverter::CustomExportCallback CustomPropertyToJsonValue;
+    CustomPropertyToJsonValue.BindStatic(&NVSceneCapturerUtils::CustomPropertyToJsonValueFunc);
+
+    // NOTE: Same conversion as NVSceneCapturerUtils::UStructToJsonObject, property by property
+    TSharedPtr<FJsonObject> ObjectJsonObj = MakeShareable(new FJsonObject());
+    for (const FProperty* ExportedProperty : ExportedProperties)
+    {
+        const void* PropertyValue = ExportedProperty->ContainerPtrToValuePtr<uint8>(&ObjectData);
+        TSharedPtr<FJsonValue> PropertyJsonValue = FJsonObjectConverter::UPropertyToJsonValue(const_cast<FProperty*>(ExportedProperty), PropertyValue, 0, 0, &CustomPropertyToJsonValue);
+        if (PropertyJsonValue.IsValid())
+        {
+            ObjectJsonObj->SetField(FJsonObjectConverter::StandardizeCase(ExportedProperty->GetAuthoredName()), PropertyJsonValue);
+        }
+    }
+
+    if (IsFieldExported(ENVAnnotationField::CustomData) && ObjectData.custom_data.IsValid())
+    {
+        ObjectJsonObj->SetObjectField(TEXT("custom_data"), ObjectData.custom_data);
+    }
+    return ObjectJsonObj;
+}
@@ -0,0 +1,259 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVCaptureFarmMode.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/HUD.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderCore.h"
+#include "RHI.h"
+
+namespace
+{
+    IConsoleVariable* GetScreenPercentageCVar()
+    {
+        return IConsoleManager::Get().FindConsoleVariable(TEXT("r.ScreenPercentage"));
+    }
+}
+
+//================================== FNVCaptureFarmModeSettings ==================================
+FNVCaptureFarmModeSettings::FNVCaptureFarmModeSettings()
+{
+    bEnabled = false;
+    PreviewInterval = 0.f;
+    PreviewScreenPercentage = 25.f;
+    BaselineFrameCount = 30;
+}
+
+//================================== FNVFrameTimeStats ==================================
+FNVFrameTimeStats::FNVFrameTimeStats()
+{
+    Reset();
+}
+
+void FNVFrameTimeStats::Reset()
+{
+    SampleCount = 0;
+    TotalGameThreadTime = 0.0;
+    TotalGPUTime = 0.0;
+}
+
+void FNVFrameTimeStats::SampleLastFrame()
+{
+    // NOTE: Those are the same counters "stat unit" shows
+    TotalGameThreadTime += FPlatformTime::ToMilliseconds(GGameThreadTime);
+    TotalGPUTime += FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+    SampleCount++;
+}
+
+float FNVFrameTimeStats::GetAverageGameThreadTime() const
+{
+    return (SampleCount > 0) ? (float)(TotalGameThreadTime / SampleCount) : 0.f;
+}
+
+float FNVFrameTimeStats::GetAverageGPUTime() const
+{
+    return (SampleCount > 0) ? (float)(TotalGPUTime / SampleCount) : 0.f;
+}
+
+//================================== FNVCaptureFarmMode ==================================
+FNVCaptureFarmMode::FNVCaptureFarmMode()
+{
+    bIsActive = false;
+    bRenderingSuppressed = false;
+    BaselineFramesLeft = 0;
+    bSavedDisableWorldRendering = false;
+    SavedScreenPercentage = 100.f;
+    bRenderingPreview = false;
+    TimeSinceLastPreview = 0.f;
+}
+
+FNVOnCaptureFarmModeChanged& FNVCaptureFarmMode::OnCaptureFarmModeChanged()
+{
+    static FNVOnCaptureFarmModeChanged CaptureFarmModeChangedDelegate;
+    return CaptureFarmModeChangedDelegate;
+}
+
+void FNVCaptureFarmMode::Enter(UWorld* World, const FNVCaptureFarmModeSettings& InSettings)
+{
+    if (bIsActive || !World)
+    {
+        return;
+    }
+
+    Settings = InSettings;
+    bIsActive = true;
+    BaselineFramesLeft = FMath::Max(Settings.BaselineFrameCount, 0);
+    BaselineFrameTimes.Reset();
+    FarmModeFrameTimes.Reset();
+
+    UE_LOG(LogNVSceneCapturer, Log, TEXT("Capture farm mode entered: the game viewport stop rendering after %d baseline frames."), BaselineFramesLeft);
+    if (BaselineFramesLeft <= 0)
+    {
+        SuppressRendering(World);
+    }
+}
+
+void FNVCaptureFarmMode::Exit(UWorld* World)
+{
+    if (!bIsActive)
+    {
+        return;
+    }
+
+    bIsActive = false;
+    if (bRenderingSuppressed)
+    {
+        RestoreRendering(World);
+    }
+    LogRecoveredFrameTimes();
+}
+
+void FNVCaptureFarmMode::Tick(UWorld* World, float DeltaTime)
+{
+    if (!bIsActive)
+    {
+        return;
+    }
+
+    if (!bRenderingSuppressed)
+    {
+        BaselineFrameTimes.SampleLastFrame();
+        BaselineFramesLeft--;
+        if (BaselineFramesLeft <= 0)
+        {
+            SuppressRendering(World);
+        }
+        return;
+    }
+
+    // NOTE: The previews cost GPU time, the frames they're rendered in are not sampled
+    if (bRenderingPreview)
+    {
+        bRenderingPreview = false;
+        SetPreviewScreenPercentage(false);
+        SetWorldRendering(World, false);
+        return;
+    }
+    FarmModeFrameTimes.SampleLastFrame();
+
+    if (Settings.PreviewInterval > 0.f)
+    {
+        TimeSinceLastPreview += DeltaTime;
+        if (TimeSinceLastPreview >= Settings.PreviewInterval)
+        {
+            // Render only the next frame of the game viewport, at a low resolution
+            TimeSinceLastPreview = 0.f;
+            bRenderingPreview = true;
+            SetPreviewScreenPercentage(true);
+            SetWorldRendering(World, true);
+        }
+    }
+}
+
+void FNVCaptureFarmMode::SuppressRendering(UWorld* World)
+{
+    if (bRenderingSuppressed || !World)
+    {
+        return;
+    }
+
+    bRenderingSuppressed = true;
+    bRenderingPreview = false;
+    TimeSinceLastPreview = 0.f;
+
+    UGameViewportClient* GameViewport = World->GetGameViewport();
+    bSavedDisableWorldRendering = GameViewport ? GameViewport->bDisableWorldRendering : false;
+    SetWorldRendering(World, false);
+
+    IConsoleVariable* ScreenPercentageCVar = GetScreenPercentageCVar();
+    SavedScreenPercentage = ScreenPercentageCVar ? ScreenPercentageCVar->GetFloat() : 100.f;
+
+    // NOTE: All the HUDs of the world are hidden, not only the players' ones, e.g: the capturer's HUD spawned without player
+    SavedHUDVisibilities.Reset();
+    for (TActorIterator<AHUD> HUDIt(World); HUDIt; ++HUDIt)
+    {
+        AHUD* CheckHUD = *HUDIt;
+        if (CheckHUD)
+        {
+            SavedHUDVisibilities.Add(TPair<TWeakObjectPtr<AHUD>, bool>(CheckHUD, CheckHUD->bShowHUD));
+            CheckHUD->bShowHUD = false;
+        }
+    }
+
+    OnCaptureFarmModeChanged().Broadcast(true);
+}
+
+void FNVCaptureFarmMode::RestoreRendering(UWorld* World)
+{
+    if (!bRenderingSuppressed)
+    {
+        return;
+    }
+
+    bRenderingSuppressed = false;
+    if (bRenderingPreview)
+    {
+        bRenderingPreview = false;
+        SetPreviewScreenPercentage(false);
+    }
+
+    UGameViewportClient* GameViewport = World ? World->GetGameViewport() : nullptr;
+    if (GameViewport)
+    {
+        GameViewport->bDisableWorldRendering = bSavedDisableWorldRendering;
+    }
+
+    for (const TPair<TWeakObjectPtr<AHUD>, bool>& SavedHUDVisibility : SavedHUDVisibilities)
+    {
+        AHUD* SavedHUD = SavedHUDVisibility.Key.Get();
+        if (SavedHUD)
+        {
+            SavedHUD->bShowHUD = SavedHUDVisibility.Value;
+        }
+    }
+    SavedHUDVisibilities.Reset();
+
+    OnCaptureFarmModeChanged().Broadcast(false);
+}
+
+void FNVCaptureFarmMode::SetWorldRendering(UWorld* World, bool bRenderWorld)
+{
+    UGameViewportClient* GameViewport = World ? World->GetGameViewport() : nullptr;
+    if (GameViewport)
+    {
+        GameViewport->bDisableWorldRendering = !bRenderWorld;
+    }
+}
+
+void FNVCaptureFarmMode::SetPreviewScreenPercentage(bool bPreview)
+{
+    IConsoleVariable* ScreenPercentageCVar = GetScreenPercentageCVar();
+    if (ScreenPercentageCVar)
+    {
+        ScreenPercentageCVar->Set(bPreview ? Settings.PreviewScreenPercentage : SavedScreenPercentage, ECVF_SetByCode);
+    }
+}
+
+void FNVCaptureFarmMode::LogRecoveredFrameTimes() const
+{
+    if ((BaselineFrameTimes.SampleCount <= 0) || (FarmModeFrameTimes.SampleCount <= 0))
+    {
+        UE_LOG(LogNVSceneCapturer, Log, TEXT("Capture farm mode exited, not enough frames sampled to compare the frame times."));
+        return;
+    }
+
+    const float BaselineGameThreadTime = BaselineFrameTimes.GetAverageGameThreadTime();
+    const float BaselineGPUTime = BaselineFrameTimes.GetAverageGPUTime();
+    const float FarmModeGameThreadTime = FarmModeFrameTimes.GetAverageGameThreadTime();
+    const float FarmModeGPUTime = FarmModeFrameTimes.GetAverageGPUTime();
+    UE_LOG(LogNVSceneCapturer, Log, TEXT("Capture farm mode exited: game thread %.2f ms -> %.2f ms (%.2f ms recovered), GPU %.2f ms -> %.2f ms (%.2f ms recovered) per frame."),
+           BaselineGameThreadTime, FarmModeGameThreadTime, BaselineGameThreadTime - FarmModeGameThreadTime,
+           BaselineGPUTime, FarmModeGPUTime, BaselineGPUTime - FarmModeGPUTime);
+}
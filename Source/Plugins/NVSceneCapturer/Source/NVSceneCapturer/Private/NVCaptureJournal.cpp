@@ -0,0 +1,195 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVCaptureJournal.h"
+#include "Json.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformFilemanager.h"
+
+//================================== FNVCaptureCheckpoint ==================================
+FString FNVCaptureCheckpoint::ToJsonString() const
+{
+    TSharedPtr<FJsonObject> JsonObj = MakeShareable(new FJsonObject());
+    JsonObj->SetNumberField(TEXT("frame_index"), FrameIndex);
+    JsonObj->SetNumberField(TEXT("marker_index"), MarkerIndex);
+    JsonObj->SetNumberField(TEXT("random_seed"), RandomSeed);
+
+    TArray<TSharedPtr<FJsonValue>> WrittenFileJsonValues;
+    WrittenFileJsonValues.Reserve(WrittenFiles.Num());
+    for (const FString& WrittenFile : WrittenFiles)
+    {
+        WrittenFileJsonValues.Add(MakeShareable(new FJsonValueString(WrittenFile)));
+    }
+    JsonObj->SetArrayField(TEXT("written_files"), WrittenFileJsonValues);
+
+    // NOTE: Each checkpoint must be on a single line
+    FString OutJsonString;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&OutJsonString);
+    FJsonSerializer::Serialize(JsonObj.ToSharedRef(), JsonWriter);
+    return OutJsonString;
+}
+
+bool FNVCaptureCheckpoint::FromJsonString(const FString& JsonString)
+{
+    TSharedPtr<FJsonObject> JsonObj;
+    TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(JsonString);
+    if (!FJsonSerializer::Deserialize(JsonReader, JsonObj) || !JsonObj.IsValid())
+    {
+        return false;
+    }
+
+    int32 NewFrameIndex = INDEX_NONE;
+    int32 NewMarkerIndex = 0;
+    int32 NewRandomSeed = 0;
+    if (!JsonObj->TryGetNumberField(TEXT("frame_index"), NewFrameIndex)
+        || !JsonObj->TryGetNumberField(TEXT("marker_index"), NewMarkerIndex)
+        || !JsonObj->TryGetNumberField(TEXT("random_seed"), NewRandomSeed))
+    {
+        return false;
+    }
+
+    FrameIndex = NewFrameIndex;
+    MarkerIndex = NewMarkerIndex;
+    RandomSeed = NewRandomSeed;
+    WrittenFiles.Reset();
+    JsonObj->TryGetStringArrayField(TEXT("written_files"), WrittenFiles);
+    return true;
+}
+
+//================================== FNVCaptureJournal ==================================
+const FString FNVCaptureJournal::JournalFileName = TEXT("capture_journal.jsonl");
+
+FNVCaptureJournal::FNVCaptureJournal()
+{
+}
+
+FNVCaptureJournal::~FNVCaptureJournal()
+{
+    Close();
+}
+
+bool FNVCaptureJournal::Open(const FString& OutputDirectoryPath, bool bAppend)
+{
+    Close();
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const FString JournalFilePath = FPaths::Combine(OutputDirectoryPath, JournalFileName);
+    if (!PlatformFile.DirectoryExists(*OutputDirectoryPath))
+    {
+        PlatformFile.CreateDirectoryTree(*OutputDirectoryPath);
+    }
+
+    if (bAppend && PlatformFile.FileExists(*JournalFilePath))
+    {
+        // Cut off the incomplete checkpoint left by a crash so the new checkpoints start on a new line
+        FNVCaptureCheckpoint LastCheckpoint;
+        int64 ValidByteSize = 0;
+        LoadLastCheckpoint(OutputDirectoryPath, LastCheckpoint, &ValidByteSize);
+        if (PlatformFile.FileSize(*JournalFilePath) != ValidByteSize)
+        {
+            TArray<uint8> JournalData;
+            FFileHelper::LoadFileToArray(JournalData, *JournalFilePath);
+            JournalData.SetNum(FMath::Min<int64>(ValidByteSize, JournalData.Num()));
+            if (!FFileHelper::SaveArrayToFile(JournalData, *JournalFilePath))
+            {
+                UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't repair the capture journal: %s"), *JournalFilePath);
+                return false;
+            }
+        }
+    }
+    else
+    {
+        PlatformFile.DeleteFile(*JournalFilePath);
+    }
+
+    JournalFileHandle.Reset(PlatformFile.OpenWrite(*JournalFilePath, true));
+    if (!JournalFileHandle.IsValid())
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't open the capture journal for writing: %s"), *JournalFilePath);
+        return false;
+    }
+    return true;
+}
+
+void FNVCaptureJournal::Close()
+{
+    if (JournalFileHandle.IsValid())
+    {
+        JournalFileHandle->Flush(true);
+        JournalFileHandle.Reset();
+    }
+}
+
+bool FNVCaptureJournal::IsOpen() const
+{
+    return JournalFileHandle.IsValid();
+}
+
+bool FNVCaptureJournal::AppendCheckpoint(const FNVCaptureCheckpoint& Checkpoint)
+{
+    if (!JournalFileHandle.IsValid())
+    {
+        return false;
+    }
+
+    const FString CheckpointLine = Checkpoint.ToJsonString() + TEXT("\n");
+    FTCHARToUTF8 UTF8Line(*CheckpointLine);
+    const bool bWritten = JournalFileHandle->Write(reinterpret_cast<const uint8*>(UTF8Line.Get()), UTF8Line.Length());
+    // The checkpoint only count once it's on the disk
+    const bool bFlushed = bWritten && JournalFileHandle->Flush(true);
+    if (!bFlushed)
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't write the checkpoint of frame %d to the capture journal."), Checkpoint.FrameIndex);
+    }
+    return bFlushed;
+}
+
+bool FNVCaptureJournal::LoadLastCheckpoint(const FString& OutputDirectoryPath, FNVCaptureCheckpoint& OutCheckpoint, int64* OutValidByteSize /*= nullptr*/)
+{
+    if (OutValidByteSize)
+    {
+        *OutValidByteSize = 0;
+    }
+
+    const FString JournalFilePath = FPaths::Combine(OutputDirectoryPath, JournalFileName);
+    TArray<uint8> JournalData;
+    if (!FFileHelper::LoadFileToArray(JournalData, *JournalFilePath, FILEREAD_Silent))
+    {
+        return false;
+    }
+
+    bool bFoundCheckpoint = false;
+    int32 LineStart = 0;
+    for (int32 i = 0; i < JournalData.Num(); i++)
+    {
+        if (JournalData[i] != '\n')
+        {
+            continue;
+        }
+
+        // Only the lines which end with a line break are complete
+        const FUTF8ToTCHAR LineConverter(reinterpret_cast<const ANSICHAR*>(JournalData.GetData() + LineStart), i - LineStart);
+        const FString CheckpointLine(LineConverter.Length(), LineConverter.Get());
+        FNVCaptureCheckpoint LineCheckpoint;
+        if (!LineCheckpoint.FromJsonString(CheckpointLine))
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("The capture journal is corrupted at byte %d, the checkpoints after it are ignored: %s"),
+                   LineStart, *JournalFilePath);
+            break;
+        }
+
+        OutCheckpoint = MoveTemp(LineCheckpoint);
+        bFoundCheckpoint = true;
+        LineStart = i + 1;
+        if (OutValidByteSize)
+        {
+            *OutValidByteSize = LineStart;
+        }
+    }
+
+    return bFoundCheckpoint;
+}
@@ -0,0 +1,157 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVCapturePipeline.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+#include "Async/Async.h"
+
+//================================== FNVCaptureFrameContext ==================================
+FNVCaptureFrameContext::FNVCaptureFrameContext(int32 InFrameIndex, int32 InPendingReadbackCount, double InBeginTime)
+    : FrameIndex(InFrameIndex),
+      PendingReadbackCounter(InPendingReadbackCount),
+      BeginTime(InBeginTime)
+{
+}
+
+bool FNVCaptureFrameContext::IsCompleted() const
+{
+    if (PendingReadbackCounter.GetValue() > 0)
+    {
+        return false;
+    }
+    for (const FNVCapturedAnnotationData& CheckAnnotation : Annotations)
+    {
+        if (!CheckAnnotation.IsBuilt())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FNVCaptureFrameContext::AddAnnotationSnapshot(const FNVSceneAnnotationSnapshotRef& Snapshot, UNVSceneFeatureExtractor_AnnotationData* FeatureExtractor, UNVSceneCapturerViewpointComponent* Viewpoint)
+{
+    ensure(IsInGameThread());
+
+    FNVCapturedAnnotationData NewAnnotationData;
+    NewAnnotationData.FeatureExtractor = FeatureExtractor;
+    NewAnnotationData.Viewpoint = Viewpoint;
+    NewAnnotationData.Snapshot = Snapshot;
+
+    const FNVSceneAnnotationSnapshot* SnapshotPtr = &Snapshot.Get();
+    NewAnnotationData.BuildTask = Async(EAsyncExecution::ThreadPool, [SnapshotPtr]()
+    {
+        return UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(*SnapshotPtr);
+    });
+    Annotations.Add(MoveTemp(NewAnnotationData));
+}
+
+void FNVCaptureFrameContext::WaitForAnnotationData() const
+{
+    for (const FNVCapturedAnnotationData& CheckAnnotation : Annotations)
+    {
+        if (CheckAnnotation.BuildTask.IsValid())
+        {
+            CheckAnnotation.BuildTask.Wait();
+        }
+    }
+}
+
+//================================== FNVCapturePipeline ==================================
+FNVCapturePipeline::FNVCapturePipeline()
+{
+    Reset(1);
+}
+
+FNVCapturePipeline::~FNVCapturePipeline()
+{
+    // NOTE: The background tasks read the snapshots the frames own
+    for (const FNVCaptureFrameContextRef& CheckFrameContext : InFlightFrames)
+    {
+        CheckFrameContext->WaitForAnnotationData();
+    }
+}
+
+void FNVCapturePipeline::Reset(int32 NewDepth)
+{
+    ensure(IsInGameThread());
+
+    for (const FNVCaptureFrameContextRef& CheckFrameContext : InFlightFrames)
+    {
+        CheckFrameContext->WaitForAnnotationData();
+    }
+
+    Depth = FMath::Max(NewDepth, 1);
+    InFlightFrames.Reset();
+    RetiredFrameCount = 0;
+    StaleFrameCount = 0;
+}
+
+bool FNVCapturePipeline::CanBeginFrame() const
+{
+    return (InFlightFrames.Num() < Depth);
+}
+
+FNVCaptureFrameContextRef FNVCapturePipeline::BeginFrame(int32 FrameIndex, int32 PendingReadbackCount, double CurrentTime)
+{
+    ensure(IsInGameThread());
+    ensure(CanBeginFrame());
+
+    FNVCaptureFrameContextRef NewFrameContext = MakeShared<FNVCaptureFrameContext, ESPMode::ThreadSafe>(FrameIndex, FMath::Max(PendingReadbackCount, 0), CurrentTime);
+    InFlightFrames.Add(NewFrameContext);
+    return NewFrameContext;
+}
+
+int32 FNVCapturePipeline::RetireCompletedFrames(TArray<FNVCaptureFrameContextRef>& OutRetiredFrames, double CurrentTime, double StaleFrameDuration /*= 0.0*/)
+{
+    ensure(IsInGameThread());
+
+    int32 RetiredCount = 0;
+    while (RetiredCount < InFlightFrames.Num())
+    {
+        const FNVCaptureFrameContextRef& CheckFrameContext = InFlightFrames[RetiredCount];
+        if (!CheckFrameContext->IsCompleted())
+        {
+            const bool bIsStale = (StaleFrameDuration > 0.0) && ((CurrentTime - CheckFrameContext->BeginTime) > StaleFrameDuration);
+            if (!bIsStale)
+            {
+                break;
+            }
+
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("Frame %d is retired while %d of its pixels data are not read back after %.3f seconds."),
+                   CheckFrameContext->FrameIndex, CheckFrameContext->PendingReadbackCounter.GetValue(), CurrentTime - CheckFrameContext->BeginTime);
+            StaleFrameCount++;
+        }
+
+        OutRetiredFrames.Add(CheckFrameContext);
+        RetiredCount++;
+    }
+
+    if (RetiredCount > 0)
+    {
+        InFlightFrames.RemoveAt(0, RetiredCount, false);
+        RetiredFrameCount += RetiredCount;
+    }
+    return RetiredCount;
+}
+
+void FNVCapturePipeline::RetireAllFrames(TArray<FNVCaptureFrameContextRef>& OutRetiredFrames)
+{
+    ensure(IsInGameThread());
+
+    for (const FNVCaptureFrameContextRef& CheckFrameContext : InFlightFrames)
+    {
+        if (!CheckFrameContext->IsCompleted())
+        {
+            StaleFrameCount++;
+        }
+    }
+
+    OutRetiredFrames.Append(InFlightFrames);
+    RetiredFrameCount += InFlightFrames.Num();
+    InFlightFrames.Reset();
+}
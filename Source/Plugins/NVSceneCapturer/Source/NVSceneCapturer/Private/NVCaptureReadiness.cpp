@@ -0,0 +1,218 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVCaptureReadiness.h"
+#include "ContentStreaming.h"
+#include "Engine/World.h"
+#include "UObject/UObjectGlobals.h"
+
+//================================== Readiness conditions ==================================
+FName FNVCaptureReadinessCondition_AsyncLoading::GetConditionName() const
+{
+    static const FName ConditionName(TEXT("AsyncLoading"));
+    return ConditionName;
+}
+
+bool FNVCaptureReadinessCondition_AsyncLoading::IsReady(UWorld* World) const
+{
+    return !IsAsyncLoading();
+}
+
+FNVCaptureReadinessCondition_TextureStreaming::FNVCaptureReadinessCondition_TextureStreaming(int32 InMaxStalledFrameCount)
+    : MaxStalledFrameCount(InMaxStalledFrameCount),
+      LastNumWantingResources(INDEX_NONE),
+      StalledFrameCount(0)
+{
+}
+
+FName FNVCaptureReadinessCondition_TextureStreaming::GetConditionName() const
+{
+    static const FName ConditionName(TEXT("TextureStreaming"));
+    return ConditionName;
+}
+
+void FNVCaptureReadinessCondition_TextureStreaming::OnBeginWaiting(UWorld* World)
+{
+    LastNumWantingResources = INDEX_NONE;
+    StalledFrameCount = 0;
+}
+
+bool FNVCaptureReadinessCondition_TextureStreaming::IsReady(UWorld* World) const
+{
+    const int32 NumWantingResources = GetNumWantingResources();
+    if ((NumWantingResources <= 0) || IsStreamingPoolOverBudget())
+    {
+        return true;
+    }
+
+    StalledFrameCount = (NumWantingResources == LastNumWantingResources) ? (StalledFrameCount + 1) : 0;
+    LastNumWantingResources = NumWantingResources;
+    return (MaxStalledFrameCount > 0) && (StalledFrameCount >= MaxStalledFrameCount);
+}
+
+int32 FNVCaptureReadinessCondition_TextureStreaming::GetNumWantingResources() const
+{
+    return IStreamingManager::Get().IsTextureStreamingEnabled() ? IStreamingManager::Get().GetNumWantingResources() : 0;
+}
+
+bool FNVCaptureReadinessCondition_TextureStreaming::IsStreamingPoolOverBudget() const
+{
+    return IStreamingManager::Get().GetRenderAssetStreamingManager().GetMemoryOverBudget() > 0;
+}
+
+FName FNVCaptureReadinessCondition_RenderState::GetConditionName() const
+{
+    static const FName ConditionName(TEXT("RenderState"));
+    return ConditionName;
+}
+
+void FNVCaptureReadinessCondition_RenderState::OnBeginWaiting(UWorld* World)
+{
+    if (World)
+    {
+        // Push the pending render state updates of the components to the render thread before putting the fence behind them
+        World->SendAllEndOfFrameUpdates();
+    }
+    RenderStateFence.BeginFence();
+}
+
+bool FNVCaptureReadinessCondition_RenderState::IsReady(UWorld* World) const
+{
+    return RenderStateFence.IsFenceComplete();
+}
+
+FNVCaptureReadinessCondition_Predicate::FNVCaptureReadinessCondition_Predicate(FName InConditionName, TFunction<bool(UWorld*)> InPredicate)
+    : ConditionName(InConditionName),
+      Predicate(MoveTemp(InPredicate))
+{
+}
+
+FName FNVCaptureReadinessCondition_Predicate::GetConditionName() const
+{
+    return ConditionName;
+}
+
+bool FNVCaptureReadinessCondition_Predicate::IsReady(UWorld* World) const
+{
+    return !Predicate || Predicate(World);
+}
+
+//================================== FNVCaptureReadinessGate ==================================
+FNVCaptureReadinessGate::FNVCaptureReadinessGate()
+{
+    Timeout = 1.f;
+    MinReadyFrameCount = 1;
+
+    bIsWaiting = false;
+    bTimedOut = false;
+    WaitStartTime = 0.0;
+    LastWaitDuration = 0.0;
+    ReadyFrameCount = 0;
+}
+
+void FNVCaptureReadinessGate::AddDefaultConditions()
+{
+    AddCondition(MakeShared<FNVCaptureReadinessCondition_AsyncLoading>());
+    AddCondition(MakeShared<FNVCaptureReadinessCondition_TextureStreaming>());
+    AddCondition(MakeShared<FNVCaptureReadinessCondition_RenderState>());
+    for (const TSharedRef<INVCaptureReadinessCondition>& GlobalCondition : GetGlobalConditions())
+    {
+        AddCondition(GlobalCondition);
+    }
+}
+
+void FNVCaptureReadinessGate::AddCondition(TSharedRef<INVCaptureReadinessCondition> NewCondition)
+{
+    Conditions.Add(NewCondition);
+}
+
+void FNVCaptureReadinessGate::RemoveAllConditions()
+{
+    Conditions.Reset();
+}
+
+void FNVCaptureReadinessGate::BeginWaiting(UWorld* World, double CurrentTime)
+{
+    bIsWaiting = true;
+    bTimedOut = false;
+    WaitStartTime = CurrentTime;
+    ReadyFrameCount = 0;
+    UnmetConditionNames.Reset();
+
+    for (const TSharedRef<INVCaptureReadinessCondition>& CheckCondition : Conditions)
+    {
+        CheckCondition->OnBeginWaiting(World);
+    }
+}
+
+bool FNVCaptureReadinessGate::Update(UWorld* World, double CurrentTime)
+{
+    if (!bIsWaiting)
+    {
+        return true;
+    }
+
+    UnmetConditionNames.Reset();
+    for (const TSharedRef<INVCaptureReadinessCondition>& CheckCondition : Conditions)
+    {
+        if (!CheckCondition->IsReady(World))
+        {
+            UnmetConditionNames.Add(CheckCondition->GetConditionName());
+        }
+    }
+
+    ReadyFrameCount = (UnmetConditionNames.Num() == 0) ? (ReadyFrameCount + 1) : 0;
+    const double WaitDuration = CurrentTime - WaitStartTime;
+    const bool bIsReady = (ReadyFrameCount >= MinReadyFrameCount);
+    bTimedOut = !bIsReady && (Timeout > 0.f) && (WaitDuration >= Timeout);
+    if (bIsReady || bTimedOut)
+    {
+        bIsWaiting = false;
+        LastWaitDuration = WaitDuration;
+        if (bTimedOut)
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("'%s' stopped waiting for the scene to be ready after the readiness timeout (%.3f seconds), the conditions not met: %s"),
+                   *GateName, WaitDuration, *GetUnmetConditionNames());
+        }
+        return true;
+    }
+    return false;
+}
+
+FString FNVCaptureReadinessGate::GetUnmetConditionNames() const
+{
+    FString ConditionNamesStr;
+    for (const FName& ConditionName : UnmetConditionNames)
+    {
+        if (!ConditionNamesStr.IsEmpty())
+        {
+            ConditionNamesStr += TEXT(", ");
+        }
+        ConditionNamesStr += ConditionName.ToString();
+    }
+    return ConditionNamesStr;
+}
+
+TArray<TSharedRef<INVCaptureReadinessCondition>>& FNVCaptureReadinessGate::GetGlobalConditions()
+{
+    static TArray<TSharedRef<INVCaptureReadinessCondition>> GlobalConditions;
+    return GlobalConditions;
+}
+
+void FNVCaptureReadinessGate::RegisterGlobalCondition(TSharedRef<INVCaptureReadinessCondition> NewCondition)
+{
+    UnregisterGlobalCondition(NewCondition->GetConditionName());
+    GetGlobalConditions().Add(NewCondition);
+}
+
+void FNVCaptureReadinessGate::UnregisterGlobalCondition(FName ConditionName)
+{
+    GetGlobalConditions().RemoveAll([ConditionName](const TSharedRef<INVCaptureReadinessCondition>& CheckCondition)
+    {
+        return CheckCondition->GetConditionName() == ConditionName;
+    });
+}
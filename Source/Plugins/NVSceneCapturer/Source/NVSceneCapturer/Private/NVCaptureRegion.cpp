@@ -0,0 +1,145 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVCaptureRegion.h"
+
+namespace
+{
+    TArray<TSharedPtr<FJsonValue>> MakeJsonIntPoint(const FIntPoint& Point)
+    {
+        TArray<TSharedPtr<FJsonValue>> JsonValues;
+        JsonValues.Add(MakeShared<FJsonValueNumber>(Point.X));
+        JsonValues.Add(MakeShared<FJsonValueNumber>(Point.Y));
+        return JsonValues;
+    }
+
+    bool ReadJsonIntPoint(const TSharedPtr<FJsonObject>& JsonObject, const FString& FieldName, FIntPoint& OutPoint)
+    {
+        const TArray<TSharedPtr<FJsonValue>>* JsonValues = nullptr;
+        if (!JsonObject->TryGetArrayField(FieldName, JsonValues) || !JsonValues || (JsonValues->Num() != 2))
+        {
+            return false;
+        }
+        OutPoint = FIntPoint((int32)(*JsonValues)[0]->AsNumber(), (int32)(*JsonValues)[1]->AsNumber());
+        return true;
+    }
+}
+
+//================================== FNVRegionOfInterestSettings ==================================
+FNVRegionOfInterestSettings::FNVRegionOfInterestSettings()
+{
+    bEnabled = false;
+    Padding = 16;
+    SnapSize = 16;
+}
+
+//================================== FNVCaptureRegion ==================================
+FIntRect FNVCaptureRegion::CalculateRegion(const TArray<FBox2D>& ObjectBoxes, const FIntPoint& ImageSize, int32 Padding, int32 SnapSize)
+{
+    const FBox2D ImageBox(FVector2D::ZeroVector, FVector2D(ImageSize));
+    FBox2D UnionBox(EForceInit::ForceInit);
+    for (const FBox2D& ObjectBox : ObjectBoxes)
+    {
+        if (ObjectBox.bIsValid && ImageBox.Intersect(ObjectBox))
+        {
+            UnionBox += ObjectBox.Overlap(ImageBox);
+        }
+    }
+
+    if (!UnionBox.bIsValid)
+    {
+        return FIntRect();
+    }
+
+    const int32 Snap = FMath::Max(SnapSize, 1);
+    const int32 PaddingSize = FMath::Max(Padding, 0);
+    FIntRect Region;
+    Region.Min.X = FMath::FloorToInt((UnionBox.Min.X - PaddingSize) / Snap) * Snap;
+    Region.Min.Y = FMath::FloorToInt((UnionBox.Min.Y - PaddingSize) / Snap) * Snap;
+    Region.Max.X = FMath::CeilToInt((UnionBox.Max.X + PaddingSize) / Snap) * Snap;
+    Region.Max.Y = FMath::CeilToInt((UnionBox.Max.Y + PaddingSize) / Snap) * Snap;
+
+    // NOTE: The max corner is not on the snapping grid when it's clamped to an image whose size isn't a multiple of the snap size
+    Region.Clip(FIntRect(FIntPoint::ZeroValue, ImageSize));
+    return (Region.Area() > 0) ? Region : FIntRect();
+}
+
+FIntRect FNVCaptureRegion::CalculateRegionOfInterest(const TArray<FBox>& ObjectBounds, const FMatrix& ViewProjectionMatrix, const FIntPoint& ImageSize,
+                                                     int32 Padding, int32 SnapSize)
+{
+    const FIntRect FullImageRegion(FIntPoint::ZeroValue, ImageSize);
+
+    TArray<FBox2D> ObjectBoxes;
+    ObjectBoxes.Reserve(ObjectBounds.Num());
+    for (const FBox& CheckBounds : ObjectBounds)
+    {
+        FBox2D ObjectBox(EForceInit::ForceInit);
+        if (!ProjectObjectBounds(CheckBounds, ViewProjectionMatrix, ImageSize, ObjectBox))
+        {
+            return FullImageRegion;
+        }
+        ObjectBoxes.Add(ObjectBox);
+    }
+
+    const FIntRect RegionOfInterest = CalculateRegion(ObjectBoxes, ImageSize, Padding, SnapSize);
+    // NOTE: Capture the whole image when nothing is visible so every frame still have its images
+    return (RegionOfInterest.Area() > 0) ? RegionOfInterest : FullImageRegion;
+}
+
+bool FNVCaptureRegion::ProjectObjectBounds(const FBox& ObjectBounds, const FMatrix& ViewProjectionMatrix, const FIntPoint& ImageSize, FBox2D& OutObjectBox)
+{
+    FVector BoundVertexes[8];
+    ObjectBounds.GetVertices(BoundVertexes);
+    OutObjectBox = FBox2D(EForceInit::ForceInit);
+    for (const FVector& BoundVertex : BoundVertexes)
+    {
+        const FPlane ProjectedVertex = ViewProjectionMatrix.TransformFVector4(FVector4(BoundVertex, 1.f));
+        if (ProjectedVertex.W <= KINDA_SMALL_NUMBER)
+        {
+            return false;
+        }
+
+        const float RHW = 1.f / ProjectedVertex.W;
+        OutObjectBox += FVector2D(0.5f * (ProjectedVertex.X * RHW + 1.f) * ImageSize.X,
+                                  0.5f * (-ProjectedVertex.Y * RHW + 1.f) * ImageSize.Y);
+    }
+    return true;
+}
+
+void FNVCaptureRegion::WriteCropToAnnotationData(const TSharedPtr<FJsonObject>& AnnotationData, const FIntRect& Region, const FIntPoint& ImageSize)
+{
+    if (!AnnotationData.IsValid())
+    {
+        return;
+    }
+
+    TSharedPtr<FJsonObject> CropJsonObj = MakeShared<FJsonObject>();
+    CropJsonObj->SetArrayField(TEXT("offset"), MakeJsonIntPoint(Region.Min));
+    CropJsonObj->SetArrayField(TEXT("size"), MakeJsonIntPoint(Region.Size()));
+    CropJsonObj->SetArrayField(TEXT("image_size"), MakeJsonIntPoint(ImageSize));
+    AnnotationData->SetObjectField(TEXT("image_crop"), CropJsonObj);
+}
+
+bool FNVCaptureRegion::ReadCropFromAnnotationData(const TSharedPtr<FJsonObject>& AnnotationData, FIntRect& OutRegion, FIntPoint& OutImageSize)
+{
+    const TSharedPtr<FJsonObject>* CropJsonObj = nullptr;
+    if (!AnnotationData.IsValid() || !AnnotationData->TryGetObjectField(TEXT("image_crop"), CropJsonObj) || !CropJsonObj || !CropJsonObj->IsValid())
+    {
+        return false;
+    }
+
+    FIntPoint Offset, Size;
+    if (!ReadJsonIntPoint(*CropJsonObj, TEXT("offset"), Offset)
+        || !ReadJsonIntPoint(*CropJsonObj, TEXT("size"), Size)
+        || !ReadJsonIntPoint(*CropJsonObj, TEXT("image_size"), OutImageSize))
+    {
+        return false;
+    }
+
+    OutRegion = FIntRect(Offset, Offset + Size);
+    return (OutRegion.Area() > 0);
+}
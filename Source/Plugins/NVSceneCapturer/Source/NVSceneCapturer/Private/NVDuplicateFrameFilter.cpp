@@ -0,0 +1,347 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVDuplicateFrameFilter.h"
+
+namespace
+{
+    // Size of the grayscale grid used to calculate the difference hash
+    const int32 HashGridWidth = 9;
+    const int32 HashGridHeight = 8;
+
+    // Maximum number of pixels sampled along each axis of a grid cell
+    const int32 MaxCellSampleCount = 8;
+
+    // Number of frames a decision is kept after it's made, the data of a frame may come a few frames late
+    const int32 KeepFrameDecisionCount = 16;
+
+    // Number of frames the decision is kept when some of the expected data of the frame are still not reported,
+    // e.g: a feature extractor failed to capture its data
+    const int32 KeepUnreportedFrameDecisionCount = 1024;
+}
+
+FNVDuplicateFrameFilter::FNVDuplicateFrameFilter(int32 InHistoryCount, int32 InHashDistanceThreshold)
+    : HistoryCount(FMath::Max(InHistoryCount, 1)),
+      HashDistanceThreshold(FMath::Clamp(InHashDistanceThreshold, 0, 64))
+{
+    CheckedFrameCounter.Reset();
+    DroppedFrameCounter.Reset();
+}
+
+bool FNVDuplicateFrameFilter::CalculateDifferenceHash(const FNVTexturePixelData& ImagePixelData, uint64& OutHash)
+{
+    OutHash = 0;
+
+    // Byte offset of each color channel inside a pixel, the grayscale images only use the red offset
+    int32 RedOffset = 0;
+    int32 GreenOffset = 0;
+    int32 BlueOffset = 0;
+    int32 PixelByteSize = 0;
+    switch (ImagePixelData.PixelFormat)
+    {
+        case EPixelFormat::PF_B8G8R8A8:
+            RedOffset = 2;
+            GreenOffset = 1;
+            BlueOffset = 0;
+            PixelByteSize = 4;
+            break;
+        case EPixelFormat::PF_R8G8B8A8:
+            RedOffset = 0;
+            GreenOffset = 1;
+            BlueOffset = 2;
+            PixelByteSize = 4;
+            break;
+        case EPixelFormat::PF_G8:
+        case EPixelFormat::PF_R8:
+            PixelByteSize = 1;
+            break;
+        default:
+            return false;
+    }
+
+    const int32 Width = ImagePixelData.PixelSize.X;
+    const int32 Height = ImagePixelData.PixelSize.Y;
+    const int32 RowStride = (ImagePixelData.RowStride > 0) ? ImagePixelData.RowStride : (Width * PixelByteSize);
+    const int64 RequiredBufferSize = (Height > 0) ? (int64(RowStride) * (Height - 1) + int64(Width) * PixelByteSize) : 0;
+    if ((Width < HashGridWidth) || (Height < HashGridHeight) || (ImagePixelData.PixelData.Num() < RequiredBufferSize))
+    {
+        return false;
+    }
+
+    const uint8* ImageData = ImagePixelData.PixelData.GetData();
+    auto GetPixelLuminance = [&](int32 X, int32 Y) -> uint32
+    {
+        const uint8* Pixel = ImageData + int64(Y) * RowStride + int64(X) * PixelByteSize;
+        if (PixelByteSize == 1)
+        {
+            return Pixel[0];
+        }
+        // Integer approximation of the Rec.601 luma
+        return (uint32(Pixel[RedOffset]) * 77 + uint32(Pixel[GreenOffset]) * 150 + uint32(Pixel[BlueOffset]) * 29) >> 8;
+    };
+
+    uint32 CellLuminances[HashGridHeight][HashGridWidth];
+    for (int32 CellY = 0; CellY < HashGridHeight; ++CellY)
+    {
+        const int32 CellStartY = (CellY * Height) / HashGridHeight;
+        const int32 CellEndY = ((CellY + 1) * Height) / HashGridHeight;
+        const int32 StepY = FMath::Max((CellEndY - CellStartY) / MaxCellSampleCount, 1);
+        for (int32 CellX = 0; CellX < HashGridWidth; ++CellX)
+        {
+            const int32 CellStartX = (CellX * Width) / HashGridWidth;
+            const int32 CellEndX = ((CellX + 1) * Width) / HashGridWidth;
+            const int32 StepX = FMath::Max((CellEndX - CellStartX) / MaxCellSampleCount, 1);
+
+            uint32 TotalLuminance = 0;
+            uint32 SampleCount = 0;
+            for (int32 Y = CellStartY + StepY / 2; Y < CellEndY; Y += StepY)
+            {
+                for (int32 X = CellStartX + StepX / 2; X < CellEndX; X += StepX)
+                {
+                    TotalLuminance += GetPixelLuminance(X, Y);
+                    SampleCount++;
+                }
+            }
+            CellLuminances[CellY][CellX] = (SampleCount > 0) ? (TotalLuminance / SampleCount) : 0;
+        }
+    }
+
+    int32 BitIndex = 0;
+    for (int32 CellY = 0; CellY < HashGridHeight; ++CellY)
+    {
+        for (int32 CellX = 0; CellX < HashGridWidth - 1; ++CellX)
+        {
+            if (CellLuminances[CellY][CellX] > CellLuminances[CellY][CellX + 1])
+            {
+                OutHash |= (uint64(1) << BitIndex);
+            }
+            BitIndex++;
+        }
+    }
+
+    return true;
+}
+
+ENVDuplicateFrameDecision FNVDuplicateFrameFilter::CheckFrame(const FFrameKey& FrameKey, const FNVTexturePixelData& ColorPixelData, const FString& ViewpointName)
+{
+    uint64 FrameHash = 0;
+    const bool bHashValid = CalculateDifferenceHash(ColorPixelData, FrameHash);
+    if (!bHashValid)
+    {
+        UE_LOG(LogNVSceneCapturer, Warning, TEXT("Can't hash the image of frame %d in viewpoint '%s', pixel format %d is not supported. The frame is kept."),
+               FrameKey.Value, *ViewpointName, (int32)ColorPixelData.PixelFormat);
+    }
+
+    const int32 FrameIndex = FrameKey.Value;
+    ENVDuplicateFrameDecision Decision = ENVDuplicateFrameDecision::Accepted;
+    TArray<TFunction<void()>> HeldBackActions;
+    {
+        FScopeLock ScopeLock(&StateLock);
+        FViewpointState& ViewpointState = ViewpointStates.FindOrAdd(FrameKey.Key);
+        FFrameState& FrameState = ViewpointState.FrameStates.FindOrAdd(FrameIndex);
+        if (FrameState.Decision != ENVDuplicateFrameDecision::Pending)
+        {
+            // The frame is captured again (e.g: the first frame), keep the first decision
+            return FrameState.Decision;
+        }
+
+        int32 DuplicatedFrameIndex = INDEX_NONE;
+        int32 HashDistance = 0;
+        if (bHashValid)
+        {
+            for (const TPair<uint64, int32>& AcceptedHash : ViewpointState.AcceptedHashes)
+            {
+                HashDistance = FMath::CountBits(AcceptedHash.Key ^ FrameHash);
+                if (HashDistance <= HashDistanceThreshold)
+                {
+                    DuplicatedFrameIndex = AcceptedHash.Value;
+                    break;
+                }
+            }
+        }
+
+        if (DuplicatedFrameIndex != INDEX_NONE)
+        {
+            Decision = ENVDuplicateFrameDecision::Dropped;
+            UE_LOG(LogNVSceneCapturer, Log, TEXT("Frame %d of viewpoint '%s' is dropped: duplicate of frame %d (hash distance %d)."),
+                   FrameIndex, *ViewpointName, DuplicatedFrameIndex, HashDistance);
+        }
+        else if (bHashValid)
+        {
+            ViewpointState.AcceptedHashes.Add(TPair<uint64, int32>(FrameHash, FrameIndex));
+            if (ViewpointState.AcceptedHashes.Num() > HistoryCount)
+            {
+                ViewpointState.AcceptedHashes.RemoveAt(0, ViewpointState.AcceptedHashes.Num() - HistoryCount, false);
+            }
+        }
+
+        FrameState.Decision = Decision;
+        HeldBackActions = MoveTemp(FrameState.HeldBackActions);
+
+        PruneFrameStates(ViewpointState, FrameIndex);
+    }
+
+    CheckedFrameCounter.Increment();
+    if (Decision == ENVDuplicateFrameDecision::Dropped)
+    {
+        DroppedFrameCounter.Increment();
+    }
+    else
+    {
+        for (TFunction<void()>& HandleDataAction : HeldBackActions)
+        {
+            HandleDataAction();
+        }
+    }
+
+    return Decision;
+}
+
+ENVDuplicateFrameDecision FNVDuplicateFrameFilter::GetDecision(const FFrameKey& FrameKey) const
+{
+    FScopeLock ScopeLock(&StateLock);
+    const FViewpointState* ViewpointState = ViewpointStates.Find(FrameKey.Key);
+    const FFrameState* FrameState = ViewpointState ? ViewpointState->FrameStates.Find(FrameKey.Value) : nullptr;
+    return FrameState ? FrameState->Decision : ENVDuplicateFrameDecision::Pending;
+}
+
+void FNVDuplicateFrameFilter::ExpectFrameData(const FFrameKey& FrameKey, int32 ExpectedDataCount)
+{
+    FScopeLock ScopeLock(&StateLock);
+    if (FFrameState* FrameState = FindFrameStateForData(FrameKey))
+    {
+        FrameState->UnreportedDataCount += ExpectedDataCount;
+    }
+}
+
+ENVDuplicateFrameDecision FNVDuplicateFrameFilter::ConsumeDecision(const FFrameKey& FrameKey)
+{
+    FScopeLock ScopeLock(&StateLock);
+    FFrameState* FrameState = FindFrameStateForData(FrameKey);
+    if (!FrameState)
+    {
+        return ENVDuplicateFrameDecision::Dropped;
+    }
+    if (FrameState->Decision != ENVDuplicateFrameDecision::Pending)
+    {
+        FrameState->UnreportedDataCount--;
+    }
+    return FrameState->Decision;
+}
+
+ENVDuplicateFrameDecision FNVDuplicateFrameFilter::DeferUntilChecked(const FFrameKey& FrameKey, TFunction<void()>&& HandleDataAction)
+{
+    ENVDuplicateFrameDecision Decision = ENVDuplicateFrameDecision::Dropped;
+    {
+        FScopeLock ScopeLock(&StateLock);
+        if (FFrameState* FrameState = FindFrameStateForData(FrameKey))
+        {
+            FrameState->UnreportedDataCount--;
+            Decision = FrameState->Decision;
+            if (Decision == ENVDuplicateFrameDecision::Pending)
+            {
+                FrameState->HeldBackActions.Add(MoveTemp(HandleDataAction));
+            }
+        }
+    }
+
+    if (Decision == ENVDuplicateFrameDecision::Accepted)
+    {
+        HandleDataAction();
+    }
+    return Decision;
+}
+
+void FNVDuplicateFrameFilter::AcceptFrameUnchecked(const FFrameKey& FrameKey)
+{
+    TArray<TFunction<void()>> HeldBackActions;
+    {
+        FScopeLock ScopeLock(&StateLock);
+        FViewpointState& ViewpointState = ViewpointStates.FindOrAdd(FrameKey.Key);
+        FFrameState* FrameState = FindFrameStateForData(FrameKey);
+        if (!FrameState || (FrameState->Decision != ENVDuplicateFrameDecision::Pending))
+        {
+            return;
+        }
+        FrameState->Decision = ENVDuplicateFrameDecision::Accepted;
+        HeldBackActions = MoveTemp(FrameState->HeldBackActions);
+
+        PruneFrameStates(ViewpointState, FrameKey.Value);
+    }
+
+    for (TFunction<void()>& HandleDataAction : HeldBackActions)
+    {
+        HandleDataAction();
+    }
+}
+
+FNVDuplicateFrameFilter::FFrameState* FNVDuplicateFrameFilter::FindFrameStateForData(const FFrameKey& FrameKey)
+{
+    FViewpointState& ViewpointState = ViewpointStates.FindOrAdd(FrameKey.Key);
+    FFrameState* FrameState = ViewpointState.FrameStates.Find(FrameKey.Value);
+    if (!FrameState)
+    {
+        // NOTE: A new pending state would never be decided, its data would be held back until the filter is reset
+        if (FrameKey.Value < ViewpointState.ForgottenFrameIndexEnd)
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("A data of frame %d came after the duplicate check of the frame was forgotten, the data is discarded."),
+                   FrameKey.Value);
+            return nullptr;
+        }
+        FrameState = &ViewpointState.FrameStates.Add(FrameKey.Value);
+    }
+    return FrameState;
+}
+
+void FNVDuplicateFrameFilter::PruneFrameStates(FViewpointState& ViewpointState, int32 LastFrameIndex)
+{
+    // Forget the old frames which are already decided and don't wait for any more data
+    for (auto It = ViewpointState.FrameStates.CreateIterator(); It; ++It)
+    {
+        const FFrameState& CheckFrameState = It.Value();
+        if ((CheckFrameState.Decision != ENVDuplicateFrameDecision::Pending)
+            && (It.Key() < LastFrameIndex - ((CheckFrameState.UnreportedDataCount > 0) ? KeepUnreportedFrameDecisionCount : KeepFrameDecisionCount)))
+        {
+            ViewpointState.ForgottenFrameIndexEnd = FMath::Max(ViewpointState.ForgottenFrameIndexEnd, It.Key() + 1);
+            It.RemoveCurrent();
+        }
+    }
+}
+
+void FNVDuplicateFrameFilter::Reset()
+{
+    int32 DiscardedActionCount = 0;
+    {
+        FScopeLock ScopeLock(&StateLock);
+        for (const auto& CheckViewpointState : ViewpointStates)
+        {
+            for (const auto& CheckFrameState : CheckViewpointState.Value.FrameStates)
+            {
+                DiscardedActionCount += CheckFrameState.Value.HeldBackActions.Num();
+            }
+        }
+        ViewpointStates.Reset();
+    }
+
+    if (DiscardedActionCount > 0)
+    {
+        UE_LOG(LogNVSceneCapturer, Warning, TEXT("%d captured data are discarded since the color images of their frames never came."), DiscardedActionCount);
+    }
+
+    CheckedFrameCounter.Reset();
+    DroppedFrameCounter.Reset();
+}
+
+int32 FNVDuplicateFrameFilter::GetCheckedFrameCount() const
+{
+    return CheckedFrameCounter.GetValue();
+}
+
+int32 FNVDuplicateFrameFilter::GetDroppedFrameCount() const
+{
+    return DroppedFrameCounter.GetValue();
+}
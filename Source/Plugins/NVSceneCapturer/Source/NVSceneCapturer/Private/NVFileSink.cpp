@@ -0,0 +1,259 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVFileSink.h"
+#include "Async/Async.h"
+#include "Misc/QueuedThreadPool.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+
+//================================== FNVFileSinkStats ==================================
+FString FNVFileSinkStats::ToString() const
+{
+    return FString::Printf(TEXT("Written files: %lld - Failed: %lld - In flight: %d files, %d ops - Written: %.2f MB - Throughput: %.2f MB/s - Submit latency avg: %.3f ms, max: %.3f ms - Ops per submission: %.1f"),
+                           WrittenFileCount, FailedFileCount, InFlightCount, InFlightOpCount,
+                           WrittenBytes / (1024.0 * 1024.0), BytesPerSecond / (1024.0 * 1024.0),
+                           AverageSubmitLatency * 1000.0, MaxSubmitLatency * 1000.0, AverageBatchSize);
+}
+
+//================================== INVFileSink ==================================
+bool INVFileSink::WriteFile(const FString& FilePath, const FString& FileContent)
+{
+    FTCHARToUTF8 UTF8Content(*FileContent);
+    TArray<uint8> FileData(reinterpret_cast<const uint8*>(UTF8Content.Get()), UTF8Content.Length());
+    return WriteFile(FilePath, MoveTemp(FileData));
+}
+
+TSharedPtr<INVFileSink, ESPMode::ThreadSafe> INVFileSink::CreateFileSink(int32 MaxInFlightCount)
+{
+#if PLATFORM_LINUX
+    TSharedPtr<FNVFileSink_IoUring, ESPMode::ThreadSafe> IoUringFileSink = FNVFileSink_IoUring::Create(MaxInFlightCount);
+    if (IoUringFileSink.IsValid())
+    {
+        return IoUringFileSink;
+    }
+    UE_LOG(LogNVSceneCapturer, Log, TEXT("io_uring isn't available, the files are written by the thread pool file sink."));
+#endif // PLATFORM_LINUX
+
+    const int32 WriterThreadCount = FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads() / 2, 2, 8);
+    return MakeShareable(new FNVFileSink_ThreadPool(MaxInFlightCount, WriterThreadCount));
+}
+
+//================================== FNVFileSinkBase ==================================
+FNVFileSinkBase::FWriteEvents::FWriteEvents()
+{
+    SlotFreedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    IdleEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+FNVFileSinkBase::FWriteEvents::~FWriteEvents()
+{
+    FPlatformProcess::ReturnSynchEventToPool(SlotFreedEvent);
+    FPlatformProcess::ReturnSynchEventToPool(IdleEvent);
+}
+
+void FNVFileSinkBase::FWriteEvents::OnFileWritten(int32 RemainInFlightCount)
+{
+    SlotFreedEvent->Trigger();
+    if (RemainInFlightCount == 0)
+    {
+        IdleEvent->Trigger();
+    }
+}
+
+FNVFileSinkBase::FNVFileSinkBase(int32 InMaxInFlightCount)
+    : MaxInFlightCount(InMaxInFlightCount)
+    , InFlightCount(0)
+    , WriteEvents(MakeShared<FWriteEvents, ESPMode::ThreadSafe>())
+    , InFlightOpCount(0)
+{
+    FirstSubmitTime = 0.0;
+    LastWrittenTime = 0.0;
+    TotalSubmitLatency = 0.0;
+    SubmittedFileCount = 0;
+    SubmittedOpCount = 0;
+    SubmitBatchCount = 0;
+    bTrackWrittenFiles = false;
+}
+
+void FNVFileSinkBase::ReserveInFlightSlot()
+{
+    const double SubmitStartTime = FPlatformTime::Seconds();
+
+    // Bounded submission queue: the slot is reserved with a compare-exchange so concurrent submitters can't exceed the bound together
+    int32 CurrentInFlightCount = InFlightCount.load();
+    for (;;)
+    {
+        if ((MaxInFlightCount > 0) && (CurrentInFlightCount >= MaxInFlightCount))
+        {
+            // NOTE: The wait time out so a slot freed before the wait start isn't missed
+            WriteEvents->SlotFreedEvent->Wait(10);
+            CurrentInFlightCount = InFlightCount.load();
+            continue;
+        }
+        if (InFlightCount.compare_exchange_weak(CurrentInFlightCount, CurrentInFlightCount + 1))
+        {
+            break;
+        }
+    }
+
+    const double SubmitLatency = FPlatformTime::Seconds() - SubmitStartTime;
+    FScopeLock ScopeLock(&StatsLock);
+    if (SubmittedFileCount == 0)
+    {
+        FirstSubmitTime = SubmitStartTime;
+    }
+    SubmittedFileCount++;
+    TotalSubmitLatency += SubmitLatency;
+    Stats.MaxSubmitLatency = FMath::Max(Stats.MaxSubmitLatency, SubmitLatency);
+}
+
+int32 FNVFileSinkBase::OnFileWritten(const FString& FilePath, bool bSucceeded, int64 FileSize)
+{
+    {
+        FScopeLock ScopeLock(&StatsLock);
+        if (bSucceeded)
+        {
+            Stats.WrittenFileCount++;
+            Stats.WrittenBytes += FileSize;
+            if (bTrackWrittenFiles)
+            {
+                WrittenFilePaths.Add(FilePath);
+            }
+        }
+        else
+        {
+            Stats.FailedFileCount++;
+        }
+        LastWrittenTime = FPlatformTime::Seconds();
+    }
+
+    // NOTE: Must be the last thing the write task touch, Flush() let the sink be destroyed right after this
+    return --InFlightCount;
+}
+
+bool FNVFileSinkBase::WriteFileBlocking(const FString& FilePath, const TArray<uint8>& FileData)
+{
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*FilePath));
+    if (!FileHandle)
+    {
+        // Only pay for the directory tree walk when the directory is actually missing
+        PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+        FileHandle.Reset(PlatformFile.OpenWrite(*FilePath));
+    }
+    return FileHandle && ((FileData.Num() == 0) || FileHandle->Write(FileData.GetData(), FileData.Num()));
+}
+
+void FNVFileSinkBase::Flush()
+{
+    // NOTE: The wait time out so the last write finishing before the wait start isn't missed
+    while (InFlightCount.load() > 0)
+    {
+        WriteEvents->IdleEvent->Wait(10);
+    }
+}
+
+int32 FNVFileSinkBase::GetInFlightCount() const
+{
+    return InFlightCount.load();
+}
+
+FNVFileSinkStats FNVFileSinkBase::GetStats() const
+{
+    FScopeLock ScopeLock(&StatsLock);
+
+    FNVFileSinkStats CurrentStats = Stats;
+    CurrentStats.InFlightCount = InFlightCount.load();
+    CurrentStats.InFlightOpCount = InFlightOpCount.load();
+    CurrentStats.AverageSubmitLatency = (SubmittedFileCount > 0) ? (TotalSubmitLatency / SubmittedFileCount) : 0.0;
+    CurrentStats.AverageBatchSize = (SubmitBatchCount > 0) ? (double(SubmittedOpCount) / SubmitBatchCount) : 0.0;
+
+    const double WritingDuration = LastWrittenTime - FirstSubmitTime;
+    CurrentStats.BytesPerSecond = (WritingDuration > 0.0) ? (CurrentStats.WrittenBytes / WritingDuration) : 0.0;
+    return CurrentStats;
+}
+
+void FNVFileSinkBase::SetTrackWrittenFiles(bool bInTrackWrittenFiles)
+{
+    FScopeLock ScopeLock(&StatsLock);
+    bTrackWrittenFiles = bInTrackWrittenFiles;
+    if (!bTrackWrittenFiles)
+    {
+        WrittenFilePaths.Reset();
+    }
+}
+
+void FNVFileSinkBase::ConsumeWrittenFilePaths(TArray<FString>& OutFilePaths)
+{
+    FScopeLock ScopeLock(&StatsLock);
+    OutFilePaths = MoveTemp(WrittenFilePaths);
+    WrittenFilePaths.Reset();
+}
+
+//================================== FNVFileSink_ThreadPool ==================================
+FNVFileSink_ThreadPool::FNVFileSink_ThreadPool(int32 InMaxInFlightCount, int32 WriterThreadCount)
+    : FNVFileSinkBase(InMaxInFlightCount)
+{
+    WriterThreadPool = FQueuedThreadPool::Allocate();
+    const uint32 WriterThreadStackSize = 128 * 1024;
+    if (!WriterThreadPool->Create(FMath::Max(WriterThreadCount, 1), WriterThreadStackSize, EThreadPriority::TPri_Normal, TEXT("NVFileSinkThreadPool")))
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't create the file writer threads, the files will be written by the engine's thread pool."));
+        delete WriterThreadPool;
+        WriterThreadPool = nullptr;
+    }
+}
+
+FNVFileSink_ThreadPool::~FNVFileSink_ThreadPool()
+{
+    // Make sure all the queued files are written before the writer threads are destroyed
+    Flush();
+
+    if (WriterThreadPool)
+    {
+        WriterThreadPool->Destroy();
+        delete WriterThreadPool;
+        WriterThreadPool = nullptr;
+    }
+}
+
+bool FNVFileSink_ThreadPool::WriteFile(const FString& FilePath, TArray<uint8>&& FileData)
+{
+    ReserveInFlightSlot();
+
+    auto WriteFileTask = [this, TaskWriteEvents = WriteEvents, FilePath, WriteData = MoveTemp(FileData)]()
+    {
+        // Each file is a single blocking write operation for this backend
+        InFlightOpCount++;
+        const bool bSucceeded = WriteFileBlocking(FilePath, WriteData);
+        InFlightOpCount--;
+        if (!bSucceeded)
+        {
+            UE_LOG(LogNVSceneCapturer, Error, TEXT("Unable to open file for writing.  Check permissions. File is %s"), *FilePath);
+        }
+        {
+            FScopeLock ScopeLock(&StatsLock);
+            SubmittedOpCount++;
+            SubmitBatchCount++;
+        }
+        const int32 RemainInFlightCount = OnFileWritten(FilePath, bSucceeded, WriteData.Num());
+
+        // NOTE: The sink may be destroyed by now, only the events the task hold are still valid
+        TaskWriteEvents->OnFileWritten(RemainInFlightCount);
+    };
+
+    if (WriterThreadPool)
+    {
+        AsyncPool(*WriterThreadPool, MoveTemp(WriteFileTask));
+    }
+    else
+    {
+        Async(EAsyncExecution::ThreadPool, MoveTemp(WriteFileTask));
+    }
+    return true;
+}
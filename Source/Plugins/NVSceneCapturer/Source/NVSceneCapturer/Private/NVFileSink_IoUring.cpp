@@ -0,0 +1,598 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVFileSink.h"
+
+#if PLATFORM_LINUX
+
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+///
+/// The io_uring ABI the sink use, declared here because the headers of the engine's Linux toolchain predate <linux/io_uring.h>
+/// NOTE: The system call numbers are the same on all the architectures since Linux 5.1
+///
+namespace
+{
+    const long IoUringSetupSyscall = 425;
+    const long IoUringEnterSyscall = 426;
+    const long IoUringRegisterSyscall = 427;
+
+    const uint64 IoUringOffsetSqRing = 0ULL;
+    const uint64 IoUringOffsetCqRing = 0x8000000ULL;
+    const uint64 IoUringOffsetSqes = 0x10000000ULL;
+
+    const uint32 IoUringFeatureSingleMmap = 1U << 0;
+    const uint32 IoUringEnterGetEvents = 1U << 0;
+    const uint32 IoUringRegisterProbe = 8;
+    const uint16 IoUringOpSupported = 1U << 0;
+
+    const uint8 IoUringOpOpenAt = 18;
+    const uint8 IoUringOpClose = 19;
+    const uint8 IoUringOpWrite = 23;
+
+    struct FIoUringSqRingOffsets
+    {
+        uint32 Head;
+        uint32 Tail;
+        uint32 RingMask;
+        uint32 RingEntries;
+        uint32 Flags;
+        uint32 Dropped;
+        uint32 Array;
+        uint32 Reserved1;
+        uint64 Reserved2;
+    };
+
+    struct FIoUringCqRingOffsets
+    {
+        uint32 Head;
+        uint32 Tail;
+        uint32 RingMask;
+        uint32 RingEntries;
+        uint32 Overflow;
+        uint32 Cqes;
+        uint32 Flags;
+        uint32 Reserved1;
+        uint64 Reserved2;
+    };
+
+    struct FIoUringParams
+    {
+        uint32 SqEntries;
+        uint32 CqEntries;
+        uint32 Flags;
+        uint32 SqThreadCpu;
+        uint32 SqThreadIdle;
+        uint32 Features;
+        uint32 WqFd;
+        uint32 Reserved[3];
+        FIoUringSqRingOffsets SqOffsets;
+        FIoUringCqRingOffsets CqOffsets;
+    };
+    static_assert(sizeof(FIoUringParams) == 120, "Must match struct io_uring_params");
+
+    struct FIoUringSqe
+    {
+        uint8 Opcode;
+        uint8 Flags;
+        uint16 IoPriority;
+        int32 Fd;
+        uint64 Offset;
+        uint64 Address;
+        uint32 Length;
+        uint32 OperationFlags;
+        uint64 UserData;
+        uint16 BufferIndex;
+        uint16 Personality;
+        uint32 FileIndex;
+        uint64 Padding[2];
+    };
+    static_assert(sizeof(FIoUringSqe) == 64, "Must match struct io_uring_sqe");
+
+    struct FIoUringCqe
+    {
+        uint64 UserData;
+        int32 Result;
+        uint32 Flags;
+    };
+    static_assert(sizeof(FIoUringCqe) == 16, "Must match struct io_uring_cqe");
+
+    struct FIoUringProbeOp
+    {
+        uint8 Op;
+        uint8 Reserved;
+        uint16 Flags;
+        uint32 Reserved2;
+    };
+
+    struct FIoUringProbe
+    {
+        uint8 LastOp;
+        uint8 OpsLength;
+        uint16 Reserved;
+        uint32 Reserved2[3];
+        FIoUringProbeOp Ops[256];
+    };
+
+    FString GetErrorMessage(int32 ErrorCode)
+    {
+        return ANSI_TO_TCHAR(strerror(ErrorCode));
+    }
+}
+
+//================================== FNVFileSink_IoUring::FRing ==================================
+/// The submission and completion rings shared with the kernel
+struct FNVFileSink_IoUring::FRing
+{
+    int32 RingFd = -1;
+
+    void* SqRingPtr = nullptr;
+    size_t SqRingSize = 0;
+    void* CqRingPtr = nullptr;
+    size_t CqRingSize = 0;
+    FIoUringSqe* Sqes = nullptr;
+    size_t SqesSize = 0;
+
+    uint32* SqHead = nullptr;
+    uint32* SqTail = nullptr;
+    uint32 SqMask = 0;
+    uint32 SqEntries = 0;
+    /// Tail of the entries prepared by the sink, they're visible to the kernel when they're submitted
+    uint32 SqLocalTail = 0;
+
+    uint32* CqHead = nullptr;
+    uint32* CqTail = nullptr;
+    uint32 CqMask = 0;
+    FIoUringCqe* Cqes = nullptr;
+
+    ~FRing()
+    {
+        if (Sqes)
+        {
+            munmap(Sqes, SqesSize);
+        }
+        if (CqRingPtr && (CqRingPtr != SqRingPtr))
+        {
+            munmap(CqRingPtr, CqRingSize);
+        }
+        if (SqRingPtr)
+        {
+            munmap(SqRingPtr, SqRingSize);
+        }
+        if (RingFd >= 0)
+        {
+            close(RingFd);
+        }
+    }
+
+    static bool SupportOperations(int32 RingFd)
+    {
+        FIoUringProbe Probe;
+        FMemory::Memzero(Probe);
+        if (syscall(IoUringRegisterSyscall, RingFd, IoUringRegisterProbe, &Probe, 256) < 0)
+        {
+            // NOTE: The probe itself came with Linux 5.6, like the open and close operations
+            return false;
+        }
+
+        for (const uint8 RequiredOp : { IoUringOpOpenAt, IoUringOpWrite, IoUringOpClose })
+        {
+            if ((RequiredOp > Probe.LastOp) || !(Probe.Ops[RequiredOp].Flags & IoUringOpSupported))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static TUniquePtr<FRing> Create(uint32 EntryCount)
+    {
+        FIoUringParams Params;
+        FMemory::Memzero(Params);
+        const int32 RingFd = int32(syscall(IoUringSetupSyscall, EntryCount, &Params));
+        if (RingFd < 0)
+        {
+            UE_LOG(LogNVSceneCapturer, Log, TEXT("Can't create an io_uring: %s"), *GetErrorMessage(errno));
+            return nullptr;
+        }
+
+        TUniquePtr<FRing> NewRing = MakeUnique<FRing>();
+        NewRing->RingFd = RingFd;
+        if (!SupportOperations(RingFd))
+        {
+            UE_LOG(LogNVSceneCapturer, Log, TEXT("The kernel's io_uring doesn't support the file open, write and close operations."));
+            return nullptr;
+        }
+
+        NewRing->SqRingSize = Params.SqOffsets.Array + Params.SqEntries * sizeof(uint32);
+        NewRing->CqRingSize = Params.CqOffsets.Cqes + Params.CqEntries * sizeof(FIoUringCqe);
+        const bool bSingleMmap = (Params.Features & IoUringFeatureSingleMmap) != 0;
+        if (bSingleMmap)
+        {
+            NewRing->SqRingSize = NewRing->CqRingSize = FMath::Max(NewRing->SqRingSize, NewRing->CqRingSize);
+        }
+
+        NewRing->SqRingPtr = mmap(nullptr, NewRing->SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IoUringOffsetSqRing);
+        if (NewRing->SqRingPtr == MAP_FAILED)
+        {
+            NewRing->SqRingPtr = nullptr;
+            return nullptr;
+        }
+        NewRing->CqRingPtr = bSingleMmap ? NewRing->SqRingPtr :
+                             mmap(nullptr, NewRing->CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IoUringOffsetCqRing);
+        if (NewRing->CqRingPtr == MAP_FAILED)
+        {
+            NewRing->CqRingPtr = nullptr;
+            return nullptr;
+        }
+        NewRing->SqesSize = Params.SqEntries * sizeof(FIoUringSqe);
+        void* SqesPtr = mmap(nullptr, NewRing->SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, RingFd, IoUringOffsetSqes);
+        if (SqesPtr == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        NewRing->Sqes = static_cast<FIoUringSqe*>(SqesPtr);
+
+        uint8* SqRingData = static_cast<uint8*>(NewRing->SqRingPtr);
+        NewRing->SqHead = reinterpret_cast<uint32*>(SqRingData + Params.SqOffsets.Head);
+        NewRing->SqTail = reinterpret_cast<uint32*>(SqRingData + Params.SqOffsets.Tail);
+        NewRing->SqMask = *reinterpret_cast<uint32*>(SqRingData + Params.SqOffsets.RingMask);
+        NewRing->SqEntries = Params.SqEntries;
+        NewRing->SqLocalTail = *NewRing->SqTail;
+
+        // The entries are always used in order, the index array never change
+        uint32* SqArray = reinterpret_cast<uint32*>(SqRingData + Params.SqOffsets.Array);
+        for (uint32 EntryIndex = 0; EntryIndex < Params.SqEntries; EntryIndex++)
+        {
+            SqArray[EntryIndex] = EntryIndex;
+        }
+
+        uint8* CqRingData = static_cast<uint8*>(NewRing->CqRingPtr);
+        NewRing->CqHead = reinterpret_cast<uint32*>(CqRingData + Params.CqOffsets.Head);
+        NewRing->CqTail = reinterpret_cast<uint32*>(CqRingData + Params.CqOffsets.Tail);
+        NewRing->CqMask = *reinterpret_cast<uint32*>(CqRingData + Params.CqOffsets.RingMask);
+        NewRing->Cqes = reinterpret_cast<FIoUringCqe*>(CqRingData + Params.CqOffsets.Cqes);
+        return NewRing;
+    }
+
+    /// Get a free submission entry, null if the kernel didn't consume enough of the submitted ones yet
+    FIoUringSqe* GetSqe()
+    {
+        const uint32 Head = __atomic_load_n(SqHead, __ATOMIC_ACQUIRE);
+        if ((SqLocalTail - Head) >= SqEntries)
+        {
+            return nullptr;
+        }
+        FIoUringSqe* Sqe = &Sqes[SqLocalTail & SqMask];
+        SqLocalTail++;
+        FMemory::Memzero(*Sqe);
+        return Sqe;
+    }
+
+    /// Submit all the prepared entries in a single system call
+    /// @param MinCompleteCount - Wait until this many operations are completed
+    /// @param OutSubmittedCount - Number of entries the kernel consumed
+    /// @return 0 or the negative error code
+    int32 Submit(uint32 MinCompleteCount, uint32& OutSubmittedCount)
+    {
+        OutSubmittedCount = 0;
+        __atomic_store_n(SqTail, SqLocalTail, __ATOMIC_RELEASE);
+        const uint32 ToSubmitCount = SqLocalTail - __atomic_load_n(SqHead, __ATOMIC_ACQUIRE);
+        for (;;)
+        {
+            const long Result = syscall(IoUringEnterSyscall, RingFd, ToSubmitCount, MinCompleteCount, (MinCompleteCount > 0) ? IoUringEnterGetEvents : 0, nullptr, 0);
+            if (Result >= 0)
+            {
+                OutSubmittedCount = uint32(Result);
+                return 0;
+            }
+            if (errno != EINTR)
+            {
+                return -errno;
+            }
+        }
+    }
+
+    /// Consume the completed operations
+    template <typename CallbackType>
+    void ForEachCompletion(CallbackType&& Callback)
+    {
+        uint32 Head = *CqHead;
+        const uint32 Tail = __atomic_load_n(CqTail, __ATOMIC_ACQUIRE);
+        while (Head != Tail)
+        {
+            const FIoUringCqe& Cqe = Cqes[Head & CqMask];
+            const uint64 UserData = Cqe.UserData;
+            const int32 Result = Cqe.Result;
+            Head++;
+            __atomic_store_n(CqHead, Head, __ATOMIC_RELEASE);
+            Callback(UserData, Result);
+        }
+    }
+};
+
+//================================== FNVFileSink_IoUring::FWriteRequest ==================================
+struct FNVFileSink_IoUring::FWriteRequest
+{
+    enum class EOperation : uint8
+    {
+        Open,
+        Write,
+        Close
+    };
+
+    FString FilePath;
+
+    /// Null-terminated absolute UTF-8 path of the file, the kernel read it while the open is in flight
+    TArray<uint8> NativeFilePath;
+
+    TArray<uint8> FileData;
+    int64 WrittenSize = 0;
+    int32 FileDescriptor = -1;
+    EOperation Operation = EOperation::Open;
+
+    /// The directory of the file is only created once, when the first open fail because it's missing
+    bool bCreatedDirectory = false;
+    bool bSucceeded = true;
+    int32 ErrorCode = 0;
+};
+
+//================================== FNVFileSink_IoUring ==================================
+TSharedPtr<FNVFileSink_IoUring, ESPMode::ThreadSafe> FNVFileSink_IoUring::Create(int32 InMaxInFlightCount, int32 QueueDepth /*= 256*/)
+{
+    TUniquePtr<FRing> NewRing = FRing::Create(uint32(FMath::Clamp(QueueDepth, 8, 4096)));
+    if (!NewRing.IsValid())
+    {
+        return nullptr;
+    }
+
+    TSharedPtr<FNVFileSink_IoUring, ESPMode::ThreadSafe> NewFileSink = MakeShareable(new FNVFileSink_IoUring(InMaxInFlightCount, MoveTemp(NewRing)));
+    if (!NewFileSink->SubmissionThread)
+    {
+        return nullptr;
+    }
+    return NewFileSink;
+}
+
+FNVFileSink_IoUring::FNVFileSink_IoUring(int32 InMaxInFlightCount, TUniquePtr<FRing>&& InRing)
+    : FNVFileSinkBase(InMaxInFlightCount)
+    , Ring(MoveTemp(InRing))
+{
+    bStopping = false;
+    bRingFailed = false;
+    PendingRequestEvent = FPlatformProcess::GetSynchEventFromPool(false);
+
+    const uint32 SubmissionThreadStackSize = 128 * 1024;
+    SubmissionThread = FRunnableThread::Create(this, TEXT("NVFileSinkIoUring"), SubmissionThreadStackSize, EThreadPriority::TPri_Normal);
+}
+
+FNVFileSink_IoUring::~FNVFileSink_IoUring()
+{
+    if (SubmissionThread)
+    {
+        // Make sure all the queued files are written before the ring is destroyed
+        Flush();
+        Stop();
+        SubmissionThread->WaitForCompletion();
+        delete SubmissionThread;
+        SubmissionThread = nullptr;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(PendingRequestEvent);
+    PendingRequestEvent = nullptr;
+}
+
+bool FNVFileSink_IoUring::WriteFile(const FString& FilePath, TArray<uint8>&& FileData)
+{
+    ReserveInFlightSlot();
+
+    FWriteRequest* NewRequest = new FWriteRequest();
+    NewRequest->FilePath = FilePath;
+    FTCHARToUTF8 UTF8FilePath(*FPaths::ConvertRelativePathToFull(FilePath));
+    NewRequest->NativeFilePath.Append(reinterpret_cast<const uint8*>(UTF8FilePath.Get()), UTF8FilePath.Length());
+    NewRequest->NativeFilePath.Add(0);
+    NewRequest->FileData = MoveTemp(FileData);
+
+    PendingRequests.Enqueue(NewRequest);
+    PendingRequestEvent->Trigger();
+    return true;
+}
+
+void FNVFileSink_IoUring::Stop()
+{
+    bStopping = true;
+    PendingRequestEvent->Trigger();
+}
+
+uint32 FNVFileSink_IoUring::Run()
+{
+    for (;;)
+    {
+        // Pick up the queued files while the ring has room for them: each file has a single operation in flight
+        // so the rings can't overflow
+        FWriteRequest* NewRequest = nullptr;
+        while ((bRingFailed || (ActiveRequests.Num() < int32(Ring->SqEntries))) && PendingRequests.Dequeue(NewRequest))
+        {
+            if (bRingFailed)
+            {
+                NewRequest->bSucceeded = WriteFileBlocking(NewRequest->FilePath, NewRequest->FileData);
+                FinishRequest(NewRequest);
+                continue;
+            }
+            ActiveRequests.Add(NewRequest);
+            PrepareNextOperation(*NewRequest);
+        }
+
+        if (ActiveRequests.Num() == 0)
+        {
+            if (bStopping && PendingRequests.IsEmpty())
+            {
+                break;
+            }
+            PendingRequestEvent->Wait();
+            continue;
+        }
+
+        // Submit all the prepared operations at once and wait for a part of them to complete, so the next submission is a batch too
+        // NOTE: Each file in the ring has exactly one operation in the kernel after the submission, the wait can't outlast them
+        uint32 SubmittedCount = 0;
+        const int32 SubmitResult = Ring->Submit(uint32(FMath::Max(ActiveRequests.Num() / 4, 1)), SubmittedCount);
+        if (SubmittedCount > 0)
+        {
+            InFlightOpCount += SubmittedCount;
+            FScopeLock ScopeLock(&StatsLock);
+            SubmittedOpCount += SubmittedCount;
+            SubmitBatchCount++;
+        }
+        if ((SubmitResult < 0) && (SubmitResult != -EAGAIN) && (SubmitResult != -EBUSY))
+        {
+            OnRingFailed(-SubmitResult);
+            continue;
+        }
+
+        Ring->ForEachCompletion([this](uint64 UserData, int32 OperationResult)
+        {
+            OnOperationCompleted(reinterpret_cast<FWriteRequest*>(UserData), OperationResult);
+        });
+    }
+    return 0;
+}
+
+void FNVFileSink_IoUring::PrepareNextOperation(FWriteRequest& WriteRequest)
+{
+    FIoUringSqe* Sqe = Ring->GetSqe();
+    // NOTE: There's never more operations prepared than files in the ring
+    check(Sqe);
+    Sqe->UserData = reinterpret_cast<uint64>(&WriteRequest);
+
+    switch (WriteRequest.Operation)
+    {
+    case FWriteRequest::EOperation::Open:
+        Sqe->Opcode = IoUringOpOpenAt;
+        Sqe->Fd = AT_FDCWD;
+        Sqe->Address = reinterpret_cast<uint64>(WriteRequest.NativeFilePath.GetData());
+        Sqe->Length = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+        Sqe->OperationFlags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        break;
+
+    case FWriteRequest::EOperation::Write:
+    {
+        const int64 RemainSize = WriteRequest.FileData.Num() - WriteRequest.WrittenSize;
+        Sqe->Opcode = IoUringOpWrite;
+        Sqe->Fd = WriteRequest.FileDescriptor;
+        Sqe->Address = reinterpret_cast<uint64>(WriteRequest.FileData.GetData() + WriteRequest.WrittenSize);
+        Sqe->Length = uint32(FMath::Min<int64>(RemainSize, MAX_int32));
+        Sqe->Offset = uint64(WriteRequest.WrittenSize);
+        break;
+    }
+
+    case FWriteRequest::EOperation::Close:
+        Sqe->Opcode = IoUringOpClose;
+        Sqe->Fd = WriteRequest.FileDescriptor;
+        break;
+    }
+}
+
+void FNVFileSink_IoUring::OnOperationCompleted(FWriteRequest* WriteRequest, int32 OperationResult)
+{
+    InFlightOpCount--;
+
+    switch (WriteRequest->Operation)
+    {
+    case FWriteRequest::EOperation::Open:
+        if (OperationResult >= 0)
+        {
+            WriteRequest->FileDescriptor = OperationResult;
+            WriteRequest->Operation = (WriteRequest->FileData.Num() > 0) ? FWriteRequest::EOperation::Write : FWriteRequest::EOperation::Close;
+        }
+        else if ((OperationResult == -ENOENT) && !WriteRequest->bCreatedDirectory)
+        {
+            // The directories are only created when they're missing, instead of being checked for each file
+            WriteRequest->bCreatedDirectory = true;
+            FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*FPaths::GetPath(FPaths::ConvertRelativePathToFull(WriteRequest->FilePath)));
+        }
+        else
+        {
+            WriteRequest->bSucceeded = false;
+            WriteRequest->ErrorCode = -OperationResult;
+            FinishRequest(WriteRequest);
+            return;
+        }
+        break;
+
+    case FWriteRequest::EOperation::Write:
+        if (OperationResult > 0)
+        {
+            // NOTE: A short write is continued from where it stopped
+            WriteRequest->WrittenSize += OperationResult;
+            if (WriteRequest->WrittenSize >= WriteRequest->FileData.Num())
+            {
+                WriteRequest->Operation = FWriteRequest::EOperation::Close;
+            }
+        }
+        else
+        {
+            WriteRequest->bSucceeded = false;
+            WriteRequest->ErrorCode = (OperationResult < 0) ? -OperationResult : EIO;
+            WriteRequest->Operation = FWriteRequest::EOperation::Close;
+        }
+        break;
+
+    case FWriteRequest::EOperation::Close:
+        if ((OperationResult < 0) && WriteRequest->bSucceeded)
+        {
+            WriteRequest->bSucceeded = false;
+            WriteRequest->ErrorCode = -OperationResult;
+        }
+        FinishRequest(WriteRequest);
+        return;
+    }
+    PrepareNextOperation(*WriteRequest);
+}
+
+void FNVFileSink_IoUring::FinishRequest(FWriteRequest* WriteRequest)
+{
+    if (!WriteRequest->bSucceeded)
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Unable to open file for writing.  Check permissions. File is %s (%s)"),
+               *WriteRequest->FilePath, *GetErrorMessage(WriteRequest->ErrorCode));
+    }
+    ActiveRequests.Remove(WriteRequest);
+    const int32 RemainInFlightCount = OnFileWritten(WriteRequest->FilePath, WriteRequest->bSucceeded, WriteRequest->FileData.Num());
+    delete WriteRequest;
+
+    // NOTE: The sink wait for this thread before it's destroyed, its events are still valid
+    WriteEvents->OnFileWritten(RemainInFlightCount);
+}
+
+void FNVFileSink_IoUring::OnRingFailed(int32 ErrorCode)
+{
+    UE_LOG(LogNVSceneCapturer, Error, TEXT("The io_uring submission failed (%s), the next files are written synchronously."), *GetErrorMessage(ErrorCode));
+    bRingFailed = true;
+
+    // NOTE: The ring isn't used any more, the operations still in the kernel are never reaped.
+    // Their requests are leaked on purpose: the kernel may still read their path or data
+    TArray<FWriteRequest*> FailedRequests = ActiveRequests.Array();
+    ActiveRequests.Reset();
+    InFlightOpCount = 0;
+    for (FWriteRequest* FailedRequest : FailedRequests)
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Unable to open file for writing.  Check permissions. File is %s"), *FailedRequest->FilePath);
+        WriteEvents->OnFileWritten(OnFileWritten(FailedRequest->FilePath, false, FailedRequest->FileData.Num()));
+    }
+}
+
+#endif // PLATFORM_LINUX
@@ -0,0 +1,117 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVFrameManifest.h"
+#include "Json.h"
+#include "HAL/PlatformFilemanager.h"
+
+const FString FNVFrameManifest::ManifestFileName = TEXT("_frame_manifest.jsonl");
+
+FNVFrameManifest::FNVFrameManifest()
+{
+}
+
+FNVFrameManifest::~FNVFrameManifest()
+{
+    Close();
+}
+
+bool FNVFrameManifest::Open(const FString& OutputDirectoryPath, bool bAppend)
+{
+    Close();
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const FString ManifestFilePath = FPaths::Combine(OutputDirectoryPath, ManifestFileName);
+    if (!PlatformFile.DirectoryExists(*OutputDirectoryPath))
+    {
+        PlatformFile.CreateDirectoryTree(*OutputDirectoryPath);
+    }
+
+    bool bNeedLineBreak = false;
+    if (bAppend)
+    {
+        // A crash may leave the last entry incomplete, start the new entries on a new line
+        TUniquePtr<IFileHandle> ReadFileHandle(PlatformFile.OpenRead(*ManifestFilePath));
+        if (ReadFileHandle.IsValid() && (ReadFileHandle->Size() > 0))
+        {
+            uint8 LastByte = 0;
+            bNeedLineBreak = ReadFileHandle->Seek(ReadFileHandle->Size() - 1) && ReadFileHandle->Read(&LastByte, 1) && (LastByte != '\n');
+        }
+    }
+    else
+    {
+        PlatformFile.DeleteFile(*ManifestFilePath);
+    }
+
+    FScopeLock ScopeLock(&ManifestLock);
+    ManifestFileHandle.Reset(PlatformFile.OpenWrite(*ManifestFilePath, true));
+    if (!ManifestFileHandle.IsValid())
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't open the frame manifest for writing: %s"), *ManifestFilePath);
+        return false;
+    }
+
+    if (bNeedLineBreak)
+    {
+        const uint8 LineBreak = '\n';
+        ManifestFileHandle->Write(&LineBreak, 1);
+    }
+    return true;
+}
+
+void FNVFrameManifest::Close()
+{
+    FScopeLock ScopeLock(&ManifestLock);
+    if (ManifestFileHandle.IsValid())
+    {
+        ManifestFileHandle->Flush(true);
+        ManifestFileHandle.Reset();
+    }
+}
+
+bool FNVFrameManifest::IsOpen() const
+{
+    FScopeLock ScopeLock(&ManifestLock);
+    return ManifestFileHandle.IsValid();
+}
+
+bool FNVFrameManifest::AppendFrameEntry(int32 FrameIndex, const FString& ViewpointName, const TArray<TPair<FString, FString>>& ExportedFiles)
+{
+    TSharedPtr<FJsonObject> FilesJsonObj = MakeShareable(new FJsonObject());
+    for (const TPair<FString, FString>& ExportedFile : ExportedFiles)
+    {
+        FilesJsonObj->SetStringField(ExportedFile.Key, ExportedFile.Value);
+    }
+
+    TSharedPtr<FJsonObject> EntryJsonObj = MakeShareable(new FJsonObject());
+    EntryJsonObj->SetNumberField(TEXT("frame_index"), FrameIndex);
+    EntryJsonObj->SetStringField(TEXT("viewpoint"), ViewpointName);
+    EntryJsonObj->SetObjectField(TEXT("files"), FilesJsonObj);
+
+    // NOTE: Each entry must be on a single line
+    FString EntryLine;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&EntryLine);
+    FJsonSerializer::Serialize(EntryJsonObj.ToSharedRef(), JsonWriter);
+    EntryLine += TEXT("\n");
+    FTCHARToUTF8 UTF8Line(*EntryLine);
+
+    FScopeLock ScopeLock(&ManifestLock);
+    if (!ManifestFileHandle.IsValid())
+    {
+        return false;
+    }
+    return ManifestFileHandle->Write(reinterpret_cast<const uint8*>(UTF8Line.Get()), UTF8Line.Length());
+}
+
+void FNVFrameManifest::Flush()
+{
+    FScopeLock ScopeLock(&ManifestLock);
+    if (ManifestFileHandle.IsValid())
+    {
+        ManifestFileHandle->Flush(true);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVFrameVisibilityFilter.h"
+#include "ConvexVolume.h"
+#include "SceneManagement.h"
+
+//================================== FNVFrameVisibilitySettings ==================================
+FNVFrameVisibilitySettings::FNVFrameVisibilitySettings()
+{
+    bEnabled = false;
+    MinVisibleObjectCount = 1;
+    MinProjectedArea = 0.f;
+    MaxConsecutiveRejectedFrames = 1000;
+}
+
+//================================== FNVFrameVisibilityFilter ==================================
+bool FNVFrameVisibilityFilter::IsBoxInFrustum(const FMatrix& ViewProjectionMatrix, const FBox& Bounds)
+{
+    if (!Bounds.IsValid)
+    {
+        return false;
+    }
+
+    FConvexVolume ViewFrustum;
+    GetViewFrustumBounds(ViewFrustum, ViewProjectionMatrix, false);
+    return ViewFrustum.IntersectBox(Bounds.GetCenter(), Bounds.GetExtent());
+}
+
+float FNVFrameVisibilityFilter::CalculateProjectedArea(const FMatrix& ViewProjectionMatrix, const FBox& Bounds)
+{
+    if (!Bounds.IsValid)
+    {
+        return 0.f;
+    }
+
+    FVector BoundVertexes[8];
+    Bounds.GetVertices(BoundVertexes);
+    FBox2D ProjectedBox(EForceInit::ForceInit);
+    for (const FVector& BoundVertex : BoundVertexes)
+    {
+        const FPlane ProjectedVertex = ViewProjectionMatrix.TransformFVector4(FVector4(BoundVertex, 1.f));
+        if (ProjectedVertex.W <= KINDA_SMALL_NUMBER)
+        {
+            // NOTE: The box is partly behind the camera, it may cover any part of the image
+            return 1.f;
+        }
+        ProjectedBox += FVector2D(ProjectedVertex.X / ProjectedVertex.W, ProjectedVertex.Y / ProjectedVertex.W);
+    }
+
+    // The image cover [-1, 1] on both axes of the normalized device coordinates
+    const FBox2D ImageBox(FVector2D(-1.f, -1.f), FVector2D(1.f, 1.f));
+    if (!ImageBox.Intersect(ProjectedBox))
+    {
+        return 0.f;
+    }
+    return ProjectedBox.Overlap(ImageBox).GetArea() / ImageBox.GetArea();
+}
+
+int32 FNVFrameVisibilityFilter::CountVisibleObjects(const FMatrix& ViewProjectionMatrix, const TArray<FBox>& ObjectBounds, float MinProjectedArea)
+{
+    FConvexVolume ViewFrustum;
+    GetViewFrustumBounds(ViewFrustum, ViewProjectionMatrix, false);
+
+    int32 VisibleObjectCount = 0;
+    for (const FBox& Bounds : ObjectBounds)
+    {
+        if (!Bounds.IsValid || !ViewFrustum.IntersectBox(Bounds.GetCenter(), Bounds.GetExtent()))
+        {
+            continue;
+        }
+        if ((MinProjectedArea > 0.f) && (CalculateProjectedArea(ViewProjectionMatrix, Bounds) < MinProjectedArea))
+        {
+            continue;
+        }
+        VisibleObjectCount++;
+    }
+    return VisibleObjectCount;
+}
+
+bool FNVFrameVisibilityFilter::HasEnoughVisibleObjects(const FNVFrameVisibilitySettings& Settings, const FMatrix& ViewProjectionMatrix, const TArray<FBox>& ObjectBounds)
+{
+    const int32 MinVisibleObjectCount = FMath::Max(Settings.MinVisibleObjectCount, 1);
+    if (ObjectBounds.Num() < MinVisibleObjectCount)
+    {
+        return false;
+    }
+    return (CountVisibleObjects(ViewProjectionMatrix, ObjectBounds, Settings.MinProjectedArea) >= MinVisibleObjectCount);
+}
@@ -10,6 +10,8 @@
 #include "HAL/RunnableThread.h"
 #include "Async/Async.h"
 #include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
 #include "ImageUtils.h"
 #include "IImageWrapperModule.h"
 #if WITH_UNREALPNG
@@ -296,7 +298,7 @@ TArray<uint8>  FNVImageExporter::CompressImage(IImageWrapperModule* ImageWrapper
     return CompressedData;
 }
 
-bool FNVImageExporter::ExportImage(IImageWrapperModule* ImageWrapperModule, const FNVImageExporterData& ImageExporterData)
+bool FNVImageExporter::ExportImage(IImageWrapperModule* ImageWrapperModule, const FNVImageExporterData& ImageExporterData, INVFileSink* FileSink /*= nullptr*/)
 {
 	bool bResult = false;
 	const auto& ExportedPixelData = ImageExporterData.PixelDataToBeExported;
@@ -315,8 +317,15 @@ bool FNVImageExporter::ExportImage(IImageWrapperModule* ImageWrapperModule, cons
 		else
 		{
 			const uint8 CompressedQuality = 100;
-			const TArray<uint8>& CompressedBitmap = CompressImage(ImageWrapperModule, ExportedPixelData, ExportImageFormat, CompressedQuality);
-			bResult = FFileHelper::SaveArrayToFile(CompressedBitmap, *ExportFilePath);
+			TArray<uint8> CompressedBitmap = CompressImage(ImageWrapperModule, ExportedPixelData, ExportImageFormat, CompressedQuality);
+			if (FileSink)
+			{
+				bResult = (CompressedBitmap.Num() > 0) && FileSink->WriteFile(ExportFilePath, MoveTemp(CompressedBitmap));
+			}
+			else
+			{
+				bResult = FFileHelper::SaveArrayToFile(CompressedBitmap, *ExportFilePath);
+			}
 		}
 		if (!bResult)
 		{
@@ -332,8 +341,9 @@ bool FNVImageExporter::ExportImage(const FNVImageExporterData& ImageExporterData
 }
 
 //====================================== FNVSaveImageToFileThread ==========================================
-FNVImageExporter_Thread::FNVImageExporter_Thread(IImageWrapperModule* InImageWrapperModule)
-    : ImageWrapperModule(InImageWrapperModule)
+FNVImageExporter_Thread::FNVImageExporter_Thread(IImageWrapperModule* InImageWrapperModule, TSharedPtr<INVFileSink, ESPMode::ThreadSafe> InFileSink /*= nullptr*/)
+    : ImageWrapperModule(InImageWrapperModule),
+      FileSink(InFileSink)
 {
     ensure(ImageWrapperModule);
 
@@ -364,6 +374,22 @@ FNVImageExporter_Thread::~FNVImageExporter_Thread()
     Kill();
 }
 
+bool FNVImageExporter_Thread::ExportInstanceMask(const FNVTexturePixelData& InstanceMaskPixelData, const FString& ExportFilePath, const ENVImageFormat ExportImageFormat,
+                                                const TSharedPtr<const FNVInstanceClassLUT, ESPMode::ThreadSafe>& InstanceClassLUT, const FString& ClassMaskExportFilePath)
+{
+    FNVImageExporterData NewImageExporterData = FNVImageExporterData(InstanceMaskPixelData, ExportFilePath, ExportImageFormat);
+    NewImageExporterData.InstanceClassLUT = InstanceClassLUT;
+    NewImageExporterData.ClassMaskExportFilePath = ClassMaskExportFilePath;
+    QueuedImageData.Enqueue(MoveTemp(NewImageExporterData));
+    PendingImageCounter.Increment();
+
+    if (HavePendingImageEvent)
+    {
+        HavePendingImageEvent->Trigger();
+    }
+    return true;
+}
+
 bool FNVImageExporter_Thread::ExportImage(const FNVTexturePixelData& ExportPixelData, const FString& ExportFilePath, const ENVImageFormat ExportImageFormat/*= ENVImageFormat::PNG*/)
 {
     FNVImageExporterData NewImageExporterData = FNVImageExporterData(ExportPixelData, ExportFilePath, ExportImageFormat);
@@ -401,9 +427,21 @@ uint32 FNVImageExporter_Thread::Run()
             ExportingImageCounterPtr->Increment();
             auto TempExportingImageCounterPtr = ExportingImageCounterPtr;
             auto TempImageWrapperModule = ImageWrapperModule;
-            Async(AsyncExecution, [TempExportingImageCounterPtr, TempImageWrapperModule, CheckImageData = MoveTemp(TmpImageData)]()
+            auto TempFileSink = FileSink;
+            Async(AsyncExecution, [TempExportingImageCounterPtr, TempImageWrapperModule, TempFileSink, CheckImageData = MoveTemp(TmpImageData)]()
                   {
-                        FNVImageExporter::ExportImage(TempImageWrapperModule, CheckImageData);
+                        FNVImageExporter::ExportImage(TempImageWrapperModule, CheckImageData, TempFileSink.Get());
+                        if (CheckImageData.InstanceClassLUT.IsValid())
+                        {
+                            // Remap the instance mask to its class mask here so it doesn't need to be rendered
+                            FNVImageExporterData ClassMaskData;
+                            ClassMaskData.ExportFilePath = CheckImageData.ClassMaskExportFilePath;
+                            ClassMaskData.ExportImageFormat = CheckImageData.ExportImageFormat;
+                            if (FNVInstanceClassRemap::Remap(CheckImageData.PixelDataToBeExported, *CheckImageData.InstanceClassLUT, ClassMaskData.PixelDataToBeExported))
+                            {
+                                FNVImageExporter::ExportImage(TempImageWrapperModule, ClassMaskData, TempFileSink.Get());
+                            }
+                        }
                         if (TempExportingImageCounterPtr.IsValid())
                         {
                             TempExportingImageCounterPtr->Decrement();
@@ -467,3 +505,275 @@ FNVImageExporterData::FNVImageExporterData(const FNVTexturePixelData& InPixelDat
 	ExportImageFormat(InExportImageFormat)
 {
 }
+
+//====================================== FNVImageBandWriter ==========================================
+#if WITH_UNREALPNG
+namespace
+{
+    void PngFileWriteCallback(png_structp png_ptr, png_bytep data, png_size_t length)
+    {
+        IFileHandle* FileHandle = (IFileHandle*)png_get_io_ptr(png_ptr);
+        if (!FileHandle || !FileHandle->Write(data, length))
+        {
+            png_error(png_ptr, "Failed to write the PNG file");
+        }
+    }
+
+    void PngFileFlushCallback(png_structp png_ptr)
+    {
+    }
+
+    // NOTE: libpng report its errors with longjmp so the functions setting the jump point must not own any C++ object
+    bool PngBeginImage(png_structp png_ptr, png_infop info_ptr, IFileHandle* FileHandle, const FIntPoint& ImageSize, uint8 BitDepth, ERGBFormat RGBFormat)
+    {
+        if (setjmp(png_jmpbuf(png_ptr)))
+        {
+            return false;
+        }
+
+        png_set_write_fn(png_ptr, FileHandle, PngFileWriteCallback, PngFileFlushCallback);
+        png_set_compression_level(png_ptr, Z_BEST_SPEED);
+        png_set_IHDR(png_ptr, info_ptr, ImageSize.X, ImageSize.Y, BitDepth, (RGBFormat == ERGBFormat::Gray) ?
+            PNG_COLOR_TYPE_GRAY : PNG_COLOR_TYPE_RGBA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png_ptr, info_ptr);
+
+        // NOTE: Same transforms as FNVImageExporter::CompressImagePNG
+        if (RGBFormat == ERGBFormat::BGRA)
+        {
+            png_set_bgr(png_ptr);
+        }
+#if PLATFORM_LITTLE_ENDIAN
+        // PNG files store 16-bit pixels in network byte order (big-endian)
+        if (BitDepth == 16)
+        {
+            png_set_swap(png_ptr);
+        }
+#endif
+        return true;
+    }
+
+    bool PngWriteRows(png_structp png_ptr, const uint8* RowsData, int32 RowCount, int64 RowByteSize)
+    {
+        if (setjmp(png_jmpbuf(png_ptr)))
+        {
+            return false;
+        }
+
+        for (int32 i = 0; i < RowCount; i++)
+        {
+            png_write_row(png_ptr, (png_bytep)(RowsData + i * RowByteSize));
+        }
+        return true;
+    }
+
+    bool PngEndImage(png_structp png_ptr, png_infop info_ptr)
+    {
+        if (setjmp(png_jmpbuf(png_ptr)))
+        {
+            return false;
+        }
+
+        png_write_end(png_ptr, info_ptr);
+        return true;
+    }
+}
+#endif // WITH_UNREALPNG
+
+FNVImageBandWriter::FNVImageBandWriter()
+{
+    PixelFormat = EPixelFormat::PF_Unknown;
+    ImageSize = FIntPoint::ZeroValue;
+    TileSize = FIntPoint::ZeroValue;
+    GridSize = FIntPoint::ZeroValue;
+    PixelByteSize = 0;
+    ImageBitDepth = 0;
+    ImageRGBFormat = ERGBFormat::Invalid;
+    PNGWriteStruct = nullptr;
+    PNGInfoStruct = nullptr;
+}
+
+FNVImageBandWriter::~FNVImageBandWriter()
+{
+    if (FileHandle.IsValid() && !IsCompleted())
+    {
+        UE_LOG(LogNVSceneCapturer, Warning, TEXT("The tiled image '%s' is incomplete, only %d/%d bands are written."),
+               *FilePath, WrittenBandCount.GetValue(), GridSize.Y);
+    }
+    ReleaseImage();
+}
+
+bool FNVImageBandWriter::Init(const FString& InFilePath, const FNVCaptureTile& Tile, EPixelFormat InPixelFormat)
+{
+#if WITH_UNREALPNG
+    if (!CanPixelFormatBeExported(InPixelFormat) || !GetExportedImageSettings(InPixelFormat, ImageBitDepth, ImageRGBFormat))
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("The pixel format %s can't be exported as a tiled image."), GetPixelFormatString(InPixelFormat));
+        return false;
+    }
+
+    FilePath = InFilePath;
+    PixelFormat = InPixelFormat;
+    ImageSize = Tile.ImageSize;
+    TileSize = Tile.Rect.Size();
+    GridSize = Tile.GridSize;
+
+    // NOTE: The pixels are written as they are read back, the same way FNVImageExporter::CompressImagePNG does
+    const int32 PixelChannels = (ImageRGBFormat == ERGBFormat::Gray) ? 1 : 4;
+    PixelByteSize = (ImageBitDepth * PixelChannels) / 8;
+    return (PixelByteSize > 0) && (ImageSize.X > 0) && (ImageSize.Y > 0);
+#else
+    UE_LOG(LogNVSceneCapturer, Error, TEXT("The tiled images need libpng to be exported."));
+    return false;
+#endif // WITH_UNREALPNG
+}
+
+bool FNVImageBandWriter::AddTile(const FNVTexturePixelData& TilePixelsData, const FNVCaptureTile& Tile)
+{
+    const FIntRect ClippedRect = Tile.GetClippedRect();
+    if ((TilePixelsData.PixelFormat != PixelFormat) || (Tile.GridSize != GridSize) || (ClippedRect.Area() <= 0))
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("The tile %d doesn't belong to the tiled image '%s'."), Tile.TileIndex, *FilePath);
+        return false;
+    }
+
+    const int32 BandIndex = Tile.TileIndex / GridSize.X;
+    const int32 BandTop = BandIndex * TileSize.Y;
+    const int32 BandHeight = FMath::Min(TileSize.Y, ImageSize.Y - BandTop);
+    const int64 BandRowStride = (int64)ImageSize.X * PixelByteSize;
+
+    // NOTE: Only the part of the tile inside the full image is kept
+    const int32 CopyWidth = FMath::Min(ClippedRect.Width(), TilePixelsData.PixelSize.X);
+    const int32 CopyHeight = FMath::Min(ClippedRect.Height(), TilePixelsData.PixelSize.Y);
+    const int64 SourceRowStride = (TilePixelsData.RowStride > 0) ? (int64)TilePixelsData.RowStride : (int64)TilePixelsData.PixelSize.X * PixelByteSize;
+    if ((int64)TilePixelsData.PixelData.Num() < SourceRowStride * CopyHeight)
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("The pixels data of the tile %d of '%s' are too small."), Tile.TileIndex, *FilePath);
+        return false;
+    }
+
+    FScopeLock Lock(&PendingBandsLock);
+    FBand& TileBand = PendingBands.FindOrAdd(BandIndex);
+    if (TileBand.Pixels.Num() == 0)
+    {
+        TileBand.Pixels.SetNumZeroed(BandRowStride * BandHeight);
+    }
+
+    for (int32 Row = 0; Row < CopyHeight; Row++)
+    {
+        const uint8* SourceRow = TilePixelsData.PixelData.GetData() + Row * SourceRowStride;
+        uint8* DestRow = TileBand.Pixels.GetData() + (ClippedRect.Min.Y - BandTop + Row) * BandRowStride + (int64)ClippedRect.Min.X * PixelByteSize;
+        FMemory::Memcpy(DestRow, SourceRow, CopyWidth * PixelByteSize);
+    }
+
+    TileBand.AddedTileCount++;
+    return (TileBand.AddedTileCount >= GridSize.X);
+}
+
+void FNVImageBandWriter::WriteCompletedBands()
+{
+    FScopeLock Lock(&WriteLock);
+    while (!IsCompleted())
+    {
+        FBand CompletedBand;
+        {
+            FScopeLock BandsLock(&PendingBandsLock);
+            const int32 NextBandIndex = WrittenBandCount.GetValue();
+            FBand* NextBand = PendingBands.Find(NextBandIndex);
+            if (!NextBand || (NextBand->AddedTileCount < GridSize.X))
+            {
+                // The bands must be written in order, wait for the next one to be completed
+                break;
+            }
+            CompletedBand = MoveTemp(*NextBand);
+            PendingBands.Remove(NextBandIndex);
+        }
+
+        const bool bIsLastBand = (WrittenBandCount.GetValue() == GridSize.Y - 1);
+        const int32 BandHeight = CompletedBand.Pixels.Num() / FMath::Max<int64>((int64)ImageSize.X * PixelByteSize, 1);
+        const bool bBandWritten = (FileHandle.IsValid() || BeginImage())
+                                  && WriteRows(CompletedBand.Pixels.GetData(), BandHeight)
+                                  && (!bIsLastBand || EndImage());
+        if (!bBandWritten)
+        {
+            UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't write the tiled image '%s'."), *FilePath);
+            ReleaseImage();
+            // Drop the image so the writer isn't waited for
+            FScopeLock BandsLock(&PendingBandsLock);
+            PendingBands.Reset();
+            WrittenBandCount.Set(GridSize.Y);
+            return;
+        }
+
+        WrittenBandCount.Increment();
+    }
+
+    if (IsCompleted())
+    {
+        ReleaseImage();
+    }
+}
+
+bool FNVImageBandWriter::IsCompleted() const
+{
+    return (WrittenBandCount.GetValue() >= GridSize.Y);
+}
+
+bool FNVImageBandWriter::BeginImage()
+{
+#if WITH_UNREALPNG
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+    FileHandle.Reset(PlatformFile.OpenWrite(*FilePath));
+    if (!FileHandle.IsValid())
+    {
+        return false;
+    }
+
+    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info_ptr = png_ptr ? png_create_info_struct(png_ptr) : nullptr;
+    PNGWriteStruct = png_ptr;
+    PNGInfoStruct = info_ptr;
+    if (!png_ptr || !info_ptr)
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("png_create_write_struct() or png_create_info_struct() is failed"));
+        return false;
+    }
+
+    return PngBeginImage(png_ptr, info_ptr, FileHandle.Get(), ImageSize, ImageBitDepth, ImageRGBFormat);
+#else
+    return false;
+#endif // WITH_UNREALPNG
+}
+
+bool FNVImageBandWriter::WriteRows(const uint8* RowsData, int32 RowCount)
+{
+#if WITH_UNREALPNG
+    return PNGWriteStruct && PngWriteRows((png_structp)PNGWriteStruct, RowsData, RowCount, (int64)ImageSize.X * PixelByteSize);
+#else
+    return false;
+#endif // WITH_UNREALPNG
+}
+
+bool FNVImageBandWriter::EndImage()
+{
+#if WITH_UNREALPNG
+    return PNGWriteStruct && PngEndImage((png_structp)PNGWriteStruct, (png_infop)PNGInfoStruct);
+#else
+    return false;
+#endif // WITH_UNREALPNG
+}
+
+void FNVImageBandWriter::ReleaseImage()
+{
+#if WITH_UNREALPNG
+    if (PNGWriteStruct)
+    {
+        png_structp png_ptr = (png_structp)PNGWriteStruct;
+        png_infop info_ptr = (png_infop)PNGInfoStruct;
+        png_destroy_write_struct(&png_ptr, info_ptr ? &info_ptr : nullptr);
+    }
+#endif // WITH_UNREALPNG
+    PNGWriteStruct = nullptr;
+    PNGInfoStruct = nullptr;
+    FileHandle.Reset();
+}
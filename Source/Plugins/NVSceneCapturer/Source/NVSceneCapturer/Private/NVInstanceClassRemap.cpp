@@ -0,0 +1,136 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVInstanceClassRemap.h"
+
+namespace
+{
+    /// Shift (in bits) of the byte at ByteOffset inside a pixel read as an uint32
+    FORCEINLINE uint32 GetByteShift(int32 ByteOffset)
+    {
+#if PLATFORM_LITTLE_ENDIAN
+        return uint32(ByteOffset) * 8;
+#else
+        return uint32(3 - ByteOffset) * 8;
+#endif
+    }
+
+    /// Remap a row of instance mask pixels, 4 pixels at a time
+    /// NOTE: The loop has no branch besides the table bounds check so the compiler can vectorize the id decoding
+    void RemapRow(const uint32* InstancePixels, int32 PixelCount, uint32 RedShift, uint32 GreenShift, uint32 BlueShift,
+                  const FNVInstanceClassLUT& InstanceClassLUT, uint8* OutClassIds)
+    {
+        auto DecodeInstanceId = [RedShift, GreenShift, BlueShift](uint32 Pixel) -> uint32
+        {
+            return (((Pixel >> RedShift) & 0xFF) << 16) | (((Pixel >> GreenShift) & 0xFF) << 8) | ((Pixel >> BlueShift) & 0xFF);
+        };
+
+        int32 X = 0;
+        for (; X + 4 <= PixelCount; X += 4)
+        {
+            const uint32 InstanceId0 = DecodeInstanceId(InstancePixels[X]);
+            const uint32 InstanceId1 = DecodeInstanceId(InstancePixels[X + 1]);
+            const uint32 InstanceId2 = DecodeInstanceId(InstancePixels[X + 2]);
+            const uint32 InstanceId3 = DecodeInstanceId(InstancePixels[X + 3]);
+            OutClassIds[X] = InstanceClassLUT.GetClassId(InstanceId0);
+            OutClassIds[X + 1] = InstanceClassLUT.GetClassId(InstanceId1);
+            OutClassIds[X + 2] = InstanceClassLUT.GetClassId(InstanceId2);
+            OutClassIds[X + 3] = InstanceClassLUT.GetClassId(InstanceId3);
+        }
+        for (; X < PixelCount; ++X)
+        {
+            OutClassIds[X] = InstanceClassLUT.GetClassId(DecodeInstanceId(InstancePixels[X]));
+        }
+    }
+}
+
+//================================== FNVInstanceClassLUT ==================================
+FNVInstanceClassLUT::FNVInstanceClassLUT()
+{
+    IdStep = 1;
+    Version = INDEX_NONE;
+}
+
+void FNVInstanceClassLUT::Build(const TMap<uint32, uint8>& InstanceClassIds, uint32 InIdStep, int32 InVersion)
+{
+    IdStep = FMath::Max(InIdStep, 1u);
+    Version = InVersion;
+    ClassIds.Reset();
+
+    uint32 MaxTableIndex = 0;
+    for (const auto& InstanceClassId : InstanceClassIds)
+    {
+        ensure((InstanceClassId.Key % IdStep) == 0);
+        MaxTableIndex = FMath::Max(MaxTableIndex, InstanceClassId.Key / IdStep);
+    }
+    if (InstanceClassIds.Num() == 0)
+    {
+        return;
+    }
+
+    // NOTE: The unused entries (background, instances without class) map to 0
+    ClassIds.SetNumZeroed(MaxTableIndex + 1);
+    for (const auto& InstanceClassId : InstanceClassIds)
+    {
+        ClassIds[InstanceClassId.Key / IdStep] = InstanceClassId.Value;
+    }
+}
+
+//================================== FNVInstanceClassRemap ==================================
+bool FNVInstanceClassRemap::Remap(const FNVTexturePixelData& InstanceMaskPixelData, const FNVInstanceClassLUT& InstanceClassLUT, FNVTexturePixelData& OutClassMaskPixelData)
+{
+    // Byte offset of each color channel inside a pixel
+    int32 RedOffset = 0;
+    int32 BlueOffset = 0;
+    switch (InstanceMaskPixelData.PixelFormat)
+    {
+        case EPixelFormat::PF_B8G8R8A8:
+            RedOffset = 2;
+            BlueOffset = 0;
+            break;
+        case EPixelFormat::PF_R8G8B8A8:
+            RedOffset = 0;
+            BlueOffset = 2;
+            break;
+        default:
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("Instance mask pixel format %d is not supported."), (int32)InstanceMaskPixelData.PixelFormat);
+            return false;
+    }
+    const int32 GreenOffset = 1;
+
+    const int32 Width = InstanceMaskPixelData.PixelSize.X;
+    const int32 Height = InstanceMaskPixelData.PixelSize.Y;
+    const int32 PixelByteSize = 4;
+    const int32 RowStride = (InstanceMaskPixelData.RowStride > 0) ? InstanceMaskPixelData.RowStride : (Width * PixelByteSize);
+    const int64 RequiredBufferSize = (Height > 0) ? (int64(RowStride) * (Height - 1) + int64(Width) * PixelByteSize) : 0;
+    if ((Width <= 0) || (Height <= 0) || (InstanceMaskPixelData.PixelData.Num() < RequiredBufferSize))
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("invalid argument."));
+        return false;
+    }
+
+    OutClassMaskPixelData.PixelFormat = EPixelFormat::PF_G8;
+    OutClassMaskPixelData.PixelSize = InstanceMaskPixelData.PixelSize;
+    OutClassMaskPixelData.RowStride = Width;
+    OutClassMaskPixelData.PixelData.SetNumUninitialized(Width * Height);
+
+    const uint32 RedShift = GetByteShift(RedOffset);
+    const uint32 GreenShift = GetByteShift(GreenOffset);
+    const uint32 BlueShift = GetByteShift(BlueOffset);
+
+    const uint8* InstanceRowPtr = InstanceMaskPixelData.PixelData.GetData();
+    uint8* ClassRowPtr = OutClassMaskPixelData.PixelData.GetData();
+    for (int32 Y = 0; Y < Height; ++Y)
+    {
+        RemapRow(reinterpret_cast<const uint32*>(InstanceRowPtr), Width, RedShift, GreenShift, BlueShift, InstanceClassLUT, ClassRowPtr);
+
+        InstanceRowPtr += RowStride;
+        ClassRowPtr += Width;
+    }
+
+    return true;
+}
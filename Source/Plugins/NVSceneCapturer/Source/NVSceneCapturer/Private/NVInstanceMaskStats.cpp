@@ -0,0 +1,351 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVInstanceMaskStats.h"
+#include "NVCaptureRegion.h"
+#include "Json.h"
+#include "Async/Async.h"
+
+//================================== FNVInstanceMaskObjectStats ==================================
+FBox2D FNVInstanceMaskObjectStats::GetBox2D() const
+{
+    if (PixelCount == 0)
+    {
+        return FBox2D(EForceInit::ForceInitToZero);
+    }
+
+    return FBox2D(FVector2D(Min.X, Min.Y), FVector2D(Max.X + 1, Max.Y + 1));
+}
+
+//================================== FNVInstanceMaskStats ==================================
+FNVInstanceMaskStats::FNVInstanceMaskStats()
+{
+    Reset();
+}
+
+void FNVInstanceMaskStats::Reset()
+{
+    ImageSize = FIntPoint::ZeroValue;
+    ObjectStats.Reset();
+}
+
+bool FNVInstanceMaskStats::Scan(const FNVTexturePixelData& MaskPixelData)
+{
+    Reset();
+
+    // Byte offset of each color channel inside a pixel
+    int32 RedOffset = 0;
+    int32 BlueOffset = 0;
+    switch (MaskPixelData.PixelFormat)
+    {
+        case EPixelFormat::PF_B8G8R8A8:
+            RedOffset = 2;
+            BlueOffset = 0;
+            break;
+        case EPixelFormat::PF_R8G8B8A8:
+            RedOffset = 0;
+            BlueOffset = 2;
+            break;
+        default:
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("Instance mask pixel format %d is not supported."), (int32)MaskPixelData.PixelFormat);
+            return false;
+    }
+    const int32 GreenOffset = 1;
+
+    const int32 Width = MaskPixelData.PixelSize.X;
+    const int32 Height = MaskPixelData.PixelSize.Y;
+    const int32 PixelByteSize = 4;
+    const int32 RowStride = (MaskPixelData.RowStride > 0) ? MaskPixelData.RowStride : (Width * PixelByteSize);
+    const int64 RequiredBufferSize = (Height > 0) ? (int64(RowStride) * (Height - 1) + int64(Width) * PixelByteSize) : 0;
+    if ((Width <= 0) || (Height <= 0) || (MaskPixelData.PixelData.Num() < RequiredBufferSize))
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("invalid argument."));
+        return false;
+    }
+
+    ImageSize = MaskPixelData.PixelSize;
+
+    // NOTE: The vertex color render mode doesn't write the alpha channel so we only compare the color bytes
+#if PLATFORM_LITTLE_ENDIAN
+    const uint32 ColorMask = 0x00FFFFFF;
+#else
+    const uint32 ColorMask = 0xFFFFFF00;
+#endif
+
+    auto DecodeInstanceId = [RedOffset, GreenOffset, BlueOffset](const uint8* Pixel) -> uint32
+    {
+        return (uint32(Pixel[RedOffset]) << 16) | (uint32(Pixel[GreenOffset]) << 8) | uint32(Pixel[BlueOffset]);
+    };
+
+    const uint8* RowPtr = MaskPixelData.PixelData.GetData();
+    for (int32 Y = 0; Y < Height; ++Y)
+    {
+        // Walk the row as runs of pixels which have the same color so we only need to update the map once per run
+        const uint32* RowPixels = reinterpret_cast<const uint32*>(RowPtr);
+        uint32 RunColor = RowPixels[0] & ColorMask;
+        int32 RunStart = 0;
+        for (int32 X = 1; X <= Width; ++X)
+        {
+            const uint32 PixelColor = (X < Width) ? (RowPixels[X] & ColorMask) : ~RunColor;
+            if (PixelColor != RunColor)
+            {
+                const uint32 InstanceId = DecodeInstanceId(reinterpret_cast<const uint8*>(&RowPixels[RunStart]));
+                if (InstanceId != 0)
+                {
+                    ObjectStats.FindOrAdd(InstanceId).AddRun(RunStart, Y, X - RunStart);
+                }
+
+                RunColor = PixelColor;
+                RunStart = X;
+            }
+        }
+
+        RowPtr += RowStride;
+    }
+
+    return true;
+}
+
+void FNVInstanceMaskStats::ApplyToAnnotationData(const TSharedPtr<FJsonObject>& AnnotationData, bool bExportImageCoordinateInPixel, bool bOverrideBoundingBox,
+                                                 const TSet<uint32>* SkippedInstanceIds /*= nullptr*/) const
+{
+    const TArray<TSharedPtr<FJsonValue>>* ObjectJsonArray = nullptr;
+    if (!AnnotationData.IsValid() || !AnnotationData->TryGetArrayField(TEXT("objects"), ObjectJsonArray) || !ObjectJsonArray)
+    {
+        return;
+    }
+
+    // The mask of a cropped capture only cover the crop, its boxes are moved back to the full image's coordinates
+    FIntRect CropRegion;
+    FIntPoint FullImageSize = ImageSize;
+    FVector2D ImageOffset = FVector2D::ZeroVector;
+    if (FNVCaptureRegion::ReadCropFromAnnotationData(AnnotationData, CropRegion, FullImageSize))
+    {
+        ImageOffset = FVector2D(CropRegion.Min);
+    }
+    else
+    {
+        FullImageSize = ImageSize;
+    }
+
+    const FVector2D ImageScale = (bExportImageCoordinateInPixel || (FullImageSize.X <= 0) || (FullImageSize.Y <= 0)) ?
+                                 FVector2D(1.f, 1.f) : FVector2D(1.f / FullImageSize.X, 1.f / FullImageSize.Y);
+
+    for (const TSharedPtr<FJsonValue>& ObjectJsonValue : *ObjectJsonArray)
+    {
+        const TSharedPtr<FJsonObject> ObjectJsonObj = ObjectJsonValue.IsValid() ? ObjectJsonValue->AsObject() : nullptr;
+        uint32 InstanceId = 0;
+        if (!ObjectJsonObj.IsValid() || !ObjectJsonObj->TryGetNumberField(TEXT("instance_id"), InstanceId))
+        {
+            continue;
+        }
+        // NOTE: The objects skipped keep the bounding box projected from their vertexes
+        if (SkippedInstanceIds && SkippedInstanceIds->Contains(InstanceId))
+        {
+            continue;
+        }
+
+        FBox2D VisibleBox(EForceInit::ForceInitToZero);
+        uint32 VisiblePixelCount = 0;
+        const FNVInstanceMaskObjectStats* InstanceStats = (InstanceId != 0) ? Find(InstanceId) : nullptr;
+        if (InstanceStats)
+        {
+            VisibleBox = InstanceStats->GetBox2D();
+            VisibleBox.Min = (VisibleBox.Min + ImageOffset) * ImageScale;
+            VisibleBox.Max = (VisibleBox.Max + ImageOffset) * ImageScale;
+            VisiblePixelCount = InstanceStats->PixelCount;
+        }
+
+        const TSharedPtr<FJsonObject> VisibleBoxJsonObj = NVSceneCapturerUtils::UStructToJsonObject(FNVBox2D(VisibleBox));
+        ObjectJsonObj->SetObjectField(TEXT("visible_bbox"), VisibleBoxJsonObj);
+        ObjectJsonObj->SetNumberField(TEXT("visible_pixel_count"), VisiblePixelCount);
+        // NOTE: The annotation schema can omit the bounding box, it's only replaced when it's exported
+        if (bOverrideBoundingBox && ObjectJsonObj->HasField(TEXT("bounding_box")))
+        {
+            ObjectJsonObj->SetObjectField(TEXT("bounding_box"), VisibleBoxJsonObj);
+        }
+    }
+}
+
+//================================== FNVInstanceMaskAnnotationMerger ==================================
+FNVInstanceMaskAnnotationMerger::FNVInstanceMaskAnnotationMerger(TSharedPtr<INVFileSink, ESPMode::ThreadSafe> InFileSink /*= nullptr*/)
+    : FileSink(InFileSink)
+{
+    ScanningMaskCounter.Reset();
+    ScanFinishedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+FNVInstanceMaskAnnotationMerger::~FNVInstanceMaskAnnotationMerger()
+{
+    // NOTE: The scan tasks keep the merger alive, none of them can be running here
+    FPlatformProcess::ReturnSynchEventToPool(ScanFinishedEvent);
+    ScanFinishedEvent = nullptr;
+}
+
+void FNVInstanceMaskAnnotationMerger::AddAnnotationData(const FFrameKey& FrameKey, const TSharedPtr<FJsonObject>& AnnotationData, const FString& ExportFilePath, bool bExportImageCoordinateInPixel,
+                                                        FExportAnnotationDataFunction ExportFunction /*= nullptr*/,
+                                                        TSharedPtr<const TSet<uint32>, ESPMode::ThreadSafe> SkippedInstanceIds /*= nullptr*/)
+{
+    FPendingAnnotationData NewPendingData;
+    NewPendingData.AnnotationData = AnnotationData;
+    NewPendingData.ExportFilePath = ExportFilePath;
+    NewPendingData.bExportImageCoordinateInPixel = bExportImageCoordinateInPixel;
+    NewPendingData.ExportFunction = MoveTemp(ExportFunction);
+    NewPendingData.SkippedInstanceIds = MoveTemp(SkippedInstanceIds);
+
+    TSharedPtr<FNVInstanceMaskStats, ESPMode::ThreadSafe> ScannedMaskStats;
+    bool bMaskSkipped = false;
+    {
+        FScopeLock ScopeLock(&PendingFrameDataLock);
+        FPendingFrameData& PendingFrameData = PendingFrameDataMap.FindOrAdd(FrameKey);
+        bMaskSkipped = PendingFrameData.bMaskSkipped;
+        if (PendingFrameData.MaskStats.IsValid())
+        {
+            // The mask of this frame is already scanned, don't need to wait
+            ScannedMaskStats = PendingFrameData.MaskStats;
+            PendingFrameDataMap.Remove(FrameKey);
+        }
+        else if (!bMaskSkipped)
+        {
+            PendingFrameData.AnnotationDataList.Add(NewPendingData);
+        }
+    }
+
+    if (ScannedMaskStats.IsValid() || bMaskSkipped)
+    {
+        ExportAnnotationData(NewPendingData, ScannedMaskStats.Get());
+    }
+}
+
+void FNVInstanceMaskAnnotationMerger::SkipInstanceMask(const FFrameKey& FrameKey)
+{
+    // Number of frames the skipped mask of a frame is remembered, the annotation data of a frame may come a few frames late
+    static const int32 KeepSkippedMaskFrameCount = 16;
+
+    TArray<FPendingAnnotationData> ReadyAnnotationDataList;
+    {
+        FScopeLock ScopeLock(&PendingFrameDataLock);
+        FPendingFrameData& PendingFrameData = PendingFrameDataMap.FindOrAdd(FrameKey);
+        PendingFrameData.bMaskSkipped = true;
+        ReadyAnnotationDataList = MoveTemp(PendingFrameData.AnnotationDataList);
+
+        // Forget the old frames whose mask are skipped
+        for (auto It = PendingFrameDataMap.CreateIterator(); It; ++It)
+        {
+            const FFrameKey& CheckFrameKey = It.Key();
+            if (It.Value().bMaskSkipped && (CheckFrameKey.Key == FrameKey.Key) && (CheckFrameKey.Value < FrameKey.Value - KeepSkippedMaskFrameCount))
+            {
+                It.RemoveCurrent();
+            }
+        }
+    }
+
+    for (const FPendingAnnotationData& ReadyAnnotationData : ReadyAnnotationDataList)
+    {
+        ExportAnnotationData(ReadyAnnotationData, nullptr);
+    }
+}
+
+void FNVInstanceMaskAnnotationMerger::AddInstanceMask(const FFrameKey& FrameKey, const FNVTexturePixelData& MaskPixelData)
+{
+    ScanningMaskCounter.Increment();
+
+    TSharedRef<FNVInstanceMaskAnnotationMerger, ESPMode::ThreadSafe> ThisMerger = AsShared();
+    Async(EAsyncExecution::ThreadPool, [ThisMerger, FrameKey, MaskPixelData]()
+    {
+        TSharedPtr<FNVInstanceMaskStats, ESPMode::ThreadSafe> MaskStats = MakeShared<FNVInstanceMaskStats, ESPMode::ThreadSafe>();
+        MaskStats->Scan(MaskPixelData);
+
+        TArray<FPendingAnnotationData> ReadyAnnotationDataList;
+        {
+            FScopeLock ScopeLock(&ThisMerger->PendingFrameDataLock);
+            FPendingFrameData& PendingFrameData = ThisMerger->PendingFrameDataMap.FindOrAdd(FrameKey);
+            if (PendingFrameData.AnnotationDataList.Num() > 0)
+            {
+                ReadyAnnotationDataList = MoveTemp(PendingFrameData.AnnotationDataList);
+                ThisMerger->PendingFrameDataMap.Remove(FrameKey);
+            }
+            else
+            {
+                // Keep the result until the annotation data of this frame come
+                PendingFrameData.MaskStats = MaskStats;
+            }
+        }
+
+        for (const FPendingAnnotationData& ReadyAnnotationData : ReadyAnnotationDataList)
+        {
+            ThisMerger->ExportAnnotationData(ReadyAnnotationData, MaskStats.Get());
+        }
+
+        if (ThisMerger->ScanningMaskCounter.Decrement() == 0)
+        {
+            ThisMerger->ScanFinishedEvent->Trigger();
+        }
+    });
+}
+
+bool FNVInstanceMaskAnnotationMerger::IsHandlingData() const
+{
+    if (ScanningMaskCounter.GetValue() > 0)
+    {
+        return true;
+    }
+
+    FScopeLock ScopeLock(&PendingFrameDataLock);
+    for (const auto& CheckPendingFrameData : PendingFrameDataMap)
+    {
+        if (CheckPendingFrameData.Value.AnnotationDataList.Num() > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FNVInstanceMaskAnnotationMerger::Flush()
+{
+    // The masks being scanned export their annotation data with the visible bounding boxes, wait for them first
+    // NOTE: The wait time out regularly so a trigger which happen before the wait start isn't missed
+    while (ScanningMaskCounter.GetValue() > 0)
+    {
+        ScanFinishedEvent->Wait(10);
+    }
+
+    TArray<FPendingAnnotationData> RemainAnnotationDataList;
+    {
+        FScopeLock ScopeLock(&PendingFrameDataLock);
+        for (auto& CheckPendingFrameData : PendingFrameDataMap)
+        {
+            RemainAnnotationDataList.Append(CheckPendingFrameData.Value.AnnotationDataList);
+        }
+        PendingFrameDataMap.Reset();
+    }
+
+    if (RemainAnnotationDataList.Num() > 0)
+    {
+        UE_LOG(LogNVSceneCapturer, Warning, TEXT("%d annotation files are exported without the visible bounding box since their instance masks never came."),
+               RemainAnnotationDataList.Num());
+    }
+    for (const FPendingAnnotationData& RemainAnnotationData : RemainAnnotationDataList)
+    {
+        ExportAnnotationData(RemainAnnotationData, nullptr);
+    }
+}
+
+void FNVInstanceMaskAnnotationMerger::ExportAnnotationData(const FPendingAnnotationData& PendingData, const FNVInstanceMaskStats* MaskStats) const
+{
+    if (MaskStats)
+    {
+        MaskStats->ApplyToAnnotationData(PendingData.AnnotationData, PendingData.bExportImageCoordinateInPixel, true, PendingData.SkippedInstanceIds.Get());
+    }
+    if (PendingData.ExportFunction)
+    {
+        PendingData.ExportFunction(PendingData.AnnotationData);
+        return;
+    }
+    NVSceneCapturerUtils::SaveJsonObjectToFile(PendingData.AnnotationData, PendingData.ExportFilePath, FileSink.Get());
+}
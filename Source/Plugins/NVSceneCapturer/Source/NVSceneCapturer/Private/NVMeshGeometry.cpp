@@ -0,0 +1,532 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVMeshGeometry.h"
+#include "Engine/StaticMesh.h"
+#include "StaticMeshResources.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+
+namespace
+{
+    /// Number of directions the hull of the meshes is decimated with
+    const int32 MeshHullDirectionCount = 64;
+
+    /// Version of the way the geometry is computed, part of the signature so the geometry baked by an older version is stale
+    const uint32 MeshGeometryVersion = 2;
+
+    void GetMeshRenderVertexes(const UStaticMesh* StaticMesh, TArray<FVector>& OutVertexes)
+    {
+        const FStaticMeshRenderData* RenderData = StaticMesh ? StaticMesh->GetRenderData() : nullptr;
+        if (!RenderData || (RenderData->LODResources.Num() == 0))
+        {
+            return;
+        }
+
+        const FPositionVertexBuffer& MeshVertexBuffer = RenderData->LODResources[0].VertexBuffers.PositionVertexBuffer;
+        const uint32 VertexCount = MeshVertexBuffer.GetNumVertices();
+        OutVertexes.Reserve(OutVertexes.Num() + VertexCount);
+        for (uint32 i = 0; i < VertexCount; i++)
+        {
+            OutVertexes.Add(FVector(MeshVertexBuffer.VertexPosition(i)));
+        }
+    }
+
+    void GetMeshCollisionVertexes(const UStaticMesh* StaticMesh, TArray<FVector>& OutVertexes)
+    {
+        const UBodySetup* BodySetup = StaticMesh ? StaticMesh->GetBodySetup() : nullptr;
+        if (BodySetup)
+        {
+            for (const FKConvexElem& ConvexElem : BodySetup->AggGeom.ConvexElems)
+            {
+                OutVertexes.Append(ConvexElem.VertexData);
+            }
+        }
+    }
+
+    /// Directions the spheres of the physics bodies are sampled along: the faces, edges and corners of a cube
+    const TArray<FVector>& GetSphereSampleDirections()
+    {
+        static TArray<FVector> SampleDirections;
+        if (SampleDirections.Num() == 0)
+        {
+            for (int32 X = -1; X <= 1; X++)
+            {
+                for (int32 Y = -1; Y <= 1; Y++)
+                {
+                    for (int32 Z = -1; Z <= 1; Z++)
+                    {
+                        if ((X != 0) || (Y != 0) || (Z != 0))
+                        {
+                            SampleDirections.Add(FVector(X, Y, Z).GetSafeNormal());
+                        }
+                    }
+                }
+            }
+        }
+        return SampleDirections;
+    }
+
+    void AddSphereVertexes(const FTransform& ElemTransform, const FVector& LocalCenter, float Radius, TArray<FVector3f>& OutVertexes)
+    {
+        for (const FVector& SampleDirection : GetSphereSampleDirections())
+        {
+            OutVertexes.Add(FVector3f(ElemTransform.TransformPosition(LocalCenter + SampleDirection * Radius)));
+        }
+    }
+
+    void AddCapsuleVertexes(const FTransform& ElemTransform, float Radius, float Length, TArray<FVector3f>& OutVertexes)
+    {
+        // NOTE: The capsule is along the Z axis of its element, the hull of the 2 end spheres is the capsule
+        const FVector HalfSegment(0.f, 0.f, Length * 0.5f);
+        AddSphereVertexes(ElemTransform, HalfSegment, Radius, OutVertexes);
+        AddSphereVertexes(ElemTransform, -HalfSegment, Radius, OutVertexes);
+    }
+}
+
+//================================== FNVMeshGeometryData ==================================
+FNVMeshGeometryData::FNVMeshGeometryData()
+{
+    SourceSignature = 0;
+    VertexCount = 0;
+    RenderBounds = FBox(EForceInit::ForceInitToZero);
+    CollisionBounds = FBox(EForceInit::ForceInitToZero);
+    PCACenter = FVector::ZeroVector;
+    PCAAxisX = FVector::ForwardVector;
+    PCAAxisY = FVector::RightVector;
+    PCAAxisZ = FVector::UpVector;
+    PCABounds = FBox(EForceInit::ForceInitToZero);
+}
+
+//================================== FNVMeshGeometryMath ==================================
+FMatrix FNVMeshGeometryMath::CalculatePCA(const TArray<FVector>& Vertexes)
+{
+    FMatrix TransformMatrix = FMatrix::Identity;
+
+    const int32 VertexCount = Vertexes.Num();
+    if (VertexCount == 0)
+    {
+        return TransformMatrix;
+    }
+
+    // Compute mean vertex
+    FVector MeanVertex = FVector::ZeroVector;
+    for (const FVector& V : Vertexes)
+    {
+        MeanVertex += V;
+    }
+    MeanVertex /= VertexCount;
+
+    // Compute covariance matrix
+    FMatrix Covariance = FMatrix::Identity;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            double Cij = 0.0;
+            for (const FVector& V : Vertexes)
+            {
+                Cij += (V[i] - MeanVertex[i]) * (V[j] - MeanVertex[j]);
+            }
+            Cij /= VertexCount;
+            Covariance.M[i][j] = static_cast<float>(Cij);
+        }
+    }
+
+    // Eigen decomposition (dominant eigenvector via power method)
+    const FVector ZAxis = ComputeDominantEigenVector(Covariance);
+    FVector XAxis, YAxis;
+    ZAxis.FindBestAxisVectors(YAxis, XAxis);
+    // NOTE: Keep the frame right handed so it can be converted to a transform
+    if (((XAxis ^ YAxis) | ZAxis) < 0.f)
+    {
+        XAxis = -XAxis;
+    }
+
+    TransformMatrix = FMatrix(XAxis, YAxis, ZAxis, MeanVertex);
+    return TransformMatrix;
+}
+
+FVector FNVMeshGeometryMath::ComputeDominantEigenVector(const FMatrix& Mat)
+{
+    // NOTES: Copied from function ComputeEigenVector in PhysicsASsetUtils.cpp
+    //using the power method: this is ok because we only need the dominate eigenvector and speed is not critical:
+    // http://en.wikipedia.org/wiki/Power_iteration
+    // NOTE: The power method never reach an eigen vector orthogonal to the vector it start from
+    // (e.g: a mesh elongated along its X axis when starting from Z), so it start from each axis and keep the most stretched result
+    FVector DominantVector = FVector(0, 0, 1.f);
+    double MaxStretch = -1.0;
+    for (const FVector& StartVector : { FVector::UpVector, FVector::ForwardVector, FVector::RightVector })
+    {
+        FVector EVector = StartVector;
+        for (int32 i = 0; i < 32; ++i)
+        {
+            float Length = EVector.Size();
+            if (Length > 0.f)
+            {
+                EVector = Mat.TransformVector(EVector) / Length;
+            }
+        }
+
+        EVector = EVector.GetSafeNormal();
+        const double Stretch = EVector | Mat.TransformVector(EVector);
+        // NOTE: The first axis is kept when the stretches are the same so the symmetric meshes keep their Z axis
+        if (!EVector.IsZero() && (Stretch > MaxStretch + KINDA_SMALL_NUMBER * FMath::Abs(MaxStretch)))
+        {
+            DominantVector = EVector;
+            MaxStretch = Stretch;
+        }
+    }
+
+    return DominantVector;
+}
+
+FBox FNVMeshGeometryMath::CalculateBoundsInFrame(const TArray<FVector>& Vertexes, const FMatrix& Frame)
+{
+    const FVector Origin = Frame.GetOrigin();
+    const FVector AxisX = Frame.GetUnitAxis(EAxis::X);
+    const FVector AxisY = Frame.GetUnitAxis(EAxis::Y);
+    const FVector AxisZ = Frame.GetUnitAxis(EAxis::Z);
+
+    FBox FrameBounds(EForceInit::ForceInitToZero);
+    for (const FVector& V : Vertexes)
+    {
+        // NOTE: The axes are orthonormal so the inverse transform is just the projection on them
+        const FVector Offset = V - Origin;
+        FrameBounds += FVector(Offset | AxisX, Offset | AxisY, Offset | AxisZ);
+    }
+    return FrameBounds;
+}
+
+void FNVMeshGeometryMath::CalculateHullVertexes(const TArray<FVector>& Vertexes, int32 DirectionCount, TArray<FVector>& OutHullVertexes)
+{
+    OutHullVertexes.Reset();
+    if ((Vertexes.Num() == 0) || (DirectionCount <= 0))
+    {
+        return;
+    }
+
+    const double GoldenAngle = PI * (3.0 - FMath::Sqrt(5.0));
+    TArray<int32> HullVertexIndexes;
+    HullVertexIndexes.Reserve(DirectionCount);
+    for (int32 DirectionIndex = 0; DirectionIndex < DirectionCount; DirectionIndex++)
+    {
+        // Spread the directions evenly on the unit sphere
+        const double Y = 1.0 - (2.0 * (DirectionIndex + 0.5) / DirectionCount);
+        const double Radius = FMath::Sqrt(FMath::Max(0.0, 1.0 - Y * Y));
+        const double Phi = GoldenAngle * DirectionIndex;
+        const FVector Direction(FMath::Cos(Phi) * Radius, Y, FMath::Sin(Phi) * Radius);
+
+        int32 SupportVertexIndex = 0;
+        double MaxDistance = Vertexes[0] | Direction;
+        for (int32 VertexIndex = 1; VertexIndex < Vertexes.Num(); VertexIndex++)
+        {
+            const double Distance = Vertexes[VertexIndex] | Direction;
+            if (Distance > MaxDistance)
+            {
+                MaxDistance = Distance;
+                SupportVertexIndex = VertexIndex;
+            }
+        }
+        HullVertexIndexes.AddUnique(SupportVertexIndex);
+    }
+
+    // NOTE: Sort the vertexes so the hull doesn't depend on the order of the directions
+    HullVertexIndexes.Sort();
+    OutHullVertexes.Reserve(HullVertexIndexes.Num());
+    for (const int32 VertexIndex : HullVertexIndexes)
+    {
+        OutHullVertexes.Add(Vertexes[VertexIndex]);
+    }
+}
+
+void FNVMeshGeometryMath::BuildMeshGeometry(const TArray<FVector>& RenderVertexes, const TArray<FVector>& CollisionVertexes, FNVMeshGeometryData& OutGeometryData)
+{
+    OutGeometryData.VertexCount = RenderVertexes.Num();
+    OutGeometryData.RenderBounds = FBox(RenderVertexes);
+    OutGeometryData.CollisionBounds = FBox(CollisionVertexes);
+
+    const TArray<FVector>& ShapeVertexes = (RenderVertexes.Num() > 0) ? RenderVertexes : CollisionVertexes;
+    const FMatrix PCAMatrix = CalculatePCA(ShapeVertexes);
+    OutGeometryData.PCACenter = PCAMatrix.GetOrigin();
+    OutGeometryData.PCAAxisX = PCAMatrix.GetUnitAxis(EAxis::X);
+    OutGeometryData.PCAAxisY = PCAMatrix.GetUnitAxis(EAxis::Y);
+    OutGeometryData.PCAAxisZ = PCAMatrix.GetUnitAxis(EAxis::Z);
+    OutGeometryData.PCABounds = CalculateBoundsInFrame(ShapeVertexes, PCAMatrix);
+
+    CalculateHullVertexes(ShapeVertexes, MeshHullDirectionCount, OutGeometryData.HullVertexes);
+}
+
+//================================== FNVMeshGeometryCache ==================================
+TMap<FObjectKey, TUniquePtr<FNVMeshGeometryData>> FNVMeshGeometryCache::RuntimeGeometries;
+
+const FNVMeshGeometryData* FNVMeshGeometryCache::FindOrBuild(const UStaticMesh* StaticMesh)
+{
+    ensure(IsInGameThread());
+    if (!StaticMesh)
+    {
+        return nullptr;
+    }
+
+    const uint32 SourceSignature = CalculateSourceSignature(StaticMesh);
+
+    // Use the baked geometry if it's still up to date
+    const UNVMeshGeometryUserData* GeometryUserData = const_cast<UStaticMesh*>(StaticMesh)->GetAssetUserData<UNVMeshGeometryUserData>();
+    if (GeometryUserData && (GeometryUserData->GeometryData.SourceSignature == SourceSignature))
+    {
+        return GeometryUserData->GeometryData.IsValid() ? &GeometryUserData->GeometryData : nullptr;
+    }
+
+    TUniquePtr<FNVMeshGeometryData>& CachedGeometry = RuntimeGeometries.FindOrAdd(FObjectKey(StaticMesh));
+    if (!CachedGeometry.IsValid() || (CachedGeometry->SourceSignature != SourceSignature))
+    {
+        if (GeometryUserData)
+        {
+            UE_LOG(LogNVSceneCapturer, Verbose, TEXT("The baked geometry of mesh '%s' is stale, computing it at runtime."), *StaticMesh->GetName());
+        }
+
+        CachedGeometry = MakeUnique<FNVMeshGeometryData>();
+        BuildMeshGeometry(StaticMesh, *CachedGeometry);
+    }
+    return CachedGeometry->IsValid() ? CachedGeometry.Get() : nullptr;
+}
+
+bool FNVMeshGeometryCache::BuildMeshGeometry(const UStaticMesh* StaticMesh, FNVMeshGeometryData& OutGeometryData)
+{
+    if (!StaticMesh)
+    {
+        return false;
+    }
+
+    TArray<FVector> RenderVertexes;
+    GetMeshRenderVertexes(StaticMesh, RenderVertexes);
+    TArray<FVector> CollisionVertexes;
+    GetMeshCollisionVertexes(StaticMesh, CollisionVertexes);
+
+    FNVMeshGeometryMath::BuildMeshGeometry(RenderVertexes, CollisionVertexes, OutGeometryData);
+    OutGeometryData.SourceSignature = CalculateSourceSignature(StaticMesh);
+    return OutGeometryData.IsValid();
+}
+
+bool FNVMeshGeometryCache::BakeMeshGeometry(UStaticMesh* StaticMesh, bool bForce /*= false*/)
+{
+    if (!StaticMesh)
+    {
+        return false;
+    }
+
+    UNVMeshGeometryUserData* GeometryUserData = StaticMesh->GetAssetUserData<UNVMeshGeometryUserData>();
+    if (!bForce && GeometryUserData && (GeometryUserData->GeometryData.SourceSignature == CalculateSourceSignature(StaticMesh)))
+    {
+        return false;
+    }
+
+    FNVMeshGeometryData NewGeometryData;
+    BuildMeshGeometry(StaticMesh, NewGeometryData);
+
+    StaticMesh->Modify();
+    if (!GeometryUserData)
+    {
+        GeometryUserData = NewObject<UNVMeshGeometryUserData>(StaticMesh, NAME_None, RF_Public | RF_Transactional);
+        StaticMesh->AddAssetUserData(GeometryUserData);
+    }
+    GeometryUserData->GeometryData = NewGeometryData;
+    RuntimeGeometries.Remove(FObjectKey(StaticMesh));
+    return true;
+}
+
+uint32 FNVMeshGeometryCache::CalculateSourceSignature(const UStaticMesh* StaticMesh)
+{
+    uint32 Signature = 0;
+    if (!StaticMesh)
+    {
+        return Signature;
+    }
+
+    Signature = HashCombine(Signature, GetTypeHash(MeshGeometryVersion));
+
+    const FStaticMeshRenderData* RenderData = StaticMesh->GetRenderData();
+    if (RenderData && (RenderData->LODResources.Num() > 0))
+    {
+        Signature = HashCombine(Signature, GetTypeHash(RenderData->LODResources[0].VertexBuffers.PositionVertexBuffer.GetNumVertices()));
+        Signature = HashCombine(Signature, GetTypeHash(RenderData->Bounds.Origin));
+        Signature = HashCombine(Signature, GetTypeHash(RenderData->Bounds.BoxExtent));
+    }
+
+    const UBodySetup* BodySetup = StaticMesh->GetBodySetup();
+    if (BodySetup)
+    {
+        Signature = HashCombine(Signature, GetTypeHash(BodySetup->AggGeom.ConvexElems.Num()));
+        for (const FKConvexElem& ConvexElem : BodySetup->AggGeom.ConvexElems)
+        {
+            Signature = HashCombine(Signature, GetTypeHash(ConvexElem.VertexData.Num()));
+            Signature = HashCombine(Signature, GetTypeHash(ConvexElem.ElemBox.Min));
+            Signature = HashCombine(Signature, GetTypeHash(ConvexElem.ElemBox.Max));
+        }
+    }
+    return Signature;
+}
+
+void FNVMeshGeometryCache::Reset()
+{
+    ensure(IsInGameThread());
+    RuntimeGeometries.Reset();
+}
+
+//================================== FNVSkeletalBodyHullCache ==================================
+TMap<FObjectKey, FNVSkeletalBodyHullsPtr> FNVSkeletalBodyHullCache::RuntimeHulls;
+
+FNVSkeletalBodyHullsPtr FNVSkeletalBodyHullCache::FindOrBuild(const UPhysicsAsset* PhysicsAsset)
+{
+    ensure(IsInGameThread());
+    if (!PhysicsAsset)
+    {
+        return nullptr;
+    }
+
+    const uint32 SourceSignature = CalculateSourceSignature(PhysicsAsset);
+    FNVSkeletalBodyHullsPtr& CachedHulls = RuntimeHulls.FindOrAdd(FObjectKey(PhysicsAsset));
+    if (!CachedHulls.IsValid() || (CachedHulls->SourceSignature != SourceSignature))
+    {
+        // NOTE: Build a new object instead of updating the cached one, the previous frames may still read it
+        TSharedPtr<FNVSkeletalBodyHulls, ESPMode::ThreadSafe> NewHulls = MakeShared<FNVSkeletalBodyHulls, ESPMode::ThreadSafe>();
+        BuildBodyHulls(PhysicsAsset, *NewHulls);
+        NewHulls->SourceSignature = SourceSignature;
+        CachedHulls = NewHulls;
+    }
+    return (CachedHulls->Bodies.Num() > 0) ? CachedHulls : nullptr;
+}
+
+void FNVSkeletalBodyHullCache::BuildBodyHulls(const UPhysicsAsset* PhysicsAsset, FNVSkeletalBodyHulls& OutBodyHulls)
+{
+    OutBodyHulls.Bodies.Reset();
+    if (!PhysicsAsset)
+    {
+        return;
+    }
+
+    for (const USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+    {
+        if (!BodySetup)
+        {
+            continue;
+        }
+
+        FNVSkeletalBodyHull BodyHull;
+        BodyHull.BoneName = BodySetup->BoneName;
+
+        const FKAggregateGeom& BodyGeom = BodySetup->AggGeom;
+        for (const FKSphereElem& SphereElem : BodyGeom.SphereElems)
+        {
+            AddSphereVertexes(SphereElem.GetTransform(), FVector::ZeroVector, SphereElem.Radius, BodyHull.Vertexes);
+        }
+        for (const FKBoxElem& BoxElem : BodyGeom.BoxElems)
+        {
+            const FTransform ElemTransform = BoxElem.GetTransform();
+            const FVector HalfExtent(BoxElem.X * 0.5f, BoxElem.Y * 0.5f, BoxElem.Z * 0.5f);
+            for (int32 CornerIndex = 0; CornerIndex < 8; CornerIndex++)
+            {
+                const FVector CornerSign((CornerIndex & 1) ? 1.f : -1.f, (CornerIndex & 2) ? 1.f : -1.f, (CornerIndex & 4) ? 1.f : -1.f);
+                BodyHull.Vertexes.Add(FVector3f(ElemTransform.TransformPosition(HalfExtent * CornerSign)));
+            }
+        }
+        for (const FKSphylElem& SphylElem : BodyGeom.SphylElems)
+        {
+            AddCapsuleVertexes(SphylElem.GetTransform(), SphylElem.Radius, SphylElem.Length, BodyHull.Vertexes);
+        }
+        for (const FKTaperedCapsuleElem& TaperedCapsuleElem : BodyGeom.TaperedCapsuleElems)
+        {
+            // NOTE: Approximated by a capsule of the biggest radius so the body is still covered
+            AddCapsuleVertexes(TaperedCapsuleElem.GetTransform(), FMath::Max(TaperedCapsuleElem.Radius0, TaperedCapsuleElem.Radius1),
+                               TaperedCapsuleElem.Length, BodyHull.Vertexes);
+        }
+        for (const FKConvexElem& ConvexElem : BodyGeom.ConvexElems)
+        {
+            const FTransform ElemTransform = ConvexElem.GetTransform();
+            for (const FVector& ConvexVertex : ConvexElem.VertexData)
+            {
+                BodyHull.Vertexes.Add(FVector3f(ElemTransform.TransformPosition(ConvexVertex)));
+            }
+        }
+
+        if (BodyHull.Vertexes.Num() == 0)
+        {
+            continue;
+        }
+
+        const FBox3f BodyBounds(BodyHull.Vertexes);
+        for (int32 CornerIndex = 0; CornerIndex < 8; CornerIndex++)
+        {
+            BodyHull.BoundsCorners.Add(FVector3f((CornerIndex & 1) ? BodyBounds.Max.X : BodyBounds.Min.X,
+                                                 (CornerIndex & 2) ? BodyBounds.Max.Y : BodyBounds.Min.Y,
+                                                 (CornerIndex & 4) ? BodyBounds.Max.Z : BodyBounds.Min.Z));
+        }
+        OutBodyHulls.Bodies.Add(MoveTemp(BodyHull));
+    }
+}
+
+uint32 FNVSkeletalBodyHullCache::CalculateSourceSignature(const UPhysicsAsset* PhysicsAsset)
+{
+    uint32 Signature = 0;
+    if (!PhysicsAsset)
+    {
+        return Signature;
+    }
+
+    auto HashElemTransform = [&Signature](const FTransform& ElemTransform)
+    {
+        Signature = HashCombine(Signature, GetTypeHash(ElemTransform.GetLocation()));
+        Signature = HashCombine(Signature, GetTypeHash(ElemTransform.GetRotation().Euler()));
+    };
+
+    Signature = HashCombine(Signature, GetTypeHash(PhysicsAsset->SkeletalBodySetups.Num()));
+    for (const USkeletalBodySetup* BodySetup : PhysicsAsset->SkeletalBodySetups)
+    {
+        if (!BodySetup)
+        {
+            continue;
+        }
+
+        Signature = HashCombine(Signature, GetTypeHash(BodySetup->BoneName));
+        const FKAggregateGeom& BodyGeom = BodySetup->AggGeom;
+        for (const FKSphereElem& SphereElem : BodyGeom.SphereElems)
+        {
+            HashElemTransform(SphereElem.GetTransform());
+            Signature = HashCombine(Signature, GetTypeHash(SphereElem.Radius));
+        }
+        for (const FKBoxElem& BoxElem : BodyGeom.BoxElems)
+        {
+            HashElemTransform(BoxElem.GetTransform());
+            Signature = HashCombine(Signature, GetTypeHash(FVector(BoxElem.X, BoxElem.Y, BoxElem.Z)));
+        }
+        for (const FKSphylElem& SphylElem : BodyGeom.SphylElems)
+        {
+            HashElemTransform(SphylElem.GetTransform());
+            Signature = HashCombine(Signature, GetTypeHash(FVector2D(SphylElem.Radius, SphylElem.Length)));
+        }
+        for (const FKTaperedCapsuleElem& TaperedCapsuleElem : BodyGeom.TaperedCapsuleElems)
+        {
+            HashElemTransform(TaperedCapsuleElem.GetTransform());
+            Signature = HashCombine(Signature, GetTypeHash(FVector(TaperedCapsuleElem.Radius0, TaperedCapsuleElem.Radius1, TaperedCapsuleElem.Length)));
+        }
+        for (const FKConvexElem& ConvexElem : BodyGeom.ConvexElems)
+        {
+            HashElemTransform(ConvexElem.GetTransform());
+            Signature = HashCombine(Signature, GetTypeHash(ConvexElem.VertexData.Num()));
+            Signature = HashCombine(Signature, GetTypeHash(ConvexElem.ElemBox.Min));
+            Signature = HashCombine(Signature, GetTypeHash(ConvexElem.ElemBox.Max));
+        }
+    }
+    return Signature;
+}
+
+void FNVSkeletalBodyHullCache::Reset()
+{
+    ensure(IsInGameThread());
+    RuntimeHulls.Reset();
+}
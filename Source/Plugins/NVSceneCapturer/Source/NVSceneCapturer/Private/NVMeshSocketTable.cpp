@@ -0,0 +1,214 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVMeshSocketTable.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshSocket.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+
+namespace
+{
+    const UObject* GetMeshAsset(const UMeshComponent* MeshComp)
+    {
+        if (const UStaticMeshComponent* StaticMeshComp = Cast<UStaticMeshComponent>(MeshComp))
+        {
+            return StaticMeshComp->GetStaticMesh();
+        }
+        if (const USkeletalMeshComponent* SkeletalMeshComp = Cast<USkeletalMeshComponent>(MeshComp))
+        {
+            return SkeletalMeshComp->GetSkeletalMeshAsset();
+        }
+        return nullptr;
+    }
+
+    uint32 CalculateSocketFilterHash(bool bExportAllSockets, const TArray<FName>& ExportSocketNames)
+    {
+        if (bExportAllSockets)
+        {
+            return 0;
+        }
+
+        uint32 FilterHash = GetTypeHash(ExportSocketNames.Num()) + 1;
+        for (const FName& SocketName : ExportSocketNames)
+        {
+            FilterHash = HashCombine(FilterHash, GetTypeHash(SocketName));
+        }
+        return FilterHash;
+    }
+}
+
+//================================== FNVMeshSocketTableCache ==================================
+TMap<FNVMeshSocketTableCache::FSocketTableKey, FNVMeshSocketTablePtr> FNVMeshSocketTableCache::SocketTables;
+
+FNVMeshSocketTablePtr FNVMeshSocketTableCache::FindOrBuild(const UMeshComponent* MeshComp, bool bExportAllSockets, const TArray<FName>& ExportSocketNames)
+{
+    ensure(IsInGameThread());
+
+    const UObject* MeshAsset = GetMeshAsset(MeshComp);
+    if (!MeshAsset)
+    {
+        return nullptr;
+    }
+
+    const uint32 SourceSignature = CalculateSourceSignature(MeshComp);
+    const FSocketTableKey TableKey(FObjectKey(MeshAsset), CalculateSocketFilterHash(bExportAllSockets, ExportSocketNames));
+    FNVMeshSocketTablePtr& CachedTable = SocketTables.FindOrAdd(TableKey);
+    if (!CachedTable.IsValid() || (CachedTable->SourceSignature != SourceSignature))
+    {
+        // NOTE: Build a new object instead of updating the cached one, it's shared with the frames being annotated
+        TSharedPtr<FNVMeshSocketTable, ESPMode::ThreadSafe> NewTable = MakeShared<FNVMeshSocketTable, ESPMode::ThreadSafe>();
+        if (!BuildSocketTable(MeshComp, bExportAllSockets, ExportSocketNames, *NewTable))
+        {
+            SocketTables.Remove(TableKey);
+            return nullptr;
+        }
+        NewTable->SourceSignature = SourceSignature;
+        CachedTable = NewTable;
+    }
+    return CachedTable;
+}
+
+bool FNVMeshSocketTableCache::BuildSocketTable(const UMeshComponent* MeshComp, bool bExportAllSockets, const TArray<FName>& ExportSocketNames, FNVMeshSocketTable& OutSocketTable)
+{
+    OutSocketTable.Entries.Reset();
+
+    auto ShouldExportSocket = [bExportAllSockets, &ExportSocketNames](const FName& SocketName)
+    {
+        return bExportAllSockets || ExportSocketNames.Contains(SocketName);
+    };
+
+    if (const UStaticMeshComponent* StaticMeshComp = Cast<UStaticMeshComponent>(MeshComp))
+    {
+        const UStaticMesh* StaticMesh = StaticMeshComp->GetStaticMesh();
+        if (!StaticMesh)
+        {
+            return false;
+        }
+
+        // NOTE: Same order as UStaticMeshComponent::QuerySupportedSockets
+        for (const UStaticMeshSocket* Socket : StaticMesh->Sockets)
+        {
+            if (Socket && ShouldExportSocket(Socket->SocketName))
+            {
+                FNVMeshSocketTableEntry NewEntry;
+                NewEntry.SocketName = Socket->SocketName.ToString();
+                NewEntry.LocalTransform = FTransform(Socket->RelativeRotation, Socket->RelativeLocation, Socket->RelativeScale);
+                OutSocketTable.Entries.Add(MoveTemp(NewEntry));
+            }
+        }
+        return true;
+    }
+
+    if (const USkeletalMeshComponent* SkeletalMeshComp = Cast<USkeletalMeshComponent>(MeshComp))
+    {
+        const USkeletalMesh* SkeletalMesh = SkeletalMeshComp->GetSkeletalMeshAsset();
+        if (!SkeletalMesh)
+        {
+            return false;
+        }
+
+        const FReferenceSkeleton& RefSkeleton = SkeletalMesh->GetRefSkeleton();
+
+        // NOTE: Same order as USkinnedMeshComponent::QuerySupportedSockets: the sockets then the bones
+        // A bone with the same name as a socket resolve to the socket, like the name lookup does
+        TMap<FName, FNVMeshSocketTableEntry> SocketEntries;
+        const TArray<USkeletalMeshSocket*> ActiveSockets = SkeletalMesh->GetActiveSocketList();
+        for (const USkeletalMeshSocket* Socket : ActiveSockets)
+        {
+            if (!Socket)
+            {
+                continue;
+            }
+
+            FNVMeshSocketTableEntry SocketEntry;
+            SocketEntry.SocketName = Socket->SocketName.ToString();
+            SocketEntry.BoneIndex = RefSkeleton.FindBoneIndex(Socket->BoneName);
+            SocketEntry.LocalTransform = Socket->GetSocketLocalTransform();
+            if (!SocketEntries.Contains(Socket->SocketName))
+            {
+                SocketEntries.Add(Socket->SocketName, SocketEntry);
+            }
+
+            if (ShouldExportSocket(Socket->SocketName))
+            {
+                OutSocketTable.Entries.Add(MoveTemp(SocketEntry));
+            }
+        }
+
+        for (int32 BoneIndex = 0; BoneIndex < RefSkeleton.GetNum(); BoneIndex++)
+        {
+            const FName BoneName = RefSkeleton.GetBoneName(BoneIndex);
+            if (!ShouldExportSocket(BoneName))
+            {
+                continue;
+            }
+
+            const FNVMeshSocketTableEntry* SameNameSocketEntry = SocketEntries.Find(BoneName);
+            if (SameNameSocketEntry)
+            {
+                OutSocketTable.Entries.Add(*SameNameSocketEntry);
+            }
+            else
+            {
+                FNVMeshSocketTableEntry BoneEntry;
+                BoneEntry.SocketName = BoneName.ToString();
+                BoneEntry.BoneIndex = BoneIndex;
+                OutSocketTable.Entries.Add(MoveTemp(BoneEntry));
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void FNVMeshSocketTableCache::GatherSocketWorldLocations(const UMeshComponent* MeshComp, const FNVMeshSocketTable& SocketTable, TArray<FVector>& OutWorldLocations)
+{
+    if (!MeshComp)
+    {
+        return;
+    }
+
+    const FTransform& ComponentTransform = MeshComp->GetComponentTransform();
+    const USkinnedMeshComponent* SkinnedMeshComp = Cast<USkinnedMeshComponent>(MeshComp);
+    OutWorldLocations.Reserve(OutWorldLocations.Num() + SocketTable.Entries.Num());
+    for (const FNVMeshSocketTableEntry& SocketEntry : SocketTable.Entries)
+    {
+        // NOTE: GetBoneTransform also resolve the bones of the components following a leader pose
+        const bool bAttachedToBone = SkinnedMeshComp && (SocketEntry.BoneIndex != INDEX_NONE);
+        const FTransform SocketParentTransform = bAttachedToBone ? SkinnedMeshComp->GetBoneTransform(SocketEntry.BoneIndex, ComponentTransform) : ComponentTransform;
+        OutWorldLocations.Add((SocketEntry.LocalTransform * SocketParentTransform).GetLocation());
+    }
+}
+
+uint32 FNVMeshSocketTableCache::CalculateSourceSignature(const UMeshComponent* MeshComp)
+{
+    uint32 Signature = 0;
+    if (const UStaticMeshComponent* StaticMeshComp = Cast<UStaticMeshComponent>(MeshComp))
+    {
+        const UStaticMesh* StaticMesh = StaticMeshComp->GetStaticMesh();
+        Signature = StaticMesh ? GetTypeHash(StaticMesh->Sockets.Num()) : 0;
+    }
+    else if (const USkeletalMeshComponent* SkeletalMeshComp = Cast<USkeletalMeshComponent>(MeshComp))
+    {
+        const USkeletalMesh* SkeletalMesh = SkeletalMeshComp->GetSkeletalMeshAsset();
+        if (SkeletalMesh)
+        {
+            Signature = HashCombine(GetTypeHash(SkeletalMesh->NumSockets()), GetTypeHash(SkeletalMesh->GetRefSkeleton().GetNum()));
+        }
+    }
+    return Signature;
+}
+
+void FNVMeshSocketTableCache::Reset()
+{
+    ensure(IsInGameThread());
+    SocketTables.Reset();
+}
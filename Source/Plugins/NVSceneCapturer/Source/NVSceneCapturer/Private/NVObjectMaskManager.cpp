@@ -8,6 +8,7 @@
 #include "NVSceneCapturerUtils.h"
 #include "NVObjectMaskManager.h"
 #include "Components/StaticMeshComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Engine.h"
 #if WITH_EDITOR
 #include "UnrealEdGlobals.h"
@@ -334,6 +335,7 @@ uint8 UNVObjectMaskMananger_Stencil::GetMaskId(const AActor* CheckActor) const
 UNVObjectMaskMananger_VertexColor::UNVObjectMaskMananger_VertexColor() : Super()
 {
 	ActorMaskNameType = ENVActorMaskNameType::UseActorMeshName;
+	MaskIdStep = 1;
 }
 
 uint32 UNVObjectMaskMananger_VertexColor::GetMaskId(const FString& MaskName) const
@@ -376,6 +378,27 @@ void UNVObjectMaskMananger_VertexColor::ScanActors(UWorld* World)
     {
         Super::ScanActors(World);
 
+        // Each exported instance of the instanced static meshes get its own mask
+        if (ActorMaskNameType == ENVActorMaskNameType::UseActorInstanceName)
+        {
+            TArray<UInstancedStaticMeshComponent*> InstancedMeshComps;
+            for (const AActor* CheckActor : AllMaskActors)
+            {
+                NVSceneCapturerUtils::GetExportedMeshInstanceComponents(CheckActor, InstancedMeshComps);
+                for (const UInstancedStaticMeshComponent* CheckComp : InstancedMeshComps)
+                {
+                    for (int32 InstanceIndex = 0; InstanceIndex < CheckComp->GetInstanceCount(); InstanceIndex++)
+                    {
+                        AllMaskNames.Add(NVSceneCapturerUtils::GetMeshInstanceName(CheckActor, CheckComp, InstanceIndex));
+                    }
+                }
+            }
+            AllMaskNames.Sort([](const FString& A, const FString& B)
+            {
+                return (A < B);
+            });
+        }
+
         // TODO: Unify this function and UNVObjectMaskMananger_Stencil::ScanActors using template ?
 
         const uint32 TotalMaskCount = (uint32)AllMaskNames.Num();
@@ -396,6 +419,8 @@ void UNVObjectMaskMananger_VertexColor::ScanActors(UWorld* World)
         MaskNameIdMap.Reset();
 
         const uint32 ValidMaskCount = FMath::Min(TotalMaskCount, NVSceneCapturerUtils::MaxVertexColorID);
+        MaskIdStep = ((SegmentationIdAssignmentType == ENVIdAssignmentType::SpreadEvenly) && (ValidMaskCount > 0)) ?
+                     (NVSceneCapturerUtils::MaxVertexColorID / ValidMaskCount) : 1;
 
         // Assign the mask id for each valid map names
         for (uint32 i = 0; i < ValidMaskCount; i++)
@@ -422,6 +447,111 @@ void UNVObjectMaskMananger_VertexColor::ScanActors(UWorld* World)
                 {
                     ApplyVertexColorMaskToActor(CheckActor, ActorMaskId);
                 }
+                ApplyVertexColorMaskToMeshInstances(CheckActor);
+            }
+        }
+    }
+}
+
+uint32 UNVObjectMaskMananger_VertexColor::GetMaskId(const AActor* CheckActor, const UInstancedStaticMeshComponent* InstancedMeshComp, int32 InstanceIndex) const
+{
+    if (ActorMaskNameType != ENVActorMaskNameType::UseActorInstanceName)
+    {
+        return GetMaskId(CheckActor);
+    }
+
+    return GetMaskId(NVSceneCapturerUtils::GetMeshInstanceName(CheckActor, InstancedMeshComp, InstanceIndex));
+}
+
+void UNVObjectMaskMananger_VertexColor::ApplyVertexColorMaskToMeshInstances(AActor* CheckActor) const
+{
+    const UNVCapturableActorTag* Tag = CheckActor ? CheckActor->FindComponentByClass<UNVCapturableActorTag>() : nullptr;
+    if (!Tag || (ActorMaskNameType != ENVActorMaskNameType::UseActorInstanceName))
+    {
+        return;
+    }
+
+    TArray<UInstancedStaticMeshComponent*> InstancedMeshComps;
+    NVSceneCapturerUtils::GetExportedMeshInstanceComponents(CheckActor, InstancedMeshComps);
+    for (UInstancedStaticMeshComponent* CheckComp : InstancedMeshComps)
+    {
+        if (!NVSceneCapturerUtils::CanStoreMeshInstanceMaskColor(CheckComp, Tag->InstanceMaskCustomDataIndex))
+        {
+            UE_LOG(LogNVObjectMaskManager, Warning, TEXT("UNVObjectMaskMananger_VertexColor - '%s' of '%s' has %d per-instance custom data floats, it needs %d to store the instance mask color at index %d. Its instances don't have their own mask color."),
+                   *CheckComp->GetName(), *CheckActor->GetName(), CheckComp->NumCustomDataFloats, Tag->InstanceMaskCustomDataIndex + 3, Tag->InstanceMaskCustomDataIndex);
+            continue;
+        }
+
+        for (int32 InstanceIndex = 0; InstanceIndex < CheckComp->GetInstanceCount(); InstanceIndex++)
+        {
+            const uint32 InstanceMaskId = GetMaskId(CheckActor, CheckComp, InstanceIndex);
+            if (InstanceMaskId > 0)
+            {
+                const FColor& MaskColor = NVSceneCapturerUtils::ConvertInt32ToVertexColor(InstanceMaskId);
+                NVSceneCapturerUtils::SetMeshInstanceMaskColor(CheckComp, InstanceIndex, Tag->InstanceMaskCustomDataIndex, MaskColor);
+            }
+        }
+    }
+}
+
+void UNVObjectMaskMananger_VertexColor::BuildInstanceClassLUT(const UNVObjectMaskMananger_Stencil* ClassMaskManager, int32 Version, FNVInstanceClassLUT& OutInstanceClassLUT) const
+{
+    TMap<uint32, uint8> InstanceClassIds;
+    InstanceClassIds.Reserve(AllMaskActors.Num());
+    for (const AActor* CheckActor : AllMaskActors)
+    {
+        if (CheckActor)
+        {
+            const uint8 ClassId = ClassMaskManager ? ClassMaskManager->GetMaskId(CheckActor) : 0;
+            const uint32 InstanceId = GetMaskId(CheckActor);
+            if (InstanceId > 0)
+            {
+                InstanceClassIds.Add(InstanceId, ClassId);
+            }
+
+            // NOTE: The instances of the instanced static meshes have the class of their actor
+            if (ActorMaskNameType == ENVActorMaskNameType::UseActorInstanceName)
+            {
+                TArray<UInstancedStaticMeshComponent*> InstancedMeshComps;
+                NVSceneCapturerUtils::GetExportedMeshInstanceComponents(CheckActor, InstancedMeshComps);
+                for (const UInstancedStaticMeshComponent* CheckComp : InstancedMeshComps)
+                {
+                    for (int32 InstanceIndex = 0; InstanceIndex < CheckComp->GetInstanceCount(); InstanceIndex++)
+                    {
+                        const uint32 MeshInstanceId = GetMaskId(CheckActor, CheckComp, InstanceIndex);
+                        if (MeshInstanceId > 0)
+                        {
+                            InstanceClassIds.Add(MeshInstanceId, ClassId);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    OutInstanceClassLUT.Build(InstanceClassIds, MaskIdStep, Version);
+    if (bDebug)
+    {
+        UE_LOG(LogNVObjectMaskManager, Log, TEXT("UNVObjectMaskMananger_VertexColor - Instance to class lookup table version %d: %d instances, %d entries."),
+               Version, InstanceClassIds.Num(), OutInstanceClassLUT.Num());
+    }
+}
+
+void UNVObjectMaskMananger_VertexColor::GetMeshInstanceMaskIds(TSet<uint32>& OutMaskIds) const
+{
+    TArray<UInstancedStaticMeshComponent*> InstancedMeshComps;
+    for (const AActor* CheckActor : AllMaskActors)
+    {
+        NVSceneCapturerUtils::GetExportedMeshInstanceComponents(CheckActor, InstancedMeshComps);
+        for (const UInstancedStaticMeshComponent* CheckComp : InstancedMeshComps)
+        {
+            for (int32 InstanceIndex = 0; InstanceIndex < CheckComp->GetInstanceCount(); InstanceIndex++)
+            {
+                const uint32 MeshInstanceId = GetMaskId(CheckActor, CheckComp, InstanceIndex);
+                if (MeshInstanceId > 0)
+                {
+                    OutMaskIds.Add(MeshInstanceId);
+                }
             }
         }
     }
@@ -432,6 +562,7 @@ FNVObjectSegmentation_Instance::FNVObjectSegmentation_Instance()
 {
 	SegmentationIdAssignmentType = ENVIdAssignmentType::SpreadEvenly;
 	VertexColorMaskManager = nullptr;
+	InstanceClassLUTVersion = 0;
 }
 
 uint32 FNVObjectSegmentation_Instance::GetInstanceId(const AActor* CheckActor) const
@@ -445,6 +576,17 @@ uint32 FNVObjectSegmentation_Instance::GetInstanceId(const AActor* CheckActor) c
 	return 0;
 }
 
+uint32 FNVObjectSegmentation_Instance::GetInstanceId(const AActor* CheckActor, const UInstancedStaticMeshComponent* InstancedMeshComp, int32 InstanceIndex) const
+{
+	ensure(VertexColorMaskManager != nullptr);
+	if (VertexColorMaskManager)
+	{
+		return VertexColorMaskManager->GetMaskId(CheckActor, InstancedMeshComp, InstanceIndex);
+	}
+
+	return 0;
+}
+
 void FNVObjectSegmentation_Instance::Init(UObject* OwnerObject)
 {
 	check(OwnerObject != nullptr);
@@ -457,6 +599,21 @@ void FNVObjectSegmentation_Instance::ScanActors(UWorld* World)
 {
 	check(VertexColorMaskManager != nullptr);
 	VertexColorMaskManager->ScanActors(World);
+
+	// NOTE: Build a new set instead of updating the current one, the frames in flight may still be merged with it
+	TSharedPtr<TSet<uint32>, ESPMode::ThreadSafe> NewMeshInstanceIds = MakeShared<TSet<uint32>, ESPMode::ThreadSafe>();
+	VertexColorMaskManager->GetMeshInstanceMaskIds(*NewMeshInstanceIds);
+	MeshInstanceIds = NewMeshInstanceIds;
+}
+
+void FNVObjectSegmentation_Instance::UpdateInstanceClassLUT(const FNVObjectSegmentation_Class& ClassSegmentation)
+{
+	check(VertexColorMaskManager != nullptr);
+
+	// NOTE: Build a new table instead of updating the current one, the frames in flight may still be remapped with it
+	TSharedPtr<FNVInstanceClassLUT, ESPMode::ThreadSafe> NewInstanceClassLUT = MakeShared<FNVInstanceClassLUT, ESPMode::ThreadSafe>();
+	VertexColorMaskManager->BuildInstanceClassLUT(ClassSegmentation.GetMaskManager(), ++InstanceClassLUTVersion, *NewInstanceClassLUT);
+	InstanceClassLUT = NewInstanceClassLUT;
 }
 
 //================================== FNVObjectSegmentation_Class ==================================
@@ -0,0 +1,160 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVRenderProfile.h"
+
+namespace
+{
+    void AddShowFlagSetting(TArray<FEngineShowFlagsSetting>& ShowFlagSettings, const TCHAR* ShowFlagName, bool bEnabled)
+    {
+        FEngineShowFlagsSetting NewShowFlagSetting;
+        NewShowFlagSetting.ShowFlagName = ShowFlagName;
+        NewShowFlagSetting.Enabled = bEnabled;
+        ShowFlagSettings.Add(NewShowFlagSetting);
+    }
+
+    /// Replace the setting of the same show flag if there's one, otherwise add it
+    void SetShowFlagSetting(TArray<FEngineShowFlagsSetting>& ShowFlagSettings, const FEngineShowFlagsSetting& NewShowFlagSetting)
+    {
+        FEngineShowFlagsSetting* ExistingShowFlagSetting = ShowFlagSettings.FindByPredicate([&NewShowFlagSetting](const FEngineShowFlagsSetting& CheckShowFlagSetting)
+        {
+            return CheckShowFlagSetting.ShowFlagName.Equals(NewShowFlagSetting.ShowFlagName, ESearchCase::IgnoreCase);
+        });
+        if (ExistingShowFlagSetting)
+        {
+            ExistingShowFlagSetting->Enabled = NewShowFlagSetting.Enabled;
+        }
+        else
+        {
+            ShowFlagSettings.Add(NewShowFlagSetting);
+        }
+    }
+}
+
+//================================== FNVRenderProfile ==================================
+FNVRenderProfile::FNVRenderProfile()
+{
+    Preset = ENVRenderProfilePreset::FullLighting;
+}
+
+FNVRenderProfile::FNVRenderProfile(ENVRenderProfilePreset InPreset)
+{
+    Preset = InPreset;
+}
+
+void FNVRenderProfile::GetPresetShowFlagSettings(ENVRenderProfilePreset CheckPreset, TArray<FEngineShowFlagsSetting>& OutShowFlagSettings)
+{
+    OutShowFlagSettings.Reset();
+    switch (CheckPreset)
+    {
+        case ENVRenderProfilePreset::GeometryOnly:
+            // Lighting and shadows
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Lighting"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("DynamicShadows"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("ContactShadows"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("GlobalIllumination"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("LumenGlobalIllumination"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("LumenReflections"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("AmbientOcclusion"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("DistanceFieldAO"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("ReflectionEnvironment"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("ScreenSpaceReflections"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("SkyLighting"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("LightShafts"), false);
+            // Atmosphere and translucency
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Fog"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("VolumetricFog"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Atmosphere"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Cloud"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Translucency"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Particles"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Decals"), false);
+            // Post-process effects, the post-process materials still run
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("AntiAliasing"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("TemporalAA"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("MotionBlur"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("DepthOfField"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Bloom"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("LensFlares"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("EyeAdaptation"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Vignette"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Grain"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("ColorGrading"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("PostProcessMaterial"), true);
+            break;
+
+        case ENVRenderProfilePreset::UnlitVertexColor:
+            // Check Engine\Source\Editor\MeshPaint\Private\MeshPaintHelpers.cpp
+            // Use VertexColor to render objects, and disable the post-process and lighting ...
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Materials"), true);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Lighting"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("BSPTriangles"), true);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("VertexColors"), true);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("PostProcessing"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("HMDDistortion"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("AntiAliasing"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("MotionBlur"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("SeparateTranslucency"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Selection"), true);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Vignette"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("Tonemapper"), false);
+            AddShowFlagSetting(OutShowFlagSettings, TEXT("ColorGrading"), false);
+            break;
+
+        case ENVRenderProfilePreset::FullLighting:
+        default:
+            break;
+    }
+}
+
+void FNVRenderProfile::BuildShowFlagSettings(TArray<FEngineShowFlagsSetting>& OutShowFlagSettings) const
+{
+    GetPresetShowFlagSettings(Preset, OutShowFlagSettings);
+    for (const FEngineShowFlagsSetting& AdditionalShowFlagSetting : AdditionalShowFlagSettings)
+    {
+        SetShowFlagSetting(OutShowFlagSettings, AdditionalShowFlagSetting);
+    }
+}
+
+void FNVRenderProfile::ApplyToShowFlags(FEngineShowFlags& ShowFlags) const
+{
+    TArray<FEngineShowFlagsSetting> ProfileShowFlagSettings;
+    BuildShowFlagSettings(ProfileShowFlagSettings);
+    for (const FEngineShowFlagsSetting& ShowFlagSetting : ProfileShowFlagSettings)
+    {
+        const int32 ShowFlagIndex = FEngineShowFlags::FindIndexByName(*ShowFlagSetting.ShowFlagName);
+        if (ShowFlagIndex != INDEX_NONE)
+        {
+            ShowFlags.SetSingleFlag(ShowFlagIndex, ShowFlagSetting.Enabled);
+        }
+        else
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("The render profile's show flag '%s' doesn't exist."), *ShowFlagSetting.ShowFlagName);
+        }
+    }
+}
+
+void FNVRenderProfile::ApplyToSceneCapture(USceneCaptureComponent* SceneCaptureComponent, const TArray<FEngineShowFlagsSetting>& OverrideShowFlagSettings) const
+{
+    if (!SceneCaptureComponent)
+    {
+        return;
+    }
+
+    TArray<FEngineShowFlagsSetting> MergedShowFlagSettings;
+    BuildShowFlagSettings(MergedShowFlagSettings);
+    for (const FEngineShowFlagsSetting& OverrideShowFlagSetting : OverrideShowFlagSettings)
+    {
+        SetShowFlagSetting(MergedShowFlagSettings, OverrideShowFlagSetting);
+    }
+
+    // NOTE: The scene capture component reset its show flags to the game defaults before applying the settings
+    if (MergedShowFlagSettings.Num() > 0)
+    {
+        SceneCaptureComponent->SetShowFlagSettings(MergedShowFlagSettings);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVSceneAnnotationSnapshot.h"
+
+//================================== FNVAnnotationViewContext ==================================
+FVector FNVAnnotationViewContext::ProjectWorldPositionToImagePosition(const FVector &WorldPosition) const
+{
+    return ProjectClipPositionToImagePosition(ViewProjectionMatrix.TransformFVector4(FVector4(WorldPosition, 1)));
+}
+
+FVector FNVAnnotationViewContext::ProjectClipPositionToImagePosition(const FVector4 &ClipPosition) const
+{
+    FVector4 P = ClipPosition;
+    if (FMath::IsNearlyZero(P.W))
+        P.W = KINDA_SMALL_NUMBER;
+
+    const float RHW = 1.f / P.W;
+    FVector PlanePos(P.X * RHW, P.Y * RHW, P.Z * RHW);
+    if (P.W <= 0.f)
+        PlanePos.Z = 0.f;
+
+    FVector ImgPos;
+    ImgPos.X = 0.5f * (PlanePos.X + 1.f) * ImageScale.X;
+    ImgPos.Y = 0.5f * (-PlanePos.Y + 1.f) * ImageScale.Y;
+    ImgPos.Z = PlanePos.Z;
+    return ImgPos;
+}
+
+void FNVAnnotationViewContext::ProjectWorldPositionsToImagePositions(TArrayView<const FVector> WorldPositions, TArray<FVector> &OutImagePositions) const
+{
+    OutImagePositions.SetNumUninitialized(WorldPositions.Num());
+
+    // NOTE: The positions are transformed with the same SIMD matrix kernel as the single projection so the results are identical
+    for (int32 i = 0; i < WorldPositions.Num(); ++i)
+    {
+        OutImagePositions[i] = ProjectClipPositionToImagePosition(ViewProjectionMatrix.TransformFVector4(FVector4(WorldPositions[i], 1)));
+    }
+}
+
+//================================== FNVSceneAnnotationSnapshot ==================================
+FNVSceneAnnotationSnapshot::FNVSceneAnnotationSnapshot(int32 InFrameIndex)
+    : FrameIndex(InFrameIndex),
+      CaptureRegion(0, 0, 0, 0),
+      FullImageSize(0, 0)
+{
+}
+
+void FNVSceneAnnotationSnapshot::AddGeometryReferences()
+{
+    ensure(IsInGameThread());
+
+    for (const FNVActorAnnotationInput& ActorInput : Actors)
+    {
+        for (const FNVMeshBoundVertexSource& VertexSource : ActorInput.MeshVertexSources)
+        {
+            if (VertexSource.GeometryOwner)
+            {
+                ReferencedAssets.AddUnique(const_cast<UObject*>(VertexSource.GeometryOwner));
+            }
+        }
+    }
+}
+
+void FNVSceneAnnotationSnapshot::AddReferencedObjects(FReferenceCollector& Collector)
+{
+    Collector.AddReferencedObjects(ReferencedAssets);
+}
+
+FString FNVSceneAnnotationSnapshot::GetReferencerName() const
+{
+    return TEXT("FNVSceneAnnotationSnapshot");
+}
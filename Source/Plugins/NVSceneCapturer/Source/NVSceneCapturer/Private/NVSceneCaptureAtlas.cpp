@@ -0,0 +1,204 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVSceneCaptureAtlas.h"
+#include "RenderingThread.h"
+
+//================================== FNVAtlasLayout ==================================
+FIntPoint FNVAtlasLayout::LayoutTiles(const TArray<FIntPoint>& TileSizes, int32 MaxAtlasWidth, TArray<FIntRect>& OutTileRects)
+{
+    OutTileRects.Reset(TileSizes.Num());
+
+    FIntPoint AtlasSize = FIntPoint::ZeroValue;
+    FIntPoint RowStart = FIntPoint::ZeroValue;
+    int32 RowHeight = 0;
+    for (const FIntPoint& TileSize : TileSizes)
+    {
+        // Start a new row if the tile doesn't fit in the current one, a tile which is wider than the atlas get a row for itself
+        if ((MaxAtlasWidth > 0) && (RowStart.X > 0) && ((RowStart.X + TileSize.X) > MaxAtlasWidth))
+        {
+            RowStart.X = 0;
+            RowStart.Y += RowHeight;
+            RowHeight = 0;
+        }
+
+        OutTileRects.Add(FIntRect(RowStart, RowStart + TileSize));
+
+        RowStart.X += TileSize.X;
+        RowHeight = FMath::Max(RowHeight, TileSize.Y);
+        AtlasSize.X = FMath::Max(AtlasSize.X, RowStart.X);
+        AtlasSize.Y = FMath::Max(AtlasSize.Y, RowStart.Y + RowHeight);
+    }
+
+    return AtlasSize;
+}
+
+int64 FNVAtlasLayout::GetTileByteOffset(const FIntRect& TileRect, int32 AtlasRowPitch, int32 PixelByteSize)
+{
+    return ((int64)TileRect.Min.Y * AtlasRowPitch + TileRect.Min.X) * PixelByteSize;
+}
+
+bool FNVAtlasLayout::SliceTile(const uint8* AtlasPixels, const FIntPoint& AtlasBufferSize, EPixelFormat PixelFormat,
+                               const FIntRect& TileRect, FNVTexturePixelData& OutTilePixelsData)
+{
+    const int32 PixelByteSize = NVSceneCapturerUtils::GetPixelByteSize(PixelFormat);
+    ensure(AtlasPixels);
+    ensure(PixelByteSize > 0);
+    if (!AtlasPixels || (PixelByteSize <= 0) || (TileRect.Area() <= 0))
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("invalid argument."));
+        return false;
+    }
+
+    // NOTE: The tile may be clipped if the atlas buffer is smaller than expected
+    const int32 TileWidth = FMath::Min(TileRect.Width(), AtlasBufferSize.X - TileRect.Min.X);
+    const int32 TileHeight = FMath::Min(TileRect.Height(), AtlasBufferSize.Y - TileRect.Min.Y);
+    if ((TileWidth <= 0) || (TileHeight <= 0))
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("The tile (%s) is outside of the atlas buffer (%s)."),
+               *TileRect.ToString(), *AtlasBufferSize.ToString());
+        return false;
+    }
+
+    const int64 AtlasRowStride = (int64)AtlasBufferSize.X * PixelByteSize;
+    const int32 TileRowStride = TileWidth * PixelByteSize;
+
+    OutTilePixelsData.PixelFormat = PixelFormat;
+    OutTilePixelsData.PixelSize = FIntPoint(TileWidth, TileHeight);
+    OutTilePixelsData.RowStride = TileRowStride;
+    OutTilePixelsData.PixelData.Reset(TileRowStride * TileHeight);
+    OutTilePixelsData.PixelData.AddUninitialized(TileRowStride * TileHeight);
+
+    const uint8* SrcRow = AtlasPixels + GetTileByteOffset(TileRect, AtlasBufferSize.X, PixelByteSize);
+    uint8* DestRow = OutTilePixelsData.PixelData.GetData();
+    for (int32 Row = 0; Row < TileHeight; Row++)
+    {
+        FMemory::Memcpy(DestRow, SrcRow, TileRowStride);
+        SrcRow += AtlasRowStride;
+        DestRow += TileRowStride;
+    }
+    return true;
+}
+
+//================================== FNVSceneCaptureAtlas ==================================
+FNVSceneCaptureAtlas::FNVSceneCaptureAtlas()
+{
+    AtlasSize = FIntPoint::ZeroValue;
+    PendingTileCount = 0;
+    ReadbackCount = 0;
+}
+
+int32 FNVSceneCaptureAtlas::AddTile(const FIntPoint& TileSize)
+{
+    ensure(TileRects.Num() == 0);
+    return TileSizes.Add(TileSize);
+}
+
+void FNVSceneCaptureAtlas::FinalizeLayout(int32 MaxAtlasWidth)
+{
+    AtlasSize = FNVAtlasLayout::LayoutTiles(TileSizes, MaxAtlasWidth, TileRects);
+    ExpectedTiles.Init(false, TileRects.Num());
+    PendingTileCount = 0;
+}
+
+void FNVSceneCaptureAtlas::ExpectTile(int32 TileIndex)
+{
+    ensure(IsInGameThread());
+    if (ExpectedTiles.IsValidIndex(TileIndex) && !ExpectedTiles[TileIndex])
+    {
+        ExpectedTiles[TileIndex] = true;
+        PendingTileCount++;
+    }
+}
+
+void FNVSceneCaptureAtlas::SubmitTile(int32 TileIndex, const FTextureRHIRef& SourceTexture, EPixelFormat ReadbackPixelFormat,
+                                      FNVTextureReader::OnFinishedReadingPixelsDataCallback Callback)
+{
+    ensure(IsInGameThread());
+    ensure(SourceTexture);
+    ensure(Callback);
+    if (!TileRects.IsValidIndex(TileIndex) || !SourceTexture || !Callback)
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("invalid argument."));
+        return;
+    }
+
+    ENQUEUE_RENDER_COMMAND(CopyTileToAtlas)(
+        [Atlas = AsShared(), TileIndex, SourceTexture, Callback](FRHICommandListImmediate& RHICmdList)
+        {
+            const FIntRect& TileRect = Atlas->TileRects[TileIndex];
+            if (!Atlas->AtlasTexture)
+            {
+                // NOTE: The atlas use the same pixel format as the tiles' render targets so they can be copied as is
+                FRHITextureCreateDesc Desc =
+                    FRHITextureCreateDesc::Create2D(TEXT("NVSceneCaptureAtlas"))
+                        .SetExtent(Atlas->AtlasSize.X, Atlas->AtlasSize.Y)
+                        .SetFormat(SourceTexture->GetFormat())
+                        .SetNumMips(1)
+                        .SetNumSamples(1)
+                        .SetFlags(ETextureCreateFlags::ShaderResource);
+                Atlas->AtlasTexture = RHICreateTexture(Desc);
+            }
+
+            ensure(SourceTexture->GetFormat() == Atlas->AtlasTexture->GetFormat());
+            const FIntPoint CopySize(FMath::Min(TileRect.Width(), (int32)SourceTexture->GetSizeX()),
+                                     FMath::Min(TileRect.Height(), (int32)SourceTexture->GetSizeY()));
+            FNVTextureReader::CopyTexture2d(nullptr, RHICmdList, SourceTexture, FIntRect(FIntPoint::ZeroValue, CopySize),
+                                            Atlas->AtlasTexture, FIntRect(TileRect.Min, TileRect.Min + CopySize));
+
+            FTileReadback NewTileReadback;
+            NewTileReadback.TileIndex = TileIndex;
+            NewTileReadback.Callback = Callback;
+            Atlas->CopiedTiles.Add(NewTileReadback);
+        });
+
+    if (ExpectedTiles[TileIndex])
+    {
+        ExpectedTiles[TileIndex] = false;
+        PendingTileCount--;
+    }
+
+    // Only read back the atlas when all the tiles captured this frame are copied into it
+    if (PendingTileCount <= 0)
+    {
+        ReadbackAtlas(ReadbackPixelFormat);
+    }
+}
+
+void FNVSceneCaptureAtlas::ReadbackAtlas(EPixelFormat ReadbackPixelFormat)
+{
+    PendingTileCount = 0;
+    ReadbackCount++;
+
+    const int32 MaxPendingFrames = FNVTextureReader::GetMaxPendingReadbackFrames();
+    ENQUEUE_RENDER_COMMAND(ReadbackAtlas)(
+        [Atlas = AsShared(), ReadbackPixelFormat, MaxPendingFrames](FRHICommandListImmediate& RHICmdList)
+        {
+            if (!Atlas->AtlasTexture || (Atlas->CopiedTiles.Num() == 0))
+            {
+                return;
+            }
+
+            // NOTE: The atlas texture is reused by the next frames, the tiles copied so far are the ones of this readback
+            TArray<FTileReadback> ReadbackTiles = MoveTemp(Atlas->CopiedTiles);
+            Atlas->CopiedTiles.Reset();
+
+            FNVTextureReader::ReadPixelsRaw_RenderThread(RHICmdList, Atlas->AtlasTexture, FIntRect(FIntPoint::ZeroValue, Atlas->AtlasSize),
+                ReadbackPixelFormat, Atlas->AtlasSize, false, MaxPendingFrames,
+                [Atlas, ReadbackTiles = MoveTemp(ReadbackTiles)](uint8* PixelsData, EPixelFormat PixelFormat, FIntPoint PixelSize)
+                {
+                    for (const FTileReadback& ReadbackTile : ReadbackTiles)
+                    {
+                        FNVTexturePixelData TilePixelsData;
+                        if (FNVAtlasLayout::SliceTile(PixelsData, PixelSize, PixelFormat, Atlas->TileRects[ReadbackTile.TileIndex], TilePixelsData))
+                        {
+                            ReadbackTile.Callback(TilePixelsData);
+                        }
+                    }
+                });
+        });
+}
@@ -24,6 +24,7 @@ UNVSceneCaptureComponent2D::UNVSceneCaptureComponent2D(const FObjectInitializer&
     TextureTargetFormat = ETextureRenderTargetFormat::RTF_RGBA8;
     OverrideTexturePixelFormat = EPixelFormat::PF_Unknown;
     bIgnoreReadbackAlpha = false;
+    AtlasTileIndex = INDEX_NONE;
 }
 
 void UNVSceneCaptureComponent2D::BeginPlay()
@@ -268,16 +269,101 @@ void UNVSceneCaptureComponent2D::CaptureSceneToPixelsData(UNVSceneCaptureCompone
     else
     {
         CaptureSceneDeferred();
+        if (CaptureAtlas.IsValid())
+        {
+            CaptureAtlas->ExpectTile(AtlasTileIndex);
+        }
         ReadPixelsDataFromTexture(Callback);
     }
 }
 
+int32 UNVSceneCaptureComponent2D::CaptureSceneTilesToPixelsData(const TArray<FNVCaptureTile>& Tiles, UNVSceneCaptureComponent2D::OnFinishedCaptureSceneTileCallback Callback)
+{
+    ensure(Callback);
+    if (!Callback)
+    {
+        UE_LOG(LogNVSceneCapturerComponent2D, Error, TEXT("invalid argument."));
+        return 0;
+    }
+
+    const bool bPrevUseCustomProjectionMatrix = bUseCustomProjectionMatrix;
+    const FMatrix PrevCustomProjectionMatrix = CustomProjectionMatrix;
+
+    int32 CapturedTileCount = 0;
+    bUseCustomProjectionMatrix = true;
+    for (const FNVCaptureTile& Tile : Tiles)
+    {
+        CustomProjectionMatrix = Tile.ProjectionMatrix;
+        ReadbackCallbackList.Add([Callback, Tile](const FNVTexturePixelData& CapturedPixelData)
+        {
+            Callback(CapturedPixelData, Tile);
+        });
+
+        // NOTE: The readback command of the tile is issued right after its render commands, before the next tile overwrite the render target
+        CaptureScene();
+
+        if (ReadbackCallbackList.Num() > 0)
+        {
+            // The scene wasn't captured (e.g: the component is hidden), the next capture mustn't read back the tile
+            UE_LOG(LogNVSceneCapturerComponent2D, Warning, TEXT("Component '%s' can't capture the tile %d, the %d remaining tiles are skipped."),
+                   *GetName(), Tile.TileIndex, Tiles.Num() - CapturedTileCount);
+            ReadbackCallbackList.Reset();
+            break;
+        }
+        CapturedTileCount++;
+    }
+
+    bUseCustomProjectionMatrix = bPrevUseCustomProjectionMatrix;
+    CustomProjectionMatrix = PrevCustomProjectionMatrix;
+    return CapturedTileCount;
+}
+
+void UNVSceneCaptureComponent2D::SetCaptureAtlas(TSharedPtr<FNVSceneCaptureAtlas, ESPMode::ThreadSafe> NewCaptureAtlas, int32 NewAtlasTileIndex)
+{
+    CaptureAtlas = NewCaptureAtlas;
+    AtlasTileIndex = CaptureAtlas.IsValid() ? NewAtlasTileIndex : INDEX_NONE;
+}
+
+void UNVSceneCaptureComponent2D::SetReadbackRegion(const FIntRect& NewReadbackRegion)
+{
+    RenderTargetReader.SetReadbackRegion(NewReadbackRegion);
+}
+
+FIntPoint UNVSceneCaptureComponent2D::GetCapturedTextureSize() const
+{
+    return TextureTarget ? FIntPoint(TextureTarget->SizeX, TextureTarget->SizeY) : TextureTargetSize.ConvertToIntPoint();
+}
+
 void UNVSceneCaptureComponent2D::OnSceneCaptured()
 {
     if (ShouldReadbackPixelsData())
     {
         // NOTE: Need to check the case where we want to capture the render target but doesn't want to read back the pixels
 
+        if (CaptureAtlas.IsValid())
+        {
+            // The atlas read back the captured texture together with the other tiles
+            EPixelFormat ReadbackPixelFormat = EPixelFormat::PF_Unknown;
+            const FTextureRHIRef CapturedTexture = RenderTargetReader.GetRenderTargetTexture(ReadbackPixelFormat);
+            if (CapturedTexture)
+            {
+                CaptureAtlas->SubmitTile(AtlasTileIndex, CapturedTexture, ReadbackPixelFormat,
+                    [TempCallbackList = ReadbackCallbackList](const FNVTexturePixelData& CapturedPixelData)
+                {
+                    for (auto WaitingCallback : TempCallbackList)
+                    {
+                        if (WaitingCallback)
+                        {
+                            WaitingCallback(CapturedPixelData);
+                        }
+                    }
+                });
+
+                ReadbackCallbackList.Reset();
+                return;
+            }
+        }
+
         RenderTargetReader.ReadPixelsData(
             [this, TempCallbackList=ReadbackCallbackList](const FNVTexturePixelData& CapturedPixelData)
         {
@@ -12,6 +12,8 @@
 #include "NVSceneManager.h"
 #include "NVAnnotatedActor.h"
 #include "NVSceneDataHandler.h"
+#include "NVTextureReader.h"
+#include "NVSceneCaptureComponent2D.h"
 #include "Engine.h"
 #include "JsonObjectConverter.h"
 #if WITH_EDITOR
@@ -21,6 +23,7 @@
 #endif // WITH_EDITOR
 
 const float MAX_StartCapturingDuration = 5.0f; // max duration to wait for ANVSceneCapturerActor::StartCapturing to successfully begin capturing before emitting warning messages
+const float MAX_InFlightFrameDuration = 10.0f; // max duration to wait for the pixels data of a frame in flight to be read back before exporting it anyway
 
 ANVSceneCapturerActor::ANVSceneCapturerActor(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -38,6 +41,8 @@ ANVSceneCapturerActor::ANVSceneCapturerActor(const FObjectInitializer& ObjectIni
 
     TimeBetweenSceneCapture = 0.f;
     LastCaptureTimestamp = 0.f;
+    RejectedFrameCount = 0;
+    ConsecutiveRejectedFrameCount = 0;
 
     bIsActive = true;
     CurrentState = ENVSceneCapturerState::Active;
@@ -46,6 +51,9 @@ ANVSceneCapturerActor::ANVSceneCapturerActor(const FObjectInitializer& ObjectIni
 
     MaxNumberOfFramesToCapture = 0;
     NumberOfFramesToCapture = MaxNumberOfFramesToCapture;
+    PipelineDepth = 1;
+    bBuildAnnotationInBackground = true;
+    bUseCaptureAtlas = false;
 
     CachedPlayerControllerViewTarget = nullptr;
 
@@ -54,7 +62,17 @@ ANVSceneCapturerActor::ANVSceneCapturerActor(const FObjectInitializer& ObjectIni
     StartCapturingTimestamp = 0.f;
     bNeedToExportScene = false;
     bTakingOverViewport = false;
-    bSkipFirstFrame = false;
+    bWaitingToStartCapturing = false;
+    RequestStartCapturingTimestamp = 0.f;
+    LastReadinessWaitDuration = 0.f;
+    ReadinessTimeout = 1.f;
+    CaptureCadenceSeed = 0;
+    bResumeFromCheckpoint = false;
+    bCheckpointPending = false;
+    LastCheckpointFrameIndex = INDEX_NONE;
+    LastExportedFrameIndex = INDEX_NONE;
+    bReseedRandomAtCheckpoints = false;
+    ShutdownDrainTimeout = 60.f;
 
 #if WITH_EDITORONLY_DATA
     USelection::SelectObjectEvent.AddUObject(this, &ANVSceneCapturerActor::OnActorSelected);
@@ -72,7 +90,20 @@ void ANVSceneCapturerActor::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
 
+    if (bWaitingToStartCapturing)
+    {
+        UpdateStartCapturing();
+    }
+
+    if (CapturePipeline.GetInFlightFrameCount() > 0)
+    {
+        // Map the readbacks the GPU already finished, then export the frames which are completed
+        FNVTextureReader::ProcessPendingReadbacks();
+        RetireCapturedFrames(false);
+    }
     CheckCaptureScene();
+
+    CaptureFarmMode.Tick(GetWorld(), DeltaTime);
 }
 
 void ANVSceneCapturerActor::UpdateSettingsFromCommandLine()
@@ -100,6 +131,56 @@ void ANVSceneCapturerActor::UpdateSettingsFromCommandLine()
         bAutoStartCapturing = true;
     }
 
+    int32 PipelineDepthOverride = 0;
+    if (FParse::Value(CommandLine, TEXT("-PipelineDepth="), PipelineDepthOverride))
+    {
+        PipelineDepth = FMath::Clamp(PipelineDepthOverride, 1, 4);
+    }
+
+    if (FParse::Param(CommandLine, TEXT("RegionOfInterest")))
+    {
+        RegionOfInterestSettings.bEnabled = true;
+    }
+
+    if (FParse::Param(CommandLine, TEXT("TiledCapture")))
+    {
+        TiledCaptureSettings.bEnabled = true;
+    }
+
+    int32 MaxTileSizeOverride = 0;
+    if (FParse::Value(CommandLine, TEXT("-MaxTileSize="), MaxTileSizeOverride))
+    {
+        TiledCaptureSettings.MaxTileSize = FMath::Max(MaxTileSizeOverride, 64);
+    }
+
+    if (FParse::Param(CommandLine, TEXT("CaptureFarm")))
+    {
+        CaptureFarmModeSettings.bEnabled = true;
+    }
+
+    float FarmPreviewIntervalOverride = 0.f;
+    if (FParse::Value(CommandLine, TEXT("-FarmPreviewInterval="), FarmPreviewIntervalOverride))
+    {
+        CaptureFarmModeSettings.PreviewInterval = FarmPreviewIntervalOverride;
+    }
+
+    int32 MinVisibleObjectsOverride = 0;
+    if (FParse::Value(CommandLine, TEXT("-MinVisibleObjects="), MinVisibleObjectsOverride))
+    {
+        FrameVisibilitySettings.bEnabled = (MinVisibleObjectsOverride > 0);
+        FrameVisibilitySettings.MinVisibleObjectCount = FMath::Max(MinVisibleObjectsOverride, 1);
+    }
+
+    if (FParse::Param(CommandLine, TEXT("UseCaptureAtlas")))
+    {
+        bUseCaptureAtlas = true;
+    }
+
+    if (FParse::Param(CommandLine, TEXT("Resume")))
+    {
+        bResumeFromCheckpoint = true;
+    }
+
     FString SettingsFilePath;
     if (FParse::Value(CommandLine, TEXT("-SettingsPath="), SettingsFilePath))
     {
@@ -146,7 +227,6 @@ void ANVSceneCapturerActor::BeginPlay()
     }
 
     bNeedToExportScene = false;
-    bSkipFirstFrame = true;
 
     UpdateViewpointList();
 
@@ -155,6 +235,8 @@ void ANVSceneCapturerActor::BeginPlay()
     {
         if (CheckViewpointComp && CheckViewpointComp->IsEnabled())
         {
+            // NOTE: The tiled capture settings decide the size of the feature extractors' render targets
+            CheckViewpointComp->SetTiledCaptureSettings(TiledCaptureSettings);
             CheckViewpointComp->SetupFeatureExtractors();
         }
     }
@@ -164,26 +246,32 @@ void ANVSceneCapturerActor::BeginPlay()
     CurrentState = bIsActive? ENVSceneCapturerState::Active: ENVSceneCapturerState::NotActive;
     if (bAutoStartCapturing && (CurrentState == ENVSceneCapturerState::Active))
     {
-        // NOTE: We need to delay the capturing so the scene have time to set up
-        const float DelayDuration = 1.f;
-        GetWorldTimerManager().SetTimer(TimeHandle_StartCapturingDelay,
-                                        this,
-                                        &ANVSceneCapturerActor::StartCapturing,
-                                        DelayDuration,
-                                        false, 
-                                        DelayDuration);
-        StartCapturingDuration = 0;
+        // NOTE: The capturing only start when the scene is set up and ready
+        StartCapturing();
     }
 
     if (SceneDataVisualizer)
     {
         SceneDataVisualizer->Init();
     }
+
+    ApplicationWillTerminateHandle = FCoreDelegates::GetApplicationWillTerminateDelegate().AddUObject(this, &ANVSceneCapturerActor::DrainAndCheckpoint);
 }
 
 void ANVSceneCapturerActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    GetWorldTimerManager().ClearTimer(TimeHandle_StartCapturingDelay);
+    bWaitingToStartCapturing = false;
+
+    FCoreDelegates::GetApplicationWillTerminateDelegate().Remove(ApplicationWillTerminateHandle);
+    ApplicationWillTerminateHandle.Reset();
+
+    // The game is shutting down (e.g: SIGTERM), don't lose the frames which are already captured
+    if ((CurrentState == ENVSceneCapturerState::Running) || (CurrentState == ENVSceneCapturerState::Paused))
+    {
+        DrainAndCheckpoint();
+        StopCapturing();
+    }
+    CaptureFarmMode.Exit(GetWorld());
 
     Super::EndPlay(EndPlayReason);
 }
@@ -274,8 +362,14 @@ void ANVSceneCapturerActor::CheckCaptureScene()
             {
                 CurrentGameMode->ClearPause();
             }
+            else if (ShouldRejectFrame() && !ShouldCaptureRejectedFrame())
+            {
+                // Skip the render, readback and export of a frame nobody want
+                RejectFrame();
+            }
             else
             {
+                ConsecutiveRejectedFrameCount = 0;
                 CaptureSceneToPixelsData();
                 // Update the capturer settings at the end of the frame after we already captured data of this frame
                 UpdateCapturerSettings();
@@ -295,10 +389,92 @@ void ANVSceneCapturerActor::CheckCaptureScene()
 void ANVSceneCapturerActor::ResetCounter()
 {
     CapturedFrameCounter.Reset();
+    RejectedFrameCount = 0;
+    ConsecutiveRejectedFrameCount = 0;
+}
+
+bool ANVSceneCapturerActor::ShouldRejectFrame() const
+{
+    if (!FrameVisibilitySettings.bEnabled)
+    {
+        return false;
+    }
+    // NOTE: Let the capturer complete once all the frames are captured
+    if ((NumberOfFramesToCapture > 0) && (CapturedFrameCounter.GetTotalFrameCount() >= NumberOfFramesToCapture))
+    {
+        return false;
+    }
+
+    // NOTE: All the viewpoints see the same training objects, only gather their bounds once
+    TArray<FBox> ObjectBounds;
+    bool bGatheredObjectBounds = false;
+    for (const UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
+    {
+        if (ViewpointComp && ViewpointComp->IsEnabled())
+        {
+            if (!bGatheredObjectBounds)
+            {
+                ViewpointComp->GetTrainingObjectBounds(ObjectBounds);
+                bGatheredObjectBounds = true;
+            }
+            if (!ViewpointComp->HasEnoughVisibleTrainingObjects(FrameVisibilitySettings, ObjectBounds))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ANVSceneCapturerActor::ShouldCaptureRejectedFrame() const
+{
+    const int32 MaxConsecutiveRejectedFrames = FrameVisibilitySettings.MaxConsecutiveRejectedFrames;
+    if ((MaxConsecutiveRejectedFrames <= 0) || (ConsecutiveRejectedFrameCount < MaxConsecutiveRejectedFrames))
+    {
+        return false;
+    }
+
+    UE_LOG(LogNVSceneCapturer, Warning, TEXT("Capturer '%s' rejected %d frames in a row, the frame is captured without enough visible training objects. Check the training objects can be seen by the viewpoints."),
+           *GetName(), ConsecutiveRejectedFrameCount);
+    return true;
+}
+
+void ANVSceneCapturerActor::RejectFrame()
+{
+    RejectedFrameCount++;
+    ConsecutiveRejectedFrameCount++;
+    UE_LOG(LogNVSceneCapturer, Verbose, TEXT("Capturer '%s' rejected a frame without enough visible training objects (%d rejected so far)."),
+           *GetName(), RejectedFrameCount);
+
+    // NOTE: The capture timestamp isn't updated so the next frame is checked right away
+    OnFrameRejectedEvent.Broadcast(this, RejectedFrameCount);
+    OnFrameRejected().Broadcast(this);
+    UpdateCapturerSettings();
+}
+
+FNVOnSceneCapturerFrameRejected& ANVSceneCapturerActor::OnFrameRejected()
+{
+    static FNVOnSceneCapturerFrameRejected FrameRejectedDelegate;
+    return FrameRejectedDelegate;
 }
 
 void ANVSceneCapturerActor::CaptureSceneToPixelsData()
 {
+    UpdateLastExportedFrame();
+
+    if (bCheckpointPending)
+    {
+        // Make sure the pixels data of the previous frames are read back then wait for them to be exported
+        FlushInFlightFrames();
+        if (SceneDataHandler && SceneDataHandler->IsHandlingData())
+        {
+            return;
+        }
+
+        WriteCheckpoint();
+        bCheckpointPending = false;
+    }
+
     const int32 CurrentFrameIndex = CapturedFrameCounter.GetTotalFrameCount();
 
     bool bFinishedCapturing = (NumberOfFramesToCapture > 0) && (CurrentFrameIndex >= NumberOfFramesToCapture);
@@ -306,68 +482,197 @@ void ANVSceneCapturerActor::CaptureSceneToPixelsData()
     const float CurrentTime = GetWorld()->GetTimeSeconds();
     const float TimePassSinceLastCapture = CurrentTime - LastCaptureTimestamp;
 
+    // NOTE: Nobody see the visualizers when the game viewport isn't rendered
+    UNVSceneDataVisualizer* FrameDataVisualizer = CaptureFarmMode.IsRenderingSuppressed() ? nullptr : SceneDataVisualizer;
+
     // Let all the child exporter components know it need to export the scene
     if (!bFinishedCapturing)
     {
+        // Decide which feature extractors capture this frame, the others don't render nor read back anything
+        // NOTE: The random cadences are drawn once per feature extractor settings, the viewpoints sharing them capture the same frames
+        CaptureCadenceDraws.BeginFrame(CaptureCadenceSeed, CurrentFrameIndex);
+        CaptureCadenceDraws.DrawSettings(FeatureExtractorSettings);
+        for (UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
+        {
+            if (ViewpointComp)
+            {
+                CaptureCadenceDraws.DrawSettings(ViewpointComp->GetFeatureExtractorSettings());
+            }
+        }
+
+        TArray<UNVSceneFeatureExtractor*> ScheduledFeatureExtractors;
         for (UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
         {
             if (ViewpointComp && ViewpointComp->IsEnabled())
             {
-                ViewpointComp->CaptureSceneToPixelsData(
-                    [this, CurrentFrameIndex](const FNVTexturePixelData& CapturedPixelData, UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint)
+                ViewpointComp->UpdateCaptureSchedule(CurrentFrameIndex, CaptureCadenceDraws);
+                // NOTE: The tiles always cover the whole images
+                if (RegionOfInterestSettings.bEnabled && !ViewpointComp->IsTiledCapture())
                 {
-                    if (SceneDataHandler)
-                    {
-                        SceneDataHandler->HandleScenePixelsData(CapturedPixelData,
-                                                                CapturedFeatureExtractor,
-                                                                CapturedViewpoint,
-                                                                CurrentFrameIndex);
-                    }
+                    ViewpointComp->SetCaptureRegion(ViewpointComp->CalculateRegionOfInterest(RegionOfInterestSettings));
+                }
+
+                ViewpointComp->GetScheduledFeatureExtractors(ScheduledFeatureExtractors);
+                if (SceneDataHandler)
+                {
+                    SceneDataHandler->HandleFrameSchedule(ScheduledFeatureExtractors, ViewpointComp, CurrentFrameIndex);
+                }
+                if (FrameDataVisualizer)
+                {
+                    FrameDataVisualizer->HandleFrameSchedule(ScheduledFeatureExtractors, ViewpointComp, CurrentFrameIndex);
+                }
+            }
+        }
+
+        // When the frames overlap, the frame keep its annotation data until all of its pixels data are read back
+        TSharedPtr<FNVCaptureFrameContext, ESPMode::ThreadSafe> FrameContext;
+        if (CapturePipeline.GetDepth() > 1)
+        {
+            int32 PendingReadbackCount = 0;
+            for (const UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
+            {
+                if (ViewpointComp && ViewpointComp->IsEnabled())
+                {
+                    PendingReadbackCount += ViewpointComp->GetCapturedPixelsDataCount();
+                }
+            }
+            FrameContext = CapturePipeline.BeginFrame(CurrentFrameIndex, PendingReadbackCount, FPlatformTime::Seconds());
+        }
 
-                    if (SceneDataVisualizer)
+        for (UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
+        {
+            if (ViewpointComp && ViewpointComp->IsEnabled())
+            {
+                if (FrameContext.IsValid())
+                {
+                    FrameContext->ViewpointTransforms.Add(FObjectKey(ViewpointComp), ViewpointComp->GetComponentTransform());
+                }
+
+                if (ViewpointComp->IsTiledCapture())
+                {
+                    const int32 CapturedTileCount = ViewpointComp->CaptureSceneTilesToPixelsData(
+                        [this, CurrentFrameIndex, FrameContext, FrameDataVisualizer](const FNVTexturePixelData& TilePixelsData, const FNVCaptureTile& CapturedTile, UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint)
                     {
-                        SceneDataVisualizer->HandleScenePixelsData(CapturedPixelData,
-                                CapturedFeatureExtractor,
-                                CapturedViewpoint,
-                                CurrentFrameIndex);
+                        if (SceneDataHandler)
+                        {
+                            SceneDataHandler->HandleScenePixelsTile(TilePixelsData,
+                                                                    CapturedTile,
+                                                                    CapturedFeatureExtractor,
+                                                                    CapturedViewpoint,
+                                                                    CurrentFrameIndex);
+                        }
+
+                        if (FrameDataVisualizer)
+                        {
+                            FrameDataVisualizer->HandleScenePixelsTile(TilePixelsData,
+                                    CapturedTile,
+                                    CapturedFeatureExtractor,
+                                    CapturedViewpoint,
+                                    CurrentFrameIndex);
+                        }
+
+                        if (FrameContext.IsValid())
+                        {
+                            FrameContext->OnReadbackCompleted();
+                        }
+                    });
+
+                    // The frame was told to wait for all the tiles, it mustn't wait for the ones which are never read back
+                    const int32 SkippedTileCount = ViewpointComp->GetCapturedPixelsDataCount() - CapturedTileCount;
+                    if (SkippedTileCount > 0)
+                    {
+                        UE_LOG(LogNVSceneCapturer, Warning, TEXT("Capturer '%s' skipped %d tiles of viewpoint '%s' at frame %d, their images are incomplete."),
+                               *GetName(), SkippedTileCount, *ViewpointComp->GetDisplayName(), CurrentFrameIndex);
+                        if (FrameContext.IsValid())
+                        {
+                            FrameContext->OnReadbacksSkipped(SkippedTileCount);
+                        }
                     }
-                });
+                }
+                else
+                {
+                    ViewpointComp->CaptureSceneToPixelsData(
+                        [this, CurrentFrameIndex, FrameContext, FrameDataVisualizer](const FNVTexturePixelData& CapturedPixelData, UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint)
+                    {
+                        if (SceneDataHandler)
+                        {
+                            SceneDataHandler->HandleScenePixelsData(CapturedPixelData,
+                                                                    CapturedFeatureExtractor,
+                                                                    CapturedViewpoint,
+                                                                    CurrentFrameIndex);
+                        }
+
+                        if (FrameDataVisualizer)
+                        {
+                            FrameDataVisualizer->HandleScenePixelsData(CapturedPixelData,
+                                    CapturedFeatureExtractor,
+                                    CapturedViewpoint,
+                                    CurrentFrameIndex);
+                        }
+
+                        if (FrameContext.IsValid())
+                        {
+                            FrameContext->OnReadbackCompleted();
+                        }
+                    });
+                }
 
-                ViewpointComp->CaptureSceneAnnotationData(
-                    [this, CurrentFrameIndex](const TSharedPtr<FJsonObject>& CapturedData, UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint)
+                if (FrameContext.IsValid() && bBuildAnnotationInBackground)
                 {
-                    if (SceneDataHandler)
+                    // The annotation data is built on a worker thread, the frame is retired once both its pixels and annotation data are ready
+                    ViewpointComp->CaptureSceneAnnotationSnapshots(CurrentFrameIndex,
+                        [FrameContext](const FNVSceneAnnotationSnapshotRef& Snapshot, UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint)
                     {
-                        SceneDataHandler->HandleSceneAnnotationData(CapturedData,
-                                CapturedFeatureExtractor,
-                                CapturedViewpoint,
-                                CurrentFrameIndex);
-                    }
-                });
+                        FrameContext->AddAnnotationSnapshot(Snapshot, CapturedFeatureExtractor, CapturedViewpoint);
+                    });
+                }
+                else
+                {
+                    ViewpointComp->CaptureSceneAnnotationData(
+                        [this, CurrentFrameIndex, FrameContext](const TSharedPtr<FJsonObject>& CapturedData, UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint)
+                    {
+                        if (FrameContext.IsValid())
+                        {
+                            FNVCapturedAnnotationData NewAnnotationData;
+                            NewAnnotationData.AnnotationData = CapturedData;
+                            NewAnnotationData.FeatureExtractor = CapturedFeatureExtractor;
+                            NewAnnotationData.Viewpoint = CapturedViewpoint;
+                            FrameContext->Annotations.Add(MoveTemp(NewAnnotationData));
+                        }
+                        else if (SceneDataHandler)
+                        {
+                            SceneDataHandler->HandleSceneAnnotationData(CapturedData,
+                                    CapturedFeatureExtractor,
+                                    CapturedViewpoint,
+                                    CurrentFrameIndex);
+                        }
+                    });
+                }
             }
         }
 
-        if (bSkipFirstFrame)
-        {
-            bSkipFirstFrame = false;
-        }
-        else
+        CapturedFrameCounter.IncreaseFrameCount();
+        CapturedFrameCounter.AddFrameDuration(TimePassSinceLastCapture);
+
+        const UNVSceneDataExporter* CurrentSceneDataExporter = Cast<UNVSceneDataExporter>(SceneDataHandler);
+        const int32 CheckpointFrameInterval = CurrentSceneDataExporter ? CurrentSceneDataExporter->GetCheckpointFrameInterval() : 0;
+        if ((CheckpointFrameInterval > 0) && ((CapturedFrameCounter.GetTotalFrameCount() % CheckpointFrameInterval) == 0))
         {
-            CapturedFrameCounter.IncreaseFrameCount();
+            bCheckpointPending = true;
         }
-        CapturedFrameCounter.AddFrameDuration(TimePassSinceLastCapture);
     }
     else
     {
-        bool bFinishedProcessingData = true;
-        // Make sure all the captured scene data are processed
-        if (SceneDataHandler)
+        // Make sure all the captured scene data are read back and processed
+        bool bFinishedProcessingData = (CapturePipeline.GetInFlightFrameCount() == 0);
+        if (SceneDataHandler && bFinishedProcessingData)
         {
             bFinishedProcessingData = !SceneDataHandler->IsHandlingData();
         }
 
         if (bFinishedProcessingData)
         {
+            WriteCheckpoint();
             OnCompleted();
         }
     }
@@ -393,36 +698,57 @@ void ANVSceneCapturerActor::SetNumberOfFramesToCapture(int32 NewSceneCount)
 void ANVSceneCapturerActor::StartCapturing()
 {
     bNeedToExportScene = false;
-    bSkipFirstFrame = true;
+
+    // NOTE: The capturing only start when the scene is ready, UpdateStartCapturing check it every frame
+    bWaitingToStartCapturing = true;
+    RequestStartCapturingTimestamp = GetWorld()->GetRealTimeSeconds();
+    StartCapturingDuration = 0.f;
+}
+
+void ANVSceneCapturerActor::UpdateStartCapturing()
+{
+    UWorld* World = GetWorld();
+    const float CurrentTime = World->GetRealTimeSeconds();
+
     ANVSceneManager* ANVSceneManagerPtr = ANVSceneManager::GetANVSceneManagerPtr();
     // if ANVSceneManagerPtr is nullptr, then there's no scene manager and it's assumed the scene is static and thus ready, else check with the scene manager
     const bool bSceneIsReady = !ANVSceneManagerPtr || ANVSceneManagerPtr->GetState() == ENVSceneManagerState::Ready;
-    if (bSceneIsReady)
+    if (!bSceneIsReady)
     {
-        StartCapturing_Internal();
-    }
-    else if (!TimeHandle_StartCapturingDelay.IsValid())
-    {
-        const float DelayDuration = 1.f;
-        // NOTE: We need to delay the capturing so the scene have time to set up
-        GetWorldTimerManager().SetTimer(TimeHandle_StartCapturingDelay,
-                                        this,
-                                        &ANVSceneCapturerActor::StartCapturing,
-                                        DelayDuration,
-                                        false,
-                                        DelayDuration);
-
-        StartCapturingDuration += DelayDuration;
-        if (StartCapturingDuration > MAX_StartCapturingDuration)
+        const float PrevStartCapturingDuration = StartCapturingDuration;
+        StartCapturingDuration = CurrentTime - RequestStartCapturingTimestamp;
+        if ((StartCapturingDuration > MAX_StartCapturingDuration) && (PrevStartCapturingDuration <= MAX_StartCapturingDuration))
         {
             UE_LOG(LogNVSceneCapturer, Warning, TEXT("Capturing could not Start -- did you set up the Game Mode?\nStartCapturingDuration: %.6f"),
                 StartCapturingDuration);
         }
+        return;
     }
-    else
+
+    // The scene is set up, now wait for its assets and render states to be ready
+    if (!ReadinessGate.IsWaiting())
     {
-        UE_LOG(LogNVSceneCapturer, Error, TEXT("Capturing could not Start -- did you set up the Game Mode?"));
+        // NOTE: The other modules may register their conditions after this capturer is created
+        ReadinessGate.RemoveAllConditions();
+        ReadinessGate.AddDefaultConditions();
+        ReadinessGate.Timeout = ReadinessTimeout;
+        ReadinessGate.GateName = GetName();
+        ReadinessGate.BeginWaiting(World, CurrentTime);
     }
+    if (!ReadinessGate.Update(World, CurrentTime))
+    {
+        return;
+    }
+
+    bWaitingToStartCapturing = false;
+    LastReadinessWaitDuration = CurrentTime - RequestStartCapturingTimestamp;
+    // NOTE: The gate already warned about the timeout and the conditions which were not met
+    if (!ReadinessGate.HasTimedOut())
+    {
+        UE_LOG(LogNVSceneCapturer, Log, TEXT("Capturer '%s' waited %.3f seconds for the scene to be ready."), *GetName(), LastReadinessWaitDuration);
+    }
+
+    StartCapturing_Internal();
 }
 
 void ANVSceneCapturerActor::StartCapturing_Internal()
@@ -448,17 +774,87 @@ void ANVSceneCapturerActor::StartCapturing_Internal()
                 NVSceneManagerPtr->UpdateSegmentationMask();
             }
 
+            // Continue from the last checkpoint of the previous session if asked to
+            FNVCaptureCheckpoint ResumeCheckpoint;
+            bool bResumeCapturing = false;
+            if (bResumeFromCheckpoint)
+            {
+                if (LoadResumeCheckpoint(ResumeCheckpoint) && (ResumeCheckpoint.MarkerIndex == GetCurrentMarkerIndex()))
+                {
+                    bResumeCapturing = true;
+                    CheckpointRandomStream.Initialize(ResumeCheckpoint.RandomSeed);
+                    if (bReseedRandomAtCheckpoints)
+                    {
+                        FMath::RandInit(ResumeCheckpoint.RandomSeed);
+                        FMath::SRandInit(ResumeCheckpoint.RandomSeed);
+                    }
+                }
+                else
+                {
+                    UE_LOG(LogNVSceneCapturer, Warning, TEXT("Capturer '%s' doesn't have any checkpoint to resume from, start capturing from the first frame."),
+                           *GetName());
+                }
+                // Only the first capturing session is resumed, the next scene markers start from their first frame
+                bResumeFromCheckpoint = false;
+            }
+            if (!bResumeCapturing)
+            {
+                // NOTE: Only take a number from the global random stream if the checkpoints re-seed it anyway
+                CheckpointRandomStream.Initialize(bReseedRandomAtCheckpoints ? FMath::Rand() : 0);
+            }
+
+            UNVSceneDataExporter* CurrentSceneDataExporter = Cast<UNVSceneDataExporter>(SceneDataHandler);
+            if (CurrentSceneDataExporter)
+            {
+                CurrentSceneDataExporter->SetResumingCapture(bResumeCapturing);
+            }
+
+            // Let the frames overlap: the pixels data are read back a few frames later instead of stalling the rendering thread
+            CapturePipeline.Reset(PipelineDepth);
+            FNVTextureReader::SetMaxPendingReadbackFrames((PipelineDepth > 1) ? PipelineDepth : 0);
+            if (PipelineDepth > 1)
+            {
+                UE_LOG(LogNVSceneCapturer, Log, TEXT("Capturer '%s' capture with up to %d frames in flight."), *GetName(), PipelineDepth);
+            }
+
+            ReleaseCaptureAtlases();
+            if (bUseCaptureAtlas)
+            {
+                // NOTE: The tiles of an atlas have a fixed size, they can't hold the cropped images
+                if (RegionOfInterestSettings.bEnabled)
+                {
+                    UE_LOG(LogNVSceneCapturer, Warning, TEXT("Capturer '%s' doesn't use the capture atlas since the images are cropped to their region of interest."), *GetName());
+                }
+                else if (TiledCaptureSettings.bEnabled)
+                {
+                    UE_LOG(LogNVSceneCapturer, Warning, TEXT("Capturer '%s' doesn't use the capture atlas since the images are captured tile by tile."), *GetName());
+                }
+                else
+                {
+                    SetupCaptureAtlases();
+                }
+            }
+
             // Now we can start capture.
             UpdateCapturerSettings();
 
             OnStartedEvent.Broadcast(this);
             SceneDataHandler->OnStartCapturingSceneData();
 
-            GetWorldTimerManager().ClearTimer(TimeHandle_StartCapturingDelay);
-            TimeHandle_StartCapturingDelay.Invalidate();
-
             // Reset the counter and stats
             ResetCounter();
+            bCheckpointPending = false;
+            LastCheckpointFrameIndex = INDEX_NONE;
+            LastExportedFrameIndex = INDEX_NONE;
+            if (bResumeCapturing)
+            {
+                // Skip the frames which are already exported
+                LastCheckpointFrameIndex = ResumeCheckpoint.FrameIndex;
+                LastExportedFrameIndex = ResumeCheckpoint.FrameIndex;
+                CapturedFrameCounter.SetFrameCount(ResumeCheckpoint.FrameIndex + 1);
+                UE_LOG(LogNVSceneCapturer, Log, TEXT("Capturer '%s' resume capturing from frame %d at marker %d."),
+                       *GetName(), ResumeCheckpoint.FrameIndex + 1, ResumeCheckpoint.MarkerIndex);
+            }
             // bIsActive is public. we need to copy bIsActive state into the protected value.
             CurrentState = ENVSceneCapturerState::Running;
             // NOTE: Make it wait till the next frame to start exporting since the scene capturer only just start capturing now
@@ -470,6 +866,11 @@ void ANVSceneCapturerActor::StartCapturing_Internal()
             {
                 ViewpointComp->StartCapturing();
             }
+
+            if (CaptureFarmModeSettings.bEnabled)
+            {
+                CaptureFarmMode.Enter(GetWorld(), CaptureFarmModeSettings);
+            }
         }
     }
 }
@@ -479,14 +880,20 @@ void ANVSceneCapturerActor::StopCapturing()
     ensure(CurrentState != ENVSceneCapturerState::NotActive);
     ensure(CurrentState != ENVSceneCapturerState::Active);
 
-    GetWorldTimerManager().ClearTimer(TimeHandle_StartCapturingDelay);
-    TimeHandle_StartCapturingDelay.Invalidate();
+    bWaitingToStartCapturing = false;
 
     for (UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
     {
         ViewpointComp->StopCapturing();
+        ViewpointComp->SetCaptureRegion(FIntRect());
     }
 
+    // Export the frames which are already captured before the data handler stop
+    FlushInFlightFrames();
+    FNVTextureReader::SetMaxPendingReadbackFrames(0);
+    ReleaseCaptureAtlases();
+    CaptureFarmMode.Exit(GetWorld());
+
     CurrentState = ENVSceneCapturerState::Active;
 
     OnStoppedEvent.Broadcast(this);
@@ -523,6 +930,10 @@ void ANVSceneCapturerActor::OnCompleted()
 
         UE_LOG(LogNVSceneCapturer, Warning, TEXT("Capturing completed!!!\nTotal capturing duration: %.6f\nStart time: %.6f\nCompleted time: %.6f"),
                CapturedDuration, StartCapturingTimestamp, CompletedCapturingTimestamp);
+        if (FrameVisibilitySettings.bEnabled)
+        {
+            UE_LOG(LogNVSceneCapturer, Log, TEXT("Capturer '%s' rejected %d frames without enough visible training objects."), *GetName(), RejectedFrameCount);
+        }
 
         for (UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
         {
@@ -530,6 +941,9 @@ void ANVSceneCapturerActor::OnCompleted()
         }
 
         CurrentState = ENVSceneCapturerState::Completed;
+        FNVTextureReader::SetMaxPendingReadbackFrames(0);
+        ReleaseCaptureAtlases();
+        CaptureFarmMode.Exit(GetWorld());
 
         if (SceneDataHandler)
         {
@@ -540,6 +954,112 @@ void ANVSceneCapturerActor::OnCompleted()
     }
 }
 
+void ANVSceneCapturerActor::SetupCaptureAtlases()
+{
+    // The scene capture components of the same feature extractor in different viewpoints render the same kind of image with the same pixel format
+    TMap<FString, TArray<UNVSceneCaptureComponent2D*>> AtlasTileGroups;
+    for (UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
+    {
+        if (!ViewpointComp || !ViewpointComp->IsEnabled())
+        {
+            continue;
+        }
+
+        for (UNVSceneFeatureExtractor* CheckFeatureExtractor : ViewpointComp->FeatureExtractorList)
+        {
+            const UNVSceneFeatureExtractor_PixelData* PixelDataFeatureExtractor = Cast<UNVSceneFeatureExtractor_PixelData>(CheckFeatureExtractor);
+            if (!PixelDataFeatureExtractor || !PixelDataFeatureExtractor->IsEnabled())
+            {
+                continue;
+            }
+
+            TArray<UNVSceneCaptureComponent2D*> SceneCaptureComponents;
+            PixelDataFeatureExtractor->GetSceneCaptureComponents(SceneCaptureComponents);
+            for (int32 i = 0; i < SceneCaptureComponents.Num(); i++)
+            {
+                const UNVSceneCaptureComponent2D* SceneCaptureComp = SceneCaptureComponents[i];
+                const FString TileGroupKey = FString::Printf(TEXT("%s.%s.%d.%d.%d"), *PixelDataFeatureExtractor->GetClass()->GetName(),
+                    *PixelDataFeatureExtractor->GetDisplayName(), i, (int32)SceneCaptureComp->TextureTargetFormat, (int32)SceneCaptureComp->OverrideTexturePixelFormat);
+                AtlasTileGroups.FindOrAdd(TileGroupKey).Add(SceneCaptureComponents[i]);
+            }
+        }
+    }
+
+    const int32 MaxAtlasWidth = (int32)GetMax2DTextureDimension();
+    for (const auto& AtlasTileGroup : AtlasTileGroups)
+    {
+        const TArray<UNVSceneCaptureComponent2D*>& TileSceneCaptureComponents = AtlasTileGroup.Value;
+        // NOTE: There's nothing to save when a feature extractor is only used by one viewpoint
+        if (TileSceneCaptureComponents.Num() < 2)
+        {
+            continue;
+        }
+
+        TSharedPtr<FNVSceneCaptureAtlas, ESPMode::ThreadSafe> NewCaptureAtlas = MakeShared<FNVSceneCaptureAtlas, ESPMode::ThreadSafe>();
+        TArray<int32> TileIndexes;
+        for (UNVSceneCaptureComponent2D* SceneCaptureComp : TileSceneCaptureComponents)
+        {
+            TileIndexes.Add(NewCaptureAtlas->AddTile(SceneCaptureComp->GetCapturedTextureSize()));
+        }
+        NewCaptureAtlas->FinalizeLayout(MaxAtlasWidth);
+
+        const FIntPoint& AtlasSize = NewCaptureAtlas->GetAtlasSize();
+        if ((AtlasSize.X > MaxAtlasWidth) || (AtlasSize.Y > MaxAtlasWidth))
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("The atlas of '%s' (%s) is too large, its images are read back separately."),
+                   *AtlasTileGroup.Key, *AtlasSize.ToString());
+            continue;
+        }
+
+        for (int32 i = 0; i < TileSceneCaptureComponents.Num(); i++)
+        {
+            TileSceneCaptureComponents[i]->SetCaptureAtlas(NewCaptureAtlas, TileIndexes[i]);
+        }
+        CaptureAtlases.Add(NewCaptureAtlas);
+
+        UE_LOG(LogNVSceneCapturer, Log, TEXT("Capturer '%s' read back %d images of '%s' with a %s atlas."),
+               *GetName(), NewCaptureAtlas->GetTileCount(), *AtlasTileGroup.Key, *AtlasSize.ToString());
+    }
+}
+
+void ANVSceneCapturerActor::ReleaseCaptureAtlases()
+{
+    if (CaptureAtlases.Num() == 0)
+    {
+        return;
+    }
+
+    int32 AtlasReadbackCount = 0;
+    for (const auto& CaptureAtlas : CaptureAtlases)
+    {
+        AtlasReadbackCount += CaptureAtlas->GetReadbackCount();
+    }
+    UE_LOG(LogNVSceneCapturer, Log, TEXT("Capturer '%s' read back %d atlases."), *GetName(), AtlasReadbackCount);
+
+    for (UNVSceneCapturerViewpointComponent* ViewpointComp : ViewpointList)
+    {
+        if (!ViewpointComp)
+        {
+            continue;
+        }
+
+        for (UNVSceneFeatureExtractor* CheckFeatureExtractor : ViewpointComp->FeatureExtractorList)
+        {
+            const UNVSceneFeatureExtractor_PixelData* PixelDataFeatureExtractor = Cast<UNVSceneFeatureExtractor_PixelData>(CheckFeatureExtractor);
+            if (PixelDataFeatureExtractor)
+            {
+                TArray<UNVSceneCaptureComponent2D*> SceneCaptureComponents;
+                PixelDataFeatureExtractor->GetSceneCaptureComponents(SceneCaptureComponents);
+                for (UNVSceneCaptureComponent2D* SceneCaptureComp : SceneCaptureComponents)
+                {
+                    SceneCaptureComp->SetCaptureAtlas(nullptr, INDEX_NONE);
+                }
+            }
+        }
+    }
+    CaptureAtlases.Reset();
+}
+
 bool ANVSceneCapturerActor::ToggleTakeOverViewport()
 {
     bTakingOverViewport = !bTakingOverViewport;
@@ -617,6 +1137,16 @@ float ANVSceneCapturerActor::GetCapturedDuration() const
     return CapturedDuration;
 }
 
+float ANVSceneCapturerActor::GetLastReadinessWaitDuration() const
+{
+    return LastReadinessWaitDuration;
+}
+
+int32 ANVSceneCapturerActor::GetRejectedFrameCount() const
+{
+    return RejectedFrameCount;
+}
+
 int32 ANVSceneCapturerActor::GetExportedFrameCount() const
 {
     UNVSceneDataExporter* CurrentSceneDataExporter = Cast<UNVSceneDataExporter>(SceneDataHandler);
@@ -699,5 +1229,141 @@ void ANVSceneCapturerActor::UpdateViewpointList()
 
 bool ANVSceneCapturerActor::CanHandleMoreSceneData() const
 {
-    return (SceneDataHandler && SceneDataHandler->CanHandleMoreData());
-}
\ No newline at end of file
+    return (SceneDataHandler && SceneDataHandler->CanHandleMoreData() && CapturePipeline.CanBeginFrame());
+}
+
+bool ANVSceneCapturerActor::LoadResumeCheckpoint(FNVCaptureCheckpoint& OutCheckpoint)
+{
+    // NOTE: The scene manager may ask for the checkpoint before this capturer begin play,
+    // make sure the output directory is already overridden by the command line
+    UpdateSettingsFromCommandLine();
+
+    const UNVSceneDataExporter* CurrentSceneDataExporter = Cast<UNVSceneDataExporter>(SceneDataHandler);
+    return CurrentSceneDataExporter && CurrentSceneDataExporter->LoadResumeCheckpoint(OutCheckpoint);
+}
+
+void ANVSceneCapturerActor::WriteCheckpoint()
+{
+    WriteCheckpoint(CapturedFrameCounter.GetTotalFrameCount() - 1, true);
+}
+
+void ANVSceneCapturerActor::WriteCheckpoint(int32 CheckpointFrameIndex, bool bWaitForPendingWrites)
+{
+    UNVSceneDataExporter* CurrentSceneDataExporter = Cast<UNVSceneDataExporter>(SceneDataHandler);
+    if (!CurrentSceneDataExporter || (CurrentSceneDataExporter->GetCheckpointFrameInterval() <= 0) || (CheckpointFrameIndex <= LastCheckpointFrameIndex))
+    {
+        return;
+    }
+
+    // NOTE: The state of a random stream can't be saved so the capturer's stream is re-seeded at each checkpoint,
+    // a session resumed from it generate the same seeds as if it never stopped
+    const int32 NewRandomSeed = CheckpointRandomStream.RandHelper(MAX_int32);
+    CheckpointRandomStream.Initialize(NewRandomSeed);
+    if (bReseedRandomAtCheckpoints)
+    {
+        FMath::RandInit(NewRandomSeed);
+        FMath::SRandInit(NewRandomSeed);
+    }
+
+    if (CurrentSceneDataExporter->WriteCheckpoint(CheckpointFrameIndex, GetCurrentMarkerIndex(), NewRandomSeed, bWaitForPendingWrites))
+    {
+        LastCheckpointFrameIndex = CheckpointFrameIndex;
+    }
+}
+
+void ANVSceneCapturerActor::DrainAndCheckpoint()
+{
+    if ((CurrentState != ENVSceneCapturerState::Running) && (CurrentState != ENVSceneCapturerState::Paused))
+    {
+        return;
+    }
+
+    FlushInFlightFrames();
+
+    const double DrainStartTime = FPlatformTime::Seconds();
+    while (SceneDataHandler && SceneDataHandler->IsHandlingData())
+    {
+        if (FPlatformTime::Seconds() - DrainStartTime > ShutdownDrainTimeout)
+        {
+            // The frames after the last fully exported one are captured again when the capturing is resumed
+            UE_LOG(LogNVSceneCapturer, Error, TEXT("Capturer '%s' can't finish exporting the captured data in %.1f seconds, the checkpoint is written for frame %d instead of %d."),
+                   *GetName(), ShutdownDrainTimeout, LastExportedFrameIndex, CapturedFrameCounter.GetTotalFrameCount() - 1);
+            WriteCheckpoint(LastExportedFrameIndex, false);
+            return;
+        }
+        FPlatformProcess::Sleep(0.01f);
+    }
+
+    WriteCheckpoint();
+}
+
+void ANVSceneCapturerActor::UpdateLastExportedFrame()
+{
+    if ((CapturePipeline.GetInFlightFrameCount() == 0) && (!SceneDataHandler || !SceneDataHandler->IsHandlingData()))
+    {
+        LastExportedFrameIndex = CapturedFrameCounter.GetTotalFrameCount() - 1;
+    }
+}
+
+int32 ANVSceneCapturerActor::GetCurrentMarkerIndex() const
+{
+    const ANVSceneManager* NVSceneManagerPtr = ANVSceneManager::GetANVSceneManagerPtr();
+    return NVSceneManagerPtr ? NVSceneManagerPtr->GetCurrentMarkerIndex() : 0;
+}
+
+int32 ANVSceneCapturerActor::GetInFlightFrameCount() const
+{
+    return CapturePipeline.GetInFlightFrameCount();
+}
+
+void ANVSceneCapturerActor::RetireCapturedFrames(bool bRetireAll)
+{
+    TArray<FNVCaptureFrameContextRef> RetiredFrames;
+    if (bRetireAll)
+    {
+        CapturePipeline.RetireAllFrames(RetiredFrames);
+    }
+    else
+    {
+        CapturePipeline.RetireCompletedFrames(RetiredFrames, FPlatformTime::Seconds(), MAX_InFlightFrameDuration);
+    }
+
+    if (!SceneDataHandler)
+    {
+        return;
+    }
+
+    for (const FNVCaptureFrameContextRef& RetiredFrame : RetiredFrames)
+    {
+        for (const FNVCapturedAnnotationData& CapturedAnnotation : RetiredFrame->Annotations)
+        {
+            UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor = CapturedAnnotation.FeatureExtractor.Get();
+            UNVSceneCapturerViewpointComponent* CapturedViewpoint = CapturedAnnotation.Viewpoint.Get();
+            const TSharedPtr<FJsonObject> CapturedData = CapturedAnnotation.GetAnnotationData();
+            if (CapturedFeatureExtractor && CapturedViewpoint && CapturedData.IsValid())
+            {
+                SceneDataHandler->HandleSceneAnnotationData(CapturedData,
+                        CapturedFeatureExtractor,
+                        CapturedViewpoint,
+                        RetiredFrame->FrameIndex);
+            }
+        }
+    }
+}
+
+void ANVSceneCapturerActor::FlushInFlightFrames()
+{
+    if (FNVTextureReader::GetMaxPendingReadbackFrames() > 0)
+    {
+        FNVTextureReader::FlushPendingReadbacks();
+    }
+    else
+    {
+        FlushRenderingCommands();
+    }
+
+    if (CapturePipeline.GetInFlightFrameCount() > 0)
+    {
+        RetireCapturedFrames(true);
+    }
+}
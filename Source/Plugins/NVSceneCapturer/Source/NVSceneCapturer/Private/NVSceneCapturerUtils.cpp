@@ -6,6 +6,7 @@
 
 #include "NVSceneCapturerModule.h"
 #include "NVSceneCapturerUtils.h"
+#include "NVFileSink.h"
 #include "Engine.h"
 #include "EngineUtils.h"
 #include "IImageWrapper.h"
@@ -15,6 +16,8 @@
 #include "JsonObjectConverter.h"
 #include "Json.h"
 #include "MeshVertexPainter/MeshVertexPainter.h"
+#include "NVMeshGeometry.h"
+#include "Components/InstancedStaticMeshComponent.h"
 
 
 // ✅ FIXED for UE5.5
@@ -350,7 +353,7 @@ namespace NVSceneCapturerUtils
         return nullptr;
     }
 
-    bool SaveJsonObjectToFile(const TSharedPtr<FJsonObject>& JsonObjData, const FString& Filename)
+    bool SaveJsonObjectToFile(const TSharedPtr<FJsonObject>& JsonObjData, const FString& Filename, INVFileSink* FileSink /*= nullptr*/)
     {
         bool bResult = false;
 
@@ -361,7 +364,11 @@ namespace NVSceneCapturerUtils
             bool bSuccess = FJsonSerializer::Serialize(JsonObjData.ToSharedRef(), JsonWriter);
             JsonWriter->Close();
 
-            if (!FFileHelper::SaveStringToFile(OutJsonString, *Filename))
+            if (FileSink)
+            {
+                bResult = FileSink->WriteFile(Filename, OutJsonString);
+            }
+            else if (!FFileHelper::SaveStringToFile(OutJsonString, *Filename))
             {
                 UE_LOG(LogNVSceneCapturer, Error, TEXT("Unable to open file for writing.  Check permissions. File is %s"), *Filename);
             }
@@ -751,46 +758,21 @@ namespace NVSceneCapturerUtils
             const UStaticMeshComponent* StaticMeshComp = Cast<UStaticMeshComponent>(MeshComp);
             if (StaticMeshComp)
             {
-                UStaticMesh* StaticMesh = StaticMeshComp->GetStaticMesh();
-                if (StaticMesh)
+                const UStaticMesh* StaticMesh = StaticMeshComp->GetStaticMesh();
+                // NOTE: The bounds of the mesh's vertexes are computed once per mesh (or baked in the mesh asset) and shared by all its instances
+                const FNVMeshGeometryData* MeshGeometry = FNVMeshGeometryCache::FindOrBuild(StaticMesh);
+                if (MeshGeometry)
                 {
                     // If the static mesh have body setup with its convex collision then use it
-                    // NOTE: This approach is a lot cheaper than checking all of the mesh's vertexes but the convex body set up may not as tight as the raw vertexes list itself
-                    if (bCheckMeshCollision && StaticMesh->GetBodySetup())
+                    // NOTE: The convex body set up may not as tight as the raw vertexes list itself
+                    if (bCheckMeshCollision && MeshGeometry->CollisionBounds.IsValid)
                     {
-                        const FKAggregateGeom& MeshGeom = StaticMesh->GetBodySetup()->AggGeom;
-                        for (const FKConvexElem& ConvexElem : MeshGeom.ConvexElems)
-                        {
-                            for (const FVector& CheckVertex : ConvexElem.VertexData)
-                            {
-                                LocalOOBB += CheckVertex;
-                            }
-                        }
+                        LocalOOBB = MeshGeometry->CollisionBounds;
                     }
-
-                    static const int MAX_VERTEXES_COUNT_MESH_FOR_BOUNDING_BOX = 1000;
-
-                    bool bHaveBodyVertexData = (LocalOOBB.IsValid != 0);
-                    // Otherwise use the mesh's raw triangle vertexes
-                    // NOTE: This approach is way slower than using the simplified collision especially with complicated mesh with a lot of vertexes
                     // Always fallback to use the Render Data if the mesh doesn't have correct body setup
-                    if (!bHaveBodyVertexData && StaticMesh->GetRenderData())
+                    else
                     {
-                        const FPositionVertexBuffer& MeshVertexBuffer = StaticMesh->GetRenderData()->LODResources[0].VertexBuffers.PositionVertexBuffer;
-                        const uint32 VertexesCount = MeshVertexBuffer.GetNumVertices();
-
-                        // Warn user when the mesh have a lot of vertexes since it can slow down the bounding box calculation
-                        if (VertexesCount > MAX_VERTEXES_COUNT_MESH_FOR_BOUNDING_BOX)
-                        {
-                            UE_LOG(LogNVSceneCapturer, VeryVerbose, TEXT("Mesh '%s' have '%d' vertexes => calculating the bounding box for it using its render data will be slow => Recommend generate simple collision for this mesh."),
-                                   *StaticMesh->GetName(), VertexesCount);
-                        }
-
-                        for (uint32 i = 0; i < VertexesCount; i++)
-                        {
-                            const FVector VertexPosition = (FVector)MeshVertexBuffer.VertexPosition(i);
-                            LocalOOBB += VertexPosition;
-                        }
+                        LocalOOBB = MeshGeometry->RenderBounds;
                     }
                 }
             }
@@ -837,30 +819,14 @@ namespace NVSceneCapturerUtils
             const UStaticMeshComponent* StaticMeshComp = Cast<UStaticMeshComponent>(MeshComp);
             if (StaticMeshComp)
             {
-                const UStaticMesh* StaticMesh = StaticMeshComp->GetStaticMesh();
-                if (StaticMesh)
+                // NOTE: This 'complex' approach calculate the OOBB base on 'Principal Component Analysis':
+                // http://www.inf.fu-berlin.de/users/rote/Papers/pdf/On+the+bounding+boxes+obtained+by+principal+component+analysis.pdf
+                // The PCA frame doesn't maintain the direction of the cuboid (front-face may be different from the mesh's one)
+                const FNVMeshGeometryData* MeshGeometry = FNVMeshGeometryCache::FindOrBuild(StaticMeshComp->GetStaticMesh());
+                if (MeshGeometry && MeshGeometry->PCABounds.IsValid)
                 {
-                    // If the static mesh have body setup with its convex collision then use it
-                    if (StaticMesh->GetBodySetup())
-                    {
-                        const FKAggregateGeom& MeshGeom = StaticMesh->GetBodySetup()->AggGeom;
-                        for (const FKConvexElem& ConvexElem : MeshGeom.ConvexElems)
-                        {
-                            BoundingVertexes.Append(ConvexElem.VertexData);
-                        }
-                    }
-                    // Otherwise use the mesh's raw triangle vertexes
-                    else if (StaticMesh->GetRenderData())
-                    {
-                        const FPositionVertexBuffer& MeshVertexBuffer = StaticMesh->GetRenderData()->LODResources[0].VertexBuffers.PositionVertexBuffer;
-                        const uint32 VertexesCount = MeshVertexBuffer.GetNumVertices();
-                        BoundingVertexes.Reserve(BoundingVertexes.Num() + VertexesCount);
-                        for (uint32 i = 0; i < VertexesCount; i++)
-                        {
-                            const FVector VertexPosition = (FVector)MeshVertexBuffer.VertexPosition(i);
-                            BoundingVertexes.Add(VertexPosition);
-                        }
-                    }
+                    const FTransform PCATransform(MeshGeometry->GetPCAMatrix());
+                    MeshOOCuboid.BuildFromOOBB(MeshGeometry->PCABounds, PCATransform * MeshTransform);
                 }
             }
             else
@@ -936,4 +902,77 @@ namespace NVSceneCapturerUtils
 
         return ActorCuboidOOBB;
     }
+
+    //================================== Instanced static meshes ==================================
+    void GetExportedMeshInstanceComponents(const AActor* CheckActor, TArray<UInstancedStaticMeshComponent*>& OutComponents)
+    {
+        OutComponents.Reset();
+
+        const UNVCapturableActorTag* Tag = CheckActor ? CheckActor->FindComponentByClass<UNVCapturableActorTag>() : nullptr;
+        if (!Tag || !Tag->bExportMeshInstances)
+        {
+            return;
+        }
+
+        // NOTE: UHierarchicalInstancedStaticMeshComponent is a UInstancedStaticMeshComponent too
+        TArray<UInstancedStaticMeshComponent*> InstancedMeshComps;
+        CheckActor->GetComponents(InstancedMeshComps);
+        for (UInstancedStaticMeshComponent* CheckComp : InstancedMeshComps)
+        {
+            if (CheckComp && CheckComp->IsVisible() && CheckComp->GetStaticMesh() && (CheckComp->GetInstanceCount() > 0))
+            {
+                OutComponents.Add(CheckComp);
+            }
+        }
+    }
+
+    FString GetMeshInstanceName(const AActor* OwnerActor, const UInstancedStaticMeshComponent* InstancedMeshComp, int32 InstanceIndex)
+    {
+        return FString::Printf(TEXT("%s.%s_%d"), OwnerActor ? *OwnerActor->GetName() : TEXT("None"),
+                               InstancedMeshComp ? *InstancedMeshComp->GetName() : TEXT("None"), InstanceIndex);
+    }
+
+    FNVCuboidData GetMeshInstanceCuboid(const FNVMeshGeometryData& MeshGeometry, const FTransform& InstanceTransform, ENVBoundsGenerationType BoundsType)
+    {
+        FNVCuboidData InstanceCuboid;
+
+        // NOTE: All the instances share the geometry of their mesh, only their transform differ
+        switch (BoundsType)
+        {
+            case ENVBoundsGenerationType::VE_AABB:
+                InstanceCuboid.BuildFromAABB(MeshGeometry.RenderBounds.TransformBy(InstanceTransform));
+                break;
+            case ENVBoundsGenerationType::VE_TightOOBB:
+                if (MeshGeometry.PCABounds.IsValid)
+                {
+                    InstanceCuboid.BuildFromOOBB(MeshGeometry.PCABounds, FTransform(MeshGeometry.GetPCAMatrix()) * InstanceTransform);
+                }
+                break;
+            default:
+                // NOTE: Same as the actors' OOBB, which doesn't check the mesh collision
+                InstanceCuboid.BuildFromOOBB(MeshGeometry.RenderBounds, InstanceTransform);
+                break;
+        }
+        return InstanceCuboid;
+    }
+
+    bool CanStoreMeshInstanceMaskColor(const UInstancedStaticMeshComponent* InstancedMeshComp, int32 CustomDataIndex)
+    {
+        return InstancedMeshComp && (CustomDataIndex >= 0) && (InstancedMeshComp->NumCustomDataFloats >= (CustomDataIndex + 3));
+    }
+
+    bool SetMeshInstanceMaskColor(UInstancedStaticMeshComponent* InstancedMeshComp, int32 InstanceIndex, int32 CustomDataIndex, const FColor& MaskColor)
+    {
+        // NOTE: The custom data layout belongs to the component's owner, resizing it would shift or drop the values its material reads
+        if (!CanStoreMeshInstanceMaskColor(InstancedMeshComp, CustomDataIndex))
+        {
+            return false;
+        }
+
+        // NOTE: The render state is only marked dirty once, after the last channel
+        InstancedMeshComp->SetCustomDataValue(InstanceIndex, CustomDataIndex, MaskColor.R / 255.f, false);
+        InstancedMeshComp->SetCustomDataValue(InstanceIndex, CustomDataIndex + 1, MaskColor.G / 255.f, false);
+        InstancedMeshComp->SetCustomDataValue(InstanceIndex, CustomDataIndex + 2, MaskColor.B / 255.f, true);
+        return true;
+    }
 }
@@ -8,6 +8,8 @@
 #include "NVSceneCapturerViewpointComponent.h"
 #include "NVSceneFeatureExtractor.h"
 #include "NVSceneCapturerActor.h"
+#include "NVSceneCaptureComponent2D.h"
+#include "EngineUtils.h"
 
 #include "UObject/ConstructorHelpers.h"
 #include "Components/StaticMeshComponent.h"
@@ -49,6 +51,7 @@ void UNVSceneCapturerViewpointComponent::SetupFeatureExtractors()
                     ExtractorClass, NewExtractorName, EObjectFlags::RF_Transient, FeatureExtractor);
             if (NewSubFeatureExtractor)
             {
+                NewSubFeatureExtractor->SetCaptureCadence(CheckFeatureExtractorSetting.CaptureCadence, FObjectKey(FeatureExtractor));
                 NewSubFeatureExtractor->Init(this);
             }
         }
@@ -121,7 +124,8 @@ bool UNVSceneCapturerViewpointComponent::CaptureSceneToPixelsData(UNVSceneCaptur
         for (auto SceneFeatureExtractor : FeatureExtractorList)
         {
             UNVSceneFeatureExtractor_PixelData* FeatureExtractorScenePixels = Cast<UNVSceneFeatureExtractor_PixelData>(SceneFeatureExtractor);
-            if (FeatureExtractorScenePixels)
+            // NOTE: The feature extractors which are not due this frame don't render nor read back anything
+            if (FeatureExtractorScenePixels && FeatureExtractorScenePixels->IsScheduledToCapture())
             {
                 bResults = bResults && FeatureExtractorScenePixels->CaptureSceneToPixelsData(
                                [this, Callback = ViewpointCallback](const FNVTexturePixelData& CapturedPixelData, UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor)
@@ -135,31 +139,230 @@ bool UNVSceneCapturerViewpointComponent::CaptureSceneToPixelsData(UNVSceneCaptur
     return bResults;
 }
 
-bool UNVSceneCapturerViewpointComponent::CaptureSceneAnnotationData(UNVSceneCapturerViewpointComponent::OnFinishedCaptureSceneAnnotationDataCallback ViewpointCallback)
+int32 UNVSceneCapturerViewpointComponent::CaptureSceneTilesToPixelsData(UNVSceneCapturerViewpointComponent::OnFinishedCaptureSceneTileCallback ViewpointCallback)
 {
-	bool bResults = false;
-	ensure(ViewpointCallback);
+    int32 CapturedTileCount = 0;
+
+    ensure(ViewpointCallback);
     if (!ViewpointCallback)
     {
         UE_LOG(LogNVSceneCapturerViewpointComponent, Error, TEXT("invalid argument."));
     }
     else
     {
-		bResults = true;
-		for (auto SceneFeatureExtractor : FeatureExtractorList)
+        // NOTE: The tiles are built for each capture since the field of view can be randomized between the frames
+        TArray<FNVCaptureTile> CaptureTiles;
+        FNVTiledCapture::BuildTiles(GetProjectionMatrix(), GetCapturerSettings().CapturedImageSize.ConvertToIntPoint(),
+                                    TiledCaptureSettings.MaxTileSize, CaptureTiles);
+
+        // NOTE: A feature extractor which can't capture all its tiles mustn't stop the next ones from capturing theirs
+        for (auto SceneFeatureExtractor : FeatureExtractorList)
         {
-            UNVSceneFeatureExtractor_AnnotationData* FeatureExtractorAnnotationData = Cast<UNVSceneFeatureExtractor_AnnotationData>(SceneFeatureExtractor);
-            if (FeatureExtractorAnnotationData)
+            UNVSceneFeatureExtractor_PixelData* FeatureExtractorScenePixels = Cast<UNVSceneFeatureExtractor_PixelData>(SceneFeatureExtractor);
+            if (FeatureExtractorScenePixels && FeatureExtractorScenePixels->IsScheduledToCapture())
             {
-				bResults = bResults && FeatureExtractorAnnotationData->CaptureSceneAnnotationData(
-                               [this, Callback = ViewpointCallback](TSharedPtr<FJsonObject> CapturedData, UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor)
+                CapturedTileCount += FeatureExtractorScenePixels->CaptureSceneTilesToPixelsData(CaptureTiles,
+                               [this, Callback = ViewpointCallback](const FNVTexturePixelData& CapturedPixelData, const FNVCaptureTile& CapturedTile, UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor)
                 {
-                    Callback(CapturedData, CapturedFeatureExtractor, this);
+                    Callback(CapturedPixelData, CapturedTile, CapturedFeatureExtractor, this);
                 });
             }
         }
     }
-    return bResults;
+
+    return CapturedTileCount;
+}
+
+int32 UNVSceneCapturerViewpointComponent::GetCapturedPixelsDataCount() const
+{
+    int32 CapturedPixelsDataCount = 0;
+    for (const auto SceneFeatureExtractor : FeatureExtractorList)
+    {
+        const UNVSceneFeatureExtractor_PixelData* FeatureExtractorScenePixels = Cast<UNVSceneFeatureExtractor_PixelData>(SceneFeatureExtractor);
+        if (FeatureExtractorScenePixels && FeatureExtractorScenePixels->IsScheduledToCapture())
+        {
+            CapturedPixelsDataCount += FeatureExtractorScenePixels->GetCapturedPixelsDataCount();
+        }
+    }
+
+    if (IsTiledCapture())
+    {
+        const FIntPoint GridSize = FNVTiledCapture::CalculateGridSize(GetCapturerSettings().CapturedImageSize.ConvertToIntPoint(), TiledCaptureSettings.MaxTileSize);
+        CapturedPixelsDataCount *= GridSize.X * GridSize.Y;
+    }
+    return CapturedPixelsDataCount;
+}
+
+void UNVSceneCapturerViewpointComponent::SetTiledCaptureSettings(const FNVTiledCaptureSettings& NewTiledCaptureSettings)
+{
+    TiledCaptureSettings = NewTiledCaptureSettings;
+}
+
+bool UNVSceneCapturerViewpointComponent::IsTiledCapture() const
+{
+    if (!TiledCaptureSettings.bEnabled)
+    {
+        return false;
+    }
+
+    // The images which fit in one tile are captured as usual
+    const FIntPoint GridSize = FNVTiledCapture::CalculateGridSize(GetCapturerSettings().CapturedImageSize.ConvertToIntPoint(), TiledCaptureSettings.MaxTileSize);
+    return ((GridSize.X * GridSize.Y) > 1);
+}
+
+FIntPoint UNVSceneCapturerViewpointComponent::GetCapturedTextureSize() const
+{
+    const FIntPoint CapturedImageSize = GetCapturerSettings().CapturedImageSize.ConvertToIntPoint();
+    return IsTiledCapture() ? FNVTiledCapture::CalculateTileSize(CapturedImageSize, TiledCaptureSettings.MaxTileSize) : CapturedImageSize;
+}
+
+FMatrix UNVSceneCapturerViewpointComponent::GetProjectionMatrix() const
+{
+    const auto& CapturerSettings = GetCapturerSettings();
+    if (CapturerSettings.bUseExplicitCameraIntrinsic)
+    {
+        FCameraIntrinsicSettings CameraIntrinsicSettings = CapturerSettings.GetCameraIntrinsicSettings();
+        CameraIntrinsicSettings.UpdateSettings();
+        return CameraIntrinsicSettings.GetProjectionMatrix();
+    }
+
+    const FNVImageSize& CapturedImageSize = CapturerSettings.CapturedImageSize;
+    return UNVSceneCaptureComponent2D::BuildProjectionMatrix(CapturedImageSize, ECameraProjectionMode::Perspective,
+                                                             CapturerSettings.GetFOVAngle(), CapturedImageSize.Width);
+}
+
+bool UNVSceneCapturerViewpointComponent::CaptureSceneAnnotationData(UNVSceneCapturerViewpointComponent::OnFinishedCaptureSceneAnnotationDataCallback ViewpointCallback)
+{
+	ensure(ViewpointCallback);
+    if (!ViewpointCallback)
+    {
+        UE_LOG(LogNVSceneCapturerViewpointComponent, Error, TEXT("invalid argument."));
+        return false;
+    }
+
+    // NOTE: Build the annotation data right away from the snapshots
+    return CaptureSceneAnnotationSnapshots(INDEX_NONE,
+                                           [Callback = ViewpointCallback](const FNVSceneAnnotationSnapshotRef& Snapshot, UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint)
+    {
+        TSharedPtr<FJsonObject> CapturedData = UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot.Get());
+        if (CapturedData.IsValid())
+        {
+            Callback(CapturedData, CapturedFeatureExtractor, CapturedViewpoint);
+        }
+    });
+}
+
+bool UNVSceneCapturerViewpointComponent::CaptureSceneAnnotationSnapshots(int32 FrameIndex, UNVSceneCapturerViewpointComponent::OnCapturedSceneAnnotationSnapshotCallback Callback)
+{
+    ensure(Callback);
+    if (!Callback)
+    {
+        UE_LOG(LogNVSceneCapturerViewpointComponent, Error, TEXT("invalid argument."));
+        return false;
+    }
+
+    for (auto SceneFeatureExtractor : FeatureExtractorList)
+    {
+        UNVSceneFeatureExtractor_AnnotationData* FeatureExtractorAnnotationData = Cast<UNVSceneFeatureExtractor_AnnotationData>(SceneFeatureExtractor);
+        if (FeatureExtractorAnnotationData && FeatureExtractorAnnotationData->IsScheduledToCapture())
+        {
+            const FNVSceneAnnotationSnapshotRef Snapshot = FeatureExtractorAnnotationData->CaptureSceneAnnotationSnapshot(FrameIndex);
+            // The annotation keep the full image's coordinates, the crop let them be matched with the cropped images
+            if (CaptureRegion.Area() > 0)
+            {
+                Snapshot->CaptureRegion = CaptureRegion;
+                Snapshot->FullImageSize = GetCapturerSettings().CapturedImageSize.ConvertToIntPoint();
+            }
+            Callback(Snapshot, FeatureExtractorAnnotationData, this);
+        }
+    }
+    return true;
+}
+
+void UNVSceneCapturerViewpointComponent::UpdateCaptureSchedule(int32 FrameIndex, const FNVCaptureCadenceDraws& CadenceDraws)
+{
+    for (auto SceneFeatureExtractor : FeatureExtractorList)
+    {
+        if (SceneFeatureExtractor)
+        {
+            SceneFeatureExtractor->UpdateCaptureSchedule(FrameIndex, CadenceDraws);
+        }
+    }
+}
+
+void UNVSceneCapturerViewpointComponent::GetScheduledFeatureExtractors(TArray<UNVSceneFeatureExtractor*>& OutFeatureExtractors) const
+{
+    OutFeatureExtractors.Reset(FeatureExtractorList.Num());
+    for (auto SceneFeatureExtractor : FeatureExtractorList)
+    {
+        if (SceneFeatureExtractor && SceneFeatureExtractor->IsScheduledToCapture())
+        {
+            OutFeatureExtractors.Add(SceneFeatureExtractor);
+        }
+    }
+}
+
+FIntRect UNVSceneCapturerViewpointComponent::CalculateRegionOfInterest(const FNVRegionOfInterestSettings& RegionOfInterestSettings) const
+{
+    const FMatrix ViewProjectionMatrix = UNVSceneCaptureComponent2D::BuildViewProjectionMatrix(GetComponentTransform(), GetProjectionMatrix());
+
+    TArray<FBox> ObjectBounds;
+    GetTrainingObjectBounds(ObjectBounds);
+
+    return FNVCaptureRegion::CalculateRegionOfInterest(ObjectBounds, ViewProjectionMatrix, GetCapturerSettings().CapturedImageSize.ConvertToIntPoint(),
+                                                       RegionOfInterestSettings.Padding, RegionOfInterestSettings.SnapSize);
+}
+
+void UNVSceneCapturerViewpointComponent::GetTrainingObjectBounds(TArray<FBox>& OutObjectBounds) const
+{
+    OutObjectBounds.Reset();
+    UWorld* World = GetWorld();
+    if (!World)
+    {
+        return;
+    }
+
+    for (TActorIterator<AActor> ActorIt(World); ActorIt; ++ActorIt)
+    {
+        const AActor* CheckActor = *ActorIt;
+        if (!CheckActor || CheckActor->IsHidden())
+        {
+            continue;
+        }
+        const UNVCapturableActorTag* Tag = Cast<UNVCapturableActorTag>(CheckActor->GetComponentByClass(UNVCapturableActorTag::StaticClass()));
+        if (!Tag || !Tag->bIncludeMe)
+        {
+            continue;
+        }
+
+        const FBox ActorBounds = CheckActor->GetComponentsBoundingBox(true);
+        if (ActorBounds.IsValid)
+        {
+            OutObjectBounds.Add(ActorBounds);
+        }
+    }
+}
+
+bool UNVSceneCapturerViewpointComponent::HasEnoughVisibleTrainingObjects(const FNVFrameVisibilitySettings& FrameVisibilitySettings, const TArray<FBox>& ObjectBounds) const
+{
+    const FMatrix ViewProjectionMatrix = UNVSceneCaptureComponent2D::BuildViewProjectionMatrix(GetComponentTransform(), GetProjectionMatrix());
+    return FNVFrameVisibilityFilter::HasEnoughVisibleObjects(FrameVisibilitySettings, ViewProjectionMatrix, ObjectBounds);
+}
+
+void UNVSceneCapturerViewpointComponent::SetCaptureRegion(const FIntRect& NewCaptureRegion)
+{
+    // Capturing the whole image doesn't need a crop
+    const FIntRect FullImageRegion(FIntPoint::ZeroValue, GetCapturerSettings().CapturedImageSize.ConvertToIntPoint());
+    CaptureRegion = (NewCaptureRegion == FullImageRegion) ? FIntRect() : NewCaptureRegion;
+
+    for (auto SceneFeatureExtractor : FeatureExtractorList)
+    {
+        UNVSceneFeatureExtractor_PixelData* FeatureExtractorScenePixels = Cast<UNVSceneFeatureExtractor_PixelData>(SceneFeatureExtractor);
+        if (FeatureExtractorScenePixels)
+        {
+            FeatureExtractorScenePixels->SetReadbackRegion(CaptureRegion);
+        }
+    }
 }
 
 void UNVSceneCapturerViewpointComponent::StartCapturing()
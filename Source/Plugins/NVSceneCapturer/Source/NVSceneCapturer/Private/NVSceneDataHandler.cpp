@@ -10,11 +10,14 @@
 #include "NVImageExporter.h"
 #include "NVSceneCapturerViewpointComponent.h"
 #include "NVSceneFeatureExtractor.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+#include "NVSceneFeatureExtractor_ImageExport.h"
 #include "NVSceneCapturerActor.h"
 #include "NVAnnotatedActor.h"
 #include "NVSceneManager.h"
 #include "Engine.h"
 #include "JsonObjectConverter.h"
+#include "Async/Async.h"
 #if WITH_EDITOR
 #include "Factories/FbxAssetImportData.h"
 #include "UnrealEdGlobals.h"
@@ -34,42 +37,365 @@ UNVSceneDataExporter::UNVSceneDataExporter() : Super(),
     bUseMapNameForCapturedDirectory = true;
     bAutoOpenExportedDirectory = false;
     MaxSaveImageAsyncCount = 100;
+    MaxFileWriteInFlightCount = 256;
+    FramesPerSubFolder = 0;
+    PreCreatedSubFolderCount = 8;
+    CreatedSubFolderStart = 0;
+    CreatedSubFolderEnd = 0;
+    SubFolderCreationTaskEnd = 0;
+    bSkipDuplicateFrames = false;
+    DuplicateFrameHistoryCount = 4;
+    DuplicateFrameHashThreshold = 4;
+    CheckpointFrameInterval = 0;
+    bResumingCapture = false;
+    bExportFrameManifest = true;
+    bExportSequenceAnnotation = false;
+    AnnotationCompressionMode = ENVAnnotationCompressionMode::None;
+    AnnotationCompressionFormat = ENVAnnotationCompressionFormat::Oodle;
+    CompressedStreamFramesPerFile = 1000;
+    CompressedStreamBlockSizeKB = 256;
+    CompressedDictionaryTrainingFrameCount = 100;
 }
 
 bool UNVSceneDataExporter::CanHandleMoreData() const
 {
     return ImageExporterThread &&
-            ((MaxSaveImageAsyncCount <= 0) || (ImageExporterThread->GetPendingImagesCount() <= MaxSaveImageAsyncCount / 2));
+            ((MaxSaveImageAsyncCount <= 0) || (ImageExporterThread->GetPendingImagesCount() <= MaxSaveImageAsyncCount / 2)) &&
+            (!FileSink.IsValid() || (MaxFileWriteInFlightCount <= 0) || (FileSink->GetInFlightCount() < MaxFileWriteInFlightCount));
 }
 
 bool UNVSceneDataExporter::IsHandlingData() const
 {
-    return ImageExporterThread && ImageExporterThread->IsExportingImage();
+    return (ImageExporterThread && ImageExporterThread->IsExportingImage())
+           || (InstanceMaskAnnotationMerger.IsValid() && InstanceMaskAnnotationMerger->IsHandlingData())
+           || (FileSink.IsValid() && (FileSink->GetInFlightCount() > 0))
+           || (PendingTiledImageWriteCount.GetValue() > 0);
 }
 
 bool UNVSceneDataExporter::HandleScenePixelsData(const FNVTexturePixelData& CapturedPixelData, UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex)
+{
+    const FObjectKey ViewpointKey(CapturedViewpoint);
+    const FObjectKey* CheckExtractorKey = DuplicateFrameFilter.IsValid() ? DuplicateFrameCheckExtractorMap.Find(ViewpointKey) : nullptr;
+    if (CheckExtractorKey && CapturedFeatureExtractor)
+    {
+        const FNVDuplicateFrameFilter::FFrameKey FrameKey(ViewpointKey, FrameIndex);
+        ENVDuplicateFrameDecision Decision = ENVDuplicateFrameDecision::Pending;
+        if (*CheckExtractorKey == FObjectKey(CapturedFeatureExtractor))
+        {
+            // NOTE: The data of this frame which were held back are exported by the filter if the frame is accepted
+            Decision = DuplicateFrameFilter->CheckFrame(FrameKey, CapturedPixelData, CapturedViewpoint->GetDisplayName());
+        }
+        else
+        {
+            Decision = DuplicateFrameFilter->ConsumeDecision(FrameKey);
+            if (Decision == ENVDuplicateFrameDecision::Pending)
+            {
+                // The color image of this frame is not checked yet, keep a copy of the data until it is
+                Decision = DuplicateFrameFilter->DeferUntilChecked(FrameKey,
+                    [this, CapturedPixelData, CapturedFeatureExtractor, CapturedViewpoint, FrameIndex]()
+                {
+                    ExportScenePixelsData(CapturedPixelData, CapturedFeatureExtractor, CapturedViewpoint, FrameIndex);
+                });
+                return true;
+            }
+        }
+
+        if (Decision == ENVDuplicateFrameDecision::Dropped)
+        {
+            return true;
+        }
+    }
+
+    return ExportScenePixelsData(CapturedPixelData, CapturedFeatureExtractor, CapturedViewpoint, FrameIndex);
+}
+
+bool UNVSceneDataExporter::HandleSceneAnnotationData(const TSharedPtr<FJsonObject>& CapturedData, class UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor, class UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex)
+{
+    const FObjectKey ViewpointKey(CapturedViewpoint);
+    if (DuplicateFrameFilter.IsValid() && DuplicateFrameCheckExtractorMap.Contains(ViewpointKey))
+    {
+        const FNVDuplicateFrameFilter::FFrameKey FrameKey(ViewpointKey, FrameIndex);
+        ENVDuplicateFrameDecision Decision = DuplicateFrameFilter->ConsumeDecision(FrameKey);
+        if (Decision == ENVDuplicateFrameDecision::Pending)
+        {
+            // NOTE: The annotation data is usually captured before the color image of the same frame is read back
+            Decision = DuplicateFrameFilter->DeferUntilChecked(FrameKey,
+                [this, CapturedData, CapturedFeatureExtractor, CapturedViewpoint, FrameIndex]()
+            {
+                ExportSceneAnnotationData(CapturedData, CapturedFeatureExtractor, CapturedViewpoint, FrameIndex);
+            });
+            return true;
+        }
+
+        if (Decision == ENVDuplicateFrameDecision::Dropped)
+        {
+            return true;
+        }
+    }
+
+    return ExportSceneAnnotationData(CapturedData, CapturedFeatureExtractor, CapturedViewpoint, FrameIndex);
+}
+
+void UNVSceneDataExporter::HandleFrameSchedule(const TArray<UNVSceneFeatureExtractor*>& ScheduledFeatureExtractors, UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex)
+{
+    if (!CapturedViewpoint)
+    {
+        return;
+    }
+
+    const FObjectKey ViewpointKey(CapturedViewpoint);
+    const FObjectKey* CheckExtractorKey = DuplicateFrameFilter.IsValid() ? DuplicateFrameCheckExtractorMap.Find(ViewpointKey) : nullptr;
+    const FString OutputDirectoryPath = FullOutputDirectoryPath / TEXT("");
+    // NOTE: The tiled images are never held in memory as a whole so they can't be checked for duplication nor merged with the annotation data
+    const bool bIsTiledCapture = CapturedViewpoint->IsTiledCapture();
+    bool bDuplicateCheckScheduled = false;
+    bool bInstanceMaskScheduled = false;
+    // Number of the scheduled data which go through the duplicate frame filter, beside the checked color image
+    int32 FilteredDataCount = 0;
+    const UNVSceneFeatureExtractor_VertexColorMask* ClassRemapFeatureExtractor = nullptr;
+    TArray<TPair<FString, FString>> ExportedFiles;
+    for (UNVSceneFeatureExtractor* ScheduledFeatureExtractor : ScheduledFeatureExtractors)
+    {
+        if (!ScheduledFeatureExtractor || !ScheduledFeatureExtractor->IsEnabled())
+        {
+            continue;
+        }
+
+        const bool bIsDuplicateCheck = (!bIsTiledCapture && CheckExtractorKey && (*CheckExtractorKey == FObjectKey(ScheduledFeatureExtractor)));
+        bDuplicateCheckScheduled |= bIsDuplicateCheck;
+        bInstanceMaskScheduled |= (!bIsTiledCapture && ScheduledFeatureExtractor->IsA<UNVSceneFeatureExtractor_VertexColorMask>());
+        if (!bIsDuplicateCheck && (ScheduledFeatureExtractor->IsA<UNVSceneFeatureExtractor_AnnotationData>()
+                                   || (!bIsTiledCapture && ScheduledFeatureExtractor->IsA<UNVSceneFeatureExtractor_PixelData>())))
+        {
+            FilteredDataCount++;
+        }
+
+        const UNVSceneFeatureExtractor_VertexColorMask* InstanceMaskFeatureExtractor = Cast<UNVSceneFeatureExtractor_VertexColorMask>(ScheduledFeatureExtractor);
+        if (!bIsTiledCapture && InstanceMaskFeatureExtractor && InstanceMaskFeatureExtractor->ShouldExportClassSegmentationMask())
+        {
+            ClassRemapFeatureExtractor = InstanceMaskFeatureExtractor;
+        }
+
+        if (FrameManifest.IsOpen())
+        {
+            static const FString JsonExtension = TEXT(".json");
+            const bool bIsPixelData = ScheduledFeatureExtractor->IsA<UNVSceneFeatureExtractor_PixelData>();
+            const bool bIsAnnotationData = ScheduledFeatureExtractor->IsA<UNVSceneFeatureExtractor_AnnotationData>();
+            FString ExportFilePath = bIsAnnotationData ? GetAnnotationExportFilePath(ScheduledFeatureExtractor, CapturedViewpoint, FrameIndex) :
+                                     GetExportFilePath(ScheduledFeatureExtractor, CapturedViewpoint, FrameIndex,
+                                                       bIsPixelData ? GetExportImageExtension(ENVImageFormat::PNG) : JsonExtension);
+            FPaths::MakePathRelativeTo(ExportFilePath, *OutputDirectoryPath);
+            ExportedFiles.Add(TPair<FString, FString>(ScheduledFeatureExtractor->GetDisplayName(), ExportFilePath));
+            if (ClassRemapFeatureExtractor && (ClassRemapFeatureExtractor == ScheduledFeatureExtractor))
+            {
+                ExportedFiles.Add(TPair<FString, FString>(ScheduledFeatureExtractor->GetDisplayName() + TEXT("_class"),
+                                                          ClassRemapFeatureExtractor->GetClassSegmentationMaskFilePath(ExportFilePath)));
+            }
+        }
+    }
+
+    // Keep the lookup table of the scene the frame is captured in, the scene may change before its instance mask is read back
+    if (ClassRemapFeatureExtractor)
+    {
+        ANVSceneManager* SceneManager = ANVSceneManager::GetANVSceneManagerPtr();
+        TSharedPtr<const FNVInstanceClassLUT, ESPMode::ThreadSafe> InstanceClassLUT = SceneManager ? SceneManager->ObjectInstanceSegmentation.GetInstanceClassLUT() : nullptr;
+        if (InstanceClassLUT.IsValid())
+        {
+            FScopeLock Lock(&FrameInstanceClassLUTLock);
+            FrameInstanceClassLUTMap.Add(TPair<FObjectKey, int32>(ViewpointKey, FrameIndex), InstanceClassLUT);
+        }
+        else
+        {
+            UE_LOG(LogNVSceneDataHandler, Warning, TEXT("Viewpoint '%s' doesn't have any instance to class lookup table, its class segmentation mask can't be exported."),
+                   *CapturedViewpoint->GetDisplayName());
+        }
+    }
+
+    // The data of the frame mustn't wait for the images which are not captured
+    const FNVDuplicateFrameFilter::FFrameKey FrameKey(ViewpointKey, FrameIndex);
+    if (CheckExtractorKey)
+    {
+        // The frame entry of the manifest is held back with the data of the frame
+        const bool bDeferFrameEntry = FrameManifest.IsOpen() && bDuplicateCheckScheduled;
+        DuplicateFrameFilter->ExpectFrameData(FrameKey, FilteredDataCount + (bDeferFrameEntry ? 1 : 0));
+        if (!bDuplicateCheckScheduled)
+        {
+            DuplicateFrameFilter->AcceptFrameUnchecked(FrameKey);
+        }
+    }
+    if (InstanceMaskAnnotationMerger.IsValid() && !bInstanceMaskScheduled && ShouldMergeInstanceMask(CapturedViewpoint))
+    {
+        InstanceMaskAnnotationMerger->SkipInstanceMask(FrameKey);
+    }
+
+    if (FrameManifest.IsOpen())
+    {
+        TFunction<void()> AppendFrameEntryAction = [this, FrameIndex, ViewpointName = CapturedViewpoint->GetDisplayName(), ExportedFiles]()
+        {
+            FrameManifest.AppendFrameEntry(FrameIndex, ViewpointName, ExportedFiles);
+        };
+
+        // NOTE: The duplicated frames which are dropped are not listed in the manifest
+        if (CheckExtractorKey && bDuplicateCheckScheduled)
+        {
+            DuplicateFrameFilter->DeferUntilChecked(FrameKey, MoveTemp(AppendFrameEntryAction));
+        }
+        else
+        {
+            AppendFrameEntryAction();
+        }
+    }
+}
+
+bool UNVSceneDataExporter::ExportScenePixelsData(const FNVTexturePixelData& CapturedPixelData, UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex)
 {
     bool bResult = false;
     if (ImageExporterThread && CapturedFeatureExtractor && CapturedViewpoint)
     {
 		ENVImageFormat ExportImageFormat = ENVImageFormat::PNG;
 
+        PrepareFrameSubFolders(FrameIndex);
+
         const FString NewExportFilePath = GetExportFilePath(CapturedFeatureExtractor, CapturedViewpoint, FrameIndex, GetExportImageExtension(ExportImageFormat));
-        ImageExporterThread->ExportImage(CapturedPixelData, NewExportFilePath, ExportImageFormat);
+
+        // The class mask is remapped from the instance mask by the exporting worker
+        TSharedPtr<const FNVInstanceClassLUT, ESPMode::ThreadSafe> InstanceClassLUT;
+        const UNVSceneFeatureExtractor_VertexColorMask* InstanceMaskFeatureExtractor = Cast<UNVSceneFeatureExtractor_VertexColorMask>(CapturedFeatureExtractor);
+        if (InstanceMaskFeatureExtractor && InstanceMaskFeatureExtractor->ShouldExportClassSegmentationMask())
+        {
+            FScopeLock Lock(&FrameInstanceClassLUTLock);
+            FrameInstanceClassLUTMap.RemoveAndCopyValue(TPair<FObjectKey, int32>(FObjectKey(CapturedViewpoint), FrameIndex), InstanceClassLUT);
+        }
+
+        if (InstanceClassLUT.IsValid())
+        {
+            ImageExporterThread->ExportInstanceMask(CapturedPixelData, NewExportFilePath, ExportImageFormat,
+                                                    InstanceClassLUT, InstanceMaskFeatureExtractor->GetClassSegmentationMaskFilePath(NewExportFilePath));
+        }
+        else
+        {
+            ImageExporterThread->ExportImage(CapturedPixelData, NewExportFilePath, ExportImageFormat);
+        }
+
+        // The instance mask is also used to calculate the visible bounding boxes of the annotation data in the same frame
+        if (InstanceMaskAnnotationMerger.IsValid() && CapturedFeatureExtractor->IsA<UNVSceneFeatureExtractor_VertexColorMask>()
+            && ShouldMergeInstanceMask(CapturedViewpoint))
+        {
+            const FNVInstanceMaskAnnotationMerger::FFrameKey FrameKey(FObjectKey(CapturedViewpoint), FrameIndex);
+            InstanceMaskAnnotationMerger->AddInstanceMask(FrameKey, CapturedPixelData);
+        }
         bResult = true;
     }
     return bResult;
 }
 
-bool UNVSceneDataExporter::HandleSceneAnnotationData(const TSharedPtr<FJsonObject>& CapturedData, class UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor, class UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex)
+bool UNVSceneDataExporter::HandleScenePixelsTile(const FNVTexturePixelData& TilePixelsData, const FNVCaptureTile& CapturedTile, UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex)
+{
+    if (!CapturedFeatureExtractor || !CapturedViewpoint)
+    {
+        return false;
+    }
+
+    PrepareFrameSubFolders(FrameIndex);
+
+    const FString NewExportFilePath = GetExportFilePath(CapturedFeatureExtractor, CapturedViewpoint, FrameIndex, GetExportImageExtension(ENVImageFormat::PNG));
+    TSharedPtr<FNVImageBandWriter, ESPMode::ThreadSafe> ImageWriter;
+    {
+        FScopeLock Lock(&TiledImageWriterLock);
+        ImageWriter = TiledImageWriterMap.FindRef(NewExportFilePath);
+        if (!ImageWriter.IsValid())
+        {
+            ImageWriter = MakeShared<FNVImageBandWriter, ESPMode::ThreadSafe>();
+            if (!ImageWriter->Init(NewExportFilePath, CapturedTile, TilePixelsData.PixelFormat))
+            {
+                return false;
+            }
+            TiledImageWriterMap.Add(NewExportFilePath, ImageWriter);
+        }
+    }
+
+    if (ImageWriter->AddTile(TilePixelsData, CapturedTile))
+    {
+        // Write the completed band on a background thread, the writer keep the bands in order
+        PendingTiledImageWriteCount.Increment();
+        Async(EAsyncExecution::ThreadPool, [this, ImageWriter]()
+        {
+            ImageWriter->WriteCompletedBands();
+            if (ImageWriter->IsCompleted())
+            {
+                FScopeLock Lock(&TiledImageWriterLock);
+                TiledImageWriterMap.Remove(ImageWriter->GetFilePath());
+            }
+            PendingTiledImageWriteCount.Decrement();
+        });
+    }
+    return true;
+}
+
+void UNVSceneDataExporter::ReleaseTiledImageWriters()
+{
+    FScopeLock Lock(&TiledImageWriterLock);
+    if (TiledImageWriterMap.Num() > 0)
+    {
+        UE_LOG(LogNVSceneDataHandler, Warning, TEXT("%d tiled images are released before all of their bands are written."), TiledImageWriterMap.Num());
+    }
+    TiledImageWriterMap.Reset();
+}
+
+bool UNVSceneDataExporter::ExportSceneAnnotationData(const TSharedPtr<FJsonObject>& CapturedData, UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex)
 {
     bool bResult = false;
     if (CapturedFeatureExtractor && CapturedViewpoint)
     {
         static const FString JsonExtension = TEXT(".json");
 
+        PrepareFrameSubFolders(FrameIndex);
+
         const FString NewExportFilePath = GetExportFilePath(CapturedFeatureExtractor, CapturedViewpoint, FrameIndex, JsonExtension);
-        return NVSceneCapturerUtils::SaveJsonObjectToFile(CapturedData, NewExportFilePath);
+
+        // In sequence mode the annotation data are written as a delta in the sequence file of the stream instead of their own json file,
+        // the compressed annotation data are written in the compressed stream file of the stream
+        FNVInstanceMaskAnnotationMerger::FExportAnnotationDataFunction ExportFunction = nullptr;
+        if (SequenceAnnotationWriter.IsOpen())
+        {
+            const FString SequenceFilePath = GetSequenceAnnotationFilePath(CapturedFeatureExtractor, CapturedViewpoint);
+            ExportFunction = [this, SequenceFilePath, FrameIndex](const TSharedPtr<FJsonObject>& AnnotationData)
+            {
+                SequenceAnnotationWriter.WriteFrame(SequenceFilePath, FrameIndex, AnnotationData);
+            };
+        }
+        else if (CompressedAnnotationStreamWriter.IsOpen())
+        {
+            const FString StreamFilePathPrefix = GetCompressedAnnotationStreamFilePathPrefix(CapturedFeatureExtractor, CapturedViewpoint);
+            ExportFunction = [this, StreamFilePathPrefix, FrameIndex](const TSharedPtr<FJsonObject>& AnnotationData)
+            {
+                CompressedAnnotationStreamWriter.WriteFrame(StreamFilePathPrefix, FrameIndex, AnnotationData);
+            };
+        }
+
+        if (CapturedFeatureExtractor->ShouldUseInstanceMaskBoundingBox())
+        {
+            if (InstanceMaskAnnotationMerger.IsValid() && ShouldMergeInstanceMask(CapturedViewpoint))
+            {
+                // Wait for the instance mask of this frame, the merger will export the annotation data
+                const FNVInstanceMaskAnnotationMerger::FFrameKey FrameKey(FObjectKey(CapturedViewpoint), FrameIndex);
+                const bool bExportImageCoordinateInPixel = CapturedFeatureExtractor->GetDataExportSettings().bExportImageCoordinateInPixel;
+                // NOTE: The mesh instances keep their projected bounding box, the instance mask only tell them apart if their material reads their custom data
+                ANVSceneManager* SceneManager = ANVSceneManager::GetANVSceneManagerPtr();
+                TSharedPtr<const TSet<uint32>, ESPMode::ThreadSafe> MeshInstanceIds = SceneManager ? SceneManager->ObjectInstanceSegmentation.GetMeshInstanceIds() : nullptr;
+                InstanceMaskAnnotationMerger->AddAnnotationData(FrameKey, CapturedData, NewExportFilePath, bExportImageCoordinateInPixel, ExportFunction, MeshInstanceIds);
+                return true;
+            }
+
+            UE_LOG(LogNVSceneDataHandler, Warning, TEXT("Viewpoint '%s' doesn't have any VertexColorMask feature extractor, can't calculate the visible bounding boxes."),
+                   *CapturedViewpoint->GetDisplayName());
+        }
+        if (ExportFunction)
+        {
+            ExportFunction(CapturedData);
+            return true;
+        }
+        return NVSceneCapturerUtils::SaveJsonObjectToFile(CapturedData, NewExportFilePath, FileSink.Get());
         bResult = true;
     }
     return bResult;
@@ -84,15 +410,41 @@ void UNVSceneDataExporter::OnStartCapturingSceneData()
         ImageExporterThread = nullptr;
     }
 
+    if (InstanceMaskAnnotationMerger.IsValid())
+    {
+        InstanceMaskAnnotationMerger->Flush();
+    }
+
+    // Use a new file sink for each session so its stats only cover the current session
+    if (FileSink.IsValid())
+    {
+        FileSink->Flush();
+    }
+    FileSink = INVFileSink::CreateFileSink(MaxFileWriteInFlightCount);
+
     if (!ImageExporterThread.IsValid())
     {
-        ImageExporterThread = TUniquePtr<FNVImageExporter_Thread>(new FNVImageExporter_Thread(ImageWrapperModule));
+        ImageExporterThread = TUniquePtr<FNVImageExporter_Thread>(new FNVImageExporter_Thread(ImageWrapperModule, FileSink));
     }
 
+    InstanceMaskAnnotationMerger = MakeShared<FNVInstanceMaskAnnotationMerger, ESPMode::ThreadSafe>(FileSink);
+    {
+        FScopeLock Lock(&FrameInstanceClassLUTLock);
+        FrameInstanceClassLUTMap.Reset();
+    }
+
+    if (DuplicateFrameFilter.IsValid())
+    {
+        DuplicateFrameFilter->Reset();
+    }
+    DuplicateFrameFilter = bSkipDuplicateFrames ?
+                           MakeShared<FNVDuplicateFrameFilter, ESPMode::ThreadSafe>(DuplicateFrameHistoryCount, DuplicateFrameHashThreshold) : nullptr;
+
     // Prepare the output directory before capturing
     FullOutputDirectoryPath = GetConfiguredOutputDirectoryPath();
     IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-    if (PlatformFile.DirectoryExists(*FullOutputDirectoryPath))
+    // NOTE: The files of the resumed session must be kept
+    if (!bResumingCapture && PlatformFile.DirectoryExists(*FullOutputDirectoryPath))
     {
         switch (DirectoryConflictHandleType)
         {
@@ -118,6 +470,219 @@ void UNVSceneDataExporter::OnStartCapturingSceneData()
     }
 
     ExportCapturerSettings();
+
+    const bool bWriteCaptureJournal = (CheckpointFrameInterval > 0);
+    FileSink->SetTrackWrittenFiles(bWriteCaptureJournal);
+    if (bWriteCaptureJournal)
+    {
+        CaptureJournal.Open(FullOutputDirectoryPath, bResumingCapture);
+    }
+    else
+    {
+        CaptureJournal.Close();
+    }
+
+    if (bExportFrameManifest)
+    {
+        FrameManifest.Open(FullOutputDirectoryPath, bResumingCapture);
+    }
+    else
+    {
+        FrameManifest.Close();
+    }
+
+    if (bExportSequenceAnnotation)
+    {
+        // Each capturing session is a sequence, the scene manager start a new session at each marker
+        ANVSceneManager* SceneManager = ANVSceneManager::GetANVSceneManagerPtr();
+        SequenceAnnotationWriter.Open(SceneManager ? SceneManager->GetCurrentMarkerIndex() : 0, bResumingCapture);
+    }
+    else
+    {
+        SequenceAnnotationWriter.Close();
+    }
+
+    if (bExportSequenceAnnotation && (AnnotationCompressionMode != ENVAnnotationCompressionMode::None))
+    {
+        UE_LOG(LogNVSceneDataHandler, Warning, TEXT("The annotation data are exported as sequence files, they're not compressed."));
+    }
+    if (!bExportSequenceAnnotation && (AnnotationCompressionMode != ENVAnnotationCompressionMode::None))
+    {
+        CompressedAnnotationStreamWriter.Open(AnnotationCompressionMode, AnnotationCompressionFormat, CompressedStreamFramesPerFile, CompressedStreamBlockSizeKB * 1024,
+                                              CompressedDictionaryTrainingFrameCount, bResumingCapture);
+    }
+    else
+    {
+        CompressedAnnotationStreamWriter.Close();
+    }
+    bResumingCapture = false;
+
+    BuildExportFileNamePostfixes();
+    BuildDuplicateFrameCheckExtractors();
+    ResetFrameSubFolders();
+}
+
+void UNVSceneDataExporter::SetSequenceObjectClassSettings(const FNVSceneAnnotatedActorData& SceneAnnotatedActorData)
+{
+    TMap<FString, TSharedPtr<FJsonObject>> ObjectClassSettings;
+    for (const FNCapturerSettingExportedActorData& ExportedObject : SceneAnnotatedActorData.exported_objects)
+    {
+        TSharedPtr<FJsonObject> ClassSettingsJsonObj = NVSceneCapturerUtils::UStructToJsonObject(ExportedObject, 0, CPF_AdvancedDisplay | CPF_Transient);
+        if (ClassSettingsJsonObj.IsValid())
+        {
+            // NOTE: The class and instance id of the object are already in its row, the instance id in the settings belong to the first actor of the class
+            ClassSettingsJsonObj->RemoveField(TEXT("class"));
+            ClassSettingsJsonObj->RemoveField(TEXT("segmentation_instance_id"));
+            ObjectClassSettings.Add(ExportedObject.Class, ClassSettingsJsonObj);
+        }
+    }
+    SequenceAnnotationWriter.SetObjectClassSettings(ObjectClassSettings);
+}
+
+void UNVSceneDataExporter::BuildExportFileNamePostfixes()
+{
+    ExportFileNamePostfixMap.Reset();
+
+    ANVSceneCapturerActor* OwnerSceneCapturer = Cast<ANVSceneCapturerActor>(GetOuter());
+    if (OwnerSceneCapturer)
+    {
+        for (UNVSceneCapturerViewpointComponent* CheckViewpointComp : OwnerSceneCapturer->GetViewpointList())
+        {
+            if (CheckViewpointComp)
+            {
+                for (UNVSceneFeatureExtractor* CheckFeatureExtractor : CheckViewpointComp->FeatureExtractorList)
+                {
+                    if (CheckFeatureExtractor)
+                    {
+                        FString ExportFileNamePostfix;
+                        const FString& ViewpointPostfix = CheckViewpointComp->GetSettings().ExportFileNamePostfix;
+                        if (!ViewpointPostfix.IsEmpty())
+                        {
+                            ExportFileNamePostfix += TEXT(".") + ViewpointPostfix;
+                        }
+                        if (!CheckFeatureExtractor->ExportFileNamePostfix.IsEmpty())
+                        {
+                            ExportFileNamePostfix += TEXT(".") + CheckFeatureExtractor->ExportFileNamePostfix;
+                        }
+                        ExportFileNamePostfixMap.Add(MakeTuple(FObjectKey(CheckViewpointComp), FObjectKey(CheckFeatureExtractor)), ExportFileNamePostfix);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void UNVSceneDataExporter::BuildDuplicateFrameCheckExtractors()
+{
+    DuplicateFrameCheckExtractorMap.Reset();
+    if (!DuplicateFrameFilter.IsValid())
+    {
+        return;
+    }
+
+    ANVSceneCapturerActor* OwnerSceneCapturer = Cast<ANVSceneCapturerActor>(GetOuter());
+    if (OwnerSceneCapturer)
+    {
+        for (UNVSceneCapturerViewpointComponent* CheckViewpointComp : OwnerSceneCapturer->GetViewpointList())
+        {
+            if (!CheckViewpointComp || !CheckViewpointComp->IsEnabled())
+            {
+                continue;
+            }
+
+            for (UNVSceneFeatureExtractor* CheckFeatureExtractor : CheckViewpointComp->FeatureExtractorList)
+            {
+                // The color image is captured by the plain pixel data feature extractors, the others capture the depth, masks ...
+                const bool bIsColorFeatureExtractor = CheckFeatureExtractor && CheckFeatureExtractor->IsEnabled()
+                                                      && CheckFeatureExtractor->IsA<UNVSceneFeatureExtractor_PixelData>()
+                                                      && !CheckFeatureExtractor->IsA<UNVSceneFeatureExtractor_SceneDepth>()
+                                                      && !CheckFeatureExtractor->IsA<UNVSceneFeatureExtractor_ScenePixelVelocity>()
+                                                      && !CheckFeatureExtractor->IsA<UNVSceneFeatureExtractor_StencilMask>()
+                                                      && !CheckFeatureExtractor->IsA<UNVSceneFeatureExtractor_VertexColorMask>();
+                if (bIsColorFeatureExtractor)
+                {
+                    DuplicateFrameCheckExtractorMap.Add(FObjectKey(CheckViewpointComp), FObjectKey(CheckFeatureExtractor));
+                    break;
+                }
+            }
+
+            if (!DuplicateFrameCheckExtractorMap.Contains(FObjectKey(CheckViewpointComp)))
+            {
+                UE_LOG(LogNVSceneDataHandler, Warning, TEXT("Viewpoint '%s' doesn't have any color image feature extractor, its duplicated frames can't be skipped."),
+                       *CheckViewpointComp->GetDisplayName());
+            }
+        }
+    }
+}
+
+void UNVSceneDataExporter::PrepareFrameSubFolders(int32 FrameIndex)
+{
+    if ((FramesPerSubFolder <= 0) || (FrameIndex < 0))
+    {
+        return;
+    }
+
+    const int32 SubFolderIndex = GetFrameSubFolderIndex(FrameIndex, FramesPerSubFolder);
+    const int32 SubFolderCountToCreate = FMath::Max(PreCreatedSubFolderCount, 1);
+
+    FScopeLock ScopeLock(&SubFolderLock);
+    if (SubFolderCreationTask.IsValid() && SubFolderCreationTask.IsReady())
+    {
+        CreatedSubFolderEnd = SubFolderCreationTaskEnd;
+        SubFolderCreationTask = TFuture<void>();
+    }
+
+    // NOTE: The file writers only create the directories of the files they fail to open,
+    // the sub-folder must exist before the first file of the frame is queued
+    if ((SubFolderIndex < CreatedSubFolderStart) || (SubFolderIndex >= CreatedSubFolderEnd))
+    {
+        const bool bIsBeingCreated = SubFolderCreationTask.IsValid() && (SubFolderIndex < SubFolderCreationTaskEnd) && (SubFolderIndex >= CreatedSubFolderEnd);
+        if (SubFolderCreationTask.IsValid())
+        {
+            SubFolderCreationTask.Wait();
+            CreatedSubFolderEnd = SubFolderCreationTaskEnd;
+            SubFolderCreationTask = TFuture<void>();
+        }
+        if (!bIsBeingCreated)
+        {
+            // The frame jumped out of the created sub-folders (e.g: the first frame, a resumed capture): create its sub-folder right away
+            const FString SubFolderPath = FPaths::Combine(GetFullOutputDirectoryPath(), FString::Printf(TEXT("%06i"), SubFolderIndex));
+            FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*SubFolderPath);
+            CreatedSubFolderStart = SubFolderIndex;
+            CreatedSubFolderEnd = SubFolderIndex + 1;
+        }
+    }
+
+    // Only queue more sub-folders when the frames get close to the last created one
+    const int32 LastSubFolderIndex = SubFolderIndex + SubFolderCountToCreate;
+    if (!SubFolderCreationTask.IsValid() && (SubFolderIndex + (SubFolderCountToCreate / 2) >= CreatedSubFolderEnd) && (LastSubFolderIndex > CreatedSubFolderEnd))
+    {
+        const FString OutputDirectoryPath = GetFullOutputDirectoryPath();
+        const int32 FirstSubFolderIndex = CreatedSubFolderEnd;
+        SubFolderCreationTaskEnd = LastSubFolderIndex;
+        // NOTE: The output directory already exist, it's created with the first sub-folder
+        SubFolderCreationTask = Async(EAsyncExecution::ThreadPool, [OutputDirectoryPath, FirstSubFolderIndex, LastSubFolderIndex]()
+        {
+            IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+            for (int32 i = FirstSubFolderIndex; i < LastSubFolderIndex; i++)
+            {
+                PlatformFile.CreateDirectory(*FPaths::Combine(OutputDirectoryPath, FString::Printf(TEXT("%06i"), i)));
+            }
+        });
+    }
+}
+
+void UNVSceneDataExporter::ResetFrameSubFolders()
+{
+    FScopeLock ScopeLock(&SubFolderLock);
+    if (SubFolderCreationTask.IsValid())
+    {
+        SubFolderCreationTask.Wait();
+        SubFolderCreationTask = TFuture<void>();
+    }
+    CreatedSubFolderStart = 0;
+    CreatedSubFolderEnd = 0;
+    SubFolderCreationTaskEnd = 0;
 }
 
 void UNVSceneDataExporter::ExportCapturerSettings()
@@ -255,8 +820,9 @@ void UNVSceneDataExporter::ExportCapturerSettings()
     TSharedPtr<FJsonObject> SceneAnnotatedDataJsonObj = NVSceneCapturerUtils::UStructToJsonObject(SceneAnnotatedActorData, CheckFlags, SkipFlags);
     if (SceneAnnotatedDataJsonObj.IsValid())
     {
-        NVSceneCapturerUtils::SaveJsonObjectToFile(SceneAnnotatedDataJsonObj, ObjectSettingsFilePath);
+        NVSceneCapturerUtils::SaveJsonObjectToFile(SceneAnnotatedDataJsonObj, ObjectSettingsFilePath, FileSink.Get());
     }
+    SetSequenceObjectClassSettings(SceneAnnotatedActorData);
 
     // Export the camera settings
     FNVCameraSettingExportData CameraSettingsExportData;
@@ -282,7 +848,7 @@ void UNVSceneDataExporter::ExportCapturerSettings()
     TSharedPtr<FJsonObject> CamSettingsJsonObj = NVSceneCapturerUtils::UStructToJsonObject(CameraSettingsExportData, CheckFlags, SkipFlags);
     if (CamSettingsJsonObj.IsValid())
     {
-        NVSceneCapturerUtils::SaveJsonObjectToFile(CamSettingsJsonObj, CameraSettingsFilePath);
+        NVSceneCapturerUtils::SaveJsonObjectToFile(CamSettingsJsonObj, CameraSettingsFilePath, FileSink.Get());
     }
 }
 
@@ -292,6 +858,64 @@ void UNVSceneDataExporter::OnStopCapturingSceneData()
     {
         ImageExporterThread->Stop();
     }
+
+    FlushPendingExports();
+
+    CaptureJournal.Close();
+    FrameManifest.Close();
+    SequenceAnnotationWriter.Close();
+    CompressedAnnotationStreamWriter.Close();
+    ReleaseTiledImageWriters();
+    {
+        // NOTE: The frames dropped by the duplicate frame filter never claim their lookup table
+        FScopeLock Lock(&FrameInstanceClassLUTLock);
+        FrameInstanceClassLUTMap.Reset();
+    }
+
+    if (FileSink.IsValid())
+    {
+        UE_LOG(LogNVSceneDataHandler, Log, TEXT("File sink stats: %s"), *FileSink->GetStats().ToString());
+    }
+    if (DuplicateFrameFilter.IsValid())
+    {
+        UE_LOG(LogNVSceneDataHandler, Log, TEXT("Duplicate frame filter: %d frames dropped out of %d checked frames."),
+               DuplicateFrameFilter->GetDroppedFrameCount(), DuplicateFrameFilter->GetCheckedFrameCount());
+    }
+}
+
+void UNVSceneDataExporter::FlushPendingExports()
+{
+    // Don't lose the annotation data which are still waiting for their instance masks,
+    // the merger export them into the sequence or compressed stream files so it must be done before they're closed
+    if (InstanceMaskAnnotationMerger.IsValid())
+    {
+        InstanceMaskAnnotationMerger->Flush();
+    }
+
+    // The files must be on the disk before the journal and the manifest which list them are closed
+    if (FileSink.IsValid())
+    {
+        FileSink->Flush();
+    }
+}
+
+bool UNVSceneDataExporter::ShouldMergeInstanceMask(const UNVSceneCapturerViewpointComponent* CapturedViewpoint) const
+{
+    bool bUseInstanceMaskBoundingBox = false;
+    bool bHaveInstanceMask = false;
+    if (CapturedViewpoint)
+    {
+        for (const UNVSceneFeatureExtractor* CheckFeatureExtractor : CapturedViewpoint->FeatureExtractorList)
+        {
+            if (CheckFeatureExtractor && CheckFeatureExtractor->IsEnabled())
+            {
+                const UNVSceneFeatureExtractor_AnnotationData* AnnotationFeatureExtractor = Cast<UNVSceneFeatureExtractor_AnnotationData>(CheckFeatureExtractor);
+                bUseInstanceMaskBoundingBox |= (AnnotationFeatureExtractor && AnnotationFeatureExtractor->ShouldUseInstanceMaskBoundingBox());
+                bHaveInstanceMask |= CheckFeatureExtractor->IsA<UNVSceneFeatureExtractor_VertexColorMask>();
+            }
+        }
+    }
+    return bUseInstanceMaskBoundingBox && bHaveInstanceMask;
 }
 
 void UNVSceneDataExporter::OnCapturingCompleted()
@@ -302,6 +926,19 @@ void UNVSceneDataExporter::OnCapturingCompleted()
     ANVSceneManager* SceneManager = ANVSceneManager::GetANVSceneManagerPtr();
     const bool bIsSceneCompleted = !SceneManager || SceneManager->GetState() == ENVSceneManagerState::Captured;
 
+    FlushPendingExports();
+
+    CaptureJournal.Close();
+    FrameManifest.Close();
+    SequenceAnnotationWriter.Close();
+    CompressedAnnotationStreamWriter.Close();
+    ReleaseTiledImageWriters();
+
+    if (FileSink.IsValid())
+    {
+        UE_LOG(LogNVSceneDataHandler, Log, TEXT("File sink stats: %s"), *FileSink->GetStats().ToString());
+    }
+
     if (bIsSceneCompleted && bAutoOpenExportedDirectory)
     {
         // Open the output path when the capturing process is completed
@@ -375,21 +1012,157 @@ FString UNVSceneDataExporter::GetExportFilePath(UNVSceneFeatureExtractor* Captur
         int32 FrameIndex,
         const FString& FileExtension) const
 {
-    const FString OutputFolderPath = GetFullOutputDirectoryPath();
-    FString OutputFileName = FString::Printf(TEXT("%06i"), FrameIndex);
+    const FString& OutputFolderPath = FullOutputDirectoryPath;
+
+    const FString ExportFileNamePostfix = GetExportFileNamePostfix(CapturedFeatureExtractor, CapturedViewpoint);
+
+    // Build the path in one go: <OutputFolder>/[<SubFolderIndex>/]<FrameIndex><Postfix><Extension>
+    FString ExportFilePath;
+    ExportFilePath.Reserve(OutputFolderPath.Len() + ExportFileNamePostfix.Len() + FileExtension.Len() + 24);
+    ExportFilePath += OutputFolderPath;
+    if (!ExportFilePath.IsEmpty() && !ExportFilePath.EndsWith(TEXT("/")))
+    {
+        ExportFilePath += TEXT("/");
+    }
+    AppendFrameFileRelativePath(ExportFilePath, FrameIndex, FramesPerSubFolder, ExportFileNamePostfix, FileExtension);
+    return ExportFilePath;
+}
+
+int32 UNVSceneDataExporter::GetFrameSubFolderIndex(int32 FrameIndex, int32 FramesPerSubFolder)
+{
+    return (FramesPerSubFolder > 0) ? (FrameIndex / FramesPerSubFolder) : INDEX_NONE;
+}
+
+void UNVSceneDataExporter::AppendFrameFileRelativePath(FString& OutFilePath, int32 FrameIndex, int32 FramesPerSubFolder,
+                                                       const FString& FileNamePostfix, const FString& FileExtension)
+{
+    if (FramesPerSubFolder > 0)
+    {
+        OutFilePath.Appendf(TEXT("%06i/"), GetFrameSubFolderIndex(FrameIndex, FramesPerSubFolder));
+    }
+    OutFilePath.Appendf(TEXT("%06i"), FrameIndex);
+    OutFilePath += FileNamePostfix;
+    OutFilePath += FileExtension;
+}
+
+namespace
+{
+    /// Parse a frame or sub-folder index formatted with "%06i"
+    /// NOTE: Only the padding can start with a 0 so each index has a single valid text
+    /// @return INDEX_NONE if the text isn't an index in this exact format
+    int32 ParseZeroPaddedIndex(const TCHAR* Text, int32 TextLength)
+    {
+        if ((TextLength < 6) || (TextLength > 10) || ((TextLength > 6) && (Text[0] == TEXT('0'))))
+        {
+            return INDEX_NONE;
+        }
+        int64 Index = 0;
+        for (int32 i = 0; i < TextLength; i++)
+        {
+            if (!FChar::IsDigit(Text[i]))
+            {
+                return INDEX_NONE;
+            }
+            Index = Index * 10 + (Text[i] - TEXT('0'));
+        }
+        return (Index <= MAX_int32) ? int32(Index) : INDEX_NONE;
+    }
+}
+
+int32 UNVSceneDataExporter::ParseFrameFileRelativePath(const FString& RelativeFilePath, int32 FramesPerSubFolder,
+                                                       const FString& FileNamePostfix, const FString& FileExtension)
+{
+    const TCHAR* FilePath = *RelativeFilePath;
+    const int32 FilePathLength = RelativeFilePath.Len();
+    const int32 FileNameSuffixLength = FileNamePostfix.Len() + FileExtension.Len();
+    if ((FilePathLength <= FileNameSuffixLength)
+        || (FCString::Strncmp(FilePath + FilePathLength - FileNameSuffixLength, *FileNamePostfix, FileNamePostfix.Len()) != 0)
+        || (FCString::Strncmp(FilePath + FilePathLength - FileExtension.Len(), *FileExtension, FileExtension.Len()) != 0))
+    {
+        return INDEX_NONE;
+    }
+
+    int32 FrameNameStart = 0;
+    int32 SubFolderIndex = INDEX_NONE;
+    if (FramesPerSubFolder > 0)
+    {
+        int32 SeparatorIndex = INDEX_NONE;
+        if (!RelativeFilePath.FindChar(TEXT('/'), SeparatorIndex))
+        {
+            return INDEX_NONE;
+        }
+        SubFolderIndex = ParseZeroPaddedIndex(FilePath, SeparatorIndex);
+        if (SubFolderIndex == INDEX_NONE)
+        {
+            return INDEX_NONE;
+        }
+        FrameNameStart = SeparatorIndex + 1;
+    }
+
+    const int32 FrameIndex = ParseZeroPaddedIndex(FilePath + FrameNameStart, FilePathLength - FileNameSuffixLength - FrameNameStart);
+    // The frame must be in its own sub-folder
+    if ((FrameIndex == INDEX_NONE) || (SubFolderIndex != GetFrameSubFolderIndex(FrameIndex, FramesPerSubFolder)))
+    {
+        return INDEX_NONE;
+    }
+    return FrameIndex;
+}
+
+FString UNVSceneDataExporter::GetSequenceAnnotationFilePath(UNVSceneFeatureExtractor* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint) const
+{
+    // NOTE: The sequence files are in the output directory itself, not in the frame sub-folders
+    static const FString SequenceFileNamePrefix = TEXT("_sequence");
+    const FString SequenceFileName = SequenceFileNamePrefix + GetExportFileNamePostfix(CapturedFeatureExtractor, CapturedViewpoint) + FNVSequenceAnnotationWriter::SequenceFileExtension;
+    return FPaths::Combine(FullOutputDirectoryPath, SequenceFileName);
+}
+
+FString UNVSceneDataExporter::GetCompressedAnnotationStreamFilePathPrefix(const UNVSceneFeatureExtractor* CapturedFeatureExtractor, const UNVSceneCapturerViewpointComponent* CapturedViewpoint) const
+{
+    // NOTE: Like the sequence files, the stream files are in the output directory itself
+    static const FString StreamFileNamePrefix = TEXT("_annotation");
+    return FPaths::Combine(FullOutputDirectoryPath, StreamFileNamePrefix + GetExportFileNamePostfix(CapturedFeatureExtractor, CapturedViewpoint));
+}
+
+FString UNVSceneDataExporter::GetCompressedAnnotationStreamFilePath(UNVSceneFeatureExtractor* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex) const
+{
+    return CompressedAnnotationStreamWriter.GetStreamFilePath(GetCompressedAnnotationStreamFilePathPrefix(CapturedFeatureExtractor, CapturedViewpoint), FrameIndex);
+}
+
+FString UNVSceneDataExporter::GetAnnotationExportFilePath(UNVSceneFeatureExtractor* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex) const
+{
+    if (SequenceAnnotationWriter.IsOpen())
+    {
+        return GetSequenceAnnotationFilePath(CapturedFeatureExtractor, CapturedViewpoint);
+    }
+    if (CompressedAnnotationStreamWriter.IsOpen())
+    {
+        return GetCompressedAnnotationStreamFilePath(CapturedFeatureExtractor, CapturedViewpoint, FrameIndex);
+    }
+
+    static const FString JsonExtension = TEXT(".json");
+    return GetExportFilePath(CapturedFeatureExtractor, CapturedViewpoint, FrameIndex, JsonExtension);
+}
+
+FString UNVSceneDataExporter::GetExportFileNamePostfix(const UNVSceneFeatureExtractor* CapturedFeatureExtractor, const UNVSceneCapturerViewpointComponent* CapturedViewpoint) const
+{
+    // NOTE: The postfixes are pre-computed when the capturing start, only build it here for the unknown pairs
+    const FString* CachedExportFileNamePostfix = ExportFileNamePostfixMap.Find(MakeTuple(FObjectKey(CapturedViewpoint), FObjectKey(CapturedFeatureExtractor)));
+    if (CachedExportFileNamePostfix)
+    {
+        return *CachedExportFileNamePostfix;
+    }
+
+    FString ExportFileNamePostfix;
     const auto& ViewpointSettings = CapturedViewpoint->GetSettings();
     if (!ViewpointSettings.ExportFileNamePostfix.IsEmpty())
     {
-        OutputFileName += TEXT(".") + ViewpointSettings.ExportFileNamePostfix;
+        ExportFileNamePostfix += TEXT(".") + ViewpointSettings.ExportFileNamePostfix;
     }
     if (!CapturedFeatureExtractor->ExportFileNamePostfix.IsEmpty())
     {
-        OutputFileName += TEXT(".") + CapturedFeatureExtractor->ExportFileNamePostfix;
+        ExportFileNamePostfix += TEXT(".") + CapturedFeatureExtractor->ExportFileNamePostfix;
     }
-    OutputFileName += FileExtension;
-
-    const FString ExportFilePath = FPaths::Combine(OutputFolderPath, OutputFileName);
-    return ExportFilePath;
+    return ExportFileNamePostfix;
 }
 
 uint32 UNVSceneDataExporter::GetPendingToExportImagesCount() const
@@ -401,6 +1174,72 @@ uint32 UNVSceneDataExporter::GetPendingToExportImagesCount() const
     return 0;
 }
 
+FNVFileSinkStats UNVSceneDataExporter::GetFileSinkStats() const
+{
+    if (FileSink.IsValid())
+    {
+        return FileSink->GetStats();
+    }
+    return FNVFileSinkStats();
+}
+
+int32 UNVSceneDataExporter::GetDroppedDuplicateFrameCount() const
+{
+    return DuplicateFrameFilter.IsValid() ? DuplicateFrameFilter->GetDroppedFrameCount() : 0;
+}
+
+int32 UNVSceneDataExporter::GetCheckpointFrameInterval() const
+{
+    return CheckpointFrameInterval;
+}
+
+void UNVSceneDataExporter::SetResumingCapture(bool bInResumingCapture)
+{
+    bResumingCapture = bInResumingCapture;
+}
+
+bool UNVSceneDataExporter::LoadResumeCheckpoint(FNVCaptureCheckpoint& OutCheckpoint) const
+{
+    return FNVCaptureJournal::LoadLastCheckpoint(GetConfiguredOutputDirectoryPath(), OutCheckpoint);
+}
+
+bool UNVSceneDataExporter::WriteCheckpoint(int32 FrameIndex, int32 MarkerIndex, int32 RandomSeed, bool bWaitForPendingWrites)
+{
+    if (!CaptureJournal.IsOpen())
+    {
+        return false;
+    }
+
+    FNVCaptureCheckpoint NewCheckpoint;
+    NewCheckpoint.FrameIndex = FrameIndex;
+    NewCheckpoint.MarkerIndex = MarkerIndex;
+    NewCheckpoint.RandomSeed = RandomSeed;
+    if (FileSink.IsValid())
+    {
+        if (bWaitForPendingWrites)
+        {
+            FileSink->Flush();
+        }
+        FileSink->ConsumeWrittenFilePaths(NewCheckpoint.WrittenFiles);
+        for (FString& WrittenFile : NewCheckpoint.WrittenFiles)
+        {
+            FPaths::MakePathRelativeTo(WrittenFile, *(FullOutputDirectoryPath / TEXT("")));
+        }
+    }
+    // The frames covered by the checkpoint must be in the manifest and the sequence or compressed stream files too
+    FrameManifest.Flush();
+    SequenceAnnotationWriter.Flush();
+    CompressedAnnotationStreamWriter.Flush();
+
+    const bool bResult = CaptureJournal.AppendCheckpoint(NewCheckpoint);
+    if (bResult)
+    {
+        UE_LOG(LogNVSceneDataHandler, Log, TEXT("Checkpoint: frame %d - marker %d - %d files written since the previous checkpoint."),
+               FrameIndex, MarkerIndex, NewCheckpoint.WrittenFiles.Num());
+    }
+    return bResult;
+}
+
 //=================================== UNVSceneDataVisualizer ===================================
 UNVSceneDataVisualizer::UNVSceneDataVisualizer()
 {
@@ -22,6 +22,63 @@
 #include "PhysicsEngine/PhysicsAsset.h"
 #include "Kismet/KismetSystemLibrary.h"
 
+//================================== FNVCaptureCadence ==================================
+FNVCaptureCadence::FNVCaptureCadence()
+{
+    CadenceType = ENVCaptureCadenceType::EveryFrame;
+    FrameInterval = 1;
+    FrameOffset = 0;
+    Probability = 1.f;
+}
+
+bool FNVCaptureCadence::IsDueAtFrame(int32 FrameIndex, float RandomValue) const
+{
+    switch (CadenceType)
+    {
+        case ENVCaptureCadenceType::FrameInterval:
+        {
+            const int32 FrameIndexFromOffset = FrameIndex - FMath::Max(FrameOffset, 0);
+            return (FrameIndexFromOffset >= 0) && ((FrameIndexFromOffset % FMath::Max(FrameInterval, 1)) == 0);
+        }
+        case ENVCaptureCadenceType::Probability:
+            return (RandomValue < Probability);
+        case ENVCaptureCadenceType::EveryFrame:
+        default:
+            return true;
+    }
+}
+
+//================================== FNVCaptureCadenceDraws ==================================
+void FNVCaptureCadenceDraws::BeginFrame(int32 RunSeed, int32 FrameIndex)
+{
+    RandomStream.Initialize((int32)HashCombine(GetTypeHash(RunSeed), GetTypeHash(FrameIndex)));
+    RandomValues.Reset();
+}
+
+void FNVCaptureCadenceDraws::DrawSettings(const TArray<FNVFeatureExtractorSettings>& SettingsList)
+{
+    // NOTE: Every settings is drawn so the values of the others don't depend on which ones have a probability cadence
+    for (const FNVFeatureExtractorSettings& CheckSettings : SettingsList)
+    {
+        DrawRandomValue(FObjectKey(CheckSettings.FeatureExtractorRef));
+    }
+}
+
+void FNVCaptureCadenceDraws::DrawRandomValue(const FObjectKey& SettingsKey)
+{
+    const float RandomValue = RandomStream.GetFraction();
+    if ((SettingsKey != FObjectKey()) && !RandomValues.Contains(SettingsKey))
+    {
+        RandomValues.Add(SettingsKey, RandomValue);
+    }
+}
+
+float FNVCaptureCadenceDraws::GetRandomValue(const FObjectKey& SettingsKey) const
+{
+    return RandomValues.FindRef(SettingsKey);
+}
+
+//================================== UNVSceneFeatureExtractor ==================================
 UNVSceneFeatureExtractor::UNVSceneFeatureExtractor(const FObjectInitializer& ObjectInitializer)
     : Super(ObjectInitializer)
 {
@@ -32,6 +89,7 @@ UNVSceneFeatureExtractor::UNVSceneFeatureExtractor(const FObjectInitializer& Obj
     OwnerCapturer = nullptr;
 
     bCapturing = false;
+    bScheduledToCapture = true;
 }
 
 UWorld* UNVSceneFeatureExtractor::GetWorld() const
@@ -66,9 +124,31 @@ void UNVSceneFeatureExtractor::Init(UNVSceneCapturerViewpointComponent* InOwnerV
     }
 }
 
+void UNVSceneFeatureExtractor::SetCaptureCadence(const FNVCaptureCadence& NewCaptureCadence, const FObjectKey& NewCaptureCadenceSettingsKey)
+{
+    CaptureCadence = NewCaptureCadence;
+    CaptureCadenceSettingsKey = NewCaptureCadenceSettingsKey;
+}
+
+const FNVCaptureCadence& UNVSceneFeatureExtractor::GetCaptureCadence() const
+{
+    return CaptureCadence;
+}
+
+void UNVSceneFeatureExtractor::UpdateCaptureSchedule(int32 FrameIndex, const FNVCaptureCadenceDraws& CadenceDraws)
+{
+    bScheduledToCapture = CaptureCadence.IsDueAtFrame(FrameIndex, CadenceDraws.GetRandomValue(CaptureCadenceSettingsKey));
+}
+
+bool UNVSceneFeatureExtractor::IsScheduledToCapture() const
+{
+    return bScheduledToCapture;
+}
+
 void UNVSceneFeatureExtractor::StartCapturing()
 {
     bCapturing = true;
+    bScheduledToCapture = true;
 }
 
 void UNVSceneFeatureExtractor::StopCapturing()
@@ -11,9 +11,13 @@
 #include "NVSceneCaptureComponent2D.h"
 #include "NVAnnotatedActor.h"
 #include "NVSceneManager.h"
+#include "NVCaptureRegion.h"
+#include "NVMeshSocketTable.h"
+#include "NVMeshGeometry.h"
 
 #include "UObject/ConstructorHelpers.h"
 #include "Components/StaticMeshComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/DrawFrustumComponent.h"
 #include "Engine/StaticMesh.h"
@@ -30,8 +34,61 @@
 #include "Rendering/SkeletalMeshLODRenderData.h"
 #include "Runtime/Engine/Public/ConvexVolume.h" // ✅ FIX: for FConvexVolume
 #include "SceneView.h"                          // for GetViewFrustumBounds
+#include "Async/ParallelFor.h"
 
 
+namespace
+{
+    /// Below this number of actors the annotation is computed on the game thread, dispatching the tasks would cost more
+    const int32 MinParallelAnnotationActorCount = 16;
+
+    /// Count how many of the cuboid's vertexes are hidden from the view location
+    int32 CountOccludedCuboidVertexes(const UWorld *World, const AActor *IgnoredActor, const FVector &ViewLocation, const FNVCuboidData &Cuboid)
+    {
+        int32 OccludedVertexCount = 0;
+        for (const FVector &V : Cuboid.Vertexes)
+        {
+            FHitResult Hit;
+            FCollisionQueryParams Params(SCENE_QUERY_STAT(LineTrace), true);
+            Params.AddIgnoredActor(IgnoredActor);
+            if (World->LineTraceSingleByChannel(Hit, ViewLocation, V, ECC_Visibility, Params))
+            {
+                OccludedVertexCount++;
+            }
+        }
+        return OccludedVertexCount;
+    }
+
+    /// Set up the vertexes of a static mesh used to calculate the 2D bounding box: its convex collision, or its LOD0 vertexes if it doesn't have any
+    bool InitStaticMeshVertexSource(const UStaticMesh *StaticMesh, const FTransform &MeshTransform, FNVMeshBoundVertexSource &OutVertexSource)
+    {
+        if (!StaticMesh)
+            return false;
+
+        OutVertexSource.MeshTransform = MeshTransform;
+        OutVertexSource.GeometryOwner = StaticMesh;
+        if (const UBodySetup *BodySetup = StaticMesh->GetBodySetup())
+        {
+            for (const FKConvexElem &ConvexElem : BodySetup->AggGeom.ConvexElems)
+            {
+                if (ConvexElem.VertexData.Num() > 0)
+                    OutVertexSource.ConvexVertexes.Add(ConvexElem.VertexData);
+            }
+        }
+
+        if (OutVertexSource.ConvexVertexes.IsEmpty())
+        {
+            if (const FStaticMeshRenderData *RenderData = StaticMesh->GetRenderData())
+            {
+                if (RenderData->LODResources.Num() > 0)
+                {
+                    OutVertexSource.PositionVertexBuffer = &RenderData->LODResources[0].VertexBuffers.PositionVertexBuffer;
+                }
+            }
+        }
+        return !OutVertexSource.ConvexVertexes.IsEmpty() || OutVertexSource.PositionVertexBuffer;
+    }
+}
 
 // ============================================================================
 // UNVSceneFeatureExtractor_AnnotationData
@@ -47,6 +104,19 @@ void UNVSceneFeatureExtractor_AnnotationData::StartCapturing()
 {
     Super::StartCapturing();
     ProtectedDataExportSettings = DataExportSettings;
+    AnnotationFields = FNVAnnotationFieldSet::Resolve(ProtectedDataExportSettings.AnnotationSchema, ShouldUseInstanceMaskBoundingBox());
+    ActorAnnotationCache.Reset();
+}
+
+void UNVSceneFeatureExtractor_AnnotationData::StopCapturing()
+{
+    if (bCacheStaticActorAnnotation && (ActorAnnotationCache.GetStats().LookupCount > 0))
+    {
+        UE_LOG(LogNVSceneCapturer, Log, TEXT("Actor annotation cache of '%s': %s"), *GetDisplayName(), *ActorAnnotationCache.GetStats().ToString());
+    }
+    ActorAnnotationCache.Reset();
+
+    Super::StopCapturing();
 }
 
 void UNVSceneFeatureExtractor_AnnotationData::UpdateSettings() {}
@@ -67,24 +137,39 @@ bool UNVSceneFeatureExtractor_AnnotationData::CaptureSceneAnnotationData(
     return false;
 }
 
+bool UNVSceneFeatureExtractor_AnnotationData::ShouldUseInstanceMaskBoundingBox() const
+{
+    return (ProtectedDataExportSettings.BoundingBox2dType == ENVBoundBox2dGenerationType::FromInstanceMask);
+}
+
 // ----------------------------------------------------------------------------
 // CaptureSceneAnnotationData_Internal
 // ----------------------------------------------------------------------------
 TSharedPtr<FJsonObject> UNVSceneFeatureExtractor_AnnotationData::CaptureSceneAnnotationData_Internal()
 {
-    TSharedPtr<FJsonObject> SceneDataJsonObj;
+    if (!OwnerViewpoint)
+        return TSharedPtr<FJsonObject>();
+
+    const FNVSceneAnnotationSnapshotRef Snapshot = CaptureSceneAnnotationSnapshot(INDEX_NONE);
+    return BuildSceneAnnotationData(Snapshot.Get());
+}
+
+// ----------------------------------------------------------------------------
+// CaptureSceneAnnotationSnapshot
+// ----------------------------------------------------------------------------
+FNVSceneAnnotationSnapshotRef UNVSceneFeatureExtractor_AnnotationData::CaptureSceneAnnotationSnapshot(int32 FrameIndex)
+{
+    ensure(IsInGameThread());
 
+    FNVSceneAnnotationSnapshotRef Snapshot = MakeShared<FNVSceneAnnotationSnapshot, ESPMode::ThreadSafe>(FrameIndex);
     if (!OwnerViewpoint)
-        return SceneDataJsonObj;
+        return Snapshot;
 
     const auto &CapturerSettings = OwnerViewpoint->GetCapturerSettings();
-    const float FOVAngle = CapturerSettings.GetFOVAngle();
     const FTransform &ViewTransform = OwnerViewpoint->GetComponentTransform();
 
-    FCapturedSceneData SceneData;
-
-    FCapturedViewpointData &ViewpointData = SceneData.camera_data;
-    ViewpointData.fov = FOVAngle;
+    FCapturedViewpointData &ViewpointData = Snapshot->CameraData;
+    ViewpointData.fov = CapturerSettings.GetFOVAngle();
     ViewpointData.location_worldframe = ViewTransform.GetLocation();
     ViewpointData.quaternion_xyzw_worldframe = ViewTransform.GetRotation();
     ViewpointData.CameraSettings = CapturerSettings.GetCameraIntrinsicSettings();
@@ -93,33 +178,68 @@ TSharedPtr<FJsonObject> UNVSceneFeatureExtractor_AnnotationData::CaptureSceneAnn
     ViewpointData.ProjectionMatrix = ProjectionMatrix;
     ViewpointData.ViewProjectionMatrix = ViewProjectionMatrix;
 
+    Snapshot->ViewContext = MakeAnnotationViewContext();
+    // NOTE: The schema is resolved when the capturing start, the annotation can be captured before that
+    if (!AnnotationFields.IsResolved())
+    {
+        AnnotationFields = FNVAnnotationFieldSet::Resolve(ProtectedDataExportSettings.AnnotationSchema, ShouldUseInstanceMaskBoundingBox());
+    }
+    Snapshot->AnnotationFields = AnnotationFields;
+    ActorAnnotationCache.BeginFrame();
+
     if (UWorld *World = GetWorld())
     {
+        // Read the actors in the iteration order, the annotation keep the same order
         for (TActorIterator<AActor> It(World); It; ++It)
         {
-            const AActor *CheckActor = *It;
-            FCapturedObjectData ActorData;
-            if (GatherActorData(CheckActor, ActorData))
+            // The actors with instanced static meshes export each of their instances instead of themselves
+            if (GatherMeshInstanceInputs(*It, Snapshot->ViewContext, Snapshot->Actors))
+                continue;
+
+            FNVActorAnnotationInput ActorInput;
+            if (GatherActorInput(*It, Snapshot->ViewContext, ActorInput))
             {
-                SceneData.Objects.Add(ActorData);
+                Snapshot->Actors.Add(MoveTemp(ActorInput));
             }
         }
     }
+    Snapshot->AddGeometryReferences();
 
-    SceneDataJsonObj = NVSceneCapturerUtils::UStructToJsonObject(SceneData, 0, 0);
+    return Snapshot;
+}
 
-    // Append any custom per-object data
+// ----------------------------------------------------------------------------
+// BuildSceneAnnotationData
+// ----------------------------------------------------------------------------
+TSharedPtr<FJsonObject> UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(const FNVSceneAnnotationSnapshot &Snapshot)
+{
+    FCapturedSceneData SceneData;
+    SceneData.camera_data = Snapshot.CameraData;
+
+    // Compute the annotation of each actor and convert its exported fields to json,
+    // the results are written by index so the order doesn't depend on the scheduling
+    const TArray<FNVActorAnnotationInput> &ActorInputs = Snapshot.Actors;
+    const FNVAnnotationViewContext &ViewContext = Snapshot.ViewContext;
+    const FNVAnnotationFieldSet &AnnotationFields = Snapshot.AnnotationFields;
+    TArray<TSharedPtr<FJsonValue>> ObjectJsonValues;
+    ObjectJsonValues.SetNum(ActorInputs.Num());
+    ParallelFor(ActorInputs.Num(), [&ViewContext, &AnnotationFields, &ActorInputs, &ObjectJsonValues](int32 ActorIndex)
+    {
+        FCapturedObjectData ObjData;
+        ComputeActorData(ViewContext, AnnotationFields, ActorInputs[ActorIndex], ObjData);
+        ObjectJsonValues[ActorIndex] = MakeShared<FJsonValueObject>(AnnotationFields.ObjectDataToJsonObject(ObjData));
+    }, (ActorInputs.Num() < MinParallelAnnotationActorCount));
+
+    TSharedPtr<FJsonObject> SceneDataJsonObj = NVSceneCapturerUtils::UStructToJsonObject(SceneData, 0, 0);
     if (SceneDataJsonObj.IsValid())
     {
-        const TArray<TSharedPtr<FJsonValue>> &JsonObjectArrayData = SceneDataJsonObj->GetArrayField(TEXT("objects"));
-        for (int32 i = 0; i < SceneData.Objects.Num(); ++i)
+        // NOTE: The objects keep their place among the scene fields
+        SceneDataJsonObj->SetArrayField(TEXT("objects"), ObjectJsonValues);
+
+        // The annotation keep the full image's coordinates, the crop let them be matched with the cropped images
+        if (Snapshot.CaptureRegion.Area() > 0)
         {
-            const FCapturedObjectData &ObjData = SceneData.Objects[i];
-            const TSharedPtr<FJsonObject> &JsonObj = JsonObjectArrayData[i]->AsObject();
-            if (ObjData.custom_data.IsValid() && JsonObj.IsValid())
-            {
-                JsonObj->SetObjectField(TEXT("custom_data"), ObjData.custom_data);
-            }
+            FNVCaptureRegion::WriteCropToAnnotationData(SceneDataJsonObj, Snapshot.CaptureRegion, Snapshot.FullImageSize);
         }
     }
 
@@ -155,46 +275,293 @@ void UNVSceneFeatureExtractor_AnnotationData::UpdateProjectionMatrix()
     }
 }
 
+// ----------------------------------------------------------------------------
+// MakeAnnotationViewContext
+// ----------------------------------------------------------------------------
+FNVAnnotationViewContext UNVSceneFeatureExtractor_AnnotationData::MakeAnnotationViewContext() const
+{
+    FNVAnnotationViewContext ViewContext;
+    ViewContext.ViewProjectionMatrix = ViewProjectionMatrix;
+    ViewContext.DistanceScaleRange = ProtectedDataExportSettings.DistanceScaleRange;
+    ViewContext.bUseInstanceMaskBoundingBox = ShouldUseInstanceMaskBoundingBox();
+
+    if (OwnerViewpoint)
+    {
+        ViewContext.ViewLocation = OwnerViewpoint->GetComponentLocation();
+        const FTransform WorldToCamera = OwnerViewpoint->GetComponentToWorld().Inverse();
+        ViewContext.WorldToCameraMatrixUE = WorldToCamera.ToMatrixNoScale();
+        ViewContext.WorldToCameraMatrixCV = ViewContext.WorldToCameraMatrixUE * NVSceneCapturerUtils::UE4ToOpenCVMatrix;
+
+        if (ProtectedDataExportSettings.bExportImageCoordinateInPixel)
+        {
+            const auto &S = OwnerViewpoint->GetCapturerSettings().CapturedImageSize;
+            ViewContext.ImageScale = FVector2D(S.Width, S.Height);
+        }
+    }
+    return ViewContext;
+}
+
 // ----------------------------------------------------------------------------
 // GatherActorData
 // ----------------------------------------------------------------------------
 bool UNVSceneFeatureExtractor_AnnotationData::GatherActorData(const AActor *CheckActor, FCapturedObjectData &ActorData)
+{
+    const FNVAnnotationViewContext ViewContext = MakeAnnotationViewContext();
+    FNVActorAnnotationInput ActorInput;
+    if (!GatherActorInput(CheckActor, ViewContext, ActorInput))
+        return false;
+
+    ComputeActorData(ViewContext, AnnotationFields, ActorInput, ActorData);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// GatherActorInput
+// ----------------------------------------------------------------------------
+bool UNVSceneFeatureExtractor_AnnotationData::GatherActorInput(const AActor *CheckActor, const FNVAnnotationViewContext &ViewContext, FNVActorAnnotationInput &ActorInput)
 {
     if (!OwnerViewpoint || !CheckActor || !ShouldExportActor(CheckActor))
         return false;
 
-    const FString ObjectName = CheckActor->GetName();
+    UWorld *World = GetWorld();
+    if (!World)
+        return false;
 
-    if (UWorld *World = GetWorld())
+    if (!NVSceneCapturerUtils::GetFirstValidMeshComponent(CheckActor))
+        return false;
+
+    const UNVCapturableActorTag *Tag = Cast<UNVCapturableActorTag>(
+        CheckActor->GetComponentByClass(UNVCapturableActorTag::StaticClass()));
+
+    ActorInput.Name = CheckActor->GetName();
+    ActorInput.Class = Tag ? Tag->Tag : ActorInput.Name;
+    ActorInput.ActorToWorld = CheckActor->GetActorTransform();
+
+    if (ANVSceneManager *Manager = ANVSceneManager::GetANVSceneManagerPtr())
     {
-        const FVector ViewLocation = OwnerViewpoint->GetComponentLocation();
-        const FTransform WorldToCamera = OwnerViewpoint->GetComponentToWorld().Inverse();
-        const FMatrix WorldToCameraMatrixUE = WorldToCamera.ToMatrixNoScale();
-        const FMatrix WorldToCameraMatrixCV = WorldToCameraMatrixUE * NVSceneCapturerUtils::UE4ToOpenCVMatrix;
+        ActorInput.InstanceId = Manager->ObjectInstanceSegmentation.GetInstanceId(CheckActor);
+    }
 
-        const FTransform ActorToWorld = CheckActor->GetActorTransform();
-        const FMatrix ActorToWorldUE = ActorToWorld.ToMatrixWithScale();
-        const FMatrix ActorToWorldCV = ActorToWorldUE * NVSceneCapturerUtils::UE4ToOpenCVMatrix;
-        const FMatrix ActorToCameraUE = ActorToWorldUE * WorldToCameraMatrixUE;
-        const FMatrix ActorToCameraCV = ActorToCameraUE * NVSceneCapturerUtils::UE4ToOpenCVMatrix;
+    FNVActorAnnotationCache::FActorState ActorState;
+    FNVActorAnnotationCache::FEntry *CachedEntry = nullptr;
+    if (bCacheStaticActorAnnotation)
+    {
+        ActorState.Update(CheckActor, ActorInput.InstanceId);
+        CachedEntry = ActorAnnotationCache.Find(CheckActor, ActorState);
+    }
 
-        ActorData.location_worldspace = NVSceneCapturerUtils::UE4ToOpenCVMatrix.TransformPosition(ActorToWorld.GetLocation());
-        ActorData.location = WorldToCameraMatrixCV.TransformPosition(ActorToWorld.GetLocation());
+    // NOTE: Only the inputs the annotation schema's fields need are gathered, the cache entries hold the same ones
+    if (CachedEntry)
+    {
+        ActorInput.Cuboid = CachedEntry->Cuboid;
+        if (AnnotationFields.NeedInput(ENVAnnotationInput::MeshVertexes))
+        {
+            ActorInput.MeshVertexSources = CachedEntry->MeshVertexSources;
+            GatherMeshBoundVertexSources(CheckActor, ProtectedDataExportSettings.bApproximateSkeletalBodiesWithBounds, ActorInput.MeshVertexSources, true);
+        }
+    }
+    else
+    {
+        // --- Generate cuboid -------------------------------------------------
+        if (AnnotationFields.NeedInput(ENVAnnotationInput::Cuboid))
+        {
+            switch (ProtectedDataExportSettings.BoundsType)
+            {
+            case ENVBoundsGenerationType::VE_TightOOBB:
+                ActorInput.Cuboid = NVSceneCapturerUtils::GetActorCuboid_OOBB_Complex(CheckActor);
+                break;
+            case ENVBoundsGenerationType::VE_AABB:
+                ActorInput.Cuboid = NVSceneCapturerUtils::GetActorCuboid_AABB(CheckActor);
+                break;
+            default:
+                ActorInput.Cuboid = NVSceneCapturerUtils::GetActorCuboid_OOBB_Simple(CheckActor, false);
+                break;
+            }
+        }
 
-        const UNVCapturableActorTag *Tag = Cast<UNVCapturableActorTag>(
-            CheckActor->GetComponentByClass(UNVCapturableActorTag::StaticClass()));
+        if (AnnotationFields.NeedInput(ENVAnnotationInput::MeshVertexes))
+        {
+            GatherMeshBoundVertexSources(CheckActor, ProtectedDataExportSettings.bApproximateSkeletalBodiesWithBounds, ActorInput.MeshVertexSources);
+        }
+    }
+
+    // --- Occlusion test simplified (unchanged logic) ---
+    const bool bNeedOcclusion = AnnotationFields.NeedInput(ENVAnnotationInput::Occlusion);
+    const bool bReuseOcclusion = CachedEntry && bCacheStaticActorOcclusion &&
+                                 ActorAnnotationCache.FindOcclusion(*CachedEntry, ViewContext.ViewLocation, ActorInput.OccludedVertexCount);
+    if (bNeedOcclusion && !bReuseOcclusion)
+    {
+        ActorInput.OccludedVertexCount = CountOccludedCuboidVertexes(World, CheckActor, ViewContext.ViewLocation, ActorInput.Cuboid);
+    }
 
-        ActorData.Name = ObjectName;
-        ActorData.Class = Tag ? Tag->Tag : ObjectName;
+    // Remaining occlusion voxel sampling logic unchanged
+    // ...
 
-        if (ANVSceneManager *Manager = ANVSceneManager::GetANVSceneManagerPtr())
+    if (bCacheStaticActorAnnotation)
+    {
+        if (CachedEntry)
         {
-            ActorData.instance_id = Manager->ObjectInstanceSegmentation.GetInstanceId(CheckActor);
+            CachedEntry->OcclusionViewLocation = ViewContext.ViewLocation;
+            CachedEntry->OccludedVertexCount = ActorInput.OccludedVertexCount;
         }
         else
         {
-            ActorData.instance_id = 0;
+            FNVActorAnnotationCache::FEntry NewEntry;
+            NewEntry.State = MoveTemp(ActorState);
+            NewEntry.Cuboid = ActorInput.Cuboid;
+            NewEntry.OcclusionViewLocation = ViewContext.ViewLocation;
+            NewEntry.OccludedVertexCount = ActorInput.OccludedVertexCount;
+            // NOTE: The instance mask bounding box mode doesn't gather the mesh geometry, those entries never need it
+            // The skeletal meshes' bodies aren't cached, their bones can move without changing the actor's bounds
+            for (const FNVMeshBoundVertexSource &VertexSource : ActorInput.MeshVertexSources)
+            {
+                if (!VertexSource.BodyHulls.IsValid())
+                    NewEntry.MeshVertexSources.Add(VertexSource);
+            }
+            ActorAnnotationCache.Add(CheckActor, MoveTemp(NewEntry));
         }
+    }
+
+    // NOTE: The sockets and custom data aren't cached, the sockets of skeletal meshes move with the animations
+    if (AnnotationFields.NeedInput(ENVAnnotationInput::Sockets) && Tag && (Tag->bExportAllMeshSocketInfo || Tag->SocketNameToExportList.Num() > 0))
+    {
+        TArray<UMeshComponent *> MeshComponents;
+        CheckActor->GetComponents(MeshComponents);
+        for (UMeshComponent *Comp : MeshComponents)
+        {
+            if (!Comp)
+                continue;
+
+            // NOTE: The sockets to export are resolved to their bones once per mesh, only the bone transforms are read each frame
+            const FNVMeshSocketTablePtr SocketTable = FNVMeshSocketTableCache::FindOrBuild(Comp, Tag->bExportAllMeshSocketInfo, Tag->SocketNameToExportList);
+            if (SocketTable.IsValid())
+            {
+                for (const FNVMeshSocketTableEntry &SocketEntry : SocketTable->Entries)
+                {
+                    ActorInput.SocketNames.Add(SocketEntry.SocketName);
+                }
+                FNVMeshSocketTableCache::GatherSocketWorldLocations(Comp, *SocketTable, ActorInput.SocketWorldLocations);
+                continue;
+            }
+
+            // The other mesh components' sockets are looked up by name
+            for (const FName SocketName : Comp->GetAllSocketNames())
+            {
+                if (Tag->bExportAllMeshSocketInfo || Tag->SocketNameToExportList.Contains(SocketName))
+                {
+                    ActorInput.SocketNames.Add(SocketName.ToString());
+                    ActorInput.SocketWorldLocations.Add(Comp->GetSocketLocation(SocketName));
+                }
+            }
+        }
+    }
+
+    const ANVAnnotatedActor *Annotated = Cast<ANVAnnotatedActor>(CheckActor);
+    if (Annotated && AnnotationFields.NeedInput(ENVAnnotationInput::CustomData))
+    {
+        ActorInput.CustomData = Annotated->GetCustomAnnotatedData();
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// GatherMeshInstanceInputs
+// ----------------------------------------------------------------------------
+bool UNVSceneFeatureExtractor_AnnotationData::GatherMeshInstanceInputs(const AActor *CheckActor, const FNVAnnotationViewContext &ViewContext, TArray<FNVActorAnnotationInput> &OutInstanceInputs)
+{
+    if (!OwnerViewpoint || !CheckActor || !ShouldExportActor(CheckActor))
+        return false;
+
+    UWorld *World = GetWorld();
+    if (!World)
+        return false;
+
+    TArray<UInstancedStaticMeshComponent *> InstancedMeshComps;
+    NVSceneCapturerUtils::GetExportedMeshInstanceComponents(CheckActor, InstancedMeshComps);
+    if (InstancedMeshComps.Num() == 0)
+        return false;
+
+    const UNVCapturableActorTag *Tag = CheckActor->FindComponentByClass<UNVCapturableActorTag>();
+    ANVSceneManager *Manager = ANVSceneManager::GetANVSceneManagerPtr();
+    for (const UInstancedStaticMeshComponent *InstancedMeshComp : InstancedMeshComps)
+    {
+        // NOTE: The instances share the geometry of their mesh, only their transform is read per instance
+        const FNVMeshGeometryData *MeshGeometry = FNVMeshGeometryCache::FindOrBuild(InstancedMeshComp->GetStaticMesh());
+        if (!MeshGeometry)
+            continue;
+
+        // NOTE: The instances' bounding box isn't filled in from the instance mask, they always need their vertexes for it
+        FNVMeshBoundVertexSource MeshVertexSource;
+        const bool bNeedVertexSource = AnnotationFields.NeedInput(ENVAnnotationInput::MeshVertexes)
+                                       || (ViewContext.bUseInstanceMaskBoundingBox && AnnotationFields.HasField(ENVAnnotationField::BoundingBox));
+        const bool bHasVertexSource = bNeedVertexSource && InitStaticMeshVertexSource(InstancedMeshComp->GetStaticMesh(), FTransform::Identity, MeshVertexSource);
+
+        const int32 InstanceCount = InstancedMeshComp->GetInstanceCount();
+        OutInstanceInputs.Reserve(OutInstanceInputs.Num() + InstanceCount);
+        for (int32 InstanceIndex = 0; InstanceIndex < InstanceCount; ++InstanceIndex)
+        {
+            FTransform InstanceTransform;
+            if (!InstancedMeshComp->GetInstanceTransform(InstanceIndex, InstanceTransform, true))
+                continue;
+
+            FNVActorAnnotationInput &InstanceInput = OutInstanceInputs.AddDefaulted_GetRef();
+            InstanceInput.Name = NVSceneCapturerUtils::GetMeshInstanceName(CheckActor, InstancedMeshComp, InstanceIndex);
+            InstanceInput.Class = Tag->Tag;
+            InstanceInput.ActorToWorld = InstanceTransform;
+            InstanceInput.bIsMeshInstance = true;
+            if (Manager)
+            {
+                InstanceInput.InstanceId = Manager->ObjectInstanceSegmentation.GetInstanceId(CheckActor, InstancedMeshComp, InstanceIndex);
+            }
+
+            if (AnnotationFields.NeedInput(ENVAnnotationInput::Cuboid))
+            {
+                InstanceInput.Cuboid = NVSceneCapturerUtils::GetMeshInstanceCuboid(*MeshGeometry, InstanceTransform, ProtectedDataExportSettings.BoundsType);
+            }
+            if (AnnotationFields.NeedInput(ENVAnnotationInput::Occlusion))
+            {
+                // NOTE: The other instances of the actor don't occlude the instance, like the actor's own meshes
+                InstanceInput.OccludedVertexCount = CountOccludedCuboidVertexes(World, CheckActor, ViewContext.ViewLocation, InstanceInput.Cuboid);
+            }
+
+            if (bHasVertexSource)
+            {
+                FNVMeshBoundVertexSource &InstanceVertexSource = InstanceInput.MeshVertexSources.Add_GetRef(MeshVertexSource);
+                InstanceVertexSource.MeshTransform = InstanceTransform;
+            }
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// ComputeActorData
+// ----------------------------------------------------------------------------
+void UNVSceneFeatureExtractor_AnnotationData::ComputeActorData(const FNVAnnotationViewContext &ViewContext, const FNVAnnotationFieldSet &AnnotationFields,
+                                                               const FNVActorAnnotationInput &ActorInput, FCapturedObjectData &ActorData)
+{
+    const FMatrix &WorldToCameraMatrixUE = ViewContext.WorldToCameraMatrixUE;
+    const FMatrix &WorldToCameraMatrixCV = ViewContext.WorldToCameraMatrixCV;
+    const FVector &ViewLocation = ViewContext.ViewLocation;
+    const FTransform &ActorToWorld = ActorInput.ActorToWorld;
+
+    ActorData.Name = ActorInput.Name;
+    ActorData.Class = ActorInput.Class;
+    ActorData.instance_id = ActorInput.InstanceId;
+
+    // NOTE: Only the fields of the annotation schema and the ones they depend on are computed
+    const bool bHasPose = AnnotationFields.HasField(ENVAnnotationField::Location)
+                          || AnnotationFields.HasField(ENVAnnotationField::Rotation)
+                          || AnnotationFields.HasField(ENVAnnotationField::PoseTransform);
+    if (bHasPose)
+    {
+        const FMatrix ActorToWorldUE = ActorToWorld.ToMatrixWithScale();
+        const FMatrix ActorToWorldCV = ActorToWorldUE * NVSceneCapturerUtils::UE4ToOpenCVMatrix;
+        const FMatrix ActorToCameraUE = ActorToWorldUE * WorldToCameraMatrixUE;
+        const FMatrix ActorToCameraCV = ActorToCameraUE * NVSceneCapturerUtils::UE4ToOpenCVMatrix;
+
+        ActorData.location_worldspace = NVSceneCapturerUtils::UE4ToOpenCVMatrix.TransformPosition(ActorToWorld.GetLocation());
+        ActorData.location = WorldToCameraMatrixCV.TransformPosition(ActorToWorld.GetLocation());
 
         ActorData.quaternion_worldspace =
             NVSceneCapturerUtils::ConvertQuaternionToOpenCVCoordinateSystem(
@@ -211,30 +578,37 @@ bool UNVSceneFeatureExtractor_AnnotationData::GatherActorData(const AActor *Chec
         ActorData.actor_to_world_matrix_ue4 = ActorToWorldUE;
         ActorData.actor_to_world_matrix_opencv = ActorToWorldCV;
 
-        UMeshComponent *MeshComp = NVSceneCapturerUtils::GetFirstValidMeshComponent(CheckActor);
-        if (!MeshComp)
-            return false;
+        const FVector ActorForward = ActorToWorld.GetRotation().Vector();
+        ActorData.bounding_box_forward_direction = ActorForward;
 
-        // --- Generate cuboid -------------------------------------------------
-        FNVCuboidData Cuboid;
-        switch (ProtectedDataExportSettings.BoundsType)
-        {
-        case ENVBoundsGenerationType::VE_TightOOBB:
-            Cuboid = NVSceneCapturerUtils::GetActorCuboid_OOBB_Complex(CheckActor);
-            break;
-        case ENVBoundsGenerationType::VE_AABB:
-            Cuboid = NVSceneCapturerUtils::GetActorCuboid_AABB(CheckActor);
-            break;
-        default:
-            Cuboid = NVSceneCapturerUtils::GetActorCuboid_OOBB_Simple(CheckActor, false);
-            break;
-        }
+        float Azimuth = 0.f, Altitude = 0.f;
+        NVSceneCapturerUtils::CalculateSphericalCoordinate(ViewLocation, ActorToWorld.GetLocation(), ActorForward, Azimuth, Altitude);
+        ActorData.viewpoint_azimuth_angle = Azimuth;
+        ActorData.viewpoint_altitude_angle = Altitude;
 
+        const float Distance = FVector::Dist(ActorToWorld.GetLocation(), ViewLocation);
+        const float Range = ViewContext.DistanceScaleRange.Size();
+        ActorData.distance_scale = Range > 0.f
+                                       ? (Distance - ViewContext.DistanceScaleRange.Min) / Range
+                                       : (Distance >= ViewContext.DistanceScaleRange.Max ? 1.f : 0.f);
+    }
+
+    const FNVCuboidData &Cuboid = ActorInput.Cuboid;
+    if (AnnotationFields.NeedInput(ENVAnnotationInput::Cuboid))
+    {
+        const bool bHasProjectedCuboid = AnnotationFields.HasField(ENVAnnotationField::ProjectedCuboid);
+        const bool bHasCuboid = AnnotationFields.HasField(ENVAnnotationField::Cuboid);
         for (const FVector &Vertex : Cuboid.Vertexes)
         {
-            const FVector ImgPt = ProjectWorldPositionToImagePosition(Vertex);
-            ActorData.projected_cuboid.Add(FVector2D(ImgPt.X, ImgPt.Y));
-            ActorData.cuboid.Add(WorldToCameraMatrixCV.TransformPosition(Vertex));
+            if (bHasProjectedCuboid)
+            {
+                const FVector ImgPt = ViewContext.ProjectWorldPositionToImagePosition(Vertex);
+                ActorData.projected_cuboid.Add(FVector2D(ImgPt.X, ImgPt.Y));
+            }
+            if (bHasCuboid)
+            {
+                ActorData.cuboid.Add(WorldToCameraMatrixCV.TransformPosition(Vertex));
+            }
         }
 
         ActorData.dimensions_worldspace = NVSceneCapturerUtils::ConvertDimensionToOpenCVCoordinateSystem(Cuboid.GetDimension());
@@ -242,27 +616,29 @@ bool UNVSceneFeatureExtractor_AnnotationData::GatherActorData(const AActor *Chec
         const FVector BB_Center = Cuboid.GetCenter();
         ActorData.bounding_box_center_worldspace = NVSceneCapturerUtils::UE4ToOpenCVMatrix.TransformPosition(BB_Center);
         ActorData.cuboid_centroid = WorldToCameraMatrixCV.TransformPosition(BB_Center);
-        ActorData.projected_cuboid_centroid = FVector2D(ProjectWorldPositionToImagePosition(BB_Center));
-
-        const FVector ActorForward = ActorToWorld.GetRotation().Vector();
-        ActorData.bounding_box_forward_direction = ActorForward;
+        ActorData.projected_cuboid_centroid = FVector2D(ViewContext.ProjectWorldPositionToImagePosition(BB_Center));
 
-        const FVector ForwardPt = ActorData.bounding_box_center_worldspace + ActorForward * 10.f;
+        const FVector ForwardPt = ActorData.bounding_box_center_worldspace + ActorToWorld.GetRotation().Vector() * 10.f;
         ActorData.bounding_box_forward_direction_imagespace =
-            (FVector2D(ProjectWorldPositionToImagePosition(ForwardPt)) - ActorData.projected_cuboid_centroid).GetSafeNormal();
-
-        float Azimuth = 0.f, Altitude = 0.f;
-        NVSceneCapturerUtils::CalculateSphericalCoordinate(ViewLocation, ActorToWorld.GetLocation(), ActorForward, Azimuth, Altitude);
-        ActorData.viewpoint_azimuth_angle = Azimuth;
-        ActorData.viewpoint_altitude_angle = Altitude;
-
-        const float Distance = FVector::Dist(ActorToWorld.GetLocation(), ViewLocation);
-        const float Range = ProtectedDataExportSettings.DistanceScaleRange.Size();
-        ActorData.distance_scale = Range > 0.f
-                                       ? (Distance - ProtectedDataExportSettings.DistanceScaleRange.Min) / Range
-                                       : (Distance >= ProtectedDataExportSettings.DistanceScaleRange.Max ? 1.f : 0.f);
+            (FVector2D(ViewContext.ProjectWorldPositionToImagePosition(ForwardPt)) - ActorData.projected_cuboid_centroid).GetSafeNormal();
+    }
 
-        FBox2D BB2D = GetBoundingBox2D(CheckActor, false);
+    if (AnnotationFields.HasField(ENVAnnotationField::BoundingBox))
+    {
+        FBox2D BB2D(EForceInit::ForceInitToZero);
+        if (ViewContext.bUseInstanceMaskBoundingBox && !ActorInput.bIsMeshInstance)
+        {
+            // NOTE: The exporter fill in the bounding box from the instance mask later,
+            // the projected cuboid is only used to estimate how much of the object is truncated
+            for (const FVector2D &ProjectedVertex : ActorData.projected_cuboid)
+            {
+                BB2D += ProjectedVertex;
+            }
+        }
+        else
+        {
+            BB2D = GetBoundingBox2D(ViewContext, ActorInput.MeshVertexSources, false);
+        }
         FBox2D ClampedBB = BB2D;
         ClampedBB.Min.X = FMath::Clamp(BB2D.Min.X, 0.f, 1.f);
         ClampedBB.Min.Y = FMath::Clamp(BB2D.Min.Y, 0.f, 1.f);
@@ -270,60 +646,35 @@ bool UNVSceneFeatureExtractor_AnnotationData::GatherActorData(const AActor *Chec
         ClampedBB.Max.Y = FMath::Clamp(BB2D.Max.Y, 0.f, 1.f);
         ActorData.bounding_box = BB2D;
 
-        // --- Occlusion test simplified (unchanged logic) ---
-        int OccludedPts = 0;
-        for (const FVector &V : Cuboid.Vertexes)
-        {
-            FHitResult Hit;
-            FCollisionQueryParams Params(SCENE_QUERY_STAT(LineTrace), true);
-            Params.AddIgnoredActor(CheckActor);
-            if (World->LineTraceSingleByChannel(Hit, ViewLocation, V, ECC_Visibility, Params))
-            {
-                OccludedPts++;
-            }
-        }
-
-        ActorData.occluded = (OccludedPts > 4) ? 2 : (OccludedPts > 0 ? 1 : 0);
-
-        // Remaining occlusion voxel sampling logic unchanged
-        // ...
-
         const float ClampedArea = ClampedBB.GetArea();
         const float FullArea = BB2D.GetArea();
         ActorData.truncated = (FullArea > 0.f) ? (1.f - (ClampedArea / FullArea)) : 1.f;
+    }
 
-        if (Tag)
-        {
-            TArray<UMeshComponent *> MeshComponents;
-            CheckActor->GetComponents(MeshComponents);
-            if (Tag->bExportAllMeshSocketInfo || Tag->SocketNameToExportList.Num() > 0)
-            {
-                for (UMeshComponent *Comp : MeshComponents)
-                {
-                    if (!Comp)
-                        continue;
-                    for (const FName SocketName : Comp->GetAllSocketNames())
-                    {
-                        if (Tag->bExportAllMeshSocketInfo || Tag->SocketNameToExportList.Contains(SocketName))
-                        {
-                            const FVector SocketWorld = Comp->GetSocketLocation(SocketName);
-                            const FVector ImgPos = ProjectWorldPositionToImagePosition(SocketWorld);
-                            FNVSocketData NewSocket;
-                            NewSocket.SocketName = SocketName.ToString();
-                            NewSocket.SocketLocation = FVector2D(ImgPos.X, ImgPos.Y);
-                            ActorData.socket_data.Add(NewSocket);
-                        }
-                    }
-                }
-            }
-        }
+    if (AnnotationFields.HasField(ENVAnnotationField::Visibility))
+    {
+        const int32 OccludedPts = ActorInput.OccludedVertexCount;
+        ActorData.occluded = (OccludedPts > 4) ? 2 : (OccludedPts > 0 ? 1 : 0);
+    }
 
-        if (const ANVAnnotatedActor *Annotated = Cast<ANVAnnotatedActor>(CheckActor))
+    if (AnnotationFields.HasField(ENVAnnotationField::Sockets))
+    {
+        TArray<FVector> SocketImagePositions;
+        ViewContext.ProjectWorldPositionsToImagePositions(ActorInput.SocketWorldLocations, SocketImagePositions);
+        ActorData.socket_data.Reserve(ActorInput.SocketNames.Num());
+        for (int32 i = 0; i < ActorInput.SocketNames.Num(); ++i)
         {
-            ActorData.custom_data = Annotated->GetCustomAnnotatedData();
+            FNVSocketData NewSocket;
+            NewSocket.SocketName = ActorInput.SocketNames[i];
+            NewSocket.SocketLocation = FVector2D(SocketImagePositions[i].X, SocketImagePositions[i].Y);
+            ActorData.socket_data.Add(NewSocket);
         }
     }
-    return true;
+
+    if (AnnotationFields.HasField(ENVAnnotationField::CustomData))
+    {
+        ActorData.custom_data = ActorInput.CustomData;
+    }
 }
 
 // ----------------------------------------------------------------------------
@@ -385,44 +736,66 @@ bool UNVSceneFeatureExtractor_AnnotationData::IsActorInViewFrustum(const FConvex
 // ----------------------------------------------------------------------------
 FVector UNVSceneFeatureExtractor_AnnotationData::ProjectWorldPositionToImagePosition(const FVector &WorldPosition) const
 {
-    FPlane P = ViewProjectionMatrix.TransformFVector4(FVector4(WorldPosition, 1));
-    if (FMath::IsNearlyZero(P.W))
-        P.W = KINDA_SMALL_NUMBER;
-
-    const float RHW = 1.f / P.W;
-    FVector PlanePos(P.X * RHW, P.Y * RHW, P.Z * RHW);
-    if (P.W <= 0.f)
-        PlanePos.Z = 0.f;
-
-    FVector ImgPos;
-    ImgPos.X = 0.5f * (PlanePos.X + 1.f);
-    ImgPos.Y = 0.5f * (-PlanePos.Y + 1.f);
-    ImgPos.Z = PlanePos.Z;
-
-    if (ProtectedDataExportSettings.bExportImageCoordinateInPixel)
-    {
-        const auto &S = OwnerViewpoint->GetCapturerSettings().CapturedImageSize;
-        ImgPos.X *= S.Width;
-        ImgPos.Y *= S.Height;
-    }
-    return ImgPos;
+    return MakeAnnotationViewContext().ProjectWorldPositionToImagePosition(WorldPosition);
 }
 
 // ----------------------------------------------------------------------------
 // GetBoundingBox2D & Calculate2dAABB
 // ----------------------------------------------------------------------------
-FBox2D UNVSceneFeatureExtractor_AnnotationData::GetBoundingBox2D(const AActor *CheckActor, bool bClampToImage) const
+void UNVSceneFeatureExtractor_AnnotationData::GatherMeshBoundVertexSources(const AActor *CheckActor, bool bUseSkeletalBodyBounds, TArray<FNVMeshBoundVertexSource> &OutVertexSources,
+                                                                           bool bSkeletalMeshesOnly /*= false*/)
 {
-    FBox2D OutBox(EForceInit::ForceInitToZero);
     if (!CheckActor)
-        return OutBox;
+        return;
 
     TArray<UMeshComponent *> MeshComponents;
     CheckActor->GetComponents(MeshComponents);
     for (const UMeshComponent *Comp : MeshComponents)
     {
-        if (Comp)
-            OutBox += Calculate2dAABB_MeshComplexCollision(Comp, bClampToImage);
+        FNVMeshBoundVertexSource VertexSource;
+        if (const UStaticMeshComponent *StaticMeshComp = Cast<UStaticMeshComponent>(Comp))
+        {
+            if (bSkeletalMeshesOnly)
+                continue;
+
+            InitStaticMeshVertexSource(StaticMeshComp->GetStaticMesh(), StaticMeshComp->GetComponentTransform(), VertexSource);
+        }
+        else if (const USkeletalMeshComponent *SkeletalMeshComp = Cast<USkeletalMeshComponent>(Comp))
+        {
+            const USkeletalMesh *SkeletalMesh = SkeletalMeshComp->GetSkeletalMeshAsset();
+            const UPhysicsAsset *PhysicsAsset = SkeletalMesh ? SkeletalMesh->GetPhysicsAsset() : nullptr;
+
+            // NOTE: The body shapes are built once per physics asset, only the bone transforms are read each frame
+            // The bodies are projected later with the rest of the annotation, on the worker threads
+            VertexSource.BodyHulls = FNVSkeletalBodyHullCache::FindOrBuild(PhysicsAsset);
+            if (!VertexSource.BodyHulls.IsValid())
+                continue;
+
+            const FTransform &ComponentTransform = SkeletalMeshComp->GetComponentTransform();
+            VertexSource.MeshTransform = ComponentTransform;
+            VertexSource.bUseBodyBoundsCorners = bUseSkeletalBodyBounds;
+            VertexSource.BodyTransforms.Reserve(VertexSource.BodyHulls->Bodies.Num());
+            for (const FNVSkeletalBodyHull &BodyHull : VertexSource.BodyHulls->Bodies)
+            {
+                const int32 BoneIndex = SkeletalMeshComp->GetBoneIndex(BodyHull.BoneName);
+                VertexSource.BodyTransforms.Add((BoneIndex != INDEX_NONE) ? SkeletalMeshComp->GetBoneTransform(BoneIndex) : ComponentTransform);
+            }
+        }
+
+        if (!VertexSource.ConvexVertexes.IsEmpty() || VertexSource.PositionVertexBuffer || VertexSource.BodyHulls.IsValid())
+        {
+            OutVertexSources.Add(MoveTemp(VertexSource));
+        }
+    }
+}
+
+FBox2D UNVSceneFeatureExtractor_AnnotationData::GetBoundingBox2D(const FNVAnnotationViewContext &ViewContext,
+                                                                 const TArray<FNVMeshBoundVertexSource> &VertexSources, bool bClampToImage)
+{
+    FBox2D OutBox(EForceInit::ForceInitToZero);
+    for (const FNVMeshBoundVertexSource &VertexSource : VertexSources)
+    {
+        OutBox += Calculate2dAABB(ViewContext, VertexSource, bClampToImage);
     }
 
     if (OutBox.GetArea() <= 0.f)
@@ -431,90 +804,64 @@ FBox2D UNVSceneFeatureExtractor_AnnotationData::GetBoundingBox2D(const AActor *C
     return OutBox;
 }
 
-FBox2D UNVSceneFeatureExtractor_AnnotationData::Calculate2dAABB(
-    TArray<FVector> Vertexes, bool bClampToImage) const
+FBox2D UNVSceneFeatureExtractor_AnnotationData::Calculate2dAABB(const FNVAnnotationViewContext &ViewContext,
+                                                                const FNVMeshBoundVertexSource &VertexSource, bool bClampToImage)
 {
     FBox2D Box(EForceInit::ForceInitToZero);
-    for (const FVector &V : Vertexes)
+    auto AddImagePosition = [bClampToImage, &Box](FVector P)
     {
-        FVector P = ProjectWorldPositionToImagePosition(V);
         if (bClampToImage)
         {
             P.X = FMath::Clamp(P.X, 0.f, 1.f);
             P.Y = FMath::Clamp(P.Y, 0.f, 1.f);
         }
         Box += FVector2D(P.X, P.Y);
-    }
-    return Box;
-}
-
-FBox2D UNVSceneFeatureExtractor_AnnotationData::Calculate2dAABB_MeshComplexCollision(
-    const UMeshComponent *CheckMeshComp, bool bClampToImage) const
-{
-    FBox2D BBox2D(EForceInit::ForceInitToZero);
-    TArray<FVector> BoundVertexes;
+    };
+    auto AddVertex = [&ViewContext, &VertexSource, &AddImagePosition](const FVector &LocalVertex)
+    {
+        AddImagePosition(ViewContext.ProjectWorldPositionToImagePosition(VertexSource.MeshTransform.TransformPosition(LocalVertex)));
+    };
 
-    if (const UStaticMeshComponent *StaticMeshComp = Cast<UStaticMeshComponent>(CheckMeshComp))
+    for (const TArrayView<const FVector> &ConvexVertexes : VertexSource.ConvexVertexes)
     {
-        const FTransform &MeshTransform = StaticMeshComp->GetComponentTransform();
-        const UStaticMesh *StaticMesh = StaticMeshComp->GetStaticMesh();
+        for (const FVector &V : ConvexVertexes)
+            AddVertex(V);
+    }
 
-        if (StaticMesh)
+    if (VertexSource.PositionVertexBuffer)
+    {
+        const FPositionVertexBuffer &VB = *VertexSource.PositionVertexBuffer;
+        const uint32 VertexCount = VB.GetNumVertices();
+        for (uint32 i = 0; i < VertexCount; ++i)
         {
-            if (const UBodySetup *BodySetup = StaticMesh->GetBodySetup())
-            {
-                for (const FKConvexElem &ConvexElem : BodySetup->AggGeom.ConvexElems)
-                {
-                    for (const FVector &V : ConvexElem.VertexData)
-                        BoundVertexes.Add(MeshTransform.TransformPosition(V));
-                }
-            }
-
-            if (BoundVertexes.IsEmpty())
-            {
-                if (const FStaticMeshRenderData *RenderData = StaticMesh->GetRenderData())
-                {
-                    if (RenderData->LODResources.Num() > 0)
-                    {
-                        const FPositionVertexBuffer &VB =
-                            RenderData->LODResources[0].VertexBuffers.PositionVertexBuffer;
-                        const uint32 VertexCount = VB.GetNumVertices();
-                        for (uint32 i = 0; i < VertexCount; ++i)
-                        {
-                            // explicit conversion from FVector3f → FVector
-                            const FVector VertexPos(VB.VertexPosition(i));
-                            BoundVertexes.Add(MeshTransform.TransformPosition(VertexPos));
-                        }
-                    }
-                }
-            }
+            // explicit conversion from FVector3f → FVector
+            AddVertex(FVector(VB.VertexPosition(i)));
         }
     }
-    else if (const USkeletalMeshComponent *SkeletalMeshComp = Cast<USkeletalMeshComponent>(CheckMeshComp))
+
+    if (VertexSource.BodyHulls.IsValid())
     {
-        if (const USkeletalMesh *SkeletalMesh = SkeletalMeshComp->GetSkeletalMeshAsset())
+        const TArray<FNVSkeletalBodyHull> &Bodies = VertexSource.BodyHulls->Bodies;
+        check(VertexSource.BodyTransforms.Num() == Bodies.Num());
+        for (int32 BodyIndex = 0; BodyIndex < Bodies.Num(); ++BodyIndex)
         {
-            if (const UPhysicsAsset *PhysicsAsset = SkeletalMesh->GetPhysicsAsset())
+            const FNVSkeletalBodyHull &BodyHull = Bodies[BodyIndex];
+            const TArray<FVector3f> &BodyVertexes = VertexSource.bUseBodyBoundsCorners ? BodyHull.BoundsCorners : BodyHull.Vertexes;
+
+            // NOTE: The bone and view projection are combined in one matrix so each vertex is a single SIMD transform,
+            // the body vertexes are close to their bone so the float matrix keeps the precision
+            const FMatrix44f BodyToClip(VertexSource.BodyTransforms[BodyIndex].ToMatrixWithScale() * ViewContext.ViewProjectionMatrix);
+            for (const FVector3f &BodyVertex : BodyVertexes)
             {
-                const FTransform &MeshTransform = SkeletalMeshComp->GetComponentTransform();
-                for (const USkeletalBodySetup *BodySetup : PhysicsAsset->SkeletalBodySetups)
-                {
-                    if (!BodySetup)
-                        continue;
-                    for (const FKConvexElem &ConvexElem : BodySetup->AggGeom.ConvexElems)
-                    {
-                        for (const FVector &V : ConvexElem.VertexData)
-                            BoundVertexes.Add(MeshTransform.TransformPosition(V));
-                    }
-                }
+                const VectorRegister4Float ClipPosition = VectorTransformVector(VectorLoadFloat3_W1(&BodyVertex.X), &BodyToClip);
+                alignas(16) float ClipPositionValues[4];
+                VectorStoreAligned(ClipPosition, ClipPositionValues);
+                AddImagePosition(ViewContext.ProjectClipPositionToImagePosition(
+                    FVector4(ClipPositionValues[0], ClipPositionValues[1], ClipPositionValues[2], ClipPositionValues[3])));
             }
         }
     }
-
-    if (!BoundVertexes.IsEmpty())
-        BBox2D = Calculate2dAABB(BoundVertexes, bClampToImage);
-
-    return BBox2D;
+    return Box;
 }
 
 //=========================================== FNVDataExportSettings ===========================================
@@ -526,5 +873,6 @@ FNVDataExportSettings::FNVDataExportSettings()
     BoundingBox2dType = ENVBoundBox2dGenerationType::FromMeshBodyCollision;
     bOutputEvenIfNoObjectsAreInView = true;
     DistanceScaleRange = FFloatInterval(100.f, 1000.f);
+    bApproximateSkeletalBodiesWithBounds = false;
     bExportImageCoordinateInPixel = true;
 }
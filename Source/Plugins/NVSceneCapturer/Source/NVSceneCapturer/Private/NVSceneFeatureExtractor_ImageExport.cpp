@@ -36,6 +36,7 @@ UNVSceneFeatureExtractor_PixelData::UNVSceneFeatureExtractor_PixelData(const FOb
     OverrideTexturePixelFormat = EPixelFormat::PF_Unknown;
     PostProcessBlendWeight = 1.f;
     CaptureSource = ESceneCaptureSource::SCS_FinalColorLDR;
+    RenderProfile = FNVRenderProfile(ENVRenderProfilePreset::FullLighting);
     SceneCaptureComponent = nullptr;
 }
 
@@ -62,14 +63,13 @@ UNVSceneCaptureComponent2D *UNVSceneFeatureExtractor_PixelData::CreateSceneCaptu
         if (NewSceneCaptureComp2D)
         {
             NewSceneCaptureComp2D->SetupAttachment(OwnerViewpoint);
-            if (bOverrideShowFlagSettings)
-            {
-                NewSceneCaptureComp2D->SetShowFlagSettings(OverrideShowFlagSettings);
-            }
+            RenderProfile.ApplyToSceneCapture(NewSceneCaptureComp2D, bOverrideShowFlagSettings ? OverrideShowFlagSettings : TArray<FEngineShowFlagsSetting>());
 
             const auto& CapturerSettings = OwnerViewpoint->GetCapturerSettings();
 
-            NewSceneCaptureComp2D->TextureTargetSize = CapturerSettings.CapturedImageSize;
+            // NOTE: The render target only hold one tile at a time when the images are captured tile by tile
+            const FIntPoint CapturedTextureSize = OwnerViewpoint->GetCapturedTextureSize();
+            NewSceneCaptureComp2D->TextureTargetSize = FNVImageSize(CapturedTextureSize.X, CapturedTextureSize.Y);
             NewSceneCaptureComp2D->FOVAngle = CapturerSettings.GetFOVAngle();
             if (CapturerSettings.bUseExplicitCameraIntrinsic)
             {
@@ -169,6 +169,63 @@ bool UNVSceneFeatureExtractor_PixelData::CaptureSceneToPixelsData(UNVSceneFeatur
     return bIsSucceeded;
 }
 
+int32 UNVSceneFeatureExtractor_PixelData::CaptureSceneTilesToPixelsData(const TArray<FNVCaptureTile>& Tiles, UNVSceneFeatureExtractor_PixelData::OnFinishedCaptureSceneTileCallback InCallback)
+{
+    int32 CapturedTileCount = 0;
+
+    if (InCallback)
+    {
+        for (auto& SceneCaptureComp2DData : SceneCaptureComp2DDataList)
+        {
+            auto CheckSceneCaptureComp2D = SceneCaptureComp2DData.SceneCaptureComp2D;
+            if (CheckSceneCaptureComp2D)
+            {
+                CapturedTileCount += CheckSceneCaptureComp2D->CaptureSceneTilesToPixelsData(Tiles,
+                    [this, Callback = InCallback](const FNVTexturePixelData& CapturedPixelData, const FNVCaptureTile& CapturedTile)
+                {
+                    Callback(CapturedPixelData, CapturedTile, this);
+                });
+            }
+        }
+    }
+    return CapturedTileCount;
+}
+
+int32 UNVSceneFeatureExtractor_PixelData::GetCapturedPixelsDataCount() const
+{
+    int32 CapturedPixelsDataCount = 0;
+    for (const auto& SceneCaptureComp2DData : SceneCaptureComp2DDataList)
+    {
+        if (SceneCaptureComp2DData.SceneCaptureComp2D)
+        {
+            CapturedPixelsDataCount++;
+        }
+    }
+    return CapturedPixelsDataCount;
+}
+
+void UNVSceneFeatureExtractor_PixelData::GetSceneCaptureComponents(TArray<UNVSceneCaptureComponent2D*>& OutSceneCaptureComponents) const
+{
+    for (const auto& SceneCaptureComp2DData : SceneCaptureComp2DDataList)
+    {
+        if (SceneCaptureComp2DData.SceneCaptureComp2D)
+        {
+            OutSceneCaptureComponents.Add(SceneCaptureComp2DData.SceneCaptureComp2D);
+        }
+    }
+}
+
+void UNVSceneFeatureExtractor_PixelData::SetReadbackRegion(const FIntRect& NewReadbackRegion)
+{
+    for (auto& SceneCaptureComp2DData : SceneCaptureComp2DDataList)
+    {
+        if (SceneCaptureComp2DData.SceneCaptureComp2D)
+        {
+            SceneCaptureComp2DData.SceneCaptureComp2D->SetReadbackRegion(NewReadbackRegion);
+        }
+    }
+}
+
 void UNVSceneFeatureExtractor_PixelData::UpdateCapturerSettings()
 {
     if (OwnerViewpoint)
@@ -222,6 +279,7 @@ UNVSceneFeatureExtractor_SceneDepth::UNVSceneFeatureExtractor_SceneDepth(const F
     DisplayName = TEXT("Depth");
     MaxDepthDistance = 3000.f;
 	CapturedPixelFormat = ENVCapturedPixelFormat::R8;
+    RenderProfile = FNVRenderProfile(ENVRenderProfilePreset::GeometryOnly);
 }
 
 void UNVSceneFeatureExtractor_SceneDepth::UpdateMaterial()
@@ -239,6 +297,13 @@ void UNVSceneFeatureExtractor_SceneDepth::UpdateMaterial()
 UNVSceneFeatureExtractor_ScenePixelVelocity::UNVSceneFeatureExtractor_ScenePixelVelocity(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
     DisplayName = TEXT("PixelVelocity");
+    RenderProfile = FNVRenderProfile(ENVRenderProfilePreset::GeometryOnly);
+
+    // NOTE: Keep the motion blur so the engine still render the velocity buffer
+    FEngineShowFlagsSetting MotionBlurShowFlagSetting;
+    MotionBlurShowFlagSetting.ShowFlagName = TEXT("MotionBlur");
+    MotionBlurShowFlagSetting.Enabled = true;
+    RenderProfile.AdditionalShowFlagSettings.Add(MotionBlurShowFlagSetting);
 }
 
 void UNVSceneFeatureExtractor_ScenePixelVelocity::UpdateSettings()
@@ -263,6 +328,7 @@ UNVSceneFeatureExtractor_StencilMask::UNVSceneFeatureExtractor_StencilMask(const
 {
     DisplayName = TEXT("StencilMask");
 	CapturedPixelFormat = ENVCapturedPixelFormat::R8;
+    RenderProfile = FNVRenderProfile(ENVRenderProfilePreset::GeometryOnly);
 }
 
 void UNVSceneFeatureExtractor_StencilMask::UpdateSettings()
@@ -281,6 +347,15 @@ UNVSceneFeatureExtractor_VertexColorMask::UNVSceneFeatureExtractor_VertexColorMa
     : Super(ObjectInitializer)
 {
     DisplayName = TEXT("VertexColorMask");
+    RenderProfile = FNVRenderProfile(ENVRenderProfilePreset::UnlitVertexColor);
+    bExportClassSegmentationMask = false;
+    ClassSegmentationMaskFileNamePostfix = TEXT("cs");
+}
+
+FString UNVSceneFeatureExtractor_VertexColorMask::GetClassSegmentationMaskFilePath(const FString& InstanceMaskFilePath) const
+{
+    const FString FileNamePostfix = ClassSegmentationMaskFileNamePostfix.IsEmpty() ? FString(TEXT("cs")) : ClassSegmentationMaskFileNamePostfix;
+    return FPaths::GetBaseFilename(InstanceMaskFilePath, false) + TEXT(".") + FileNamePostfix + FPaths::GetExtension(InstanceMaskFilePath, true);
 }
 
 void UNVSceneFeatureExtractor_VertexColorMask::UpdateSettings()
@@ -293,23 +368,7 @@ void UNVSceneFeatureExtractor_VertexColorMask::UpdateSettings()
         // Since the VertexColor render mode doesn't use alpha and cleared it, we should ignore it when trying to read back pixels value
         SceneCaptureComponent->bIgnoreReadbackAlpha = true;
         SceneCaptureComponent->PostProcessBlendWeight = 0.f;
-        SceneCaptureComponent->ShowFlags = FEngineShowFlags(EShowFlagInitMode::ESFIM_Game);
-        // Check Engine\Source\Editor\MeshPaint\Private\MeshPaintHelpers.cpp
-        // Use VertexColor to render objects, and disable the post-process and lighting ...
-        FEngineShowFlags& OverrideShowFlags = SceneCaptureComponent->ShowFlags;
-        OverrideShowFlags.SetMaterials(true);
-        OverrideShowFlags.SetLighting(false);
-        OverrideShowFlags.SetBSPTriangles(true);
-        OverrideShowFlags.SetVertexColors(true);
-        OverrideShowFlags.SetPostProcessing(false);
-        OverrideShowFlags.SetHMDDistortion(false);
-        OverrideShowFlags.SetAntiAliasing(false);
-        OverrideShowFlags.SetMotionBlur(false);
-        OverrideShowFlags.SetSeparateTranslucency(false);
-        OverrideShowFlags.SetSelection(true);
-        OverrideShowFlags.SetVignette(false);
-        OverrideShowFlags.SetTonemapper(false);
-        OverrideShowFlags.SetColorGrading(false);
+        // NOTE: The vertex colors are rendered unlit without any post-process, the show flags come from the render profile
 
         if (SceneCaptureComponent->TextureTarget)
         {
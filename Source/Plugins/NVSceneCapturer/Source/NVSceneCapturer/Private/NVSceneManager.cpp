@@ -34,6 +34,7 @@ ANVSceneManager::ANVSceneManager(const FObjectInitializer& ObjectInitializer) :
     SceneManagerState = ENVSceneManagerState::NotActive;
     CurrentSceneMarker = nullptr;
     bAutoExitAfterExportingComplete = true;
+    bResumeFromCheckpoint = false;
 }
 
 ANVSceneManager* ANVSceneManager::GetANVSceneManagerPtr()
@@ -54,6 +55,11 @@ void ANVSceneManager::ResetState()
     }
 }
 
+int32 ANVSceneManager::GetCurrentMarkerIndex() const
+{
+    return CurrentMarkerIndex;
+}
+
 bool ANVSceneManager::IsAllSceneCaptured() const
 {
     return !bCaptureAtAllMarkers || (CurrentMarkerIndex >= SceneMarkers.Num() - 1);
@@ -146,7 +152,8 @@ void ANVSceneManager::BeginPlay()
 
             if (bCaptureAtAllMarkers)
             {
-                CurrentMarkerIndex = -1;
+                // The markers before the resumed one are already captured
+                CurrentMarkerIndex = bResumeFromCheckpoint ? (GetResumeMarkerIndex() - 1) : -1;
                 FocusNextMarker();
             }
             else
@@ -162,6 +169,8 @@ void ANVSceneManager::UpdateSettingsFromCommandLine()
 {
     const auto CommandLine = FCommandLine::Get();
 
+    bResumeFromCheckpoint = FParse::Param(CommandLine, TEXT("Resume"));
+
     FString OverrideCapturers = TEXT("");
     if (FParse::Value(CommandLine, TEXT("-Capturers="), OverrideCapturers))
     {
@@ -200,6 +209,21 @@ void ANVSceneManager::UpdateSettingsFromCommandLine()
     }
 }
 
+int32 ANVSceneManager::GetResumeMarkerIndex()
+{
+    int32 ResumeMarkerIndex = INDEX_NONE;
+    for (ANVSceneCapturerActor* CheckCapturer : SceneCapturers)
+    {
+        if (CheckCapturer && CheckCapturer->bIsActive)
+        {
+            FNVCaptureCheckpoint CapturerCheckpoint;
+            const int32 CapturerMarkerIndex = CheckCapturer->LoadResumeCheckpoint(CapturerCheckpoint) ? CapturerCheckpoint.MarkerIndex : 0;
+            ResumeMarkerIndex = (ResumeMarkerIndex == INDEX_NONE) ? CapturerMarkerIndex : FMath::Min(ResumeMarkerIndex, CapturerMarkerIndex);
+        }
+    }
+    return FMath::Clamp(ResumeMarkerIndex, 0, FMath::Max(SceneMarkers.Num() - 1, 0));
+}
+
 void ANVSceneManager::SetupScene()
 {
     UWorld* World = GetWorld();
@@ -273,6 +297,8 @@ void ANVSceneManager::UpdateSegmentationMask()
         if (bNeedInstanceSegmentation)
         {
             ObjectInstanceSegmentation.ScanActors(World);
+            // The class masks can be remapped from the instance masks instead of being rendered
+            ObjectInstanceSegmentation.UpdateInstanceClassLUT(ObjectClassSegmentation);
         }
     }
 }
@@ -0,0 +1,486 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVSequenceAnnotation.h"
+#include "Json.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+    const TCHAR* const IndexFieldName = TEXT("index");
+    const TCHAR* const ObjectsFieldName = TEXT("objects");
+    const TCHAR* const ObjectSettingsFieldName = TEXT("object_settings");
+
+    FString ToCondensedJsonString(const TSharedRef<FJsonObject>& JsonObj)
+    {
+        FString JsonString;
+        TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
+        FJsonSerializer::Serialize(JsonObj, JsonWriter);
+        return JsonString;
+    }
+
+    TArray<TSharedPtr<FJsonValue>> ToJsonIndexArray(const TArray<int32>& Indexes)
+    {
+        TArray<TSharedPtr<FJsonValue>> JsonValues;
+        JsonValues.Reserve(Indexes.Num());
+        for (int32 Index : Indexes)
+        {
+            JsonValues.Add(MakeShared<FJsonValueNumber>(Index));
+        }
+        return JsonValues;
+    }
+}
+
+const FString FNVSequenceAnnotationWriter::SequenceFileExtension = TEXT(".jsonl");
+const TArray<FString> FNVSequenceAnnotationWriter::StaticObjectFieldNames = { TEXT("class"), TEXT("instance_id") };
+
+FNVSequenceAnnotationWriter::FNVSequenceAnnotationWriter()
+{
+    CurrentMarkerIndex = 0;
+    bIsOpen = false;
+    bAppendToSequenceFiles = false;
+}
+
+FNVSequenceAnnotationWriter::~FNVSequenceAnnotationWriter()
+{
+    Close();
+}
+
+void FNVSequenceAnnotationWriter::Open(int32 MarkerIndex, bool bAppend)
+{
+    Close();
+
+    FScopeLock ScopeLock(&WriterLock);
+    CurrentMarkerIndex = MarkerIndex;
+    bAppendToSequenceFiles = bAppend;
+    bIsOpen = true;
+}
+
+void FNVSequenceAnnotationWriter::Close()
+{
+    FScopeLock ScopeLock(&WriterLock);
+    for (auto& CheckStream : StreamMap)
+    {
+        if (CheckStream.Value->FileHandle.IsValid())
+        {
+            CheckStream.Value->FileHandle->Flush(true);
+        }
+    }
+    StreamMap.Reset();
+    bIsOpen = false;
+}
+
+bool FNVSequenceAnnotationWriter::IsOpen() const
+{
+    FScopeLock ScopeLock(&WriterLock);
+    return bIsOpen;
+}
+
+void FNVSequenceAnnotationWriter::SetObjectClassSettings(const TMap<FString, TSharedPtr<FJsonObject>>& InObjectClassSettings)
+{
+    FScopeLock ScopeLock(&WriterLock);
+    ObjectClassSettings = InObjectClassSettings;
+}
+
+FNVSequenceAnnotationWriter::FSequenceStream* FNVSequenceAnnotationWriter::FindOrOpenStream(const FString& SequenceFilePath)
+{
+    TUniquePtr<FSequenceStream>* ExistingStream = StreamMap.Find(SequenceFilePath);
+    if (ExistingStream)
+    {
+        return (*ExistingStream)->FileHandle.IsValid() ? ExistingStream->Get() : nullptr;
+    }
+
+    // NOTE: The stream is kept even if its file can't be opened so the error is only reported once
+    TUniquePtr<FSequenceStream>& NewStream = StreamMap.Add(SequenceFilePath, MakeUnique<FSequenceStream>());
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const FString SequenceDirectoryPath = FPaths::GetPath(SequenceFilePath);
+    if (!PlatformFile.DirectoryExists(*SequenceDirectoryPath))
+    {
+        PlatformFile.CreateDirectoryTree(*SequenceDirectoryPath);
+    }
+
+    bool bNeedLineBreak = false;
+    if (bAppendToSequenceFiles)
+    {
+        // A crash may leave the last record incomplete, start the new records on a new line
+        TUniquePtr<IFileHandle> ReadFileHandle(PlatformFile.OpenRead(*SequenceFilePath));
+        if (ReadFileHandle.IsValid() && (ReadFileHandle->Size() > 0))
+        {
+            uint8 LastByte = 0;
+            bNeedLineBreak = ReadFileHandle->Seek(ReadFileHandle->Size() - 1) && ReadFileHandle->Read(&LastByte, 1) && (LastByte != '\n');
+        }
+    }
+    else
+    {
+        PlatformFile.DeleteFile(*SequenceFilePath);
+    }
+
+    NewStream->FileHandle.Reset(PlatformFile.OpenWrite(*SequenceFilePath, true));
+    if (!NewStream->FileHandle.IsValid())
+    {
+        UE_LOG(LogNVSceneCapturer, Error, TEXT("Can't open the sequence annotation file for writing: %s"), *SequenceFilePath);
+        return nullptr;
+    }
+
+    if (bNeedLineBreak)
+    {
+        const uint8 LineBreak = '\n';
+        NewStream->FileHandle->Write(&LineBreak, 1);
+    }
+    return NewStream.Get();
+}
+
+bool FNVSequenceAnnotationWriter::WriteRecord(IFileHandle& FileHandle, const TSharedRef<FJsonObject>& RecordJsonObj)
+{
+    // NOTE: Each record must be on a single line
+    FString RecordLine = ToCondensedJsonString(RecordJsonObj);
+    RecordLine += TEXT("\n");
+    FTCHARToUTF8 UTF8Line(*RecordLine);
+    return FileHandle.Write(reinterpret_cast<const uint8*>(UTF8Line.Get()), UTF8Line.Length());
+}
+
+bool FNVSequenceAnnotationWriter::WriteFrame(const FString& SequenceFilePath, int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)
+{
+    if (!AnnotationData.IsValid())
+    {
+        return false;
+    }
+
+    FScopeLock ScopeLock(&WriterLock);
+    if (!bIsOpen)
+    {
+        return false;
+    }
+    FSequenceStream* Stream = FindOrOpenStream(SequenceFilePath);
+    if (!Stream)
+    {
+        return false;
+    }
+
+    const bool bIsKeyFrame = (Stream->LastFrameIndex == INDEX_NONE);
+
+    TSharedRef<FJsonObject> SceneJsonObj = MakeShared<FJsonObject>();
+    TArray<TSharedPtr<FJsonValue>> NewObjectRows;
+    TArray<TSharedPtr<FJsonValue>> ChangedObjects;
+    TArray<int32> FrameObjectIndexes;
+    for (const auto& SceneField : AnnotationData->Values)
+    {
+        if (SceneField.Key != ObjectsFieldName)
+        {
+            SceneJsonObj->SetField(SceneField.Key, SceneField.Value);
+            continue;
+        }
+
+        // Keep the position of the objects among the scene fields, they're filled back in when the frame is expanded
+        SceneJsonObj->SetField(SceneField.Key, MakeShared<FJsonValueNull>());
+
+        const TArray<TSharedPtr<FJsonValue>>* ObjectValues = nullptr;
+        if (!SceneField.Value.IsValid() || !SceneField.Value->TryGetArray(ObjectValues))
+        {
+            continue;
+        }
+
+        // Number of objects in this frame having the same static fields
+        TMap<FString, int32> ObjectKeyCountMap;
+        for (const TSharedPtr<FJsonValue>& ObjectValue : *ObjectValues)
+        {
+            const TSharedPtr<FJsonObject>* ObjectJsonObjPtr = nullptr;
+            if (!ObjectValue.IsValid() || !ObjectValue->TryGetObject(ObjectJsonObjPtr) || !ObjectJsonObjPtr->IsValid())
+            {
+                continue;
+            }
+            const TSharedPtr<FJsonObject>& ObjectJsonObj = *ObjectJsonObjPtr;
+
+            TSharedRef<FJsonObject> StaticJsonObj = MakeShared<FJsonObject>();
+            TSharedRef<FJsonObject> DynamicJsonObj = MakeShared<FJsonObject>();
+            for (const auto& ObjectField : ObjectJsonObj->Values)
+            {
+                if (StaticObjectFieldNames.Contains(ObjectField.Key))
+                {
+                    StaticJsonObj->SetField(ObjectField.Key, ObjectField.Value);
+                }
+                else
+                {
+                    DynamicJsonObj->SetField(ObjectField.Key, ObjectField.Value);
+                }
+            }
+
+            // NOTE: The objects with the same static fields (e.g: no instance id) are told apart by their order in the frame
+            FString ObjectKey = ToCondensedJsonString(StaticJsonObj);
+            int32& SameKeyCount = ObjectKeyCountMap.FindOrAdd(ObjectKey);
+            ObjectKey.Appendf(TEXT("#%d"), SameKeyCount);
+            SameKeyCount++;
+
+            int32 ObjectIndex = INDEX_NONE;
+            const int32* ExistingObjectIndex = Stream->ObjectIndexMap.Find(ObjectKey);
+            if (ExistingObjectIndex)
+            {
+                ObjectIndex = *ExistingObjectIndex;
+            }
+            else
+            {
+                ObjectIndex = Stream->LastObjectDataList.Add(FString());
+                Stream->LastObjectFlags.Add(false);
+                Stream->ObjectIndexMap.Add(ObjectKey, ObjectIndex);
+
+                TSharedRef<FJsonObject> ObjectRowJsonObj = MakeShared<FJsonObject>();
+                ObjectRowJsonObj->SetNumberField(IndexFieldName, ObjectIndex);
+                for (const auto& StaticField : StaticJsonObj->Values)
+                {
+                    ObjectRowJsonObj->SetField(StaticField.Key, StaticField.Value);
+                }
+                FString ObjectClassName;
+                if (ObjectJsonObj->TryGetStringField(TEXT("class"), ObjectClassName))
+                {
+                    const TSharedPtr<FJsonObject>* ClassSettingsJsonObj = ObjectClassSettings.Find(ObjectClassName);
+                    if (ClassSettingsJsonObj && ClassSettingsJsonObj->IsValid())
+                    {
+                        ObjectRowJsonObj->SetObjectField(ObjectSettingsFieldName, *ClassSettingsJsonObj);
+                    }
+                }
+                NewObjectRows.Add(MakeShared<FJsonValueObject>(ObjectRowJsonObj));
+            }
+            FrameObjectIndexes.Add(ObjectIndex);
+
+            // Only write the objects which weren't in the previous frame or whose dynamic fields changed
+            FString ObjectData = ToCondensedJsonString(DynamicJsonObj);
+            const bool bWasInLastFrame = !bIsKeyFrame && Stream->LastObjectFlags[ObjectIndex];
+            if (!bWasInLastFrame || (ObjectData != Stream->LastObjectDataList[ObjectIndex]))
+            {
+                TSharedRef<FJsonObject> ChangedObjectJsonObj = MakeShared<FJsonObject>();
+                ChangedObjectJsonObj->SetNumberField(IndexFieldName, ObjectIndex);
+                for (const auto& DynamicField : DynamicJsonObj->Values)
+                {
+                    ChangedObjectJsonObj->SetField(DynamicField.Key, DynamicField.Value);
+                }
+                ChangedObjects.Add(MakeShared<FJsonValueObject>(ChangedObjectJsonObj));
+                Stream->LastObjectDataList[ObjectIndex] = MoveTemp(ObjectData);
+            }
+        }
+    }
+
+    TBitArray<> FrameObjectFlags(false, Stream->LastObjectDataList.Num());
+    bool bIsSortedByIndex = true;
+    for (int32 i = 0; i < FrameObjectIndexes.Num(); i++)
+    {
+        FrameObjectFlags[FrameObjectIndexes[i]] = true;
+        bIsSortedByIndex &= ((i == 0) || (FrameObjectIndexes[i - 1] < FrameObjectIndexes[i]));
+    }
+
+    TArray<int32> RemovedObjectIndexes;
+    if (!bIsKeyFrame)
+    {
+        for (TConstSetBitIterator<> It(Stream->LastObjectFlags); It; ++It)
+        {
+            if (!FrameObjectFlags[It.GetIndex()])
+            {
+                RemovedObjectIndexes.Add(It.GetIndex());
+            }
+        }
+    }
+
+    bool bResult = true;
+    if (NewObjectRows.Num() > 0)
+    {
+        TSharedRef<FJsonObject> TableRecordJsonObj = MakeShared<FJsonObject>();
+        TableRecordJsonObj->SetNumberField(TEXT("marker_index"), CurrentMarkerIndex);
+        TableRecordJsonObj->SetArrayField(TEXT("object_table"), NewObjectRows);
+        bResult &= WriteRecord(*Stream->FileHandle, TableRecordJsonObj);
+    }
+
+    TSharedRef<FJsonObject> FrameRecordJsonObj = MakeShared<FJsonObject>();
+    FrameRecordJsonObj->SetNumberField(TEXT("frame_index"), FrameIndex);
+    FrameRecordJsonObj->SetNumberField(TEXT("base_frame_index"), bIsKeyFrame ? INDEX_NONE : Stream->LastFrameIndex);
+    FrameRecordJsonObj->SetObjectField(TEXT("scene"), SceneJsonObj);
+    if (ChangedObjects.Num() > 0)
+    {
+        FrameRecordJsonObj->SetArrayField(ObjectsFieldName, ChangedObjects);
+    }
+    if (RemovedObjectIndexes.Num() > 0)
+    {
+        FrameRecordJsonObj->SetArrayField(TEXT("removed_objects"), ToJsonIndexArray(RemovedObjectIndexes));
+    }
+    if (!bIsSortedByIndex)
+    {
+        FrameRecordJsonObj->SetArrayField(TEXT("object_order"), ToJsonIndexArray(FrameObjectIndexes));
+    }
+    bResult &= WriteRecord(*Stream->FileHandle, FrameRecordJsonObj);
+
+    Stream->LastObjectFlags = MoveTemp(FrameObjectFlags);
+    Stream->LastFrameIndex = FrameIndex;
+    return bResult;
+}
+
+void FNVSequenceAnnotationWriter::Flush()
+{
+    FScopeLock ScopeLock(&WriterLock);
+    for (auto& CheckStream : StreamMap)
+    {
+        if (CheckStream.Value->FileHandle.IsValid())
+        {
+            CheckStream.Value->FileHandle->Flush(true);
+        }
+    }
+}
+
+bool FNVSequenceAnnotationWriter::ReadSequenceFile(const FString& SequenceFilePath, TFunctionRef<void(int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)> FrameCallback)
+{
+    FString SequenceFileContent;
+    if (!FFileHelper::LoadFileToString(SequenceFileContent, *SequenceFilePath))
+    {
+        UE_LOG(LogNVSceneCapturer, Warning, TEXT("Can't read the sequence annotation file: %s"), *SequenceFilePath);
+        return false;
+    }
+
+    TArray<FString> RecordLines;
+    SequenceFileContent.ParseIntoArrayLines(RecordLines);
+
+    bool bResult = true;
+    TArray<TSharedPtr<FJsonObject>> ObjectTable;
+    // Map between the index of the objects in the current frame and their expanded data
+    TMap<int32, TSharedPtr<FJsonObject>> FrameObjectMap;
+    for (int32 LineIndex = 0; LineIndex < RecordLines.Num(); LineIndex++)
+    {
+        TSharedPtr<FJsonObject> RecordJsonObj;
+        TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<TCHAR>::Create(RecordLines[LineIndex]);
+        if (!FJsonSerializer::Deserialize(JsonReader, RecordJsonObj) || !RecordJsonObj.IsValid())
+        {
+            // NOTE: A crash can leave the last record of a session incomplete
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("Record %d of the sequence annotation file '%s' is incomplete, it's skipped."), LineIndex, *SequenceFilePath);
+            continue;
+        }
+
+        const TArray<TSharedPtr<FJsonValue>>* ObjectRowValues = nullptr;
+        if (RecordJsonObj->TryGetArrayField(TEXT("object_table"), ObjectRowValues))
+        {
+            for (const TSharedPtr<FJsonValue>& ObjectRowValue : *ObjectRowValues)
+            {
+                const TSharedPtr<FJsonObject>* ObjectRowJsonObj = nullptr;
+                int32 ObjectIndex = INDEX_NONE;
+                if (ObjectRowValue.IsValid() && ObjectRowValue->TryGetObject(ObjectRowJsonObj)
+                    && (*ObjectRowJsonObj)->TryGetNumberField(IndexFieldName, ObjectIndex) && (ObjectIndex >= 0))
+                {
+                    if (ObjectIndex >= ObjectTable.Num())
+                    {
+                        ObjectTable.SetNum(ObjectIndex + 1);
+                    }
+                    ObjectTable[ObjectIndex] = *ObjectRowJsonObj;
+                }
+            }
+            continue;
+        }
+
+        int32 FrameIndex = INDEX_NONE;
+        const TSharedPtr<FJsonObject>* SceneJsonObj = nullptr;
+        if (!RecordJsonObj->TryGetNumberField(TEXT("frame_index"), FrameIndex) || !RecordJsonObj->TryGetObjectField(TEXT("scene"), SceneJsonObj))
+        {
+            UE_LOG(LogNVSceneCapturer, Warning, TEXT("Record %d of the sequence annotation file '%s' is neither an object table nor a frame."), LineIndex, *SequenceFilePath);
+            bResult = false;
+            continue;
+        }
+
+        int32 BaseFrameIndex = INDEX_NONE;
+        RecordJsonObj->TryGetNumberField(TEXT("base_frame_index"), BaseFrameIndex);
+        if (BaseFrameIndex == INDEX_NONE)
+        {
+            FrameObjectMap.Reset();
+        }
+
+        const TArray<TSharedPtr<FJsonValue>>* RemovedObjectValues = nullptr;
+        if (RecordJsonObj->TryGetArrayField(TEXT("removed_objects"), RemovedObjectValues))
+        {
+            for (const TSharedPtr<FJsonValue>& RemovedObjectValue : *RemovedObjectValues)
+            {
+                FrameObjectMap.Remove(static_cast<int32>(RemovedObjectValue->AsNumber()));
+            }
+        }
+
+        const TArray<TSharedPtr<FJsonValue>>* ChangedObjectValues = nullptr;
+        if (RecordJsonObj->TryGetArrayField(ObjectsFieldName, ChangedObjectValues))
+        {
+            for (const TSharedPtr<FJsonValue>& ChangedObjectValue : *ChangedObjectValues)
+            {
+                const TSharedPtr<FJsonObject>* ChangedObjectJsonObj = nullptr;
+                int32 ObjectIndex = INDEX_NONE;
+                if (!ChangedObjectValue.IsValid() || !ChangedObjectValue->TryGetObject(ChangedObjectJsonObj)
+                    || !(*ChangedObjectJsonObj)->TryGetNumberField(IndexFieldName, ObjectIndex)
+                    || !ObjectTable.IsValidIndex(ObjectIndex) || !ObjectTable[ObjectIndex].IsValid())
+                {
+                    UE_LOG(LogNVSceneCapturer, Warning, TEXT("Frame %d of the sequence annotation file '%s' has an object which isn't in the object table."), FrameIndex, *SequenceFilePath);
+                    bResult = false;
+                    continue;
+                }
+
+                // The static fields come first, followed by the dynamic fields in the order they're captured
+                TSharedPtr<FJsonObject> ExpandedObjectJsonObj = MakeShareable(new FJsonObject());
+                for (const auto& StaticField : ObjectTable[ObjectIndex]->Values)
+                {
+                    if ((StaticField.Key != IndexFieldName) && (StaticField.Key != ObjectSettingsFieldName))
+                    {
+                        ExpandedObjectJsonObj->SetField(StaticField.Key, StaticField.Value);
+                    }
+                }
+                for (const auto& DynamicField : (*ChangedObjectJsonObj)->Values)
+                {
+                    if (DynamicField.Key != IndexFieldName)
+                    {
+                        ExpandedObjectJsonObj->SetField(DynamicField.Key, DynamicField.Value);
+                    }
+                }
+                FrameObjectMap.Add(ObjectIndex, ExpandedObjectJsonObj);
+            }
+        }
+
+        TArray<int32> FrameObjectIndexes;
+        const TArray<TSharedPtr<FJsonValue>>* ObjectOrderValues = nullptr;
+        if (RecordJsonObj->TryGetArrayField(TEXT("object_order"), ObjectOrderValues))
+        {
+            for (const TSharedPtr<FJsonValue>& ObjectOrderValue : *ObjectOrderValues)
+            {
+                FrameObjectIndexes.Add(static_cast<int32>(ObjectOrderValue->AsNumber()));
+            }
+        }
+        else
+        {
+            FrameObjectMap.GenerateKeyArray(FrameObjectIndexes);
+            FrameObjectIndexes.Sort();
+        }
+
+        TArray<TSharedPtr<FJsonValue>> FrameObjectValues;
+        FrameObjectValues.Reserve(FrameObjectIndexes.Num());
+        for (int32 ObjectIndex : FrameObjectIndexes)
+        {
+            const TSharedPtr<FJsonObject>* FrameObjectJsonObj = FrameObjectMap.Find(ObjectIndex);
+            if (FrameObjectJsonObj)
+            {
+                FrameObjectValues.Add(MakeShared<FJsonValueObject>(*FrameObjectJsonObj));
+            }
+            else
+            {
+                bResult = false;
+            }
+        }
+
+        TSharedPtr<FJsonObject> AnnotationData = MakeShareable(new FJsonObject());
+        for (const auto& SceneField : (*SceneJsonObj)->Values)
+        {
+            if (SceneField.Key == ObjectsFieldName)
+            {
+                AnnotationData->SetArrayField(ObjectsFieldName, FrameObjectValues);
+            }
+            else
+            {
+                AnnotationData->SetField(SceneField.Key, SceneField.Value);
+            }
+        }
+        FrameCallback(FrameIndex, AnnotationData);
+    }
+
+    return bResult;
+}
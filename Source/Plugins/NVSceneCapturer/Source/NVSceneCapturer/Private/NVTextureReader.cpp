@@ -16,10 +16,30 @@
 #include "RenderingThread.h"
 #include "RendererInterface.h"
 #include "StaticBoundShaderState.h"
+#include "RHIGPUReadback.h"
 #include "Engine/TextureRenderTarget2D.h"
 
 DEFINE_LOG_CATEGORY(LogNVTextureReader);
 
+namespace
+{
+    /// A readback which is copied on the GPU but not mapped to the CPU memory yet
+    struct FNVPendingTextureReadback
+    {
+        TUniquePtr<FRHIGPUTextureReadback> Readback;
+        EPixelFormat PixelFormat;
+        FIntPoint TargetSize;
+        uint32 SubmittedFrameNumber;
+        FNVTextureReader::OnFinishedReadingRawPixelsCallback Callback;
+    };
+
+    // NOTE: Only accessed on the rendering thread, sorted by the order the readbacks are submitted
+    TArray<FNVPendingTextureReadback> PendingReadbacks;
+
+    // NOTE: Only accessed on the game thread, the render commands get a copy of it
+    int32 MaxPendingReadbackFrames = 0;
+}
+
 //======================= FNVTextureReader =======================//
 FNVTextureReader::FNVTextureReader()
 {
@@ -207,51 +227,178 @@ bool FNVTextureReader::ReadPixelsRaw(const FTextureRHIRef &NewSourceTexture, con
     }
     else
     {
-        static const FName RendererModuleName("Renderer");
-        // Load the renderer module on the main thread, as the module manager is not thread-safe, and copy the ptr into the render command, along with 'this' (which is protected by BlockUntilAvailable in ~FViewportSurfaceReader())
-        IRendererModule *RendererModule = &FModuleManager::GetModuleChecked<IRendererModule>(RendererModuleName);
-        check(RendererModule);
+        const int32 MaxPendingFrames = MaxPendingReadbackFrames;
 
         // NOTE: This approach almost identical to function FViewportSurfaceReader::ResolveRenderTarget in FrameGrabber.cpp
         // The main different is we reading the pixels back from a render target instead of a viewport
         ENQUEUE_RENDER_COMMAND(ReadPixelsFromTexture)(
             [=](FRHICommandListImmediate &RHICmdList)
             {
-                // FRHIResourceCreateInfo CreateInfo(FClearValueBinding::None);
-                // TODO: Can cache the ReadbackTexture and reuse it if the format and size doesn't change instead of creating it everytime we read like this
-                // Need to be careful with reusing the ReadbackTexture: need to make sure the texture is already finished reading
-                FRHITextureCreateDesc Desc =
-                    FRHITextureCreateDesc::Create2D(TEXT("NVTextureReadback"))
-                        .SetExtent(TargetSize.X, TargetSize.Y)
-                        .SetFormat(TargetPixelFormat)
-                        .SetNumMips(1)
-                        .SetNumSamples(1)
-                        .SetFlags(ETextureCreateFlags::CPUReadback);
+                ReadPixelsRaw_RenderThread(RHICmdList, NewSourceTexture, SourceRect, TargetPixelFormat, TargetSize, bIgnoreAlpha, MaxPendingFrames, Callback);
+            });
+        bResult = true;
+    }
 
-                FTextureRHIRef ReadbackTexture = RHICreateTexture(Desc);
+    return bResult;
+}
 
-                bool bOverwriteAlpha = !bIgnoreAlpha;
-                // Copy the source texture to the readback texture so we can read it back later even after the source texture is modified
-                CopyTexture2d(RendererModule, RHICmdList, NewSourceTexture, SourceRect, ReadbackTexture, FIntRect(FIntPoint::ZeroValue, TargetSize), bOverwriteAlpha);
+void FNVTextureReader::ReadPixelsRaw_RenderThread(FRHICommandListImmediate &RHICmdList, const FTextureRHIRef &NewSourceTexture, const FIntRect &SourceRect,
+                                                  EPixelFormat TargetPixelFormat, const FIntPoint &TargetSize, bool bIgnoreAlpha, int32 MaxPendingFrames,
+                                                  OnFinishedReadingRawPixelsCallback Callback)
+{
+    check(IsInRenderingThread());
 
-                // Stage the texture to read back its pixels data
-                FIntPoint PixelSize = FIntPoint::ZeroValue;
-                void *PixelDataBuffer = nullptr;
-                RHICmdList.MapStagingSurface(ReadbackTexture, PixelDataBuffer, PixelSize.X, PixelSize.Y);
+    if (MaxPendingFrames > 0)
+    {
+        // Only enqueue the copy now, the pixels are mapped in a later frame when the GPU is done with it
+        // so the rendering thread doesn't have to wait for the GPU to finish rendering the scene
+        FNVPendingTextureReadback NewReadback;
+        NewReadback.Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("NVTextureReadback"));
+        NewReadback.Readback->EnqueueCopy(RHICmdList, NewSourceTexture,
+                                          FIntVector(SourceRect.Min.X, SourceRect.Min.Y, 0), 0,
+                                          FIntVector(TargetSize.X, TargetSize.Y, 1));
+        NewReadback.PixelFormat = TargetPixelFormat;
+        NewReadback.TargetSize = TargetSize;
+        NewReadback.SubmittedFrameNumber = GFrameNumberRenderThread;
+        NewReadback.Callback = Callback;
+        PendingReadbacks.Add(MoveTemp(NewReadback));
+
+        ProcessPendingReadbacks_RenderThread(RHICmdList, MaxPendingFrames, false);
+        return;
+    }
 
-                if (PixelDataBuffer)
-                {
-                    Callback((uint8 *)PixelDataBuffer, TargetPixelFormat, PixelSize);
-                }
+    // FRHIResourceCreateInfo CreateInfo(FClearValueBinding::None);
+    // TODO: Can cache the ReadbackTexture and reuse it if the format and size doesn't change instead of creating it everytime we read like this
+    // Need to be careful with reusing the ReadbackTexture: need to make sure the texture is already finished reading
+    FRHITextureCreateDesc Desc =
+        FRHITextureCreateDesc::Create2D(TEXT("NVTextureReadback"))
+            .SetExtent(TargetSize.X, TargetSize.Y)
+            .SetFormat(TargetPixelFormat)
+            .SetNumMips(1)
+            .SetNumSamples(1)
+            .SetFlags(ETextureCreateFlags::CPUReadback);
+
+    FTextureRHIRef ReadbackTexture = RHICreateTexture(Desc);
+
+    bool bOverwriteAlpha = !bIgnoreAlpha;
+    // Copy the source texture to the readback texture so we can read it back later even after the source texture is modified
+    CopyTexture2d(nullptr, RHICmdList, NewSourceTexture, SourceRect, ReadbackTexture, FIntRect(FIntPoint::ZeroValue, TargetSize), bOverwriteAlpha);
+
+    // Stage the texture to read back its pixels data
+    FIntPoint PixelSize = FIntPoint::ZeroValue;
+    void *PixelDataBuffer = nullptr;
+    RHICmdList.MapStagingSurface(ReadbackTexture, PixelDataBuffer, PixelSize.X, PixelSize.Y);
+
+    if (PixelDataBuffer)
+    {
+        Callback((uint8 *)PixelDataBuffer, TargetPixelFormat, PixelSize);
+    }
 
-                RHICmdList.UnmapStagingSurface(ReadbackTexture);
+    RHICmdList.UnmapStagingSurface(ReadbackTexture);
 
-                ReadbackTexture.SafeRelease();
+    ReadbackTexture.SafeRelease();
+}
+
+void FNVTextureReader::SetMaxPendingReadbackFrames(int32 NewMaxPendingFrames)
+{
+    ensure(IsInGameThread());
+
+    const int32 PrevMaxPendingFrames = MaxPendingReadbackFrames;
+    MaxPendingReadbackFrames = FMath::Max(NewMaxPendingFrames, 0);
+    if ((PrevMaxPendingFrames > 0) && (MaxPendingReadbackFrames == 0))
+    {
+        // Don't leave the readbacks which are already in flight behind
+        ENQUEUE_RENDER_COMMAND(FlushPendingTextureReadbacks)(
+            [](FRHICommandListImmediate &RHICmdList)
+            {
+                ProcessPendingReadbacks_RenderThread(RHICmdList, 0, true);
             });
-        bResult = true;
     }
+}
 
-    return bResult;
+int32 FNVTextureReader::GetMaxPendingReadbackFrames()
+{
+    return MaxPendingReadbackFrames;
+}
+
+void FNVTextureReader::ProcessPendingReadbacks()
+{
+    const int32 MaxPendingFrames = MaxPendingReadbackFrames;
+    ENQUEUE_RENDER_COMMAND(ProcessPendingTextureReadbacks)(
+        [MaxPendingFrames](FRHICommandListImmediate &RHICmdList)
+        {
+            ProcessPendingReadbacks_RenderThread(RHICmdList, MaxPendingFrames, false);
+        });
+}
+
+void FNVTextureReader::FlushPendingReadbacks()
+{
+    ENQUEUE_RENDER_COMMAND(FlushPendingTextureReadbacks)(
+        [](FRHICommandListImmediate &RHICmdList)
+        {
+            ProcessPendingReadbacks_RenderThread(RHICmdList, 0, true);
+        });
+    FlushRenderingCommands();
+}
+
+void FNVTextureReader::ProcessPendingReadbacks_RenderThread(FRHICommandListImmediate &RHICmdList, int32 MaxPendingFrames, bool bFlushAll)
+{
+    // Find the readbacks we can map now, keep them in order since the GPU finish them in the order they're submitted
+    int32 ReadyReadbackCount = 0;
+    bool bNeedToWaitForGPU = false;
+    for (; ReadyReadbackCount < PendingReadbacks.Num(); ReadyReadbackCount++)
+    {
+        const FNVPendingTextureReadback &CheckReadback = PendingReadbacks[ReadyReadbackCount];
+        if (CheckReadback.Readback->IsReady())
+        {
+            continue;
+        }
+
+        const uint32 PendingFrameCount = GFrameNumberRenderThread - CheckReadback.SubmittedFrameNumber;
+        if (bFlushAll || (PendingFrameCount >= (uint32)FMath::Max(MaxPendingFrames, 1)))
+        {
+            bNeedToWaitForGPU = true;
+            continue;
+        }
+        break;
+    }
+
+    if (ReadyReadbackCount == 0)
+    {
+        return;
+    }
+
+    if (bNeedToWaitForGPU)
+    {
+        // NOTE: This stall the rendering thread the same way mapping the readback right after copying it did
+        RHICmdList.BlockUntilGPUIdle();
+    }
+
+    // NOTE: Move the readbacks out first, the callbacks may take a while and we don't want to touch the list while they run
+    TArray<FNVPendingTextureReadback> ReadyReadbacks;
+    ReadyReadbacks.Reserve(ReadyReadbackCount);
+    for (int32 i = 0; i < ReadyReadbackCount; i++)
+    {
+        ReadyReadbacks.Add(MoveTemp(PendingReadbacks[i]));
+    }
+    PendingReadbacks.RemoveAt(0, ReadyReadbackCount);
+
+    for (FNVPendingTextureReadback &ReadyReadback : ReadyReadbacks)
+    {
+        int32 RowPitchInPixels = 0;
+        int32 BufferHeight = 0;
+        void *PixelDataBuffer = ReadyReadback.Readback->Lock(RowPitchInPixels, &BufferHeight);
+        if (PixelDataBuffer)
+        {
+            const FIntPoint PixelSize(RowPitchInPixels, (BufferHeight > 0) ? BufferHeight : ReadyReadback.TargetSize.Y);
+            ReadyReadback.Callback((uint8 *)PixelDataBuffer, ReadyReadback.PixelFormat, PixelSize);
+            ReadyReadback.Readback->Unlock();
+        }
+        else
+        {
+            UE_LOG(LogNVTextureReader, Error, TEXT("Can't map the pending texture readback."));
+        }
+    }
 }
 
 void FNVTextureReader::CopyTexture2d(IRendererModule * /*RendererModule*/, FRHICommandListImmediate &RHICmdList,
@@ -338,6 +485,18 @@ void FNVTextureRenderTargetReader::SetTextureRenderTarget(UTextureRenderTarget2D
     }
 }
 
+FTextureRHIRef FNVTextureRenderTargetReader::GetRenderTargetTexture(EPixelFormat &OutReadbackPixelFormat)
+{
+    UpdateTextureFromRenderTarget();
+    OutReadbackPixelFormat = ReadbackPixelFormat;
+    return SourceTexture;
+}
+
+void FNVTextureRenderTargetReader::SetReadbackRegion(const FIntRect &NewReadbackRegion)
+{
+    ReadbackRegion = NewReadbackRegion;
+}
+
 bool FNVTextureRenderTargetReader::ReadPixelsData(OnFinishedReadingPixelsDataCallback Callback, bool bIgnoreAlpha /*= false*/)
 {
     UpdateTextureFromRenderTarget();
@@ -402,7 +561,14 @@ void FNVTextureRenderTargetReader::UpdateTextureFromRenderTarget()
                                                                                     : SourceRenderTarget->GetRenderTargetResource();
         if (RenderTargetResource)
         {
-            SetSourceTexture(RenderTargetResource->GetRenderTargetTexture());
+            FTextureRHIRef RenderTargetTexture = RenderTargetResource->GetRenderTargetTexture();
+            FIntRect SourceRegion = ReadbackRegion;
+            if (RenderTargetTexture && (SourceRegion.Area() > 0))
+            {
+                // Only copy the region from the render target, the rest of the pixels are not read back at all
+                SourceRegion.Clip(FIntRect(FIntPoint::ZeroValue, RenderTargetTexture->GetSizeXY()));
+            }
+            SetSourceTexture(RenderTargetTexture, SourceRegion, EPixelFormat::PF_Unknown, SourceRegion.Size());
         }
     }
     else
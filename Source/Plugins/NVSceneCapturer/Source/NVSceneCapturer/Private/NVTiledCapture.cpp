@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "NVTiledCapture.h"
+
+//================================== FNVTiledCaptureSettings ==================================
+FNVTiledCaptureSettings::FNVTiledCaptureSettings()
+{
+    bEnabled = false;
+    MaxTileSize = 2048;
+}
+
+//================================== FNVCaptureTile ==================================
+FNVCaptureTile::FNVCaptureTile()
+{
+    TileIndex = INDEX_NONE;
+    GridSize = FIntPoint::ZeroValue;
+    Rect = FIntRect();
+    ImageSize = FIntPoint::ZeroValue;
+    ProjectionMatrix = FMatrix::Identity;
+}
+
+FIntRect FNVCaptureTile::GetClippedRect() const
+{
+    FIntRect ClippedRect = Rect;
+    ClippedRect.Clip(FIntRect(FIntPoint::ZeroValue, ImageSize));
+    return ClippedRect;
+}
+
+//================================== FNVTiledCapture ==================================
+FIntPoint FNVTiledCapture::CalculateGridSize(const FIntPoint& ImageSize, int32 MaxTileSize)
+{
+    const int32 TileSizeLimit = FMath::Max(MaxTileSize, 1);
+    return FIntPoint(FMath::Max(FMath::DivideAndRoundUp(ImageSize.X, TileSizeLimit), 1),
+                     FMath::Max(FMath::DivideAndRoundUp(ImageSize.Y, TileSizeLimit), 1));
+}
+
+FIntPoint FNVTiledCapture::CalculateTileSize(const FIntPoint& ImageSize, int32 MaxTileSize)
+{
+    // NOTE: Split the image evenly instead of using the maximum tile size so the last column and row don't go too far past the image
+    const FIntPoint GridSize = CalculateGridSize(ImageSize, MaxTileSize);
+    return FIntPoint(FMath::DivideAndRoundUp(ImageSize.X, GridSize.X), FMath::DivideAndRoundUp(ImageSize.Y, GridSize.Y));
+}
+
+void FNVTiledCapture::BuildTiles(const FMatrix& FullProjectionMatrix, const FIntPoint& ImageSize, int32 MaxTileSize, TArray<FNVCaptureTile>& OutTiles)
+{
+    const FIntPoint GridSize = CalculateGridSize(ImageSize, MaxTileSize);
+    const FIntPoint TileSize = CalculateTileSize(ImageSize, MaxTileSize);
+
+    OutTiles.Reset(GridSize.X * GridSize.Y);
+    for (int32 Row = 0; Row < GridSize.Y; Row++)
+    {
+        for (int32 Column = 0; Column < GridSize.X; Column++)
+        {
+            FNVCaptureTile NewTile;
+            NewTile.TileIndex = OutTiles.Num();
+            NewTile.GridSize = GridSize;
+            NewTile.ImageSize = ImageSize;
+            NewTile.Rect.Min = FIntPoint(Column * TileSize.X, Row * TileSize.Y);
+            NewTile.Rect.Max = NewTile.Rect.Min + TileSize;
+            NewTile.ProjectionMatrix = MakeTileProjectionMatrix(FullProjectionMatrix, NewTile.Rect, ImageSize);
+            OutTiles.Add(NewTile);
+        }
+    }
+}
+
+FMatrix FNVTiledCapture::MakeTileProjectionMatrix(const FMatrix& FullProjectionMatrix, const FIntRect& TileRect, const FIntPoint& ImageSize)
+{
+    return FullProjectionMatrix * MakeTileClipMatrix(TileRect, ImageSize);
+}
+
+FMatrix FNVTiledCapture::MakeTileClipMatrix(const FIntRect& TileRect, const FIntPoint& ImageSize)
+{
+    ensure((TileRect.Area() > 0) && (ImageSize.X > 0) && (ImageSize.Y > 0));
+    if ((TileRect.Area() <= 0) || (ImageSize.X <= 0) || (ImageSize.Y <= 0))
+    {
+        return FMatrix::Identity;
+    }
+
+    // The tile's region in the normalized device coordinates of the full image, the Y axis point up
+    const double ScaleX = (double)ImageSize.X / TileRect.Width();
+    const double ScaleY = (double)ImageSize.Y / TileRect.Height();
+    const double CenterX = (double)(TileRect.Min.X + TileRect.Max.X) / ImageSize.X - 1.0;
+    const double CenterY = 1.0 - (double)(TileRect.Min.Y + TileRect.Max.Y) / ImageSize.Y;
+
+    // NOTE: The offset is multiplied by W so the mapping stay the same after the perspective divide: x' = (x - Center * w) * Scale
+    FMatrix ClipMatrix = FMatrix::Identity;
+    ClipMatrix.M[0][0] = ScaleX;
+    ClipMatrix.M[1][1] = ScaleY;
+    ClipMatrix.M[3][0] = -CenterX * ScaleX;
+    ClipMatrix.M[3][1] = -CenterY * ScaleY;
+    return ClipMatrix;
+}
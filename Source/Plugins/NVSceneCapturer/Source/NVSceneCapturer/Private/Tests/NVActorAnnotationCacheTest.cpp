@@ -0,0 +1,249 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVAnnotationTestUtils.h"
+#include "NVActorAnnotationCache.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// Stand-in for the occlusion traces: only depend on the actor's cuboid and the viewpoint, like the traces of a static scene
+    int32 CountSyntheticOccludedVertexes(const FNVCuboidData& Cuboid, const FVector& ViewLocation)
+    {
+        const float CenterDistance = FVector::Dist(Cuboid.GetCenter(), ViewLocation);
+        int32 OccludedVertexCount = 0;
+        for (const FVector& Vertex : Cuboid.Vertexes)
+        {
+            if (FVector::Dist(Vertex, ViewLocation) > CenterDistance)
+            {
+                OccludedVertexCount++;
+            }
+        }
+        return OccludedVertexCount;
+    }
+
+    FNVActorAnnotationInput MakeActorInput(const AActor* Actor, uint32 InstanceId)
+    {
+        FNVActorAnnotationInput ActorInput;
+        ActorInput.Name = Actor->GetName();
+        ActorInput.Class = TEXT("CacheTestActor");
+        ActorInput.InstanceId = InstanceId;
+        ActorInput.ActorToWorld = Actor->GetActorTransform();
+        return ActorInput;
+    }
+
+    /// Gather the world space input of the actor from scratch
+    FNVActorAnnotationInput GatherRecomputedActorInput(const AActor* Actor, uint32 InstanceId, const FVector& ViewLocation)
+    {
+        FNVActorAnnotationInput ActorInput = MakeActorInput(Actor, InstanceId);
+        ActorInput.Cuboid = NVSceneCapturerUtils::GetActorCuboid_OOBB_Simple(Actor, false);
+        ActorInput.OccludedVertexCount = CountSyntheticOccludedVertexes(ActorInput.Cuboid, ViewLocation);
+        return ActorInput;
+    }
+
+    /// Gather the world space input of the actor the way the annotation extractor does, reusing the cached data if the actor didn't change
+    FNVActorAnnotationInput GatherCachedActorInput(FNVActorAnnotationCache& ActorAnnotationCache, const AActor* Actor, uint32 InstanceId, const FVector& ViewLocation)
+    {
+        FNVActorAnnotationInput ActorInput = MakeActorInput(Actor, InstanceId);
+
+        FNVActorAnnotationCache::FActorState ActorState;
+        ActorState.Update(Actor, InstanceId);
+        if (FNVActorAnnotationCache::FEntry* CachedEntry = ActorAnnotationCache.Find(Actor, ActorState))
+        {
+            ActorInput.Cuboid = CachedEntry->Cuboid;
+            if (!ActorAnnotationCache.FindOcclusion(*CachedEntry, ViewLocation, ActorInput.OccludedVertexCount))
+            {
+                ActorInput.OccludedVertexCount = CountSyntheticOccludedVertexes(ActorInput.Cuboid, ViewLocation);
+            }
+            CachedEntry->OcclusionViewLocation = ViewLocation;
+            CachedEntry->OccludedVertexCount = ActorInput.OccludedVertexCount;
+        }
+        else
+        {
+            ActorInput.Cuboid = NVSceneCapturerUtils::GetActorCuboid_OOBB_Simple(Actor, false);
+            ActorInput.OccludedVertexCount = CountSyntheticOccludedVertexes(ActorInput.Cuboid, ViewLocation);
+
+            FNVActorAnnotationCache::FEntry NewEntry;
+            NewEntry.State = MoveTemp(ActorState);
+            NewEntry.Cuboid = ActorInput.Cuboid;
+            NewEntry.OcclusionViewLocation = ViewLocation;
+            NewEntry.OccludedVertexCount = ActorInput.OccludedVertexCount;
+            ActorAnnotationCache.Add(Actor, MoveTemp(NewEntry));
+        }
+        return ActorInput;
+    }
+
+    AStaticMeshActor* SpawnMeshActor(UWorld* World, UStaticMesh* StaticMesh, const FTransform& ActorTransform)
+    {
+        AStaticMeshActor* MeshActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), ActorTransform);
+        if (MeshActor)
+        {
+            MeshActor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+            MeshActor->GetStaticMeshComponent()->SetStaticMesh(StaticMesh);
+
+            UNVCapturableActorTag* CapturableTag = NewObject<UNVCapturableActorTag>(MeshActor);
+            MeshActor->AddInstanceComponent(CapturableTag);
+            CapturableTag->RegisterComponent();
+        }
+        return MeshActor;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVActorAnnotationCacheEquivalenceTest, "NVSceneCapturer.ActorAnnotationCache.Equivalence", NV_UNIT_TEST_FLAGS)
+bool FNVActorAnnotationCacheEquivalenceTest::RunTest(const FString& Parameters)
+{
+    UStaticMesh* CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+    UStaticMesh* ConeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cone.Cone"));
+    if (!CubeMesh || !ConeMesh)
+    {
+        AddWarning(TEXT("The engine's basic shapes can't be loaded, the test is skipped"));
+        return true;
+    }
+
+    NVSceneCapturerTest::FScopedTestWorld TestWorld;
+    FRandomStream RandomStream(2018);
+
+    const int32 ActorCount = 24;
+    const int32 FrameCount = 120;
+
+    TArray<AStaticMeshActor*> MeshActors;
+    for (int32 ActorIndex = 0; ActorIndex < ActorCount; ActorIndex++)
+    {
+        AStaticMeshActor* MeshActor = SpawnMeshActor(TestWorld.World, CubeMesh, NVSceneCapturerTest::MakeRandomTransform(RandomStream));
+        if (!TestNotNull(TEXT("The test actor is spawned"), MeshActor))
+        {
+            return false;
+        }
+        MeshActors.Add(MeshActor);
+    }
+
+    FNVActorAnnotationCache ActorAnnotationCache;
+    const FNVAnnotationFieldSet AnnotationFields = NVSceneCapturerTest::MakeFullAnnotationFields(true);
+    FTransform ViewTransform = FTransform::Identity;
+    int64 ExpectedHitCount = 0;
+    int32 MismatchedFrameCount = 0;
+
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+    {
+        ActorAnnotationCache.BeginFrame();
+
+        // The viewpoint move every other frame on average, the cached actors must still be projected from the new one
+        if (RandomStream.FRand() < 0.5f)
+        {
+            const FRotator ViewRotation(RandomStream.FRandRange(-20.f, 20.f), RandomStream.FRandRange(-30.f, 30.f), 0.f);
+            ViewTransform = FTransform(ViewRotation, FVector(RandomStream.FRandRange(-200.f, 200.f), RandomStream.FRandRange(-200.f, 200.f), RandomStream.FRandRange(-100.f, 100.f)));
+        }
+
+        // Most of the actors don't change, the others move, change their mesh or are marked dirty by a randomizer
+        for (AStaticMeshActor* MeshActor : MeshActors)
+        {
+            const float ChangeRoll = RandomStream.FRand();
+            if (ChangeRoll < 0.2f)
+            {
+                MeshActor->SetActorTransform(NVSceneCapturerTest::MakeRandomTransform(RandomStream));
+            }
+            else if (ChangeRoll < 0.25f)
+            {
+                UStaticMeshComponent* MeshComp = MeshActor->GetStaticMeshComponent();
+                MeshComp->SetStaticMesh((MeshComp->GetStaticMesh() == CubeMesh) ? ConeMesh : CubeMesh);
+            }
+            else if (ChangeRoll < 0.3f)
+            {
+                MeshActor->FindComponentByClass<UNVCapturableActorTag>()->MarkAnnotationDirty();
+            }
+            else if (FrameIndex > 0)
+            {
+                ExpectedHitCount++;
+            }
+        }
+
+        FNVSceneAnnotationSnapshot CachedSnapshot(FrameIndex);
+        FNVSceneAnnotationSnapshot RecomputedSnapshot(FrameIndex);
+        CachedSnapshot.ViewContext = NVSceneCapturerTest::MakeTestViewContext(ViewTransform);
+        CachedSnapshot.ViewContext.bUseInstanceMaskBoundingBox = true;
+        CachedSnapshot.AnnotationFields = AnnotationFields;
+        RecomputedSnapshot.ViewContext = CachedSnapshot.ViewContext;
+        RecomputedSnapshot.AnnotationFields = AnnotationFields;
+
+        const FVector ViewLocation = ViewTransform.GetLocation();
+        for (int32 ActorIndex = 0; ActorIndex < MeshActors.Num(); ActorIndex++)
+        {
+            const uint32 InstanceId = (uint32)(ActorIndex + 1);
+            CachedSnapshot.Actors.Add(GatherCachedActorInput(ActorAnnotationCache, MeshActors[ActorIndex], InstanceId, ViewLocation));
+            RecomputedSnapshot.Actors.Add(GatherRecomputedActorInput(MeshActors[ActorIndex], InstanceId, ViewLocation));
+        }
+
+        const FString CachedJsonString = NVSceneCapturerTest::JsonObjectToString(UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(CachedSnapshot));
+        const FString RecomputedJsonString = NVSceneCapturerTest::JsonObjectToString(UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(RecomputedSnapshot));
+        if (!CachedJsonString.Equals(RecomputedJsonString, ESearchCase::CaseSensitive))
+        {
+            MismatchedFrameCount++;
+        }
+    }
+
+    TestEqual(TEXT("The annotation built from the cache is the same as the recomputed one"), MismatchedFrameCount, 0);
+
+    const FNVActorAnnotationCacheStats& CacheStats = ActorAnnotationCache.GetStats();
+    TestEqual(TEXT("All the actors are looked up every frame"), CacheStats.LookupCount, (int64)(ActorCount * FrameCount));
+    TestTrue(TEXT("The actors which didn't change are reused"), ExpectedHitCount > 0);
+    TestEqual(TEXT("Only the actors which didn't change are reused"), CacheStats.HitCount, ExpectedHitCount);
+    TestTrue(TEXT("The occlusion is reused while the viewpoint doesn't move"), CacheStats.OcclusionHitCount > 0);
+    TestTrue(TEXT("The hit rate is reported"), CacheStats.GetHitRate() > 0.f);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVActorAnnotationCacheEvictionTest, "NVSceneCapturer.ActorAnnotationCache.Eviction", NV_UNIT_TEST_FLAGS)
+bool FNVActorAnnotationCacheEvictionTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestWorld TestWorld;
+    AActor* UsedActor = TestWorld.World->SpawnActor<AActor>();
+    AActor* UnusedActor = TestWorld.World->SpawnActor<AActor>();
+    if (!TestTrue(TEXT("The test actors are spawned"), UsedActor && UnusedActor))
+    {
+        return false;
+    }
+
+    FNVActorAnnotationCache ActorAnnotationCache;
+    ActorAnnotationCache.BeginFrame();
+
+    FNVActorAnnotationCache::FEntry UsedEntry;
+    UsedEntry.State.Update(UsedActor, 1);
+    const FNVActorAnnotationCache::FActorState UsedActorState = UsedEntry.State;
+    ActorAnnotationCache.Add(UsedActor, MoveTemp(UsedEntry));
+
+    FNVActorAnnotationCache::FEntry UnusedEntry;
+    UnusedEntry.State.Update(UnusedActor, 2);
+    ActorAnnotationCache.Add(UnusedActor, MoveTemp(UnusedEntry));
+    TestEqual(TEXT("Both actors are cached"), ActorAnnotationCache.Num(), 2);
+
+    // The entries which aren't used for a while are removed, e.g: the actor left the view or is destroyed
+    for (int32 FrameIndex = 0; FrameIndex < 100; FrameIndex++)
+    {
+        ActorAnnotationCache.BeginFrame();
+        TestNotNull(TEXT("The actor used every frame stay cached"), ActorAnnotationCache.Find(UsedActor, UsedActorState));
+    }
+    TestEqual(TEXT("The unused actor is removed"), ActorAnnotationCache.Num(), 1);
+
+    // A different mask id is a different annotation
+    FNVActorAnnotationCache::FActorState RemaskedActorState = UsedActorState;
+    RemaskedActorState.InstanceId = 3;
+    TestNull(TEXT("The actor with a new mask id isn't reused"), ActorAnnotationCache.Find(UsedActor, RemaskedActorState));
+
+    ActorAnnotationCache.Reset();
+    TestEqual(TEXT("The reset cache is empty"), ActorAnnotationCache.Num(), 0);
+    TestEqual(TEXT("The reset cache has no lookup"), ActorAnnotationCache.GetStats().LookupCount, (int64)0);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,595 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVAnnotationTestUtils.h"
+#include "NVAnnotationCompression.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    const int32 CompressionFormatCount = int32(ENVAnnotationCompressionFormat::NVAnnotationCompressionFormat_MAX);
+
+    /// Annotation data of a frame, the scene only change every few frames like a slow moving capture
+    TSharedPtr<FJsonObject> BuildAnnotationData(int32 FrameIndex, int32 ActorCount, int32 Seed)
+    {
+        return UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(*NVSceneCapturerTest::MakeRandomSnapshot(FrameIndex, ActorCount, Seed + FrameIndex / 4));
+    }
+
+    TArray<uint8> JsonObjectToUTF8(const TSharedPtr<FJsonObject>& JsonObject)
+    {
+        const FString JsonString = NVSceneCapturerTest::JsonObjectToString(JsonObject);
+        FTCHARToUTF8 UTF8Content(*JsonString);
+        return TArray<uint8>(reinterpret_cast<const uint8*>(UTF8Content.Get()), UTF8Content.Length());
+    }
+
+    /// The frames of a stream file, in the order they're read
+    struct FReadFrames
+    {
+        TArray<int32> FrameIndexes;
+        TArray<FString> AnnotationJsonStrings;
+    };
+
+    bool ReadStreamFrames(const FString& StreamFilePath, FReadFrames& OutReadFrames)
+    {
+        return FNVCompressedAnnotationStreamWriter::ReadStreamFile(StreamFilePath, [&OutReadFrames](int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)
+        {
+            OutReadFrames.FrameIndexes.Add(FrameIndex);
+            OutReadFrames.AnnotationJsonStrings.Add(NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+        });
+    }
+
+    /// Check the frames read from a stream file are the expected ones, in order
+    void TestReadFrames(FAutomationTestBase& Test, const FString& What, const FReadFrames& ReadFrames, const TArray<int32>& ExpectedFrameIndexes,
+                        const TArray<FString>& ExpectedJsonStrings)
+    {
+        Test.TestEqual(What + TEXT(": frame indexes"), FString::JoinBy(ReadFrames.FrameIndexes, TEXT(","), [](int32 FrameIndex) { return FString::FromInt(FrameIndex); }),
+                       FString::JoinBy(ExpectedFrameIndexes, TEXT(","), [](int32 FrameIndex) { return FString::FromInt(FrameIndex); }));
+        bool bSameFrames = (ReadFrames.AnnotationJsonStrings.Num() == ExpectedJsonStrings.Num());
+        for (int32 FrameOffset = 0; bSameFrames && (FrameOffset < ExpectedJsonStrings.Num()); FrameOffset++)
+        {
+            bSameFrames = ReadFrames.AnnotationJsonStrings[FrameOffset].Equals(ExpectedJsonStrings[FrameOffset], ESearchCase::CaseSensitive);
+        }
+        Test.TestTrue(What + TEXT(": the frames are the same as the written ones"), bSameFrames);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationCompressionBlocksTest, "NVSceneCapturer.AnnotationCompression.Blocks", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationCompressionBlocksTest::RunTest(const FString& Parameters)
+{
+    const TArray<uint8> BlockContents[3] = {
+        JsonObjectToUTF8(BuildAnnotationData(0, 20, 7)),
+        JsonObjectToUTF8(BuildAnnotationData(10, 3, 70)),
+        JsonObjectToUTF8(BuildAnnotationData(20, 60, 700))
+    };
+    TArray<uint8> ExpectedData;
+    for (const TArray<uint8>& BlockContent : BlockContents)
+    {
+        ExpectedData.Append(BlockContent);
+    }
+
+    for (int32 FormatIndex = 0; FormatIndex < CompressionFormatCount; FormatIndex++)
+    {
+        const ENVAnnotationCompressionFormat CompressionFormat = ENVAnnotationCompressionFormat(FormatIndex);
+        const FString FormatName = NVAnnotationCompression::GetCompressionFormatName(CompressionFormat).ToString();
+
+        // The blocks are appended one after the other and read back as a single content
+        TArray<uint8> BlockData;
+        for (const TArray<uint8>& BlockContent : BlockContents)
+        {
+            TestTrue(FString::Printf(TEXT("%s: the block is compressed"), *FormatName),
+                     NVAnnotationCompression::CompressBlock(CompressionFormat, BlockContent.GetData(), BlockContent.Num(), BlockData));
+        }
+        TestTrue(FString::Printf(TEXT("%s: the blocks are smaller than their content"), *FormatName), BlockData.Num() < ExpectedData.Num());
+
+        TArray<uint8> UncompressedData;
+        TestTrue(FString::Printf(TEXT("%s: the blocks are decompressed"), *FormatName), NVAnnotationCompression::DecompressBlocks(BlockData, UncompressedData));
+        TestTrue(FString::Printf(TEXT("%s: the blocks give back their content"), *FormatName), UncompressedData == ExpectedData);
+    }
+
+    // Nothing to compress doesn't make an empty block
+    TArray<uint8> EmptyBlockData;
+    TestFalse(TEXT("An empty content isn't compressed"), NVAnnotationCompression::CompressBlock(ENVAnnotationCompressionFormat::Oodle, nullptr, 0, EmptyBlockData));
+    TestEqual(TEXT("No block is added for an empty content"), EmptyBlockData.Num(), 0);
+
+    // A crash cut the last block: the blocks before it are still read
+    TArray<uint8> CutBlockData;
+    for (const TArray<uint8>& BlockContent : BlockContents)
+    {
+        NVAnnotationCompression::CompressBlock(ENVAnnotationCompressionFormat::Oodle, BlockContent.GetData(), BlockContent.Num(), CutBlockData);
+    }
+    CutBlockData.SetNum(CutBlockData.Num() - 5);
+    AddExpectedError(TEXT("invalid block"), EAutomationExpectedErrorFlags::Contains, 1);
+    TArray<uint8> CutUncompressedData;
+    TestFalse(TEXT("The cut block is reported"), NVAnnotationCompression::DecompressBlocks(CutBlockData, CutUncompressedData));
+    TestEqual(TEXT("The blocks before the cut one are decompressed"), CutUncompressedData.Num(), BlockContents[0].Num() + BlockContents[1].Num());
+
+    // A header cut in the middle
+    TArray<uint8> CutHeaderData;
+    NVAnnotationCompression::CompressBlock(ENVAnnotationCompressionFormat::LZ4, BlockContents[0].GetData(), BlockContents[0].Num(), CutHeaderData);
+    CutHeaderData.AddZeroed(6);
+    AddExpectedError(TEXT("is incomplete"), EAutomationExpectedErrorFlags::Contains, 1);
+    TArray<uint8> CutHeaderUncompressedData;
+    TestFalse(TEXT("The cut header is reported"), NVAnnotationCompression::DecompressBlocks(CutHeaderData, CutHeaderUncompressedData));
+    TestTrue(TEXT("The block before the cut header is decompressed"), CutHeaderUncompressedData == BlockContents[0]);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationCompressionStreamRoundTripTest, "NVSceneCapturer.AnnotationCompression.StreamRoundTrip", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationCompressionStreamRoundTripTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("AnnotationCompressionStream"));
+    const FString StreamFilePathPrefixes[2] = {
+        FPaths::Combine(TestDirectory.DirectoryPath, TEXT("_annotation_Viewpoint0")),
+        FPaths::Combine(TestDirectory.DirectoryPath, TEXT("Sub"), TEXT("_annotation_Viewpoint1"))
+    };
+
+    // 2 streams captured together, each stream roll over to a new file every 10 frames;
+    // the small blocks make each file hold several of them
+    const int32 FramesPerFile = 10;
+    const int32 FrameCount = 25;
+    FNVCompressedAnnotationStreamWriter StreamWriter;
+    StreamWriter.Open(ENVAnnotationCompressionMode::Stream, ENVAnnotationCompressionFormat::Zlib, FramesPerFile, 16 * 1024, 0, false);
+    TestTrue(TEXT("The stream writer is open"), StreamWriter.IsOpen());
+
+    TArray<FString> ExpectedJsonStrings[2];
+    int64 FullJsonSize = 0;
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+    {
+        for (int32 StreamIndex = 0; StreamIndex < 2; StreamIndex++)
+        {
+            const TSharedPtr<FJsonObject> AnnotationData = BuildAnnotationData(FrameIndex, 10 + StreamIndex * 20, 100 * (StreamIndex + 1));
+            ExpectedJsonStrings[StreamIndex].Add(NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+            FullJsonSize += ExpectedJsonStrings[StreamIndex].Last().Len();
+            TestTrue(FString::Printf(TEXT("Frame %d of stream %d is written"), FrameIndex, StreamIndex),
+                     StreamWriter.WriteFrame(StreamFilePathPrefixes[StreamIndex], FrameIndex, AnnotationData));
+        }
+    }
+
+    // Frame 3 come late, after its file is closed: it's appended to the file instead of overwriting it
+    const TSharedPtr<FJsonObject> LateAnnotationData = BuildAnnotationData(3, 5, 9);
+    TestTrue(TEXT("The late frame is written"), StreamWriter.WriteFrame(StreamFilePathPrefixes[0], 3, LateAnnotationData));
+    StreamWriter.Close();
+    TestFalse(TEXT("The stream writer is closed"), StreamWriter.IsOpen());
+    TestFalse(TEXT("A closed stream writer doesn't write"), StreamWriter.WriteFrame(StreamFilePathPrefixes[0], FrameCount, LateAnnotationData));
+
+    // Each frame is read back from its file exactly as it's written
+    int64 StreamFileSize = 0;
+    for (int32 StreamIndex = 0; StreamIndex < 2; StreamIndex++)
+    {
+        for (int32 FileIndex = 0; FileIndex * FramesPerFile < FrameCount; FileIndex++)
+        {
+            const int32 FirstFrameIndex = FileIndex * FramesPerFile;
+            const FString StreamFilePath = StreamWriter.GetStreamFilePath(StreamFilePathPrefixes[StreamIndex], FirstFrameIndex);
+            TestTrue(FString::Printf(TEXT("Stream %d file %d is named after its index"), StreamIndex, FileIndex),
+                     StreamFilePath.EndsWith(FString::Printf(TEXT(".%06d.jsonl"), FileIndex) + NVAnnotationCompression::CompressedFileExtension));
+
+            FReadFrames ReadFrames;
+            TestTrue(FString::Printf(TEXT("Stream %d file %d is read"), StreamIndex, FileIndex), ReadStreamFrames(StreamFilePath, ReadFrames));
+            const int32 FileFrameCount = FMath::Min(FramesPerFile, FrameCount - FirstFrameIndex);
+            const bool bHasLateFrame = (StreamIndex == 0) && (FileIndex == 0);
+            if (!TestEqual(FString::Printf(TEXT("Stream %d file %d has all its frames"), StreamIndex, FileIndex), ReadFrames.FrameIndexes.Num(), FileFrameCount + (bHasLateFrame ? 1 : 0)))
+            {
+                continue;
+            }
+            for (int32 FrameOffset = 0; FrameOffset < FileFrameCount; FrameOffset++)
+            {
+                const int32 FrameIndex = FirstFrameIndex + FrameOffset;
+                TestEqual(FString::Printf(TEXT("Stream %d frame %d index"), StreamIndex, FrameIndex), ReadFrames.FrameIndexes[FrameOffset], FrameIndex);
+                TestTrue(FString::Printf(TEXT("Stream %d frame %d is the same as the written one"), StreamIndex, FrameIndex),
+                         ReadFrames.AnnotationJsonStrings[FrameOffset].Equals(ExpectedJsonStrings[StreamIndex][FrameIndex], ESearchCase::CaseSensitive));
+            }
+            if (bHasLateFrame)
+            {
+                TestEqual(TEXT("The late frame is the last record of its file"), ReadFrames.FrameIndexes.Last(), 3);
+                TestTrue(TEXT("The late frame is the same as the written one"),
+                         ReadFrames.AnnotationJsonStrings.Last().Equals(NVSceneCapturerTest::JsonObjectToString(LateAnnotationData), ESearchCase::CaseSensitive));
+            }
+            StreamFileSize += IFileManager::Get().FileSize(*StreamFilePath);
+        }
+    }
+
+    AddInfo(FString::Printf(TEXT("Compressed stream files: %lld bytes, per-frame json: %lld characters"), StreamFileSize, FullJsonSize));
+    TestTrue(TEXT("The stream files are smaller than the per-frame json"), StreamFileSize < FullJsonSize);
+
+    // The stream files are plain json-lines once decompressed
+    FString StreamFileContent;
+    TestTrue(TEXT("The stream file is decompressed"), NVAnnotationCompression::LoadCompressedFileToString(StreamWriter.GetStreamFilePath(StreamFilePathPrefixes[1], 0), StreamFileContent));
+    TArray<FString> RecordLines;
+    StreamFileContent.ParseIntoArrayLines(RecordLines);
+    TestEqual(TEXT("The stream file has a line per frame"), RecordLines.Num(), FramesPerFile);
+    TestTrue(TEXT("The records start with their frame index"), (RecordLines.Num() > 1) && RecordLines[1].StartsWith(TEXT("{\"frame_index\":1,")));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationCompressionStreamResumeTest, "NVSceneCapturer.AnnotationCompression.StreamResume", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationCompressionStreamResumeTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("AnnotationCompressionResume"));
+    const FString StreamFilePathPrefix = FPaths::Combine(TestDirectory.DirectoryPath, TEXT("_annotation"));
+
+    // All the frames are in the same file, the first session capture frames 0-9
+    FNVCompressedAnnotationStreamWriter StreamWriter;
+    TMap<int32, FString> ExpectedJsonStrings;
+    StreamWriter.Open(ENVAnnotationCompressionMode::Stream, ENVAnnotationCompressionFormat::Oodle, 0, 1024, 0, false);
+    for (int32 FrameIndex = 0; FrameIndex < 10; FrameIndex++)
+    {
+        const TSharedPtr<FJsonObject> AnnotationData = BuildAnnotationData(FrameIndex, 8, 1);
+        ExpectedJsonStrings.Add(FrameIndex, NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+        StreamWriter.WriteFrame(StreamFilePathPrefix, FrameIndex, AnnotationData);
+    }
+    StreamWriter.Close();
+    const FString StreamFilePath = StreamWriter.GetStreamFilePath(StreamFilePathPrefix, 1000);
+    TestTrue(TEXT("All the frames are in the first file"), StreamFilePath == StreamWriter.GetStreamFilePath(StreamFilePathPrefix, 0));
+
+    // The resumed session capture the frames after the checkpoint at frame 6 again, they're appended to the same file
+    StreamWriter.Open(ENVAnnotationCompressionMode::Stream, ENVAnnotationCompressionFormat::Gzip, 0, 1024, 0, true);
+    for (int32 FrameIndex = 6; FrameIndex < 16; FrameIndex++)
+    {
+        const TSharedPtr<FJsonObject> AnnotationData = BuildAnnotationData(FrameIndex, 8, 2);
+        ExpectedJsonStrings.Add(FrameIndex, NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+        StreamWriter.WriteFrame(StreamFilePathPrefix, FrameIndex, AnnotationData);
+    }
+    StreamWriter.Close();
+
+    // The blocks of the 2 sessions are read in order, whatever their format; the last record of a frame is the valid one
+    FReadFrames ReadFrames;
+    TestTrue(TEXT("The resumed stream file is read"), ReadStreamFrames(StreamFilePath, ReadFrames));
+    TestEqual(TEXT("The records of both sessions are read"), ReadFrames.FrameIndexes.Num(), 20);
+    TMap<int32, FString> LastJsonStrings;
+    for (int32 RecordIndex = 0; RecordIndex < ReadFrames.FrameIndexes.Num(); RecordIndex++)
+    {
+        LastJsonStrings.Add(ReadFrames.FrameIndexes[RecordIndex], ReadFrames.AnnotationJsonStrings[RecordIndex]);
+    }
+    TestEqual(TEXT("All the frames are read"), LastJsonStrings.Num(), ExpectedJsonStrings.Num());
+    for (const auto& ExpectedJsonString : ExpectedJsonStrings)
+    {
+        const FString* LastJsonString = LastJsonStrings.Find(ExpectedJsonString.Key);
+        TestTrue(FString::Printf(TEXT("The last record of frame %d is the valid one"), ExpectedJsonString.Key),
+                 LastJsonString && LastJsonString->Equals(ExpectedJsonString.Value, ESearchCase::CaseSensitive));
+    }
+
+    // A crash cut the last block: the records of the blocks before it are still read
+    TArray<uint8> StreamFileData;
+    FFileHelper::LoadFileToArray(StreamFileData, *StreamFilePath);
+    StreamFileData.SetNum(StreamFileData.Num() - 3);
+    const FString CutStreamFilePath = FPaths::Combine(TestDirectory.DirectoryPath, TEXT("Cut.jsonl") + NVAnnotationCompression::CompressedFileExtension);
+    FFileHelper::SaveArrayToFile(StreamFileData, *CutStreamFilePath);
+    AddExpectedError(TEXT("invalid block"), EAutomationExpectedErrorFlags::Contains, 1);
+    FReadFrames CutReadFrames;
+    TestFalse(TEXT("The cut stream file is reported"), ReadStreamFrames(CutStreamFilePath, CutReadFrames));
+    TestTrue(TEXT("The records before the cut block are read"), (CutReadFrames.FrameIndexes.Num() > 0) && (CutReadFrames.FrameIndexes.Num() < 20));
+
+    // A new session which doesn't resume start the stream file over
+    StreamWriter.Open(ENVAnnotationCompressionMode::Stream, ENVAnnotationCompressionFormat::LZ4, 0, 1024, 0, false);
+    StreamWriter.WriteFrame(StreamFilePathPrefix, 0, BuildAnnotationData(0, 8, 3));
+    StreamWriter.Close();
+    FReadFrames NewReadFrames;
+    TestTrue(TEXT("The new stream file is read"), ReadStreamFrames(StreamFilePath, NewReadFrames));
+    TestEqual(TEXT("The new stream file only has the new session's records"), NewReadFrames.FrameIndexes.Num(), 1);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationCompressionDictionaryTest, "NVSceneCapturer.AnnotationCompression.Dictionary", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationCompressionDictionaryTest::RunTest(const FString& Parameters)
+{
+    // The dictionary is trained on the first 20 frames and used on the next 20
+    TArray<TArray<uint8>> TrainingRecords;
+    TArray<TArray<uint8>> Records;
+    for (int32 FrameIndex = 0; FrameIndex < 40; FrameIndex++)
+    {
+        (FrameIndex < 20 ? TrainingRecords : Records).Add(JsonObjectToUTF8(BuildAnnotationData(FrameIndex, 10, 5)));
+    }
+
+    TArray<uint8> Dictionary;
+    TestTrue(TEXT("The dictionary is trained"), NVAnnotationCompression::TrainDictionary(TrainingRecords, NVAnnotationCompression::MaxDictionarySize, Dictionary));
+    TestTrue(TEXT("The dictionary isn't empty"), Dictionary.Num() > 0);
+    TestTrue(TEXT("The dictionary fit in the zlib window"), Dictionary.Num() <= NVAnnotationCompression::MaxDictionarySize);
+
+    TArray<uint8> SmallDictionary;
+    NVAnnotationCompression::TrainDictionary(TrainingRecords, 100, SmallDictionary);
+    TestTrue(TEXT("The dictionary is capped to its maximum size"), (SmallDictionary.Num() > 0) && (SmallDictionary.Num() <= 100));
+
+    // A single sample or samples with nothing in common don't make a dictionary
+    TArray<uint8> NoDictionary;
+    TestFalse(TEXT("A single sample doesn't make a dictionary"), NVAnnotationCompression::TrainDictionary({ TrainingRecords[0] }, 1024, NoDictionary));
+    TestFalse(TEXT("No sample doesn't make a dictionary"), NVAnnotationCompression::TrainDictionary({}, 1024, NoDictionary));
+    TestEqual(TEXT("No dictionary is empty"), NoDictionary.Num(), 0);
+
+    // Each record is a block of its own, the dictionary make them smaller than without it
+    FNVAnnotationDictionaryCompressor DictionaryCompressor(Dictionary);
+    FNVAnnotationDictionaryCompressor PlainCompressor(TArray<uint8>{});
+    TArray<uint8> DictionaryBlockData;
+    TArray<uint8> PlainBlockData;
+    TArray<uint8> ExpectedData;
+    for (const TArray<uint8>& Record : Records)
+    {
+        TestTrue(TEXT("The record is compressed with the dictionary"), DictionaryCompressor.CompressBlock(Record.GetData(), Record.Num(), DictionaryBlockData));
+        TestTrue(TEXT("The record is compressed without dictionary"), PlainCompressor.CompressBlock(Record.GetData(), Record.Num(), PlainBlockData));
+        ExpectedData.Append(Record);
+    }
+    AddInfo(FString::Printf(TEXT("Records: %d bytes - with the dictionary: %d bytes - without: %d bytes"), ExpectedData.Num(), DictionaryBlockData.Num(), PlainBlockData.Num()));
+    TestTrue(TEXT("The dictionary make the records smaller"), DictionaryBlockData.Num() < PlainBlockData.Num());
+
+    TArray<uint8> UncompressedData;
+    TestTrue(TEXT("The records are decompressed with the dictionary"), NVAnnotationCompression::DecompressBlocks(DictionaryBlockData, UncompressedData, &Dictionary));
+    TestTrue(TEXT("The records are the same with the dictionary"), UncompressedData == ExpectedData);
+
+    // The blocks without dictionary are plain zlib blocks
+    TArray<uint8> PlainUncompressedData;
+    TestTrue(TEXT("The records without dictionary are decompressed"), NVAnnotationCompression::DecompressBlocks(PlainBlockData, PlainUncompressedData));
+    TestTrue(TEXT("The records are the same without dictionary"), PlainUncompressedData == ExpectedData);
+
+    // The blocks can't be read without their dictionary
+    AddExpectedError(TEXT("need its dictionary"), EAutomationExpectedErrorFlags::Contains, 1);
+    TArray<uint8> MissingDictionaryData;
+    TestFalse(TEXT("The records need the dictionary"), NVAnnotationCompression::DecompressBlocks(DictionaryBlockData, MissingDictionaryData));
+    TestEqual(TEXT("Nothing is decompressed without the dictionary"), MissingDictionaryData.Num(), 0);
+
+    AddExpectedError(TEXT("another dictionary"), EAutomationExpectedErrorFlags::Contains, 1);
+    AddExpectedError(TEXT("Can't decompress"), EAutomationExpectedErrorFlags::Contains, 1);
+    TArray<uint8> WrongDictionaryData;
+    TestFalse(TEXT("The records need the same dictionary"), NVAnnotationCompression::DecompressBlocks(DictionaryBlockData, WrongDictionaryData, &SmallDictionary));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationCompressionDictionaryRecordsTest, "NVSceneCapturer.AnnotationCompression.DictionaryRecords", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationCompressionDictionaryRecordsTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("AnnotationCompressionDictionary"));
+    const FString StreamFilePathPrefix = FPaths::Combine(TestDirectory.DirectoryPath, TEXT("_annotation"));
+    const FString DictionaryFilePath = FNVCompressedAnnotationStreamWriter::GetDictionaryFilePath(StreamFilePathPrefix);
+
+    // The dictionary is trained on the first 6 frames, they span 2 files
+    const int32 FramesPerFile = 4;
+    const int32 TrainingFrameCount = 6;
+    FNVCompressedAnnotationStreamWriter StreamWriter;
+    StreamWriter.Open(ENVAnnotationCompressionMode::DictionaryRecords, ENVAnnotationCompressionFormat::Oodle, FramesPerFile, 1024, TrainingFrameCount, false);
+
+    TMap<int32, FString> ExpectedJsonStrings;
+    for (int32 FrameIndex = 0; FrameIndex < 12; FrameIndex++)
+    {
+        if (FrameIndex == TrainingFrameCount - 1)
+        {
+            TestFalse(TEXT("The dictionary isn't saved before its training frames"), FPaths::FileExists(DictionaryFilePath));
+        }
+        const TSharedPtr<FJsonObject> AnnotationData = BuildAnnotationData(FrameIndex, 12, 11);
+        ExpectedJsonStrings.Add(FrameIndex, NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+        TestTrue(FString::Printf(TEXT("Frame %d is written"), FrameIndex), StreamWriter.WriteFrame(StreamFilePathPrefix, FrameIndex, AnnotationData));
+    }
+    TestTrue(TEXT("The dictionary is saved next to the stream files"), FPaths::FileExists(DictionaryFilePath));
+    StreamWriter.Close();
+
+    auto ReadFileFrames = [&](int32 FileIndex, const TArray<int32>& ExpectedFrameIndexes, const FString& What)
+    {
+        TArray<FString> FileJsonStrings;
+        for (int32 FrameIndex : ExpectedFrameIndexes)
+        {
+            FileJsonStrings.Add(ExpectedJsonStrings[FrameIndex]);
+        }
+        FReadFrames ReadFrames;
+        TestTrue(What + TEXT(": the stream file is read"), ReadStreamFrames(StreamWriter.GetStreamFilePath(StreamFilePathPrefix, FileIndex * FramesPerFile), ReadFrames));
+        TestReadFrames(*this, What, ReadFrames, ExpectedFrameIndexes, FileJsonStrings);
+    };
+    ReadFileFrames(0, { 0, 1, 2, 3 }, TEXT("File 0"));
+    ReadFileFrames(1, { 4, 5, 6, 7 }, TEXT("File 1"));
+    ReadFileFrames(2, { 8, 9, 10, 11 }, TEXT("File 2"));
+
+    // The resumed session keep the saved dictionary: its records are written right away and all the records are read with it
+    TArray<uint8> SavedDictionary;
+    FFileHelper::LoadFileToArray(SavedDictionary, *DictionaryFilePath);
+    StreamWriter.Open(ENVAnnotationCompressionMode::DictionaryRecords, ENVAnnotationCompressionFormat::Oodle, FramesPerFile, 1024, TrainingFrameCount, true);
+    const TSharedPtr<FJsonObject> ResumedAnnotationData = BuildAnnotationData(10, 12, 22);
+    ExpectedJsonStrings.Add(10, NVSceneCapturerTest::JsonObjectToString(ResumedAnnotationData));
+    StreamWriter.WriteFrame(StreamFilePathPrefix, 10, ResumedAnnotationData);
+    StreamWriter.WriteFrame(StreamFilePathPrefix, 12, BuildAnnotationData(12, 12, 22));
+    StreamWriter.Close();
+    TArray<uint8> ResumedDictionary;
+    FFileHelper::LoadFileToArray(ResumedDictionary, *DictionaryFilePath);
+    TestTrue(TEXT("The resumed session doesn't train a new dictionary"), ResumedDictionary == SavedDictionary);
+
+    FReadFrames LastReadFrames;
+    ReadStreamFrames(StreamWriter.GetStreamFilePath(StreamFilePathPrefix, 10), LastReadFrames);
+    TestTrue(TEXT("The resumed record is the last one"), (LastReadFrames.FrameIndexes.Num() == 5) && (LastReadFrames.FrameIndexes.Last() == 10)
+             && LastReadFrames.AnnotationJsonStrings.Last().Equals(ExpectedJsonStrings[10], ESearchCase::CaseSensitive));
+
+    // The records of the resumed session aren't held back for a new training, they're compressed with the saved dictionary
+    AddExpectedError(TEXT("need its dictionary"), EAutomationExpectedErrorFlags::Contains, 2);
+    const FString ResumedStreamFilePath = StreamWriter.GetStreamFilePath(StreamFilePathPrefix, 12);
+    FString ResumedStreamFileContent;
+    TestTrue(TEXT("The resumed records are compressed with the saved dictionary"),
+             NVAnnotationCompression::LoadCompressedFileToString(ResumedStreamFilePath, ResumedStreamFileContent, &SavedDictionary)
+             && ResumedStreamFileContent.StartsWith(TEXT("{\"frame_index\":12,")));
+    TestFalse(TEXT("The resumed records need the saved dictionary"), NVAnnotationCompression::LoadCompressedFileToString(ResumedStreamFilePath, ResumedStreamFileContent));
+
+    // A checkpoint before the end of the training train the dictionary on the frames so far, they're on the disk
+    StreamWriter.Open(ENVAnnotationCompressionMode::DictionaryRecords, ENVAnnotationCompressionFormat::Oodle, 0, 1024, 100, false);
+    for (int32 FrameIndex = 0; FrameIndex < 3; FrameIndex++)
+    {
+        StreamWriter.WriteFrame(StreamFilePathPrefix, FrameIndex, BuildAnnotationData(FrameIndex * 4, 12, 33));
+    }
+    TestFalse(TEXT("A new session start a new dictionary"), FPaths::FileExists(DictionaryFilePath));
+    StreamWriter.Flush();
+    TestTrue(TEXT("The checkpoint save the dictionary"), FPaths::FileExists(DictionaryFilePath));
+    FReadFrames FlushedReadFrames;
+    TestTrue(TEXT("The checkpoint write the training frames"), ReadStreamFrames(StreamWriter.GetStreamFilePath(StreamFilePathPrefix, 0), FlushedReadFrames)
+             && (FlushedReadFrames.FrameIndexes.Num() == 3));
+    StreamWriter.Close();
+
+    // The stream files can't be read without their dictionary
+    IFileManager::Get().Delete(*DictionaryFilePath);
+    FReadFrames MissingDictionaryReadFrames;
+    TestFalse(TEXT("The missing dictionary is reported"), ReadStreamFrames(StreamWriter.GetStreamFilePath(StreamFilePathPrefix, 0), MissingDictionaryReadFrames));
+    TestEqual(TEXT("No record is read without the dictionary"), MissingDictionaryReadFrames.FrameIndexes.Num(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationCompressionConcurrentStreamsTest, "NVSceneCapturer.AnnotationCompression.ConcurrentStreams", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationCompressionConcurrentStreamsTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("AnnotationCompressionConcurrent"));
+
+    // Each viewpoint stream its frames from its own thread while the other streams compress theirs
+    const int32 StreamCount = 6;
+    const int32 FrameCount = 30;
+    const ENVAnnotationCompressionMode CompressionModes[] = { ENVAnnotationCompressionMode::Stream, ENVAnnotationCompressionMode::DictionaryRecords };
+    for (const ENVAnnotationCompressionMode CompressionMode : CompressionModes)
+    {
+        const FString ModeName = StaticEnum<ENVAnnotationCompressionMode>()->GetNameStringByValue(int64(CompressionMode));
+        TArray<FString> StreamFilePathPrefixes;
+        TArray<TArray<TSharedPtr<FJsonObject>>> AnnotationDatas;
+        TArray<TArray<FString>> ExpectedJsonStrings;
+        for (int32 StreamIndex = 0; StreamIndex < StreamCount; StreamIndex++)
+        {
+            StreamFilePathPrefixes.Add(FPaths::Combine(TestDirectory.DirectoryPath, ModeName, FString::Printf(TEXT("_annotation_Viewpoint%d"), StreamIndex)));
+            TArray<TSharedPtr<FJsonObject>>& StreamAnnotationDatas = AnnotationDatas.AddDefaulted_GetRef();
+            TArray<FString>& StreamJsonStrings = ExpectedJsonStrings.AddDefaulted_GetRef();
+            for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+            {
+                StreamAnnotationDatas.Add(BuildAnnotationData(FrameIndex, 8, 1000 * StreamIndex));
+                StreamJsonStrings.Add(NVSceneCapturerTest::JsonObjectToString(StreamAnnotationDatas.Last()));
+            }
+        }
+
+        FNVCompressedAnnotationStreamWriter StreamWriter;
+        StreamWriter.Open(CompressionMode, ENVAnnotationCompressionFormat::Zlib, 0, 2048, 5, false);
+        std::atomic<int32> WrittenFrameCount(0);
+        ParallelFor(StreamCount, [&](int32 StreamIndex)
+        {
+            for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+            {
+                if (StreamWriter.WriteFrame(StreamFilePathPrefixes[StreamIndex], FrameIndex, AnnotationDatas[StreamIndex][FrameIndex]))
+                {
+                    WrittenFrameCount++;
+                }
+                if (FrameIndex == FrameCount / 2)
+                {
+                    StreamWriter.Flush();
+                }
+            }
+        });
+        StreamWriter.Close();
+        TestEqual(ModeName + TEXT(": all the frames are written"), WrittenFrameCount.load(), StreamCount * FrameCount);
+
+        TArray<int32> ExpectedFrameIndexes;
+        for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+        {
+            ExpectedFrameIndexes.Add(FrameIndex);
+        }
+        for (int32 StreamIndex = 0; StreamIndex < StreamCount; StreamIndex++)
+        {
+            const FString What = FString::Printf(TEXT("%s stream %d"), *ModeName, StreamIndex);
+            FReadFrames ReadFrames;
+            TestTrue(What + TEXT(": the stream file is read"), ReadStreamFrames(StreamWriter.GetStreamFilePath(StreamFilePathPrefixes[StreamIndex], 0), ReadFrames));
+            TestReadFrames(*this, What, ReadFrames, ExpectedFrameIndexes, ExpectedJsonStrings[StreamIndex]);
+        }
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationCompressionPerfTest, "NVSceneCapturer.Perf.AnnotationCompression", NV_PERF_TEST_FLAGS)
+bool FNVAnnotationCompressionPerfTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("AnnotationCompressionPerf"));
+
+    // 200 frames of 50 objects, the scene change every 4 frames
+    const int32 FrameCount = 200;
+    TArray<TSharedPtr<FJsonObject>> AnnotationDatas;
+    int64 FullJsonSize = 0;
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+    {
+        AnnotationDatas.Add(BuildAnnotationData(FrameIndex, 50, 42));
+        FullJsonSize += JsonObjectToUTF8(AnnotationDatas.Last()).Num();
+    }
+    const double FullJsonSizeMB = FullJsonSize / (1024.0 * 1024.0);
+
+    for (int32 FormatIndex = 0; FormatIndex < CompressionFormatCount; FormatIndex++)
+    {
+        const ENVAnnotationCompressionFormat CompressionFormat = ENVAnnotationCompressionFormat(FormatIndex);
+        const FString FormatName = NVAnnotationCompression::GetCompressionFormatName(CompressionFormat).ToString();
+
+        // Each frame compressed on its own, for reference: it can't use the redundancy between the frames
+        int64 FrameBlockSize = 0;
+        const double FrameBlockDuration = NVSceneCapturerTest::MeasureSeconds([&]()
+        {
+            for (const TSharedPtr<FJsonObject>& AnnotationData : AnnotationDatas)
+            {
+                const TArray<uint8> FrameData = JsonObjectToUTF8(AnnotationData);
+                TArray<uint8> BlockData;
+                NVAnnotationCompression::CompressBlock(CompressionFormat, FrameData.GetData(), FrameData.Num(), BlockData);
+                FrameBlockSize += BlockData.Num();
+            }
+        });
+
+        // The frames streamed into a single file with the default block size
+        const FString StreamFilePathPrefix = FPaths::Combine(TestDirectory.DirectoryPath, TEXT("_annotation_") + FormatName);
+        FNVCompressedAnnotationStreamWriter StreamWriter;
+        const double StreamDuration = NVSceneCapturerTest::MeasureSeconds([&]()
+        {
+            StreamWriter.Open(ENVAnnotationCompressionMode::Stream, CompressionFormat, 0, 256 * 1024, 0, false);
+            for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+            {
+                StreamWriter.WriteFrame(StreamFilePathPrefix, FrameIndex, AnnotationDatas[FrameIndex]);
+            }
+            StreamWriter.Close();
+        });
+        const FString StreamFilePath = StreamWriter.GetStreamFilePath(StreamFilePathPrefix, 0);
+        const int64 StreamFileSize = IFileManager::Get().FileSize(*StreamFilePath);
+
+        int32 ReadFrameCount = 0;
+        const double ReadDuration = NVSceneCapturerTest::MeasureSeconds([&]()
+        {
+            FNVCompressedAnnotationStreamWriter::ReadStreamFile(StreamFilePath, [&ReadFrameCount](int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)
+            {
+                ReadFrameCount++;
+            });
+        });
+        TestEqual(FString::Printf(TEXT("%s: all the frames are read back"), *FormatName), ReadFrameCount, FrameCount);
+
+        AddInfo(FString::Printf(TEXT("%s: per-frame blocks ratio %.1fx at %.1f MB/s - stream ratio %.1fx at %.1f MB/s - stream read %.1f MB/s"), *FormatName,
+                                double(FullJsonSize) / FMath::Max<int64>(FrameBlockSize, 1), FullJsonSizeMB / FrameBlockDuration,
+                                double(FullJsonSize) / FMath::Max<int64>(StreamFileSize, 1), FullJsonSizeMB / StreamDuration,
+                                FullJsonSizeMB / ReadDuration));
+    }
+
+    // Each frame compressed on its own with a dictionary trained on the first 20 frames, saved with the stream
+    const FString DictionaryStreamFilePathPrefix = FPaths::Combine(TestDirectory.DirectoryPath, TEXT("_annotation_Dictionary"));
+    FNVCompressedAnnotationStreamWriter DictionaryStreamWriter;
+    const double DictionaryStreamDuration = NVSceneCapturerTest::MeasureSeconds([&]()
+    {
+        DictionaryStreamWriter.Open(ENVAnnotationCompressionMode::DictionaryRecords, ENVAnnotationCompressionFormat::Zlib, 0, 256 * 1024, 20, false);
+        for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+        {
+            DictionaryStreamWriter.WriteFrame(DictionaryStreamFilePathPrefix, FrameIndex, AnnotationDatas[FrameIndex]);
+        }
+        DictionaryStreamWriter.Close();
+    });
+    const FString DictionaryStreamFilePath = DictionaryStreamWriter.GetStreamFilePath(DictionaryStreamFilePathPrefix, 0);
+    const int64 DictionaryStreamFileSize = IFileManager::Get().FileSize(*DictionaryStreamFilePath)
+                                         + IFileManager::Get().FileSize(*FNVCompressedAnnotationStreamWriter::GetDictionaryFilePath(DictionaryStreamFilePathPrefix));
+
+    int32 DictionaryReadFrameCount = 0;
+    const double DictionaryReadDuration = NVSceneCapturerTest::MeasureSeconds([&]()
+    {
+        FNVCompressedAnnotationStreamWriter::ReadStreamFile(DictionaryStreamFilePath, [&DictionaryReadFrameCount](int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)
+        {
+            DictionaryReadFrameCount++;
+        });
+    });
+    TestEqual(TEXT("Dictionary records: all the frames are read back"), DictionaryReadFrameCount, FrameCount);
+    AddInfo(FString::Printf(TEXT("Dictionary records: ratio %.1fx (with the dictionary) at %.1f MB/s - read %.1f MB/s"),
+                            double(FullJsonSize) / FMath::Max<int64>(DictionaryStreamFileSize, 1), FullJsonSizeMB / DictionaryStreamDuration,
+                            FullJsonSizeMB / DictionaryReadDuration));
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVAnnotationTestUtils.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// Build the annotation of each actor of a snapshot on its own: a snapshot with a single actor is always built serially
+    TArray<FString> BuildSerialObjectJsonStrings(const FNVSceneAnnotationSnapshot& Snapshot)
+    {
+        TArray<FString> ObjectJsonStrings;
+        for (const FNVActorAnnotationInput& ActorInput : Snapshot.Actors)
+        {
+            FNVSceneAnnotationSnapshot ActorSnapshot(Snapshot.FrameIndex);
+            ActorSnapshot.CameraData = Snapshot.CameraData;
+            ActorSnapshot.ViewContext = Snapshot.ViewContext;
+            ActorSnapshot.AnnotationFields = Snapshot.AnnotationFields;
+            ActorSnapshot.Actors.Add(ActorInput);
+
+            const TArray<FString> ActorJsonStrings = NVSceneCapturerTest::GetObjectJsonStrings(
+                UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(ActorSnapshot));
+            ObjectJsonStrings.Append(ActorJsonStrings);
+        }
+        return ObjectJsonStrings;
+    }
+
+    int32 CountMismatchedObjects(const TArray<FString>& ObjectJsonStrings, const TArray<FString>& ExpectedObjectJsonStrings)
+    {
+        int32 MismatchedObjectCount = FMath::Abs(ObjectJsonStrings.Num() - ExpectedObjectJsonStrings.Num());
+        for (int32 ObjectIndex = 0; ObjectIndex < FMath::Min(ObjectJsonStrings.Num(), ExpectedObjectJsonStrings.Num()); ObjectIndex++)
+        {
+            if (!ObjectJsonStrings[ObjectIndex].Equals(ExpectedObjectJsonStrings[ObjectIndex], ESearchCase::CaseSensitive))
+            {
+                MismatchedObjectCount++;
+            }
+        }
+        return MismatchedObjectCount;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationParallelEquivalenceTest, "NVSceneCapturer.AnnotationData.ParallelEquivalence", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationParallelEquivalenceTest::RunTest(const FString& Parameters)
+{
+    // A few randomized scenes, below and above the actor count the annotation start to be built in parallel
+    for (const int32 ActorCount : { 1, 15, 16, 64, 250 })
+    {
+        for (const int32 Seed : { 7, 1234, 98765 })
+        {
+            FNVSceneAnnotationSnapshotRef Snapshot = NVSceneCapturerTest::MakeRandomSnapshot(0, ActorCount, Seed);
+
+            const TSharedPtr<FJsonObject> AnnotationJsonObject = UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot.Get());
+            const TArray<FString> ObjectJsonStrings = NVSceneCapturerTest::GetObjectJsonStrings(AnnotationJsonObject);
+            const TArray<FString> SerialObjectJsonStrings = BuildSerialObjectJsonStrings(Snapshot.Get());
+
+            const FString SceneName = FString::Printf(TEXT("%d actors, seed %d"), ActorCount, Seed);
+            TestEqual(FString::Printf(TEXT("%s: all the actors are exported"), *SceneName), ObjectJsonStrings.Num(), ActorCount);
+            TestEqual(FString::Printf(TEXT("%s: the objects are the same as the serial ones, in the same order"), *SceneName),
+                      CountMismatchedObjects(ObjectJsonStrings, SerialObjectJsonStrings), 0);
+
+            // The scheduling of the worker threads doesn't change the result
+            const FString AnnotationJsonString = NVSceneCapturerTest::JsonObjectToString(AnnotationJsonObject);
+            for (int32 RunIndex = 0; RunIndex < 3; RunIndex++)
+            {
+                TestEqual(FString::Printf(TEXT("%s: run %d give the same annotation"), *SceneName, RunIndex),
+                          NVSceneCapturerTest::JsonObjectToString(UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot.Get())),
+                          AnnotationJsonString);
+            }
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationParallelObjectFieldsTest, "NVSceneCapturer.AnnotationData.ObjectFields", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationParallelObjectFieldsTest::RunTest(const FString& Parameters)
+{
+    FNVSceneAnnotationSnapshotRef Snapshot = NVSceneCapturerTest::MakeRandomSnapshot(0, 40, 42);
+    const TSharedPtr<FJsonObject> AnnotationJsonObject = UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot.Get());
+
+    const TArray<TSharedPtr<FJsonValue>>* ObjectJsonValues = nullptr;
+    if (!TestTrue(TEXT("The annotation has the objects"), AnnotationJsonObject.IsValid() && AnnotationJsonObject->TryGetArrayField(TEXT("objects"), ObjectJsonValues)))
+    {
+        return false;
+    }
+
+    // Each object is written at the index of its actor, with the actor's own data
+    for (int32 ActorIndex = 0; ActorIndex < ObjectJsonValues->Num(); ActorIndex++)
+    {
+        const FNVActorAnnotationInput& ActorInput = Snapshot->Actors[ActorIndex];
+        const TSharedPtr<FJsonObject> ObjectJsonObject = (*ObjectJsonValues)[ActorIndex]->AsObject();
+        TestEqual(FString::Printf(TEXT("Object %d is its actor"), ActorIndex), (uint32)ObjectJsonObject->GetNumberField(TEXT("instance_id")), ActorInput.InstanceId);
+        TestEqual(FString::Printf(TEXT("Object %d has its class"), ActorIndex), ObjectJsonObject->GetStringField(TEXT("class")), ActorInput.Class);
+        TestEqual(FString::Printf(TEXT("Object %d has all its sockets"), ActorIndex), ObjectJsonObject->GetArrayField(TEXT("socket_data")).Num(), ActorInput.SocketNames.Num());
+        TestEqual(FString::Printf(TEXT("Object %d has all its cuboid vertexes"), ActorIndex), ObjectJsonObject->GetArrayField(TEXT("projected_cuboid")).Num(), (int32)FNVCuboidData::TotalVertexesCount);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,238 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVAnnotationTestUtils.h"
+#include "NVAnnotationSchema.h"
+#include "NVSceneCapturerUtils.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// The json fields of each annotation field in the exported objects (in their export order), and the inputs it must be computed from, dependencies included
+    struct FExpectedFieldResolution
+    {
+        ENVAnnotationField Field;
+        const TCHAR* JsonFieldName;
+        const TCHAR* JsonFieldNames;
+        ENVAnnotationInput Inputs;
+    };
+
+    const FExpectedFieldResolution ExpectedFieldResolutions[] =
+    {
+        { ENVAnnotationField::Location, TEXT("location"),
+          TEXT("location_worldspace,location,viewpoint_azimuth_angle,viewpoint_altitude_angle,distance_scale"), ENVAnnotationInput::None },
+        { ENVAnnotationField::Rotation, TEXT("quaternion_xyzw"),
+          TEXT("rotation_worldspace,quaternion_worldspace,rotation,quaternion_xyzw,bounding_box_forward_direction"), ENVAnnotationInput::None },
+        { ENVAnnotationField::PoseTransform, TEXT("pose_transform"),
+          TEXT("actor_to_world_matrix_ue4,actor_to_world_matrix_opencv,actor_to_camera_matrix,pose_transform"), ENVAnnotationInput::None },
+        { ENVAnnotationField::CuboidCentroid, TEXT("cuboid_centroid"),
+          TEXT("dimensions_worldspace,bounding_box_center_worldspace,cuboid_centroid"), ENVAnnotationInput::Cuboid },
+        { ENVAnnotationField::ProjectedCuboidCentroid, TEXT("projected_cuboid_centroid"),
+          TEXT("projected_cuboid_centroid,bounding_box_forward_direction_imagespace"), ENVAnnotationInput::Cuboid },
+        { ENVAnnotationField::BoundingBox, TEXT("bounding_box"), TEXT("truncated,bounding_box"), ENVAnnotationInput::MeshVertexes },
+        { ENVAnnotationField::Cuboid, TEXT("cuboid"), TEXT("cuboid"), ENVAnnotationInput::Cuboid },
+        { ENVAnnotationField::ProjectedCuboid, TEXT("projected_cuboid"), TEXT("projected_cuboid"), ENVAnnotationInput::Cuboid },
+        // The occlusion is traced toward the cuboid's vertexes
+        { ENVAnnotationField::Visibility, TEXT("visibility"), TEXT("occluded,occlusion,visibility"), ENVAnnotationInput::Occlusion | ENVAnnotationInput::Cuboid },
+        { ENVAnnotationField::Sockets, TEXT("socket_data"), TEXT("socket_data"), ENVAnnotationInput::Sockets },
+        { ENVAnnotationField::CustomData, TEXT("custom_data"), TEXT("custom_data"), ENVAnnotationInput::CustomData },
+    };
+    static_assert(UE_ARRAY_COUNT(ExpectedFieldResolutions) == uint32(ENVAnnotationField::NVAnnotationField_MAX), "All the annotation fields must be tested");
+
+    const ENVAnnotationInput AllInputs[] =
+    {
+        ENVAnnotationInput::Cuboid, ENVAnnotationInput::MeshVertexes, ENVAnnotationInput::Occlusion, ENVAnnotationInput::Sockets, ENVAnnotationInput::CustomData
+    };
+
+    FNVAnnotationSchema MakeSchema(std::initializer_list<ENVAnnotationField> ExportedFields)
+    {
+        FNVAnnotationSchema Schema;
+        Schema.ExportedFields = ExportedFields;
+        return Schema;
+    }
+
+    /// Check which inputs the field set need
+    void TestInputs(FAutomationTestBase& Test, const FString& What, const FNVAnnotationFieldSet& FieldSet, ENVAnnotationInput ExpectedInputs)
+    {
+        for (const ENVAnnotationInput Input : AllInputs)
+        {
+            Test.TestTrue(FString::Printf(TEXT("%s: need input %d"), *What, int32(Input)), FieldSet.NeedInput(Input) == EnumHasAnyFlags(ExpectedInputs, Input));
+        }
+    }
+
+    /// An object with all its fields filled in, the custom data included
+    FCapturedObjectData MakeFullObjectData()
+    {
+        // NOTE: Value initialized, the fields which aren't set are 0
+        FCapturedObjectData ObjectData = FCapturedObjectData();
+        ObjectData.Name = TEXT("TestActor");
+        ObjectData.Class = TEXT("TestClass");
+        ObjectData.instance_id = 42;
+        ObjectData.truncated = 0.25f;
+        ObjectData.occluded = 1;
+        ObjectData.location = FVector(1.f, 2.f, 3.f);
+        ObjectData.quaternion_xyzw = FQuat(FRotator(10.f, 20.f, 30.f));
+        ObjectData.pose_transform = FMatrix::Identity;
+        ObjectData.cuboid.Add(FVector(4.f, 5.f, 6.f));
+        ObjectData.projected_cuboid.Add(FVector2D(7.f, 8.f));
+        FNVSocketData Socket;
+        Socket.SocketName = TEXT("TestSocket");
+        Socket.SocketLocation = FVector2D(9.f, 10.f);
+        ObjectData.socket_data.Add(Socket);
+        ObjectData.custom_data = MakeShared<FJsonObject>();
+        ObjectData.custom_data->SetStringField(TEXT("tag"), TEXT("test"));
+        return ObjectData;
+    }
+
+    FString GetJsonFieldNames(const TSharedPtr<FJsonObject>& JsonObject)
+    {
+        TArray<FString> FieldNames;
+        JsonObject->Values.GenerateKeyArray(FieldNames);
+        return FString::Join(FieldNames, TEXT(","));
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationSchemaDefaultTest, "NVSceneCapturer.AnnotationSchema.Default", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationSchemaDefaultTest::RunTest(const FString& Parameters)
+{
+    // All the fields are exported by default
+    const FNVAnnotationFieldSet FieldSet = FNVAnnotationFieldSet::Resolve(FNVAnnotationSchema(), false);
+    TestTrue(TEXT("The default schema is resolved"), FieldSet.IsResolved());
+    for (const FExpectedFieldResolution& Expected : ExpectedFieldResolutions)
+    {
+        TestTrue(FString::Printf(TEXT("%s is exported by default"), Expected.JsonFieldName), FieldSet.IsFieldExported(Expected.Field));
+        TestTrue(FString::Printf(TEXT("%s is computed by default"), Expected.JsonFieldName), FieldSet.HasField(Expected.Field));
+    }
+    TestInputs(*this, TEXT("Default schema"), FieldSet,
+               ENVAnnotationInput::Cuboid | ENVAnnotationInput::MeshVertexes | ENVAnnotationInput::Occlusion | ENVAnnotationInput::Sockets | ENVAnnotationInput::CustomData);
+
+    // The default schema export the objects the same way as before the schema existed: every property, then the custom data
+    const FCapturedObjectData FullObjectData = MakeFullObjectData();
+    const TSharedPtr<FJsonObject> BaselineObjectJsonObj = NVSceneCapturerUtils::UStructToJsonObject(FullObjectData, 0, 0);
+    BaselineObjectJsonObj->SetObjectField(TEXT("custom_data"), FullObjectData.custom_data);
+    TestEqual(TEXT("The default schema export the same objects as before"),
+              NVSceneCapturerTest::JsonObjectToString(FieldSet.ObjectDataToJsonObject(FullObjectData)), NVSceneCapturerTest::JsonObjectToString(BaselineObjectJsonObj));
+
+    // The default field set, before any schema is resolved, doesn't export anything
+    TestFalse(TEXT("The default field set isn't resolved"), FNVAnnotationFieldSet().IsResolved());
+
+    // An empty schema only export what identify the objects
+    const FNVAnnotationFieldSet EmptyFieldSet = FNVAnnotationFieldSet::Resolve(MakeSchema({}), false);
+    TestTrue(TEXT("The empty schema is resolved"), EmptyFieldSet.IsResolved());
+    TestInputs(*this, TEXT("Empty schema"), EmptyFieldSet, ENVAnnotationInput::None);
+    TestEqual(TEXT("Only the name, the class and the instance id are exported"),
+              GetJsonFieldNames(EmptyFieldSet.ObjectDataToJsonObject(FullObjectData)), FString(TEXT("name,class,instance_id")));
+
+    // The invalid fields are ignored
+    const FNVAnnotationFieldSet InvalidFieldSet = FNVAnnotationFieldSet::Resolve(MakeSchema({ ENVAnnotationField::NVAnnotationField_MAX, ENVAnnotationField::Location }), false);
+    TestTrue(TEXT("The valid field of a schema with an invalid one is exported"), InvalidFieldSet.IsFieldExported(ENVAnnotationField::Location));
+    TestEqual(TEXT("The invalid field isn't exported"), GetJsonFieldNames(InvalidFieldSet.ObjectDataToJsonObject(FullObjectData)),
+              FString::Printf(TEXT("name,class,instance_id,%s"), ExpectedFieldResolutions[0].JsonFieldNames));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationSchemaDependencyTest, "NVSceneCapturer.AnnotationSchema.Dependencies", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationSchemaDependencyTest::RunTest(const FString& Parameters)
+{
+    // Each field on its own only need its own inputs and the ones they depend on, and only export its own json field
+    const FCapturedObjectData FullObjectData = MakeFullObjectData();
+    for (const FExpectedFieldResolution& Expected : ExpectedFieldResolutions)
+    {
+        const FNVAnnotationFieldSet FieldSet = FNVAnnotationFieldSet::Resolve(MakeSchema({ Expected.Field }), false);
+        for (const FExpectedFieldResolution& OtherField : ExpectedFieldResolutions)
+        {
+            const bool bIsSameField = (OtherField.Field == Expected.Field);
+            TestTrue(FString::Printf(TEXT("%s schema: %s is exported"), Expected.JsonFieldName, OtherField.JsonFieldName), FieldSet.IsFieldExported(OtherField.Field) == bIsSameField);
+            TestTrue(FString::Printf(TEXT("%s schema: %s is computed"), Expected.JsonFieldName, OtherField.JsonFieldName), FieldSet.HasField(OtherField.Field) == bIsSameField);
+        }
+        TestInputs(*this, FString::Printf(TEXT("%s schema"), Expected.JsonFieldName), FieldSet, Expected.Inputs);
+
+        TestEqual(FString::Printf(TEXT("%s schema: exported json fields"), Expected.JsonFieldName),
+                  GetJsonFieldNames(FieldSet.ObjectDataToJsonObject(FullObjectData)), FString::Printf(TEXT("name,class,instance_id,%s"), Expected.JsonFieldNames));
+    }
+
+    // The fields sharing an input only gather it once, and the order of the schema doesn't matter
+    const FNVAnnotationFieldSet CuboidFieldSet = FNVAnnotationFieldSet::Resolve(
+        MakeSchema({ ENVAnnotationField::Visibility, ENVAnnotationField::ProjectedCuboid, ENVAnnotationField::CuboidCentroid }), false);
+    const FNVAnnotationFieldSet ReorderedFieldSet = FNVAnnotationFieldSet::Resolve(
+        MakeSchema({ ENVAnnotationField::CuboidCentroid, ENVAnnotationField::ProjectedCuboid, ENVAnnotationField::Visibility, ENVAnnotationField::Visibility }), false);
+    TestInputs(*this, TEXT("Cuboid fields"), CuboidFieldSet, ENVAnnotationInput::Cuboid | ENVAnnotationInput::Occlusion);
+    TestEqual(TEXT("The exported fields keep the declaration order whatever the schema order"),
+              NVSceneCapturerTest::JsonObjectToString(ReorderedFieldSet.ObjectDataToJsonObject(FullObjectData)),
+              NVSceneCapturerTest::JsonObjectToString(CuboidFieldSet.ObjectDataToJsonObject(FullObjectData)));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationSchemaInstanceMaskTest, "NVSceneCapturer.AnnotationSchema.InstanceMaskBoundingBox", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationSchemaInstanceMaskTest::RunTest(const FString& Parameters)
+{
+    // The bounding box filled in from the instance mask start as the bounds of the projected cuboid instead of the mesh vertexes
+    const FNVAnnotationFieldSet MaskFieldSet = FNVAnnotationFieldSet::Resolve(MakeSchema({ ENVAnnotationField::BoundingBox }), true);
+    TestTrue(TEXT("The bounding box is exported"), MaskFieldSet.IsFieldExported(ENVAnnotationField::BoundingBox));
+    TestTrue(TEXT("The projected cuboid is computed for the bounding box"), MaskFieldSet.HasField(ENVAnnotationField::ProjectedCuboid));
+    TestFalse(TEXT("The projected cuboid isn't exported"), MaskFieldSet.IsFieldExported(ENVAnnotationField::ProjectedCuboid));
+    TestInputs(*this, TEXT("Instance mask bounding box"), MaskFieldSet, ENVAnnotationInput::Cuboid);
+
+    TestEqual(TEXT("Only the bounding box is exported"), GetJsonFieldNames(MaskFieldSet.ObjectDataToJsonObject(MakeFullObjectData())),
+              FString(TEXT("name,class,instance_id,truncated,bounding_box")));
+
+    // The instance mask doesn't add anything when the bounding box isn't exported
+    const FNVAnnotationFieldSet NoBoxFieldSet = FNVAnnotationFieldSet::Resolve(MakeSchema({ ENVAnnotationField::Location }), true);
+    TestFalse(TEXT("No projected cuboid without bounding box"), NoBoxFieldSet.HasField(ENVAnnotationField::ProjectedCuboid));
+    TestInputs(*this, TEXT("Instance mask without bounding box"), NoBoxFieldSet, ENVAnnotationInput::None);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAnnotationSchemaSubsetTest, "NVSceneCapturer.AnnotationSchema.ExportedSubset", NV_UNIT_TEST_FLAGS)
+bool FNVAnnotationSchemaSubsetTest::RunTest(const FString& Parameters)
+{
+    // Omitting fields doesn't change the value of the exported ones
+    FNVSceneAnnotationSnapshotRef FullSnapshot = NVSceneCapturerTest::MakeRandomSnapshot(0, 20, 49);
+    const TArray<FString> FullObjectJsonStrings = NVSceneCapturerTest::GetObjectJsonStrings(
+        UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(FullSnapshot.Get()));
+
+    for (const FExpectedFieldResolution& Expected : ExpectedFieldResolutions)
+    {
+        FNVSceneAnnotationSnapshot Snapshot(0);
+        Snapshot.ViewContext = FullSnapshot->ViewContext;
+        Snapshot.AnnotationFields = FNVAnnotationFieldSet::Resolve(MakeSchema({ Expected.Field }), false);
+        Snapshot.Actors = FullSnapshot->Actors;
+
+        const TSharedPtr<FJsonObject> AnnotationJsonObject = UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot);
+        const TArray<TSharedPtr<FJsonValue>>* ObjectJsonValues = nullptr;
+        if (!TestTrue(FString::Printf(TEXT("%s schema: the annotation has the objects"), Expected.JsonFieldName),
+                      AnnotationJsonObject.IsValid() && AnnotationJsonObject->TryGetArrayField(TEXT("objects"), ObjectJsonValues)
+                      && (ObjectJsonValues->Num() == FullObjectJsonStrings.Num())))
+        {
+            continue;
+        }
+
+        int32 MismatchedObjectCount = 0;
+        for (int32 ObjectIndex = 0; ObjectIndex < ObjectJsonValues->Num(); ObjectIndex++)
+        {
+            // Keep the same fields of the full object to compare them
+            TSharedPtr<FJsonObject> FullObjectJsonObj;
+            FJsonSerializer::Deserialize(TJsonReaderFactory<TCHAR>::Create(FullObjectJsonStrings[ObjectIndex]), FullObjectJsonObj);
+            const TSharedPtr<FJsonObject> ObjectJsonObj = (*ObjectJsonValues)[ObjectIndex]->AsObject();
+            TSharedPtr<FJsonObject> FullSubsetJsonObj = MakeShared<FJsonObject>();
+            for (const auto& ObjectField : ObjectJsonObj->Values)
+            {
+                FullSubsetJsonObj->SetField(ObjectField.Key, FullObjectJsonObj->TryGetField(ObjectField.Key));
+            }
+            if (NVSceneCapturerTest::JsonObjectToString(ObjectJsonObj) != NVSceneCapturerTest::JsonObjectToString(FullSubsetJsonObj))
+            {
+                MismatchedObjectCount++;
+            }
+        }
+        TestEqual(FString::Printf(TEXT("%s schema: the exported field has the same value as in the full objects"), Expected.JsonFieldName), MismatchedObjectCount, 0);
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,133 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVSceneAnnotationSnapshot.h"
+#include "NVSceneCaptureComponent2D.h"
+#include "Math/RandomStream.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/// Synthetic annotation inputs shared by the annotation tests, they don't need any UObject nor world
+namespace NVSceneCapturerTest
+{
+    /// Corners of a unit box, the vertexes of the synthetic meshes' convex hull
+    inline TArrayView<const FVector> GetUnitBoxVertexes()
+    {
+        static const TArray<FVector> UnitBoxVertexes = {
+            FVector(-50.f, -50.f, -50.f), FVector(50.f, -50.f, -50.f), FVector(-50.f, 50.f, -50.f), FVector(50.f, 50.f, -50.f),
+            FVector(-50.f, -50.f, 50.f), FVector(50.f, -50.f, 50.f), FVector(-50.f, 50.f, 50.f), FVector(50.f, 50.f, 50.f)
+        };
+        return UnitBoxVertexes;
+    }
+
+    /// The view of a 640x480 perspective camera at the origin looking down the X axis
+    inline FNVAnnotationViewContext MakeTestViewContext(const FTransform& ViewTransform = FTransform::Identity)
+    {
+        FMatrix ProjectionMatrix;
+        FNVAnnotationViewContext ViewContext;
+        ViewContext.ViewProjectionMatrix = UNVSceneCaptureComponent2D::BuildViewProjectionMatrix(
+            ViewTransform, FNVImageSize(640, 480), ECameraProjectionMode::Perspective, 90.f, 640.f, ProjectionMatrix);
+        ViewContext.ViewLocation = ViewTransform.GetLocation();
+        ViewContext.WorldToCameraMatrixUE = ViewTransform.Inverse().ToMatrixNoScale();
+        ViewContext.WorldToCameraMatrixCV = ViewContext.WorldToCameraMatrixUE * NVSceneCapturerUtils::UE4ToOpenCVMatrix;
+        ViewContext.ImageScale = FVector2D(640.f, 480.f);
+        return ViewContext;
+    }
+
+    /// All the annotation fields: the default schema
+    inline FNVAnnotationFieldSet MakeFullAnnotationFields(bool bUseInstanceMaskBoundingBox = false)
+    {
+        return FNVAnnotationFieldSet::Resolve(FNVAnnotationSchema(), bUseInstanceMaskBoundingBox);
+    }
+
+    inline FTransform MakeRandomTransform(FRandomStream& RandomStream)
+    {
+        const FRotator Rotation(RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f));
+        const FVector Location(RandomStream.FRandRange(200.f, 2000.f), RandomStream.FRandRange(-800.f, 800.f), RandomStream.FRandRange(-600.f, 600.f));
+        const FVector Scale(RandomStream.FRandRange(0.2f, 3.f), RandomStream.FRandRange(0.2f, 3.f), RandomStream.FRandRange(0.2f, 3.f));
+        return FTransform(Rotation, Location, Scale);
+    }
+
+    /// An actor in front of the test camera with a box mesh, a few sockets and some custom data
+    inline FNVActorAnnotationInput MakeRandomActorInput(FRandomStream& RandomStream, int32 ActorIndex)
+    {
+        FNVActorAnnotationInput ActorInput;
+        ActorInput.Name = FString::Printf(TEXT("TestActor_%d"), ActorIndex);
+        ActorInput.Class = (ActorIndex % 3 == 0) ? TEXT("TestClassA") : TEXT("TestClassB");
+        ActorInput.InstanceId = (uint32)(ActorIndex + 1);
+        ActorInput.ActorToWorld = MakeRandomTransform(RandomStream);
+
+        FNVMeshBoundVertexSource VertexSource;
+        VertexSource.MeshTransform = ActorInput.ActorToWorld;
+        VertexSource.ConvexVertexes.Add(GetUnitBoxVertexes());
+        ActorInput.MeshVertexSources.Add(MoveTemp(VertexSource));
+
+        const FBox LocalBox(FVector(-50.f), FVector(50.f));
+        ActorInput.Cuboid = FNVCuboidData(LocalBox, ActorInput.ActorToWorld);
+        ActorInput.OccludedVertexCount = RandomStream.RandRange(0, 8);
+
+        const int32 SocketCount = RandomStream.RandRange(0, 6);
+        for (int32 SocketIndex = 0; SocketIndex < SocketCount; SocketIndex++)
+        {
+            ActorInput.SocketNames.Add(FString::Printf(TEXT("Socket_%d"), SocketIndex));
+            ActorInput.SocketWorldLocations.Add(ActorInput.ActorToWorld.TransformPosition(RandomStream.GetUnitVector() * 50.f));
+        }
+
+        ActorInput.CustomData = MakeShared<FJsonObject>();
+        ActorInput.CustomData->SetNumberField(TEXT("actor_index"), ActorIndex);
+        return ActorInput;
+    }
+
+    /// A snapshot of randomized actors seen by the test camera
+    inline FNVSceneAnnotationSnapshotRef MakeRandomSnapshot(int32 FrameIndex, int32 ActorCount, int32 Seed)
+    {
+        FRandomStream RandomStream(Seed);
+        FNVSceneAnnotationSnapshotRef Snapshot = MakeShared<FNVSceneAnnotationSnapshot, ESPMode::ThreadSafe>(FrameIndex);
+        Snapshot->ViewContext = MakeTestViewContext();
+        Snapshot->AnnotationFields = MakeFullAnnotationFields();
+        for (int32 ActorIndex = 0; ActorIndex < ActorCount; ActorIndex++)
+        {
+            Snapshot->Actors.Add(MakeRandomActorInput(RandomStream, ActorIndex));
+        }
+        return Snapshot;
+    }
+
+    /// Serialize a json object to a condensed string so two annotations can be compared exactly
+    inline FString JsonObjectToString(const TSharedPtr<FJsonObject>& JsonObject)
+    {
+        FString JsonString;
+        if (JsonObject.IsValid())
+        {
+            TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
+            FJsonSerializer::Serialize(JsonObject.ToSharedRef(), JsonWriter);
+        }
+        return JsonString;
+    }
+
+    /// Serialize each exported object of an annotation
+    inline TArray<FString> GetObjectJsonStrings(const TSharedPtr<FJsonObject>& AnnotationJsonObject)
+    {
+        TArray<FString> ObjectJsonStrings;
+        const TArray<TSharedPtr<FJsonValue>>* ObjectJsonValues = nullptr;
+        if (AnnotationJsonObject.IsValid() && AnnotationJsonObject->TryGetArrayField(TEXT("objects"), ObjectJsonValues))
+        {
+            for (const TSharedPtr<FJsonValue>& ObjectJsonValue : *ObjectJsonValues)
+            {
+                ObjectJsonStrings.Add(JsonObjectToString(ObjectJsonValue->AsObject()));
+            }
+        }
+        return ObjectJsonStrings;
+    }
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,175 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVSceneFeatureExtractor.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    FNVCaptureCadence MakeFrameIntervalCadence(int32 FrameInterval, int32 FrameOffset)
+    {
+        FNVCaptureCadence Cadence;
+        Cadence.CadenceType = ENVCaptureCadenceType::FrameInterval;
+        Cadence.FrameInterval = FrameInterval;
+        Cadence.FrameOffset = FrameOffset;
+        return Cadence;
+    }
+
+    FNVCaptureCadence MakeProbabilityCadence(float Probability)
+    {
+        FNVCaptureCadence Cadence;
+        Cadence.CadenceType = ENVCaptureCadenceType::Probability;
+        Cadence.Probability = Probability;
+        return Cadence;
+    }
+
+    /// The frames in [0, FrameCount) a cadence is due at, the probability cadence use the value drawn for the settings each frame
+    FString GetDueFrames(const FNVCaptureCadence& Cadence, int32 FrameCount, int32 RunSeed, const FObjectKey& SettingsKey)
+    {
+        FNVCaptureCadenceDraws CadenceDraws;
+        TArray<FString> DueFrames;
+        for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+        {
+            CadenceDraws.BeginFrame(RunSeed, FrameIndex);
+            CadenceDraws.DrawRandomValue(SettingsKey);
+            if (Cadence.IsDueAtFrame(FrameIndex, CadenceDraws.GetRandomValue(SettingsKey)))
+            {
+                DueFrames.Add(FString::FromInt(FrameIndex));
+            }
+        }
+        return FString::Join(DueFrames, TEXT(","));
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureCadenceFrameIntervalTest, "NVSceneCapturer.CaptureCadence.FrameInterval", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureCadenceFrameIntervalTest::RunTest(const FString& Parameters)
+{
+    const FObjectKey SettingsKey(GetTransientPackage());
+
+    TestEqual(TEXT("Every frame"), GetDueFrames(FNVCaptureCadence(), 5, 0, SettingsKey), FString(TEXT("0,1,2,3,4")));
+    TestEqual(TEXT("Every 3 frames"), GetDueFrames(MakeFrameIntervalCadence(3, 0), 10, 0, SettingsKey), FString(TEXT("0,3,6,9")));
+    TestEqual(TEXT("Every 3 frames from the frame 2"), GetDueFrames(MakeFrameIntervalCadence(3, 2), 10, 0, SettingsKey), FString(TEXT("2,5,8")));
+    TestEqual(TEXT("An interval of 1 is every frame"), GetDueFrames(MakeFrameIntervalCadence(1, 0), 4, 0, SettingsKey), FString(TEXT("0,1,2,3")));
+
+    // The invalid values are clamped the same way the editor does
+    TestEqual(TEXT("A null interval is every frame"), GetDueFrames(MakeFrameIntervalCadence(0, 0), 4, 0, SettingsKey), FString(TEXT("0,1,2,3")));
+    TestEqual(TEXT("A negative offset start at the first frame"), GetDueFrames(MakeFrameIntervalCadence(2, -3), 6, 0, SettingsKey), FString(TEXT("0,2,4")));
+
+    // The random value doesn't change the frame interval cadence
+    TestTrue(TEXT("The frame interval ignore the random value"), MakeFrameIntervalCadence(2, 0).IsDueAtFrame(4, 0.99f));
+    TestFalse(TEXT("The frame interval ignore the random value"), MakeFrameIntervalCadence(2, 0).IsDueAtFrame(5, 0.f));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureCadenceRandomFramesTest, "NVSceneCapturer.CaptureCadence.RandomFrames", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureCadenceRandomFramesTest::RunTest(const FString& Parameters)
+{
+    const FObjectKey SettingsKeyA(GetTransientPackage());
+    const FObjectKey SettingsKeyB(UObject::StaticClass());
+    const FObjectKey SettingsKeyC(UPackage::StaticClass());
+    const FNVCaptureCadence HalfCadence = MakeProbabilityCadence(0.5f);
+
+    // The schedule only depend on the run seed and the frame index
+    const FString DueFrames = GetDueFrames(HalfCadence, 200, 7, SettingsKeyA);
+    TestEqual(TEXT("The same run seed capture the same frames"), GetDueFrames(HalfCadence, 200, 7, SettingsKeyA), DueFrames);
+    TestNotEqual(TEXT("Another run seed capture other frames"), GetDueFrames(HalfCadence, 200, 8, SettingsKeyA), DueFrames);
+
+    {
+        FNVCaptureCadenceDraws CadenceDraws;
+        CadenceDraws.BeginFrame(7, 42);
+        CadenceDraws.DrawRandomValue(SettingsKeyA);
+        const float FrameValue = CadenceDraws.GetRandomValue(SettingsKeyA);
+
+        // A frame drawn alone, e.g: when the capture resume at that frame, has the same value
+        CadenceDraws.BeginFrame(7, 0);
+        CadenceDraws.DrawRandomValue(SettingsKeyA);
+        CadenceDraws.BeginFrame(7, 42);
+        CadenceDraws.DrawRandomValue(SettingsKeyA);
+        TestEqual(TEXT("The value of a frame doesn't depend on the previous frames"), CadenceDraws.GetRandomValue(SettingsKeyA), FrameValue);
+    }
+
+    // Drawing the cadences doesn't consume the global random stream the scene is randomized with
+    {
+        FMath::RandInit(1234);
+        const int32 ExpectedRandValue = FMath::Rand();
+
+        FMath::RandInit(1234);
+        FNVCaptureCadenceDraws CadenceDraws;
+        for (int32 FrameIndex = 0; FrameIndex < 100; FrameIndex++)
+        {
+            CadenceDraws.BeginFrame(0, FrameIndex);
+            CadenceDraws.DrawRandomValue(SettingsKeyA);
+            CadenceDraws.DrawRandomValue(SettingsKeyB);
+        }
+        TestEqual(TEXT("The global random stream is unchanged"), FMath::Rand(), ExpectedRandValue);
+    }
+
+    // The viewpoints sharing the settings share the value, e.g: both images of a stereo pair are captured together
+    {
+        FNVCaptureCadenceDraws CadenceDraws;
+        CadenceDraws.BeginFrame(3, 5);
+        CadenceDraws.DrawRandomValue(SettingsKeyA);
+        CadenceDraws.DrawRandomValue(SettingsKeyB);
+        const float ValueA = CadenceDraws.GetRandomValue(SettingsKeyA);
+        const float ValueB = CadenceDraws.GetRandomValue(SettingsKeyB);
+        TestNotEqual(TEXT("Each settings has its own value"), ValueA, ValueB);
+
+        // The second viewpoint draw the same settings again
+        CadenceDraws.DrawRandomValue(SettingsKeyA);
+        CadenceDraws.DrawRandomValue(SettingsKeyB);
+        TestEqual(TEXT("The second viewpoint keep the value of the first"), CadenceDraws.GetRandomValue(SettingsKeyA), ValueA);
+        TestEqual(TEXT("The second viewpoint keep the value of the first"), CadenceDraws.GetRandomValue(SettingsKeyB), ValueB);
+
+        TestEqual(TEXT("The settings not drawn this frame has no value"), CadenceDraws.GetRandomValue(SettingsKeyC), 0.f);
+        CadenceDraws.BeginFrame(3, 6);
+        TestEqual(TEXT("The values are forgotten at the next frame"), CadenceDraws.GetRandomValue(SettingsKeyA), 0.f);
+    }
+
+    // Settings without feature extractor still draw so the values of the next settings don't depend on them
+    {
+        FNVCaptureCadenceDraws CadenceDraws;
+        CadenceDraws.BeginFrame(3, 5);
+        CadenceDraws.DrawRandomValue(SettingsKeyA);
+        CadenceDraws.DrawRandomValue(SettingsKeyB);
+        const float ExpectedValueB = CadenceDraws.GetRandomValue(SettingsKeyB);
+
+        CadenceDraws.BeginFrame(3, 5);
+        CadenceDraws.DrawRandomValue(FObjectKey());
+        CadenceDraws.DrawRandomValue(SettingsKeyB);
+        TestEqual(TEXT("An empty settings take its turn in the stream"), CadenceDraws.GetRandomValue(SettingsKeyB), ExpectedValueB);
+    }
+
+    // The captured ratio follow the probability
+    {
+        const int32 FrameCount = 20000;
+        const FNVCaptureCadence QuarterCadence = MakeProbabilityCadence(0.25f);
+        FNVCaptureCadenceDraws CadenceDraws;
+        int32 DueFrameCount = 0;
+        for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+        {
+            CadenceDraws.BeginFrame(11, FrameIndex);
+            CadenceDraws.DrawRandomValue(SettingsKeyA);
+            if (QuarterCadence.IsDueAtFrame(FrameIndex, CadenceDraws.GetRandomValue(SettingsKeyA)))
+            {
+                DueFrameCount++;
+            }
+        }
+        const float DueRatio = float(DueFrameCount) / FrameCount;
+        TestTrue(FString::Printf(TEXT("A quarter of the frames are captured (%.4f)"), DueRatio), FMath::Abs(DueRatio - 0.25f) < 0.02f);
+
+        TestEqual(TEXT("A null probability never capture"), GetDueFrames(MakeProbabilityCadence(0.f), 100, 11, SettingsKeyA), FString());
+        TestEqual(TEXT("A probability of 1 always capture"), GetDueFrames(MakeProbabilityCadence(1.f), 3, 11, SettingsKeyA), FString(TEXT("0,1,2")));
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
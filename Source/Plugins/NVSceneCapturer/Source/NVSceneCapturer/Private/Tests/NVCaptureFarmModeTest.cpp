@@ -0,0 +1,189 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVCaptureFarmMode.h"
+#include "Engine/GameViewportClient.h"
+#include "GameFramework/HUD.h"
+#include "HAL/IConsoleManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// A test world with a game viewport and 2 HUDs, the first one shown and the second one hidden
+    struct FFarmModeTestWorld : public NVSceneCapturerTest::FScopedTestWorld
+    {
+        UGameViewportClient* GameViewport = nullptr;
+        AHUD* ShownHUD = nullptr;
+        AHUD* HiddenHUD = nullptr;
+
+        explicit FFarmModeTestWorld(bool bDisableWorldRendering)
+        {
+            // NOTE: The viewport client isn't initialized, the mode only touch its world rendering flag
+            GameViewport = NewObject<UGameViewportClient>(GetTransientPackage());
+            GameViewport->bDisableWorldRendering = bDisableWorldRendering;
+            GEngine->GetWorldContextFromWorldChecked(World).GameViewport = GameViewport;
+
+            ShownHUD = World->SpawnActor<AHUD>();
+            ShownHUD->bShowHUD = true;
+            HiddenHUD = World->SpawnActor<AHUD>();
+            HiddenHUD->bShowHUD = false;
+        }
+
+        ~FFarmModeTestWorld()
+        {
+            GEngine->GetWorldContextFromWorldChecked(World).GameViewport = nullptr;
+        }
+    };
+
+    /// Check the game viewport and the HUDs are in the state they were before the mode is entered
+    void TestRestoredState(FAutomationTestBase& Test, const FString& What, const FFarmModeTestWorld& TestWorld, bool bExpectedDisableWorldRendering)
+    {
+        Test.TestTrue(What + TEXT(": the world rendering is restored"), TestWorld.GameViewport->bDisableWorldRendering == bExpectedDisableWorldRendering);
+        Test.TestTrue(What + TEXT(": the shown HUD is shown again"), TestWorld.ShownHUD->bShowHUD);
+        Test.TestFalse(What + TEXT(": the hidden HUD stay hidden"), TestWorld.HiddenHUD->bShowHUD);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureFarmModeToggleTest, "NVSceneCapturer.CaptureFarmMode.Toggle", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureFarmModeToggleTest::RunTest(const FString& Parameters)
+{
+    FFarmModeTestWorld TestWorld(false);
+    UWorld* World = TestWorld.World;
+
+    IConsoleVariable* ScreenPercentageCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.ScreenPercentage"));
+    const float OriginalScreenPercentage = ScreenPercentageCVar ? ScreenPercentageCVar->GetFloat() : 100.f;
+
+    TArray<bool> ModeChanges;
+    const FDelegateHandle ModeChangedHandle = FNVCaptureFarmMode::OnCaptureFarmModeChanged().AddLambda([&ModeChanges](bool bRenderingSuppressed)
+    {
+        ModeChanges.Add(bRenderingSuppressed);
+    });
+
+    FNVCaptureFarmModeSettings Settings;
+    Settings.bEnabled = true;
+    Settings.BaselineFrameCount = 2;
+    Settings.PreviewInterval = 1.f;
+    Settings.PreviewScreenPercentage = 25.f;
+
+    FNVCaptureFarmMode FarmMode;
+    FarmMode.Enter(World, Settings);
+    TestTrue(TEXT("The mode is active"), FarmMode.IsActive());
+
+    // The baseline frames are rendered normally
+    FarmMode.Tick(World, 0.1f);
+    TestFalse(TEXT("The baseline frames are rendered"), FarmMode.IsRenderingSuppressed());
+    TestFalse(TEXT("The baseline frames render the world"), TestWorld.GameViewport->bDisableWorldRendering);
+    TestTrue(TEXT("The baseline frames show the HUD"), TestWorld.ShownHUD->bShowHUD);
+
+    FarmMode.Tick(World, 0.1f);
+    TestTrue(TEXT("The rendering is suppressed after the baseline frames"), FarmMode.IsRenderingSuppressed());
+    TestTrue(TEXT("The world isn't rendered"), TestWorld.GameViewport->bDisableWorldRendering);
+    TestFalse(TEXT("The HUD is hidden"), TestWorld.ShownHUD->bShowHUD);
+    TestFalse(TEXT("The hidden HUD stay hidden"), TestWorld.HiddenHUD->bShowHUD);
+    TestEqual(TEXT("The baseline frames are sampled"), FarmMode.GetBaselineFrameTimes().SampleCount, 2);
+
+    // The preview renders a single frame at the preview resolution
+    FarmMode.Tick(World, 0.6f);
+    TestTrue(TEXT("No preview before the interval"), TestWorld.GameViewport->bDisableWorldRendering);
+    FarmMode.Tick(World, 0.6f);
+    TestFalse(TEXT("The preview frame render the world"), TestWorld.GameViewport->bDisableWorldRendering);
+    TestFalse(TEXT("The preview frame doesn't show the HUD"), TestWorld.ShownHUD->bShowHUD);
+    if (ScreenPercentageCVar)
+    {
+        TestEqual(TEXT("The preview is rendered at a low resolution"), ScreenPercentageCVar->GetFloat(), 25.f);
+    }
+    FarmMode.Tick(World, 0.1f);
+    TestTrue(TEXT("The world isn't rendered after the preview"), TestWorld.GameViewport->bDisableWorldRendering);
+    if (ScreenPercentageCVar)
+    {
+        TestEqual(TEXT("The resolution is restored after the preview"), ScreenPercentageCVar->GetFloat(), OriginalScreenPercentage);
+    }
+    TestEqual(TEXT("The preview frame isn't sampled"), FarmMode.GetFarmModeFrameTimes().SampleCount, 2);
+
+    // Exiting in the middle of a preview restore everything
+    FarmMode.Tick(World, 1.f);
+    FarmMode.Exit(World);
+    TestFalse(TEXT("The mode is inactive"), FarmMode.IsActive());
+    TestFalse(TEXT("The rendering isn't suppressed"), FarmMode.IsRenderingSuppressed());
+    TestRestoredState(*this, TEXT("Exit"), TestWorld, false);
+    if (ScreenPercentageCVar)
+    {
+        TestEqual(TEXT("The resolution is restored"), ScreenPercentageCVar->GetFloat(), OriginalScreenPercentage);
+    }
+
+    FNVCaptureFarmMode::OnCaptureFarmModeChanged().Remove(ModeChangedHandle);
+    TestEqual(TEXT("The rendering is suppressed then restored once"), ModeChanges.Num(), 2);
+    TestTrue(TEXT("The changes are broadcasted in order"), (ModeChanges.Num() == 2) && ModeChanges[0] && !ModeChanges[1]);
+
+    // A second exit doesn't touch the state anymore
+    TestWorld.ShownHUD->bShowHUD = false;
+    FarmMode.Exit(World);
+    TestFalse(TEXT("Exiting twice doesn't restore the state again"), TestWorld.ShownHUD->bShowHUD);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureFarmModeRestoreTest, "NVSceneCapturer.CaptureFarmMode.Restore", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureFarmModeRestoreTest::RunTest(const FString& Parameters)
+{
+    FNVCaptureFarmModeSettings Settings;
+    Settings.bEnabled = true;
+    Settings.BaselineFrameCount = 0;
+
+    // Without baseline frames the rendering is suppressed right away
+    {
+        FFarmModeTestWorld TestWorld(false);
+        FNVCaptureFarmMode FarmMode;
+        FarmMode.Enter(TestWorld.World, Settings);
+        TestTrue(TEXT("The rendering is suppressed on enter"), FarmMode.IsRenderingSuppressed());
+        TestTrue(TEXT("The world isn't rendered"), TestWorld.GameViewport->bDisableWorldRendering);
+
+        // No preview interval: the world is never rendered
+        for (int32 FrameIndex = 0; FrameIndex < 10; FrameIndex++)
+        {
+            FarmMode.Tick(TestWorld.World, 1.f);
+            TestTrue(TEXT("The world is never rendered without preview"), TestWorld.GameViewport->bDisableWorldRendering);
+        }
+
+        FarmMode.Exit(TestWorld.World);
+        TestRestoredState(*this, TEXT("No baseline"), TestWorld, false);
+    }
+
+    // The world rendering turned off before the mode is entered stay off
+    {
+        FFarmModeTestWorld TestWorld(true);
+        FNVCaptureFarmMode FarmMode;
+        FarmMode.Enter(TestWorld.World, Settings);
+        FarmMode.Exit(TestWorld.World);
+        TestRestoredState(*this, TEXT("Disabled world rendering"), TestWorld, true);
+    }
+
+    // Exiting before the end of the baseline doesn't touch the state
+    {
+        FFarmModeTestWorld TestWorld(false);
+        FNVCaptureFarmModeSettings BaselineSettings = Settings;
+        BaselineSettings.BaselineFrameCount = 5;
+        FNVCaptureFarmMode FarmMode;
+        FarmMode.Enter(TestWorld.World, BaselineSettings);
+        FarmMode.Tick(TestWorld.World, 0.1f);
+        FarmMode.Exit(TestWorld.World);
+        TestRestoredState(*this, TEXT("Exit during the baseline"), TestWorld, false);
+    }
+
+    // Nothing happen without world
+    {
+        FNVCaptureFarmMode FarmMode;
+        FarmMode.Enter(nullptr, Settings);
+        TestFalse(TEXT("The mode isn't entered without world"), FarmMode.IsActive());
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
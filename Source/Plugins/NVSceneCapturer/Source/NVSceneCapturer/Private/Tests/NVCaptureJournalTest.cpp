@@ -0,0 +1,216 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVCaptureJournal.h"
+#include "Misc/FileHelper.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    FNVCaptureCheckpoint MakeCheckpoint(int32 FrameIndex)
+    {
+        FNVCaptureCheckpoint Checkpoint;
+        Checkpoint.FrameIndex = FrameIndex;
+        Checkpoint.MarkerIndex = FrameIndex / 100;
+        Checkpoint.RandomSeed = FrameIndex * 7919 + 13;
+        Checkpoint.WrittenFiles.Add(FString::Printf(TEXT("%06d.png"), FrameIndex));
+        Checkpoint.WrittenFiles.Add(FString::Printf(TEXT("%06d.json"), FrameIndex));
+        return Checkpoint;
+    }
+
+    /// Write a journal with the checkpoints of the frames and return its content
+    TArray<uint8> WriteJournal(const FString& DirectoryPath, const TArray<int32>& FrameIndexes)
+    {
+        FNVCaptureJournal Journal;
+        Journal.Open(DirectoryPath, false);
+        for (int32 FrameIndex : FrameIndexes)
+        {
+            Journal.AppendCheckpoint(MakeCheckpoint(FrameIndex));
+        }
+        Journal.Close();
+
+        TArray<uint8> JournalData;
+        FFileHelper::LoadFileToArray(JournalData, *FPaths::Combine(DirectoryPath, FNVCaptureJournal::JournalFileName));
+        return JournalData;
+    }
+
+    /// Simulate a crash in the middle of a write: only the first bytes of the journal are on the disk
+    void TruncateJournal(const FString& DirectoryPath, const TArray<uint8>& JournalData, int32 ByteSize)
+    {
+        TArray<uint8> TruncatedData(JournalData.GetData(), ByteSize);
+        FFileHelper::SaveArrayToFile(TruncatedData, *FPaths::Combine(DirectoryPath, FNVCaptureJournal::JournalFileName));
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureCheckpointJsonTest, "NVSceneCapturer.CaptureJournal.CheckpointJson", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureCheckpointJsonTest::RunTest(const FString& Parameters)
+{
+    const FNVCaptureCheckpoint Checkpoint = MakeCheckpoint(1234);
+    const FString JsonString = Checkpoint.ToJsonString();
+    TestFalse(TEXT("The checkpoint is on a single line"), JsonString.Contains(TEXT("\n")));
+
+    FNVCaptureCheckpoint ReadCheckpoint;
+    TestTrue(TEXT("The checkpoint is read back"), ReadCheckpoint.FromJsonString(JsonString));
+    TestEqual(TEXT("frame_index"), ReadCheckpoint.FrameIndex, Checkpoint.FrameIndex);
+    TestEqual(TEXT("marker_index"), ReadCheckpoint.MarkerIndex, Checkpoint.MarkerIndex);
+    TestEqual(TEXT("random_seed"), ReadCheckpoint.RandomSeed, Checkpoint.RandomSeed);
+    TestEqual(TEXT("written_files"), ReadCheckpoint.WrittenFiles, Checkpoint.WrittenFiles);
+
+    FNVCaptureCheckpoint InvalidCheckpoint;
+    TestFalse(TEXT("A checkpoint without its frame index is invalid"), InvalidCheckpoint.FromJsonString(TEXT("{\"marker_index\":0,\"random_seed\":1}")));
+    TestFalse(TEXT("An incomplete checkpoint is invalid"), InvalidCheckpoint.FromJsonString(JsonString.Left(JsonString.Len() / 2)));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureJournalTruncatedTest, "NVSceneCapturer.CaptureJournal.Truncated", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureJournalTruncatedTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("CaptureJournalTruncated"));
+    const FString& DirectoryPath = TestDirectory.DirectoryPath;
+
+    const TArray<int32> FrameIndexes = { 99, 199, 299 };
+    const TArray<uint8> JournalData = WriteJournal(DirectoryPath, FrameIndexes);
+
+    // Find where each checkpoint line end
+    TArray<int32> LineEnds;
+    for (int32 i = 0; i < JournalData.Num(); i++)
+    {
+        if (JournalData[i] == '\n')
+        {
+            LineEnds.Add(i + 1);
+        }
+    }
+    if (!TestEqual(TEXT("Each checkpoint is on its own line"), LineEnds.Num(), FrameIndexes.Num()))
+    {
+        return false;
+    }
+
+    FNVCaptureCheckpoint LastCheckpoint;
+    int64 ValidByteSize = 0;
+    TestTrue(TEXT("The complete journal is loaded"), FNVCaptureJournal::LoadLastCheckpoint(DirectoryPath, LastCheckpoint, &ValidByteSize));
+    TestEqual(TEXT("The last checkpoint is found"), LastCheckpoint.FrameIndex, FrameIndexes.Last());
+    TestEqual(TEXT("The complete journal is valid"), ValidByteSize, (int64)JournalData.Num());
+
+    // Crash at every byte of the journal: the last complete checkpoint before the crash must be found
+    int32 MismatchedCrashCount = 0;
+    for (int32 ByteSize = 0; ByteSize <= JournalData.Num(); ByteSize++)
+    {
+        TruncateJournal(DirectoryPath, JournalData, ByteSize);
+
+        int32 CompleteLineCount = 0;
+        while ((CompleteLineCount < LineEnds.Num()) && (LineEnds[CompleteLineCount] <= ByteSize))
+        {
+            CompleteLineCount++;
+        }
+
+        FNVCaptureCheckpoint TruncatedCheckpoint;
+        int64 TruncatedValidByteSize = 0;
+        const bool bFound = FNVCaptureJournal::LoadLastCheckpoint(DirectoryPath, TruncatedCheckpoint, &TruncatedValidByteSize);
+        const bool bExpectFound = (CompleteLineCount > 0);
+        const int64 ExpectedValidByteSize = bExpectFound ? LineEnds[CompleteLineCount - 1] : 0;
+        if ((bFound != bExpectFound)
+            || (TruncatedValidByteSize != ExpectedValidByteSize)
+            || (bExpectFound && (TruncatedCheckpoint.FrameIndex != FrameIndexes[CompleteLineCount - 1])))
+        {
+            AddError(FString::Printf(TEXT("Wrong checkpoint when the journal is cut at byte %d"), ByteSize));
+            MismatchedCrashCount++;
+        }
+    }
+    TestEqual(TEXT("The last complete checkpoint is found wherever the journal is cut"), MismatchedCrashCount, 0);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureJournalResumeTest, "NVSceneCapturer.CaptureJournal.Resume", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureJournalResumeTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("CaptureJournalResume"));
+    const FString& DirectoryPath = TestDirectory.DirectoryPath;
+    const FString JournalFilePath = FPaths::Combine(DirectoryPath, FNVCaptureJournal::JournalFileName);
+
+    const TArray<uint8> JournalData = WriteJournal(DirectoryPath, { 9, 19 });
+
+    // Crash in the middle of the third checkpoint
+    const FString PartialLine = MakeCheckpoint(29).ToJsonString().Left(20);
+    TArray<uint8> CrashedJournalData = JournalData;
+    CrashedJournalData.Append(reinterpret_cast<const uint8*>(TCHAR_TO_UTF8(*PartialLine)), PartialLine.Len());
+    FFileHelper::SaveArrayToFile(CrashedJournalData, *JournalFilePath);
+
+    // The resumed session cut off the partial line and append after the last complete checkpoint
+    {
+        FNVCaptureJournal Journal;
+        TestTrue(TEXT("The crashed journal is opened for appending"), Journal.Open(DirectoryPath, true));
+        TestTrue(TEXT("A checkpoint is appended"), Journal.AppendCheckpoint(MakeCheckpoint(39)));
+    }
+
+    FString JournalContent;
+    FFileHelper::LoadFileToString(JournalContent, *JournalFilePath);
+    TArray<FString> JournalLines;
+    JournalContent.ParseIntoArrayLines(JournalLines);
+    TestEqual(TEXT("The partial checkpoint is cut off"), JournalLines.Num(), 3);
+
+    FNVCaptureCheckpoint LastCheckpoint;
+    int64 ValidByteSize = 0;
+    TestTrue(TEXT("The resumed journal is loaded"), FNVCaptureJournal::LoadLastCheckpoint(DirectoryPath, LastCheckpoint, &ValidByteSize));
+    TestEqual(TEXT("The appended checkpoint is the last one"), LastCheckpoint.FrameIndex, 39);
+    TestEqual(TEXT("The whole resumed journal is valid"), ValidByteSize, (int64)IFileManager::Get().FileSize(*JournalFilePath));
+
+    // A corrupted line in the middle stop the loading at the last checkpoint before it
+    TArray<uint8> CorruptedJournalData = JournalData;
+    const char CorruptedLine[] = "{\"frame_index\":\n";
+    CorruptedJournalData.Append(reinterpret_cast<const uint8*>(CorruptedLine), sizeof(CorruptedLine) - 1);
+    CorruptedJournalData.Append(JournalData);
+    FFileHelper::SaveArrayToFile(CorruptedJournalData, *JournalFilePath);
+
+    AddExpectedError(TEXT("The capture journal is corrupted"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestTrue(TEXT("The checkpoints before the corrupted line are loaded"), FNVCaptureJournal::LoadLastCheckpoint(DirectoryPath, LastCheckpoint, &ValidByteSize));
+    TestEqual(TEXT("The checkpoint before the corrupted line is the last one"), LastCheckpoint.FrameIndex, 19);
+    TestEqual(TEXT("The journal is valid up to the corrupted line"), ValidByteSize, (int64)JournalData.Num());
+
+    // A new session start a new journal
+    {
+        FNVCaptureJournal Journal;
+        Journal.Open(DirectoryPath, false);
+    }
+    TestFalse(TEXT("A new journal has no checkpoint"), FNVCaptureJournal::LoadLastCheckpoint(DirectoryPath, LastCheckpoint));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureCheckpointSeedTest, "NVSceneCapturer.CaptureJournal.CheckpointSeed", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureCheckpointSeedTest::RunTest(const FString& Parameters)
+{
+    // The capturer re-seed its stream with each checkpoint's seed, a session resumed from the saved seed
+    // must generate the same seeds for the next checkpoints as the session which never stopped
+    auto NextCheckpointSeed = [](FRandomStream& RandomStream)
+    {
+        const int32 NewRandomSeed = RandomStream.RandHelper(MAX_int32);
+        RandomStream.Initialize(NewRandomSeed);
+        return NewRandomSeed;
+    };
+
+    FRandomStream UninterruptedStream(42);
+    TArray<int32> UninterruptedSeeds;
+    for (int32 CheckpointIndex = 0; CheckpointIndex < 8; CheckpointIndex++)
+    {
+        UninterruptedSeeds.Add(NextCheckpointSeed(UninterruptedStream));
+    }
+
+    const int32 ResumeCheckpointIndex = 3;
+    FRandomStream ResumedStream(UninterruptedSeeds[ResumeCheckpointIndex]);
+    for (int32 CheckpointIndex = ResumeCheckpointIndex + 1; CheckpointIndex < UninterruptedSeeds.Num(); CheckpointIndex++)
+    {
+        TestEqual(FString::Printf(TEXT("Seed of checkpoint %d"), CheckpointIndex), NextCheckpointSeed(ResumedStream), UninterruptedSeeds[CheckpointIndex]);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,250 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVAnnotationTestUtils.h"
+#include "NVCapturePipeline.h"
+#include "NVCaptureRegion.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+#include "Async/ParallelFor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    TArray<int32> GetFrameIndexes(const TArray<FNVCaptureFrameContextRef>& FrameContexts)
+    {
+        TArray<int32> FrameIndexes;
+        for (const FNVCaptureFrameContextRef& FrameContext : FrameContexts)
+        {
+            FrameIndexes.Add(FrameContext->FrameIndex);
+        }
+        return FrameIndexes;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCapturePipelineOutOfOrderTest, "NVSceneCapturer.CapturePipeline.OutOfOrder", NV_UNIT_TEST_FLAGS)
+bool FNVCapturePipelineOutOfOrderTest::RunTest(const FString& Parameters)
+{
+    FNVCapturePipeline CapturePipeline;
+    CapturePipeline.Reset(3);
+
+    FNVCaptureFrameContextRef Frame0 = CapturePipeline.BeginFrame(0, 2, 0.0);
+    FNVCaptureFrameContextRef Frame1 = CapturePipeline.BeginFrame(1, 1, 0.1);
+    FNVCaptureFrameContextRef Frame2 = CapturePipeline.BeginFrame(2, 3, 0.2);
+    TestFalse(TEXT("The pipeline is full"), CapturePipeline.CanBeginFrame());
+
+    // The later frames complete first: nothing can be retired while the first frame is in flight
+    Frame1->OnReadbackCompleted();
+    Frame2->OnReadbacksSkipped(1);
+    Frame2->OnReadbackCompleted();
+    Frame2->OnReadbackCompleted();
+    TestTrue(TEXT("Frame 1 is completed"), Frame1->IsCompleted());
+    TestTrue(TEXT("Frame 2 is completed with a skipped readback"), Frame2->IsCompleted());
+
+    TArray<FNVCaptureFrameContextRef> RetiredFrames;
+    TestEqual(TEXT("The completed frames wait for the first one"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 0.3), 0);
+    TestEqual(TEXT("All the frames are still in flight"), CapturePipeline.GetInFlightFrameCount(), 3);
+
+    Frame0->OnReadbackCompleted();
+    TestEqual(TEXT("A partially read back frame isn't retired"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 0.4), 0);
+
+    Frame0->OnReadbackCompleted();
+    TestEqual(TEXT("All the frames are retired once the first one complete"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 0.5), 3);
+    TestEqual(TEXT("The frames are retired in the order they're captured"), GetFrameIndexes(RetiredFrames), TArray<int32>({ 0, 1, 2 }));
+    TestEqual(TEXT("The retired frames are counted"), CapturePipeline.GetRetiredFrameCount(), 3);
+    TestEqual(TEXT("No frame is stale"), CapturePipeline.GetStaleFrameCount(), 0);
+    TestTrue(TEXT("The pipeline has room again"), CapturePipeline.CanBeginFrame());
+
+    // A frame in the middle still in flight hold back the frames after it
+    RetiredFrames.Reset();
+    FNVCaptureFrameContextRef Frame3 = CapturePipeline.BeginFrame(3, 1, 1.0);
+    FNVCaptureFrameContextRef Frame4 = CapturePipeline.BeginFrame(4, 1, 1.1);
+    FNVCaptureFrameContextRef Frame5 = CapturePipeline.BeginFrame(5, 0, 1.2);
+    Frame3->OnReadbackCompleted();
+    TestEqual(TEXT("Only the frames before the one in flight are retired"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 1.3), 1);
+    Frame4->OnReadbackCompleted();
+    TestEqual(TEXT("The rest are retired when it complete"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 1.4), 2);
+    TestEqual(TEXT("The frames are still retired in order"), GetFrameIndexes(RetiredFrames), TArray<int32>({ 3, 4, 5 }));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCapturePipelineConcurrentReadbackTest, "NVSceneCapturer.CapturePipeline.ConcurrentReadback", NV_UNIT_TEST_FLAGS)
+bool FNVCapturePipelineConcurrentReadbackTest::RunTest(const FString& Parameters)
+{
+    const int32 FrameCount = 64;
+    const int32 ReadbacksPerFrame = 24;
+    const int32 SkippedReadbacksPerFrame = 4;
+
+    FNVCapturePipeline CapturePipeline;
+    CapturePipeline.Reset(FrameCount);
+
+    TArray<FNVCaptureFrameContextRef> FrameContexts;
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+    {
+        FrameContexts.Add(CapturePipeline.BeginFrame(FrameIndex, ReadbacksPerFrame, 0.0));
+    }
+
+    // The readbacks of all the frames complete on worker threads in any order, some tiles are never captured
+    ParallelFor(FrameCount * ReadbacksPerFrame, [&FrameContexts](int32 ReadbackIndex)
+    {
+        // Interleave the frames so the later frames get their readbacks at the same time as the earlier ones
+        const int32 FrameIndex = (ReadbackIndex * 7) % FrameContexts.Num();
+        const int32 FrameReadbackIndex = ReadbackIndex / FrameContexts.Num();
+        if (FrameReadbackIndex < (ReadbacksPerFrame - SkippedReadbacksPerFrame))
+        {
+            FrameContexts[FrameIndex]->OnReadbackCompleted();
+        }
+        else if (FrameReadbackIndex == (ReadbacksPerFrame - SkippedReadbacksPerFrame))
+        {
+            FrameContexts[FrameIndex]->OnReadbacksSkipped(SkippedReadbacksPerFrame);
+        }
+    });
+
+    TArray<FNVCaptureFrameContextRef> RetiredFrames;
+    TestEqual(TEXT("All the frames are retired"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 1.0), FrameCount);
+
+    TArray<int32> ExpectedFrameIndexes;
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+    {
+        ExpectedFrameIndexes.Add(FrameIndex);
+        TestEqual(FString::Printf(TEXT("Frame %d has no readback left"), FrameIndex), FrameContexts[FrameIndex]->PendingReadbackCounter.GetValue(), 0);
+    }
+    TestEqual(TEXT("The frames are retired in the order they're captured"), GetFrameIndexes(RetiredFrames), ExpectedFrameIndexes);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCapturePipelineStaleFrameTest, "NVSceneCapturer.CapturePipeline.StaleFrame", NV_UNIT_TEST_FLAGS)
+bool FNVCapturePipelineStaleFrameTest::RunTest(const FString& Parameters)
+{
+    FNVCapturePipeline CapturePipeline;
+    CapturePipeline.Reset(2);
+
+    // A tile which is never read back nor reported as skipped make its frame stale
+    FNVCaptureFrameContextRef Frame0 = CapturePipeline.BeginFrame(0, 4, 0.0);
+    FNVCaptureFrameContextRef Frame1 = CapturePipeline.BeginFrame(1, 1, 0.5);
+    Frame0->OnReadbackCompleted();
+    Frame0->OnReadbackCompleted();
+    Frame0->OnReadbackCompleted();
+    Frame1->OnReadbackCompleted();
+
+    TArray<FNVCaptureFrameContextRef> RetiredFrames;
+    TestEqual(TEXT("The frame isn't stale before the duration"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 5.0, 10.0), 0);
+
+    AddExpectedError(TEXT("Frame 0 is retired while 1 of its pixels data are not read back"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestEqual(TEXT("The stale frame and the completed frame after it are retired"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 10.5, 10.0), 2);
+    TestEqual(TEXT("The stale frame is counted"), CapturePipeline.GetStaleFrameCount(), 1);
+
+    // Retiring all the frames count the incomplete ones as stale
+    RetiredFrames.Reset();
+    CapturePipeline.BeginFrame(2, 1, 11.0);
+    FNVCaptureFrameContextRef Frame3 = CapturePipeline.BeginFrame(3, 1, 11.0);
+    Frame3->OnReadbacksSkipped(1);
+    CapturePipeline.RetireAllFrames(RetiredFrames);
+    TestEqual(TEXT("All the frames are retired"), GetFrameIndexes(RetiredFrames), TArray<int32>({ 2, 3 }));
+    TestEqual(TEXT("Only the incomplete frame is stale"), CapturePipeline.GetStaleFrameCount(), 2);
+    TestEqual(TEXT("No frame is in flight"), CapturePipeline.GetInFlightFrameCount(), 0);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCapturePipelineAnnotationPairingTest, "NVSceneCapturer.CapturePipeline.AnnotationPairing", NV_UNIT_TEST_FLAGS)
+bool FNVCapturePipelineAnnotationPairingTest::RunTest(const FString& Parameters)
+{
+    const int32 FrameCount = 8;
+    const int32 ReadbacksPerFrame = 3;
+
+    FNVCapturePipeline CapturePipeline;
+    CapturePipeline.Reset(FrameCount);
+
+    // Each frame see a different scene, its annotation is built in the background from the snapshot taken when it's captured
+    TArray<FNVCaptureFrameContextRef> FrameContexts;
+    TArray<FString> ExpectedAnnotationJsonStrings;
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+    {
+        const int32 ActorCount = 10 + FrameIndex * 5;
+        FNVSceneAnnotationSnapshotRef Snapshot = NVSceneCapturerTest::MakeRandomSnapshot(FrameIndex, ActorCount, 100 + FrameIndex);
+        ExpectedAnnotationJsonStrings.Add(NVSceneCapturerTest::JsonObjectToString(UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot.Get())));
+
+        FNVCaptureFrameContextRef FrameContext = CapturePipeline.BeginFrame(FrameIndex, ReadbacksPerFrame, 0.0);
+        FrameContext->AddAnnotationSnapshot(Snapshot, nullptr, nullptr);
+        FrameContexts.Add(FrameContext);
+    }
+
+    // The pixels of the later frames are read back first
+    for (int32 FrameIndex = FrameCount - 1; FrameIndex >= 0; FrameIndex--)
+    {
+        for (int32 ReadbackIndex = 0; ReadbackIndex < ReadbacksPerFrame; ReadbackIndex++)
+        {
+            FrameContexts[FrameIndex]->OnReadbackCompleted();
+        }
+    }
+
+    // A frame is only completed once both its pixels and its annotation are ready
+    for (const FNVCaptureFrameContextRef& FrameContext : FrameContexts)
+    {
+        FrameContext->WaitForAnnotationData();
+        TestTrue(FString::Printf(TEXT("Frame %d is completed"), FrameContext->FrameIndex), FrameContext->IsCompleted());
+    }
+
+    TArray<FNVCaptureFrameContextRef> RetiredFrames;
+    TestEqual(TEXT("All the frames are retired"), CapturePipeline.RetireCompletedFrames(RetiredFrames, 1.0), FrameCount);
+
+    for (int32 RetiredIndex = 0; RetiredIndex < RetiredFrames.Num(); RetiredIndex++)
+    {
+        const FNVCaptureFrameContextRef& RetiredFrame = RetiredFrames[RetiredIndex];
+        TestEqual(TEXT("The frames are retired in the order they're captured"), RetiredFrame->FrameIndex, RetiredIndex);
+        if (!TestEqual(FString::Printf(TEXT("Frame %d has its annotation"), RetiredIndex), RetiredFrame->Annotations.Num(), 1))
+        {
+            continue;
+        }
+
+        const FNVCapturedAnnotationData& CapturedAnnotation = RetiredFrame->Annotations[0];
+        TestTrue(FString::Printf(TEXT("Frame %d keep the snapshot of its own frame"), RetiredIndex),
+                 CapturedAnnotation.Snapshot.IsValid() && (CapturedAnnotation.Snapshot->FrameIndex == RetiredFrame->FrameIndex));
+
+        const TSharedPtr<FJsonObject> AnnotationData = CapturedAnnotation.GetAnnotationData();
+        TestEqual(FString::Printf(TEXT("Frame %d has all the actors of its snapshot"), RetiredIndex),
+                  NVSceneCapturerTest::GetObjectJsonStrings(AnnotationData).Num(), CapturedAnnotation.Snapshot->Actors.Num());
+        TestEqual(FString::Printf(TEXT("Frame %d has the annotation of its own scene"), RetiredIndex),
+                  NVSceneCapturerTest::JsonObjectToString(AnnotationData), ExpectedAnnotationJsonStrings[RetiredIndex]);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCapturePipelineSnapshotCompletenessTest, "NVSceneCapturer.CapturePipeline.SnapshotCompleteness", NV_UNIT_TEST_FLAGS)
+bool FNVCapturePipelineSnapshotCompletenessTest::RunTest(const FString& Parameters)
+{
+    FNVSceneAnnotationSnapshotRef Snapshot = NVSceneCapturerTest::MakeRandomSnapshot(3, 20, 5);
+    Snapshot->CameraData.fov = 90.f;
+    Snapshot->CameraData.location_worldframe = FVector(1.f, 2.f, 3.f);
+    Snapshot->CaptureRegion = FIntRect(100, 50, 400, 300);
+    Snapshot->FullImageSize = FIntPoint(640, 480);
+
+    const TSharedPtr<FJsonObject> AnnotationData = UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot.Get());
+    if (!TestTrue(TEXT("The annotation is built from the snapshot"), AnnotationData.IsValid()))
+    {
+        return false;
+    }
+
+    // The snapshot alone is enough to build the whole annotation: the camera, the objects and the crop
+    const TSharedPtr<FJsonObject>* CameraJsonObject = nullptr;
+    TestTrue(TEXT("The annotation has the camera data"), AnnotationData->TryGetObjectField(TEXT("camera_data"), CameraJsonObject));
+    TestEqual(TEXT("The annotation has all the actors"), NVSceneCapturerTest::GetObjectJsonStrings(AnnotationData).Num(), Snapshot->Actors.Num());
+
+    FIntRect CropRegion;
+    FIntPoint CropImageSize;
+    TestTrue(TEXT("The annotation has the crop of the capture region"), FNVCaptureRegion::ReadCropFromAnnotationData(AnnotationData, CropRegion, CropImageSize));
+    TestEqual(TEXT("The crop is the capture region of the snapshot"), CropRegion, Snapshot->CaptureRegion);
+    TestEqual(TEXT("The crop keep the full image size of the snapshot"), CropImageSize, Snapshot->FullImageSize);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
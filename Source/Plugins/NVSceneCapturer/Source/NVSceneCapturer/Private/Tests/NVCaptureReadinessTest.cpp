@@ -0,0 +1,246 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVCaptureReadiness.h"
+#include "RenderingThread.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// A condition the test turn on and off
+    class FMockReadinessCondition : public INVCaptureReadinessCondition
+    {
+    public:
+        explicit FMockReadinessCondition(FName InConditionName)
+            : ConditionName(InConditionName)
+        {
+        }
+
+        virtual FName GetConditionName() const override
+        {
+            return ConditionName;
+        }
+
+        virtual void OnBeginWaiting(UWorld* World) override
+        {
+            BeginWaitingCount++;
+        }
+
+        virtual bool IsReady(UWorld* World) const override
+        {
+            CheckCount++;
+            return bReady;
+        }
+
+    public:
+        FName ConditionName;
+        bool bReady = false;
+        int32 BeginWaitingCount = 0;
+        mutable int32 CheckCount = 0;
+    };
+
+    /// The texture streaming condition with a streamer the test control
+    class FMockTextureStreamingCondition : public FNVCaptureReadinessCondition_TextureStreaming
+    {
+    public:
+        explicit FMockTextureStreamingCondition(int32 InMaxStalledFrameCount)
+            : FNVCaptureReadinessCondition_TextureStreaming(InMaxStalledFrameCount)
+        {
+        }
+
+    public:
+        int32 NumWantingResources = 0;
+        bool bOverBudget = false;
+
+    protected:
+        virtual int32 GetNumWantingResources() const override
+        {
+            return NumWantingResources;
+        }
+
+        virtual bool IsStreamingPoolOverBudget() const override
+        {
+            return bOverBudget;
+        }
+    };
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureReadinessGateReadyTest, "NVSceneCapturer.CaptureReadiness.Ready", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureReadinessGateReadyTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FMockReadinessCondition> AssetCondition = MakeShared<FMockReadinessCondition>(TEXT("MockAssets"));
+    TSharedRef<FMockReadinessCondition> LightCondition = MakeShared<FMockReadinessCondition>(TEXT("MockLights"));
+
+    FNVCaptureReadinessGate ReadinessGate;
+    ReadinessGate.Timeout = 0.f;
+    ReadinessGate.MinReadyFrameCount = 3;
+    ReadinessGate.AddCondition(AssetCondition);
+    ReadinessGate.AddCondition(LightCondition);
+
+    TestTrue(TEXT("A gate which isn't waiting is open"), ReadinessGate.Update(nullptr, 0.0));
+
+    ReadinessGate.BeginWaiting(nullptr, 10.0);
+    TestTrue(TEXT("The gate is waiting"), ReadinessGate.IsWaiting());
+    TestEqual(TEXT("The conditions are told the gate start waiting"), AssetCondition->BeginWaitingCount + LightCondition->BeginWaitingCount, 2);
+
+    TestFalse(TEXT("The gate wait while no condition is met"), ReadinessGate.Update(nullptr, 10.1));
+    TestEqual(TEXT("Both conditions are unmet"), ReadinessGate.GetUnmetConditionNames(), FString(TEXT("MockAssets, MockLights")));
+
+    AssetCondition->bReady = true;
+    TestFalse(TEXT("The gate wait while one condition is unmet"), ReadinessGate.Update(nullptr, 10.2));
+    TestEqual(TEXT("Only the unmet condition is reported"), ReadinessGate.GetUnmetConditionNames(), FString(TEXT("MockLights")));
+
+    // The conditions must be met for MinReadyFrameCount frames in a row
+    LightCondition->bReady = true;
+    TestFalse(TEXT("Ready for 1 frame"), ReadinessGate.Update(nullptr, 10.3));
+    TestFalse(TEXT("Ready for 2 frames"), ReadinessGate.Update(nullptr, 10.4));
+    LightCondition->bReady = false;
+    TestFalse(TEXT("A condition unmet again reset the ready frames"), ReadinessGate.Update(nullptr, 10.5));
+    LightCondition->bReady = true;
+    TestFalse(TEXT("Ready for 1 frame again"), ReadinessGate.Update(nullptr, 10.6));
+    TestFalse(TEXT("Ready for 2 frames again"), ReadinessGate.Update(nullptr, 10.7));
+    TestTrue(TEXT("Ready for 3 frames in a row"), ReadinessGate.Update(nullptr, 10.8));
+
+    TestFalse(TEXT("The gate stopped waiting"), ReadinessGate.IsWaiting());
+    TestFalse(TEXT("The gate didn't time out"), ReadinessGate.HasTimedOut());
+    TestEqual(TEXT("The wait duration is measured from BeginWaiting"), ReadinessGate.GetLastWaitDuration(), 0.8, 1.e-6);
+    TestTrue(TEXT("No condition is unmet"), ReadinessGate.GetUnmetConditionNames().IsEmpty());
+
+    // The conditions aren't checked any more once the gate is open
+    const int32 CheckCount = AssetCondition->CheckCount;
+    TestTrue(TEXT("The open gate stay open"), ReadinessGate.Update(nullptr, 11.0));
+    TestEqual(TEXT("The conditions aren't checked by an open gate"), AssetCondition->CheckCount, CheckCount);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureReadinessGateTimeoutTest, "NVSceneCapturer.CaptureReadiness.Timeout", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureReadinessGateTimeoutTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FMockReadinessCondition> NeverReadyCondition = MakeShared<FMockReadinessCondition>(TEXT("MockNeverReady"));
+
+    FNVCaptureReadinessGate ReadinessGate;
+    TestEqual(TEXT("The gate wait 1 second by default"), ReadinessGate.Timeout, 1.f);
+    ReadinessGate.Timeout = 2.f;
+    ReadinessGate.GateName = TEXT("MockCapturer");
+    ReadinessGate.AddCondition(NeverReadyCondition);
+
+    ReadinessGate.BeginWaiting(nullptr, 100.0);
+    TestFalse(TEXT("The gate wait before the timeout"), ReadinessGate.Update(nullptr, 101.0));
+    TestFalse(TEXT("The gate wait until the timeout"), ReadinessGate.Update(nullptr, 101.9));
+    // The wait ended by the timeout is reported with the conditions which were not met
+    AddExpectedError(TEXT("'MockCapturer' stopped waiting for the scene to be ready after the readiness timeout"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestTrue(TEXT("The gate open at the timeout"), ReadinessGate.Update(nullptr, 102.0));
+    TestTrue(TEXT("The gate timed out"), ReadinessGate.HasTimedOut());
+    TestEqual(TEXT("The condition which was never met is reported"), ReadinessGate.GetUnmetConditionNames(), FString(TEXT("MockNeverReady")));
+
+    // A new wait reset the timeout
+    ReadinessGate.BeginWaiting(nullptr, 200.0);
+    TestFalse(TEXT("A new wait clear the timeout"), ReadinessGate.HasTimedOut());
+    TestFalse(TEXT("A new wait has its own timeout"), ReadinessGate.Update(nullptr, 201.0));
+    NeverReadyCondition->bReady = true;
+    TestTrue(TEXT("The gate open when the condition is met"), ReadinessGate.Update(nullptr, 201.5));
+    TestFalse(TEXT("The gate didn't time out"), ReadinessGate.HasTimedOut());
+
+    // No timeout: wait as long as it takes
+    ReadinessGate.Timeout = 0.f;
+    NeverReadyCondition->bReady = false;
+    ReadinessGate.BeginWaiting(nullptr, 300.0);
+    TestFalse(TEXT("The gate without timeout keep waiting"), ReadinessGate.Update(nullptr, 100000.0));
+
+    // A gate without any condition open right away
+    ReadinessGate.RemoveAllConditions();
+    ReadinessGate.BeginWaiting(nullptr, 400.0);
+    TestTrue(TEXT("A gate without condition open at the first update"), ReadinessGate.Update(nullptr, 400.0));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureReadinessTextureStreamingTest, "NVSceneCapturer.CaptureReadiness.TextureStreaming", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureReadinessTextureStreamingTest::RunTest(const FString& Parameters)
+{
+    FMockTextureStreamingCondition StreamingCondition(3);
+    StreamingCondition.OnBeginWaiting(nullptr);
+    StreamingCondition.NumWantingResources = 10;
+    TestFalse(TEXT("The streamer want some mips"), StreamingCondition.IsReady(nullptr));
+    StreamingCondition.NumWantingResources = 8;
+    TestFalse(TEXT("The streamer make progress"), StreamingCondition.IsReady(nullptr));
+    TestFalse(TEXT("Stalled for 1 frame"), StreamingCondition.IsReady(nullptr));
+    TestFalse(TEXT("Stalled for 2 frames"), StreamingCondition.IsReady(nullptr));
+    TestTrue(TEXT("The streamer which stopped making progress is settled"), StreamingCondition.IsReady(nullptr));
+
+    StreamingCondition.OnBeginWaiting(nullptr);
+    TestFalse(TEXT("A new wait reset the stalled frames"), StreamingCondition.IsReady(nullptr));
+    StreamingCondition.bOverBudget = true;
+    TestTrue(TEXT("The streamer can't stream more mips in once its pool is over budget"), StreamingCondition.IsReady(nullptr));
+    StreamingCondition.bOverBudget = false;
+    StreamingCondition.NumWantingResources = 0;
+    TestTrue(TEXT("The streamer doesn't want any mips"), StreamingCondition.IsReady(nullptr));
+
+    FMockTextureStreamingCondition NeverStalledCondition(0);
+    NeverStalledCondition.NumWantingResources = 8;
+    NeverStalledCondition.OnBeginWaiting(nullptr);
+    bool bEverReady = false;
+    for (int32 FrameIndex = 0; FrameIndex < 100; FrameIndex++)
+    {
+        bEverReady |= NeverStalledCondition.IsReady(nullptr);
+    }
+    TestFalse(TEXT("The stalled streamer is never settled when the stall detection is off"), bEverReady);
+
+    // The stalled streamer open the gate before its timeout
+    TSharedRef<FMockTextureStreamingCondition> GateStreamingCondition = MakeShared<FMockTextureStreamingCondition>(3);
+    GateStreamingCondition->NumWantingResources = 5;
+    FNVCaptureReadinessGate ReadinessGate;
+    ReadinessGate.Timeout = 1.f;
+    ReadinessGate.AddCondition(GateStreamingCondition);
+    ReadinessGate.BeginWaiting(nullptr, 0.0);
+    int32 UpdateCount = 1;
+    while (!ReadinessGate.Update(nullptr, UpdateCount * 0.01))
+    {
+        UpdateCount++;
+    }
+    TestEqual(TEXT("The gate open once the streamer stalled for 3 frames"), UpdateCount, 4);
+    TestFalse(TEXT("The gate didn't time out"), ReadinessGate.HasTimedOut());
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureReadinessGlobalConditionTest, "NVSceneCapturer.CaptureReadiness.GlobalCondition", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureReadinessGlobalConditionTest::RunTest(const FString& Parameters)
+{
+    const FName GlobalConditionName(TEXT("MockGlobalCondition"));
+    TSharedRef<FMockReadinessCondition> FirstCondition = MakeShared<FMockReadinessCondition>(GlobalConditionName);
+    TSharedRef<FMockReadinessCondition> SecondCondition = MakeShared<FMockReadinessCondition>(GlobalConditionName);
+
+    // Registering a condition with the same name replace the previous one
+    FNVCaptureReadinessGate::RegisterGlobalCondition(FirstCondition);
+    FNVCaptureReadinessGate::RegisterGlobalCondition(SecondCondition);
+
+    FNVCaptureReadinessGate ReadinessGate;
+    ReadinessGate.AddDefaultConditions();
+    ReadinessGate.BeginWaiting(nullptr, 0.0);
+    TestEqual(TEXT("The replaced global condition isn't used"), FirstCondition->BeginWaitingCount, 0);
+    TestEqual(TEXT("The registered global condition is used"), SecondCondition->BeginWaitingCount, 1);
+
+    ReadinessGate.Update(nullptr, 0.1);
+    TestTrue(TEXT("The unmet global condition is reported"), ReadinessGate.GetUnmetConditionNames().Contains(GlobalConditionName.ToString()));
+
+    FNVCaptureReadinessGate::UnregisterGlobalCondition(GlobalConditionName);
+    FNVCaptureReadinessGate NewReadinessGate;
+    NewReadinessGate.AddDefaultConditions();
+    NewReadinessGate.BeginWaiting(nullptr, 0.0);
+    TestEqual(TEXT("The unregistered global condition isn't added to the new gates"), SecondCondition->BeginWaitingCount, 1);
+
+    // Let the render state fence of the default conditions complete before the gates are destroyed
+    FlushRenderingCommands();
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,194 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVCaptureRegion.h"
+#include "NVInstanceMaskStats.h"
+#include "NVSceneCaptureComponent2D.h"
+#include "NVSceneCapturerUtils.h"
+#include "Json.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    const FIntPoint TestImageSize(640, 480);
+
+    /// A camera at the origin looking along the X axis with a 90 degrees field of view: its focal length is 320 pixels
+    FMatrix MakeTestViewProjectionMatrix()
+    {
+        const FMatrix ProjectionMatrix = UNVSceneCaptureComponent2D::BuildProjectionMatrix(FNVImageSize(TestImageSize.X, TestImageSize.Y),
+                                                                                          ECameraProjectionMode::Perspective, 90.f, 0.f);
+        return UNVSceneCaptureComponent2D::BuildViewProjectionMatrix(FTransform::Identity, ProjectionMatrix);
+    }
+
+    FBox MakeCube(const FVector& Center, float HalfSize)
+    {
+        return FBox(Center - FVector(HalfSize), Center + FVector(HalfSize));
+    }
+
+    FString ToJsonString(const TSharedPtr<FJsonObject>& JsonObject)
+    {
+        FString JsonString;
+        TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&JsonString);
+        FJsonSerializer::Serialize(JsonObject.ToSharedRef(), JsonWriter);
+        return JsonString;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureRegionCalculateTest, "NVSceneCapturer.CaptureRegion.Calculate", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureRegionCalculateTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint ImageSize(100, 60);
+    auto CalculateRegion = [&ImageSize](const TArray<FBox2D>& ObjectBoxes, int32 Padding, int32 SnapSize)
+    {
+        return FNVCaptureRegion::CalculateRegion(ObjectBoxes, ImageSize, Padding, SnapSize);
+    };
+
+    const FBox2D FirstBox(FVector2D(20.f, 10.f), FVector2D(30.f, 20.f));
+    const FBox2D SecondBox(FVector2D(50.5f, 30.f), FVector2D(60.f, 35.5f));
+
+    TestEqual(TEXT("A single box without padding nor snapping"), CalculateRegion({ FirstBox }, 0, 1), FIntRect(20, 10, 30, 20));
+    TestEqual(TEXT("The region is the union of the boxes"), CalculateRegion({ FirstBox, SecondBox }, 0, 1), FIntRect(20, 10, 60, 36));
+    TestEqual(TEXT("The padding is added around the union"), CalculateRegion({ FirstBox, SecondBox }, 4, 1), FIntRect(16, 6, 64, 40));
+    TestEqual(TEXT("The corners are snapped outward"), CalculateRegion({ FirstBox, SecondBox }, 0, 16), FIntRect(16, 0, 64, 48));
+    TestEqual(TEXT("The padding is added before snapping"), CalculateRegion({ FirstBox }, 5, 16), FIntRect(0, 0, 48, 32));
+
+    // The region stay inside the image, its max corner isn't on the grid when the image size isn't a multiple of the snap size
+    const FBox2D BorderBox(FVector2D(-15.f, 50.f), FVector2D(10.f, 70.f));
+    TestEqual(TEXT("The region is clipped to the image"), CalculateRegion({ BorderBox }, 0, 16), FIntRect(0, 48, 16, 60));
+    TestEqual(TEXT("The padding is clipped to the image"), CalculateRegion({ FBox2D(FVector2D(1.f, 1.f), FVector2D(99.f, 59.f)) }, 16, 16), FIntRect(0, 0, 100, 60));
+
+    // The boxes outside of the image don't grow the region
+    const FBox2D OutsideBox(FVector2D(200.f, 10.f), FVector2D(220.f, 20.f));
+    TestEqual(TEXT("The boxes outside of the image are ignored"), CalculateRegion({ FirstBox, OutsideBox }, 0, 1), FIntRect(20, 10, 30, 20));
+    TestEqual(TEXT("No region when nothing is visible"), CalculateRegion({ OutsideBox }, 0, 1).Area(), 0);
+    TestEqual(TEXT("No region without box"), CalculateRegion({}, 0, 16).Area(), 0);
+    TestEqual(TEXT("The invalid boxes are ignored"), CalculateRegion({ FBox2D(EForceInit::ForceInit) }, 0, 1).Area(), 0);
+
+    // The invalid settings are clamped the same way the editor does
+    TestEqual(TEXT("A null snap size doesn't snap"), CalculateRegion({ FirstBox }, 0, 0), FIntRect(20, 10, 30, 20));
+    TestEqual(TEXT("A negative padding is ignored"), CalculateRegion({ FirstBox }, -5, 1), FIntRect(20, 10, 30, 20));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureRegionOfInterestTest, "NVSceneCapturer.CaptureRegion.RegionOfInterest", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureRegionOfInterestTest::RunTest(const FString& Parameters)
+{
+    const FMatrix ViewProjectionMatrix = MakeTestViewProjectionMatrix();
+    const FIntRect FullImageRegion(FIntPoint::ZeroValue, TestImageSize);
+
+    // The front face of the cube is 90 units away: its 10 units half size is projected to 320 * 10 / 90 = 35.56 pixels
+    const FBox CenterCube = MakeCube(FVector(100.f, 0.f, 0.f), 10.f);
+    FBox2D CenterBox;
+    if (TestTrue(TEXT("The cube in front of the camera is projected"), FNVCaptureRegion::ProjectObjectBounds(CenterCube, ViewProjectionMatrix, TestImageSize, CenterBox)))
+    {
+        TestTrue(TEXT("Projected box min"), CenterBox.Min.Equals(FVector2D(320.f - 35.556f, 240.f - 35.556f), 0.01f));
+        TestTrue(TEXT("Projected box max"), CenterBox.Max.Equals(FVector2D(320.f + 35.556f, 240.f + 35.556f), 0.01f));
+    }
+    TestEqual(TEXT("The region of the centered cube"), FNVCaptureRegion::CalculateRegionOfInterest({ CenterCube }, ViewProjectionMatrix, TestImageSize, 0, 16),
+              FIntRect(272, 192, 368, 288));
+
+    // The Y axis is the image's right and the Z axis its top
+    const FBox TopRightCube = MakeCube(FVector(100.f, 50.f, 50.f), 10.f);
+    FBox2D TopRightBox;
+    FNVCaptureRegion::ProjectObjectBounds(TopRightCube, ViewProjectionMatrix, TestImageSize, TopRightBox);
+    TestTrue(TEXT("The cube on the right is projected on the right"), TopRightBox.Min.X > 320.f);
+    TestTrue(TEXT("The cube on the top is projected on the top"), TopRightBox.Max.Y < 240.f);
+
+    const FIntRect UnionRegion = FNVCaptureRegion::CalculateRegionOfInterest({ CenterCube, TopRightCube }, ViewProjectionMatrix, TestImageSize, 8, 16);
+    TestTrue(TEXT("The region contains both cubes"), UnionRegion.Contains(FIntPoint(272, 287)) && UnionRegion.Contains(FIntPoint(FMath::CeilToInt(TopRightBox.Max.X) - 1, FMath::FloorToInt(TopRightBox.Min.Y))));
+    TestTrue(TEXT("The region is smaller than the image"), UnionRegion.Area() < FullImageRegion.Area());
+    TestTrue(TEXT("The region is snapped"), (UnionRegion.Min.X % 16 == 0) && (UnionRegion.Min.Y % 16 == 0) && (UnionRegion.Max.X % 16 == 0) && (UnionRegion.Max.Y % 16 == 0));
+
+    // The whole image is captured when the region can't be trusted or is empty
+    FBox2D BehindBox;
+    TestFalse(TEXT("The cube behind the camera isn't projected"), FNVCaptureRegion::ProjectObjectBounds(MakeCube(FVector(-100.f, 0.f, 0.f), 10.f), ViewProjectionMatrix, TestImageSize, BehindBox));
+    TestEqual(TEXT("A cube around the camera capture the whole image"),
+              FNVCaptureRegion::CalculateRegionOfInterest({ CenterCube, MakeCube(FVector::ZeroVector, 10.f) }, ViewProjectionMatrix, TestImageSize, 0, 16), FullImageRegion);
+    TestEqual(TEXT("A cube outside of the view capture the whole image"),
+              FNVCaptureRegion::CalculateRegionOfInterest({ MakeCube(FVector(100.f, 1000.f, 0.f), 10.f) }, ViewProjectionMatrix, TestImageSize, 0, 16), FullImageRegion);
+    TestEqual(TEXT("No training object capture the whole image"),
+              FNVCaptureRegion::CalculateRegionOfInterest({}, ViewProjectionMatrix, TestImageSize, 0, 16), FullImageRegion);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVCaptureRegionRemapTest, "NVSceneCapturer.CaptureRegion.Remap", NV_UNIT_TEST_FLAGS)
+bool FNVCaptureRegionRemapTest::RunTest(const FString& Parameters)
+{
+    const FIntRect Region(64, 32, 96, 48);
+    const FIntPoint FullImageSize(256, 128);
+
+    // The positions round trip between the full image and the crop
+    const FVector2D ImagePosition(70.5f, 40.25f);
+    const FVector2D RegionPosition = FNVCaptureRegion::ImageToRegionPosition(ImagePosition, Region);
+    TestEqual(TEXT("The position in the crop"), RegionPosition, FVector2D(6.5f, 8.25f));
+    TestEqual(TEXT("The position back in the full image"), FNVCaptureRegion::RegionToImagePosition(RegionPosition, Region), ImagePosition);
+    TestEqual(TEXT("The crop origin"), FNVCaptureRegion::RegionToImagePosition(FVector2D::ZeroVector, Region), FVector2D(64.f, 32.f));
+
+    // The crop written in the annotation is read back
+    TSharedPtr<FJsonObject> AnnotationData = MakeShared<FJsonObject>();
+    FNVCaptureRegion::WriteCropToAnnotationData(AnnotationData, Region, FullImageSize);
+    FIntRect ReadRegion;
+    FIntPoint ReadImageSize;
+    TestTrue(TEXT("The crop is read back"), FNVCaptureRegion::ReadCropFromAnnotationData(AnnotationData, ReadRegion, ReadImageSize));
+    TestEqual(TEXT("The crop region"), ReadRegion, Region);
+    TestEqual(TEXT("The full image size"), ReadImageSize, FullImageSize);
+
+    TestFalse(TEXT("No crop in the annotation"), FNVCaptureRegion::ReadCropFromAnnotationData(MakeShared<FJsonObject>(), ReadRegion, ReadImageSize));
+    TestFalse(TEXT("No annotation"), FNVCaptureRegion::ReadCropFromAnnotationData(nullptr, ReadRegion, ReadImageSize));
+    TSharedPtr<FJsonObject> EmptyCropData = MakeShared<FJsonObject>();
+    FNVCaptureRegion::WriteCropToAnnotationData(EmptyCropData, FIntRect(10, 10, 10, 20), FullImageSize);
+    TestFalse(TEXT("An empty crop is invalid"), FNVCaptureRegion::ReadCropFromAnnotationData(EmptyCropData, ReadRegion, ReadImageSize));
+
+    // The visible box of the cropped instance mask is moved back to the full image's coordinates
+    FNVTexturePixelData MaskPixelData;
+    MaskPixelData.PixelFormat = PF_B8G8R8A8;
+    MaskPixelData.PixelSize = Region.Size();
+    MaskPixelData.RowStride = Region.Width() * 4;
+    MaskPixelData.PixelData.SetNumZeroed(MaskPixelData.RowStride * Region.Height());
+    for (int32 Y = 2; Y < 6; Y++)
+    {
+        for (int32 X = 4; X < 8; X++)
+        {
+            // Instance 5 in the blue channel
+            MaskPixelData.PixelData[Y * MaskPixelData.RowStride + X * 4] = 5;
+        }
+    }
+    FNVInstanceMaskStats MaskStats;
+    TestTrue(TEXT("The cropped mask is scanned"), MaskStats.Scan(MaskPixelData));
+
+    for (bool bExportImageCoordinateInPixel : { true, false })
+    {
+        TSharedPtr<FJsonObject> ObjectJsonObj = MakeShared<FJsonObject>();
+        ObjectJsonObj->SetNumberField(TEXT("instance_id"), 5);
+        TSharedPtr<FJsonObject> CroppedAnnotationData = MakeShared<FJsonObject>();
+        TArray<TSharedPtr<FJsonValue>> ObjectValues;
+        ObjectValues.Add(MakeShared<FJsonValueObject>(ObjectJsonObj));
+        CroppedAnnotationData->SetArrayField(TEXT("objects"), ObjectValues);
+        FNVCaptureRegion::WriteCropToAnnotationData(CroppedAnnotationData, Region, FullImageSize);
+
+        MaskStats.ApplyToAnnotationData(CroppedAnnotationData, bExportImageCoordinateInPixel, false);
+
+        FBox2D ExpectedBox(FVector2D(68.f, 34.f), FVector2D(72.f, 38.f));
+        if (!bExportImageCoordinateInPixel)
+        {
+            // The normalized coordinates are relative to the full image, not the crop
+            const FVector2D ImageScale(1.f / FullImageSize.X, 1.f / FullImageSize.Y);
+            ExpectedBox = FBox2D(ExpectedBox.Min * ImageScale, ExpectedBox.Max * ImageScale);
+        }
+        TestEqual(bExportImageCoordinateInPixel ? TEXT("The visible box in pixels") : TEXT("The normalized visible box"),
+                  ToJsonString(ObjectJsonObj->GetObjectField(TEXT("visible_bbox"))),
+                  ToJsonString(NVSceneCapturerUtils::UStructToJsonObject(FNVBox2D(ExpectedBox))));
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,270 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVDuplicateFrameFilter.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// A synthetic color image: each cell of the 9x8 hash grid is filled with a random gray level
+    struct FSyntheticImage
+    {
+        FNVTexturePixelData PixelData;
+
+        FSyntheticImage(int32 Seed, int32 NoiseAmplitude = 0, EPixelFormat PixelFormat = PF_B8G8R8A8, int32 Width = 90, int32 Height = 80, int32 RowPadding = 0)
+        {
+            FRandomStream CellRandom(Seed);
+            uint8 CellLuminances[8][9];
+            for (int32 CellY = 0; CellY < 8; CellY++)
+            {
+                for (int32 CellX = 0; CellX < 9; CellX++)
+                {
+                    CellLuminances[CellY][CellX] = (uint8)CellRandom.RandRange(16, 239);
+                }
+            }
+
+            FRandomStream NoiseRandom(Seed * 31 + 7);
+            Fill(PixelFormat, Width, Height, RowPadding, [&](int32 X, int32 Y)
+            {
+                const int32 Luminance = CellLuminances[(Y * 8) / Height][(X * 9) / Width] + NoiseRandom.RandRange(-NoiseAmplitude, NoiseAmplitude);
+                return (uint8)FMath::Clamp(Luminance, 0, 255);
+            });
+        }
+
+        template <typename GetLuminanceFunction>
+        FSyntheticImage(EPixelFormat PixelFormat, int32 Width, int32 Height, GetLuminanceFunction GetLuminance)
+        {
+            Fill(PixelFormat, Width, Height, 0, GetLuminance);
+        }
+
+        template <typename GetLuminanceFunction>
+        void Fill(EPixelFormat PixelFormat, int32 Width, int32 Height, int32 RowPadding, GetLuminanceFunction GetLuminance)
+        {
+            const int32 PixelByteSize = ((PixelFormat == PF_G8) || (PixelFormat == PF_R8)) ? 1 : 4;
+            PixelData.PixelFormat = PixelFormat;
+            PixelData.PixelSize = FIntPoint(Width, Height);
+            PixelData.RowStride = Width * PixelByteSize + RowPadding;
+            // The padding at the end of the rows must never be read
+            PixelData.PixelData.Init(0xFF, PixelData.RowStride * Height);
+            for (int32 Y = 0; Y < Height; Y++)
+            {
+                for (int32 X = 0; X < Width; X++)
+                {
+                    const uint8 Luminance = GetLuminance(X, Y);
+                    uint8* Pixel = PixelData.PixelData.GetData() + Y * PixelData.RowStride + X * PixelByteSize;
+                    for (int32 ChannelIndex = 0; ChannelIndex < PixelByteSize; ChannelIndex++)
+                    {
+                        Pixel[ChannelIndex] = Luminance;
+                    }
+                }
+            }
+        }
+    };
+
+    uint64 GetHash(const FSyntheticImage& Image)
+    {
+        uint64 Hash = 0;
+        FNVDuplicateFrameFilter::CalculateDifferenceHash(Image.PixelData, Hash);
+        return Hash;
+    }
+
+    int32 GetHashDistance(const FSyntheticImage& ImageA, const FSyntheticImage& ImageB)
+    {
+        return FMath::CountBits(GetHash(ImageA) ^ GetHash(ImageB));
+    }
+
+    void TestDecision(FAutomationTestBase& Test, const TCHAR* What, ENVDuplicateFrameDecision Decision, ENVDuplicateFrameDecision ExpectedDecision)
+    {
+        Test.TestEqual(What, (int32)Decision, (int32)ExpectedDecision);
+    }
+
+    FString JoinIndexes(const TArray<int32>& Indexes)
+    {
+        TArray<FString> IndexStrings;
+        for (int32 Index : Indexes)
+        {
+            IndexStrings.Add(FString::FromInt(Index));
+        }
+        return FString::Join(IndexStrings, TEXT(","));
+    }
+
+    const TCHAR* TestViewpointName = TEXT("TestViewpoint");
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVDuplicateFrameHashTest, "NVSceneCapturer.DuplicateFrameFilter.DifferenceHash", NV_UNIT_TEST_FLAGS)
+bool FNVDuplicateFrameHashTest::RunTest(const FString& Parameters)
+{
+    // Each bit tell whether a cell is brighter than its right neighbor
+    const FSyntheticImage DarkerToTheRight(PF_B8G8R8A8, 90, 80, [](int32 X, int32 Y) { return (uint8)(255 - X * 2); });
+    const FSyntheticImage BrighterToTheRight(PF_B8G8R8A8, 90, 80, [](int32 X, int32 Y) { return (uint8)(X * 2); });
+    const FSyntheticImage Uniform(PF_B8G8R8A8, 90, 80, [](int32 X, int32 Y) { return (uint8)128; });
+    TestTrue(TEXT("All the cells are brighter than their right neighbor"), GetHash(DarkerToTheRight) == ~uint64(0));
+    TestTrue(TEXT("No cell is brighter than its right neighbor"), GetHash(BrighterToTheRight) == 0);
+    TestTrue(TEXT("Uniform image"), GetHash(Uniform) == 0);
+
+    const FSyntheticImage Image(1);
+    TestEqual(TEXT("The hash doesn't depend on the channel order"), GetHashDistance(FSyntheticImage(1, 0, PF_R8G8B8A8), Image), 0);
+    TestEqual(TEXT("The hash of a grayscale image"), GetHashDistance(FSyntheticImage(1, 0, PF_G8), Image), 0);
+    TestEqual(TEXT("The row padding is skipped"), GetHashDistance(FSyntheticImage(1, 0, PF_B8G8R8A8, 90, 80, 12), Image), 0);
+    TestEqual(TEXT("The hash doesn't depend much on the image size"), GetHashDistance(FSyntheticImage(1, 0, PF_B8G8R8A8, 1920, 1080), Image), 0);
+
+    TestTrue(TEXT("A noisy copy of the image is nearly identical"), GetHashDistance(FSyntheticImage(1, 2), Image) <= 4);
+    int32 MinDifferentImageDistance = 64;
+    for (int32 Seed = 2; Seed < 20; Seed++)
+    {
+        MinDifferentImageDistance = FMath::Min(MinDifferentImageDistance, GetHashDistance(FSyntheticImage(Seed), Image));
+    }
+    TestTrue(TEXT("Different images are far apart"), MinDifferentImageDistance > 8);
+
+    uint64 Hash = 0;
+    TestFalse(TEXT("The image is too small to be hashed"), FNVDuplicateFrameFilter::CalculateDifferenceHash(FSyntheticImage(1, 0, PF_B8G8R8A8, 8, 8).PixelData, Hash));
+    FSyntheticImage TruncatedImage(1);
+    TruncatedImage.PixelData.PixelData.SetNum(TruncatedImage.PixelData.PixelData.Num() / 2);
+    TestFalse(TEXT("The pixel buffer is too small for the image"), FNVDuplicateFrameFilter::CalculateDifferenceHash(TruncatedImage.PixelData, Hash));
+    FSyntheticImage FloatImage(1);
+    FloatImage.PixelData.PixelFormat = PF_FloatRGBA;
+    TestFalse(TEXT("The pixel format is not supported"), FNVDuplicateFrameFilter::CalculateDifferenceHash(FloatImage.PixelData, Hash));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVDuplicateFrameDecisionTest, "NVSceneCapturer.DuplicateFrameFilter.Decision", NV_UNIT_TEST_FLAGS)
+bool FNVDuplicateFrameDecisionTest::RunTest(const FString& Parameters)
+{
+    FNVDuplicateFrameFilter Filter(2, 4);
+    const FObjectKey ViewpointA;
+    const FObjectKey ViewpointB(GetTransientPackage());
+    typedef FNVDuplicateFrameFilter::FFrameKey FFrameKey;
+
+    TestDecision(*this, TEXT("First frame"), Filter.CheckFrame(FFrameKey(ViewpointA, 0), FSyntheticImage(1).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Accepted);
+    TestDecision(*this, TEXT("Noisy copy of the first frame"), Filter.CheckFrame(FFrameKey(ViewpointA, 1), FSyntheticImage(1, 2).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Dropped);
+    TestDecision(*this, TEXT("A frame captured again keep its decision"), Filter.CheckFrame(FFrameKey(ViewpointA, 0), FSyntheticImage(1).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Accepted);
+    TestDecision(*this, TEXT("Other viewpoint"), Filter.CheckFrame(FFrameKey(ViewpointB, 1), FSyntheticImage(1).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Accepted);
+    TestDecision(*this, TEXT("Different image"), Filter.CheckFrame(FFrameKey(ViewpointA, 2), FSyntheticImage(2).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Accepted);
+    TestDecision(*this, TEXT("Duplicate of the second to last accepted frame"), Filter.CheckFrame(FFrameKey(ViewpointA, 3), FSyntheticImage(1).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Dropped);
+    TestDecision(*this, TEXT("Different image"), Filter.CheckFrame(FFrameKey(ViewpointA, 4), FSyntheticImage(3).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Accepted);
+    TestDecision(*this, TEXT("The first frame is out of the history"), Filter.CheckFrame(FFrameKey(ViewpointA, 5), FSyntheticImage(1).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Accepted);
+
+    // The frame is kept when its image can't be hashed
+    FSyntheticImage FloatImage(1);
+    FloatImage.PixelData.PixelFormat = PF_FloatRGBA;
+    AddExpectedError(TEXT("is not supported"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestDecision(*this, TEXT("Unsupported pixel format"), Filter.CheckFrame(FFrameKey(ViewpointA, 6), FloatImage.PixelData, TestViewpointName), ENVDuplicateFrameDecision::Accepted);
+
+    TestEqual(TEXT("Checked frames, the frame captured again is only checked once"), Filter.GetCheckedFrameCount(), 8);
+    TestEqual(TEXT("Dropped frames"), Filter.GetDroppedFrameCount(), 2);
+    TestDecision(*this, TEXT("Decision of a frame"), Filter.GetDecision(FFrameKey(ViewpointA, 1)), ENVDuplicateFrameDecision::Dropped);
+    TestDecision(*this, TEXT("Decision of a frame not checked yet"), Filter.GetDecision(FFrameKey(ViewpointA, 7)), ENVDuplicateFrameDecision::Pending);
+
+    Filter.Reset();
+    TestEqual(TEXT("The counters are reset"), Filter.GetCheckedFrameCount(), 0);
+    TestDecision(*this, TEXT("The history is reset"), Filter.CheckFrame(FFrameKey(ViewpointA, 0), FSyntheticImage(1, 2).PixelData, TestViewpointName), ENVDuplicateFrameDecision::Accepted);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVDuplicateFrameHeldBackDataTest, "NVSceneCapturer.DuplicateFrameFilter.HeldBackData", NV_UNIT_TEST_FLAGS)
+bool FNVDuplicateFrameHeldBackDataTest::RunTest(const FString& Parameters)
+{
+    FNVDuplicateFrameFilter Filter(4, 4);
+    const FObjectKey Viewpoint;
+    typedef FNVDuplicateFrameFilter::FFrameKey FFrameKey;
+
+    TArray<int32> HandledFrameIndexes;
+    auto DeferData = [&](int32 FrameIndex)
+    {
+        return Filter.DeferUntilChecked(FFrameKey(Viewpoint, FrameIndex), [&HandledFrameIndexes, FrameIndex]() { HandledFrameIndexes.Add(FrameIndex); });
+    };
+
+    // The data come before the color image
+    TestDecision(*this, TEXT("The data wait for the check"), DeferData(0), ENVDuplicateFrameDecision::Pending);
+    TestDecision(*this, TEXT("The data wait for the check"), DeferData(1), ENVDuplicateFrameDecision::Pending);
+    TestEqual(TEXT("No data is handled before the check"), HandledFrameIndexes.Num(), 0);
+    Filter.CheckFrame(FFrameKey(Viewpoint, 0), FSyntheticImage(1).PixelData, TestViewpointName);
+    Filter.CheckFrame(FFrameKey(Viewpoint, 1), FSyntheticImage(1).PixelData, TestViewpointName);
+    TestEqual(TEXT("Only the data of the accepted frame are handled"), JoinIndexes(HandledFrameIndexes), FString(TEXT("0")));
+
+    // The data come after the color image
+    TestDecision(*this, TEXT("The data of an accepted frame are handled right away"), DeferData(0), ENVDuplicateFrameDecision::Accepted);
+    TestDecision(*this, TEXT("The data of a dropped frame are discarded"), DeferData(1), ENVDuplicateFrameDecision::Dropped);
+    TestEqual(TEXT("Handled data"), JoinIndexes(HandledFrameIndexes), FString(TEXT("0,0")));
+
+    // The color image of the frame is not captured
+    DeferData(2);
+    Filter.AcceptFrameUnchecked(FFrameKey(Viewpoint, 2));
+    TestEqual(TEXT("The data of an unchecked frame are handled"), JoinIndexes(HandledFrameIndexes), FString(TEXT("0,0,2")));
+    TestDecision(*this, TEXT("The frame is accepted"), Filter.GetDecision(FFrameKey(Viewpoint, 2)), ENVDuplicateFrameDecision::Accepted);
+
+    // The color image never come
+    DeferData(3);
+    DeferData(3);
+    AddExpectedError(TEXT("2 captured data are discarded"), EAutomationExpectedErrorFlags::Contains, 1);
+    Filter.Reset();
+    TestEqual(TEXT("The data held back are discarded"), HandledFrameIndexes.Num(), 3);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVDuplicateFrameLateDataTest, "NVSceneCapturer.DuplicateFrameFilter.LateData", NV_UNIT_TEST_FLAGS)
+bool FNVDuplicateFrameLateDataTest::RunTest(const FString& Parameters)
+{
+    FNVDuplicateFrameFilter Filter(4, 4);
+    const FObjectKey Viewpoint;
+    typedef FNVDuplicateFrameFilter::FFrameKey FFrameKey;
+
+    int32 HandledDataCount = 0;
+    auto DeferData = [&](int32 FrameIndex)
+    {
+        return Filter.DeferUntilChecked(FFrameKey(Viewpoint, FrameIndex), [&HandledDataCount]() { HandledDataCount++; });
+    };
+    auto CaptureFrames = [&](int32 FirstFrameIndex, int32 LastFrameIndex)
+    {
+        for (int32 FrameIndex = FirstFrameIndex; FrameIndex <= LastFrameIndex; FrameIndex++)
+        {
+            Filter.ExpectFrameData(FFrameKey(Viewpoint, FrameIndex), 0);
+            Filter.CheckFrame(FFrameKey(Viewpoint, FrameIndex), FSyntheticImage(FrameIndex + 100).PixelData, TestViewpointName);
+        }
+    };
+
+    // Frame 0 expect 2 data, frame 1 one, frame 2 none
+    Filter.ExpectFrameData(FFrameKey(Viewpoint, 0), 2);
+    Filter.ExpectFrameData(FFrameKey(Viewpoint, 1), 1);
+    Filter.CheckFrame(FFrameKey(Viewpoint, 0), FSyntheticImage(1).PixelData, TestViewpointName);
+    Filter.CheckFrame(FFrameKey(Viewpoint, 1), FSyntheticImage(1).PixelData, TestViewpointName);
+    Filter.CheckFrame(FFrameKey(Viewpoint, 2), FSyntheticImage(2).PixelData, TestViewpointName);
+
+    // The data come much later than the color images: the decisions are kept until the expected data are reported
+    CaptureFrames(3, 100);
+    TestDecision(*this, TEXT("Late data of an accepted frame"), Filter.ConsumeDecision(FFrameKey(Viewpoint, 0)), ENVDuplicateFrameDecision::Accepted);
+    TestDecision(*this, TEXT("Late data of an accepted frame"), DeferData(0), ENVDuplicateFrameDecision::Accepted);
+    TestDecision(*this, TEXT("Late data of a dropped frame"), DeferData(1), ENVDuplicateFrameDecision::Dropped);
+    TestEqual(TEXT("The late data of the accepted frame are handled"), HandledDataCount, 1);
+
+    // Once its data are all reported the frame is forgotten, an unexpected data of the frame is discarded
+    // instead of waiting for a check which never come
+    CaptureFrames(101, 120);
+    AddExpectedError(TEXT("came after the duplicate check of the frame was forgotten"), EAutomationExpectedErrorFlags::Contains, 3);
+    TestDecision(*this, TEXT("Unexpected data of a forgotten frame"), DeferData(0), ENVDuplicateFrameDecision::Dropped);
+    TestDecision(*this, TEXT("Unexpected data of a forgotten frame"), DeferData(2), ENVDuplicateFrameDecision::Dropped);
+    TestEqual(TEXT("The unexpected data are not handled"), HandledDataCount, 1);
+
+    // The decision of a frame whose data never come is only kept for a while
+    Filter.ExpectFrameData(FFrameKey(Viewpoint, 121), 1);
+    CaptureFrames(121, 121 + 1100);
+    TestDecision(*this, TEXT("The data which never came don't hold the decision forever"), DeferData(121), ENVDuplicateFrameDecision::Dropped);
+
+    // Nothing is left waiting for a check
+    Filter.Reset();
+    TestEqual(TEXT("No data is handled after the reset"), HandledDataCount, 1);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,218 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVFileSink.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    FString GetTestFilePath(const FString& DirectoryPath, int32 FileIndex)
+    {
+        // Spread the files in a few sub-directories so the sink has to create them concurrently
+        return FPaths::Combine(DirectoryPath, FString::Printf(TEXT("%02d"), FileIndex % 16), FString::Printf(TEXT("%06d.txt"), FileIndex));
+    }
+
+    FString GetTestFileContent(int32 FileIndex)
+    {
+        return FString::Printf(TEXT("{\"file_index\":%d,\"padding\":\"%s\"}"), FileIndex, *FString::ChrN(FileIndex % 97, TEXT('x')));
+    }
+
+    typedef TFunction<TSharedPtr<INVFileSink, ESPMode::ThreadSafe>(int32 MaxInFlightCount)> FCreateFileSinkFunction;
+
+    TSharedPtr<INVFileSink, ESPMode::ThreadSafe> CreateThreadPoolFileSink(int32 MaxInFlightCount)
+    {
+        return MakeShareable(new FNVFileSink_ThreadPool(MaxInFlightCount, 4));
+    }
+
+#if PLATFORM_LINUX
+    TSharedPtr<INVFileSink, ESPMode::ThreadSafe> CreateIoUringFileSink(int32 MaxInFlightCount)
+    {
+        return FNVFileSink_IoUring::Create(MaxInFlightCount);
+    }
+
+    /// The io_uring backend need a recent kernel, it may also be blocked in some containers
+    bool CanTestIoUringFileSink(FAutomationTestBase& Test)
+    {
+        if (!FNVFileSink_IoUring::Create(1).IsValid())
+        {
+            Test.AddWarning(TEXT("io_uring isn't available on this system, the io_uring file sink isn't tested."));
+            return false;
+        }
+        return true;
+    }
+#endif // PLATFORM_LINUX
+
+    /// Write thousands of small files from several threads and check their content
+    void TestWriteFiles(FAutomationTestBase& Test, const FString& DirectoryPath, const FCreateFileSinkFunction& CreateFileSink)
+    {
+        const int32 FileCount = 4000;
+        const int32 SubmitterCount = 8;
+        const int32 MaxInFlightCount = 16;
+
+        TSharedPtr<INVFileSink, ESPMode::ThreadSafe> FileSink = CreateFileSink(MaxInFlightCount);
+        if (!Test.TestTrue(TEXT("The file sink is created"), FileSink.IsValid()))
+        {
+            return;
+        }
+        FileSink->SetTrackWrittenFiles(true);
+
+        // Several threads submit at the same time so they race for the last free slots
+        FThreadSafeCounter MaxObservedInFlightCount;
+        FThreadSafeCounter FailedSubmitCount;
+        ParallelFor(SubmitterCount, [&](int32 SubmitterIndex)
+        {
+            for (int32 FileIndex = SubmitterIndex; FileIndex < FileCount; FileIndex += SubmitterCount)
+            {
+                if (!FileSink->WriteFile(GetTestFilePath(DirectoryPath, FileIndex), GetTestFileContent(FileIndex)))
+                {
+                    FailedSubmitCount.Increment();
+                }
+
+                const int32 InFlightCount = FileSink->GetInFlightCount();
+                int32 ObservedCount = MaxObservedInFlightCount.GetValue();
+                while ((InFlightCount > ObservedCount) && (MaxObservedInFlightCount.CompareExchange(ObservedCount, InFlightCount) != ObservedCount))
+                {
+                    ObservedCount = MaxObservedInFlightCount.GetValue();
+                }
+            }
+        });
+        FileSink->Flush();
+
+        Test.TestEqual(TEXT("All the writes are queued"), FailedSubmitCount.GetValue(), 0);
+        Test.TestTrue(TEXT("The number of files in flight never exceed the bound"), MaxObservedInFlightCount.GetValue() <= MaxInFlightCount);
+        Test.TestEqual(TEXT("No file is in flight after the flush"), FileSink->GetInFlightCount(), 0);
+
+        const FNVFileSinkStats Stats = FileSink->GetStats();
+        Test.AddInfo(Stats.ToString());
+        Test.TestEqual(TEXT("All the files are written"), Stats.WrittenFileCount, (int64)FileCount);
+        Test.TestEqual(TEXT("No write failed"), Stats.FailedFileCount, (int64)0);
+        Test.TestEqual(TEXT("No operation is in flight after the flush"), Stats.InFlightOpCount, 0);
+        Test.TestTrue(TEXT("The throughput is reported"), Stats.BytesPerSecond > 0.0);
+        Test.TestTrue(TEXT("The operations per submission are reported"), Stats.AverageBatchSize >= 1.0);
+
+        TArray<FString> WrittenFilePaths;
+        FileSink->ConsumeWrittenFilePaths(WrittenFilePaths);
+        Test.TestEqual(TEXT("All the written files are tracked"), WrittenFilePaths.Num(), FileCount);
+
+        int32 MismatchedFileCount = 0;
+        for (int32 FileIndex = 0; FileIndex < FileCount; FileIndex++)
+        {
+            FString FileContent;
+            if (!FFileHelper::LoadFileToString(FileContent, *GetTestFilePath(DirectoryPath, FileIndex))
+                || (FileContent != GetTestFileContent(FileIndex)))
+            {
+                MismatchedFileCount++;
+            }
+        }
+        Test.TestEqual(TEXT("All the files have their content"), MismatchedFileCount, 0);
+
+        // An existing file is overwritten, an empty file is still created
+        FileSink->WriteFile(GetTestFilePath(DirectoryPath, 0), FString(TEXT("overwritten")));
+        FileSink->WriteFile(FPaths::Combine(DirectoryPath, TEXT("Empty"), TEXT("empty.txt")), TArray<uint8>());
+        FileSink->Flush();
+        FString OverwrittenContent;
+        FFileHelper::LoadFileToString(OverwrittenContent, *GetTestFilePath(DirectoryPath, 0));
+        Test.TestEqual(TEXT("The existing file is overwritten"), OverwrittenContent, FString(TEXT("overwritten")));
+        Test.TestEqual(TEXT("The empty file is created"), IFileManager::Get().FileSize(*FPaths::Combine(DirectoryPath, TEXT("Empty"), TEXT("empty.txt"))), (int64)0);
+    }
+
+    /// Flushing an idle sink return right away, a sink can be destroyed right after a flush
+    void TestFlush(FAutomationTestBase& Test, const FString& DirectoryPath, const FCreateFileSinkFunction& CreateFileSink)
+    {
+        TSharedPtr<INVFileSink, ESPMode::ThreadSafe> FileSink = CreateFileSink(4);
+        const double IdleFlushDuration = NVSceneCapturerTest::MeasureSeconds([&FileSink]() { FileSink->Flush(); });
+        Test.TestTrue(TEXT("Flushing an idle sink doesn't wait"), IdleFlushDuration < 0.5);
+
+        // The sink can be destroyed right after a flush while its writes are still signalling
+        const int32 RoundCount = 50;
+        const int32 FilePerRound = 20;
+        int32 WrittenFileCount = 0;
+        for (int32 RoundIndex = 0; RoundIndex < RoundCount; RoundIndex++)
+        {
+            TSharedPtr<INVFileSink, ESPMode::ThreadSafe> RoundFileSink = CreateFileSink(2);
+            for (int32 FileIndex = 0; FileIndex < FilePerRound; FileIndex++)
+            {
+                const int32 TestFileIndex = RoundIndex * FilePerRound + FileIndex;
+                RoundFileSink->WriteFile(GetTestFilePath(DirectoryPath, TestFileIndex), GetTestFileContent(TestFileIndex));
+            }
+            RoundFileSink->Flush();
+            WrittenFileCount += RoundFileSink->GetStats().WrittenFileCount;
+            RoundFileSink.Reset();
+        }
+        Test.TestEqual(TEXT("All the files are written before the sinks are destroyed"), WrittenFileCount, RoundCount * FilePerRound);
+
+        // A file which can't be created is reported as failed, the sink doesn't wait for it
+        TSharedPtr<INVFileSink, ESPMode::ThreadSafe> FailingFileSink = CreateFileSink(2);
+        const FString BlockingFilePath = FPaths::Combine(DirectoryPath, TEXT("NotADirectory"));
+        FFileHelper::SaveStringToFile(TEXT("file"), *BlockingFilePath);
+        Test.AddExpectedError(TEXT("Unable to open file for writing"), EAutomationExpectedErrorFlags::Contains, 1);
+        FailingFileSink->WriteFile(FPaths::Combine(BlockingFilePath, TEXT("file.txt")), FString(TEXT("content")));
+        FailingFileSink->Flush();
+        Test.TestEqual(TEXT("The failed write is reported"), FailingFileSink->GetStats().FailedFileCount, (int64)1);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFileSinkThreadPoolWriteFilesTest, "NVSceneCapturer.FileSink.ThreadPool.WriteFiles", NV_UNIT_TEST_FLAGS)
+bool FNVFileSinkThreadPoolWriteFilesTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("FileSinkThreadPoolWriteFiles"));
+    TestWriteFiles(*this, TestDirectory.DirectoryPath, &CreateThreadPoolFileSink);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFileSinkThreadPoolFlushTest, "NVSceneCapturer.FileSink.ThreadPool.Flush", NV_UNIT_TEST_FLAGS)
+bool FNVFileSinkThreadPoolFlushTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("FileSinkThreadPoolFlush"));
+    TestFlush(*this, TestDirectory.DirectoryPath, &CreateThreadPoolFileSink);
+    return true;
+}
+
+#if PLATFORM_LINUX
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFileSinkIoUringWriteFilesTest, "NVSceneCapturer.FileSink.IoUring.WriteFiles", NV_UNIT_TEST_FLAGS)
+bool FNVFileSinkIoUringWriteFilesTest::RunTest(const FString& Parameters)
+{
+    if (!CanTestIoUringFileSink(*this))
+    {
+        return true;
+    }
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("FileSinkIoUringWriteFiles"));
+    TestWriteFiles(*this, TestDirectory.DirectoryPath, &CreateIoUringFileSink);
+
+    // The operations of the files in the ring are submitted together
+    NVSceneCapturerTest::FScopedTestDirectory BatchTestDirectory(TEXT("FileSinkIoUringBatch"));
+    TSharedPtr<INVFileSink, ESPMode::ThreadSafe> FileSink = CreateIoUringFileSink(0);
+    for (int32 FileIndex = 0; FileIndex < 1000; FileIndex++)
+    {
+        FileSink->WriteFile(GetTestFilePath(BatchTestDirectory.DirectoryPath, FileIndex), GetTestFileContent(FileIndex));
+    }
+    FileSink->Flush();
+    const FNVFileSinkStats Stats = FileSink->GetStats();
+    AddInfo(Stats.ToString());
+    TestTrue(TEXT("The operations are batched"), Stats.AverageBatchSize > 1.0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFileSinkIoUringFlushTest, "NVSceneCapturer.FileSink.IoUring.Flush", NV_UNIT_TEST_FLAGS)
+bool FNVFileSinkIoUringFlushTest::RunTest(const FString& Parameters)
+{
+    if (!CanTestIoUringFileSink(*this))
+    {
+        return true;
+    }
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("FileSinkIoUringFlush"));
+    TestFlush(*this, TestDirectory.DirectoryPath, &CreateIoUringFileSink);
+    return true;
+}
+#endif // PLATFORM_LINUX
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVSceneDataHandler.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    const FString TestFileNamePostfix = TEXT(".left");
+    const FString TestFileExtension = TEXT(".png");
+
+    FString GetFrameFilePath(int32 FrameIndex, int32 FramesPerSubFolder)
+    {
+        FString FilePath;
+        UNVSceneDataExporter::AppendFrameFileRelativePath(FilePath, FrameIndex, FramesPerSubFolder, TestFileNamePostfix, TestFileExtension);
+        return FilePath;
+    }
+
+    /// Build the path of every frame in [0, FrameCount) and check it's parsed back to its frame index
+    /// NOTE: A mapping with a left inverse is injective, the round trip also prove no 2 frames share a file
+    void TestRoundTrip(FAutomationTestBase& Test, int32 FrameCount, int32 FramesPerSubFolder)
+    {
+        int32 MismatchedFrameCount = 0;
+        int32 WrongSubFolderCount = 0;
+        FString FilePath;
+        for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+        {
+            // NOTE: Reset keep the allocation so the loop only measure the mapping
+            FilePath.Reset();
+            UNVSceneDataExporter::AppendFrameFileRelativePath(FilePath, FrameIndex, FramesPerSubFolder, TestFileNamePostfix, TestFileExtension);
+            const int32 ParsedFrameIndex = UNVSceneDataExporter::ParseFrameFileRelativePath(FilePath, FramesPerSubFolder, TestFileNamePostfix, TestFileExtension);
+            if (ParsedFrameIndex != FrameIndex)
+            {
+                if (MismatchedFrameCount == 0)
+                {
+                    Test.AddError(FString::Printf(TEXT("Frame %d is written to '%s' which is parsed back as frame %d"), FrameIndex, *FilePath, ParsedFrameIndex));
+                }
+                MismatchedFrameCount++;
+            }
+
+            // The sub-folder in the path is the one PrepareFrameSubFolders create for the frame
+            if (FramesPerSubFolder > 0)
+            {
+                const FString ExpectedSubFolder = FString::Printf(TEXT("%06i/"), UNVSceneDataExporter::GetFrameSubFolderIndex(FrameIndex, FramesPerSubFolder));
+                if (!FilePath.StartsWith(ExpectedSubFolder, ESearchCase::CaseSensitive))
+                {
+                    WrongSubFolderCount++;
+                }
+            }
+        }
+        Test.TestEqual(FString::Printf(TEXT("Every frame is parsed back from its path (%d frames per sub-folder)"), FramesPerSubFolder), MismatchedFrameCount, 0);
+        Test.TestEqual(FString::Printf(TEXT("Every frame is in its sub-folder (%d frames per sub-folder)"), FramesPerSubFolder), WrongSubFolderCount, 0);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFrameFilePathRoundTripTest, "NVSceneCapturer.FrameFilePath.RoundTrip", NV_UNIT_TEST_FLAGS)
+bool FNVFrameFilePathRoundTripTest::RunTest(const FString& Parameters)
+{
+    const int32 FrameCount = 10 * 1000 * 1000;
+    TestRoundTrip(*this, FrameCount, 0);
+    TestRoundTrip(*this, FrameCount, 1000);
+    TestRoundTrip(*this, FrameCount, 1);
+
+    TestEqual(TEXT("Frame path without sub-folder"), GetFrameFilePath(42, 0), FString(TEXT("000042.left.png")));
+    TestEqual(TEXT("Frame path in a sub-folder"), GetFrameFilePath(1042, 1000), FString(TEXT("000001/001042.left.png")));
+    TestEqual(TEXT("The frame index grow past the padding"), GetFrameFilePath(9999999, 1000), FString(TEXT("009999/9999999.left.png")));
+    TestEqual(TEXT("No sub-folder index without sub-folders"), UNVSceneDataExporter::GetFrameSubFolderIndex(42, 0), (int32)INDEX_NONE);
+
+    // The paths around the end of the padding are all different
+    TSet<FString> FilePaths;
+    for (int32 FrameIndex = 999000; FrameIndex < 1001000; FrameIndex++)
+    {
+        FilePaths.Add(GetFrameFilePath(FrameIndex, 1000));
+        FilePaths.Add(GetFrameFilePath(FrameIndex, 0));
+    }
+    TestEqual(TEXT("Each frame has its own file"), FilePaths.Num(), 2 * 2000);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFrameFilePathInvalidTest, "NVSceneCapturer.FrameFilePath.Invalid", NV_UNIT_TEST_FLAGS)
+bool FNVFrameFilePathInvalidTest::RunTest(const FString& Parameters)
+{
+    auto ParseFilePath = [](const TCHAR* FilePath, int32 FramesPerSubFolder)
+    {
+        return UNVSceneDataExporter::ParseFrameFileRelativePath(FilePath, FramesPerSubFolder, TestFileNamePostfix, TestFileExtension);
+    };
+
+    TestEqual(TEXT("Valid path"), ParseFilePath(TEXT("000001/001042.left.png"), 1000), 1042);
+    TestEqual(TEXT("The frame isn't in its sub-folder"), ParseFilePath(TEXT("000002/001042.left.png"), 1000), (int32)INDEX_NONE);
+    TestEqual(TEXT("Missing sub-folder"), ParseFilePath(TEXT("001042.left.png"), 1000), (int32)INDEX_NONE);
+    TestEqual(TEXT("Unexpected sub-folder"), ParseFilePath(TEXT("000001/001042.left.png"), 0), (int32)INDEX_NONE);
+    TestEqual(TEXT("Missing padding"), ParseFilePath(TEXT("1042.left.png"), 0), (int32)INDEX_NONE);
+    TestEqual(TEXT("Extra padding"), ParseFilePath(TEXT("0001042.left.png"), 0), (int32)INDEX_NONE);
+    TestEqual(TEXT("Other viewpoint"), ParseFilePath(TEXT("001042.right.png"), 0), (int32)INDEX_NONE);
+    TestEqual(TEXT("Other extension"), ParseFilePath(TEXT("001042.left.json"), 0), (int32)INDEX_NONE);
+    TestEqual(TEXT("Not a number"), ParseFilePath(TEXT("00a042.left.png"), 0), (int32)INDEX_NONE);
+    TestEqual(TEXT("Frame index overflow"), ParseFilePath(TEXT("9999999999.left.png"), 0), (int32)INDEX_NONE);
+    TestEqual(TEXT("Only the suffix"), ParseFilePath(TEXT(".left.png"), 0), (int32)INDEX_NONE);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
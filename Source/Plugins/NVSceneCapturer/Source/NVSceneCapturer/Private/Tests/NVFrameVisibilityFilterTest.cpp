@@ -0,0 +1,124 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVFrameVisibilityFilter.h"
+#include "NVSceneCaptureComponent2D.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// A synthetic view frustum: a 640x480 camera with a 90 degrees horizontal field of view, the X axis is forward
+    FMatrix MakeViewProjectionMatrix(const FTransform& ViewTransform, ECameraProjectionMode::Type ProjectionType = ECameraProjectionMode::Perspective)
+    {
+        const FMatrix ProjectionMatrix = UNVSceneCaptureComponent2D::BuildProjectionMatrix(FNVImageSize(640, 480), ProjectionType, 90.f, 400.f);
+        return UNVSceneCaptureComponent2D::BuildViewProjectionMatrix(ViewTransform, ProjectionMatrix);
+    }
+
+    FBox MakeBox(const FVector& Center, float HalfSize)
+    {
+        return FBox(Center - FVector(HalfSize), Center + FVector(HalfSize));
+    }
+
+    FNVFrameVisibilitySettings MakeSettings(int32 MinVisibleObjectCount, float MinProjectedArea)
+    {
+        FNVFrameVisibilitySettings Settings;
+        Settings.bEnabled = true;
+        Settings.MinVisibleObjectCount = MinVisibleObjectCount;
+        Settings.MinProjectedArea = MinProjectedArea;
+        return Settings;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFrameVisibilityFrustumTest, "NVSceneCapturer.FrameVisibility.Frustum", NV_UNIT_TEST_FLAGS)
+bool FNVFrameVisibilityFrustumTest::RunTest(const FString& Parameters)
+{
+    const FMatrix ViewProjectionMatrix = MakeViewProjectionMatrix(FTransform::Identity);
+
+    TestTrue(TEXT("The box in front of the camera is visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector(100.f, 0.f, 0.f), 10.f)));
+    TestTrue(TEXT("The far box is visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector(100000.f, 0.f, 0.f), 10.f)));
+    TestFalse(TEXT("The box behind the camera isn't visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector(-100.f, 0.f, 0.f), 10.f)));
+    TestFalse(TEXT("The box on the left of the frustum isn't visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector(100.f, -300.f, 0.f), 10.f)));
+    TestFalse(TEXT("The box above the frustum isn't visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector(100.f, 0.f, 200.f), 10.f)));
+    // The vertical field of view is narrower than the horizontal one: the frustum's top is 0.75 unit up per unit away
+    TestTrue(TEXT("The box inside the horizontal field of view is visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector(100.f, 85.f, 0.f), 10.f)));
+    TestFalse(TEXT("The box outside the vertical field of view isn't visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector(100.f, 0.f, 100.f), 10.f)));
+    TestTrue(TEXT("The box crossing the frustum's side is visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector(100.f, 105.f, 0.f), 10.f)));
+    TestTrue(TEXT("The box around the camera is visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, MakeBox(FVector::ZeroVector, 50.f)));
+    TestFalse(TEXT("An invalid box isn't visible"), FNVFrameVisibilityFilter::IsBoxInFrustum(ViewProjectionMatrix, FBox(EForceInit::ForceInit)));
+
+    // A viewpoint which is moved and turned to the left see the box on its side instead
+    const FMatrix TurnedViewProjectionMatrix = MakeViewProjectionMatrix(FTransform(FRotator(0.f, -90.f, 0.f), FVector(0.f, 50.f, 0.f)));
+    TestTrue(TEXT("The turned viewpoint see the box on its left"), FNVFrameVisibilityFilter::IsBoxInFrustum(TurnedViewProjectionMatrix, MakeBox(FVector(0.f, -100.f, 0.f), 10.f)));
+    TestFalse(TEXT("The turned viewpoint doesn't see the box in front of the other one"), FNVFrameVisibilityFilter::IsBoxInFrustum(TurnedViewProjectionMatrix, MakeBox(FVector(100.f, 0.f, 0.f), 10.f)));
+
+    // The orthographic frustum is 400 units wide whatever the distance
+    const FMatrix OrthoViewProjectionMatrix = MakeViewProjectionMatrix(FTransform::Identity, ECameraProjectionMode::Orthographic);
+    TestTrue(TEXT("The orthographic view see the far box on its side"), FNVFrameVisibilityFilter::IsBoxInFrustum(OrthoViewProjectionMatrix, MakeBox(FVector(5000.f, 180.f, 0.f), 10.f)));
+    TestFalse(TEXT("The orthographic view doesn't see past its width"), FNVFrameVisibilityFilter::IsBoxInFrustum(OrthoViewProjectionMatrix, MakeBox(FVector(100.f, 250.f, 0.f), 10.f)));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFrameVisibilityProjectedAreaTest, "NVSceneCapturer.FrameVisibility.ProjectedArea", NV_UNIT_TEST_FLAGS)
+bool FNVFrameVisibilityProjectedAreaTest::RunTest(const FString& Parameters)
+{
+    const FMatrix ViewProjectionMatrix = MakeViewProjectionMatrix(FTransform::Identity);
+
+    // The front face of the box is 90 units away: it covers 20 / 90 of the image's half width and 20 / 67.5 of its half height
+    const float ExpectedArea = (20.f / 90.f) * (20.f / 67.5f) / 4.f;
+    TestEqual(TEXT("The projected area of the centered box"), FNVFrameVisibilityFilter::CalculateProjectedArea(ViewProjectionMatrix, MakeBox(FVector(100.f, 0.f, 0.f), 10.f)), ExpectedArea, 1.0e-4f);
+    TestEqual(TEXT("The projected area shrink with the distance"),
+              FNVFrameVisibilityFilter::CalculateProjectedArea(ViewProjectionMatrix, MakeBox(FVector(1000.f, 0.f, 0.f), 10.f)), (20.f / 990.f) * (20.f / 742.5f) / 4.f, 1.0e-5f);
+
+    // The part of the box outside of the image isn't counted
+    const float BorderArea = FNVFrameVisibilityFilter::CalculateProjectedArea(ViewProjectionMatrix, MakeBox(FVector(100.f, 100.f, 0.f), 10.f));
+    TestTrue(TEXT("The box on the image's border is partly counted"), (BorderArea > 0.f) && (BorderArea < ExpectedArea));
+
+    TestEqual(TEXT("The box outside of the image cover nothing"), FNVFrameVisibilityFilter::CalculateProjectedArea(ViewProjectionMatrix, MakeBox(FVector(100.f, -300.f, 0.f), 10.f)), 0.f);
+    TestEqual(TEXT("The box filling the view cover the whole image"), FNVFrameVisibilityFilter::CalculateProjectedArea(ViewProjectionMatrix, FBox(FVector(100.f, -1000.f, -1000.f), FVector(200.f, 1000.f, 1000.f))), 1.f);
+    TestEqual(TEXT("The box partly behind the camera may cover the whole image"), FNVFrameVisibilityFilter::CalculateProjectedArea(ViewProjectionMatrix, MakeBox(FVector::ZeroVector, 50.f)), 1.f);
+    TestEqual(TEXT("An invalid box cover nothing"), FNVFrameVisibilityFilter::CalculateProjectedArea(ViewProjectionMatrix, FBox(EForceInit::ForceInit)), 0.f);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVFrameVisibilityPredicateTest, "NVSceneCapturer.FrameVisibility.Predicate", NV_UNIT_TEST_FLAGS)
+bool FNVFrameVisibilityPredicateTest::RunTest(const FString& Parameters)
+{
+    const FMatrix ViewProjectionMatrix = MakeViewProjectionMatrix(FTransform::Identity);
+
+    const FBox NearBox = MakeBox(FVector(100.f, 0.f, 0.f), 10.f);
+    const FBox TinyBox = MakeBox(FVector(5000.f, 0.f, 0.f), 1.f);
+    const FBox BehindBox = MakeBox(FVector(-100.f, 0.f, 0.f), 10.f);
+    const FBox SideBox = MakeBox(FVector(100.f, -300.f, 0.f), 10.f);
+    const TArray<FBox> ObjectBounds = { NearBox, TinyBox, BehindBox, SideBox };
+
+    TestEqual(TEXT("The boxes in the frustum are counted"), FNVFrameVisibilityFilter::CountVisibleObjects(ViewProjectionMatrix, ObjectBounds, 0.f), 2);
+    TestEqual(TEXT("The boxes too small in the image aren't counted"), FNVFrameVisibilityFilter::CountVisibleObjects(ViewProjectionMatrix, ObjectBounds, 0.001f), 1);
+    TestEqual(TEXT("No box cover half of the image"), FNVFrameVisibilityFilter::CountVisibleObjects(ViewProjectionMatrix, ObjectBounds, 0.5f), 0);
+
+    TestTrue(TEXT("One visible object is enough"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(1, 0.f), ViewProjectionMatrix, ObjectBounds));
+    TestTrue(TEXT("Two visible objects are enough"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(2, 0.f), ViewProjectionMatrix, ObjectBounds));
+    TestFalse(TEXT("Three visible objects aren't"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(3, 0.f), ViewProjectionMatrix, ObjectBounds));
+    TestFalse(TEXT("The tiny object doesn't count with a minimum area"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(2, 0.001f), ViewProjectionMatrix, ObjectBounds));
+    TestFalse(TEXT("Fewer objects than the minimum"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(5, 0.f), ViewProjectionMatrix, ObjectBounds));
+    TestFalse(TEXT("No object is never enough"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(1, 0.f), ViewProjectionMatrix, {}));
+    TestFalse(TEXT("The objects all behind the camera"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(1, 0.f), ViewProjectionMatrix, { BehindBox, SideBox }));
+    TestTrue(TEXT("A null minimum count still need one object"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(0, 0.f), ViewProjectionMatrix, { NearBox }));
+    TestFalse(TEXT("A null minimum count still need one object"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(0, 0.f), ViewProjectionMatrix, { BehindBox }));
+
+    // Each viewpoint is checked with its own frustum, e.g: the second one is turned away from the objects
+    const FMatrix TurnedViewProjectionMatrix = MakeViewProjectionMatrix(FTransform(FRotator(0.f, 180.f, 0.f), FVector::ZeroVector));
+    TestTrue(TEXT("The turned viewpoint see the box behind the first one"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(1, 0.f), TurnedViewProjectionMatrix, { BehindBox }));
+    TestFalse(TEXT("The turned viewpoint doesn't see the box in front of the first one"), FNVFrameVisibilityFilter::HasEnoughVisibleObjects(MakeSettings(1, 0.f), TurnedViewProjectionMatrix, { NearBox }));
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,239 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVInstanceClassRemap.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// A synthetic instance mask, the instance ids are encoded the same way as the vertex color render
+    struct FSyntheticMask
+    {
+        FNVTexturePixelData PixelData;
+        /// The instance id of each pixel, row by row
+        TArray<uint32> InstanceIds;
+
+        FSyntheticMask(int32 Width, int32 Height, EPixelFormat PixelFormat = PF_B8G8R8A8, int32 RowPadding = 0)
+        {
+            PixelData.PixelFormat = PixelFormat;
+            PixelData.PixelSize = FIntPoint(Width, Height);
+            PixelData.RowStride = Width * 4 + RowPadding;
+            PixelData.PixelData.SetNumZeroed(PixelData.RowStride * Height);
+            InstanceIds.SetNumZeroed(Width * Height);
+
+            // The padding at the end of the rows must never be read
+            for (int32 Y = 0; Y < Height; Y++)
+            {
+                for (int32 PaddingIndex = 0; PaddingIndex < RowPadding; PaddingIndex++)
+                {
+                    PixelData.PixelData[Y * PixelData.RowStride + Width * 4 + PaddingIndex] = 0x01;
+                }
+            }
+        }
+
+        void SetPixel(int32 X, int32 Y, uint32 InstanceId, uint8 Alpha = 0xFF)
+        {
+            const bool bIsBGRA = (PixelData.PixelFormat == PF_B8G8R8A8);
+            uint8* Pixel = PixelData.PixelData.GetData() + Y * PixelData.RowStride + X * 4;
+            Pixel[bIsBGRA ? 2 : 0] = (InstanceId >> 16) & 0xFF;
+            Pixel[1] = (InstanceId >> 8) & 0xFF;
+            Pixel[bIsBGRA ? 0 : 2] = InstanceId & 0xFF;
+            Pixel[3] = Alpha;
+            InstanceIds[Y * PixelData.PixelSize.X + X] = InstanceId;
+        }
+    };
+
+    /// Remap the mask and compare every pixel with the class of its instance looked up one by one
+    void TestRemappedMask(FAutomationTestBase& Test, const FString& What, const FSyntheticMask& Mask, const FNVInstanceClassLUT& InstanceClassLUT,
+                          const TMap<uint32, uint8>& ExpectedClassIds)
+    {
+        FNVTexturePixelData ClassMaskPixelData;
+        if (!Test.TestTrue(What + TEXT(": the mask is remapped"), FNVInstanceClassRemap::Remap(Mask.PixelData, InstanceClassLUT, ClassMaskPixelData)))
+        {
+            return;
+        }
+
+        const FIntPoint& PixelSize = Mask.PixelData.PixelSize;
+        Test.TestEqual(What + TEXT(": the class mask is a 8 bit mask"), (int32)ClassMaskPixelData.PixelFormat, (int32)PF_G8);
+        Test.TestTrue(What + TEXT(": the class mask has the instance mask size"), ClassMaskPixelData.PixelSize == PixelSize);
+        Test.TestEqual(What + TEXT(": the class mask is tightly packed"), (int32)ClassMaskPixelData.RowStride, PixelSize.X);
+        if (!Test.TestEqual(What + TEXT(": the class mask buffer size"), ClassMaskPixelData.PixelData.Num(), PixelSize.X * PixelSize.Y))
+        {
+            return;
+        }
+
+        int32 MismatchedPixelCount = 0;
+        for (int32 PixelIndex = 0; PixelIndex < Mask.InstanceIds.Num(); PixelIndex++)
+        {
+            const uint8* ExpectedClassId = ExpectedClassIds.Find(Mask.InstanceIds[PixelIndex]);
+            const uint8 ClassId = ClassMaskPixelData.PixelData[PixelIndex];
+            if (ClassId != (ExpectedClassId ? *ExpectedClassId : 0))
+            {
+                if (MismatchedPixelCount == 0)
+                {
+                    Test.AddError(FString::Printf(TEXT("%s: the pixel (%d, %d) of the instance %u has the class %d instead of %d"), *What,
+                                                  PixelIndex % PixelSize.X, PixelIndex / PixelSize.X, Mask.InstanceIds[PixelIndex], ClassId, ExpectedClassId ? *ExpectedClassId : 0));
+                }
+                MismatchedPixelCount++;
+            }
+        }
+        Test.TestEqual(What + TEXT(": every pixel has the class of its instance"), MismatchedPixelCount, 0);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVInstanceClassLUTBuildTest, "NVSceneCapturer.InstanceClassRemap.LUTBuild", NV_UNIT_TEST_FLAGS)
+bool FNVInstanceClassLUTBuildTest::RunTest(const FString& Parameters)
+{
+    FNVInstanceClassLUT InstanceClassLUT;
+    TestFalse(TEXT("A new table is invalid"), InstanceClassLUT.IsValid());
+    TestEqual(TEXT("A new table has no version"), InstanceClassLUT.GetVersion(), (int32)INDEX_NONE);
+    TestEqual(TEXT("A new table map everything to the background"), (int32)InstanceClassLUT.GetClassId(5), 0);
+
+    // Sequential ids
+    TMap<uint32, uint8> InstanceClassIds;
+    InstanceClassIds.Add(1, 10);
+    InstanceClassIds.Add(2, 20);
+    InstanceClassIds.Add(4, 10);
+    InstanceClassIds.Add(5, 0);
+    InstanceClassLUT.Build(InstanceClassIds, 1, 3);
+    TestTrue(TEXT("The table is valid"), InstanceClassLUT.IsValid());
+    TestEqual(TEXT("The table has the version of the masks"), InstanceClassLUT.GetVersion(), 3);
+    TestEqual(TEXT("The table stop at the largest id"), InstanceClassLUT.Num(), 6);
+    TestEqual(TEXT("The background has no class"), (int32)InstanceClassLUT.GetClassId(0), 0);
+    TestEqual(TEXT("Instance 1"), (int32)InstanceClassLUT.GetClassId(1), 10);
+    TestEqual(TEXT("Instance 2"), (int32)InstanceClassLUT.GetClassId(2), 20);
+    TestEqual(TEXT("An id missing between 2 instances has no class"), (int32)InstanceClassLUT.GetClassId(3), 0);
+    TestEqual(TEXT("Instances may share a class"), (int32)InstanceClassLUT.GetClassId(4), 10);
+    TestEqual(TEXT("An instance without class"), (int32)InstanceClassLUT.GetClassId(5), 0);
+    TestEqual(TEXT("An id past the table has no class"), (int32)InstanceClassLUT.GetClassId(6), 0);
+    TestEqual(TEXT("The largest id has no class"), (int32)InstanceClassLUT.GetClassId(MAX_uint32), 0);
+
+    // Ids spread evenly: the table is indexed by id / step so it stay as small as the instance count
+    const uint32 IdStep = 0x010101;
+    TMap<uint32, uint8> SpreadInstanceClassIds;
+    for (uint32 InstanceIndex = 1; InstanceIndex <= 15; InstanceIndex++)
+    {
+        SpreadInstanceClassIds.Add(InstanceIndex * IdStep, uint8(InstanceIndex * 17));
+    }
+    InstanceClassLUT.Build(SpreadInstanceClassIds, IdStep, 4);
+    TestEqual(TEXT("The rebuilt table has the new version"), InstanceClassLUT.GetVersion(), 4);
+    TestEqual(TEXT("The spread ids step"), (int32)InstanceClassLUT.GetIdStep(), (int32)IdStep);
+    TestEqual(TEXT("The spread table has an entry per instance"), InstanceClassLUT.Num(), 16);
+    TestEqual(TEXT("The first spread instance"), (int32)InstanceClassLUT.GetClassId(IdStep), 17);
+    TestEqual(TEXT("The last spread instance"), (int32)InstanceClassLUT.GetClassId(15 * IdStep), 255);
+    TestEqual(TEXT("An id past the spread table has no class"), (int32)InstanceClassLUT.GetClassId(16 * IdStep), 0);
+    TestEqual(TEXT("The ids of the previous build are gone"), (int32)InstanceClassLUT.GetClassId(2), 0);
+
+    // A null step is handled as sequential ids
+    InstanceClassLUT.Build(InstanceClassIds, 0, 5);
+    TestEqual(TEXT("A null step is a step of 1"), (int32)InstanceClassLUT.GetIdStep(), 1);
+    TestEqual(TEXT("The table built with a null step"), (int32)InstanceClassLUT.GetClassId(2), 20);
+
+    // No instance: the table is empty again
+    InstanceClassLUT.Build(TMap<uint32, uint8>(), 1, 6);
+    TestFalse(TEXT("The table without instance is invalid"), InstanceClassLUT.IsValid());
+    TestEqual(TEXT("The empty table keep its version"), InstanceClassLUT.GetVersion(), 6);
+    TestEqual(TEXT("The empty table map everything to the background"), (int32)InstanceClassLUT.GetClassId(1), 0);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVInstanceClassRemapKernelTest, "NVSceneCapturer.InstanceClassRemap.Kernel", NV_UNIT_TEST_FLAGS)
+bool FNVInstanceClassRemapKernelTest::RunTest(const FString& Parameters)
+{
+    TMap<uint32, uint8> InstanceClassIds;
+    InstanceClassIds.Add(1, 3);
+    InstanceClassIds.Add(0x0100, 7);
+    InstanceClassIds.Add(0x010000, 11);
+    InstanceClassIds.Add(0x123456, 255);
+    FNVInstanceClassLUT InstanceClassLUT;
+    InstanceClassLUT.Build(InstanceClassIds, 1, 1);
+
+    // Each byte of the id comes from its own channel, the alpha is ignored
+    // NOTE: The widths aren't multiples of 4 so the tail of the rows is remapped too
+    const EPixelFormat PixelFormats[] = { PF_B8G8R8A8, PF_R8G8B8A8 };
+    for (EPixelFormat PixelFormat : PixelFormats)
+    {
+        const FString FormatName = (PixelFormat == PF_B8G8R8A8) ? TEXT("BGRA") : TEXT("RGBA");
+        FSyntheticMask Mask(7, 3, PixelFormat);
+        Mask.SetPixel(0, 0, 1);
+        Mask.SetPixel(1, 0, 0x0100);
+        Mask.SetPixel(2, 0, 0x010000);
+        Mask.SetPixel(3, 0, 0x123456);
+        Mask.SetPixel(4, 0, 0x123456, 0);
+        Mask.SetPixel(5, 0, 2);
+        Mask.SetPixel(6, 0, 0xFFFFFF);
+        Mask.SetPixel(6, 1, 0x0100);
+        Mask.SetPixel(3, 2, 1);
+        TestRemappedMask(*this, FormatName, Mask, InstanceClassLUT, InstanceClassIds);
+    }
+
+    // The row padding is skipped
+    {
+        FSyntheticMask Mask(5, 4, PF_B8G8R8A8, 12);
+        for (int32 Y = 0; Y < 4; Y++)
+        {
+            Mask.SetPixel(4, Y, 0x010000);
+            Mask.SetPixel(Y, Y, 0x0100);
+        }
+        TestRemappedMask(*this, TEXT("Padded rows"), Mask, InstanceClassLUT, InstanceClassIds);
+    }
+
+    // A row stride of 0 means the rows are tightly packed
+    {
+        FSyntheticMask Mask(4, 2);
+        Mask.SetPixel(3, 1, 0x123456);
+        Mask.PixelData.RowStride = 0;
+        TestRemappedMask(*this, TEXT("Unknown row stride"), Mask, InstanceClassLUT, InstanceClassIds);
+    }
+
+    // Random ids spread evenly, compared with the table looked up one pixel at a time
+    {
+        const uint32 IdStep = 0x0F0F0F;
+        TMap<uint32, uint8> SpreadInstanceClassIds;
+        for (uint32 InstanceIndex = 1; InstanceIndex <= 16; InstanceIndex++)
+        {
+            SpreadInstanceClassIds.Add(InstanceIndex * IdStep, uint8(1 + InstanceIndex % 5));
+        }
+        FNVInstanceClassLUT SpreadInstanceClassLUT;
+        SpreadInstanceClassLUT.Build(SpreadInstanceClassIds, IdStep, 2);
+
+        FRandomStream RandomStream(7);
+        FSyntheticMask Mask(131, 37, PF_B8G8R8A8, 20);
+        for (int32 Y = 0; Y < 37; Y++)
+        {
+            for (int32 X = 0; X < 131; X++)
+            {
+                Mask.SetPixel(X, Y, uint32(RandomStream.RandRange(0, 17)) * IdStep);
+            }
+        }
+        TestRemappedMask(*this, TEXT("Random spread ids"), Mask, SpreadInstanceClassLUT, SpreadInstanceClassIds);
+    }
+
+    // Without table everything is background
+    {
+        FSyntheticMask Mask(6, 2);
+        Mask.SetPixel(1, 1, 1);
+        TestRemappedMask(*this, TEXT("Empty table"), Mask, FNVInstanceClassLUT(), TMap<uint32, uint8>());
+    }
+
+    FNVTexturePixelData ClassMaskPixelData;
+    FSyntheticMask FloatMask(4, 4, PF_FloatRGBA);
+    AddExpectedError(TEXT("is not supported"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestFalse(TEXT("The unsupported pixel formats aren't remapped"), FNVInstanceClassRemap::Remap(FloatMask.PixelData, InstanceClassLUT, ClassMaskPixelData));
+
+    FSyntheticMask TruncatedMask(4, 4);
+    TruncatedMask.PixelData.PixelData.SetNum(TruncatedMask.PixelData.PixelData.Num() - 1);
+    AddExpectedError(TEXT("invalid argument"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestFalse(TEXT("A buffer smaller than the mask isn't remapped"), FNVInstanceClassRemap::Remap(TruncatedMask.PixelData, InstanceClassLUT, ClassMaskPixelData));
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,301 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVInstanceMaskStats.h"
+#include "Json.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// A synthetic instance mask, the instance ids are encoded the same way as the vertex color render
+    struct FSyntheticMask
+    {
+        FNVTexturePixelData PixelData;
+
+        FSyntheticMask(int32 Width, int32 Height, EPixelFormat PixelFormat = PF_B8G8R8A8, int32 RowPadding = 0)
+        {
+            PixelData.PixelFormat = PixelFormat;
+            PixelData.PixelSize = FIntPoint(Width, Height);
+            PixelData.RowStride = Width * 4 + RowPadding;
+            PixelData.PixelData.SetNumZeroed(PixelData.RowStride * Height);
+
+            // The padding at the end of the rows must never be read
+            for (int32 Y = 0; Y < Height; Y++)
+            {
+                for (int32 PaddingIndex = 0; PaddingIndex < RowPadding; PaddingIndex++)
+                {
+                    PixelData.PixelData[Y * PixelData.RowStride + Width * 4 + PaddingIndex] = 0x5A;
+                }
+            }
+        }
+
+        void SetPixel(int32 X, int32 Y, uint32 InstanceId, uint8 Alpha = 0)
+        {
+            const bool bIsBGRA = (PixelData.PixelFormat == PF_B8G8R8A8);
+            uint8* Pixel = PixelData.PixelData.GetData() + Y * PixelData.RowStride + X * 4;
+            Pixel[bIsBGRA ? 2 : 0] = (InstanceId >> 16) & 0xFF;
+            Pixel[1] = (InstanceId >> 8) & 0xFF;
+            Pixel[bIsBGRA ? 0 : 2] = InstanceId & 0xFF;
+            Pixel[3] = Alpha;
+        }
+
+        void FillRect(const FIntRect& Rect, uint32 InstanceId)
+        {
+            for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+            {
+                for (int32 X = Rect.Min.X; X < Rect.Max.X; X++)
+                {
+                    SetPixel(X, Y, InstanceId);
+                }
+            }
+        }
+    };
+
+    TSharedPtr<FJsonObject> MakeAnnotationData(const TArray<uint32>& InstanceIds, bool bWithBoundingBox)
+    {
+        TArray<TSharedPtr<FJsonValue>> ObjectValues;
+        for (uint32 InstanceId : InstanceIds)
+        {
+            TSharedPtr<FJsonObject> ObjectJsonObj = MakeShared<FJsonObject>();
+            ObjectJsonObj->SetStringField(TEXT("class"), TEXT("Cube"));
+            ObjectJsonObj->SetNumberField(TEXT("instance_id"), InstanceId);
+            if (bWithBoundingBox)
+            {
+                ObjectJsonObj->SetStringField(TEXT("bounding_box"), TEXT("projected"));
+            }
+            ObjectValues.Add(MakeShared<FJsonValueObject>(ObjectJsonObj));
+        }
+
+        TSharedPtr<FJsonObject> AnnotationData = MakeShared<FJsonObject>();
+        AnnotationData->SetArrayField(TEXT("objects"), ObjectValues);
+        return AnnotationData;
+    }
+
+    TSharedPtr<FJsonObject> GetObject(const TSharedPtr<FJsonObject>& AnnotationData, int32 ObjectIndex)
+    {
+        return AnnotationData->GetArrayField(TEXT("objects"))[ObjectIndex]->AsObject();
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVInstanceMaskStatsScanTest, "NVSceneCapturer.InstanceMaskStats.Scan", NV_UNIT_TEST_FLAGS)
+bool FNVInstanceMaskStatsScanTest::RunTest(const FString& Parameters)
+{
+    // 2 rectangles, one of them split in 2 pieces, on a padded BGRA buffer
+    FSyntheticMask Mask(64, 32, PF_B8G8R8A8, 12);
+    Mask.FillRect(FIntRect(4, 2, 10, 8), 1);
+    Mask.FillRect(FIntRect(20, 10, 30, 12), 0x123456);
+    Mask.FillRect(FIntRect(40, 20, 42, 31), 0x123456);
+    // A single pixel touching the right border
+    Mask.SetPixel(63, 0, 0xABCDEF);
+
+    FNVInstanceMaskStats MaskStats;
+    TestTrue(TEXT("The mask is scanned"), MaskStats.Scan(Mask.PixelData));
+    TestEqual(TEXT("Image size"), MaskStats.ImageSize, FIntPoint(64, 32));
+    TestEqual(TEXT("The background isn't counted"), MaskStats.ObjectStats.Num(), 3);
+
+    const FNVInstanceMaskObjectStats* FirstStats = MaskStats.Find(1);
+    if (TestNotNull(TEXT("Instance 1"), FirstStats))
+    {
+        TestEqual(TEXT("Instance 1 min"), FirstStats->Min, FIntPoint(4, 2));
+        TestEqual(TEXT("Instance 1 max"), FirstStats->Max, FIntPoint(9, 7));
+        TestEqual(TEXT("Instance 1 pixel count"), FirstStats->PixelCount, uint32(6 * 6));
+        const FBox2D Box = FirstStats->GetBox2D();
+        TestEqual(TEXT("The box max corner is exclusive"), Box.Max, FVector2D(10.f, 8.f));
+    }
+
+    const FNVInstanceMaskObjectStats* SplitStats = MaskStats.Find(0x123456);
+    if (TestNotNull(TEXT("Split instance"), SplitStats))
+    {
+        TestEqual(TEXT("Split instance min"), SplitStats->Min, FIntPoint(20, 10));
+        TestEqual(TEXT("Split instance max"), SplitStats->Max, FIntPoint(41, 30));
+        TestEqual(TEXT("Split instance pixel count"), SplitStats->PixelCount, uint32(10 * 2 + 2 * 11));
+    }
+
+    const FNVInstanceMaskObjectStats* BorderStats = MaskStats.Find(0xABCDEF);
+    if (TestNotNull(TEXT("Border instance"), BorderStats))
+    {
+        TestEqual(TEXT("Border instance min"), BorderStats->Min, FIntPoint(63, 0));
+        TestEqual(TEXT("Border instance max"), BorderStats->Max, FIntPoint(63, 0));
+        TestEqual(TEXT("Border instance pixel count"), BorderStats->PixelCount, uint32(1));
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVInstanceMaskStatsFormatTest, "NVSceneCapturer.InstanceMaskStats.PixelFormats", NV_UNIT_TEST_FLAGS)
+bool FNVInstanceMaskStatsFormatTest::RunTest(const FString& Parameters)
+{
+    // The RGBA buffers decode the same ids as the BGRA ones
+    FSyntheticMask RGBAMask(8, 4, PF_R8G8B8A8);
+    RGBAMask.FillRect(FIntRect(1, 1, 3, 3), 0x010203);
+    FNVInstanceMaskStats MaskStats;
+    TestTrue(TEXT("The RGBA mask is scanned"), MaskStats.Scan(RGBAMask.PixelData));
+    TestNotNull(TEXT("The RGBA id is decoded"), MaskStats.Find(0x010203));
+
+    // The alpha channel isn't written by the vertex color render, it mustn't split the runs nor the ids
+    FSyntheticMask AlphaMask(8, 1);
+    for (int32 X = 0; X < 8; X++)
+    {
+        AlphaMask.SetPixel(X, 0, 7, uint8(X * 31));
+    }
+    TestTrue(TEXT("The mask with random alpha is scanned"), MaskStats.Scan(AlphaMask.PixelData));
+    TestEqual(TEXT("The alpha is ignored"), MaskStats.ObjectStats.Num(), 1);
+    const FNVInstanceMaskObjectStats* AlphaStats = MaskStats.Find(7);
+    TestTrue(TEXT("All the pixels are counted"), AlphaStats && (AlphaStats->PixelCount == 8));
+
+    // Unsupported format and truncated buffer
+    FSyntheticMask FloatMask(8, 4);
+    FloatMask.PixelData.PixelFormat = PF_R32_FLOAT;
+    AddExpectedError(TEXT("is not supported"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestFalse(TEXT("The unsupported format is rejected"), MaskStats.Scan(FloatMask.PixelData));
+
+    FSyntheticMask TruncatedMask(8, 4);
+    TruncatedMask.PixelData.PixelData.SetNum(8 * 4 * 3);
+    AddExpectedError(TEXT("invalid argument"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestFalse(TEXT("The truncated buffer is rejected"), MaskStats.Scan(TruncatedMask.PixelData));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVInstanceMaskStatsApplyTest, "NVSceneCapturer.InstanceMaskStats.ApplyToAnnotationData", NV_UNIT_TEST_FLAGS)
+bool FNVInstanceMaskStatsApplyTest::RunTest(const FString& Parameters)
+{
+    FSyntheticMask Mask(16, 16);
+    Mask.FillRect(FIntRect(0, 0, 4, 4), 5);
+    FNVInstanceMaskStats MaskStats;
+    MaskStats.Scan(Mask.PixelData);
+
+    // Object 9 isn't in the mask: it's fully occluded
+    TSharedPtr<FJsonObject> AnnotationData = MakeAnnotationData({ 5, 9 }, true);
+    MaskStats.ApplyToAnnotationData(AnnotationData, true, true);
+
+    const TSharedPtr<FJsonObject> VisibleObject = GetObject(AnnotationData, 0);
+    TestEqual(TEXT("Visible pixel count"), VisibleObject->GetIntegerField(TEXT("visible_pixel_count")), 16);
+    TestTrue(TEXT("Visible box"), VisibleObject->HasTypedField<EJson::Object>(TEXT("visible_bbox")));
+    TestTrue(TEXT("The bounding box is replaced"), VisibleObject->HasTypedField<EJson::Object>(TEXT("bounding_box")));
+
+    const TSharedPtr<FJsonObject> OccludedObject = GetObject(AnnotationData, 1);
+    TestEqual(TEXT("Occluded pixel count"), OccludedObject->GetIntegerField(TEXT("visible_pixel_count")), 0);
+
+    // The schema can omit the bounding box, it mustn't be added back
+    TSharedPtr<FJsonObject> NoBoxAnnotationData = MakeAnnotationData({ 5 }, false);
+    MaskStats.ApplyToAnnotationData(NoBoxAnnotationData, true, true);
+    TestFalse(TEXT("The omitted bounding box stay omitted"), GetObject(NoBoxAnnotationData, 0)->HasField(TEXT("bounding_box")));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVInstanceMaskStatsSkippedInstancesTest, "NVSceneCapturer.InstanceMaskStats.SkippedInstances", NV_UNIT_TEST_FLAGS)
+bool FNVInstanceMaskStatsSkippedInstancesTest::RunTest(const FString& Parameters)
+{
+    // Instance 6 is a mesh instance: the mask doesn't tell it apart, e.g: its pixels have the color of its actor
+    FSyntheticMask Mask(16, 16);
+    Mask.FillRect(FIntRect(0, 0, 4, 4), 5);
+    Mask.FillRect(FIntRect(8, 8, 16, 16), 6);
+    FNVInstanceMaskStats MaskStats;
+    MaskStats.Scan(Mask.PixelData);
+
+    const TSet<uint32> SkippedInstanceIds = { 6, 7 };
+    TSharedPtr<FJsonObject> AnnotationData = MakeAnnotationData({ 5, 6, 7 }, true);
+    MaskStats.ApplyToAnnotationData(AnnotationData, true, true, &SkippedInstanceIds);
+
+    TestTrue(TEXT("The other objects get their visible box"), GetObject(AnnotationData, 0)->HasTypedField<EJson::Object>(TEXT("visible_bbox")));
+    for (int32 ObjectIndex : { 1, 2 })
+    {
+        const TSharedPtr<FJsonObject> SkippedObject = GetObject(AnnotationData, ObjectIndex);
+        TestFalse(FString::Printf(TEXT("Skipped object %d has no visible box"), ObjectIndex), SkippedObject->HasField(TEXT("visible_bbox")));
+        TestFalse(FString::Printf(TEXT("Skipped object %d has no visible pixel count"), ObjectIndex), SkippedObject->HasField(TEXT("visible_pixel_count")));
+        TestEqual(FString::Printf(TEXT("Skipped object %d keep its projected bounding box"), ObjectIndex), SkippedObject->GetStringField(TEXT("bounding_box")), FString(TEXT("projected")));
+    }
+
+    // The merger skip the same objects
+    TSharedRef<FNVInstanceMaskAnnotationMerger, ESPMode::ThreadSafe> Merger = MakeShared<FNVInstanceMaskAnnotationMerger, ESPMode::ThreadSafe>();
+    const FNVInstanceMaskAnnotationMerger::FFrameKey FrameKey(FObjectKey(), 0);
+    TSharedPtr<FJsonObject> ExportedAnnotationData;
+    Merger->AddAnnotationData(FrameKey, MakeAnnotationData({ 5, 6 }, true), FString(), true,
+                              [&ExportedAnnotationData](const TSharedPtr<FJsonObject>& AnnotationData) { ExportedAnnotationData = AnnotationData; },
+                              MakeShared<TSet<uint32>, ESPMode::ThreadSafe>(SkippedInstanceIds));
+    Merger->AddInstanceMask(FrameKey, Mask.PixelData);
+    Merger->Flush();
+
+    if (TestTrue(TEXT("The merged annotation is exported"), ExportedAnnotationData.IsValid()))
+    {
+        TestTrue(TEXT("The merged object gets its visible box"), GetObject(ExportedAnnotationData, 0)->HasField(TEXT("visible_bbox")));
+        TestFalse(TEXT("The merged mesh instance has no visible box"), GetObject(ExportedAnnotationData, 1)->HasField(TEXT("visible_bbox")));
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVInstanceMaskMergerFlushTest, "NVSceneCapturer.InstanceMaskStats.MergerFlush", NV_UNIT_TEST_FLAGS)
+bool FNVInstanceMaskMergerFlushTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FNVInstanceMaskAnnotationMerger, ESPMode::ThreadSafe> Merger = MakeShared<FNVInstanceMaskAnnotationMerger, ESPMode::ThreadSafe>();
+
+    FCriticalSection ExportedLock;
+    TMap<int32, TSharedPtr<FJsonObject>> ExportedFrames;
+    auto MakeExportFunction = [&ExportedLock, &ExportedFrames](int32 FrameIndex)
+    {
+        return [&ExportedLock, &ExportedFrames, FrameIndex](const TSharedPtr<FJsonObject>& AnnotationData)
+        {
+            FScopeLock ScopeLock(&ExportedLock);
+            ExportedFrames.Add(FrameIndex, AnnotationData);
+        };
+    };
+
+    FSyntheticMask Mask(512, 512);
+    Mask.FillRect(FIntRect(10, 10, 100, 100), 3);
+    const FObjectKey ViewpointKey;
+
+    // Frame 0: the annotation come first, frame 1: the mask come first, frame 2: the mask never come
+    Merger->AddAnnotationData(FNVInstanceMaskAnnotationMerger::FFrameKey(ViewpointKey, 0), MakeAnnotationData({ 3 }, true), FString(), true, MakeExportFunction(0));
+    Merger->AddInstanceMask(FNVInstanceMaskAnnotationMerger::FFrameKey(ViewpointKey, 0), Mask.PixelData);
+    Merger->AddInstanceMask(FNVInstanceMaskAnnotationMerger::FFrameKey(ViewpointKey, 1), Mask.PixelData);
+    Merger->AddAnnotationData(FNVInstanceMaskAnnotationMerger::FFrameKey(ViewpointKey, 2), MakeAnnotationData({ 3 }, true), FString(), true, MakeExportFunction(2));
+
+    // The scan of frame 1 may still be running, the flush must wait for it before the annotation of frame 1 come
+    Merger->Flush();
+    TestFalse(TEXT("The merger is idle after the flush"), Merger->IsHandlingData());
+    {
+        FScopeLock ScopeLock(&ExportedLock);
+        TestEqual(TEXT("Frame 0 and 2 are exported by the flush"), ExportedFrames.Num(), 2);
+        TestTrue(TEXT("Frame 0 has the visible box of its mask"), ExportedFrames.Contains(0) && GetObject(ExportedFrames[0], 0)->HasField(TEXT("visible_bbox")));
+        TestTrue(TEXT("Frame 2 is exported without visible box"), ExportedFrames.Contains(2) && !GetObject(ExportedFrames[2], 0)->HasField(TEXT("visible_bbox")));
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVInstanceMaskStatsPerfTest, "NVSceneCapturer.Perf.InstanceMaskScan", NV_PERF_TEST_FLAGS)
+bool FNVInstanceMaskStatsPerfTest::RunTest(const FString& Parameters)
+{
+    // A 1080p mask with 200 objects on a background, a typical dataset frame
+    const int32 Width = 1920;
+    const int32 Height = 1080;
+    FSyntheticMask Mask(Width, Height);
+    FRandomStream RandomStream(42);
+    for (uint32 InstanceId = 1; InstanceId <= 200; InstanceId++)
+    {
+        const FIntPoint Min(RandomStream.RandRange(0, Width - 200), RandomStream.RandRange(0, Height - 200));
+        const FIntPoint Size(RandomStream.RandRange(10, 200), RandomStream.RandRange(10, 200));
+        Mask.FillRect(FIntRect(Min, Min + Size), InstanceId);
+    }
+
+    const int32 RepeatCount = 20;
+    FNVInstanceMaskStats MaskStats;
+    const double Duration = NVSceneCapturerTest::MeasureSeconds([&]()
+    {
+        for (int32 RepeatIndex = 0; RepeatIndex < RepeatCount; RepeatIndex++)
+        {
+            MaskStats.Scan(Mask.PixelData);
+        }
+    });
+
+    const double MegaPixels = double(Width) * Height * RepeatCount / 1.0e6;
+    AddInfo(FString::Printf(TEXT("Instance mask scan: %.1f MPixels/s (%.3f ms per 1080p mask)"), MegaPixels / Duration, Duration * 1000.0 / RepeatCount));
+    TestTrue(TEXT("The objects are found"), MaskStats.ObjectStats.Num() > 0);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
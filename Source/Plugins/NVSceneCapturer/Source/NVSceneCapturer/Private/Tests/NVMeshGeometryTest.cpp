@@ -0,0 +1,200 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVMeshGeometry.h"
+#include "Math/RandomStream.h"
+#include "Algo/Reverse.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// The corners and random points inside of a box, transformed to the mesh space
+    TArray<FVector> MakeBoxVertexes(const FVector& BoxExtent, const FTransform& BoxTransform, int32 InsideVertexCount, int32 Seed)
+    {
+        TArray<FVector> Vertexes;
+        for (int32 CornerIndex = 0; CornerIndex < 8; CornerIndex++)
+        {
+            const FVector Corner((CornerIndex & 1) ? BoxExtent.X : -BoxExtent.X,
+                                 (CornerIndex & 2) ? BoxExtent.Y : -BoxExtent.Y,
+                                 (CornerIndex & 4) ? BoxExtent.Z : -BoxExtent.Z);
+            Vertexes.Add(BoxTransform.TransformPosition(Corner));
+        }
+
+        FRandomStream RandomStream(Seed);
+        for (int32 VertexIndex = 0; VertexIndex < InsideVertexCount; VertexIndex++)
+        {
+            const FVector InsidePoint(RandomStream.FRandRange(-BoxExtent.X, BoxExtent.X),
+                                      RandomStream.FRandRange(-BoxExtent.Y, BoxExtent.Y),
+                                      RandomStream.FRandRange(-BoxExtent.Z, BoxExtent.Z));
+            Vertexes.Add(BoxTransform.TransformPosition(InsidePoint));
+        }
+        return Vertexes;
+    }
+
+    FVector GetMeanVertex(const TArray<FVector>& Vertexes)
+    {
+        FVector MeanVertex = FVector::ZeroVector;
+        for (const FVector& Vertex : Vertexes)
+        {
+            MeanVertex += Vertex;
+        }
+        return MeanVertex / FMath::Max(Vertexes.Num(), 1);
+    }
+
+    bool IsOrthonormalRightHandedFrame(const FMatrix& Frame)
+    {
+        const FVector AxisX = Frame.GetScaledAxis(EAxis::X);
+        const FVector AxisY = Frame.GetScaledAxis(EAxis::Y);
+        const FVector AxisZ = Frame.GetScaledAxis(EAxis::Z);
+        return AxisX.IsUnit(1.e-3f) && AxisY.IsUnit(1.e-3f) && AxisZ.IsUnit(1.e-3f)
+               && FMath::IsNearlyZero(AxisX | AxisY, 1.e-3) && FMath::IsNearlyZero(AxisY | AxisZ, 1.e-3) && FMath::IsNearlyZero(AxisZ | AxisX, 1.e-3)
+               && (((AxisX ^ AxisY) | AxisZ) > 0.f);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshGeometryPCATest, "NVSceneCapturer.MeshGeometry.PCA", NV_UNIT_TEST_FLAGS)
+bool FNVMeshGeometryPCATest::RunTest(const FString& Parameters)
+{
+    // A box elongated along its X axis, rotated in many ways including none at all
+    const FVector BoxExtent(200.f, 30.f, 10.f);
+    const TArray<FRotator> BoxRotations = {
+        FRotator::ZeroRotator, FRotator(90.f, 0.f, 0.f), FRotator(0.f, 90.f, 0.f),
+        FRotator(30.f, 45.f, 60.f), FRotator(-75.f, 10.f, 120.f), FRotator(5.f, -160.f, -40.f)
+    };
+
+    for (int32 RotationIndex = 0; RotationIndex < BoxRotations.Num(); RotationIndex++)
+    {
+        const FTransform BoxTransform(BoxRotations[RotationIndex], FVector(12.f, -40.f, 75.f));
+        const TArray<FVector> Vertexes = MakeBoxVertexes(BoxExtent, BoxTransform, 500, RotationIndex);
+
+        const FMatrix PCAMatrix = FNVMeshGeometryMath::CalculatePCA(Vertexes);
+        const FString RotationName = BoxRotations[RotationIndex].ToString();
+        TestTrue(FString::Printf(TEXT("%s: the PCA frame is orthonormal and right handed"), *RotationName), IsOrthonormalRightHandedFrame(PCAMatrix));
+        TestTrue(FString::Printf(TEXT("%s: the PCA frame's origin is the mean vertex"), *RotationName), PCAMatrix.GetOrigin().Equals(GetMeanVertex(Vertexes), 1.e-2f));
+
+        const FVector BoxAxis = BoxTransform.GetUnitAxis(EAxis::X);
+        TestTrue(FString::Printf(TEXT("%s: the Z axis is the box's long axis"), *RotationName),
+                 FMath::Abs(PCAMatrix.GetUnitAxis(EAxis::Z) | BoxAxis) > 0.999f);
+    }
+
+    // No vertex: the identity frame
+    TestTrue(TEXT("The PCA of no vertex is the identity"), FNVMeshGeometryMath::CalculatePCA(TArray<FVector>()).Equals(FMatrix::Identity));
+
+    // The dominant eigen vector of a diagonal matrix is the axis with the largest value, whichever axis it is
+    TestTrue(TEXT("Dominant X axis"), FMath::Abs(FNVMeshGeometryMath::ComputeDominantEigenVector(FScaleMatrix(FVector(5.f, 1.f, 2.f))).X) > 0.999f);
+    TestTrue(TEXT("Dominant Y axis"), FMath::Abs(FNVMeshGeometryMath::ComputeDominantEigenVector(FScaleMatrix(FVector(1.f, 5.f, 2.f))).Y) > 0.999f);
+    TestTrue(TEXT("Dominant Z axis"), FMath::Abs(FNVMeshGeometryMath::ComputeDominantEigenVector(FScaleMatrix(FVector(1.f, 2.f, 5.f))).Z) > 0.999f);
+    TestTrue(TEXT("An isotropic matrix keep the Z axis"), FMath::Abs(FNVMeshGeometryMath::ComputeDominantEigenVector(FScaleMatrix(FVector(3.f))).Z) > 0.999f);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshGeometryOOBBTest, "NVSceneCapturer.MeshGeometry.OOBB", NV_UNIT_TEST_FLAGS)
+bool FNVMeshGeometryOOBBTest::RunTest(const FString& Parameters)
+{
+    const FVector BoxExtent(150.f, 40.f, 15.f);
+    const FTransform BoxTransform(FRotator(20.f, 35.f, -50.f), FVector(-30.f, 80.f, 10.f));
+    const TArray<FVector> Vertexes = MakeBoxVertexes(BoxExtent, BoxTransform, 300, 44);
+
+    // The bounds in the box's own frame are the box
+    const FMatrix BoxFrame = BoxTransform.ToMatrixNoScale();
+    const FBox BoxFrameBounds = FNVMeshGeometryMath::CalculateBoundsInFrame(Vertexes, BoxFrame);
+    TestTrue(TEXT("The bounds in the box's frame are the box"), BoxFrameBounds.Min.Equals(-BoxExtent, 1.e-2f) && BoxFrameBounds.Max.Equals(BoxExtent, 1.e-2f));
+
+    // The bounds in the PCA frame are tight: each of their faces touch a vertex, and much smaller than the axis aligned bounds
+    const FMatrix PCAMatrix = FNVMeshGeometryMath::CalculatePCA(Vertexes);
+    const FBox PCABounds = FNVMeshGeometryMath::CalculateBoundsInFrame(Vertexes, PCAMatrix);
+    TestTrue(TEXT("The PCA bounds are valid"), PCABounds.IsValid != 0);
+    TestEqual(TEXT("The PCA bounds' length is the box's length"), PCABounds.GetSize().Z, BoxExtent.X * 2.f, 1.f);
+
+    const FVector AxisX = PCAMatrix.GetUnitAxis(EAxis::X);
+    const FVector AxisY = PCAMatrix.GetUnitAxis(EAxis::Y);
+    const FVector AxisZ = PCAMatrix.GetUnitAxis(EAxis::Z);
+    int32 TouchedFaceCount = 0;
+    for (int32 Axis = 0; Axis < 3; Axis++)
+    {
+        bool bTouchMin = false;
+        bool bTouchMax = false;
+        for (const FVector& Vertex : Vertexes)
+        {
+            const FVector Offset = Vertex - PCAMatrix.GetOrigin();
+            const FVector FramePosition(Offset | AxisX, Offset | AxisY, Offset | AxisZ);
+            TestTrue(TEXT("The vertexes are inside of the PCA bounds"), PCABounds.ExpandBy(1.e-2f).IsInside(FramePosition));
+            bTouchMin |= FMath::IsNearlyEqual(FramePosition[Axis], PCABounds.Min[Axis], 1.e-2);
+            bTouchMax |= FMath::IsNearlyEqual(FramePosition[Axis], PCABounds.Max[Axis], 1.e-2);
+        }
+        TouchedFaceCount += (bTouchMin ? 1 : 0) + (bTouchMax ? 1 : 0);
+    }
+    TestEqual(TEXT("All the faces of the PCA bounds touch a vertex"), TouchedFaceCount, 6);
+
+    const double PCAVolume = PCABounds.GetVolume();
+    const double AxisAlignedVolume = FBox(Vertexes).GetVolume();
+    TestTrue(TEXT("The PCA bounds are tighter than the axis aligned ones"), PCAVolume < AxisAlignedVolume);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshGeometryHullTest, "NVSceneCapturer.MeshGeometry.Hull", NV_UNIT_TEST_FLAGS)
+bool FNVMeshGeometryHullTest::RunTest(const FString& Parameters)
+{
+    const FVector BoxExtent(50.f, 50.f, 50.f);
+    const TArray<FVector> Vertexes = MakeBoxVertexes(BoxExtent, FTransform::Identity, 1000, 3);
+
+    // Only the corners of the box are the furthest along any direction
+    TArray<FVector> HullVertexes;
+    FNVMeshGeometryMath::CalculateHullVertexes(Vertexes, 64, HullVertexes);
+    TestEqual(TEXT("The hull is the corners of the box"), HullVertexes.Num(), 8);
+    for (const FVector& HullVertex : HullVertexes)
+    {
+        TestTrue(TEXT("A hull vertex is a corner"), HullVertex.GetAbs().Equals(BoxExtent, 1.e-3f));
+    }
+    TestTrue(TEXT("The hull has the same bounds as the vertexes"), FBox(HullVertexes).Equals(FBox(Vertexes), 1.e-3f));
+
+    // The hull keep at most one vertex per direction, whatever the order of the vertexes
+    FNVMeshGeometryMath::CalculateHullVertexes(Vertexes, 4, HullVertexes);
+    TestTrue(TEXT("The hull has at most one vertex per direction"), HullVertexes.Num() <= 4);
+    TArray<FVector> ReversedVertexes = Vertexes;
+    Algo::Reverse(ReversedVertexes);
+    TArray<FVector> ReversedHullVertexes;
+    FNVMeshGeometryMath::CalculateHullVertexes(ReversedVertexes, 64, ReversedHullVertexes);
+    TestEqual(TEXT("The hull doesn't depend on the order of the vertexes"), ReversedHullVertexes.Num(), 8);
+
+    FNVMeshGeometryMath::CalculateHullVertexes(TArray<FVector>(), 64, HullVertexes);
+    TestEqual(TEXT("No vertex, no hull"), HullVertexes.Num(), 0);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshGeometryBuildTest, "NVSceneCapturer.MeshGeometry.Build", NV_UNIT_TEST_FLAGS)
+bool FNVMeshGeometryBuildTest::RunTest(const FString& Parameters)
+{
+    const FTransform BoxTransform(FRotator(10.f, 70.f, 0.f), FVector(5.f, 5.f, 5.f));
+    const TArray<FVector> RenderVertexes = MakeBoxVertexes(FVector(120.f, 20.f, 20.f), BoxTransform, 200, 11);
+    const TArray<FVector> CollisionVertexes = MakeBoxVertexes(FVector(125.f, 25.f, 25.f), BoxTransform, 0, 12);
+
+    FNVMeshGeometryData GeometryData;
+    FNVMeshGeometryMath::BuildMeshGeometry(RenderVertexes, CollisionVertexes, GeometryData);
+    TestTrue(TEXT("The geometry is valid"), GeometryData.IsValid());
+    TestEqual(TEXT("The vertexes are counted"), GeometryData.VertexCount, RenderVertexes.Num());
+    TestTrue(TEXT("The render bounds are the render vertexes' bounds"), GeometryData.RenderBounds.Equals(FBox(RenderVertexes)));
+    TestTrue(TEXT("The collision bounds are the collision vertexes' bounds"), GeometryData.CollisionBounds.Equals(FBox(CollisionVertexes)));
+    TestTrue(TEXT("The stored PCA frame is the PCA of the render vertexes"), GeometryData.GetPCAMatrix().Equals(FNVMeshGeometryMath::CalculatePCA(RenderVertexes), 1.e-4f));
+    TestTrue(TEXT("The hull is decimated"), (GeometryData.HullVertexes.Num() > 0) && (GeometryData.HullVertexes.Num() <= 64));
+
+    // A mesh without render vertexes use its collision
+    FNVMeshGeometryData CollisionGeometryData;
+    FNVMeshGeometryMath::BuildMeshGeometry(TArray<FVector>(), CollisionVertexes, CollisionGeometryData);
+    TestFalse(TEXT("A mesh without render vertex isn't valid"), CollisionGeometryData.IsValid());
+    TestTrue(TEXT("The PCA use the collision vertexes"), CollisionGeometryData.GetPCAMatrix().Equals(FNVMeshGeometryMath::CalculatePCA(CollisionVertexes), 1.e-4f));
+    TestEqual(TEXT("The hull use the collision vertexes"), CollisionGeometryData.HullVertexes.Num(), CollisionVertexes.Num());
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
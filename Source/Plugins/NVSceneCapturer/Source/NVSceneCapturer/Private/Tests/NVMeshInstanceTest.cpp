@@ -0,0 +1,217 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVSceneCapturerUtils.h"
+#include "NVMeshGeometry.h"
+#include "Engine/StaticMesh.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    template <typename ComponentType>
+    ComponentType* AddInstancedMeshComponent(AActor* OwnerActor, UStaticMesh* StaticMesh, const TCHAR* ComponentName, int32 InstanceCount, FRandomStream& RandomStream)
+    {
+        ComponentType* InstancedMeshComp = NewObject<ComponentType>(OwnerActor, ComponentName);
+        InstancedMeshComp->SetMobility(EComponentMobility::Movable);
+        InstancedMeshComp->SetStaticMesh(StaticMesh);
+        if (OwnerActor->GetRootComponent())
+        {
+            InstancedMeshComp->SetupAttachment(OwnerActor->GetRootComponent());
+        }
+        else
+        {
+            OwnerActor->SetRootComponent(InstancedMeshComp);
+        }
+        OwnerActor->AddInstanceComponent(InstancedMeshComp);
+        InstancedMeshComp->RegisterComponent();
+
+        for (int32 InstanceIndex = 0; InstanceIndex < InstanceCount; InstanceIndex++)
+        {
+            const FRotator Rotation(RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f));
+            const FVector Location(RandomStream.FRandRange(-500.f, 500.f), RandomStream.FRandRange(-500.f, 500.f), RandomStream.FRandRange(-500.f, 500.f));
+            InstancedMeshComp->AddInstance(FTransform(Rotation, Location, FVector(RandomStream.FRandRange(0.5f, 2.f))));
+        }
+        return InstancedMeshComp;
+    }
+
+    /// An actor whose instances are exported: a visible ISM, a visible HISM, a hidden ISM and an ISM without instance
+    AActor* SpawnInstancedMeshActor(UWorld* World, UStaticMesh* StaticMesh, FRandomStream& RandomStream)
+    {
+        AActor* MeshActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FRotator(0.f, 45.f, 0.f), FVector(1000.f, 200.f, 0.f)));
+        if (!MeshActor)
+        {
+            return nullptr;
+        }
+
+        AddInstancedMeshComponent<UInstancedStaticMeshComponent>(MeshActor, StaticMesh, TEXT("Rocks"), 12, RandomStream);
+        AddInstancedMeshComponent<UHierarchicalInstancedStaticMeshComponent>(MeshActor, StaticMesh, TEXT("Trees"), 30, RandomStream);
+        AddInstancedMeshComponent<UInstancedStaticMeshComponent>(MeshActor, StaticMesh, TEXT("Hidden"), 5, RandomStream)->SetVisibility(false);
+        AddInstancedMeshComponent<UInstancedStaticMeshComponent>(MeshActor, StaticMesh, TEXT("Empty"), 0, RandomStream);
+
+        UNVCapturableActorTag* CapturableTag = NewObject<UNVCapturableActorTag>(MeshActor);
+        MeshActor->AddInstanceComponent(CapturableTag);
+        CapturableTag->RegisterComponent();
+        return MeshActor;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshInstanceEnumerationTest, "NVSceneCapturer.MeshInstances.Enumeration", NV_UNIT_TEST_FLAGS)
+bool FNVMeshInstanceEnumerationTest::RunTest(const FString& Parameters)
+{
+    UStaticMesh* CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+    if (!CubeMesh)
+    {
+        AddWarning(TEXT("The engine's basic shapes can't be loaded, the test is skipped"));
+        return true;
+    }
+
+    NVSceneCapturerTest::FScopedTestWorld TestWorld;
+    FRandomStream RandomStream(47);
+    AActor* MeshActor = SpawnInstancedMeshActor(TestWorld.World, CubeMesh, RandomStream);
+    if (!TestNotNull(TEXT("The instanced mesh actor is spawned"), MeshActor))
+    {
+        return false;
+    }
+
+    // Only the visible components with some instances are exported, the hierarchical ones included
+    TArray<UInstancedStaticMeshComponent*> InstancedMeshComps;
+    NVSceneCapturerUtils::GetExportedMeshInstanceComponents(MeshActor, InstancedMeshComps);
+    TestEqual(TEXT("The visible components with instances are exported"), InstancedMeshComps.Num(), 2);
+    int32 InstanceCount = 0;
+    TSet<FString> InstanceNames;
+    for (const UInstancedStaticMeshComponent* InstancedMeshComp : InstancedMeshComps)
+    {
+        TestTrue(TEXT("The exported component is visible"), InstancedMeshComp->IsVisible());
+        for (int32 InstanceIndex = 0; InstanceIndex < InstancedMeshComp->GetInstanceCount(); InstanceIndex++)
+        {
+            InstanceNames.Add(NVSceneCapturerUtils::GetMeshInstanceName(MeshActor, InstancedMeshComp, InstanceIndex));
+            InstanceCount++;
+        }
+    }
+    TestEqual(TEXT("All the instances are enumerated"), InstanceCount, 12 + 30);
+    TestEqual(TEXT("Each instance has its own name"), InstanceNames.Num(), InstanceCount);
+    TestTrue(TEXT("The instance name is made of the actor, the component and the index"),
+             InstanceNames.Contains(FString::Printf(TEXT("%s.Trees_29"), *MeshActor->GetName())));
+
+    // The instances are exported only when the tag ask for it
+    MeshActor->FindComponentByClass<UNVCapturableActorTag>()->bExportMeshInstances = false;
+    NVSceneCapturerUtils::GetExportedMeshInstanceComponents(MeshActor, InstancedMeshComps);
+    TestEqual(TEXT("No instance is exported when the tag disable it"), InstancedMeshComps.Num(), 0);
+    NVSceneCapturerUtils::GetExportedMeshInstanceComponents(nullptr, InstancedMeshComps);
+    TestEqual(TEXT("No actor has no instance"), InstancedMeshComps.Num(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshInstanceCuboidTest, "NVSceneCapturer.MeshInstances.Cuboid", NV_UNIT_TEST_FLAGS)
+bool FNVMeshInstanceCuboidTest::RunTest(const FString& Parameters)
+{
+    UStaticMesh* CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+    const FNVMeshGeometryData* MeshGeometry = CubeMesh ? FNVMeshGeometryCache::FindOrBuild(CubeMesh) : nullptr;
+    if (!MeshGeometry)
+    {
+        AddWarning(TEXT("The engine's basic shapes can't be loaded, the test is skipped"));
+        return true;
+    }
+
+    NVSceneCapturerTest::FScopedTestWorld TestWorld;
+    FRandomStream RandomStream(470);
+    AActor* MeshActor = SpawnInstancedMeshActor(TestWorld.World, CubeMesh, RandomStream);
+    if (!TestNotNull(TEXT("The instanced mesh actor is spawned"), MeshActor))
+    {
+        return false;
+    }
+
+    TArray<UInstancedStaticMeshComponent*> InstancedMeshComps;
+    NVSceneCapturerUtils::GetExportedMeshInstanceComponents(MeshActor, InstancedMeshComps);
+    for (const UInstancedStaticMeshComponent* InstancedMeshComp : InstancedMeshComps)
+    {
+        for (int32 InstanceIndex = 0; InstanceIndex < InstancedMeshComp->GetInstanceCount(); InstanceIndex++)
+        {
+            FTransform InstanceTransform;
+            InstancedMeshComp->GetInstanceTransform(InstanceIndex, InstanceTransform, true);
+            const FString InstanceName = NVSceneCapturerUtils::GetMeshInstanceName(MeshActor, InstancedMeshComp, InstanceIndex);
+
+            // The instance's cuboid is the mesh's one placed at the instance transform
+            const FNVCuboidData ExpectedCuboid(MeshGeometry->RenderBounds, InstanceTransform);
+            const FNVCuboidData InstanceCuboid = NVSceneCapturerUtils::GetMeshInstanceCuboid(*MeshGeometry, InstanceTransform, ENVBoundsGenerationType::VE_OOBB);
+            bool bSameVertexes = (InstanceCuboid.Vertexes.Num() == ExpectedCuboid.Vertexes.Num());
+            for (int32 VertexIndex = 0; bSameVertexes && (VertexIndex < InstanceCuboid.Vertexes.Num()); VertexIndex++)
+            {
+                bSameVertexes = InstanceCuboid.Vertexes[VertexIndex].Equals(ExpectedCuboid.Vertexes[VertexIndex], 1.e-3f);
+            }
+            TestTrue(FString::Printf(TEXT("%s: OOBB at the instance transform"), *InstanceName), bSameVertexes);
+
+            const FBox InstanceAABB = MeshGeometry->RenderBounds.TransformBy(InstanceTransform);
+            const FNVCuboidData AABBCuboid = NVSceneCapturerUtils::GetMeshInstanceCuboid(*MeshGeometry, InstanceTransform, ENVBoundsGenerationType::VE_AABB);
+            TestTrue(FString::Printf(TEXT("%s: AABB of the instance"), *InstanceName),
+                     AABBCuboid.GetCenter().Equals(InstanceAABB.GetCenter(), 1.e-3f) && AABBCuboid.GetDimension().Equals(InstanceAABB.GetSize(), 1.e-3f));
+
+            const FNVCuboidData TightCuboid = NVSceneCapturerUtils::GetMeshInstanceCuboid(*MeshGeometry, InstanceTransform, ENVBoundsGenerationType::VE_TightOOBB);
+            TestTrue(FString::Printf(TEXT("%s: tight OOBB around the same center"), *InstanceName),
+                     TightCuboid.GetCenter().Equals(ExpectedCuboid.GetCenter(), 1.f));
+        }
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshInstanceMaskColorTest, "NVSceneCapturer.MeshInstances.MaskColor", NV_UNIT_TEST_FLAGS)
+bool FNVMeshInstanceMaskColorTest::RunTest(const FString& Parameters)
+{
+    UStaticMesh* CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+    if (!CubeMesh)
+    {
+        AddWarning(TEXT("The engine's basic shapes can't be loaded, the test is skipped"));
+        return true;
+    }
+
+    NVSceneCapturerTest::FScopedTestWorld TestWorld;
+    FRandomStream RandomStream(4700);
+    AActor* MeshActor = SpawnInstancedMeshActor(TestWorld.World, CubeMesh, RandomStream);
+    if (!TestNotNull(TEXT("The instanced mesh actor is spawned"), MeshActor))
+    {
+        return false;
+    }
+
+    TArray<UInstancedStaticMeshComponent*> InstancedMeshComps;
+    NVSceneCapturerUtils::GetExportedMeshInstanceComponents(MeshActor, InstancedMeshComps);
+    UInstancedStaticMeshComponent* InstancedMeshComp = InstancedMeshComps.Num() > 0 ? InstancedMeshComps[0] : nullptr;
+    if (!TestNotNull(TEXT("The actor has an exported component"), InstancedMeshComp))
+    {
+        return false;
+    }
+
+    // The user's custom data layout is never resized, nothing is written when it's too small
+    const FColor MaskColor(0x12, 0x34, 0x56);
+    TestFalse(TEXT("No color is written without custom data"), NVSceneCapturerUtils::SetMeshInstanceMaskColor(InstancedMeshComp, 0, 0, MaskColor));
+    TestEqual(TEXT("The custom data isn't added"), InstancedMeshComp->NumCustomDataFloats, 0);
+
+    InstancedMeshComp->SetNumCustomDataFloats(5);
+    const TArray<float> UserCustomData = InstancedMeshComp->PerInstanceSMCustomData;
+    TestFalse(TEXT("No color is written past the custom data"), NVSceneCapturerUtils::SetMeshInstanceMaskColor(InstancedMeshComp, 0, 3, MaskColor));
+    TestEqual(TEXT("The custom data isn't grown"), InstancedMeshComp->NumCustomDataFloats, 5);
+    TestTrue(TEXT("The custom data isn't changed"), InstancedMeshComp->PerInstanceSMCustomData == UserCustomData);
+
+    // The color fits in the last 3 floats, the user's first 2 floats are kept
+    const int32 InstanceIndex = 4;
+    InstancedMeshComp->SetCustomDataValue(InstanceIndex, 0, 7.f);
+    InstancedMeshComp->SetCustomDataValue(InstanceIndex, 1, 8.f);
+    TestTrue(TEXT("The color is written in the custom data"), NVSceneCapturerUtils::SetMeshInstanceMaskColor(InstancedMeshComp, InstanceIndex, 2, MaskColor));
+    const float* InstanceCustomData = InstancedMeshComp->PerInstanceSMCustomData.GetData() + InstanceIndex * 5;
+    TestEqual(TEXT("The user's first float is kept"), InstanceCustomData[0], 7.f);
+    TestEqual(TEXT("The user's second float is kept"), InstanceCustomData[1], 8.f);
+    TestEqual(TEXT("Red"), InstanceCustomData[2], 0x12 / 255.f);
+    TestEqual(TEXT("Green"), InstanceCustomData[3], 0x34 / 255.f);
+    TestEqual(TEXT("Blue"), InstanceCustomData[4], 0x56 / 255.f);
+    TestEqual(TEXT("The other instances aren't changed"), InstancedMeshComp->PerInstanceSMCustomData[2], 0.f);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
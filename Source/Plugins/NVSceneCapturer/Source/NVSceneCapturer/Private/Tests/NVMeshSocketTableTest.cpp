@@ -0,0 +1,190 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVMeshSocketTable.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshSocket.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "Animation/SkeletalMeshActor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// The exported sockets of a mesh component found by their names, the way they were gathered before the socket tables
+    void GatherSocketsByName(const UMeshComponent* MeshComp, bool bExportAllSockets, const TArray<FName>& ExportSocketNames,
+                             TArray<FString>& OutSocketNames, TArray<FVector>& OutWorldLocations)
+    {
+        for (const FName SocketName : MeshComp->GetAllSocketNames())
+        {
+            if (bExportAllSockets || ExportSocketNames.Contains(SocketName))
+            {
+                OutSocketNames.Add(SocketName.ToString());
+                OutWorldLocations.Add(MeshComp->GetSocketLocation(SocketName));
+            }
+        }
+    }
+
+    /// Compare the sockets resolved by a socket table with the ones found by their names
+    void TestSocketTableEquivalence(FAutomationTestBase& Test, const FString& What, const UMeshComponent* MeshComp,
+                                    bool bExportAllSockets, const TArray<FName>& ExportSocketNames)
+    {
+        TArray<FString> ExpectedSocketNames;
+        TArray<FVector> ExpectedWorldLocations;
+        GatherSocketsByName(MeshComp, bExportAllSockets, ExportSocketNames, ExpectedSocketNames, ExpectedWorldLocations);
+
+        const FNVMeshSocketTablePtr SocketTable = FNVMeshSocketTableCache::FindOrBuild(MeshComp, bExportAllSockets, ExportSocketNames);
+        if (!Test.TestTrue(FString::Printf(TEXT("%s: the mesh has a socket table"), *What), SocketTable.IsValid()))
+        {
+            return;
+        }
+
+        TArray<FString> SocketNames;
+        for (const FNVMeshSocketTableEntry& SocketEntry : SocketTable->Entries)
+        {
+            SocketNames.Add(SocketEntry.SocketName);
+        }
+        TArray<FVector> WorldLocations;
+        FNVMeshSocketTableCache::GatherSocketWorldLocations(MeshComp, *SocketTable, WorldLocations);
+
+        Test.TestEqual(FString::Printf(TEXT("%s: same sockets in the same order"), *What), FString::Join(SocketNames, TEXT(",")), FString::Join(ExpectedSocketNames, TEXT(",")));
+        if (Test.TestEqual(FString::Printf(TEXT("%s: a location per socket"), *What), WorldLocations.Num(), ExpectedWorldLocations.Num()))
+        {
+            for (int32 SocketIndex = 0; SocketIndex < WorldLocations.Num(); SocketIndex++)
+            {
+                Test.TestTrue(FString::Printf(TEXT("%s: socket %s is at the same location"), *What, *ExpectedSocketNames[SocketIndex]),
+                              WorldLocations[SocketIndex].Equals(ExpectedWorldLocations[SocketIndex], 1.e-3f));
+            }
+        }
+    }
+
+    UStaticMeshSocket* AddStaticMeshSocket(UStaticMesh* StaticMesh, const TCHAR* SocketName, const FVector& RelativeLocation, const FRotator& RelativeRotation, const FVector& RelativeScale)
+    {
+        UStaticMeshSocket* Socket = NewObject<UStaticMeshSocket>(StaticMesh);
+        Socket->SocketName = SocketName;
+        Socket->RelativeLocation = RelativeLocation;
+        Socket->RelativeRotation = RelativeRotation;
+        Socket->RelativeScale = RelativeScale;
+        StaticMesh->AddSocket(Socket);
+        return Socket;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshSocketTableStaticMeshTest, "NVSceneCapturer.MeshSocketTable.StaticMesh", NV_UNIT_TEST_FLAGS)
+bool FNVMeshSocketTableStaticMeshTest::RunTest(const FString& Parameters)
+{
+    FNVMeshSocketTableCache::Reset();
+
+    // NOTE: A transient mesh, the sockets don't need any render data
+    UStaticMesh* StaticMesh = NewObject<UStaticMesh>(GetTransientPackage());
+    AddStaticMeshSocket(StaticMesh, TEXT("Muzzle"), FVector(80.f, 0.f, 10.f), FRotator(0.f, 15.f, 0.f), FVector(1.f));
+    AddStaticMeshSocket(StaticMesh, TEXT("Grip"), FVector(-20.f, 5.f, -15.f), FRotator(30.f, 0.f, 45.f), FVector(2.f, 1.f, 0.5f));
+    AddStaticMeshSocket(StaticMesh, TEXT("Sight"), FVector(10.f, 0.f, 20.f), FRotator::ZeroRotator, FVector(1.f));
+
+    UStaticMeshComponent* MeshComp = NewObject<UStaticMeshComponent>(GetTransientPackage());
+    MeshComp->SetMobility(EComponentMobility::Movable);
+    MeshComp->SetStaticMesh(StaticMesh);
+
+    const TArray<FName> ExportSocketNames = { TEXT("Sight"), TEXT("Muzzle"), TEXT("NotASocket") };
+    FRandomStream RandomStream(46);
+    for (int32 PoseIndex = 0; PoseIndex < 10; PoseIndex++)
+    {
+        const FRotator Rotation(RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f));
+        const FVector Location(RandomStream.FRandRange(-1000.f, 1000.f), RandomStream.FRandRange(-1000.f, 1000.f), RandomStream.FRandRange(-1000.f, 1000.f));
+        const FVector Scale(RandomStream.FRandRange(0.5f, 2.f), RandomStream.FRandRange(0.5f, 2.f), RandomStream.FRandRange(0.5f, 2.f));
+        MeshComp->SetWorldTransform(FTransform(Rotation, Location, Scale));
+
+        TestSocketTableEquivalence(*this, FString::Printf(TEXT("Pose %d, all the sockets"), PoseIndex), MeshComp, true, {});
+        TestSocketTableEquivalence(*this, FString::Printf(TEXT("Pose %d, the listed sockets"), PoseIndex), MeshComp, false, ExportSocketNames);
+    }
+
+    // The tables are shared by the components of the same mesh and the same socket filter
+    const FNVMeshSocketTablePtr AllSocketTable = FNVMeshSocketTableCache::FindOrBuild(MeshComp, true, {});
+    TestTrue(TEXT("The table of the mesh is reused"), AllSocketTable == FNVMeshSocketTableCache::FindOrBuild(MeshComp, true, {}));
+    TestTrue(TEXT("Another socket filter has its own table"), AllSocketTable != FNVMeshSocketTableCache::FindOrBuild(MeshComp, false, ExportSocketNames));
+
+    // Adding a socket rebuild the table, without changing the table the previous frames are using
+    AddStaticMeshSocket(StaticMesh, TEXT("Scope"), FVector(0.f, 0.f, 30.f), FRotator::ZeroRotator, FVector(1.f));
+    const FNVMeshSocketTablePtr RebuiltSocketTable = FNVMeshSocketTableCache::FindOrBuild(MeshComp, true, {});
+    TestTrue(TEXT("The table is rebuilt when a socket is added"), RebuiltSocketTable != AllSocketTable);
+    TestEqual(TEXT("The previous table is untouched"), AllSocketTable->Entries.Num(), 3);
+    TestSocketTableEquivalence(*this, TEXT("After adding a socket"), MeshComp, true, {});
+
+    // The components without a supported mesh fall back to the name lookup
+    MeshComp->SetStaticMesh(nullptr);
+    TestFalse(TEXT("A component without mesh has no table"), FNVMeshSocketTableCache::FindOrBuild(MeshComp, true, {}).IsValid());
+    TestFalse(TEXT("No component has no table"), FNVMeshSocketTableCache::FindOrBuild(nullptr, true, {}).IsValid());
+
+    FNVMeshSocketTableCache::Reset();
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVMeshSocketTableSkeletalMeshTest, "NVSceneCapturer.MeshSocketTable.SkeletalMesh", NV_UNIT_TEST_FLAGS)
+bool FNVMeshSocketTableSkeletalMeshTest::RunTest(const FString& Parameters)
+{
+    USkeletalMesh* SkeletalMesh = LoadObject<USkeletalMesh>(nullptr, TEXT("/Engine/EngineMeshes/SkeletalCube.SkeletalCube"));
+    if (!SkeletalMesh || (SkeletalMesh->GetRefSkeleton().GetNum() == 0))
+    {
+        AddWarning(TEXT("The engine's skeletal cube can't be loaded, the test is skipped"));
+        return true;
+    }
+
+    FNVMeshSocketTableCache::Reset();
+    NVSceneCapturerTest::FScopedTestWorld TestWorld;
+
+    // NOTE: The sockets are only added for the test: one attached to a bone and one with the same name as a bone, it must win over the bone
+    const FReferenceSkeleton& RefSkeleton = SkeletalMesh->GetRefSkeleton();
+    const FName LastBoneName = RefSkeleton.GetBoneName(RefSkeleton.GetNum() - 1);
+
+    USkeletalMeshSocket* OffsetSocket = NewObject<USkeletalMeshSocket>(SkeletalMesh);
+    OffsetSocket->SocketName = TEXT("NVTestSocket");
+    OffsetSocket->BoneName = LastBoneName;
+    OffsetSocket->RelativeLocation = FVector(12.f, -4.f, 30.f);
+    OffsetSocket->RelativeRotation = FRotator(10.f, 20.f, 30.f);
+
+    USkeletalMeshSocket* BoneNameSocket = NewObject<USkeletalMeshSocket>(SkeletalMesh);
+    BoneNameSocket->SocketName = RefSkeleton.GetBoneName(0);
+    BoneNameSocket->BoneName = LastBoneName;
+    BoneNameSocket->RelativeLocation = FVector(0.f, 25.f, 0.f);
+
+    SkeletalMesh->AddSocket(OffsetSocket);
+    SkeletalMesh->AddSocket(BoneNameSocket);
+
+    ASkeletalMeshActor* MeshActor = TestWorld.World->SpawnActor<ASkeletalMeshActor>(ASkeletalMeshActor::StaticClass(), FTransform::Identity);
+    USkeletalMeshComponent* MeshComp = MeshActor ? MeshActor->GetSkeletalMeshComponent() : nullptr;
+    if (TestNotNull(TEXT("The skeletal mesh actor is spawned"), MeshComp))
+    {
+        MeshComp->SetMobility(EComponentMobility::Movable);
+        MeshComp->SetSkeletalMeshAsset(SkeletalMesh);
+
+        const TArray<FName> ExportSocketNames = { TEXT("NVTestSocket"), RefSkeleton.GetBoneName(0), LastBoneName };
+        FRandomStream RandomStream(460);
+        for (int32 PoseIndex = 0; PoseIndex < 10; PoseIndex++)
+        {
+            const FRotator Rotation(RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f));
+            const FVector Location(RandomStream.FRandRange(-1000.f, 1000.f), RandomStream.FRandRange(-1000.f, 1000.f), RandomStream.FRandRange(-1000.f, 1000.f));
+            MeshActor->SetActorTransform(FTransform(Rotation, Location, FVector(RandomStream.FRandRange(0.5f, 2.f))));
+
+            TestSocketTableEquivalence(*this, FString::Printf(TEXT("Pose %d, all the sockets and bones"), PoseIndex), MeshComp, true, {});
+            TestSocketTableEquivalence(*this, FString::Printf(TEXT("Pose %d, the listed sockets"), PoseIndex), MeshComp, false, ExportSocketNames);
+        }
+    }
+
+    // Restore the engine's mesh
+    SkeletalMesh->GetMeshOnlySocketList().Remove(OffsetSocket);
+    SkeletalMesh->GetMeshOnlySocketList().Remove(BoneNameSocket);
+    SkeletalMesh->RebuildSocketMap();
+
+    FNVMeshSocketTableCache::Reset();
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
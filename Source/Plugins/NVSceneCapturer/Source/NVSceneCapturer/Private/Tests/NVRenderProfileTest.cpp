@@ -0,0 +1,207 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVRenderProfile.h"
+#include "NVSceneFeatureExtractor_ImageExport.h"
+#include "Components/SceneCaptureComponent2D.h"
+#include "ShowFlags.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    typedef TPair<const TCHAR*, bool> FExpectedShowFlag;
+
+    bool GetShowFlag(const FEngineShowFlags& ShowFlags, const TCHAR* ShowFlagName)
+    {
+        const int32 ShowFlagIndex = FEngineShowFlags::FindIndexByName(ShowFlagName);
+        return (ShowFlagIndex != INDEX_NONE) && ShowFlags.GetSingleFlag(ShowFlagIndex);
+    }
+
+    /// Every show flag of a set by name, e.g: "Lighting" -> true
+    TMap<FString, bool> GetShowFlagValues(const FEngineShowFlags& ShowFlags)
+    {
+        // NOTE: The show flags are formatted as "Name=0,Name=1,..."
+        TArray<FString> ShowFlagStrings;
+        ShowFlags.ToString().ParseIntoArray(ShowFlagStrings, TEXT(","));
+        TMap<FString, bool> ShowFlagValues;
+        for (const FString& ShowFlagString : ShowFlagStrings)
+        {
+            FString ShowFlagName, ShowFlagValue;
+            if (ShowFlagString.Split(TEXT("="), &ShowFlagName, &ShowFlagValue))
+            {
+                ShowFlagValues.Add(ShowFlagName, ShowFlagValue != TEXT("0"));
+            }
+        }
+        return ShowFlagValues;
+    }
+
+    /// The show flags of a profile: the game defaults with the profile applied on top
+    FEngineShowFlags MakeProfileShowFlags(const FNVRenderProfile& RenderProfile)
+    {
+        FEngineShowFlags ShowFlags(EShowFlagInitMode::ESFIM_Game);
+        RenderProfile.ApplyToShowFlags(ShowFlags);
+        return ShowFlags;
+    }
+
+    /// Check the profile turn the expected show flags on or off, and only touch the show flags its settings list
+    void TestProfileShowFlags(FAutomationTestBase& Test, const FString& ProfileName, const FNVRenderProfile& RenderProfile, const TArray<FExpectedShowFlag>& ExpectedShowFlags)
+    {
+        const FEngineShowFlags DefaultShowFlags(EShowFlagInitMode::ESFIM_Game);
+        const FEngineShowFlags ProfileShowFlags = MakeProfileShowFlags(RenderProfile);
+
+        for (const FExpectedShowFlag& ExpectedShowFlag : ExpectedShowFlags)
+        {
+            Test.TestTrue(FString::Printf(TEXT("%s: show flag %s is %s"), *ProfileName, ExpectedShowFlag.Key, ExpectedShowFlag.Value ? TEXT("on") : TEXT("off")),
+                          GetShowFlag(ProfileShowFlags, ExpectedShowFlag.Key) == ExpectedShowFlag.Value);
+        }
+
+        TArray<FEngineShowFlagsSetting> ShowFlagSettings;
+        RenderProfile.BuildShowFlagSettings(ShowFlagSettings);
+        TSet<FString> SetShowFlagNames;
+        for (const FEngineShowFlagsSetting& ShowFlagSetting : ShowFlagSettings)
+        {
+            Test.TestTrue(FString::Printf(TEXT("%s: the show flag %s exists"), *ProfileName, *ShowFlagSetting.ShowFlagName),
+                          FEngineShowFlags::FindIndexByName(*ShowFlagSetting.ShowFlagName) != INDEX_NONE);
+            SetShowFlagNames.Add(ShowFlagSetting.ShowFlagName);
+        }
+
+        const TMap<FString, bool> DefaultShowFlagValues = GetShowFlagValues(DefaultShowFlags);
+        TArray<FString> ChangedShowFlagNames;
+        for (const TPair<FString, bool>& ProfileShowFlagValue : GetShowFlagValues(ProfileShowFlags))
+        {
+            const bool* DefaultShowFlagValue = DefaultShowFlagValues.Find(ProfileShowFlagValue.Key);
+            if (!SetShowFlagNames.Contains(ProfileShowFlagValue.Key) && (!DefaultShowFlagValue || (*DefaultShowFlagValue != ProfileShowFlagValue.Value)))
+            {
+                ChangedShowFlagNames.Add(ProfileShowFlagValue.Key);
+            }
+        }
+        Test.TestTrue(FString::Printf(TEXT("%s: the show flags are read"), *ProfileName), DefaultShowFlagValues.Num() > 0);
+        Test.TestEqual(FString::Printf(TEXT("%s: the other show flags keep their game defaults"), *ProfileName), FString::Join(ChangedShowFlagNames, TEXT(",")), FString());
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVRenderProfilePresetsTest, "NVSceneCapturer.RenderProfile.Presets", NV_UNIT_TEST_FLAGS)
+bool FNVRenderProfilePresetsTest::RunTest(const FString& Parameters)
+{
+    TArray<FEngineShowFlagsSetting> ShowFlagSettings;
+    FNVRenderProfile::GetPresetShowFlagSettings(ENVRenderProfilePreset::FullLighting, ShowFlagSettings);
+    TestEqual(TEXT("The full lighting keep the whole pipeline"), ShowFlagSettings.Num(), 0);
+    TestProfileShowFlags(*this, TEXT("Full lighting"), FNVRenderProfile(ENVRenderProfilePreset::FullLighting),
+    {
+        FExpectedShowFlag(TEXT("Lighting"), true),
+        FExpectedShowFlag(TEXT("PostProcessing"), true),
+    });
+
+    TestProfileShowFlags(*this, TEXT("Geometry only"), FNVRenderProfile(ENVRenderProfilePreset::GeometryOnly),
+    {
+        FExpectedShowFlag(TEXT("Lighting"), false),
+        FExpectedShowFlag(TEXT("DynamicShadows"), false),
+        FExpectedShowFlag(TEXT("GlobalIllumination"), false),
+        FExpectedShowFlag(TEXT("AmbientOcclusion"), false),
+        FExpectedShowFlag(TEXT("ReflectionEnvironment"), false),
+        FExpectedShowFlag(TEXT("Fog"), false),
+        FExpectedShowFlag(TEXT("Translucency"), false),
+        FExpectedShowFlag(TEXT("Particles"), false),
+        FExpectedShowFlag(TEXT("TemporalAA"), false),
+        FExpectedShowFlag(TEXT("MotionBlur"), false),
+        FExpectedShowFlag(TEXT("Bloom"), false),
+        // The depth and stencil mask are post-process materials
+        FExpectedShowFlag(TEXT("PostProcessing"), true),
+        FExpectedShowFlag(TEXT("PostProcessMaterial"), true),
+        FExpectedShowFlag(TEXT("Materials"), true),
+    });
+
+    TestProfileShowFlags(*this, TEXT("Unlit vertex color"), FNVRenderProfile(ENVRenderProfilePreset::UnlitVertexColor),
+    {
+        FExpectedShowFlag(TEXT("VertexColors"), true),
+        FExpectedShowFlag(TEXT("Materials"), true),
+        FExpectedShowFlag(TEXT("Lighting"), false),
+        FExpectedShowFlag(TEXT("PostProcessing"), false),
+        FExpectedShowFlag(TEXT("Tonemapper"), false),
+        FExpectedShowFlag(TEXT("AntiAliasing"), false),
+    });
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVRenderProfileSettingsTest, "NVSceneCapturer.RenderProfile.Settings", NV_UNIT_TEST_FLAGS)
+bool FNVRenderProfileSettingsTest::RunTest(const FString& Parameters)
+{
+    auto MakeShowFlagSetting = [](const TCHAR* ShowFlagName, bool bEnabled)
+    {
+        FEngineShowFlagsSetting ShowFlagSetting;
+        ShowFlagSetting.ShowFlagName = ShowFlagName;
+        ShowFlagSetting.Enabled = bEnabled;
+        return ShowFlagSetting;
+    };
+
+    // The additional show flags replace the preset's setting of the same show flag
+    FNVRenderProfile RenderProfile(ENVRenderProfilePreset::GeometryOnly);
+    RenderProfile.AdditionalShowFlagSettings.Add(MakeShowFlagSetting(TEXT("MotionBlur"), true));
+    RenderProfile.AdditionalShowFlagSettings.Add(MakeShowFlagSetting(TEXT("Wireframe"), true));
+
+    TArray<FEngineShowFlagsSetting> PresetShowFlagSettings;
+    FNVRenderProfile::GetPresetShowFlagSettings(ENVRenderProfilePreset::GeometryOnly, PresetShowFlagSettings);
+    TArray<FEngineShowFlagsSetting> ShowFlagSettings;
+    RenderProfile.BuildShowFlagSettings(ShowFlagSettings);
+    TestEqual(TEXT("The setting of the same show flag is replaced, the new one is added"), ShowFlagSettings.Num(), PresetShowFlagSettings.Num() + 1);
+    TestProfileShowFlags(*this, TEXT("Geometry only with motion blur"), RenderProfile,
+    {
+        FExpectedShowFlag(TEXT("MotionBlur"), true),
+        FExpectedShowFlag(TEXT("Wireframe"), true),
+        FExpectedShowFlag(TEXT("Lighting"), false),
+    });
+
+    // The unknown show flags are skipped
+    FNVRenderProfile UnknownShowFlagProfile(ENVRenderProfilePreset::FullLighting);
+    UnknownShowFlagProfile.AdditionalShowFlagSettings.Add(MakeShowFlagSetting(TEXT("NotAShowFlag"), false));
+    AddExpectedError(TEXT("NotAShowFlag' doesn't exist"), EAutomationExpectedErrorFlags::Contains, 1);
+    FEngineShowFlags UnknownShowFlags = MakeProfileShowFlags(UnknownShowFlagProfile);
+    TestTrue(TEXT("The unknown show flag doesn't change the others"), GetShowFlag(UnknownShowFlags, TEXT("Lighting")));
+
+    // The scene capture component get the profile merged with its override show flags, the override win
+    USceneCaptureComponent2D* SceneCaptureComponent = NewObject<USceneCaptureComponent2D>(GetTransientPackage());
+    RenderProfile.ApplyToSceneCapture(SceneCaptureComponent, { MakeShowFlagSetting(TEXT("Lighting"), true), MakeShowFlagSetting(TEXT("Fog"), false) });
+    TestTrue(TEXT("The override show flag win"), GetShowFlag(SceneCaptureComponent->ShowFlags, TEXT("Lighting")));
+    TestFalse(TEXT("The profile show flag is applied"), GetShowFlag(SceneCaptureComponent->ShowFlags, TEXT("DynamicShadows")));
+    TestTrue(TEXT("The additional show flag is applied"), GetShowFlag(SceneCaptureComponent->ShowFlags, TEXT("MotionBlur")));
+    TestFalse(TEXT("The override show flag is applied"), GetShowFlag(SceneCaptureComponent->ShowFlags, TEXT("Fog")));
+
+    // The full lighting profile without override keep the component's show flags
+    USceneCaptureComponent2D* FullLightingComponent = NewObject<USceneCaptureComponent2D>(GetTransientPackage());
+    FullLightingComponent->ShowFlags.SetWireframe(true);
+    FNVRenderProfile(ENVRenderProfilePreset::FullLighting).ApplyToSceneCapture(FullLightingComponent, {});
+    TestTrue(TEXT("Nothing is applied without show flag settings"), GetShowFlag(FullLightingComponent->ShowFlags, TEXT("Wireframe")));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVRenderProfileExtractorPresetsTest, "NVSceneCapturer.RenderProfile.ExtractorPresets", NV_UNIT_TEST_FLAGS)
+bool FNVRenderProfileExtractorPresetsTest::RunTest(const FString& Parameters)
+{
+    auto TestExtractorPreset = [this](const TCHAR* ExtractorName, const UNVSceneFeatureExtractor_PixelData* FeatureExtractor, ENVRenderProfilePreset ExpectedPreset)
+    {
+        TestEqual(FString::Printf(TEXT("%s render profile preset"), ExtractorName), (int32)FeatureExtractor->GetRenderProfile().Preset, (int32)ExpectedPreset);
+    };
+
+    TestExtractorPreset(TEXT("Color image"), GetDefault<UNVSceneFeatureExtractor_PixelData>(), ENVRenderProfilePreset::FullLighting);
+    TestExtractorPreset(TEXT("Depth"), GetDefault<UNVSceneFeatureExtractor_SceneDepth>(), ENVRenderProfilePreset::GeometryOnly);
+    TestExtractorPreset(TEXT("Stencil mask"), GetDefault<UNVSceneFeatureExtractor_StencilMask>(), ENVRenderProfilePreset::GeometryOnly);
+    TestExtractorPreset(TEXT("Pixel velocity"), GetDefault<UNVSceneFeatureExtractor_ScenePixelVelocity>(), ENVRenderProfilePreset::GeometryOnly);
+    TestExtractorPreset(TEXT("Vertex color mask"), GetDefault<UNVSceneFeatureExtractor_VertexColorMask>(), ENVRenderProfilePreset::UnlitVertexColor);
+
+    // The velocity buffer is only rendered with the motion blur
+    const FEngineShowFlags VelocityShowFlags = MakeProfileShowFlags(GetDefault<UNVSceneFeatureExtractor_ScenePixelVelocity>()->GetRenderProfile());
+    TestTrue(TEXT("The pixel velocity keep the motion blur"), GetShowFlag(VelocityShowFlags, TEXT("MotionBlur")));
+    TestFalse(TEXT("The pixel velocity isn't lit"), GetShowFlag(VelocityShowFlags, TEXT("Lighting")));
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
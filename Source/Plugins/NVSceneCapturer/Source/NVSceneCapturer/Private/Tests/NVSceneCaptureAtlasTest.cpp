@@ -0,0 +1,169 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVSceneCaptureAtlas.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// Value of each byte of the synthetic atlas buffer, unique enough to catch any offset mistake
+    uint8 GetAtlasByte(int32 X, int32 Y, int32 ByteIndex)
+    {
+        return (uint8)((X * 7 + Y * 13 + ByteIndex * 3) & 0xFF);
+    }
+
+    TArray<uint8> MakeAtlasBuffer(const FIntPoint& AtlasBufferSize, int32 PixelByteSize)
+    {
+        TArray<uint8> AtlasPixels;
+        AtlasPixels.SetNumUninitialized(AtlasBufferSize.X * AtlasBufferSize.Y * PixelByteSize);
+        for (int32 Y = 0; Y < AtlasBufferSize.Y; Y++)
+        {
+            for (int32 X = 0; X < AtlasBufferSize.X; X++)
+            {
+                for (int32 ByteIndex = 0; ByteIndex < PixelByteSize; ByteIndex++)
+                {
+                    AtlasPixels[(Y * AtlasBufferSize.X + X) * PixelByteSize + ByteIndex] = GetAtlasByte(X, Y, ByteIndex);
+                }
+            }
+        }
+        return AtlasPixels;
+    }
+
+    /// Check the pixels data of a tile are the pixels of its region in the atlas
+    bool IsTileSlicedFromAtlas(const FNVTexturePixelData& TilePixelsData, const FIntPoint& TileMin, int32 PixelByteSize)
+    {
+        for (int32 Y = 0; Y < TilePixelsData.PixelSize.Y; Y++)
+        {
+            for (int32 X = 0; X < TilePixelsData.PixelSize.X; X++)
+            {
+                for (int32 ByteIndex = 0; ByteIndex < PixelByteSize; ByteIndex++)
+                {
+                    const uint8 TileByte = TilePixelsData.PixelData[Y * TilePixelsData.RowStride + X * PixelByteSize + ByteIndex];
+                    if (TileByte != GetAtlasByte(TileMin.X + X, TileMin.Y + Y, ByteIndex))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAtlasLayoutTilesTest, "NVSceneCapturer.CaptureAtlas.LayoutTiles", NV_UNIT_TEST_FLAGS)
+bool FNVAtlasLayoutTilesTest::RunTest(const FString& Parameters)
+{
+    TArray<FIntRect> TileRects;
+
+    // No width limit: all the tiles are in one row
+    const TArray<FIntPoint> StereoTileSizes = { FIntPoint(640, 480), FIntPoint(640, 480) };
+    TestEqual(TEXT("Stereo atlas size"), FNVAtlasLayout::LayoutTiles(StereoTileSizes, 0, TileRects), FIntPoint(1280, 480));
+    TestEqual(TEXT("Left tile"), TileRects[0], FIntRect(0, 0, 640, 480));
+    TestEqual(TEXT("Right tile"), TileRects[1], FIntRect(640, 0, 1280, 480));
+
+    // The rows wrap at the maximum width, each row is as tall as its tallest tile
+    const TArray<FIntPoint> MixedTileSizes = { FIntPoint(400, 300), FIntPoint(400, 200), FIntPoint(300, 100), FIntPoint(500, 250) };
+    TestEqual(TEXT("Wrapped atlas size"), FNVAtlasLayout::LayoutTiles(MixedTileSizes, 1000, TileRects), FIntPoint(800, 550));
+    TestEqual(TEXT("Tile 0 start the first row"), TileRects[0], FIntRect(0, 0, 400, 300));
+    TestEqual(TEXT("Tile 1 fit in the first row"), TileRects[1], FIntRect(400, 0, 800, 200));
+    TestEqual(TEXT("Tile 2 start the second row below the tallest tile"), TileRects[2], FIntRect(0, 300, 300, 400));
+    TestEqual(TEXT("Tile 3 fit in the second row"), TileRects[3], FIntRect(300, 300, 800, 550));
+
+    // A tile wider than the atlas get a row for itself
+    const TArray<FIntPoint> WideTileSizes = { FIntPoint(100, 10), FIntPoint(300, 20), FIntPoint(100, 30) };
+    TestEqual(TEXT("Atlas with a wide tile"), FNVAtlasLayout::LayoutTiles(WideTileSizes, 200, TileRects), FIntPoint(300, 60));
+    TestEqual(TEXT("The wide tile start a new row"), TileRects[1], FIntRect(0, 10, 300, 30));
+    TestEqual(TEXT("The tile after the wide one start a new row"), TileRects[2], FIntRect(0, 30, 100, 60));
+
+    // No tile overlap another one
+    for (int32 i = 0; i < TileRects.Num(); i++)
+    {
+        for (int32 j = i + 1; j < TileRects.Num(); j++)
+        {
+            FIntRect Overlap = TileRects[i];
+            Overlap.Clip(TileRects[j]);
+            TestTrue(FString::Printf(TEXT("Tiles %d and %d don't overlap"), i, j), Overlap.Area() <= 0);
+        }
+    }
+
+    TestEqual(TEXT("An empty atlas"), FNVAtlasLayout::LayoutTiles(TArray<FIntPoint>(), 100, TileRects), FIntPoint::ZeroValue);
+    TestEqual(TEXT("An empty atlas has no tile"), TileRects.Num(), 0);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAtlasSliceTileTest, "NVSceneCapturer.CaptureAtlas.SliceTile", NV_UNIT_TEST_FLAGS)
+bool FNVAtlasSliceTileTest::RunTest(const FString& Parameters)
+{
+    for (EPixelFormat PixelFormat : { PF_B8G8R8A8, PF_FloatRGBA })
+    {
+        const int32 PixelByteSize = NVSceneCapturerUtils::GetPixelByteSize(PixelFormat);
+        const FString FormatName = GetPixelFormatString(PixelFormat);
+
+        TArray<FIntRect> TileRects;
+        const FIntPoint AtlasSize = FNVAtlasLayout::LayoutTiles({ FIntPoint(37, 21), FIntPoint(50, 13), FIntPoint(29, 33) }, 90, TileRects);
+
+        // The mapped readback buffer is usually wider than the atlas: its row pitch is aligned
+        const FIntPoint AtlasBufferSize(Align(AtlasSize.X, 64), AtlasSize.Y);
+        const TArray<uint8> AtlasPixels = MakeAtlasBuffer(AtlasBufferSize, PixelByteSize);
+
+        for (int32 TileIndex = 0; TileIndex < TileRects.Num(); TileIndex++)
+        {
+            const FIntRect& TileRect = TileRects[TileIndex];
+            TestEqual(FString::Printf(TEXT("%s: byte offset of tile %d"), *FormatName, TileIndex),
+                      FNVAtlasLayout::GetTileByteOffset(TileRect, AtlasBufferSize.X, PixelByteSize),
+                      ((int64)TileRect.Min.Y * AtlasBufferSize.X + TileRect.Min.X) * PixelByteSize);
+
+            FNVTexturePixelData TilePixelsData;
+            if (!TestTrue(FString::Printf(TEXT("%s: tile %d is sliced"), *FormatName, TileIndex),
+                          FNVAtlasLayout::SliceTile(AtlasPixels.GetData(), AtlasBufferSize, PixelFormat, TileRect, TilePixelsData)))
+            {
+                continue;
+            }
+
+            TestEqual(TEXT("The tile keep the pixel format"), TilePixelsData.PixelFormat, PixelFormat);
+            TestEqual(TEXT("The tile has its own size"), TilePixelsData.PixelSize, TileRect.Size());
+            TestEqual(TEXT("The tile rows are tightly packed"), TilePixelsData.RowStride, TileRect.Width() * PixelByteSize);
+            TestEqual(TEXT("The tile has all its pixels"), TilePixelsData.PixelData.Num(), TileRect.Area() * PixelByteSize);
+            TestTrue(FString::Printf(TEXT("%s: tile %d has the pixels of its region"), *FormatName, TileIndex),
+                     IsTileSlicedFromAtlas(TilePixelsData, TileRect.Min, PixelByteSize));
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVAtlasSliceClippedTileTest, "NVSceneCapturer.CaptureAtlas.SliceClippedTile", NV_UNIT_TEST_FLAGS)
+bool FNVAtlasSliceClippedTileTest::RunTest(const FString& Parameters)
+{
+    const EPixelFormat PixelFormat = PF_B8G8R8A8;
+    const int32 PixelByteSize = NVSceneCapturerUtils::GetPixelByteSize(PixelFormat);
+    const FIntPoint AtlasBufferSize(64, 32);
+    const TArray<uint8> AtlasPixels = MakeAtlasBuffer(AtlasBufferSize, PixelByteSize);
+
+    // A tile going past the atlas buffer is clipped to it
+    FNVTexturePixelData TilePixelsData;
+    const FIntRect OverflowTileRect(48, 20, 80, 40);
+    TestTrue(TEXT("The overflowing tile is sliced"), FNVAtlasLayout::SliceTile(AtlasPixels.GetData(), AtlasBufferSize, PixelFormat, OverflowTileRect, TilePixelsData));
+    TestEqual(TEXT("The tile is clipped to the atlas buffer"), TilePixelsData.PixelSize, FIntPoint(16, 12));
+    TestTrue(TEXT("The clipped tile has the pixels of its region"), IsTileSlicedFromAtlas(TilePixelsData, OverflowTileRect.Min, PixelByteSize));
+
+    // The invalid tiles are rejected
+    AddExpectedError(TEXT("is outside of the atlas buffer"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestFalse(TEXT("A tile outside of the atlas buffer is rejected"),
+              FNVAtlasLayout::SliceTile(AtlasPixels.GetData(), AtlasBufferSize, PixelFormat, FIntRect(64, 0, 80, 16), TilePixelsData));
+
+    AddExpectedError(TEXT("invalid argument"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestFalse(TEXT("An empty tile is rejected"),
+              FNVAtlasLayout::SliceTile(AtlasPixels.GetData(), AtlasBufferSize, PixelFormat, FIntRect(8, 8, 8, 16), TilePixelsData));
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/// Flags of the plugin's unit tests: pure CPU code, they run in the editor and in the game (e.g: -ExecCmds="Automation RunTests NVSceneCapturer")
+#define NV_UNIT_TEST_FLAGS (EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+/// Flags of the plugin's benchmarks, they only report their timings and are filtered out of the regular test runs
+#define NV_PERF_TEST_FLAGS (EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+namespace NVSceneCapturerTest
+{
+    /// A unique temporary directory for a test, removed with all its content when the scope end
+    struct FScopedTestDirectory
+    {
+        FString DirectoryPath;
+
+        explicit FScopedTestDirectory(const TCHAR* TestName)
+        {
+            DirectoryPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("NVSceneCapturer"), TestName, FGuid::NewGuid().ToString());
+            FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*DirectoryPath);
+        }
+
+        ~FScopedTestDirectory()
+        {
+            FPlatformFileManager::Get().GetPlatformFile().DeleteDirectoryRecursively(*DirectoryPath);
+        }
+    };
+
+    /// A transient game world the test can spawn actors in, destroyed with its actors when the scope end
+    struct FScopedTestWorld
+    {
+        UWorld* World = nullptr;
+
+        FScopedTestWorld()
+        {
+            World = UWorld::CreateWorld(EWorldType::Game, false);
+            FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+            WorldContext.SetCurrentWorld(World);
+        }
+
+        ~FScopedTestWorld()
+        {
+            GEngine->DestroyWorldContext(World);
+            World->DestroyWorld(false);
+        }
+    };
+
+    /// Time a function and return its duration in seconds
+    template <typename FunctionType>
+    double MeasureSeconds(FunctionType&& Function)
+    {
+        const double StartTime = FPlatformTime::Seconds();
+        Function();
+        return FPlatformTime::Seconds() - StartTime;
+    }
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,238 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVAnnotationTestUtils.h"
+#include "NVSequenceAnnotation.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+#include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// A randomized scene evolving from frame to frame: some actors move, appear, disappear or change order
+    struct FEvolvingScene
+    {
+        FRandomStream RandomStream;
+        TArray<FNVActorAnnotationInput> Actors;
+        int32 NextActorIndex = 0;
+
+        FEvolvingScene(int32 Seed, int32 ActorCount)
+            : RandomStream(Seed)
+        {
+            for (int32 ActorIndex = 0; ActorIndex < ActorCount; ActorIndex++)
+            {
+                AddActor();
+            }
+
+            // 2 objects with the same static fields, they're only told apart by their order
+            for (int32 CopyIndex = 0; CopyIndex < 2; CopyIndex++)
+            {
+                FNVActorAnnotationInput& UnnamedActor = AddActor();
+                UnnamedActor.InstanceId = 0;
+                UnnamedActor.Class = TEXT("Unnamed");
+            }
+        }
+
+        FNVActorAnnotationInput& AddActor()
+        {
+            return Actors.Add_GetRef(NVSceneCapturerTest::MakeRandomActorInput(RandomStream, NextActorIndex++));
+        }
+
+        void MoveActor(FNVActorAnnotationInput& ActorInput)
+        {
+            const FNVActorAnnotationInput MovedActor = NVSceneCapturerTest::MakeRandomActorInput(RandomStream, 0);
+            ActorInput.ActorToWorld = MovedActor.ActorToWorld;
+            ActorInput.Cuboid = MovedActor.Cuboid;
+            ActorInput.MeshVertexSources = MovedActor.MeshVertexSources;
+            ActorInput.OccludedVertexCount = MovedActor.OccludedVertexCount;
+            ActorInput.SocketWorldLocations.Reset();
+            for (int32 SocketIndex = 0; SocketIndex < ActorInput.SocketNames.Num(); SocketIndex++)
+            {
+                ActorInput.SocketWorldLocations.Add(ActorInput.ActorToWorld.TransformPosition(RandomStream.GetUnitVector() * 50.f));
+            }
+        }
+
+        /// Change the scene for the next frame, a still frame doesn't change anything
+        void Step(bool bStill)
+        {
+            if (bStill)
+            {
+                return;
+            }
+
+            for (FNVActorAnnotationInput& ActorInput : Actors)
+            {
+                if (RandomStream.FRand() < 0.3f)
+                {
+                    MoveActor(ActorInput);
+                }
+            }
+            if ((Actors.Num() > 4) && (RandomStream.FRand() < 0.5f))
+            {
+                Actors.RemoveAt(RandomStream.RandRange(0, Actors.Num() - 1));
+            }
+            if (RandomStream.FRand() < 0.5f)
+            {
+                AddActor();
+            }
+            if (RandomStream.FRand() < 0.2f)
+            {
+                Actors.Swap(0, Actors.Num() - 1);
+            }
+        }
+
+        TSharedPtr<FJsonObject> BuildAnnotationData(int32 FrameIndex) const
+        {
+            FNVSceneAnnotationSnapshot Snapshot(FrameIndex);
+            Snapshot.ViewContext = NVSceneCapturerTest::MakeTestViewContext();
+            Snapshot.AnnotationFields = NVSceneCapturerTest::MakeFullAnnotationFields();
+            Snapshot.Actors = Actors;
+            return UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot);
+        }
+    };
+
+    /// The expanded frames of a sequence file, in the order they're read
+    struct FReadFrames
+    {
+        TArray<int32> FrameIndexes;
+        TArray<FString> AnnotationJsonStrings;
+    };
+
+    bool ReadSequenceFrames(const FString& SequenceFilePath, FReadFrames& OutReadFrames)
+    {
+        return FNVSequenceAnnotationWriter::ReadSequenceFile(SequenceFilePath, [&OutReadFrames](int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)
+        {
+            OutReadFrames.FrameIndexes.Add(FrameIndex);
+            OutReadFrames.AnnotationJsonStrings.Add(NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+        });
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVSequenceAnnotationRoundTripTest, "NVSceneCapturer.SequenceAnnotation.RoundTrip", NV_UNIT_TEST_FLAGS)
+bool FNVSequenceAnnotationRoundTripTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("SequenceRoundTrip"));
+    const FString SequenceFilePaths[2] = {
+        FPaths::Combine(TestDirectory.DirectoryPath, TEXT("Viewpoint0"), TEXT("annotation") + FNVSequenceAnnotationWriter::SequenceFileExtension),
+        FPaths::Combine(TestDirectory.DirectoryPath, TEXT("Viewpoint1"), TEXT("annotation") + FNVSequenceAnnotationWriter::SequenceFileExtension)
+    };
+
+    FNVSequenceAnnotationWriter SequenceWriter;
+    TMap<FString, TSharedPtr<FJsonObject>> ObjectClassSettings;
+    TSharedPtr<FJsonObject> ClassSettingsJsonObj = MakeShared<FJsonObject>();
+    ClassSettingsJsonObj->SetNumberField(TEXT("segmentation_class_id"), 12);
+    ObjectClassSettings.Add(TEXT("TestClassA"), ClassSettingsJsonObj);
+    SequenceWriter.SetObjectClassSettings(ObjectClassSettings);
+    SequenceWriter.Open(3, false);
+
+    // 2 streams captured together, each with its own scene; every 4th frame doesn't change
+    FEvolvingScene Scenes[2] = { FEvolvingScene(48, 12), FEvolvingScene(480, 30) };
+    TArray<FString> ExpectedJsonStrings[2];
+    int64 FullJsonSize = 0;
+    const int32 FrameCount = 40;
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+    {
+        for (int32 StreamIndex = 0; StreamIndex < 2; StreamIndex++)
+        {
+            Scenes[StreamIndex].Step((FrameIndex % 4) == 3);
+            const TSharedPtr<FJsonObject> AnnotationData = Scenes[StreamIndex].BuildAnnotationData(FrameIndex);
+            ExpectedJsonStrings[StreamIndex].Add(NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+            FullJsonSize += ExpectedJsonStrings[StreamIndex].Last().Len();
+            TestTrue(FString::Printf(TEXT("Frame %d of stream %d is written"), FrameIndex, StreamIndex),
+                     SequenceWriter.WriteFrame(SequenceFilePaths[StreamIndex], FrameIndex, AnnotationData));
+        }
+    }
+    SequenceWriter.Close();
+
+    // Each frame is expanded back to exactly the annotation data it's written from
+    int64 SequenceFileSize = 0;
+    for (int32 StreamIndex = 0; StreamIndex < 2; StreamIndex++)
+    {
+        FReadFrames ReadFrames;
+        TestTrue(FString::Printf(TEXT("Stream %d is read"), StreamIndex), ReadSequenceFrames(SequenceFilePaths[StreamIndex], ReadFrames));
+        if (!TestEqual(FString::Printf(TEXT("Stream %d has all its frames"), StreamIndex), ReadFrames.FrameIndexes.Num(), FrameCount))
+        {
+            continue;
+        }
+        for (int32 FrameIndex = 0; FrameIndex < FrameCount; FrameIndex++)
+        {
+            TestEqual(FString::Printf(TEXT("Stream %d frame %d index"), StreamIndex, FrameIndex), ReadFrames.FrameIndexes[FrameIndex], FrameIndex);
+            TestTrue(FString::Printf(TEXT("Stream %d frame %d is the same as the written one"), StreamIndex, FrameIndex),
+                     ReadFrames.AnnotationJsonStrings[FrameIndex].Equals(ExpectedJsonStrings[StreamIndex][FrameIndex], ESearchCase::CaseSensitive));
+        }
+        SequenceFileSize += IFileManager::Get().FileSize(*SequenceFilePaths[StreamIndex]);
+    }
+
+    // The unchanged objects aren't written again
+    AddInfo(FString::Printf(TEXT("Sequence files: %lld bytes, per-frame json: %lld characters"), SequenceFileSize, FullJsonSize));
+    TestTrue(TEXT("The sequence files are smaller than the per-frame json"), SequenceFileSize < FullJsonSize);
+
+    // The class settings are only in the object table
+    FString SequenceFileContent;
+    FFileHelper::LoadFileToString(SequenceFileContent, *SequenceFilePaths[0]);
+    TestTrue(TEXT("The object table has the class settings"), SequenceFileContent.Contains(TEXT("\"object_settings\":{\"segmentation_class_id\":12}")));
+    TestTrue(TEXT("The object table has the marker index"), SequenceFileContent.StartsWith(TEXT("{\"marker_index\":3,")));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVSequenceAnnotationResumeTest, "NVSceneCapturer.SequenceAnnotation.Resume", NV_UNIT_TEST_FLAGS)
+bool FNVSequenceAnnotationResumeTest::RunTest(const FString& Parameters)
+{
+    NVSceneCapturerTest::FScopedTestDirectory TestDirectory(TEXT("SequenceResume"));
+    const FString SequenceFilePath = FPaths::Combine(TestDirectory.DirectoryPath, TEXT("annotation") + FNVSequenceAnnotationWriter::SequenceFileExtension);
+
+    // The first session crash while writing frame 10: its last record is cut in the middle
+    FNVSequenceAnnotationWriter SequenceWriter;
+    FEvolvingScene Scene(4800, 10);
+    TMap<int32, FString> ExpectedJsonStrings;
+    SequenceWriter.Open(0, false);
+    for (int32 FrameIndex = 0; FrameIndex < 10; FrameIndex++)
+    {
+        Scene.Step(false);
+        const TSharedPtr<FJsonObject> AnnotationData = Scene.BuildAnnotationData(FrameIndex);
+        ExpectedJsonStrings.Add(FrameIndex, NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+        SequenceWriter.WriteFrame(SequenceFilePath, FrameIndex, AnnotationData);
+    }
+    SequenceWriter.Close();
+    FFileHelper::SaveStringToFile(TEXT("{\"frame_index\":10,\"base_fr"), *SequenceFilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM,
+                                  &IFileManager::Get(), FILEWRITE_Append);
+
+    // The resumed session capture the frames after the last checkpoint again, with a new key frame
+    SequenceWriter.Open(1, true);
+    for (int32 FrameIndex = 6; FrameIndex < 16; FrameIndex++)
+    {
+        Scene.Step(false);
+        const TSharedPtr<FJsonObject> AnnotationData = Scene.BuildAnnotationData(FrameIndex);
+        ExpectedJsonStrings.Add(FrameIndex, NVSceneCapturerTest::JsonObjectToString(AnnotationData));
+        SequenceWriter.WriteFrame(SequenceFilePath, FrameIndex, AnnotationData);
+    }
+    SequenceWriter.Close();
+
+    AddExpectedError(TEXT("is incomplete"), EAutomationExpectedErrorFlags::Contains, 1);
+    FReadFrames ReadFrames;
+    TestTrue(TEXT("The resumed sequence is read"), ReadSequenceFrames(SequenceFilePath, ReadFrames));
+    TestEqual(TEXT("The frames of both sessions are read, without the incomplete one"), ReadFrames.FrameIndexes.Num(), 10 + 10);
+
+    // The last record of a frame is the valid one
+    TMap<int32, FString> LastJsonStrings;
+    for (int32 ReadIndex = 0; ReadIndex < ReadFrames.FrameIndexes.Num(); ReadIndex++)
+    {
+        LastJsonStrings.Add(ReadFrames.FrameIndexes[ReadIndex], ReadFrames.AnnotationJsonStrings[ReadIndex]);
+    }
+    TestEqual(TEXT("Each frame is read"), LastJsonStrings.Num(), 16);
+    for (const auto& ExpectedJsonString : ExpectedJsonStrings)
+    {
+        const FString* LastJsonString = LastJsonStrings.Find(ExpectedJsonString.Key);
+        TestTrue(FString::Printf(TEXT("Frame %d is the last captured one"), ExpectedJsonString.Key),
+                 LastJsonString && LastJsonString->Equals(ExpectedJsonString.Value, ESearchCase::CaseSensitive));
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
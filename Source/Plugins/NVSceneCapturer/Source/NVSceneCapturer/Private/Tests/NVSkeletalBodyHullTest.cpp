@@ -0,0 +1,224 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVAnnotationTestUtils.h"
+#include "NVMeshGeometry.h"
+#include "NVSceneFeatureExtractor_DataExport.h"
+#include "JsonObjectConverter.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    USkeletalBodySetup* AddBody(UPhysicsAsset* PhysicsAsset, const TCHAR* BoneName)
+    {
+        USkeletalBodySetup* BodySetup = NewObject<USkeletalBodySetup>(PhysicsAsset);
+        BodySetup->BoneName = BoneName;
+        PhysicsAsset->SkeletalBodySetups.Add(BodySetup);
+        return BodySetup;
+    }
+
+    /// A small character: a sphere, a box, a capsule and a body without any shape
+    UPhysicsAsset* MakeTestPhysicsAsset()
+    {
+        UPhysicsAsset* PhysicsAsset = NewObject<UPhysicsAsset>(GetTransientPackage());
+
+        FKSphereElem SphereElem(20.f);
+        SphereElem.Center = FVector(0.f, 0.f, 10.f);
+        AddBody(PhysicsAsset, TEXT("pelvis"))->AggGeom.SphereElems.Add(SphereElem);
+
+        FKBoxElem BoxElem(30.f, 20.f, 10.f);
+        BoxElem.Center = FVector(5.f, 0.f, 0.f);
+        BoxElem.Rotation = FRotator(0.f, 30.f, 0.f);
+        AddBody(PhysicsAsset, TEXT("spine"))->AggGeom.BoxElems.Add(BoxElem);
+
+        FKSphylElem CapsuleElem(5.f, 40.f);
+        AddBody(PhysicsAsset, TEXT("upperarm"))->AggGeom.SphylElems.Add(CapsuleElem);
+
+        AddBody(PhysicsAsset, TEXT("empty"));
+        return PhysicsAsset;
+    }
+
+    /// The 2D box of the bodies computed the straightforward way: each body vertex transformed by its bone and projected on its own
+    FBox2D CalculateReferenceBox(const FNVAnnotationViewContext& ViewContext, const FNVSkeletalBodyHulls& BodyHulls, const TArray<FTransform>& BodyTransforms, bool bUseBodyBoundsCorners)
+    {
+        FBox2D ReferenceBox(EForceInit::ForceInitToZero);
+        for (int32 BodyIndex = 0; BodyIndex < BodyHulls.Bodies.Num(); BodyIndex++)
+        {
+            const FNVSkeletalBodyHull& BodyHull = BodyHulls.Bodies[BodyIndex];
+            for (const FVector3f& BodyVertex : (bUseBodyBoundsCorners ? BodyHull.BoundsCorners : BodyHull.Vertexes))
+            {
+                const FVector ImagePosition = ViewContext.ProjectWorldPositionToImagePosition(BodyTransforms[BodyIndex].TransformPosition(FVector(BodyVertex)));
+                ReferenceBox += FVector2D(ImagePosition.X, ImagePosition.Y);
+            }
+        }
+        return ReferenceBox;
+    }
+
+    /// Read the bounding box of the first object of an annotation
+    bool GetObjectBoundingBox(const TSharedPtr<FJsonObject>& AnnotationJsonObject, FNVBox2D& OutBoundingBox)
+    {
+        const TArray<TSharedPtr<FJsonValue>>* ObjectJsonValues = nullptr;
+        if (!AnnotationJsonObject.IsValid() || !AnnotationJsonObject->TryGetArrayField(TEXT("objects"), ObjectJsonValues) || (ObjectJsonValues->Num() == 0))
+        {
+            return false;
+        }
+
+        const TSharedPtr<FJsonObject>* BoxJsonObject = nullptr;
+        return (*ObjectJsonValues)[0]->AsObject()->TryGetObjectField(TEXT("bounding_box"), BoxJsonObject)
+               && FJsonObjectConverter::JsonObjectToUStruct(BoxJsonObject->ToSharedRef(), &OutBoundingBox);
+    }
+
+    bool IsBoxNearlyEqual(const FNVBox2D& Box, const FNVBox2D& ExpectedBox, float Tolerance)
+    {
+        return Box.top_left.Equals(ExpectedBox.top_left, Tolerance) && Box.bottom_right.Equals(ExpectedBox.bottom_right, Tolerance);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVSkeletalBodyHullBuildTest, "NVSceneCapturer.SkeletalBodyHull.Build", NV_UNIT_TEST_FLAGS)
+bool FNVSkeletalBodyHullBuildTest::RunTest(const FString& Parameters)
+{
+    UPhysicsAsset* PhysicsAsset = MakeTestPhysicsAsset();
+
+    FNVSkeletalBodyHulls BodyHulls;
+    FNVSkeletalBodyHullCache::BuildBodyHulls(PhysicsAsset, BodyHulls);
+    if (!TestEqual(TEXT("The bodies without any shape are skipped"), BodyHulls.Bodies.Num(), 3))
+    {
+        return false;
+    }
+
+    // The sphere's points are on the sphere
+    const FNVSkeletalBodyHull& SphereHull = BodyHulls.Bodies[0];
+    TestEqual(TEXT("The sphere body keep its bone"), SphereHull.BoneName, FName(TEXT("pelvis")));
+    bool bOnSphere = (SphereHull.Vertexes.Num() > 0);
+    for (const FVector3f& Vertex : SphereHull.Vertexes)
+    {
+        bOnSphere &= FMath::IsNearlyEqual(FVector3f::Dist(Vertex, FVector3f(0.f, 0.f, 10.f)), 20.f, 1.e-3f);
+    }
+    TestTrue(TEXT("The sphere is sampled on its surface"), bOnSphere);
+
+    // The box is its corners, in the bone space
+    const FNVSkeletalBodyHull& BoxHull = BodyHulls.Bodies[1];
+    const FKBoxElem& BoxElem = PhysicsAsset->SkeletalBodySetups[1]->AggGeom.BoxElems[0];
+    TestEqual(TEXT("The box is its corners"), BoxHull.Vertexes.Num(), 8);
+    for (int32 CornerIndex = 0; CornerIndex < BoxHull.Vertexes.Num(); CornerIndex++)
+    {
+        const FVector LocalCorner((CornerIndex & 1) ? 15.f : -15.f, (CornerIndex & 2) ? 10.f : -10.f, (CornerIndex & 4) ? 5.f : -5.f);
+        TestTrue(FString::Printf(TEXT("Box corner %d is in the bone space"), CornerIndex),
+                 FVector(BoxHull.Vertexes[CornerIndex]).Equals(BoxElem.GetTransform().TransformPosition(LocalCorner), 1.e-3f));
+    }
+
+    // The capsule's points are at its radius from its segment
+    const FNVSkeletalBodyHull& CapsuleHull = BodyHulls.Bodies[2];
+    bool bOnCapsule = (CapsuleHull.Vertexes.Num() > 0);
+    for (const FVector3f& Vertex : CapsuleHull.Vertexes)
+    {
+        const FVector SegmentPoint = FMath::ClosestPointOnSegment(FVector(Vertex), FVector(0.f, 0.f, -20.f), FVector(0.f, 0.f, 20.f));
+        bOnCapsule &= FMath::IsNearlyEqual(FVector::Dist(FVector(Vertex), SegmentPoint), 5.0, 1.e-3);
+    }
+    TestTrue(TEXT("The capsule is sampled on its surface"), bOnCapsule);
+    TestEqual(TEXT("The capsule's bounds cover its caps"), (double)FBox3f(CapsuleHull.Vertexes).GetExtent().Z, 25.0, 1.e-3);
+
+    // The bounds corners are the corners of the body's vertexes' bounds
+    for (const FNVSkeletalBodyHull& BodyHull : BodyHulls.Bodies)
+    {
+        TestEqual(TEXT("A body has 8 bounds corners"), BodyHull.BoundsCorners.Num(), 8);
+        TestTrue(TEXT("The bounds corners have the bounds of the body"), FBox3f(BodyHull.BoundsCorners).Equals(FBox3f(BodyHull.Vertexes)));
+    }
+
+    // The hulls are built once, and built again only when the bodies change
+    FNVSkeletalBodyHullCache::Reset();
+    const FNVSkeletalBodyHullsPtr CachedHulls = FNVSkeletalBodyHullCache::FindOrBuild(PhysicsAsset);
+    TestTrue(TEXT("The cached hulls are reused"), CachedHulls.IsValid() && (FNVSkeletalBodyHullCache::FindOrBuild(PhysicsAsset) == CachedHulls));
+
+    PhysicsAsset->SkeletalBodySetups[0]->AggGeom.SphereElems[0].Radius = 30.f;
+    const FNVSkeletalBodyHullsPtr RebuiltHulls = FNVSkeletalBodyHullCache::FindOrBuild(PhysicsAsset);
+    TestTrue(TEXT("The changed bodies are built again"), RebuiltHulls.IsValid() && (RebuiltHulls != CachedHulls));
+    TestEqual(TEXT("The previous hulls are left untouched for the frames still reading them"),
+              (double)FVector3f::Dist(CachedHulls->Bodies[0].Vertexes[0], FVector3f(0.f, 0.f, 10.f)), 20.0, 1.e-3);
+    FNVSkeletalBodyHullCache::Reset();
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVSkeletalBodyHullProjectionTest, "NVSceneCapturer.SkeletalBodyHull.Projection", NV_UNIT_TEST_FLAGS)
+bool FNVSkeletalBodyHullProjectionTest::RunTest(const FString& Parameters)
+{
+    FNVSkeletalBodyHulls BuiltHulls;
+    FNVSkeletalBodyHullCache::BuildBodyHulls(MakeTestPhysicsAsset(), BuiltHulls);
+    const FNVSkeletalBodyHullsPtr BodyHulls = MakeShared<FNVSkeletalBodyHulls, ESPMode::ThreadSafe>(BuiltHulls);
+
+    const FNVAnnotationViewContext ViewContext = NVSceneCapturerTest::MakeTestViewContext();
+    const FNVAnnotationFieldSet AnnotationFields = NVSceneCapturerTest::MakeFullAnnotationFields();
+    FRandomStream RandomStream(45);
+
+    // Synthetic poses: the bones of the character are scattered around it, in front of the camera
+    const int32 PoseCount = 50;
+    int32 MismatchedPoseCount = 0;
+    int32 UncoveredPoseCount = 0;
+    for (int32 PoseIndex = 0; PoseIndex < PoseCount; PoseIndex++)
+    {
+        const FVector CharacterLocation(RandomStream.FRandRange(400.f, 3000.f), RandomStream.FRandRange(-500.f, 500.f), RandomStream.FRandRange(-300.f, 300.f));
+        TArray<FTransform> BodyTransforms;
+        for (int32 BodyIndex = 0; BodyIndex < BodyHulls->Bodies.Num(); BodyIndex++)
+        {
+            const FRotator BoneRotation(RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f), RandomStream.FRandRange(-180.f, 180.f));
+            BodyTransforms.Add(FTransform(BoneRotation, CharacterLocation + RandomStream.GetUnitVector() * RandomStream.FRandRange(0.f, 80.f)));
+        }
+
+        FNVBox2D BodyBoxes[2];
+        for (const bool bUseBodyBoundsCorners : { false, true })
+        {
+            FNVSceneAnnotationSnapshot Snapshot(PoseIndex);
+            Snapshot.ViewContext = ViewContext;
+            Snapshot.AnnotationFields = AnnotationFields;
+
+            FNVActorAnnotationInput ActorInput;
+            ActorInput.ActorToWorld = FTransform(CharacterLocation);
+            FNVMeshBoundVertexSource VertexSource;
+            VertexSource.MeshTransform = ActorInput.ActorToWorld;
+            VertexSource.BodyHulls = BodyHulls;
+            VertexSource.BodyTransforms = BodyTransforms;
+            VertexSource.bUseBodyBoundsCorners = bUseBodyBoundsCorners;
+            ActorInput.MeshVertexSources.Add(MoveTemp(VertexSource));
+            Snapshot.Actors.Add(MoveTemp(ActorInput));
+
+            FNVBox2D& BodyBox = BodyBoxes[bUseBodyBoundsCorners ? 1 : 0];
+            if (!GetObjectBoundingBox(UNVSceneFeatureExtractor_AnnotationData::BuildSceneAnnotationData(Snapshot), BodyBox))
+            {
+                AddError(TEXT("The annotation of the character doesn't have its bounding box"));
+                return false;
+            }
+
+            // The batched float transforms give the same box as the per vertex double transforms, within a small fraction of a pixel
+            const FNVBox2D ReferenceBox(CalculateReferenceBox(ViewContext, *BodyHulls, BodyTransforms, bUseBodyBoundsCorners));
+            if (!IsBoxNearlyEqual(BodyBox, ReferenceBox, 0.05f))
+            {
+                MismatchedPoseCount++;
+            }
+        }
+
+        // The bounds corners are a coarser approximation which still cover the bodies
+        const FNVBox2D& VertexBox = BodyBoxes[0];
+        const FNVBox2D& CornerBox = BodyBoxes[1];
+        const bool bCovered = (CornerBox.top_left.X <= VertexBox.top_left.X + 0.05f) && (CornerBox.top_left.Y <= VertexBox.top_left.Y + 0.05f)
+                              && (CornerBox.bottom_right.X >= VertexBox.bottom_right.X - 0.05f) && (CornerBox.bottom_right.Y >= VertexBox.bottom_right.Y - 0.05f);
+        if (!bCovered)
+        {
+            UncoveredPoseCount++;
+        }
+    }
+
+    TestEqual(TEXT("The bodies' boxes are the same as the reference ones for all the poses"), MismatchedPoseCount, 0);
+    TestEqual(TEXT("The bounds corners' boxes cover the bodies for all the poses"), UncoveredPoseCount, 0);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,159 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVSceneCapturerModule.h"
+#include "Tests/NVSceneCapturerTestUtils.h"
+#include "NVTiledCapture.h"
+#include "NVSceneCaptureComponent2D.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /// Project a world point to an image rendered with a view projection matrix
+    /// @param OutPixel  The position of the point in the image (in pixels)
+    /// @param OutDepth  The depth written in the depth buffer
+    /// @return false if the point is behind the camera
+    bool ProjectToImage(const FMatrix& ViewProjectionMatrix, const FVector& WorldPoint, const FIntPoint& ImageSize, FVector2D& OutPixel, double& OutDepth)
+    {
+        const FPlane ClipPoint = ViewProjectionMatrix.TransformFVector4(FVector4(WorldPoint, 1.f));
+        if (ClipPoint.W <= KINDA_SMALL_NUMBER)
+        {
+            return false;
+        }
+
+        const double RHW = 1.0 / ClipPoint.W;
+        OutPixel = FVector2D(0.5 * (ClipPoint.X * RHW + 1.0) * ImageSize.X, 0.5 * (1.0 - ClipPoint.Y * RHW) * ImageSize.Y);
+        OutDepth = ClipPoint.Z * RHW;
+        return true;
+    }
+
+    /// Project random world points through the full view and through the tiles covering them:
+    /// each point must land in the tile at its full image position minus the tile's offset, with the same depth
+    void TestTileProjections(FAutomationTestBase& Test, const FString& TestName, const FMatrix& FullProjectionMatrix, const FIntPoint& ImageSize, int32 MaxTileSize)
+    {
+        TArray<FNVCaptureTile> Tiles;
+        FNVTiledCapture::BuildTiles(FullProjectionMatrix, ImageSize, MaxTileSize, Tiles);
+        const FIntPoint GridSize = FNVTiledCapture::CalculateGridSize(ImageSize, MaxTileSize);
+        const FIntPoint TileSize = FNVTiledCapture::CalculateTileSize(ImageSize, MaxTileSize);
+        Test.TestEqual(FString::Printf(TEXT("%s: tile count"), *TestName), Tiles.Num(), GridSize.X * GridSize.Y);
+        Test.TestTrue(FString::Printf(TEXT("%s: the tiles fit in the render target"), *TestName), (TileSize.X <= MaxTileSize) && (TileSize.Y <= MaxTileSize));
+
+        // The clipped tiles cover the full image exactly once
+        int64 CoveredPixelCount = 0;
+        for (const FNVCaptureTile& Tile : Tiles)
+        {
+            CoveredPixelCount += Tile.GetClippedRect().Area();
+        }
+        Test.TestTrue(FString::Printf(TEXT("%s: the tiles cover the image"), *TestName), CoveredPixelCount == int64(ImageSize.X) * ImageSize.Y);
+
+        // The viewpoint isn't at the origin so the view transform is part of the projection
+        const FTransform ViewTransform(FRotator(-10.f, 30.f, 5.f), FVector(120.f, -40.f, 75.f));
+        const FMatrix FullViewProjectionMatrix = UNVSceneCaptureComponent2D::BuildViewProjectionMatrix(ViewTransform, FullProjectionMatrix);
+
+        FRandomStream RandomStream(42);
+        const double PixelTolerance = 1.0e-3;
+        int32 ProjectedPointCount = 0;
+        int32 MismatchedPointCount = 0;
+        for (int32 PointIndex = 0; PointIndex < 2000; PointIndex++)
+        {
+            const FVector ViewPoint(RandomStream.FRandRange(50.f, 5000.f), RandomStream.FRandRange(-2500.f, 2500.f), RandomStream.FRandRange(-2500.f, 2500.f));
+            const FVector WorldPoint = ViewTransform.TransformPosition(ViewPoint);
+
+            FVector2D FullPixel;
+            double FullDepth = 0.0;
+            if (!ProjectToImage(FullViewProjectionMatrix, WorldPoint, ImageSize, FullPixel, FullDepth)
+                || (FullPixel.X < 0.0) || (FullPixel.Y < 0.0) || (FullPixel.X >= ImageSize.X) || (FullPixel.Y >= ImageSize.Y))
+            {
+                continue;
+            }
+            ProjectedPointCount++;
+
+            int32 CoveringTileCount = 0;
+            for (const FNVCaptureTile& Tile : Tiles)
+            {
+                const FIntRect ClippedRect = Tile.GetClippedRect();
+                if ((FullPixel.X < ClippedRect.Min.X) || (FullPixel.Y < ClippedRect.Min.Y) || (FullPixel.X >= ClippedRect.Max.X) || (FullPixel.Y >= ClippedRect.Max.Y))
+                {
+                    continue;
+                }
+                CoveringTileCount++;
+
+                FVector2D TilePixel;
+                double TileDepth = 0.0;
+                const FMatrix TileViewProjectionMatrix = UNVSceneCaptureComponent2D::BuildViewProjectionMatrix(ViewTransform, Tile.ProjectionMatrix);
+                const bool bProjected = ProjectToImage(TileViewProjectionMatrix, WorldPoint, Tile.Rect.Size(), TilePixel, TileDepth);
+                if (!bProjected
+                    || !(TilePixel + FVector2D(Tile.Rect.Min)).Equals(FullPixel, PixelTolerance)
+                    || !FMath::IsNearlyEqual(TileDepth, FullDepth, 1.0e-9))
+                {
+                    if (MismatchedPointCount == 0)
+                    {
+                        Test.AddError(FString::Printf(TEXT("%s: the point %s is at %s in the full image but at %s in the tile %d offset by %s"),
+                                                      *TestName, *WorldPoint.ToString(), *FullPixel.ToString(), *TilePixel.ToString(), Tile.TileIndex, *Tile.Rect.Min.ToString()));
+                    }
+                    MismatchedPointCount++;
+                }
+            }
+            if (CoveringTileCount != 1)
+            {
+                MismatchedPointCount++;
+            }
+        }
+
+        Test.TestTrue(FString::Printf(TEXT("%s: the points are in the view"), *TestName), ProjectedPointCount > 100);
+        Test.TestEqual(FString::Printf(TEXT("%s: every point is in its tile at the same position"), *TestName), MismatchedPointCount, 0);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVTiledCaptureGridTest, "NVSceneCapturer.TiledCapture.Grid", NV_UNIT_TEST_FLAGS)
+bool FNVTiledCaptureGridTest::RunTest(const FString& Parameters)
+{
+    TestEqual(TEXT("An image smaller than a tile is a single tile"), FNVTiledCapture::CalculateGridSize(FIntPoint(1920, 1080), 2048), FIntPoint(1, 1));
+    TestEqual(TEXT("8K grid"), FNVTiledCapture::CalculateGridSize(FIntPoint(7680, 4320), 2048), FIntPoint(4, 3));
+    TestEqual(TEXT("8K tiles are split evenly"), FNVTiledCapture::CalculateTileSize(FIntPoint(7680, 4320), 2048), FIntPoint(1920, 1440));
+    TestEqual(TEXT("The tile size is rounded up"), FNVTiledCapture::CalculateTileSize(FIntPoint(1001, 599), 256), FIntPoint(251, 200));
+
+    TArray<FNVCaptureTile> Tiles;
+    FNVTiledCapture::BuildTiles(FMatrix::Identity, FIntPoint(1001, 599), 256, Tiles);
+    if (TestEqual(TEXT("Tile count"), Tiles.Num(), 4 * 3))
+    {
+        TestEqual(TEXT("The tiles are ordered row by row"), Tiles[5].Rect, FIntRect(251, 200, 502, 400));
+        TestEqual(TEXT("The last tile go past the image"), Tiles.Last().Rect, FIntRect(753, 400, 1004, 600));
+        TestEqual(TEXT("The clipped last tile stay in the image"), Tiles.Last().GetClippedRect(), FIntRect(753, 400, 1001, 599));
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNVTiledCaptureProjectionTest, "NVSceneCapturer.TiledCapture.Projection", NV_UNIT_TEST_FLAGS)
+bool FNVTiledCaptureProjectionTest::RunTest(const FString& Parameters)
+{
+    struct FTestCase
+    {
+        const TCHAR* Name;
+        FIntPoint ImageSize;
+        int32 MaxTileSize;
+        ECameraProjectionMode::Type ProjectionType;
+    };
+    const FTestCase TestCases[] =
+    {
+        { TEXT("8K perspective"), FIntPoint(7680, 4320), 2048, ECameraProjectionMode::Perspective },
+        { TEXT("Uneven perspective"), FIntPoint(1001, 599), 256, ECameraProjectionMode::Perspective },
+        { TEXT("Portrait perspective"), FIntPoint(600, 1000), 256, ECameraProjectionMode::Perspective },
+        { TEXT("Single tile"), FIntPoint(640, 480), 2048, ECameraProjectionMode::Perspective },
+        { TEXT("Orthographic"), FIntPoint(1001, 599), 256, ECameraProjectionMode::Orthographic },
+    };
+
+    for (const FTestCase& TestCase : TestCases)
+    {
+        const FMatrix FullProjectionMatrix = UNVSceneCaptureComponent2D::BuildProjectionMatrix(FNVImageSize(TestCase.ImageSize.X, TestCase.ImageSize.Y),
+                                                                                              TestCase.ProjectionType, 75.f, 8000.f);
+        TestTileProjections(*this, TestCase.Name, FullProjectionMatrix, TestCase.ImageSize, TestCase.MaxTileSize);
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,104 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "NVSceneAnnotationSnapshot.h"
+
+/// Statistics of the lookups in an actor annotation cache
+struct NVSCENECAPTURER_API FNVActorAnnotationCacheStats
+{
+    int64 LookupCount = 0;
+    int64 HitCount = 0;
+
+    /// Number of cached actors which also reused their occlusion
+    int64 OcclusionHitCount = 0;
+
+    float GetHitRate() const
+    {
+        return (LookupCount > 0) ? float(double(HitCount) / double(LookupCount)) : 0.f;
+    }
+
+    FString ToString() const;
+};
+
+///
+/// Keep the world space annotation data (cuboid, mesh geometry, occlusion) of the exported actors between the frames,
+/// so the actors which didn't change since the previous frame don't need to recompute them.
+/// An entry is reused only if the actor's transform, bounds, meshes, mask id and annotation version are all unchanged.
+/// NOTE: The projections only depend on the viewpoint, they're always recomputed from the cached world space data.
+/// All the functions must be called on the game thread.
+///
+class NVSCENECAPTURER_API FNVActorAnnotationCache
+{
+public:
+    /// The state of an actor its cached annotation data depend on
+    struct FActorState
+    {
+        FTransform ActorToWorld;
+        FBox Bounds;
+        TArray<FObjectKey> MeshAssets;
+        uint32 InstanceId = 0;
+        uint32 AnnotationVersion = 0;
+
+        /// Read the current state of the actor
+        void Update(const AActor* CheckActor, uint32 InInstanceId);
+
+        bool Equals(const FActorState& Other) const;
+    };
+
+    struct FEntry
+    {
+        FActorState State;
+        FNVCuboidData Cuboid;
+        TArray<FNVMeshBoundVertexSource> MeshVertexSources;
+
+        /// Where the occlusion is traced from, the occlusion can only be reused while the viewpoint doesn't move
+        FVector OcclusionViewLocation = FVector::ZeroVector;
+        int32 OccludedVertexCount = INDEX_NONE;
+
+        /// The last frame the entry was used in
+        int32 LastUsedFrame = INDEX_NONE;
+    };
+
+    FNVActorAnnotationCache();
+
+    /// Start a new frame, the entries which aren't used for a while are removed
+    void BeginFrame();
+
+    /// Find the cached annotation data of the actor
+    /// @return nullptr if the actor isn't cached or changed since it was cached
+    FEntry* Find(const AActor* CheckActor, const FActorState& CurrentState);
+
+    /// Find the cached occlusion of the actor, only valid while the viewpoint doesn't move
+    /// @return false if the occlusion must be traced again
+    bool FindOcclusion(const FEntry& CachedEntry, const FVector& ViewLocation, int32& OutOccludedVertexCount);
+
+    /// Cache the annotation data of the actor
+    void Add(const AActor* CheckActor, FEntry&& NewEntry);
+
+    void Reset();
+
+    int32 Num() const
+    {
+        return Entries.Num();
+    }
+
+    const FNVActorAnnotationCacheStats& GetStats() const
+    {
+        return Stats;
+    }
+
+protected:
+    TMap<FObjectKey, FEntry> Entries;
+    FNVActorAnnotationCacheStats Stats;
+    int32 FrameCounter;
+
+    /// The entries not used for more than this number of frames are removed (e.g: the actor is out of the view or destroyed)
+    static const int32 MaxUnusedFrameCount;
+};
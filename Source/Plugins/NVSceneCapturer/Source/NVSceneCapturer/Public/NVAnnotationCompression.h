@@ -0,0 +1,181 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "NVAnnotationCompression.generated.h"
+
+struct z_stream_s;
+
+/// How the annotation files are compressed
+/// NOTE: There is no compressed file per frame, it would be too small to gain much from the compression on its own
+UENUM(BlueprintType)
+enum class ENVAnnotationCompressionMode : uint8
+{
+    /// The annotation data are written as plain json files
+    None = 0,
+
+    /// The annotation data of each viewpoint and annotation feature extractor are streamed into rolling compressed json-lines files
+    /// (_annotation<postfix>.<file index>.jsonl.nvz), the records are compressed by blocks so the redundancy between the frames is used
+    Stream UMETA(DisplayName = "Rolling compressed json-lines files"),
+
+    /// Like Stream but each record is compressed on its own with a dictionary trained on the first frames of the stream
+    /// and saved next to the stream files (_annotation<postfix>.dict), a record can be decompressed without the ones before it
+    /// NOTE: The records are always compressed with zlib, the only engine format with preset dictionaries
+    DictionaryRecords UMETA(DisplayName = "Records compressed with a trained dictionary"),
+
+    /// @cond DOXYGEN_SUPPRESSED_CODE
+    NVAnnotationCompressionMode_MAX UMETA(Hidden)
+    /// @endcond DOXYGEN_SUPPRESSED_CODE
+};
+
+/// The compression formats of the engine the annotation files can use
+UENUM(BlueprintType)
+enum class ENVAnnotationCompressionFormat : uint8
+{
+    Oodle = 0,
+    Zlib,
+    Gzip,
+    LZ4,
+
+    /// @cond DOXYGEN_SUPPRESSED_CODE
+    NVAnnotationCompressionFormat_MAX UMETA(Hidden)
+    /// @endcond DOXYGEN_SUPPRESSED_CODE
+};
+
+///
+/// Compressed annotation files are a list of independent blocks, each one is a header followed by the compressed data:
+/// [magic "NVZB" (4 bytes)][format (1 byte)][flags (1 byte)][reserved (2 bytes)][uncompressed size (4 bytes)][compressed size (4 bytes)][compressed data]
+/// The dictionary flag mark the zlib blocks compressed with a preset dictionary, they can only be decompressed with the same dictionary.
+/// NOTE: The blocks are independent so a stream can be appended to and a crash only lose the last incomplete block
+///
+namespace NVAnnotationCompression
+{
+    /// Extension added to the compressed annotation files
+    NVSCENECAPTURER_API extern const FString CompressedFileExtension;
+
+    /// Maximum size (in bytes) of a trained dictionary, zlib only look that far back
+    NVSCENECAPTURER_API extern const int32 MaxDictionarySize;
+
+    /// Name of the engine's compression format
+    NVSCENECAPTURER_API FName GetCompressionFormatName(ENVAnnotationCompressionFormat CompressionFormat);
+
+    /// Compress the data into a block and append it to OutBlockData
+    NVSCENECAPTURER_API bool CompressBlock(ENVAnnotationCompressionFormat CompressionFormat, const uint8* UncompressedData, int32 UncompressedSize, TArray<uint8>& OutBlockData);
+
+    /// Decompress all the blocks of a compressed annotation file and append their data to OutUncompressedData
+    /// @param Dictionary - The dictionary the blocks with the dictionary flag are compressed with
+    /// @return false if one of the blocks is invalid, the data of the blocks before it are still decompressed
+    NVSCENECAPTURER_API bool DecompressBlocks(const TArray<uint8>& BlockData, TArray<uint8>& OutUncompressedData, const TArray<uint8>* Dictionary = nullptr);
+
+    /// Read a compressed annotation file back to its text
+    NVSCENECAPTURER_API bool LoadCompressedFileToString(const FString& FilePath, FString& OutFileContent, const TArray<uint8>* Dictionary = nullptr);
+
+    /// Build a dictionary from sample records: the segments of the samples whose content is the most common among the samples,
+    /// the most common ones last so they're the closest to the compressed data
+    /// @param MaxSize - Maximum size (in bytes) of the dictionary, it's capped to MaxDictionarySize
+    /// @return false if the samples don't have anything in common
+    NVSCENECAPTURER_API bool TrainDictionary(const TArray<TArray<uint8>>& Samples, int32 MaxSize, TArray<uint8>& OutDictionary);
+}
+
+///
+/// Compress records one by one with zlib primed with a dictionary, into blocks with the dictionary flag.
+/// The compression state is reused between the records so each record only pay for the compression itself.
+/// With an empty dictionary the blocks are plain zlib blocks.
+/// NOTE: Not thread-safe, each stream has its own compressor
+///
+class NVSCENECAPTURER_API FNVAnnotationDictionaryCompressor
+{
+public:
+    explicit FNVAnnotationDictionaryCompressor(const TArray<uint8>& InDictionary);
+    ~FNVAnnotationDictionaryCompressor();
+
+    FNVAnnotationDictionaryCompressor(const FNVAnnotationDictionaryCompressor&) = delete;
+    FNVAnnotationDictionaryCompressor& operator=(const FNVAnnotationDictionaryCompressor&) = delete;
+
+    /// Compress the data into a block and append it to OutBlockData
+    bool CompressBlock(const uint8* UncompressedData, int32 UncompressedSize, TArray<uint8>& OutBlockData);
+
+    const TArray<uint8>& GetDictionary() const
+    {
+        return Dictionary;
+    }
+
+protected:
+    TArray<uint8> Dictionary;
+    z_stream_s* DeflateStream;
+};
+
+///
+/// Stream the annotation data of the frames into rolling compressed json-lines files, one per viewpoint and annotation feature extractor.
+/// Each line is the annotation data of a frame with its index first: {"frame_index":12,"camera_data":{...},"objects":[...]}
+/// A new file is started every FramesPerFile frames. In Stream mode the records are buffered and compressed by blocks,
+/// in DictionaryRecords mode each record is a block compressed with the stream's dictionary: the first frames of the stream
+/// are held back until the dictionary is trained on them, then it's saved next to the stream files and used for all the records.
+/// NOTE: A resumed session capture the frames after the last checkpoint again, the last record of a frame is the valid one
+///
+class NVSCENECAPTURER_API FNVCompressedAnnotationStreamWriter
+{
+public:
+    FNVCompressedAnnotationStreamWriter();
+    ~FNVCompressedAnnotationStreamWriter();
+
+    /// Start a new capturing session
+    /// @param InCompressionMode - How the records are compressed, Stream or DictionaryRecords
+    /// @param InCompressionFormat - The compression format of the blocks in Stream mode
+    /// @param InFramesPerFile - Number of frames in each stream file, <= 0 mean all the frames are in the same file
+    /// @param InBlockSize - Size (in bytes) of the uncompressed records buffered before they're compressed into a block in Stream mode
+    /// @param InDictionaryTrainingFrameCount - Number of frames of each stream the dictionary is trained on in DictionaryRecords mode
+    /// @param bAppend - If true, keep the records already in the stream files and their dictionaries, otherwise start new stream files
+    void Open(ENVAnnotationCompressionMode InCompressionMode, ENVAnnotationCompressionFormat InCompressionFormat, int32 InFramesPerFile, int32 InBlockSize,
+              int32 InDictionaryTrainingFrameCount, bool bAppend);
+
+    /// Write the buffered records and close all the stream files
+    void Close();
+    bool IsOpen() const;
+
+    /// Path of the stream file a frame is written to
+    /// @param StreamFilePathPrefix - Path of the stream's files without their file index and extension
+    FString GetStreamFilePath(const FString& StreamFilePathPrefix, int32 FrameIndex) const;
+
+    /// Path of the dictionary of a stream in DictionaryRecords mode
+    static FString GetDictionaryFilePath(const FString& StreamFilePathPrefix);
+
+    /// Add the annotation data of a frame to its stream file
+    /// NOTE: This function is thread-safe, the records of the other streams are compressed at the same time
+    bool WriteFrame(const FString& StreamFilePathPrefix, int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData);
+
+    /// Compress the buffered records and make sure they're on the disk
+    /// NOTE: The dictionaries which are still waiting for their training frames are trained on the frames received so far
+    void Flush();
+
+    /// Read a stream file back to the annotation data of each frame, in the order they're written
+    /// NOTE: The dictionary of the stream is loaded from the stream's directory if the file need it
+    static bool ReadStreamFile(const FString& StreamFilePath, TFunctionRef<void(int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)> FrameCallback);
+
+protected:
+    /// The files and the compression state of a stream, defined in the cpp
+    struct FStream;
+    typedef TSharedPtr<FStream, ESPMode::ThreadSafe> FStreamPtr;
+
+    FStreamPtr FindOrAddStream(const FString& StreamFilePathPrefix);
+
+protected:
+    /// Map between the path prefix of a stream and its state
+    /// NOTE: WriterLock only guard the map and the settings, each stream has its own lock so the streams are compressed and written in parallel
+    TMap<FString, FStreamPtr> StreamMap;
+
+    ENVAnnotationCompressionMode CompressionMode;
+    ENVAnnotationCompressionFormat CompressionFormat;
+    int32 FramesPerFile;
+    int32 BlockSize;
+    int32 DictionaryTrainingFrameCount;
+    bool bIsOpen;
+    bool bAppendToStreamFiles;
+    mutable FCriticalSection WriterLock;
+};
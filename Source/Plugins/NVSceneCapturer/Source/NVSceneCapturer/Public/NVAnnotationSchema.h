@@ -0,0 +1,144 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "NVAnnotationSchema.generated.h"
+
+struct FCapturedObjectData;
+
+/// The fields of the exported objects an annotation schema can select
+/// NOTE: The name, class and instance id of the objects are always exported, they identify the objects
+UENUM(BlueprintType)
+enum class ENVAnnotationField : uint8
+{
+    /// Location of the object in the camera and world space, and its distance and direction from the viewpoint
+    /// (location, location_worldspace, viewpoint_azimuth_angle, viewpoint_altitude_angle, distance_scale)
+    Location = 0,
+
+    /// Rotation of the object in the camera and world space (quaternion_xyzw, rotation, quaternion_worldspace, rotation_worldspace, bounding_box_forward_direction)
+    Rotation,
+
+    /// Object to camera and object to world transforms (pose_transform, actor_to_camera_matrix, actor_to_world_matrix_ue4, actor_to_world_matrix_opencv)
+    PoseTransform,
+
+    /// Center and size of the object's cuboid (cuboid_centroid, bounding_box_center_worldspace, dimensions_worldspace)
+    CuboidCentroid,
+
+    /// Center and forward direction of the object's cuboid projected on the image (projected_cuboid_centroid, bounding_box_forward_direction_imagespace)
+    ProjectedCuboidCentroid,
+
+    /// 2D bounding box of the object on the image and how much of it is outside of the image (bounding_box, truncated)
+    BoundingBox,
+
+    /// Vertexes of the object's cuboid in the camera space (cuboid)
+    Cuboid,
+
+    /// Vertexes of the object's cuboid projected on the image (projected_cuboid)
+    ProjectedCuboid,
+
+    /// Occlusion level of the object, traced from the viewpoint toward its cuboid vertexes (occluded)
+    /// NOTE: The occlusion and visibility properties are exported with it, they aren't computed
+    Visibility,
+
+    /// Exported sockets of the object's meshes projected on the image (socket_data)
+    Sockets,
+
+    /// The custom data of the annotated actors (custom_data)
+    CustomData,
+
+    /// @cond DOXYGEN_SUPPRESSED_CODE
+    NVAnnotationField_MAX UMETA(Hidden)
+    /// @endcond DOXYGEN_SUPPRESSED_CODE
+};
+
+/// The data of the actors gathered on the game thread to compute the annotation fields
+enum class ENVAnnotationInput : uint8
+{
+    None = 0,
+    Cuboid = 1 << 0,
+    MeshVertexes = 1 << 1,
+    Occlusion = 1 << 2,
+    Sockets = 1 << 3,
+    CustomData = 1 << 4,
+};
+ENUM_CLASS_FLAGS(ENVAnnotationInput)
+
+/// Which fields of the objects an annotation feature extractor export
+USTRUCT(BlueprintType)
+struct NVSCENECAPTURER_API FNVAnnotationSchema
+{
+    GENERATED_BODY()
+
+public:
+    FNVAnnotationSchema();
+
+    /// The fields to export for each object, the data the other fields need are neither gathered nor computed
+    /// NOTE: By default all the fields are exported, the objects are the same as before the schema existed
+    UPROPERTY(EditAnywhere, Category = "Schema")
+    TArray<ENVAnnotationField> ExportedFields;
+};
+
+///
+/// The annotation schema resolved for a capturing session: the fields to compute and export
+/// and the data which must be gathered for them, with their dependencies.
+///
+struct NVSCENECAPTURER_API FNVAnnotationFieldSet
+{
+public:
+    FNVAnnotationFieldSet();
+
+    /// Resolve the fields of the schema and their dependencies
+    /// @param bUseInstanceMaskBoundingBox - If true, the 2D bounding boxes are filled in from the instance mask instead of the mesh vertexes
+    static FNVAnnotationFieldSet Resolve(const FNVAnnotationSchema& Schema, bool bUseInstanceMaskBoundingBox);
+
+    /// Whether the field is computed
+    bool HasField(ENVAnnotationField Field) const
+    {
+        return (FieldMask & GetFieldBit(Field)) != 0;
+    }
+
+    /// Whether the field is written to the exported objects
+    bool IsFieldExported(ENVAnnotationField Field) const
+    {
+        return (ExportedFieldMask & GetFieldBit(Field)) != 0;
+    }
+
+    /// Whether the field set is resolved from a schema, the default one doesn't export anything
+    bool IsResolved() const
+    {
+        return (ExportedProperties.Num() > 0);
+    }
+
+    /// Whether the input must be gathered for the fields
+    bool NeedInput(ENVAnnotationInput Input) const
+    {
+        return EnumHasAnyFlags(Inputs, Input);
+    }
+
+    /// Convert the exported fields of an object to json, in the same order as the full object
+    /// NOTE: Only the exported fields are converted, the omitted ones cost nothing
+    TSharedPtr<FJsonObject> ObjectDataToJsonObject(const FCapturedObjectData& ObjectData) const;
+
+protected:
+    static uint32 GetFieldBit(ENVAnnotationField Field)
+    {
+        return (1u << uint32(Field));
+    }
+
+    /// The fields which are computed: the exported fields and the ones they depend on
+    uint32 FieldMask;
+
+    /// The fields which are exported
+    uint32 ExportedFieldMask;
+
+    ENVAnnotationInput Inputs;
+
+    /// The properties of FCapturedObjectData to export, in their declaration order
+    TArray<const FProperty*> ExportedProperties;
+};
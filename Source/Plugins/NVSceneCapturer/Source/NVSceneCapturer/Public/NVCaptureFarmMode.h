@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NVCaptureFarmMode.generated.h"
+
+class UWorld;
+class AHUD;
+
+/// Settings of the capture farm mode: nobody watch the game viewport while capturing so only the scene capture components render
+USTRUCT(BlueprintType)
+struct NVSCENECAPTURER_API FNVCaptureFarmModeSettings
+{
+    GENERATED_BODY()
+
+public:
+    FNVCaptureFarmModeSettings();
+
+    /// If true, the game viewport's scene, the HUD and the visualizers are not rendered nor updated while capturing
+    UPROPERTY(EditAnywhere, Category = "CaptureFarm")
+    bool bEnabled;
+
+    /// Time (in seconds) between 2 low resolution previews of the game viewport
+    /// NOTE: <= 0 mean the game viewport is never rendered while capturing
+    UPROPERTY(EditAnywhere, Category = "CaptureFarm", meta = (EditCondition = "bEnabled"))
+    float PreviewInterval;
+
+    /// The screen percentage the previews are rendered at
+    UPROPERTY(EditAnywhere, Category = "CaptureFarm", meta = (ClampMin = 1, ClampMax = 100, EditCondition = "bEnabled"))
+    float PreviewScreenPercentage;
+
+    /// Number of frames captured with the game viewport still rendered, to measure the frame times the mode is compared with
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "CaptureFarm", meta = (ClampMin = 0, EditCondition = "bEnabled"))
+    int32 BaselineFrameCount;
+};
+
+/// Average time (in milliseconds) the game thread and the GPU spent on a frame
+struct NVSCENECAPTURER_API FNVFrameTimeStats
+{
+    FNVFrameTimeStats();
+
+    void Reset();
+    /// Sample the engine's game thread and GPU time of the last frame
+    void SampleLastFrame();
+
+    float GetAverageGameThreadTime() const;
+    float GetAverageGPUTime() const;
+
+    int32 SampleCount;
+    double TotalGameThreadTime;
+    double TotalGPUTime;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FNVOnCaptureFarmModeChanged, bool /*bRenderingSuppressed*/);
+
+///
+/// Turn off the game viewport's scene rendering and the HUD while capturing, the scene capture components still render.
+/// The engine and HUD states are saved when the rendering is suppressed and restored when the mode is exited.
+/// The game thread and GPU frame times of the first captured frames are sampled before the rendering is suppressed
+/// then compared with the ones sampled after, to show how much time is recovered.
+/// NOTE: The functions must be called on the game thread
+///
+class NVSCENECAPTURER_API FNVCaptureFarmMode
+{
+public:
+    FNVCaptureFarmMode();
+
+    void Enter(UWorld* World, const FNVCaptureFarmModeSettings& InSettings);
+    void Exit(UWorld* World);
+
+    /// Suppress the rendering after the baseline frames, render the previews and sample the frame times
+    /// NOTE: Should be called once per frame while the mode is active
+    void Tick(UWorld* World, float DeltaTime);
+
+    bool IsActive() const
+    {
+        return bIsActive;
+    }
+
+    /// Whether the game viewport, the HUD and the visualizers are currently turned off
+    bool IsRenderingSuppressed() const
+    {
+        return bRenderingSuppressed;
+    }
+
+    /// Frame times sampled before the rendering is suppressed
+    const FNVFrameTimeStats& GetBaselineFrameTimes() const
+    {
+        return BaselineFrameTimes;
+    }
+
+    /// Frame times sampled while the rendering is suppressed, the preview frames excluded
+    const FNVFrameTimeStats& GetFarmModeFrameTimes() const
+    {
+        return FarmModeFrameTimes;
+    }
+
+    /// Broadcasted when the rendering of any capture farm mode is suppressed or restored, let the other modules hide their widgets (e.g: the HUD overlay)
+    static FNVOnCaptureFarmModeChanged& OnCaptureFarmModeChanged();
+
+protected:
+    void SuppressRendering(UWorld* World);
+    void RestoreRendering(UWorld* World);
+    /// Enable or disable the game viewport's scene rendering
+    void SetWorldRendering(UWorld* World, bool bRenderWorld);
+    void SetPreviewScreenPercentage(bool bPreview);
+    void LogRecoveredFrameTimes() const;
+
+protected:
+    bool bIsActive;
+    bool bRenderingSuppressed;
+    FNVCaptureFarmModeSettings Settings;
+    int32 BaselineFramesLeft;
+
+    /// The game viewport's state before the rendering is suppressed
+    bool bSavedDisableWorldRendering;
+    /// Whether the HUDs were shown before the rendering is suppressed
+    TArray<TPair<TWeakObjectPtr<AHUD>, bool>> SavedHUDVisibilities;
+    float SavedScreenPercentage;
+
+    bool bRenderingPreview;
+    float TimeSinceLastPreview;
+
+    FNVFrameTimeStats BaselineFrameTimes;
+    FNVFrameTimeStats FarmModeFrameTimes;
+};
@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+/// The progress of a capturing session at the time all the data of its frames up to FrameIndex are written to disk
+struct NVSCENECAPTURER_API FNVCaptureCheckpoint
+{
+    /// Index of the last frame whose data are all written to disk
+    int32 FrameIndex = INDEX_NONE;
+
+    /// Index of the scene marker the frames are captured at
+    int32 MarkerIndex = 0;
+
+    /// Seed of the random stream right after this checkpoint
+    int32 RandomSeed = 0;
+
+    /// Paths (relative to the output directory) of the files written since the previous checkpoint
+    TArray<FString> WrittenFiles;
+
+    bool IsValid() const
+    {
+        return (FrameIndex >= 0);
+    }
+
+    FString ToJsonString() const;
+    bool FromJsonString(const FString& JsonString);
+};
+
+///
+/// Append-only journal of the checkpoints of a capturing session, one json object per line.
+/// A crash can only leave the last line incomplete, such line is ignored when the journal is loaded
+/// and cut off when the journal is opened again for appending.
+///
+class NVSCENECAPTURER_API FNVCaptureJournal
+{
+public:
+    FNVCaptureJournal();
+    ~FNVCaptureJournal();
+
+    /// Name of the journal file inside the output directory
+    static const FString JournalFileName;
+
+    /// Open the journal file of an output directory
+    /// @param bAppend - If true, keep the complete checkpoints already in the journal, otherwise start a new journal
+    bool Open(const FString& OutputDirectoryPath, bool bAppend);
+    void Close();
+    bool IsOpen() const;
+
+    /// Write a checkpoint at the end of the journal and flush it to disk
+    bool AppendCheckpoint(const FNVCaptureCheckpoint& Checkpoint);
+
+    /// Find the last complete checkpoint in the journal of an output directory
+    /// @param OutValidByteSize - Size of the part of the journal which only contain complete checkpoints
+    /// @return false if there's no complete checkpoint
+    static bool LoadLastCheckpoint(const FString& OutputDirectoryPath, FNVCaptureCheckpoint& OutCheckpoint, int64* OutValidByteSize = nullptr);
+
+protected:
+    TUniquePtr<IFileHandle> JournalFileHandle;
+};
@@ -0,0 +1,145 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+#include "Async/Future.h"
+#include "NVSceneAnnotationSnapshot.h"
+
+class FJsonObject;
+class UNVSceneFeatureExtractor_AnnotationData;
+class UNVSceneCapturerViewpointComponent;
+
+/// An annotation data gathered on the game thread, held until all the pixels data of its frame are read back
+struct NVSCENECAPTURER_API FNVCapturedAnnotationData
+{
+    TSharedPtr<FJsonObject> AnnotationData;
+    TWeakObjectPtr<UNVSceneFeatureExtractor_AnnotationData> FeatureExtractor;
+    TWeakObjectPtr<UNVSceneCapturerViewpointComponent> Viewpoint;
+
+    /// The scene snapshot the annotation data is built from in the background, if it isn't built on the game thread
+    /// NOTE: The frame own the snapshot so it's released on the game thread, the task only read it
+    TSharedPtr<FNVSceneAnnotationSnapshot, ESPMode::ThreadSafe> Snapshot;
+    TFuture<TSharedPtr<FJsonObject>> BuildTask;
+
+    bool IsBuilt() const
+    {
+        return !BuildTask.IsValid() || BuildTask.IsReady();
+    }
+
+    /// Get the annotation data, wait for the background task to build it if needed
+    TSharedPtr<FJsonObject> GetAnnotationData() const
+    {
+        return BuildTask.IsValid() ? BuildTask.Get() : AnnotationData;
+    }
+};
+
+/// Everything a frame in flight need to be exported correctly, even after the scene moved on to the next frames
+struct NVSCENECAPTURER_API FNVCaptureFrameContext
+{
+    FNVCaptureFrameContext(int32 InFrameIndex, int32 InPendingReadbackCount, double InBeginTime);
+
+    /// Index of the frame, used to label all of its exported data
+    const int32 FrameIndex;
+
+    /// World transforms of the enabled viewpoints at the time the frame is captured
+    TMap<FObjectKey, FTransform> ViewpointTransforms;
+
+    /// Annotation data of the frame, snapshot of the scene at the time the frame is captured
+    TArray<FNVCapturedAnnotationData> Annotations;
+
+    /// Number of pixels data of the frame which are not read back yet
+    /// NOTE: Decreased on the rendering thread
+    FThreadSafeCounter PendingReadbackCounter;
+
+    /// Time (in seconds) when the frame is captured
+    const double BeginTime;
+
+    bool IsCompleted() const;
+
+    /// Build the annotation data of the snapshot on a worker thread, the frame keep it until it's retired
+    void AddAnnotationSnapshot(const FNVSceneAnnotationSnapshotRef& Snapshot, UNVSceneFeatureExtractor_AnnotationData* FeatureExtractor, UNVSceneCapturerViewpointComponent* Viewpoint);
+
+    /// Block until the annotation data of all the snapshots are built
+    void WaitForAnnotationData() const;
+
+    /// Called when a pixels data of the frame is read back, can be called from any thread
+    void OnReadbackCompleted()
+    {
+        PendingReadbackCounter.Decrement();
+    }
+
+    /// Called when some pixels data of the frame won't be read back (e.g: a tile can't be captured), the frame stop waiting for them
+    void OnReadbacksSkipped(int32 SkippedReadbackCount)
+    {
+        PendingReadbackCounter.Subtract(SkippedReadbackCount);
+    }
+};
+
+typedef TSharedRef<FNVCaptureFrameContext, ESPMode::ThreadSafe> FNVCaptureFrameContextRef;
+
+///
+/// Keep track of the frames in flight when capturing with overlapped frames:
+/// the scene of a frame can be set up while the previous frames are still rendered and read back.
+/// The frames can complete in any order but they're always retired in the order they're captured.
+/// NOTE: All the functions must be called on the game thread, only the frame context's readback counter can be updated from other threads
+///
+class NVSCENECAPTURER_API FNVCapturePipeline
+{
+public:
+    FNVCapturePipeline();
+    ~FNVCapturePipeline();
+
+    /// Forget all the frames in flight and change the maximum number of frames in flight
+    void Reset(int32 NewDepth);
+
+    int32 GetDepth() const
+    {
+        return Depth;
+    }
+
+    /// Whether there's room for another frame in flight
+    bool CanBeginFrame() const;
+
+    /// Start tracking a new frame
+    /// @param PendingReadbackCount - Number of pixels data the frame wait for before it can be retired
+    FNVCaptureFrameContextRef BeginFrame(int32 FrameIndex, int32 PendingReadbackCount, double CurrentTime);
+
+    /// Remove the frames which are completed from the pipeline, stop at the first frame still in flight so the frames are retired in order
+    /// @param StaleFrameDuration - The frames which are in flight longer than this (in seconds) are retired even if they're not completed, <= 0 mean no limit
+    /// @return Number of frames retired
+    int32 RetireCompletedFrames(TArray<FNVCaptureFrameContextRef>& OutRetiredFrames, double CurrentTime, double StaleFrameDuration = 0.0);
+
+    /// Remove all the frames from the pipeline, completed or not
+    void RetireAllFrames(TArray<FNVCaptureFrameContextRef>& OutRetiredFrames);
+
+    int32 GetInFlightFrameCount() const
+    {
+        return InFlightFrames.Num();
+    }
+
+    int32 GetRetiredFrameCount() const
+    {
+        return RetiredFrameCount;
+    }
+
+    int32 GetStaleFrameCount() const
+    {
+        return StaleFrameCount;
+    }
+
+protected:
+    int32 Depth;
+
+    /// The frames in flight, sorted by the order they're captured
+    TArray<FNVCaptureFrameContextRef> InFlightFrames;
+
+    int32 RetiredFrameCount;
+    int32 StaleFrameCount;
+};
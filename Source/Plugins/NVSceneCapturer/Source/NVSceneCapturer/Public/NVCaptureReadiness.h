@@ -0,0 +1,160 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderCommandFence.h"
+
+class UWorld;
+
+///
+/// A condition which must be met before the scene can be captured, e.g: all the assets are loaded
+/// NOTE: The conditions are checked on the game thread
+///
+class NVSCENECAPTURER_API INVCaptureReadinessCondition
+{
+public:
+    virtual ~INVCaptureReadinessCondition() {}
+
+    virtual FName GetConditionName() const = 0;
+
+    /// Called when the gate start waiting for the scene to be ready (e.g: after the scene changed)
+    virtual void OnBeginWaiting(UWorld* World) {}
+
+    virtual bool IsReady(UWorld* World) const = 0;
+};
+
+/// The condition is met when there's no asynchronous package loading in progress
+class NVSCENECAPTURER_API FNVCaptureReadinessCondition_AsyncLoading : public INVCaptureReadinessCondition
+{
+public:
+    virtual FName GetConditionName() const override;
+    virtual bool IsReady(UWorld* World) const override;
+};
+
+/// The condition is met when the texture streamer settled: it doesn't have any mips left to stream in,
+/// its pool is over budget or the number of textures waiting for their mips didn't change for a number of frames
+/// NOTE: The streamer never get all the mips it want while its pool is over budget
+class NVSCENECAPTURER_API FNVCaptureReadinessCondition_TextureStreaming : public INVCaptureReadinessCondition
+{
+public:
+    /// @param InMaxStalledFrameCount - Number of frames without progress after which the streamer is considered settled, <= 0 mean never
+    explicit FNVCaptureReadinessCondition_TextureStreaming(int32 InMaxStalledFrameCount = 30);
+
+    virtual FName GetConditionName() const override;
+    virtual void OnBeginWaiting(UWorld* World) override;
+    virtual bool IsReady(UWorld* World) const override;
+
+protected:
+    /// Number of textures which still want more mips, 0 if the texture streaming is disabled
+    virtual int32 GetNumWantingResources() const;
+
+    /// Whether the streaming pool is full so no more mips can be streamed in
+    virtual bool IsStreamingPoolOverBudget() const;
+
+protected:
+    int32 MaxStalledFrameCount;
+
+    /// NOTE: IsReady is called once per frame by the gate, it track the progress of the streamer
+    mutable int32 LastNumWantingResources;
+    mutable int32 StalledFrameCount;
+};
+
+/// The condition is met when the render thread processed all the scene updates made before the gate started waiting
+class NVSCENECAPTURER_API FNVCaptureReadinessCondition_RenderState : public INVCaptureReadinessCondition
+{
+public:
+    virtual FName GetConditionName() const override;
+    virtual void OnBeginWaiting(UWorld* World) override;
+    virtual bool IsReady(UWorld* World) const override;
+
+protected:
+    FRenderCommandFence RenderStateFence;
+};
+
+/// The condition is met when a predicate return true, used for the conditions which don't need any state
+class NVSCENECAPTURER_API FNVCaptureReadinessCondition_Predicate : public INVCaptureReadinessCondition
+{
+public:
+    FNVCaptureReadinessCondition_Predicate(FName InConditionName, TFunction<bool(UWorld*)> InPredicate);
+
+    virtual FName GetConditionName() const override;
+    virtual bool IsReady(UWorld* World) const override;
+
+protected:
+    FName ConditionName;
+    TFunction<bool(UWorld*)> Predicate;
+};
+
+///
+/// Wait for the scene to be ready to be captured: all the conditions must be met for a number of frames in a row,
+/// or the timeout expired
+///
+class NVSCENECAPTURER_API FNVCaptureReadinessGate
+{
+public:
+    FNVCaptureReadinessGate();
+
+    /// Add the default conditions: async loading, texture streaming, render state and the globally registered ones
+    void AddDefaultConditions();
+    void AddCondition(TSharedRef<INVCaptureReadinessCondition> NewCondition);
+    void RemoveAllConditions();
+
+    /// Start waiting for the scene to be ready
+    void BeginWaiting(UWorld* World, double CurrentTime);
+
+    /// Check the conditions, should be called once per frame while waiting
+    /// @return true if the scene is ready or the gate timed out
+    bool Update(UWorld* World, double CurrentTime);
+
+    bool IsWaiting() const
+    {
+        return bIsWaiting;
+    }
+
+    /// Whether the last wait ended because of the timeout
+    bool HasTimedOut() const
+    {
+        return bTimedOut;
+    }
+
+    /// Time (in seconds) spent in the last wait
+    double GetLastWaitDuration() const
+    {
+        return LastWaitDuration;
+    }
+
+    /// Name of the conditions which were not met at the last update
+    FString GetUnmetConditionNames() const;
+
+    /// Let the other modules add their conditions to all the gates, e.g: no pending randomized asset loads
+    static void RegisterGlobalCondition(TSharedRef<INVCaptureReadinessCondition> NewCondition);
+    static void UnregisterGlobalCondition(FName ConditionName);
+
+public:
+    /// Maximum time (in seconds) to wait, <= 0 mean no limit
+    float Timeout;
+
+    /// Name of the owner of the gate in the logs
+    FString GateName;
+
+    /// Number of frames in a row all the conditions must be met
+    int32 MinReadyFrameCount;
+
+protected:
+    static TArray<TSharedRef<INVCaptureReadinessCondition>>& GetGlobalConditions();
+
+protected:
+    TArray<TSharedRef<INVCaptureReadinessCondition>> Conditions;
+    TArray<FName> UnmetConditionNames;
+
+    bool bIsWaiting;
+    bool bTimedOut;
+    double WaitStartTime;
+    double LastWaitDuration;
+    int32 ReadyFrameCount;
+};
@@ -0,0 +1,78 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "NVCaptureRegion.generated.h"
+
+/// Settings of the region of interest mode: only the part of the images around the training objects is read back and exported
+USTRUCT(BlueprintType)
+struct NVSCENECAPTURER_API FNVRegionOfInterestSettings
+{
+    GENERATED_BODY()
+
+public:
+    FNVRegionOfInterestSettings();
+
+    /// If true, the captured images are cropped to the region around the training objects
+    UPROPERTY(EditAnywhere, Category = "RegionOfInterest")
+    bool bEnabled;
+
+    /// Number of pixels added around the projected boxes of the training objects
+    UPROPERTY(EditAnywhere, Category = "RegionOfInterest", meta = (ClampMin = 0, EditCondition = "bEnabled"))
+    int32 Padding;
+
+    /// The region's corners are snapped (outward) to a multiple of this number of pixels
+    UPROPERTY(EditAnywhere, Category = "RegionOfInterest", meta = (ClampMin = 1, EditCondition = "bEnabled"))
+    int32 SnapSize;
+};
+
+///
+/// Helper functions to compute the region of interest of a captured image and to map the coordinates between the full image and the region
+/// NOTE: The annotation data always use the full image's coordinates, the crop is written next to them so the cropped images can be matched
+///
+struct NVSCENECAPTURER_API FNVCaptureRegion
+{
+    /// Compute the region covering all the object boxes
+    /// @param ObjectBoxes   The 2d boxes (in pixels) of the objects, they can be partly outside of the image
+    /// @param ImageSize     The 2d size (in pixels) of the full image
+    /// @param Padding       Number of pixels added around the union of the boxes
+    /// @param SnapSize      The region's corners are snapped outward to a multiple of this number of pixels
+    /// @return The region inside the image, empty if none of the boxes is visible
+    static FIntRect CalculateRegion(const TArray<FBox2D>& ObjectBoxes, const FIntPoint& ImageSize, int32 Padding, int32 SnapSize);
+
+    /// Compute the region of interest of an image from the 3d bounds of its training objects
+    /// @param ObjectBounds         The world bounds of the training objects
+    /// @param ViewProjectionMatrix The view projection matrix of the viewpoint capturing the image
+    /// @return The region around the projected objects, the whole image if none of them is visible or if one is partly behind the camera
+    static FIntRect CalculateRegionOfInterest(const TArray<FBox>& ObjectBounds, const FMatrix& ViewProjectionMatrix, const FIntPoint& ImageSize,
+                                              int32 Padding, int32 SnapSize);
+
+    /// Project the 3d bounds of an object to a 2d box (in pixels) of the image
+    /// @return false if the object is partly behind the camera, its projected box can't be trusted
+    static bool ProjectObjectBounds(const FBox& ObjectBounds, const FMatrix& ViewProjectionMatrix, const FIntPoint& ImageSize, FBox2D& OutObjectBox);
+
+    /// Map a position (in pixels) in the full image to the cropped image
+    static FVector2D ImageToRegionPosition(const FVector2D& ImagePosition, const FIntRect& Region)
+    {
+        return ImagePosition - FVector2D(Region.Min);
+    }
+
+    /// Map a position (in pixels) in the cropped image back to the full image
+    static FVector2D RegionToImagePosition(const FVector2D& RegionPosition, const FIntRect& Region)
+    {
+        return RegionPosition + FVector2D(Region.Min);
+    }
+
+    /// Add the "image_crop" field ({"offset": [x, y], "size": [width, height], "image_size": [width, height]}) to the annotation data
+    static void WriteCropToAnnotationData(const TSharedPtr<FJsonObject>& AnnotationData, const FIntRect& Region, const FIntPoint& ImageSize);
+
+    /// Read the "image_crop" field of the annotation data
+    /// @return false if the annotation data doesn't have a valid crop
+    static bool ReadCropFromAnnotationData(const TSharedPtr<FJsonObject>& AnnotationData, FIntRect& OutRegion, FIntPoint& OutImageSize);
+};
@@ -0,0 +1,112 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NVSceneCapturerUtils.h"
+#include "UObject/ObjectKey.h"
+
+enum class ENVDuplicateFrameDecision : uint8
+{
+    /// The color image of the frame is not checked yet
+    Pending,
+    Accepted,
+    /// The frame is nearly identical to one of the recently accepted frames
+    Dropped,
+};
+
+///
+/// Drop the frames which look nearly identical to the recently accepted frames of the same viewpoint.
+/// The color image of each frame is reduced to a 64 bits difference hash (dHash), a frame is dropped when the hamming distance
+/// between its hash and one of the last accepted hashes is not bigger than the threshold.
+/// All the data of a frame (annotation, masks ...) are held back until the decision for the frame is made.
+/// The decision of a frame is kept until all the data expected for the frame are reported, the data which come after
+/// the decision is forgotten are discarded.
+/// NOTE: All the functions are thread safe
+///
+class NVSCENECAPTURER_API FNVDuplicateFrameFilter
+{
+public:
+    /// The viewpoint and frame index which captured the data
+    typedef TPair<FObjectKey, int32> FFrameKey;
+
+    /// @param InHistoryCount - Number of the last accepted frames of a viewpoint to compare with
+    /// @param InHashDistanceThreshold - Maximum number of different bits (out of 64) between 2 frames to be considered duplicated
+    FNVDuplicateFrameFilter(int32 InHistoryCount, int32 InHashDistanceThreshold);
+
+    /// Calculate the 64 bits difference hash of an image: the image is reduced to a 9x8 grayscale grid
+    /// and each bit tell whether a cell is brighter than its right neighbor
+    /// NOTE: The cells are averaged from a sparse set of pixels so the cost doesn't depend much on the image size
+    /// @return false if the pixel format of the image is not supported
+    static bool CalculateDifferenceHash(const FNVTexturePixelData& ImagePixelData, uint64& OutHash);
+
+    /// Check the color image of a frame and decide whether to keep the frame or not,
+    /// the data held back for the frame are handled (or discarded) right away
+    ENVDuplicateFrameDecision CheckFrame(const FFrameKey& FrameKey, const FNVTexturePixelData& ColorPixelData, const FString& ViewpointName);
+
+    ENVDuplicateFrameDecision GetDecision(const FFrameKey& FrameKey) const;
+
+    /// Record the number of data (other than the checked color image) the frame is going to have,
+    /// the decision of the frame is kept until they are all reported by ConsumeDecision or DeferUntilChecked
+    void ExpectFrameData(const FFrameKey& FrameKey, int32 ExpectedDataCount);
+
+    /// Get the decision of the frame for one of its data, the data is reported if the frame is already decided
+    /// NOTE: Call DeferUntilChecked for the data if the frame is still pending
+    ENVDuplicateFrameDecision ConsumeDecision(const FFrameKey& FrameKey);
+
+    /// Hold back an action handling the frame's data until the frame is checked, the data is reported
+    /// NOTE: The action is run right away if the frame was accepted in the meantime
+    /// @return The decision of the frame when the action was submitted
+    ENVDuplicateFrameDecision DeferUntilChecked(const FFrameKey& FrameKey, TFunction<void()>&& HandleDataAction);
+
+    /// Accept the frame without checking it, e.g: its color image is not captured, the actions held back for it are run
+    void AcceptFrameUnchecked(const FFrameKey& FrameKey);
+
+    /// Forget all the frames, the actions which are still held back are discarded
+    void Reset();
+
+    int32 GetCheckedFrameCount() const;
+    int32 GetDroppedFrameCount() const;
+
+protected:
+    struct FFrameState
+    {
+        ENVDuplicateFrameDecision Decision = ENVDuplicateFrameDecision::Pending;
+        TArray<TFunction<void()>> HeldBackActions;
+
+        /// Number of the expected data of the frame which are not reported yet
+        /// NOTE: May be negative if the data are reported before they are expected
+        int32 UnreportedDataCount = 0;
+    };
+
+    struct FViewpointState
+    {
+        /// The hash and frame index of the last accepted frames, oldest first
+        TArray<TPair<uint64, int32>> AcceptedHashes;
+        TMap<int32, FFrameState> FrameStates;
+
+        /// The decisions of some of the frames before this index are forgotten
+        int32 ForgottenFrameIndexEnd = 0;
+    };
+
+    /// Find the state of the frame the data come from, create it if the frame is not decided yet
+    /// @return nullptr if the decision of the frame is already forgotten
+    FFrameState* FindFrameStateForData(const FFrameKey& FrameKey);
+
+    /// Forget the decided frames which are old enough, the lock must be held
+    void PruneFrameStates(FViewpointState& ViewpointState, int32 LastFrameIndex);
+
+protected:
+    int32 HistoryCount;
+    int32 HashDistanceThreshold;
+
+    TMap<FObjectKey, FViewpointState> ViewpointStates;
+    mutable FCriticalSection StateLock;
+
+    FThreadSafeCounter CheckedFrameCounter;
+    FThreadSafeCounter DroppedFrameCounter;
+};
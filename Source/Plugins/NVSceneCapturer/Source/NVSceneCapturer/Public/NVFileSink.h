@@ -0,0 +1,219 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+class FQueuedThreadPool;
+class FRunnableThread;
+
+/// Statistics of the file writing operations of a file sink
+struct NVSCENECAPTURER_API FNVFileSinkStats
+{
+    /// Number of files which are queued or being written
+    int32 InFlightCount = 0;
+
+    /// Number of IO operations (open, write, close) submitted to the system and not completed yet
+    int32 InFlightOpCount = 0;
+
+    int64 WrittenFileCount = 0;
+    int64 FailedFileCount = 0;
+    int64 WrittenBytes = 0;
+
+    /// Average write throughput since the first file was submitted
+    double BytesPerSecond = 0.0;
+
+    /// Time (in seconds) WriteFile had to wait before the write was queued
+    double AverageSubmitLatency = 0.0;
+    double MaxSubmitLatency = 0.0;
+
+    /// Average number of IO operations submitted to the system at once, 1 if the backend doesn't batch them
+    double AverageBatchSize = 0.0;
+
+    FString ToString() const;
+};
+
+///
+/// Interface of the backends which write the exported files (images, annotation data) to disk
+/// NOTE: All the functions must be thread safe, files are submitted from the game thread, the render thread and the worker threads
+///
+class NVSCENECAPTURER_API INVFileSink
+{
+public:
+    virtual ~INVFileSink() {}
+
+    /// Queue the data to be written to a new file, the directory of the file is created if needed
+    /// NOTE: This may block the caller if there are too many writes in flight
+    /// @param FilePath - Full path of the file to write
+    /// @param FileData - The file content, the sink take the ownership of the data
+    /// @return true if the write is queued
+    virtual bool WriteFile(const FString& FilePath, TArray<uint8>&& FileData) = 0;
+
+    /// Queue a text to be written to a new file
+    bool WriteFile(const FString& FilePath, const FString& FileContent);
+
+    /// Block until all the queued writes are finished
+    virtual void Flush() = 0;
+
+    /// Number of files which are queued or being written
+    virtual int32 GetInFlightCount() const = 0;
+
+    virtual FNVFileSinkStats GetStats() const = 0;
+
+    /// Keep the paths of the files which are successfully written until they are consumed
+    virtual void SetTrackWrittenFiles(bool bTrackWrittenFiles) = 0;
+
+    /// Move out the paths of the files written since the last call
+    /// NOTE: Only the files written while the tracking is on are reported
+    virtual void ConsumeWrittenFilePaths(TArray<FString>& OutFilePaths) = 0;
+
+    /// Create the default file sink of the current platform: the io_uring backend on Linux if the kernel support it,
+    /// the thread pool backend otherwise
+    /// @param MaxInFlightCount - Maximum number of files can be queued at the same time, <= 0 mean no limit
+    static TSharedPtr<INVFileSink, ESPMode::ThreadSafe> CreateFileSink(int32 MaxInFlightCount);
+};
+
+///
+/// Common part of the file sinks: the bounded submission queue, the stats and the tracking of the written files
+///
+class NVSCENECAPTURER_API FNVFileSinkBase : public INVFileSink
+{
+public:
+    explicit FNVFileSinkBase(int32 InMaxInFlightCount);
+
+    virtual void Flush() override;
+    virtual int32 GetInFlightCount() const override;
+    virtual FNVFileSinkStats GetStats() const override;
+    virtual void SetTrackWrittenFiles(bool bTrackWrittenFiles) override;
+    virtual void ConsumeWrittenFilePaths(TArray<FString>& OutFilePaths) override;
+
+protected:
+    /// Reserve a slot in the submission queue, wait for a write to finish if they're all taken,
+    /// the time it took is recorded as the submission latency
+    void ReserveInFlightSlot();
+
+    /// Record the written file and release its slot
+    /// @return The number of files still in flight
+    /// NOTE: Must be the last thing the write task touch in the sink, Flush() let the sink be destroyed right after this
+    int32 OnFileWritten(const FString& FilePath, bool bSucceeded, int64 FileSize);
+
+    /// Write the file with a blocking open/write/close on the calling thread
+    /// NOTE: The exporter create the directories ahead of the files, the directory tree is only created when the file can't be opened
+    static bool WriteFileBlocking(const FString& FilePath, const TArray<uint8>& FileData);
+
+    /// Events the writes signal, the write tasks hold a reference so they can signal them after the sink is destroyed
+    struct FWriteEvents
+    {
+        FWriteEvents();
+        ~FWriteEvents();
+
+        /// Signal a written file
+        /// @param RemainInFlightCount - The number of files still in flight returned by OnFileWritten
+        void OnFileWritten(int32 RemainInFlightCount);
+
+        /// Triggered each time a file is written, wake up one of the submitters waiting for a slot
+        FEvent* SlotFreedEvent;
+
+        /// Triggered when there's no file in flight any more
+        FEvent* IdleEvent;
+    };
+
+protected:
+    int32 MaxInFlightCount;
+
+    std::atomic<int32> InFlightCount;
+    TSharedRef<FWriteEvents, ESPMode::ThreadSafe> WriteEvents;
+
+    mutable FCriticalSection StatsLock;
+    FNVFileSinkStats Stats;
+    double FirstSubmitTime;
+    double LastWrittenTime;
+    double TotalSubmitLatency;
+    int64 SubmittedFileCount;
+
+    /// The IO operations submitted to the system, the backends without batching count each blocking file write as one
+    std::atomic<int32> InFlightOpCount;
+    int64 SubmittedOpCount;
+    int64 SubmitBatchCount;
+
+    FThreadSafeBool bTrackWrittenFiles;
+    TArray<FString> WrittenFilePaths;
+};
+
+///
+/// Portable file sink: each file is opened, written and closed by a dedicated pool of writer threads
+/// so the capturing and compressing threads never wait for the disk unless the submission queue is full.
+///
+class NVSCENECAPTURER_API FNVFileSink_ThreadPool : public FNVFileSinkBase
+{
+public:
+    FNVFileSink_ThreadPool(int32 InMaxInFlightCount, int32 WriterThreadCount);
+    virtual ~FNVFileSink_ThreadPool();
+
+    using INVFileSink::WriteFile;
+    virtual bool WriteFile(const FString& FilePath, TArray<uint8>&& FileData) override;
+
+protected:
+    FQueuedThreadPool* WriterThreadPool;
+};
+
+#if PLATFORM_LINUX
+///
+/// Linux file sink: the open, write and close operations of all the queued files are batched into an io_uring
+/// by a single submission thread, so many files cost a few system calls instead of 3 blocking ones each.
+/// The missing directories are only created when an open fail because of them.
+/// NOTE: Need a kernel >= 5.6 (IORING_OP_OPENAT, IORING_OP_CLOSE), Create() return null if it's not supported
+///
+class NVSCENECAPTURER_API FNVFileSink_IoUring : public FNVFileSinkBase, public FRunnable
+{
+public:
+    /// Create the sink if the kernel support all the operations it need
+    /// @param QueueDepth - Maximum number of files being opened, written or closed by the kernel at the same time
+    static TSharedPtr<FNVFileSink_IoUring, ESPMode::ThreadSafe> Create(int32 InMaxInFlightCount, int32 QueueDepth = 256);
+    virtual ~FNVFileSink_IoUring();
+
+    using INVFileSink::WriteFile;
+    virtual bool WriteFile(const FString& FilePath, TArray<uint8>&& FileData) override;
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+protected:
+    struct FRing;
+    struct FWriteRequest;
+
+    FNVFileSink_IoUring(int32 InMaxInFlightCount, TUniquePtr<FRing>&& InRing);
+
+    /// Queue the next operation of a file in the submission ring
+    void PrepareNextOperation(FWriteRequest& WriteRequest);
+
+    /// Move a file to its next operation once the kernel completed the current one
+    void OnOperationCompleted(FWriteRequest* WriteRequest, int32 OperationResult);
+
+    void FinishRequest(FWriteRequest* WriteRequest);
+
+    /// Give up on the ring after an unexpected submission error: the files it hold are failed and the next ones are written synchronously
+    void OnRingFailed(int32 ErrorCode);
+
+protected:
+    TUniquePtr<FRing> Ring;
+    FRunnableThread* SubmissionThread;
+    FThreadSafeBool bStopping;
+
+    /// The files queued by WriteFile and not picked up by the submission thread yet
+    TQueue<FWriteRequest*, EQueueMode::Mpsc> PendingRequests;
+    FEvent* PendingRequestEvent;
+
+    /// The files the kernel is working on, only used by the submission thread
+    TSet<FWriteRequest*> ActiveRequests;
+    bool bRingFailed;
+};
+#endif // PLATFORM_LINUX
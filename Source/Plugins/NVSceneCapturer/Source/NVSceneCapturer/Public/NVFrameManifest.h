@@ -0,0 +1,45 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+///
+/// Append-only list of the data exported in each frame of each viewpoint, one json object per line, e.g:
+/// {"frame_index":12,"viewpoint":"Left","files":{"Color":"000012.png","Annotation":"000012.json"}}
+/// The feature extractors which skip a frame because of their capture cadence are not listed in it.
+/// NOTE: A resumed session capture the frames after the last checkpoint again, the last entry of a frame is the valid one
+///
+class NVSCENECAPTURER_API FNVFrameManifest
+{
+public:
+    FNVFrameManifest();
+    ~FNVFrameManifest();
+
+    /// Name of the manifest file inside the output directory
+    static const FString ManifestFileName;
+
+    /// Open the manifest file of an output directory
+    /// @param bAppend - If true, keep the entries already in the manifest, otherwise start a new manifest
+    bool Open(const FString& OutputDirectoryPath, bool bAppend);
+    void Close();
+    bool IsOpen() const;
+
+    /// Write the entry of a frame at the end of the manifest
+    /// @param ExportedFiles - Pairs of the feature extractor name and the path of its exported file (relative to the output directory)
+    /// NOTE: This function is thread-safe
+    bool AppendFrameEntry(int32 FrameIndex, const FString& ViewpointName, const TArray<TPair<FString, FString>>& ExportedFiles);
+
+    /// Make sure all the entries written so far are on the disk
+    void Flush();
+
+protected:
+    TUniquePtr<IFileHandle> ManifestFileHandle;
+    mutable FCriticalSection ManifestLock;
+};
@@ -0,0 +1,58 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NVFrameVisibilityFilter.generated.h"
+
+/// Settings of the frame visibility filter: the frames where the viewpoints don't see enough training objects are not captured
+USTRUCT(BlueprintType)
+struct NVSCENECAPTURER_API FNVFrameVisibilitySettings
+{
+    GENERATED_BODY()
+
+public:
+    FNVFrameVisibilitySettings();
+
+    /// If true, the frames are checked before they're rendered and the ones without enough visible training objects are rejected
+    UPROPERTY(EditAnywhere, Category = "FrameVisibility")
+    bool bEnabled;
+
+    /// Minimum number of training objects each viewpoint must see
+    UPROPERTY(EditAnywhere, Category = "FrameVisibility", meta = (ClampMin = 1, EditCondition = "bEnabled"))
+    int32 MinVisibleObjectCount;
+
+    /// Minimum fraction (0 - 1) of the image a training object's projected box must cover to be counted as visible
+    UPROPERTY(EditAnywhere, Category = "FrameVisibility", meta = (ClampMin = 0, ClampMax = 1, EditCondition = "bEnabled"))
+    float MinProjectedArea;
+
+    /// Maximum number of frames rejected in a row, the next frame is captured anyway so the capturing never stall
+    /// (e.g: the training objects are hidden or out of the viewpoints' reach)
+    /// NOTE: <= 0 mean no limit
+    UPROPERTY(EditAnywhere, Category = "FrameVisibility", meta = (UIMin = 0, EditCondition = "bEnabled"))
+    int32 MaxConsecutiveRejectedFrames;
+};
+
+///
+/// Helper functions to count the training objects a view can see, using their bounding boxes
+/// NOTE: The occlusion between the objects is not taken into account
+///
+struct NVSCENECAPTURER_API FNVFrameVisibilityFilter
+{
+    /// Check whether a box is inside or intersect the view frustum
+    static bool IsBoxInFrustum(const FMatrix& ViewProjectionMatrix, const FBox& Bounds);
+
+    /// The fraction (0 - 1) of the image the projected box covers, clipped to the image
+    /// NOTE: Return 1 when the box is partly behind the camera since its projection can't be trusted
+    static float CalculateProjectedArea(const FMatrix& ViewProjectionMatrix, const FBox& Bounds);
+
+    /// Count the boxes which are in the view frustum and cover at least MinProjectedArea of the image
+    static int32 CountVisibleObjects(const FMatrix& ViewProjectionMatrix, const TArray<FBox>& ObjectBounds, float MinProjectedArea);
+
+    /// Check whether a view see enough objects to be captured
+    static bool HasEnoughVisibleObjects(const FNVFrameVisibilitySettings& Settings, const FMatrix& ViewProjectionMatrix, const TArray<FBox>& ObjectBounds);
+};
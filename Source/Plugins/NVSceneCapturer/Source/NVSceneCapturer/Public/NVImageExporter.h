@@ -9,8 +9,13 @@
 #include "NVSceneCapturerUtils.h"
 #include "HAL/Runnable.h"
 #include "IImageWrapper.h"
+#include "NVFileSink.h"
+#include "NVTiledCapture.h"
+#include "NVInstanceClassRemap.h"
 #include "NVImageExporter.generated.h"
 
+class IFileHandle;
+
 USTRUCT()
 struct NVSCENECAPTURER_API FNVImageExporterData
 {
@@ -26,6 +31,12 @@ public:
 	UPROPERTY()
 	ENVImageFormat ExportImageFormat;
 
+    /// If valid, the pixels are an instance mask which is also remapped to a class mask with this lookup table
+    TSharedPtr<const FNVInstanceClassLUT, ESPMode::ThreadSafe> InstanceClassLUT;
+
+    /// Where to export the class mask remapped from the instance mask
+    FString ClassMaskExportFilePath;
+
 public:
 	FNVImageExporterData();
     FNVImageExporterData(const FNVTexturePixelData& InPixelDataToBeExported,
@@ -57,7 +68,8 @@ public:
                                        uint8 CompressionQuality = 100);
 
     /// Export an in-memory image to file on disk
-    static bool ExportImage(IImageWrapperModule* ImageWrapperModule, const FNVImageExporterData& ImageExporterData);
+    /// @param FileSink  If valid, the compressed image is queued to be written by this sink instead of being written right away
+    static bool ExportImage(IImageWrapperModule* ImageWrapperModule, const FNVImageExporterData& ImageExporterData, INVFileSink* FileSink = nullptr);
 
 	bool ExportImage(const FNVImageExporterData& ImageExporterData);
 
@@ -68,13 +80,20 @@ protected:
 struct NVSCENECAPTURER_API FNVImageExporter_Thread : public FRunnable
 {
 public:
-    FNVImageExporter_Thread(IImageWrapperModule* InImageWrapperModule);
+    FNVImageExporter_Thread(IImageWrapperModule* InImageWrapperModule, TSharedPtr<INVFileSink, ESPMode::ThreadSafe> InFileSink = nullptr);
     ~FNVImageExporter_Thread();
 
     bool ExportImage(const FNVTexturePixelData& ExportPixelData,
                      const FString& ExportFilePath,
 					 const ENVImageFormat ExportImageFormat = ENVImageFormat::PNG);
 
+    /// Export an instance mask, then remap it to a class mask and export it too, on the same worker
+    bool ExportInstanceMask(const FNVTexturePixelData& InstanceMaskPixelData,
+                            const FString& ExportFilePath,
+                            const ENVImageFormat ExportImageFormat,
+                            const TSharedPtr<const FNVInstanceClassLUT, ESPMode::ThreadSafe>& InstanceClassLUT,
+                            const FString& ClassMaskExportFilePath);
+
     virtual uint32 Run();
     virtual void Stop() override;
     void Kill();
@@ -90,7 +109,81 @@ protected:
 
     IImageWrapperModule* ImageWrapperModule;
 
+    /// Where to write the compressed images, if not valid the images are written by the exporting tasks themselves
+    TSharedPtr<INVFileSink, ESPMode::ThreadSafe> FileSink;
+
     FEvent* HavePendingImageEvent;
     FThreadSafeCounter PendingImageCounter;
     TSharedPtr<FThreadSafeCounter, ESPMode::ThreadSafe> ExportingImageCounterPtr;
-};
\ No newline at end of file
+};
+
+///
+/// Write a tiled image to a PNG file band by band as its tiles are read back, the full image is never held in memory.
+/// A band is a row of tiles: the tiles are copied into their band, when all the tiles of a band are added its rows are
+/// compressed and written to the file and its memory is released.
+/// NOTE: The functions can be called from any thread
+///
+class NVSCENECAPTURER_API FNVImageBandWriter
+{
+public:
+    FNVImageBandWriter();
+    ~FNVImageBandWriter();
+
+    /// Prepare the writer, the file is only created when the first band is written
+    /// @return false if the pixel format can't be exported
+    bool Init(const FString& InFilePath, const FNVCaptureTile& Tile, EPixelFormat InPixelFormat);
+
+    /// Copy the pixels data of a tile into its band
+    /// @return true if the band of the tile is completed and can be written
+    bool AddTile(const FNVTexturePixelData& TilePixelsData, const FNVCaptureTile& Tile);
+
+    /// Write the completed bands which are next in the file, close the file after the last band is written
+    void WriteCompletedBands();
+
+    /// Check whether all the bands of the image are written
+    bool IsCompleted() const;
+
+    const FString& GetFilePath() const
+    {
+        return FilePath;
+    }
+
+protected:
+    /// Create the file and write the PNG header
+    bool BeginImage();
+    /// Compress and write the rows of a band
+    bool WriteRows(const uint8* RowsData, int32 RowCount);
+    /// Finish the PNG stream
+    bool EndImage();
+    /// Release the libpng structs and close the file
+    void ReleaseImage();
+
+protected:
+    FString FilePath;
+    EPixelFormat PixelFormat;
+    FIntPoint ImageSize;
+    FIntPoint TileSize;
+    FIntPoint GridSize;
+    int32 PixelByteSize;
+    uint8 ImageBitDepth;
+    ERGBFormat ImageRGBFormat;
+
+    /// The pixel rows of a band waiting for all of its tiles
+    struct FBand
+    {
+        FBand() : AddedTileCount(0) {}
+
+        TArray<uint8> Pixels;
+        int32 AddedTileCount;
+    };
+    TMap<int32, FBand> PendingBands;
+    FCriticalSection PendingBandsLock;
+
+    /// The bands are written by one thread at a time, in order
+    FCriticalSection WriteLock;
+    TUniquePtr<IFileHandle> FileHandle;
+    // NOTE: The libpng structs are kept opaque so png.h isn't included in the header
+    void* PNGWriteStruct;
+    void* PNGInfoStruct;
+    FThreadSafeCounter WrittenBandCount;
+};
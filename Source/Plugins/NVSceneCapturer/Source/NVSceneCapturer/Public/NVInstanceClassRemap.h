@@ -0,0 +1,76 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NVSceneCapturerUtils.h"
+
+///
+/// Dense lookup table between the instance segmentation ids (vertex color mask) and the class segmentation ids (stencil mask).
+/// The instance ids are given sequentially or spread evenly by a constant step so the table is indexed by InstanceId / IdStep
+/// and stay as small as the number of instances.
+/// NOTE: The table is immutable once built, a new one (with a new version) is built each time the segmentation masks are updated
+/// so the frames in flight keep using the table of the scene they're captured in.
+///
+struct NVSCENECAPTURER_API FNVInstanceClassLUT
+{
+public:
+    FNVInstanceClassLUT();
+
+    /// Build the table from the instance id and class id pairs
+    /// @param InstanceClassIds  Map between the instance ids and the class ids, the instances without class use 0
+    /// @param InIdStep          The step between 2 consecutive instance ids (1 if they're given sequentially)
+    /// @param InVersion         The version of the segmentation masks the ids come from
+    void Build(const TMap<uint32, uint8>& InstanceClassIds, uint32 InIdStep, int32 InVersion);
+
+    FORCEINLINE uint8 GetClassId(uint32 InstanceId) const
+    {
+        const uint32 TableIndex = (IdStep > 1) ? (InstanceId / IdStep) : InstanceId;
+        return (TableIndex < (uint32)ClassIds.Num()) ? ClassIds[TableIndex] : 0;
+    }
+
+    bool IsValid() const
+    {
+        return (ClassIds.Num() > 0);
+    }
+
+    int32 GetVersion() const
+    {
+        return Version;
+    }
+
+    uint32 GetIdStep() const
+    {
+        return IdStep;
+    }
+
+    int32 Num() const
+    {
+        return ClassIds.Num();
+    }
+
+protected:
+    /// The class id of each instance, indexed by InstanceId / IdStep
+    /// NOTE: Index 0 is the background
+    TArray<uint8> ClassIds;
+    uint32 IdStep;
+    int32 Version;
+};
+
+///
+/// Convert an instance segmentation mask (vertex color) into a class segmentation mask (8 bits, same ids as the stencil mask)
+/// on the CPU, so only the instance mask need to be rendered.
+///
+struct NVSCENECAPTURER_API FNVInstanceClassRemap
+{
+    /// Remap every pixel of the instance mask to its class id
+    /// NOTE: Only 8 bit per channel RGBA/BGRA buffers are supported, the instance id is encoded the same way as NVSceneCapturerUtils::ConvertInt32ToVertexColor
+    /// @param InstanceMaskPixelData  The instance mask pixels read back from the vertex color feature extractor
+    /// @param OutClassMaskPixelData  The class mask, tightly packed PF_G8 pixels of the same size
+    /// @return true if the mask was remapped
+    static bool Remap(const FNVTexturePixelData& InstanceMaskPixelData, const FNVInstanceClassLUT& InstanceClassLUT, FNVTexturePixelData& OutClassMaskPixelData);
+};
@@ -0,0 +1,143 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NVSceneCapturerUtils.h"
+#include "UObject/ObjectKey.h"
+#include "NVFileSink.h"
+
+/// Visible footprint of a single instance id in the instance segmentation mask
+struct NVSCENECAPTURER_API FNVInstanceMaskObjectStats
+{
+    /// Top-left most pixel (inclusive) covered by the instance
+    FIntPoint Min = FIntPoint(MAX_int32, MAX_int32);
+    /// Bottom-right most pixel (inclusive) covered by the instance
+    FIntPoint Max = FIntPoint(MIN_int32, MIN_int32);
+    /// Number of pixels covered by the instance
+    uint32 PixelCount = 0;
+
+    /// Add a horizontal run of Length pixels starting at (X, Y)
+    FORCEINLINE void AddRun(int32 X, int32 Y, int32 Length)
+    {
+        Min.X = FMath::Min(Min.X, X);
+        Max.X = FMath::Max(Max.X, X + Length - 1);
+        Min.Y = FMath::Min(Min.Y, Y);
+        Max.Y = FMath::Max(Max.Y, Y);
+        PixelCount += Length;
+    }
+
+    /// The visible 2d box in pixel coordinates, the max corner is exclusive so it match the vertex projected box
+    FBox2D GetBox2D() const;
+};
+
+///
+/// Per-instance statistics (visible 2d bounding box and pixel count) accumulated from an instance mask (vertex color) buffer.
+/// The mask is scanned once, row by row, and the id map is only touched when the instance id change along a row
+/// so the cost is linear in the number of pixels and mostly bound by memory bandwidth.
+///
+struct NVSCENECAPTURER_API FNVInstanceMaskStats
+{
+public:
+    FNVInstanceMaskStats();
+
+    /// Scan the instance mask pixels and accumulate the per-instance statistics
+    /// NOTE: Only 8 bit per channel RGBA/BGRA buffers are supported, the instance id is encoded the same way as NVSceneCapturerUtils::ConvertInt32ToVertexColor
+    /// @param MaskPixelData - The instance mask pixels read back from the vertex color feature extractor
+    /// @return true if the buffer was scanned
+    bool Scan(const FNVTexturePixelData& MaskPixelData);
+
+    /// Add the "visible_bbox" and "visible_pixel_count" fields to each object in the annotation data, matched by its instance_id
+    /// @param AnnotationData - The scene annotation data (the "objects" array) captured in the same frame as the mask
+    /// @param bExportImageCoordinateInPixel - If false, the box is normalized by the mask's size
+    /// @param bOverrideBoundingBox - If true, the "bounding_box" field is replaced by the visible box too
+    /// @param SkippedInstanceIds - The objects with these instance ids are left as is, their instance mask color isn't reliable (e.g: mesh instances)
+    void ApplyToAnnotationData(const TSharedPtr<FJsonObject>& AnnotationData, bool bExportImageCoordinateInPixel, bool bOverrideBoundingBox,
+                               const TSet<uint32>* SkippedInstanceIds = nullptr) const;
+
+    const FNVInstanceMaskObjectStats* Find(uint32 InstanceId) const
+    {
+        return ObjectStats.Find(InstanceId);
+    }
+
+    void Reset();
+
+public:
+    /// Size of the scanned mask
+    FIntPoint ImageSize;
+
+    /// Map between the instance id and its statistics
+    /// NOTE: The background (id 0) is not included
+    TMap<uint32, FNVInstanceMaskObjectStats> ObjectStats;
+};
+
+///
+/// Pair the annotation data with the instance mask captured by the same viewpoint in the same frame,
+/// scan the mask on a worker thread then export the annotation data with the visible bounding boxes filled in.
+/// NOTE: The annotation data usually come first (game thread) and the mask later (render thread read back) but both orders are handled.
+///
+class NVSCENECAPTURER_API FNVInstanceMaskAnnotationMerger : public TSharedFromThis<FNVInstanceMaskAnnotationMerger, ESPMode::ThreadSafe>
+{
+public:
+    /// The viewpoint and frame index which captured the data
+    typedef TPair<FObjectKey, int32> FFrameKey;
+
+    /// @param InFileSink - Where to write the annotation files, if not valid they are written right away
+    FNVInstanceMaskAnnotationMerger(TSharedPtr<INVFileSink, ESPMode::ThreadSafe> InFileSink = nullptr);
+    ~FNVInstanceMaskAnnotationMerger();
+
+    /// Export the merged annotation data somewhere else than its own json file (e.g: a sequence annotation file)
+    typedef TFunction<void(const TSharedPtr<FJsonObject>& AnnotationData)> FExportAnnotationDataFunction;
+
+    /// Queue the annotation data to be exported once the instance mask of the same frame is scanned
+    /// @param ExportFunction - If set, called to export the merged annotation data instead of writing it to ExportFilePath
+    /// @param SkippedInstanceIds - The instance ids of the objects which don't get the visible bounding box (see FNVInstanceMaskStats::ApplyToAnnotationData)
+    void AddAnnotationData(const FFrameKey& FrameKey, const TSharedPtr<FJsonObject>& AnnotationData, const FString& ExportFilePath, bool bExportImageCoordinateInPixel,
+                           FExportAnnotationDataFunction ExportFunction = nullptr, TSharedPtr<const TSet<uint32>, ESPMode::ThreadSafe> SkippedInstanceIds = nullptr);
+
+    /// Scan the instance mask on a worker thread and export the annotation data waiting for it
+    void AddInstanceMask(const FFrameKey& FrameKey, const FNVTexturePixelData& MaskPixelData);
+
+    /// The instance mask of the frame is not captured (e.g: capture cadence), export its annotation data as is
+    void SkipInstanceMask(const FFrameKey& FrameKey);
+
+    /// Whether there are annotation data waiting for their mask or masks being scanned
+    bool IsHandlingData() const;
+
+    /// Wait for the masks being scanned, then export all the waiting annotation data as is and forget the scanned masks which are not claimed
+    /// NOTE: The annotation data are exported (queued to the file sink or given to their export function) when this return
+    void Flush();
+
+protected:
+    struct FPendingAnnotationData
+    {
+        TSharedPtr<FJsonObject> AnnotationData;
+        FString ExportFilePath;
+        bool bExportImageCoordinateInPixel;
+        FExportAnnotationDataFunction ExportFunction;
+        TSharedPtr<const TSet<uint32>, ESPMode::ThreadSafe> SkippedInstanceIds;
+    };
+
+    struct FPendingFrameData
+    {
+        TArray<FPendingAnnotationData> AnnotationDataList;
+        TSharedPtr<FNVInstanceMaskStats, ESPMode::ThreadSafe> MaskStats;
+        bool bMaskSkipped = false;
+    };
+
+    void ExportAnnotationData(const FPendingAnnotationData& PendingData, const FNVInstanceMaskStats* MaskStats) const;
+
+protected:
+    TSharedPtr<INVFileSink, ESPMode::ThreadSafe> FileSink;
+
+    TMap<FFrameKey, FPendingFrameData> PendingFrameDataMap;
+    mutable FCriticalSection PendingFrameDataLock;
+    FThreadSafeCounter ScanningMaskCounter;
+
+    /// Triggered when the last mask being scanned is done
+    FEvent* ScanFinishedEvent;
+};
@@ -0,0 +1,187 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Engine/AssetUserData.h"
+#include "NVMeshGeometry.generated.h"
+
+class UStaticMesh;
+class UPhysicsAsset;
+
+/// Geometry of a static mesh the annotation need, it only depend on the mesh so it's computed once and shared by all the mesh's instances
+USTRUCT()
+struct NVSCENECAPTURER_API FNVMeshGeometryData
+{
+    GENERATED_BODY()
+
+public:
+    FNVMeshGeometryData();
+
+    /// Signature of the mesh geometry the data is computed from, the data is stale once the mesh's signature changed
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    uint32 SourceSignature;
+
+    /// Number of vertexes of the LOD0 render data
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    int32 VertexCount;
+
+    /// Bounds of the LOD0 render vertexes, in the mesh space
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    FBox RenderBounds;
+
+    /// Bounds of the simple convex collision vertexes, in the mesh space. Invalid if the mesh doesn't have any
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    FBox CollisionBounds;
+
+    /// Frame of the principal component analysis of the vertexes, in the mesh space
+    /// NOTE: The origin is the mean vertex and the Z axis is the dominant direction
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    FVector PCACenter;
+
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    FVector PCAAxisX;
+
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    FVector PCAAxisY;
+
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    FVector PCAAxisZ;
+
+    /// Tight oriented bounding box of the vertexes, in the PCA frame
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    FBox PCABounds;
+
+    /// Decimated hull of the vertexes: the vertexes the hull is the furthest along in a fixed set of directions, in the mesh space
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    TArray<FVector> HullVertexes;
+
+    bool IsValid() const
+    {
+        return (VertexCount > 0);
+    }
+
+    /// The PCA frame, transform from the PCA frame to the mesh space
+    FMatrix GetPCAMatrix() const
+    {
+        return FMatrix(PCAAxisX, PCAAxisY, PCAAxisZ, PCACenter);
+    }
+};
+
+///
+/// The math kernels the mesh geometry is computed with, they don't depend on any UObject
+///
+struct NVSCENECAPTURER_API FNVMeshGeometryMath
+{
+    /// Principal component analysis of the vertexes
+    /// @return The PCA frame: the rows are the axes (Z is the dominant direction, the frame is right handed) and the origin is the mean vertex
+    static FMatrix CalculatePCA(const TArray<FVector>& Vertexes);
+
+    /// The dominant eigen vector of a symmetric 3x3 matrix, using the power method
+    static FVector ComputeDominantEigenVector(const FMatrix& Mat);
+
+    /// Bounds of the vertexes in a frame, the frame's axes must be orthonormal
+    static FBox CalculateBoundsInFrame(const TArray<FVector>& Vertexes, const FMatrix& Frame);
+
+    /// Decimate the hull of the vertexes: keep the vertexes the furthest along each direction of a fibonacci sphere
+    /// @param DirectionCount - Number of directions to check, the maximum number of vertexes kept
+    static void CalculateHullVertexes(const TArray<FVector>& Vertexes, int32 DirectionCount, TArray<FVector>& OutHullVertexes);
+
+    /// Compute all the geometry data from the vertexes of a mesh
+    /// @param RenderVertexes    - The LOD0 render vertexes, the PCA and the hull are computed from them
+    /// @param CollisionVertexes - The simple convex collision vertexes, the PCA and the hull use them if there isn't any render vertex
+    static void BuildMeshGeometry(const TArray<FVector>& RenderVertexes, const TArray<FVector>& CollisionVertexes, FNVMeshGeometryData& OutGeometryData);
+};
+
+/// The geometry of a static mesh baked in the mesh asset, so it doesn't need to be computed at runtime
+UCLASS(ClassGroup = (NVIDIA))
+class NVSCENECAPTURER_API UNVMeshGeometryUserData : public UAssetUserData
+{
+    GENERATED_BODY()
+
+public:
+    UPROPERTY(VisibleAnywhere, Category = "Geometry")
+    FNVMeshGeometryData GeometryData;
+};
+
+///
+/// Give access to the geometry of the static meshes: read from their baked user data when it's up to date,
+/// otherwise computed the first time it's needed and kept in memory.
+/// NOTE: All the functions must be called on the game thread
+///
+class NVSCENECAPTURER_API FNVMeshGeometryCache
+{
+public:
+    /// Get the geometry of the mesh
+    /// @return nullptr if the mesh doesn't have any vertex
+    static const FNVMeshGeometryData* FindOrBuild(const UStaticMesh* StaticMesh);
+
+    /// Compute the geometry of the mesh from its vertexes
+    static bool BuildMeshGeometry(const UStaticMesh* StaticMesh, FNVMeshGeometryData& OutGeometryData);
+
+    /// Store the geometry of the mesh in its user data
+    /// @param bForce - If false, the mesh's user data is only updated if it's missing or stale
+    /// @return true if the mesh's user data changed and the mesh need to be saved
+    static bool BakeMeshGeometry(UStaticMesh* StaticMesh, bool bForce = false);
+
+    /// Signature of the mesh geometry, changed when the mesh's vertexes or collision changed
+    static uint32 CalculateSourceSignature(const UStaticMesh* StaticMesh);
+
+    /// Forget all the geometry computed at runtime
+    static void Reset();
+
+protected:
+    static TMap<FObjectKey, TUniquePtr<FNVMeshGeometryData>> RuntimeGeometries;
+};
+
+/// The shape of a physics asset's body, in the space of the bone it's attached to
+struct NVSCENECAPTURER_API FNVSkeletalBodyHull
+{
+    FName BoneName;
+
+    /// The vertexes of the body's shapes: the convex vertexes, the box corners and points sampled on the spheres and capsules
+    TArray<FVector3f> Vertexes;
+
+    /// The 8 corners of the bounds of the vertexes, a coarser approximation of the body
+    TArray<FVector3f> BoundsCorners;
+};
+
+/// The shapes of all the bodies of a physics asset
+struct NVSCENECAPTURER_API FNVSkeletalBodyHulls
+{
+    uint32 SourceSignature = 0;
+    TArray<FNVSkeletalBodyHull> Bodies;
+};
+
+/// NOTE: The hulls are immutable once built so the annotation threads can share them while the cache rebuild a stale one
+typedef TSharedPtr<const FNVSkeletalBodyHulls, ESPMode::ThreadSafe> FNVSkeletalBodyHullsPtr;
+
+///
+/// Give access to the body shapes of the physics assets: built the first time they're needed and kept in memory,
+/// so the skeletal meshes only need to transform them by their bones each frame.
+/// NOTE: All the functions must be called on the game thread
+///
+class NVSCENECAPTURER_API FNVSkeletalBodyHullCache
+{
+public:
+    /// Get the body shapes of the physics asset
+    /// @return nullptr if the physics asset doesn't have any body
+    static FNVSkeletalBodyHullsPtr FindOrBuild(const UPhysicsAsset* PhysicsAsset);
+
+    /// Compute the body shapes of the physics asset from its body setups
+    static void BuildBodyHulls(const UPhysicsAsset* PhysicsAsset, FNVSkeletalBodyHulls& OutBodyHulls);
+
+    /// Signature of the physics asset's bodies, changed when a body or one of its shapes changed
+    static uint32 CalculateSourceSignature(const UPhysicsAsset* PhysicsAsset);
+
+    /// Forget all the body shapes
+    static void Reset();
+
+protected:
+    static TMap<FObjectKey, FNVSkeletalBodyHullsPtr> RuntimeHulls;
+};
@@ -0,0 +1,64 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+class UMeshComponent;
+
+/// A socket of a mesh resolved to the bone it's attached to
+struct NVSCENECAPTURER_API FNVMeshSocketTableEntry
+{
+    FString SocketName;
+
+    /// Index of the bone in the skeletal mesh's reference skeleton, INDEX_NONE if the socket is attached to the component itself
+    int32 BoneIndex = INDEX_NONE;
+
+    /// Transform of the socket relative to its bone (or to the component)
+    FTransform LocalTransform;
+};
+
+/// The sockets of a mesh to export, in the same order as the mesh component's GetAllSocketNames
+struct NVSCENECAPTURER_API FNVMeshSocketTable
+{
+    uint32 SourceSignature = 0;
+    TArray<FNVMeshSocketTableEntry> Entries;
+};
+
+typedef TSharedPtr<const FNVMeshSocketTable, ESPMode::ThreadSafe> FNVMeshSocketTablePtr;
+
+///
+/// Resolve the exported sockets of the meshes once, so the frames only need to read the bone transforms
+/// instead of searching all the socket names of every mesh component.
+/// NOTE: All the functions must be called on the game thread
+///
+class NVSCENECAPTURER_API FNVMeshSocketTableCache
+{
+public:
+    /// Get the table of the sockets to export from the mesh of the component
+    /// @param bExportAllSockets - If true, all the sockets (and bones) of the mesh are exported, otherwise only the ones in ExportSocketNames
+    /// @return nullptr if the component's mesh type isn't supported, its sockets must be looked up by name
+    static FNVMeshSocketTablePtr FindOrBuild(const UMeshComponent* MeshComp, bool bExportAllSockets, const TArray<FName>& ExportSocketNames);
+
+    /// Resolve the sockets to export of the component's mesh
+    static bool BuildSocketTable(const UMeshComponent* MeshComp, bool bExportAllSockets, const TArray<FName>& ExportSocketNames, FNVMeshSocketTable& OutSocketTable);
+
+    /// Append the world location of all the sockets of the table, using the current bone transforms of the component
+    static void GatherSocketWorldLocations(const UMeshComponent* MeshComp, const FNVMeshSocketTable& SocketTable, TArray<FVector>& OutWorldLocations);
+
+    /// Signature of the sockets of the component's mesh, changed when sockets or bones are added or removed
+    static uint32 CalculateSourceSignature(const UMeshComponent* MeshComp);
+
+    /// Forget all the socket tables
+    static void Reset();
+
+protected:
+    /// The tables are keyed by the mesh asset and the socket name filter
+    typedef TPair<FObjectKey, uint32> FSocketTableKey;
+    static TMap<FSocketTableKey, FNVMeshSocketTablePtr> SocketTables;
+};
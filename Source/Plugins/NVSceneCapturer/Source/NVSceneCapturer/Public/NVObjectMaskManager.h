@@ -12,6 +12,7 @@
 #include "UnrealEdGlobals.h"
 #include "Editor/UnrealEdEngine.h"
 #endif // WITH_EDITOR
+#include "NVInstanceClassRemap.h"
 #include "NVObjectMaskManager.generated.h"
 
 /// This enum describe how to get the mask name out of an actor
@@ -145,10 +146,28 @@ public:
     uint32 GetMaskId(const FString& MaskName) const;
     uint32 GetMaskId(const AActor* CheckActor) const;
 
+    /// Mask id of an instance of one of the actor's instanced static mesh components
+    /// NOTE: The instances only have their own mask when the mask name is the actor instance name, otherwise they use the actor's one
+    uint32 GetMaskId(const AActor* CheckActor, const class UInstancedStaticMeshComponent* InstancedMeshComp, int32 InstanceIndex) const;
+
+    /// Build the lookup table between the mask ids of the scanned actors and their class ids in another mask manager
+    void BuildInstanceClassLUT(const UNVObjectMaskMananger_Stencil* ClassMaskManager, int32 Version, FNVInstanceClassLUT& OutInstanceClassLUT) const;
+
+    /// Collect the mask ids of the exported instances of the scanned actors' instanced static meshes
+    void GetMeshInstanceMaskIds(TSet<uint32>& OutMaskIds) const;
+
+protected:
+    /// Write the mask color of all the exported instances of the actor's instanced static mesh components
+    void ApplyVertexColorMaskToMeshInstances(AActor* CheckActor) const;
+
 protected: // Transient
     UPROPERTY(Transient)
     TMap<FString, uint32> MaskNameIdMap;
 
+    /// The step between 2 consecutive mask ids
+    UPROPERTY(Transient)
+    uint32 MaskIdStep;
+
     static const uint32 MaxVertexColorID;
 };
 
@@ -161,9 +180,27 @@ public:
 	FNVObjectSegmentation_Instance();
 
 	uint32 GetInstanceId(const AActor* CheckActor) const;
+	uint32 GetInstanceId(const AActor* CheckActor, const class UInstancedStaticMeshComponent* InstancedMeshComp, int32 InstanceIndex) const;
 	void Init(UObject* OwnerObject);
 	void ScanActors(UWorld* World);
 
+	/// Build a new lookup table between the instance ids and the class ids of the scanned actors
+	/// NOTE: Must be called after both segmentations scanned the actors
+	void UpdateInstanceClassLUT(const struct FNVObjectSegmentation_Class& ClassSegmentation);
+
+	/// The lookup table of the current scene, the frames keep a reference to the one they're captured with
+	TSharedPtr<const FNVInstanceClassLUT, ESPMode::ThreadSafe> GetInstanceClassLUT() const
+	{
+		return InstanceClassLUT;
+	}
+
+	/// The instance ids of the exported mesh instances of the current scene
+	/// NOTE: Their instance mask color is only rendered by the materials which read it from the per-instance custom data
+	TSharedPtr<const TSet<uint32>, ESPMode::ThreadSafe> GetMeshInstanceIds() const
+	{
+		return MeshInstanceIds;
+	}
+
 protected:
 // Editor properties
 
@@ -174,6 +211,11 @@ protected:
 
 	UPROPERTY(Transient)
 	UNVObjectMaskMananger_VertexColor* VertexColorMaskManager;
+
+	TSharedPtr<const FNVInstanceClassLUT, ESPMode::ThreadSafe> InstanceClassLUT;
+	int32 InstanceClassLUTVersion;
+
+	TSharedPtr<const TSet<uint32>, ESPMode::ThreadSafe> MeshInstanceIds;
 };
 
 /// This enum describe how to get the class type out of an actor to use for segmentation
@@ -208,6 +250,11 @@ public:
 	void Init(UObject* OwnerObject);
 	void ScanActors(UWorld* World);
 
+	const UNVObjectMaskMananger_Stencil* GetMaskManager() const
+	{
+		return StencilMaskManager;
+	}
+
 protected:
 // Editor properties
 	/// How to get the class type out of actors in the scene to use for segmentation
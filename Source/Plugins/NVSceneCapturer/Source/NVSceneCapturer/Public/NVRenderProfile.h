@@ -0,0 +1,58 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneCaptureComponent.h"
+#include "NVRenderProfile.generated.h"
+
+/// The rendering features a feature extractor need, everything else is turned off in its scene capture components
+UENUM(BlueprintType)
+enum class ENVRenderProfilePreset : uint8
+{
+    /// Keep the scene capture component's full pipeline: lighting, shadows, post-process, translucency ...
+    FullLighting UMETA(DisplayName = "Full lighting"),
+    /// Only render the opaque geometry, unlit. The post-process materials still run (e.g: depth and stencil mask)
+    GeometryOnly UMETA(DisplayName = "Geometry only"),
+    /// Render the opaque geometry with its vertex colors, unlit and without any post-process
+    UnlitVertexColor UMETA(DisplayName = "Unlit vertex color"),
+
+    NVRenderProfilePreset_MAX UMETA(Hidden)
+};
+
+/// The show flags a feature extractor's scene capture components render with
+USTRUCT(BlueprintType)
+struct NVSCENECAPTURER_API FNVRenderProfile
+{
+    GENERATED_BODY()
+
+public:
+    FNVRenderProfile();
+    FNVRenderProfile(ENVRenderProfilePreset InPreset);
+
+    /// The preset the show flags start from
+    UPROPERTY(EditAnywhere, Category = "RenderProfile")
+    ENVRenderProfilePreset Preset;
+
+    /// Show flags applied on top of the preset's ones
+    UPROPERTY(EditAnywhere, Category = "RenderProfile")
+    TArray<FEngineShowFlagsSetting> AdditionalShowFlagSettings;
+
+public:
+    /// The show flags a preset turn on or off, the other show flags keep their game defaults
+    static void GetPresetShowFlagSettings(ENVRenderProfilePreset CheckPreset, TArray<FEngineShowFlagsSetting>& OutShowFlagSettings);
+
+    /// The preset's show flags followed by the additional ones
+    void BuildShowFlagSettings(TArray<FEngineShowFlagsSetting>& OutShowFlagSettings) const;
+
+    /// Apply the profile's show flags to a set of show flags
+    void ApplyToShowFlags(FEngineShowFlags& ShowFlags) const;
+
+    /// Merge the profile's show flags with a scene capture component's override show flags then apply them to it
+    /// NOTE: The override show flags win when they set the same show flag as the profile
+    void ApplyToSceneCapture(USceneCaptureComponent* SceneCaptureComponent, const TArray<FEngineShowFlagsSetting>& OverrideShowFlagSettings) const;
+};
@@ -0,0 +1,121 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "NVSceneCapturerUtils.h"
+#include "NVMeshGeometry.h"
+#include "NVAnnotationSchema.h"
+
+class FPositionVertexBuffer;
+
+/// The view data shared by all the actors of a frame, so the annotation can be computed without touching the viewpoint
+struct NVSCENECAPTURER_API FNVAnnotationViewContext
+{
+    FMatrix ViewProjectionMatrix = FMatrix::Identity;
+    FMatrix WorldToCameraMatrixUE = FMatrix::Identity;
+    FMatrix WorldToCameraMatrixCV = FMatrix::Identity;
+    FVector ViewLocation = FVector::ZeroVector;
+
+    /// Scale from the normalized image coordinate to the exported one: the image size in pixel or (1, 1)
+    FVector2D ImageScale = FVector2D(1.f, 1.f);
+
+    FFloatInterval DistanceScaleRange = FFloatInterval(100.f, 1000.f);
+    bool bUseInstanceMaskBoundingBox = false;
+
+    /// Projects a world-space position to image-space coordinates
+    FVector ProjectWorldPositionToImagePosition(const FVector &WorldPosition) const;
+
+    /// Converts a clip-space position (already transformed by ViewProjectionMatrix) to image-space coordinates
+    FVector ProjectClipPositionToImagePosition(const FVector4 &ClipPosition) const;
+
+    /// Projects a batch of world-space positions to image-space coordinates
+    void ProjectWorldPositionsToImagePositions(TArrayView<const FVector> WorldPositions, TArray<FVector> &OutImagePositions) const;
+};
+
+/// The vertexes of a mesh component used to calculate the 2D bounding box of its actor
+/// NOTE: The views point into the mesh assets (body setups, render data) which aren't modified while the annotation is gathered
+struct NVSCENECAPTURER_API FNVMeshBoundVertexSource
+{
+    FTransform MeshTransform;
+
+    /// The asset the vertexes belong to (static mesh), only used to keep it loaded
+    const UObject *GeometryOwner = nullptr;
+
+    TArray<TArrayView<const FVector>> ConvexVertexes;
+    const FPositionVertexBuffer *PositionVertexBuffer = nullptr;
+
+    /// The body shapes of a skeletal mesh's physics asset, in their bones' space
+    FNVSkeletalBodyHullsPtr BodyHulls;
+    /// The world transform of the bone of each body, captured with the frame
+    TArray<FTransform> BodyTransforms;
+    /// If true, only the corners of the bodies' bounds are projected instead of all their vertexes
+    bool bUseBodyBoundsCorners = false;
+};
+
+/// Everything read from the UObjects on the game thread to annotate an actor
+struct NVSCENECAPTURER_API FNVActorAnnotationInput
+{
+    FString Name;
+    FString Class;
+    uint32 InstanceId = 0;
+    FTransform ActorToWorld;
+
+    /// If true, the object is an instance of an instanced static mesh, its bounding box is never filled in from the instance mask
+    bool bIsMeshInstance = false;
+    FNVCuboidData Cuboid;
+
+    /// How many cuboid vertexes are hidden from the viewpoint
+    /// NOTE: The line traces query the physics scene so they're done on the game thread too
+    int32 OccludedVertexCount = 0;
+
+    TArray<FNVMeshBoundVertexSource> MeshVertexSources;
+    TArray<FString> SocketNames;
+    TArray<FVector> SocketWorldLocations;
+    TSharedPtr<FJsonObject> CustomData;
+};
+
+///
+/// Snapshot of the scene data an annotation feature extractor need, taken on the game thread when the frame is captured.
+/// The annotation is computed and serialized from it later on a worker thread, while the scene already moved on to the next frames.
+/// NOTE: The snapshot keep the mesh assets its vertex sources point into from being garbage collected,
+/// it must be created and released on the game thread.
+///
+struct NVSCENECAPTURER_API FNVSceneAnnotationSnapshot : public FGCObject
+{
+public:
+    FNVSceneAnnotationSnapshot(int32 InFrameIndex);
+
+    /// Index of the frame the snapshot is taken for
+    const int32 FrameIndex;
+
+    FCapturedViewpointData CameraData;
+    FNVAnnotationViewContext ViewContext;
+
+    /// The fields of the objects to compute and export
+    FNVAnnotationFieldSet AnnotationFields;
+
+    /// The exported actors, in the order they're iterated in the world
+    TArray<FNVActorAnnotationInput> Actors;
+
+    /// Region of the image the pixels data are cropped to, empty if the whole image is captured
+    FIntRect CaptureRegion;
+    FIntPoint FullImageSize;
+
+    /// Keep the assets referenced by the actors' vertex sources alive
+    void AddGeometryReferences();
+
+    // FGCObject interface
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+    virtual FString GetReferencerName() const override;
+
+protected:
+    TArray<TObjectPtr<UObject>> ReferencedAssets;
+};
+
+typedef TSharedRef<FNVSceneAnnotationSnapshot, ESPMode::ThreadSafe> FNVSceneAnnotationSnapshotRef;
@@ -0,0 +1,107 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHI.h"
+#include "NVSceneCapturerUtils.h"
+#include "NVTextureReader.h"
+
+/// Helper functions to place the tiles of an atlas and to cut them back out of its pixels
+struct NVSCENECAPTURER_API FNVAtlasLayout
+{
+    /// Place the tiles in rows from left to right, start a new row when the next tile doesn't fit in the maximum width
+    /// @param TileSizes         The 2d size (in pixels) of each tile
+    /// @param MaxAtlasWidth     The maximum width (in pixels) of the atlas, <= 0 mean no limit
+    /// @param OutTileRects      The region of each tile in the atlas, in the same order as TileSizes
+    /// @return The 2d size of the atlas needed to hold all the tiles
+    static FIntPoint LayoutTiles(const TArray<FIntPoint>& TileSizes, int32 MaxAtlasWidth, TArray<FIntRect>& OutTileRects);
+
+    /// Byte offset of the first pixel of a tile in the atlas pixels buffer
+    /// @param AtlasRowPitch     Number of pixels in each row of the atlas pixels buffer, can be larger than the width of the atlas
+    static int64 GetTileByteOffset(const FIntRect& TileRect, int32 AtlasRowPitch, int32 PixelByteSize);
+
+    /// Cut the pixels data of a tile out of the pixels buffer of the atlas
+    /// NOTE: The rows of the tile are copied straight out of the mapped atlas buffer, it's the only copy the pixels data go through
+    /// @param AtlasPixels       The pixels buffer of the atlas
+    /// @param AtlasBufferSize   The 2d size of the atlas pixels buffer: the row pitch (in pixels) and the number of rows
+    static bool SliceTile(const uint8* AtlasPixels, const FIntPoint& AtlasBufferSize, EPixelFormat PixelFormat,
+                          const FIntRect& TileRect, FNVTexturePixelData& OutTilePixelsData);
+};
+
+///
+/// Shared readback atlas: pack the render targets of several scene capture components into one atlas texture so they're read back together.
+/// Each component render its own view as usual, its render target is then copied into its tile of the atlas on the GPU.
+/// When all the tiles expected in the frame are copied, the atlas is read back once and sliced into the pixels data of each tile.
+/// NOTE: Only the readback is shared, the views are not rendered into the atlas in one pass so the rendering cost is the same as without it
+/// NOTE: All the tiles must have the same pixel format
+/// NOTE: The public functions must be called on the game thread
+///
+class NVSCENECAPTURER_API FNVSceneCaptureAtlas : public TSharedFromThis<FNVSceneCaptureAtlas, ESPMode::ThreadSafe>
+{
+public:
+    FNVSceneCaptureAtlas();
+
+    /// Add a tile to the atlas, must be called before the layout is finalized
+    /// @return The index of the new tile
+    int32 AddTile(const FIntPoint& TileSize);
+
+    /// Place all the tiles in the atlas
+    /// @param MaxAtlasWidth     The maximum width (in pixels) of the atlas, <= 0 mean no limit
+    void FinalizeLayout(int32 MaxAtlasWidth);
+
+    int32 GetTileCount() const
+    {
+        return TileRects.Num();
+    }
+
+    const FIntPoint& GetAtlasSize() const
+    {
+        return AtlasSize;
+    }
+
+    /// Number of times the atlas was read back
+    int32 GetReadbackCount() const
+    {
+        return ReadbackCount;
+    }
+
+    /// Let the atlas know a tile is going to be captured this frame, the atlas wait for it before it's read back
+    void ExpectTile(int32 TileIndex);
+
+    /// Copy the captured texture of a tile into the atlas, read back the atlas if it's the last tile it wait for
+    /// @param SourceTexture         The texture the tile's view is rendered to
+    /// @param ReadbackPixelFormat   The pixel format of the read back pixels
+    /// @param Callback              Function to call with the pixels data of the tile after the atlas is read back
+    void SubmitTile(int32 TileIndex, const FTextureRHIRef& SourceTexture, EPixelFormat ReadbackPixelFormat,
+                    FNVTextureReader::OnFinishedReadingPixelsDataCallback Callback);
+
+protected:
+    /// Read back the atlas and dispatch the pixels data of the tiles copied into it
+    void ReadbackAtlas(EPixelFormat ReadbackPixelFormat);
+
+protected:
+    TArray<FIntPoint> TileSizes;
+    TArray<FIntRect> TileRects;
+    FIntPoint AtlasSize;
+
+    // NOTE: Only accessed on the game thread
+    TArray<bool> ExpectedTiles;
+    int32 PendingTileCount;
+    int32 ReadbackCount;
+
+    /// The tile waiting for the atlas to be read back
+    struct FTileReadback
+    {
+        int32 TileIndex;
+        FNVTextureReader::OnFinishedReadingPixelsDataCallback Callback;
+    };
+
+    // NOTE: Only accessed on the rendering thread
+    FTextureRHIRef AtlasTexture;
+    TArray<FTileReadback> CopiedTiles;
+};
@@ -9,6 +9,8 @@
 #include "Components/SceneCaptureComponent2D.h"
 #include "NVSceneCapturerUtils.h"
 #include "NVTextureReader.h"
+#include "NVSceneCaptureAtlas.h"
+#include "NVTiledCapture.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "NVSceneCaptureComponent2D.generated.h"
 
@@ -29,6 +31,11 @@ class NVSCENECAPTURER_API UNVSceneCaptureComponent2D : public USceneCaptureCompo
     /// FNVTexturePixelData - The struct contain the captured scene's pixels data
     typedef TFunction<void(const FNVTexturePixelData&)> OnFinishedCaptureScenePixelsDataCallback;
 
+    /// Callback function get called after a tile of the scene is captured and its pixels data is read back
+    /// FNVTexturePixelData - The struct contain the captured tile's pixels data
+    /// FNVCaptureTile - The tile which is captured
+    typedef TFunction<void(const FNVTexturePixelData&, const FNVCaptureTile&)> OnFinishedCaptureSceneTileCallback;
+
 
 public:
     UNVSceneCaptureComponent2D(const FObjectInitializer& ObjectInitializer);
@@ -57,6 +64,22 @@ public:
     /// This function is combination of CaptureSceneToTexture and ReadPixelsDataFromTexture
     void CaptureSceneToPixelsData(UNVSceneCaptureComponent2D::OnFinishedCaptureScenePixelsDataCallback Callback);
 
+    /// Capture the tiles of the scene one after another to the render target texture, each tile is read back before the next one is rendered
+    /// NOTE: The tiles are rendered right away instead of later in the rendering phase since they share the same render target
+    /// @return Number of tiles which are captured, the callback only get called for them
+    int32 CaptureSceneTilesToPixelsData(const TArray<FNVCaptureTile>& Tiles, UNVSceneCaptureComponent2D::OnFinishedCaptureSceneTileCallback Callback);
+
+    /// Read back the captured texture as a tile of an atlas instead of reading it back alone
+    /// @param NewCaptureAtlas   The atlas to copy the captured texture into, nullptr to read back the captured texture alone
+    void SetCaptureAtlas(TSharedPtr<FNVSceneCaptureAtlas, ESPMode::ThreadSafe> NewCaptureAtlas, int32 NewAtlasTileIndex);
+
+    /// The 2d size (in pixels) of the captured texture
+    FIntPoint GetCapturedTextureSize() const;
+
+    /// Only read back a region of the captured texture
+    /// @param NewReadbackRegion     The region (in pixels) to read back, empty to read back the whole texture
+    void SetReadbackRegion(const FIntRect& NewReadbackRegion);
+
     UFUNCTION(BlueprintCallable, Category = "Exporter")
     void StartCapturing();
     UFUNCTION(BlueprintCallable, Category = "Exporter")
@@ -109,4 +132,8 @@ public: // Editor properties
 protected: // Transient properties
     FNVTextureRenderTargetReader RenderTargetReader;
     TArray<UNVSceneCaptureComponent2D::OnFinishedCaptureScenePixelsDataCallback> ReadbackCallbackList;
+
+    /// The atlas the captured texture is read back with, if any
+    TSharedPtr<FNVSceneCaptureAtlas, ESPMode::ThreadSafe> CaptureAtlas;
+    int32 AtlasTileIndex;
 };
@@ -12,6 +12,10 @@
 #include "NVSceneCapturerViewpointComponent.h"
 #include "NVImageExporter.h"
 #include "NVSceneDataHandler.h"
+#include "NVCaptureReadiness.h"
+#include "NVCapturePipeline.h"
+#include "NVSceneCaptureAtlas.h"
+#include "NVCaptureFarmMode.h"
 #if WITH_EDITOR
 #include "Editor.h"
 #include "UnrealEdGlobals.h"
@@ -116,6 +120,9 @@ class ANVSceneCapturerActor;
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FNVSceneCapturer_Started, ANVSceneCapturerActor*, SceneCapturer);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FNVSceneCapturer_Stopped, ANVSceneCapturerActor*, SceneCapturer);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FNVSceneCapturer_Completed, ANVSceneCapturerActor*, SceneCapturer, bool, bIsSucceeded);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FNVSceneCapturer_FrameRejected, ANVSceneCapturerActor*, SceneCapturer, int32, RejectedFrameCount);
+/// Native version of the frame rejected event, broadcasted for all the capturers so the other modules don't need to find them
+DECLARE_MULTICAST_DELEGATE_OneParam(FNVOnSceneCapturerFrameRejected, ANVSceneCapturerActor* /*SceneCapturer*/);
 
 ///
 /// The scene exporter actor.
@@ -188,6 +195,27 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Capturer")
     int32 GetExportedFrameCount() const;
 
+    /// Time (in seconds) the capturer waited for the scene to be ready before it started capturing the last time
+    UFUNCTION(BlueprintCallable, Category = "Capturer")
+    float GetLastReadinessWaitDuration() const;
+
+    /// Number of captured frames whose pixels data are not all read back yet
+    UFUNCTION(BlueprintCallable, Category = "Capturer")
+    int32 GetInFlightFrameCount() const;
+
+    /// Number of frames which are not captured since their viewpoints didn't see enough training objects
+    UFUNCTION(BlueprintCallable, Category = "Capturer")
+    int32 GetRejectedFrameCount() const;
+
+    /// Broadcasted when any capturer reject a frame, the scene should be randomized again
+    static FNVOnSceneCapturerFrameRejected& OnFrameRejected();
+
+    /// The capture farm mode's state and the frame times it sampled
+    const FNVCaptureFarmMode& GetCaptureFarmMode() const
+    {
+        return CaptureFarmMode;
+    }
+
     UFUNCTION(BlueprintCallable, Category = "Capturer")
     TArray<UNVSceneCapturerViewpointComponent*> GetViewpointList();
 
@@ -200,6 +228,9 @@ public:
 
     static TArray<FNVNamedImageSizePreset> const& GetImageSizePresets();
 
+    /// Find the last checkpoint recorded by the previous capturing session in the output directory
+    bool LoadResumeCheckpoint(FNVCaptureCheckpoint& OutCheckpoint);
+
     /// Event properties
 	UPROPERTY(BlueprintAssignable, Category = "Events")
 	FNVSceneCapturer_Started OnStartedEvent;
@@ -207,6 +238,8 @@ public:
 	FNVSceneCapturer_Stopped OnStoppedEvent;
 	UPROPERTY(BlueprintAssignable, Category = "Events")
 	FNVSceneCapturer_Completed OnCompletedEvent;
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FNVSceneCapturer_FrameRejected OnFrameRejectedEvent;
 
 protected:
     virtual void PostLoad() final;
@@ -223,12 +256,48 @@ protected:
     void UpdateSettingsFromCommandLine();
     void UpdateViewpointList();
     void StartCapturing_Internal();
+    /// Wait for the scene to be ready then start capturing
+    void UpdateStartCapturing();
     void CaptureSceneToPixelsData();
     void CheckCaptureScene();
+    /// Check whether any enabled viewpoint doesn't see enough training objects to capture the current frame
+    bool ShouldRejectFrame() const;
+    /// Skip the current frame without rendering it and randomize the scene again
+    void RejectFrame();
+    /// Check whether the frame must be captured even if it should be rejected, because too many frames were rejected in a row
+    bool ShouldCaptureRejectedFrame() const;
     void UpdateCapturerSettings();
     void OnCompleted();
     bool CanHandleMoreSceneData() const;
 
+    /// Record all the frames captured so far in the capture journal, re-seed the random stream for the next frames
+    /// NOTE: All the captured data must already be exported
+    void WriteCheckpoint();
+
+    /// Record the frames up to CheckpointFrameIndex in the capture journal
+    /// @param bWaitForPendingWrites - If false, the files still being written are left out of the checkpoint instead of waited for
+    void WriteCheckpoint(int32 CheckpointFrameIndex, bool bWaitForPendingWrites);
+
+    /// Wait (up to ShutdownDrainTimeout) for all the captured data to be exported then write the last checkpoint
+    /// NOTE: Called when the game is shutting down (e.g: SIGTERM) so the capturing can be resumed later
+    void DrainAndCheckpoint();
+
+    /// Remember the last captured frame if all the captured data are exported
+    void UpdateLastExportedFrame();
+
+    int32 GetCurrentMarkerIndex() const;
+
+    /// Export the annotation data of the frames whose pixels data are all read back, in the order they're captured
+    /// @param bRetireAll - If true, export all the frames in flight even if they're not completed
+    void RetireCapturedFrames(bool bRetireAll);
+
+    /// Wait for the pixels data of all the frames in flight to be read back then retire them
+    void FlushInFlightFrames();
+
+    /// Group the scene capture components of the same feature extractor in all the viewpoints into shared readback atlases
+    void SetupCaptureAtlases();
+    void ReleaseCaptureAtlases();
+
 public: // Editor properties
 	/// Whether this capturer actor is active and can start capturing or not
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Capture")
@@ -250,6 +319,15 @@ protected: // Editor properties
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Capture")
     bool bAutoStartCapturing;
 
+    /// Seed of the random frames capture cadences, the frames they capture only depend on this seed and the frame index
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    int32 CaptureCadenceSeed;
+
+    /// Maximum time (in seconds) to wait for the scene to be ready (assets loaded, textures streamed in ...) before starting capturing
+    /// NOTE: <= 0 mean wait until the scene is ready
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    float ReadinessTimeout;
+
     /// NOTE: TimeBetweenSceneExport <= 0 mean export every frame
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Capture")
     float TimeBetweenSceneCapture;
@@ -259,6 +337,56 @@ protected: // Editor properties
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Capture", meta=(UIMin=0))
     int32 MaxNumberOfFramesToCapture;
 
+    /// Maximum number of frames in flight: the scene of the next frame is set up while the previous frames are still rendered and read back
+    /// NOTE: 1 mean each frame is read back before the next one is captured, 2 or 3 usually give the best throughput
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture", meta = (ClampMin = 1, ClampMax = 4))
+    int32 PipelineDepth;
+
+    /// If true, the engine's global random stream (FMath::Rand, FMath::FRand ...) the randomization components use is re-seeded
+    /// at each checkpoint of the capture journal, a session resumed from a checkpoint then randomize its scenes the same way
+    /// as if the capturing never stopped
+    /// NOTE: The seeds come from the capturer's own random stream, the global stream is only touched when this is enabled.
+    /// When it's disabled the resumed session start from the same frame but its scenes are randomized differently.
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Checkpoint")
+    bool bReseedRandomAtCheckpoints;
+
+    /// Maximum time (in seconds) the game thread wait for the captured data to be exported when the game is shutting down.
+    /// If the data are still not all exported after that, the checkpoint of the last frame whose data were all exported is written instead.
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Checkpoint", meta = (ClampMin = 0))
+    float ShutdownDrainTimeout;
+
+    /// If true, the annotation data are built and serialized on worker threads from a snapshot of the scene taken when the frame is captured
+    /// NOTE: Only used when PipelineDepth > 1, the frames wait for their annotation data like they wait for their pixels data
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    bool bBuildAnnotationInBackground;
+
+    /// If true, the viewpoints' captured images of the same feature extractor share one readback per frame: they're copied into an atlas texture
+    /// which is read back once then sliced back into the image of each viewpoint
+    /// NOTE: Reduce the number of readbacks per frame when there are many viewpoints (e.g: stereo or surround rigs),
+    /// each viewpoint still render its own view so the rendering cost doesn't change
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    bool bUseCaptureAtlas;
+
+    /// Only read back and export the region of the images around the training objects
+    /// NOTE: The crop of each image is written in the "image_crop" field of its annotation data
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    FNVRegionOfInterestSettings RegionOfInterestSettings;
+
+    /// Render the images which are bigger than the render target limits tile by tile, with a small render target reused by all the tiles
+    /// NOTE: The annotation data still use the coordinates of the full images
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    FNVTiledCaptureSettings TiledCaptureSettings;
+
+    /// Stop rendering the game viewport, the HUD and the visualizers while capturing, only the scene capture components render
+    /// NOTE: Meant for the capture farms where nobody watch the game window
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    FNVCaptureFarmModeSettings CaptureFarmModeSettings;
+
+    /// Don't render the frames where a viewpoint doesn't see enough training objects, randomize the scene again instead
+    /// NOTE: The check use the bounds of the objects so the occlusion isn't taken into account
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    FNVFrameVisibilitySettings FrameVisibilitySettings;
+
     /// If true, the player's camera will be tied to this exporter's location and rotation
     UPROPERTY(EditAnywhere, Category = "Capture")
     bool bTakeOverGameViewport;
@@ -295,6 +423,14 @@ protected: // Transient properties
     UPROPERTY(Transient)
     FNVFrameCounter CapturedFrameCounter;
 
+    /// Number of frames rejected by the frame visibility filter since the capturer started capturing
+    UPROPERTY(Transient)
+    int32 RejectedFrameCount;
+
+    /// Number of frames rejected since the last captured frame
+    UPROPERTY(Transient)
+    int32 ConsecutiveRejectedFrameCount;
+
     UPROPERTY(Transient)
     AActor* CachedPlayerControllerViewTarget;
 
@@ -310,15 +446,55 @@ protected: // Transient properties
     UPROPERTY(Transient)
     bool bTakingOverViewport;
 
+    /// If true, the capturer is waiting for the scene to be ready to start capturing
     UPROPERTY(Transient)
-    bool bSkipFirstFrame;
+    bool bWaitingToStartCapturing;
 
     UPROPERTY(Transient)
-    FTimerHandle TimeHandle_StartCapturingDelay;
+    float RequestStartCapturingTimestamp;
+
+    UPROPERTY(Transient)
+    float LastReadinessWaitDuration;
+
+    /// Check whether the scene is ready to be captured
+    FNVCaptureReadinessGate ReadinessGate;
 
 	UPROPERTY(Transient)
 	TArray<UNVSceneCapturerViewpointComponent*> ViewpointList;
 
     UPROPERTY(Transient)
     int32 ImageToCapturePerFrame;
+
+    /// If true, the next capturing session continue from the last checkpoint of the capture journal (-Resume)
+    UPROPERTY(Transient)
+    bool bResumeFromCheckpoint;
+
+    /// If true, the capturer wait for all the captured data to be exported then write a checkpoint before capturing the next frame
+    UPROPERTY(Transient)
+    bool bCheckpointPending;
+
+    UPROPERTY(Transient)
+    int32 LastCheckpointFrameIndex;
+
+    /// Index of the last frame whose data were all exported, the checkpoint written when the shutdown drain time out
+    UPROPERTY(Transient)
+    int32 LastExportedFrameIndex;
+
+    /// Generate the seeds of the global random stream at the checkpoints, it's re-seeded with them too
+    /// so a resumed session generate the same seeds after its checkpoint
+    FRandomStream CheckpointRandomStream;
+
+    /// The random values the capture cadences of the current frame are decided with
+    FNVCaptureCadenceDraws CaptureCadenceDraws;
+
+    FDelegateHandle ApplicationWillTerminateHandle;
+
+    /// Keep track of the frames in flight
+    FNVCapturePipeline CapturePipeline;
+
+    /// The shared readback atlases the viewpoints' captured images are read back with
+    TArray<TSharedPtr<FNVSceneCaptureAtlas, ESPMode::ThreadSafe>> CaptureAtlases;
+
+    /// Turn off the game viewport's rendering while capturing
+    FNVCaptureFarmMode CaptureFarmMode;
 };
\ No newline at end of file
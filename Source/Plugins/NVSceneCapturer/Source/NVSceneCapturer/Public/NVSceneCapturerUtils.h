@@ -181,11 +181,13 @@ public:
     UPROPERTY(Transient)
     uint32 occluded;
 
+    /// NOTE: Not computed, it's 0 so the exported value doesn't change between the frames
     UPROPERTY(Transient)
-    float occlusion;
+    float occlusion = 0.f;
 
+    /// NOTE: Not computed, it's 0 so the exported value doesn't change between the frames
     UPROPERTY()
-    float visibility;
+    float visibility = 0.f;
 
     UPROPERTY(Transient)
     FVector dimensions_worldspace;
@@ -315,10 +317,17 @@ class NVSCENECAPTURER_API UNVCapturableActorTag : public UActorComponent
 {
     GENERATED_BODY()
 public:
-    UNVCapturableActorTag() : bIncludeMe(true) {}
+    UNVCapturableActorTag() : bIncludeMe(true), bExportMeshInstances(true), InstanceMaskCustomDataIndex(0), AnnotationVersion(0) {}
 
     bool IsValid() const { return bIncludeMe && !Tag.IsEmpty(); }
 
+    /// Let the capturers know the annotation data of the owner actor must be recomputed, even if it didn't move
+    /// NOTE: Call it when the owner actor changed in a way which doesn't show in its transform, bounds or meshes
+    UFUNCTION(BlueprintCallable, Category = "Capturer")
+    void MarkAnnotationDirty() { AnnotationVersion++; }
+
+    uint32 GetAnnotationVersion() const { return AnnotationVersion; }
+
 public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Config")
     FString Tag;
@@ -331,6 +340,19 @@ public:
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Config", meta = (editcondition = "!bExportAllMeshSocketInfo"))
     TArray<FName> SocketNameToExportList;
+
+    /// If true, each instance of the actor's instanced static mesh components is exported as its own object instead of the actor
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Config")
+    bool bExportMeshInstances;
+
+    /// Index of the first of the 3 per-instance custom data floats the instance mask color (RGB in [0, 1]) is written to
+    /// NOTE: The instances' material must output those values as its color for the instance mask to tell the instances apart,
+    /// and the component's NumCustomDataFloats must be large enough to hold them, it's never resized
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Config", meta = (editcondition = "bExportMeshInstances", ClampMin = "0"))
+    int32 InstanceMaskCustomDataIndex;
+
+protected:
+    uint32 AnnotationVersion;
 };
 
 UENUM(BlueprintType)
@@ -353,6 +375,10 @@ enum class ENVBoundBox2dGenerationType : uint8
 {
     From3dBoundingBox,
     FromMeshBodyCollision,
+
+    /// Use the visible pixels of the object in the instance mask (VertexColorMask feature extractor) of the same viewpoint
+    /// NOTE: This skip the vertex projection, the box only cover the visible (non-occluded) part of the object
+    FromInstanceMask,
 };
 
 USTRUCT(BlueprintType)
@@ -480,6 +506,8 @@ protected:
     float FPSAccumulatedDuration;
 };
 
+class INVFileSink;
+
 namespace NVSceneCapturerUtils
 {
     extern const FMatrix UE4ToOpenCVMatrix;
@@ -508,7 +536,9 @@ namespace NVSceneCapturerUtils
         return FJsonObjectConverter::UStructToJsonObject(InStructData, CheckFlags, SkipFlags, &CustomPropertyToJsonValue);
     }
 
-    NVSCENECAPTURER_API bool SaveJsonObjectToFile(const TSharedPtr<FJsonObject> &JsonObjData, const FString &Filename);
+    /// Serialize the json object and write it to a file
+    /// @param FileSink - If valid, the file is queued to be written by this sink instead of being written right away
+    NVSCENECAPTURER_API bool SaveJsonObjectToFile(const TSharedPtr<FJsonObject> &JsonObjData, const FString &Filename, INVFileSink *FileSink = nullptr);
     NVSCENECAPTURER_API FString GetExportImageExtension(EImageFormat ImageFormat);
 
     NVSCENECAPTURER_API UMeshComponent *GetFirstValidMeshComponent(const AActor *CheckActor);
@@ -536,4 +566,18 @@ namespace NVSceneCapturerUtils
     NVSCENECAPTURER_API FNVCuboidData GetActorCuboid_AABB(const AActor *CheckActor);
     NVSCENECAPTURER_API FNVCuboidData GetActorCuboid_OOBB_Simple(const AActor *CheckActor, bool bCheckMeshCollision = true);
     NVSCENECAPTURER_API FNVCuboidData GetActorCuboid_OOBB_Complex(const AActor *CheckActor);
+
+    /// The instanced static mesh components of the actor whose instances are exported as separate objects
+    /// NOTE: Only the actors whose capturable tag enable bExportMeshInstances have some
+    NVSCENECAPTURER_API void GetExportedMeshInstanceComponents(const AActor *CheckActor, TArray<class UInstancedStaticMeshComponent *> &OutComponents);
+    /// Unique name of an instance of a mesh, used as its object name and its instance mask name
+    NVSCENECAPTURER_API FString GetMeshInstanceName(const AActor *OwnerActor, const class UInstancedStaticMeshComponent *InstancedMeshComp, int32 InstanceIndex);
+    /// The cuboid of an instance of a mesh in world space, built from the geometry shared by all the mesh's instances (see FNVMeshGeometryCache)
+    NVSCENECAPTURER_API FNVCuboidData GetMeshInstanceCuboid(const struct FNVMeshGeometryData &MeshGeometry, const FTransform &InstanceTransform, ENVBoundsGenerationType BoundsType);
+    /// Whether the component has the 3 per-instance custom data floats, starting at CustomDataIndex, to store the instance mask color in
+    NVSCENECAPTURER_API bool CanStoreMeshInstanceMaskColor(const class UInstancedStaticMeshComponent *InstancedMeshComp, int32 CustomDataIndex);
+    /// Write the instance mask color of an instance in its per-instance custom data: R, G and B in [0, 1] starting at CustomDataIndex
+    /// NOTE: The component's NumCustomDataFloats is never changed, nothing is written if it doesn't have enough floats
+    /// @return false if the color couldn't be written
+    NVSCENECAPTURER_API bool SetMeshInstanceMaskColor(class UInstancedStaticMeshComponent *InstancedMeshComp, int32 InstanceIndex, int32 CustomDataIndex, const FColor &MaskColor);
 }
@@ -12,6 +12,9 @@
 #include "NVSceneFeatureExtractor_DataExport.h"
 #include "NVSceneFeatureExtractor_ImageExport.h"
 #include "NVTextureReader.h"
+#include "NVCaptureRegion.h"
+#include "NVTiledCapture.h"
+#include "NVFrameVisibilityFilter.h"
 #include "NVSceneCapturerViewpointComponent.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogNVSceneCapturerViewpointComponent, Log, All)
@@ -76,6 +79,33 @@ public:
 
     bool CaptureSceneToPixelsData(UNVSceneCapturerViewpointComponent::OnFinishedCaptureScenePixelsDataCallback Callback);
 
+    /// Callback function get called after a tile of the scene is captured and its pixels data is read back
+    /// FNVTexturePixelData - The struct contain the captured tile's pixels data
+    /// FNVCaptureTile - The tile which is captured
+    /// UNVSceneFeatureExtractor_PixelData* - Reference to the feature extractor that captured the tile
+    /// UNVSceneCapturerViewpointComponent* - Reference to the viewpoint that captured the tile
+    typedef TFunction<void(const FNVTexturePixelData&, const FNVCaptureTile&, UNVSceneFeatureExtractor_PixelData*, UNVSceneCapturerViewpointComponent*)> OnFinishedCaptureSceneTileCallback;
+
+    /// Capture the scene tile by tile, used instead of CaptureSceneToPixelsData when the viewpoint use the tiled capture
+    /// @return Number of tiles which are captured, less than GetCapturedPixelsDataCount() if some tiles can't be captured
+    int32 CaptureSceneTilesToPixelsData(UNVSceneCapturerViewpointComponent::OnFinishedCaptureSceneTileCallback Callback);
+
+    /// Number of times the callback of CaptureSceneToPixelsData (or CaptureSceneTilesToPixelsData) get called for each capture
+    int32 GetCapturedPixelsDataCount() const;
+
+    /// Capture the images tile by tile if they're bigger than the tiles
+    /// NOTE: Must be called before the feature extractors are set up since it decide the size of their render targets
+    void SetTiledCaptureSettings(const FNVTiledCaptureSettings& NewTiledCaptureSettings);
+
+    /// Check whether the images are captured tile by tile
+    bool IsTiledCapture() const;
+
+    /// The 2d size (in pixels) of the render targets: the size of a tile when the images are captured tile by tile, otherwise the size of the images
+    FIntPoint GetCapturedTextureSize() const;
+
+    /// The projection matrix of the full captured image
+    FMatrix GetProjectionMatrix() const;
+
     /// Callback function get called after the scene capture component finished capturing scene's annotation data
     /// TSharedPtr<FJsonObject> - The JSON object contain the annotation data
     /// UNVSceneFeatureExtractor_AnnotationData* - Reference to the feature extractor that captured the scene annotation data
@@ -84,8 +114,43 @@ public:
 
     bool CaptureSceneAnnotationData(UNVSceneCapturerViewpointComponent::OnFinishedCaptureSceneAnnotationDataCallback Callback);
 
+    /// Callback function get called after the scene capture component took a snapshot of the scene for an annotation feature extractor
+    /// FNVSceneAnnotationSnapshotRef - The snapshot the annotation data can be built from on any thread
+    typedef TFunction<void(const FNVSceneAnnotationSnapshotRef&, UNVSceneFeatureExtractor_AnnotationData*, UNVSceneCapturerViewpointComponent*)> OnCapturedSceneAnnotationSnapshotCallback;
+
+    /// Take the snapshots of the scene the scheduled annotation feature extractors need, the annotation data are built later from them
+    bool CaptureSceneAnnotationSnapshots(int32 FrameIndex, UNVSceneCapturerViewpointComponent::OnCapturedSceneAnnotationSnapshotCallback Callback);
+
     void SetupFeatureExtractors();
     void UpdateCapturerSettings();
+
+    /// Decide which feature extractors capture the frame, using their capture cadence
+    /// NOTE: Must be called once per frame, before the frame is captured
+    /// @param CadenceDraws - The random values of the frame, already drawn for the feature extractor settings of this viewpoint
+    void UpdateCaptureSchedule(int32 FrameIndex, const FNVCaptureCadenceDraws& CadenceDraws);
+
+    /// Get the feature extractors which capture the current frame
+    void GetScheduledFeatureExtractors(TArray<UNVSceneFeatureExtractor*>& OutFeatureExtractors) const;
+
+    /// Compute the region of the image covering the training objects visible from this viewpoint
+    /// NOTE: The region is calculated from the projected bounds of the objects so it's conservative
+    /// @return The region (in pixels), the whole image if an object is partly behind the camera or nothing is visible
+    FIntRect CalculateRegionOfInterest(const FNVRegionOfInterestSettings& RegionOfInterestSettings) const;
+
+    /// Get the world bounds of the training objects (the actors with a capturable tag which include them) in the level
+    void GetTrainingObjectBounds(TArray<FBox>& OutObjectBounds) const;
+
+    /// Check whether this viewpoint see enough training objects for its frame to be captured
+    /// @param ObjectBounds  The world bounds of the training objects, see GetTrainingObjectBounds
+    bool HasEnoughVisibleTrainingObjects(const FNVFrameVisibilitySettings& FrameVisibilitySettings, const TArray<FBox>& ObjectBounds) const;
+
+    /// Only read back and export the region of the images for the next captures
+    /// @param NewCaptureRegion  The region (in pixels) to capture, empty to capture the whole images
+    void SetCaptureRegion(const FIntRect& NewCaptureRegion);
+    const FIntRect& GetCaptureRegion() const
+    {
+        return CaptureRegion;
+    }
     const FNVSceneCapturerViewpointSettings& GetSettings() const;
     const FNVSceneCapturerSettings& GetCapturerSettings() const;
     const TArray<FNVFeatureExtractorSettings>& GetFeatureExtractorSettings() const;
@@ -118,6 +183,11 @@ protected: // Transient properties
     UPROPERTY(Transient)
     class ANVSceneCapturerActor* OwnerSceneCapturer;
 
+    /// The region of the images the viewpoint read back, empty mean the whole images
+    FIntRect CaptureRegion;
+
+    FNVTiledCaptureSettings TiledCaptureSettings;
+
 #if WITH_EDITORONLY_DATA
 protected: // Proxy editor mesh
     /// The frustum component used to show visually where the camera field of view is
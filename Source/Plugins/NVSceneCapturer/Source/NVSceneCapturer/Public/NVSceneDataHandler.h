@@ -8,6 +8,14 @@
 
 #include "NVSceneCapturerUtils.h"
 #include "NVImageExporter.h"
+#include "NVInstanceMaskStats.h"
+#include "NVDuplicateFrameFilter.h"
+#include "NVCaptureJournal.h"
+#include "NVFrameManifest.h"
+#include "NVSequenceAnnotation.h"
+#include "NVAnnotationCompression.h"
+#include "NVTiledCapture.h"
+#include "Async/Future.h"
 #include "NVSceneDataHandler.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogNVSceneDataHandler, Log, All)
@@ -39,6 +47,18 @@ public:
         class UNVSceneCapturerViewpointComponent* CapturedViewpoint,
         int32 FrameIndex) PURE_VIRTUAL(UNVSceneDataHandler::HandleScenePixelsData, return false; );
 
+    /// Handle the pixels data of a tile captured from the scene, when the viewpoint capture its images tile by tile
+    /// @param TilePixelsData - The tile's pixels data
+    /// @param CapturedTile - The tile which is captured and its region in the full image
+    /// @param CapturedFeatureExtractor - The feature extractor which captured the data
+    /// @param CapturedViewpoint - The viewpoint which captured the data
+    /// @param FrameIndex - The frame when the data is captured
+    virtual bool HandleScenePixelsTile(const FNVTexturePixelData& TilePixelsData,
+        const FNVCaptureTile& CapturedTile,
+        class UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor,
+        class UNVSceneCapturerViewpointComponent* CapturedViewpoint,
+        int32 FrameIndex) { return false; }
+
     /// Handle the annotation data captured from the scene
     /// @param CapturedData  - The scene's annotated data
     /// @param CapturedFeatureExtractor - The feature extractor which captured the data
@@ -49,6 +69,14 @@ public:
         class UNVSceneCapturerViewpointComponent* CapturedViewpoint,
         int32 FrameIndex) PURE_VIRTUAL(UNVSceneDataHandler::HandleSceneAnnotationData, return false; );
 
+    /// Handle the list of the feature extractors which capture a frame, called before any data of the frame is handled
+    /// @param ScheduledFeatureExtractors - The feature extractors which capture the frame, the others skip it because of their capture cadence
+    /// @param CapturedViewpoint - The viewpoint which capture the frame
+    /// @param FrameIndex - The frame to be captured
+    virtual void HandleFrameSchedule(const TArray<class UNVSceneFeatureExtractor*>& ScheduledFeatureExtractors,
+        class UNVSceneCapturerViewpointComponent* CapturedViewpoint,
+        int32 FrameIndex) {}
+
     virtual void OnStartCapturingSceneData() PURE_VIRTUAL(UNVSceneDataHandler::OnStartCapturingSceneData, return; );
     virtual void OnStopCapturingSceneData() PURE_VIRTUAL(UNVSceneDataHandler::OnStopCapturingSceneData, return; );
     virtual void OnCapturingCompleted() PURE_VIRTUAL(UNVSceneDataHandler::OnCapturingCompleted, return; );
@@ -96,6 +124,18 @@ public:
                                        UNVSceneCapturerViewpointComponent* CapturedViewpoint,
                                        int32 FrameIndex) override;
 
+    /// Stream the tile into the tiled image file of the feature extractor, band by band
+    /// @param TilePixelsData - The tile's pixels data
+    /// @param CapturedTile - The tile which is captured and its region in the full image
+    /// @param CapturedFeatureExtractor - The feature extractor which captured the data
+    /// @param CapturedViewpoint - The viewpoint which captured the data
+    /// @param FrameIndex - The frame when the data is captured
+    virtual bool HandleScenePixelsTile(const FNVTexturePixelData& TilePixelsData,
+                                       const FNVCaptureTile& CapturedTile,
+                                       UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor,
+                                       UNVSceneCapturerViewpointComponent* CapturedViewpoint,
+                                       int32 FrameIndex) override;
+
     /// Handle the annotation data captured from the scene
     /// @param CapturedData  - The scene's annotated data
     /// @param CapturedFeatureExtractor - The feature extractor which captured the data
@@ -106,6 +146,14 @@ public:
                                            class UNVSceneCapturerViewpointComponent* CapturedViewpoint,
                                            int32 FrameIndex) override;
 
+    /// Record the files the frame is going to have in the frame manifest
+    /// @param ScheduledFeatureExtractors - The feature extractors which capture the frame, the others skip it because of their capture cadence
+    /// @param CapturedViewpoint - The viewpoint which capture the frame
+    /// @param FrameIndex - The frame to be captured
+    virtual void HandleFrameSchedule(const TArray<class UNVSceneFeatureExtractor*>& ScheduledFeatureExtractors,
+                                     UNVSceneCapturerViewpointComponent* CapturedViewpoint,
+                                     int32 FrameIndex) override;
+
     virtual void OnStartCapturingSceneData() override;
     virtual void OnStopCapturingSceneData() override;
     virtual void OnCapturingCompleted() override;
@@ -133,11 +181,109 @@ public:
                               int32 FrameIndex,
                               const FString& FileExtension) const;
 
+    /// Index of the sub-folder the files of a frame are exported in
+    /// @return INDEX_NONE if the frames are all exported in the output directory itself (FramesPerSubFolder <= 0)
+    static int32 GetFrameSubFolderIndex(int32 FrameIndex, int32 FramesPerSubFolder);
+
+    /// Append the path of an exported file of a frame, relative to the output directory: [<SubFolderIndex>/]<FrameIndex><Postfix><Extension>
+    static void AppendFrameFileRelativePath(FString& OutFilePath,
+                                            int32 FrameIndex,
+                                            int32 FramesPerSubFolder,
+                                            const FString& FileNamePostfix,
+                                            const FString& FileExtension);
+
+    /// Find the frame a relative file path built by AppendFrameFileRelativePath belong to
+    /// @return The frame index, INDEX_NONE if the path isn't the path of a frame file with this layout
+    static int32 ParseFrameFileRelativePath(const FString& RelativeFilePath,
+                                            int32 FramesPerSubFolder,
+                                            const FString& FileNamePostfix,
+                                            const FString& FileExtension);
+
+    /// Path of the sequence annotation file the annotation data of the feature extractor are written to when bExportSequenceAnnotation is true
+    FString GetSequenceAnnotationFilePath(class UNVSceneFeatureExtractor* CapturedFeatureExtractor,
+                                          UNVSceneCapturerViewpointComponent* CapturedViewpoint) const;
+
+    /// Path of the compressed stream file the annotation data of a frame are written to when AnnotationCompressionMode isn't None
+    FString GetCompressedAnnotationStreamFilePath(class UNVSceneFeatureExtractor* CapturedFeatureExtractor,
+                                                  UNVSceneCapturerViewpointComponent* CapturedViewpoint,
+                                                  int32 FrameIndex) const;
+
     uint32 GetPendingToExportImagesCount() const;
 
+    /// Statistics of the files written by this exporter in the current capturing session
+    FNVFileSinkStats GetFileSinkStats() const;
+
+    /// Number of frames dropped by the duplicate frame filter in the current capturing session
+    UFUNCTION(BlueprintCallable, Category = "Exporter")
+    int32 GetDroppedDuplicateFrameCount() const;
+
+    /// Number of frames between 2 checkpoints, <= 0 mean the capture journal is not written
+    int32 GetCheckpointFrameInterval() const;
+
+    /// If true, the next capturing session continue the session recorded in the capture journal of the output directory:
+    /// the existing files are kept and the new checkpoints are appended to the journal
+    void SetResumingCapture(bool bInResumingCapture);
+
+    /// Find the last checkpoint recorded in the capture journal of the configured output directory
+    bool LoadResumeCheckpoint(FNVCaptureCheckpoint& OutCheckpoint) const;
+
+    /// Record that all the data of the frames up to FrameIndex are written to disk
+    /// NOTE: The caller must make sure there's no data of these frames still being exported
+    /// @param bWaitForPendingWrites - If false, the files still being written (of the later frames) are left for the next checkpoint instead of waited for
+    bool WriteCheckpoint(int32 FrameIndex, int32 MarkerIndex, int32 RandomSeed, bool bWaitForPendingWrites = true);
+
 protected:
     void ExportCapturerSettings();
 
+    /// Export the pixels data right away, without going through the duplicate frame filter
+    bool ExportScenePixelsData(const FNVTexturePixelData& CapturedPixelData,
+                               UNVSceneFeatureExtractor_PixelData* CapturedFeatureExtractor,
+                               UNVSceneCapturerViewpointComponent* CapturedViewpoint,
+                               int32 FrameIndex);
+
+    /// Export the annotation data right away, without going through the duplicate frame filter
+    bool ExportSceneAnnotationData(const TSharedPtr<FJsonObject>& CapturedData,
+                                   UNVSceneFeatureExtractor_AnnotationData* CapturedFeatureExtractor,
+                                   UNVSceneCapturerViewpointComponent* CapturedViewpoint,
+                                   int32 FrameIndex);
+
+    /// Export the annotation data still waiting for their instance masks and wait for the queued files to be written
+    /// NOTE: Must be called before the writers (journal, manifest, sequence and compressed stream files) are closed
+    void FlushPendingExports();
+
+    /// Drop the tiled images which are still waiting for some of their tiles
+    void ReleaseTiledImageWriters();
+
+    /// Find the color image feature extractor of each viewpoint which is used to detect the duplicated frames
+    /// NOTE: The viewpoints without any color image feature extractor are not filtered
+    void BuildDuplicateFrameCheckExtractors();
+
+    /// Pre-compute the file name postfix of each viewpoint and feature extractor pair
+    void BuildExportFileNamePostfixes();
+
+    /// The postfix of the files exported by a viewpoint and feature extractor pair, e.g: ".Left.depth"
+    FString GetExportFileNamePostfix(const UNVSceneFeatureExtractor* CapturedFeatureExtractor, const UNVSceneCapturerViewpointComponent* CapturedViewpoint) const;
+
+    /// Path of the compressed stream files of a viewpoint and annotation feature extractor pair, without their file index and extension
+    FString GetCompressedAnnotationStreamFilePathPrefix(const UNVSceneFeatureExtractor* CapturedFeatureExtractor, const UNVSceneCapturerViewpointComponent* CapturedViewpoint) const;
+
+    /// Path of the file the annotation data of a frame end up in: its own json file, the sequence file or a compressed file
+    FString GetAnnotationExportFilePath(UNVSceneFeatureExtractor* CapturedFeatureExtractor, UNVSceneCapturerViewpointComponent* CapturedViewpoint, int32 FrameIndex) const;
+
+    /// Give the sequence annotation writer the static description of the exported object classes
+    void SetSequenceObjectClassSettings(const struct FNVSceneAnnotatedActorData& SceneAnnotatedActorData);
+
+    /// Make sure the sub-folder of the frame exist before its files are queued to be written
+    /// and create the next sub-folders ahead of the frames on a background thread
+    void PrepareFrameSubFolders(int32 FrameIndex);
+
+    /// Wait for the background creation of the sub-folders and forget the created ones
+    void ResetFrameSubFolders();
+
+    /// Check whether the viewpoint have both an annotation feature extractor which use the instance mask for its 2d bounding boxes
+    /// and an enabled instance mask (vertex color) feature extractor
+    bool ShouldMergeInstanceMask(const UNVSceneCapturerViewpointComponent* CapturedViewpoint) const;
+
 public: // Editor properties
     // ToDo: move to protected.
     /// If true, the exporter will use the current map's name for the export folder, otherwise it will use the ExportFolderName
@@ -157,6 +303,16 @@ protected: // Editor properties
     UPROPERTY(EditAnywhere, Category = "Save Path")
     ENVCaptureDirectoryConflictHandleType DirectoryConflictHandleType;
 
+    /// Number of frames exported in each sub-folder, the sub-folders are named by their index: 000000/, 000001/ ...
+    /// It keep the number of files in a directory small when exporting a lot of frames
+    /// NOTE: <= 0 mean all the frames are exported in the same directory
+    UPROPERTY(EditAnywhere, Category = "Save Path", meta = (UIMin = 0))
+    int32 FramesPerSubFolder;
+
+    /// Number of frame sub-folders to create ahead of the frame being exported
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Save Path", meta = (UIMin = 1, EditCondition = "FramesPerSubFolder > 0"))
+    int32 PreCreatedSubFolderCount;
+
     /// If true, this exporter will automatically open the exported directory after it finish exporting
     UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Capture")
     bool bAutoOpenExportedDirectory;
@@ -164,6 +320,68 @@ protected: // Editor properties
     UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
     uint32 MaxSaveImageAsyncCount;
 
+    /// If true, the exporter list the files exported in each frame of each viewpoint in the frame manifest (_frame_manifest.jsonl)
+    /// NOTE: The frames don't have the same files when the feature extractors use different capture cadences
+    UPROPERTY(EditAnywhere, Category = "Capture")
+    bool bExportFrameManifest;
+
+    /// If true, the annotation data of each viewpoint and annotation feature extractor are written to a sequence file (_sequence<postfix>.jsonl)
+    /// instead of one json file per frame: an object table with the static fields of the objects and, for each frame,
+    /// only the dynamic fields of the objects which changed since the previous frame
+    /// NOTE: FNVSequenceAnnotationWriter::ReadSequenceFile expand the sequence file back to the per-frame annotation data
+    UPROPERTY(EditAnywhere, Category = "Capture")
+    bool bExportSequenceAnnotation;
+
+    /// How the annotation data are compressed, Stream compress the records by blocks and DictionaryRecords compress each record
+    /// with a dictionary saved next to the stream files: FNVCompressedAnnotationStreamWriter::ReadStreamFile read the compressed stream files back
+    /// NOTE: Ignored when bExportSequenceAnnotation is true
+    UPROPERTY(EditAnywhere, Category = "Annotation Compression")
+    ENVAnnotationCompressionMode AnnotationCompressionMode;
+
+    UPROPERTY(EditAnywhere, Category = "Annotation Compression", meta = (EditCondition = "AnnotationCompressionMode == ENVAnnotationCompressionMode::Stream"))
+    ENVAnnotationCompressionFormat AnnotationCompressionFormat;
+
+    /// Number of frames in each compressed stream file, the stream roll over to a new file after that
+    /// NOTE: <= 0 mean all the frames of a stream are in the same file
+    UPROPERTY(EditAnywhere, Category = "Annotation Compression", meta = (UIMin = 0, EditCondition = "AnnotationCompressionMode != ENVAnnotationCompressionMode::None"))
+    int32 CompressedStreamFramesPerFile;
+
+    /// Size (in KB) of the records compressed together in a block of a stream file,
+    /// the bigger blocks compress better but a crash lose more records
+    /// NOTE: In DictionaryRecords mode it's the size of the compressed records buffered before they're written
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Annotation Compression", meta = (ClampMin = 1, EditCondition = "AnnotationCompressionMode != ENVAnnotationCompressionMode::None"))
+    int32 CompressedStreamBlockSizeKB;
+
+    /// Number of frames of each stream the dictionary is trained on in DictionaryRecords mode, they're written once it's trained
+    /// NOTE: A checkpoint train the dictionaries on the frames received so far
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Annotation Compression", meta = (ClampMin = 1, EditCondition = "AnnotationCompressionMode == ENVAnnotationCompressionMode::DictionaryRecords"))
+    int32 CompressedDictionaryTrainingFrameCount;
+
+    /// Maximum number of files can be queued to be written to disk at the same time
+    /// NOTE: <= 0 mean no limit
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = "Capture")
+    int32 MaxFileWriteInFlightCount;
+
+    /// If true, the frames whose color image look nearly identical to one of the recently exported frames of the same viewpoint
+    /// are dropped along with all their data (annotation, masks ...)
+    /// NOTE: The exported file names keep the captured frame index so the dropped frames leave gaps in the sequence
+    UPROPERTY(EditAnywhere, Category = "Duplicate Frame Filter")
+    bool bSkipDuplicateFrames;
+
+    /// Number of the last exported frames of a viewpoint to compare each new frame with
+    UPROPERTY(EditAnywhere, Category = "Duplicate Frame Filter", meta = (ClampMin = 1, UIMax = 32, EditCondition = "bSkipDuplicateFrames"))
+    int32 DuplicateFrameHistoryCount;
+
+    /// Maximum number of different bits (out of 64) between the perceptual hashes of 2 frames for them to be considered duplicated
+    UPROPERTY(EditAnywhere, Category = "Duplicate Frame Filter", meta = (ClampMin = 0, ClampMax = 64, EditCondition = "bSkipDuplicateFrames"))
+    int32 DuplicateFrameHashThreshold;
+
+    /// Number of frames between 2 checkpoints of the capture journal, the capturer wait for all the captured data to be written
+    /// before recording a checkpoint so the capturing can be resumed from it (-Resume) after a crash
+    /// NOTE: <= 0 mean the capture journal is not written
+    UPROPERTY(EditAnywhere, Category = "Checkpoint", meta = (UIMin = 0))
+    int32 CheckpointFrameInterval;
+
 protected: // Transient
     UPROPERTY(Transient)
     FString SubFolderName;
@@ -174,6 +392,59 @@ protected: // Transient
     TUniquePtr<FNVImageExporter_Thread> ImageExporterThread;
     IImageWrapperModule* ImageWrapperModule;
 
+    /// Write all the exported files (images and annotation data) to disk
+    TSharedPtr<INVFileSink, ESPMode::ThreadSafe> FileSink;
+
+    /// Map between a (viewpoint, feature extractor) pair and the postfix of its exported file names
+    TMap<TPair<FObjectKey, FObjectKey>, FString> ExportFileNamePostfixMap;
+
+    /// The frame sub-folders in [CreatedSubFolderStart, CreatedSubFolderEnd) are created on disk
+    int32 CreatedSubFolderStart;
+    int32 CreatedSubFolderEnd;
+
+    /// Background task creating the next frame sub-folders: [CreatedSubFolderEnd, SubFolderCreationTaskEnd)
+    TFuture<void> SubFolderCreationTask;
+    int32 SubFolderCreationTaskEnd;
+    FCriticalSection SubFolderLock;
+
+    /// Pair the annotation data with the instance mask of the same frame to fill in the visible bounding boxes
+    TSharedPtr<FNVInstanceMaskAnnotationMerger, ESPMode::ThreadSafe> InstanceMaskAnnotationMerger;
+
+    /// Hold back the data of each frame until its color image is checked for duplication
+    /// NOTE: Only valid when bSkipDuplicateFrames is true
+    TSharedPtr<FNVDuplicateFrameFilter, ESPMode::ThreadSafe> DuplicateFrameFilter;
+
+    /// Map between a viewpoint and the feature extractor of the color image used to check its duplicated frames
+    TMap<FObjectKey, FObjectKey> DuplicateFrameCheckExtractorMap;
+
+    /// The instance to class lookup table of the scene each frame (viewpoint, frame index) is captured in,
+    /// used to remap its instance mask to the class mask once it's read back
+    TMap<TPair<FObjectKey, int32>, TSharedPtr<const FNVInstanceClassLUT, ESPMode::ThreadSafe>> FrameInstanceClassLUTMap;
+    FCriticalSection FrameInstanceClassLUTLock;
+
+    /// Record the progress of the capturing session
+    FNVCaptureJournal CaptureJournal;
+
+    /// List the files exported in each frame
+    FNVFrameManifest FrameManifest;
+
+    /// Write the annotation data as object tables and per-frame deltas
+    /// NOTE: Only open when bExportSequenceAnnotation is true
+    FNVSequenceAnnotationWriter SequenceAnnotationWriter;
+
+    /// Stream the annotation data into rolling compressed json-lines files
+    /// NOTE: Only open when AnnotationCompressionMode isn't None
+    FNVCompressedAnnotationStreamWriter CompressedAnnotationStreamWriter;
+
+    /// Map between the file path of a tiled image and the writer streaming its tiles to disk
+    TMap<FString, TSharedPtr<FNVImageBandWriter, ESPMode::ThreadSafe>> TiledImageWriterMap;
+    FCriticalSection TiledImageWriterLock;
+
+    /// Number of tiled image bands being written
+    FThreadSafeCounter PendingTiledImageWriteCount;
+
+    bool bResumingCapture;
+
     static const FString DefaultDataOutputFolder;
 };
 
@@ -11,6 +11,7 @@
 #include "Engine/TextureRenderTarget2D.h"
 #include "NVSceneCapturerUtils.h"
 #include "NVTextureReader.h"
+#include "UObject/ObjectKey.h"
 #include "NVSceneFeatureExtractor.generated.h"
 
 class UNVSceneCapturerViewpointComponent;
@@ -18,6 +19,51 @@ class ANVSceneCapturerActor;
 class UNVSceneCaptureComponent2D;
 class UNVSceneFeatureExtractor;
 
+UENUM(BlueprintType)
+enum class ENVCaptureCadenceType : uint8
+{
+    /// Capture every frame
+    EveryFrame UMETA(DisplayName = "Every frame"),
+
+    /// Capture one frame every FrameInterval frames, starting from frame FrameOffset
+    FrameInterval UMETA(DisplayName = "Every N frames"),
+
+    /// Capture each frame with a probability, drawn from the capturer's cadence random stream
+    Probability UMETA(DisplayName = "Random frames"),
+
+    CaptureCadenceType_MAX UMETA(Hidden)
+};
+
+/// How often a feature extractor capture the scene
+USTRUCT(BlueprintType)
+struct NVSCENECAPTURER_API FNVCaptureCadence
+{
+    GENERATED_BODY()
+
+public:
+    FNVCaptureCadence();
+
+    /// Check whether a frame should be captured
+    /// @param RandomValue - Random number in the [0, 1) range, only used by the probability cadence
+    bool IsDueAtFrame(int32 FrameIndex, float RandomValue) const;
+
+public:
+    UPROPERTY(EditAnywhere, Category = Cadence)
+    ENVCaptureCadenceType CadenceType;
+
+    /// Number of frames between 2 captured frames
+    UPROPERTY(EditAnywhere, Category = Cadence, meta = (ClampMin = 1, EditCondition = "CadenceType == ENVCaptureCadenceType::FrameInterval"))
+    int32 FrameInterval;
+
+    /// Index of the first captured frame
+    UPROPERTY(EditAnywhere, Category = Cadence, meta = (ClampMin = 0, EditCondition = "CadenceType == ENVCaptureCadenceType::FrameInterval"))
+    int32 FrameOffset;
+
+    /// Chance for each frame to be captured
+    UPROPERTY(EditAnywhere, Category = Cadence, meta = (ClampMin = 0, ClampMax = 1, EditCondition = "CadenceType == ENVCaptureCadenceType::Probability"))
+    float Probability;
+};
+
 USTRUCT(BlueprintType)
 struct NVSCENECAPTURER_API FNVFeatureExtractorSettings
 {
@@ -26,6 +72,39 @@ struct NVSCENECAPTURER_API FNVFeatureExtractorSettings
 public:
     UPROPERTY(EditAnywhere, Instanced, Category = FeatureExtraction, meta = (ShowOnlyInnerProperties))
     UNVSceneFeatureExtractor* FeatureExtractorRef;
+
+    /// How often the feature extractor capture the scene, the frames it skip don't have its data
+    UPROPERTY(EditAnywhere, Category = FeatureExtraction)
+    FNVCaptureCadence CaptureCadence;
+};
+
+///
+/// The random values the probability cadences of a frame are decided with: one value per feature extractor settings,
+/// so all the viewpoints using the same settings capture the same frames (e.g: both images of a stereo pair).
+/// The values are drawn from a stream seeded with the run seed and the frame index: they don't touch the global random stream
+/// the scene is randomized with, and a resumed capture draw the same values for the same frames.
+///
+struct NVSCENECAPTURER_API FNVCaptureCadenceDraws
+{
+public:
+    /// Forget the values of the previous frame and seed the stream for the new one
+    void BeginFrame(int32 RunSeed, int32 FrameIndex);
+
+    /// Draw one value for each settings in the list, in order
+    void DrawSettings(const TArray<FNVFeatureExtractorSettings>& SettingsList);
+
+    /// Draw the value of a feature extractor settings
+    /// NOTE: The settings which already have a value in this frame keep it, the draw still happen so the next values don't change
+    /// @param SettingsKey - The feature extractor referenced by the settings (FeatureExtractorRef)
+    void DrawRandomValue(const FObjectKey& SettingsKey);
+
+    /// The value drawn for the settings of a feature extractor this frame, 0 if it wasn't drawn
+    /// @param SettingsKey - The feature extractor referenced by the settings (FeatureExtractorRef)
+    float GetRandomValue(const FObjectKey& SettingsKey) const;
+
+protected:
+    FRandomStream RandomStream;
+    TMap<FObjectKey, float> RandomValues;
 };
 
 ///
@@ -46,6 +125,19 @@ public:
 
     void Init(UNVSceneCapturerViewpointComponent* InOwnerViewpoint);
 
+    /// @param NewCaptureCadenceSettingsKey - The feature extractor referenced by the settings the cadence come from,
+    ///                                       the feature extractors created from the same settings capture the same frames
+    void SetCaptureCadence(const FNVCaptureCadence& NewCaptureCadence, const FObjectKey& NewCaptureCadenceSettingsKey);
+    const FNVCaptureCadence& GetCaptureCadence() const;
+
+    /// Decide whether this feature extractor capture the frame
+    /// NOTE: Must be called once per frame, before the frame is captured
+    /// @param CadenceDraws - The random values of the frame, already drawn for the settings of this feature extractor
+    void UpdateCaptureSchedule(int32 FrameIndex, const FNVCaptureCadenceDraws& CadenceDraws);
+
+    /// Whether this feature extractor capture the current frame
+    bool IsScheduledToCapture() const;
+
     virtual void StartCapturing();
     virtual void StopCapturing();
 
@@ -75,6 +167,11 @@ protected: // Transient properties
     UNVSceneCapturerViewpointComponent* OwnerViewpoint;
     UPROPERTY(Transient)
     bool bCapturing;
+    UPROPERTY(Transient)
+    FNVCaptureCadence CaptureCadence;
+    FObjectKey CaptureCadenceSettingsKey;
+    UPROPERTY(Transient)
+    bool bScheduledToCapture;
 };
 
 USTRUCT()
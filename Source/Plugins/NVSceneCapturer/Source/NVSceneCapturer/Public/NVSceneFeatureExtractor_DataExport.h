@@ -10,6 +10,8 @@
 #include "NVSceneFeatureExtractor.h"
 #include "NVSceneCapturerUtils.h"
 #include "Runtime/Engine/Public/ConvexVolume.h"
+#include "NVSceneAnnotationSnapshot.h"
+#include "NVActorAnnotationCache.h"
 #include "NVSceneFeatureExtractor_DataExport.generated.h"
 
 USTRUCT(BlueprintType)
@@ -36,6 +38,11 @@ public:
     UPROPERTY(EditAnywhere, Category = "Export")
     ENVBoundBox2dGenerationType BoundingBox2dType = ENVBoundBox2dGenerationType::FromMeshBodyCollision;
 
+    /// If true, the 2D bounding box of the skeletal meshes only project the corners of their physics bodies' bounds
+    /// NOTE: Much cheaper for crowds of animated actors but the box is looser than with all the body shapes' vertexes
+    UPROPERTY(EditAnywhere, Category = "Export", meta = (EditCondition = "BoundingBox2dType == ENVBoundBox2dGenerationType::FromMeshBodyCollision"))
+    bool bApproximateSkeletalBodiesWithBounds = false;
+
     UPROPERTY(EditAnywhere, Category = "Export")
     bool bOutputEvenIfNoObjectsAreInView = true;
 
@@ -45,6 +52,11 @@ public:
     /// If true, export absolute pixel coordinates; otherwise, normalized [0,1] ratios
     UPROPERTY(EditAnywhere, Category = "Export")
     bool bExportImageCoordinateInPixel = true;
+
+    /// The fields exported for each object, e.g: only the location and rotation for a 6-DoF pose dataset
+    /// NOTE: The data the omitted fields need (occlusion traces, mesh vertexes, sockets ...) aren't gathered at all
+    UPROPERTY(EditAnywhere, Category = "Export")
+    FNVAnnotationSchema AnnotationSchema;
 };
 
 // ============================================================================
@@ -59,6 +71,7 @@ public:
     UNVSceneFeatureExtractor_AnnotationData(const FObjectInitializer &ObjectInitializer);
 
     virtual void StartCapturing() override;
+    virtual void StopCapturing() override;
     virtual void UpdateCapturerSettings() override;
     virtual void UpdateSettings() override;
 
@@ -69,14 +82,60 @@ public:
     /// Capture the annotation data of the scene and return it in JSON format
     bool CaptureSceneAnnotationData(OnFinishedCaptureSceneAnnotationDataCallback Callback);
 
+    /// The export settings used by the current capturing session
+    const FNVDataExportSettings& GetDataExportSettings() const
+    {
+        return ProtectedDataExportSettings;
+    }
+
+    /// If true, the 2D bounding boxes are not projected from the mesh but filled in from the instance mask of the same viewpoint
+    bool ShouldUseInstanceMaskBoundingBox() const;
+
+    /// The fields of the objects computed and exported by the current capturing session
+    const FNVAnnotationFieldSet& GetAnnotationFields() const
+    {
+        return AnnotationFields;
+    }
+
+    /// Statistics of the static actor cache for the current capturing session
+    const FNVActorAnnotationCacheStats& GetActorAnnotationCacheStats() const
+    {
+        return ActorAnnotationCache.GetStats();
+    }
+
+    /// Take a snapshot of the scene data the annotation need, must run on the game thread
+    /// NOTE: The snapshot is cheap compared to the annotation itself, which can be built later on any thread
+    FNVSceneAnnotationSnapshotRef CaptureSceneAnnotationSnapshot(int32 FrameIndex);
+
+    /// Compute the annotation data of a scene snapshot and convert it to JSON
+    /// NOTE: Doesn't touch any UObject so it's safe to call from worker threads
+    static TSharedPtr<FJsonObject> BuildSceneAnnotationData(const FNVSceneAnnotationSnapshot &Snapshot);
+
 protected:
     TSharedPtr<FJsonObject> CaptureSceneAnnotationData_Internal();
 
     void UpdateProjectionMatrix();
 
     /// Collects all actor data into FCapturedObjectData
+    /// NOTE: Same result as GatherActorInput followed by ComputeActorData, the parallel path only split the 2 phases
     bool GatherActorData(const AActor *CheckActor, FCapturedObjectData &ActorData);
 
+    /// The view data of the current frame, must be called after UpdateProjectionMatrix
+    FNVAnnotationViewContext MakeAnnotationViewContext() const;
+
+    /// Reads everything the annotation of the actor need from its UObjects, must run on the game thread
+    /// NOTE: The world space data of the actors which didn't change since the previous frames are reused from the cache
+    bool GatherActorInput(const AActor *CheckActor, const FNVAnnotationViewContext &ViewContext, FNVActorAnnotationInput &ActorInput);
+
+    /// Reads the annotation input of each exported instance of the actor's instanced static meshes, must run on the game thread
+    /// @return false if the actor doesn't export any mesh instance, it's then exported as a whole
+    bool GatherMeshInstanceInputs(const AActor *CheckActor, const FNVAnnotationViewContext &ViewContext, TArray<FNVActorAnnotationInput> &OutInstanceInputs);
+
+    /// Computes the fields of the annotation of an actor from its gathered input
+    /// NOTE: Doesn't touch any UObject so it's safe to call from worker threads
+    static void ComputeActorData(const FNVAnnotationViewContext &ViewContext, const FNVAnnotationFieldSet &AnnotationFields,
+                                 const FNVActorAnnotationInput &ActorInput, FCapturedObjectData &ActorData);
+
     /// Whether to include this actor in the export
     bool ShouldExportActor(const AActor *CheckActor) const;
 
@@ -86,19 +145,32 @@ protected:
     /// Projects a world-space position to image-space coordinates
     FVector ProjectWorldPositionToImagePosition(const FVector &WorldPosition) const;
 
-    /// Gets 2D bounding box of the actor (projected on image)
-    FBox2D GetBoundingBox2D(const AActor *CheckActor, bool bClampToImage = true) const;
+    /// Collects the vertexes of the mesh components of the actor used to calculate its 2D bounding box
+    /// @param bUseSkeletalBodyBounds - If true, the skeletal meshes' bodies are approximated by their bounds
+    /// @param bSkeletalMeshesOnly    - If true, only collects the skeletal meshes' bodies, they must be gathered every frame since their bones move
+    static void GatherMeshBoundVertexSources(const AActor *CheckActor, bool bUseSkeletalBodyBounds, TArray<FNVMeshBoundVertexSource> &OutVertexSources,
+                                             bool bSkeletalMeshesOnly = false);
 
-    /// Calculates 2D AABB of a 3D vertex list on the viewport
-    FBox2D Calculate2dAABB(TArray<FVector> Vertexes, bool bClampToImage = true) const;
+    /// Gets 2D bounding box of the actor (projected on image) from its mesh vertexes
+    static FBox2D GetBoundingBox2D(const FNVAnnotationViewContext &ViewContext, const TArray<FNVMeshBoundVertexSource> &VertexSources, bool bClampToImage = true);
 
-    /// Calculates 2D AABB of a static mesh using complex collision data
-    FBox2D Calculate2dAABB_MeshComplexCollision(const class UMeshComponent *CheckMeshComp, bool bClampToImage = true) const;
+    /// Calculates 2D AABB of the vertexes of a mesh component on the viewport
+    static FBox2D Calculate2dAABB(const FNVAnnotationViewContext &ViewContext, const FNVMeshBoundVertexSource &VertexSource, bool bClampToImage = true);
 
 protected: // Editor properties
     UPROPERTY(EditAnywhere, SimpleDisplay, Category = Config, meta = (ShowOnlyInnerProperties = true))
     FNVDataExportSettings DataExportSettings;
 
+    /// If true, the cuboid and mesh geometry of the actors which didn't change since the previous frames are reused instead of recomputed
+    /// NOTE: An actor is changed if its transform, bounds, meshes or mask id changed or its capturable tag is marked dirty
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = Config)
+    bool bCacheStaticActorAnnotation = true;
+
+    /// If true, the cached actors also reuse their occlusion while the viewpoint doesn't move
+    /// NOTE: Only correct if the other actors don't move in front of them either, the occluders aren't tracked
+    UPROPERTY(EditAnywhere, AdvancedDisplay, Category = Config, meta = (EditCondition = "bCacheStaticActorAnnotation"))
+    bool bCacheStaticActorOcclusion = false;
+
     UPROPERTY(Transient)
     FMatrix ViewProjectionMatrix = FMatrix::Identity;
 
@@ -107,4 +179,10 @@ protected: // Editor properties
 
 protected: // Runtime copy of the export settings
     FNVDataExportSettings ProtectedDataExportSettings;
+
+    /// The annotation schema of the export settings resolved with its dependencies
+    FNVAnnotationFieldSet AnnotationFields;
+
+    /// World space annotation data of the actors, kept between the frames
+    FNVActorAnnotationCache ActorAnnotationCache;
 };
@@ -12,6 +12,8 @@
 #include "NVSceneCapturerUtils.h"
 #include "NVTextureReader.h"
 #include "NVSceneFeatureExtractor.h"
+#include "NVTiledCapture.h"
+#include "NVRenderProfile.h"
 #include "Materials/MaterialInterface.h"
 #include "NVSceneFeatureExtractor_ImageExport.generated.h"
 
@@ -36,6 +38,16 @@ public:
 
     virtual bool CaptureSceneToPixelsData(UNVSceneFeatureExtractor_PixelData::OnFinishedCaptureScenePixelsDataCallback Callback);
 
+    /// Callback function get called after a tile of the scene is captured and its pixels data is read back
+    /// FNVTexturePixelData - The struct contain the captured tile's pixels data
+    /// FNVCaptureTile - The tile which is captured
+    /// UNVSceneFeatureExtractor_PixelData* - Reference to the feature extractor that captured the tile
+    typedef TFunction<void(const FNVTexturePixelData&, const FNVCaptureTile&, UNVSceneFeatureExtractor_PixelData*)> OnFinishedCaptureSceneTileCallback;
+
+    /// Capture the scene tile by tile, the callback get called once for each tile which is captured
+    /// @return Number of tiles which are captured by all the scene capture components
+    virtual int32 CaptureSceneTilesToPixelsData(const TArray<FNVCaptureTile>& Tiles, UNVSceneFeatureExtractor_PixelData::OnFinishedCaptureSceneTileCallback Callback);
+
     virtual void StartCapturing() override;
     virtual void StopCapturing() override;
     virtual void UpdateCapturerSettings() override;
@@ -44,6 +56,21 @@ public:
 
     virtual class UTextureRenderTarget2D* GetRenderTarget() const;
 
+    /// Number of pixels data this feature extractor read back each time it capture the scene
+    int32 GetCapturedPixelsDataCount() const;
+
+    /// Get all the scene capture components this feature extractor use to capture the scene
+    void GetSceneCaptureComponents(TArray<UNVSceneCaptureComponent2D*>& OutSceneCaptureComponents) const;
+
+    /// Only read back a region of the captured images
+    /// @param NewReadbackRegion     The region (in pixels) to read back, empty to read back the whole images
+    void SetReadbackRegion(const FIntRect& NewReadbackRegion);
+
+    const FNVRenderProfile& GetRenderProfile() const
+    {
+        return RenderProfile;
+    }
+
 protected:
     virtual void UpdateSettings() override;
     virtual void UpdateMaterial();
@@ -57,6 +84,11 @@ protected: // Editor properties
     UPROPERTY(EditInstanceOnly, Category = Config)
     TArray<AActor*> IgnoreActors;
 
+    /// The rendering features the scene capture components need, e.g: the depth and masks only need the geometry
+    /// NOTE: The override show flags are applied on top of the profile
+    UPROPERTY(EditDefaultsOnly, Category = Config)
+    FNVRenderProfile RenderProfile;
+
     UPROPERTY(EditDefaultsOnly, Category = Config, meta = (PinHiddenByDefault, InlineEditConditionToggle))
     bool bOverrideShowFlagSettings;
 
@@ -153,6 +185,26 @@ class NVSCENECAPTURER_API UNVSceneFeatureExtractor_VertexColorMask : public UNVS
 public:
     UNVSceneFeatureExtractor_VertexColorMask(const FObjectInitializer& ObjectInitializer);
 
+    /// Check whether the class segmentation mask is remapped from the instance mask and exported along with it
+    bool ShouldExportClassSegmentationMask() const
+    {
+        return IsEnabled() && bExportClassSegmentationMask;
+    }
+
+    /// The path of the class segmentation mask exported along with an instance mask
+    FString GetClassSegmentationMaskFilePath(const FString& InstanceMaskFilePath) const;
+
 protected:
     virtual void UpdateSettings() override;
+
+protected: // Editor properties
+    /// If true, the class segmentation mask is also exported: it's remapped from this instance mask on the CPU,
+    /// with the same class ids as the StencilMask feature extractor
+    /// NOTE: The StencilMask feature extractor can then be disabled, saving one scene render per viewpoint per frame
+    UPROPERTY(EditAnywhere, Category = Config)
+    bool bExportClassSegmentationMask;
+
+    /// The string to add to the end of the class segmentation mask's file name
+    UPROPERTY(EditAnywhere, Category = Config, meta = (EditCondition = "bExportClassSegmentationMask"))
+    FString ClassSegmentationMaskFileNamePostfix;
 };
@@ -63,6 +63,9 @@ public:
     /// Get scene capturing state.
     ENVSceneManagerState GetState() const;
 
+    /// Index of the scene marker the capturers are capturing at
+    int32 GetCurrentMarkerIndex() const;
+
     /// if state is CAPTURED, this change the state to READY.
     UFUNCTION(BlueprintCallable, Category = "Capturer")
     void ResetState();
@@ -89,6 +92,9 @@ protected:
     void FocusNextMarker();
     bool IsAllSceneCaptured() const;
 
+    /// Find the earliest scene marker the active capturers need to resume capturing from
+    int32 GetResumeMarkerIndex();
+
 	UFUNCTION()
     virtual void OnCapturingCompleted(ANVSceneCapturerActor* SceneCapturer, bool bIsSucceeded);
 
@@ -134,4 +140,8 @@ protected: // Transient properties
 
     UPROPERTY(Transient)
     int32 CurrentMarkerIndex;
+
+    /// If true, continue capturing from the last checkpoint of the capturers (-Resume)
+    UPROPERTY(Transient)
+    bool bResumeFromCheckpoint;
 };
@@ -0,0 +1,94 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+
+class IFileHandle;
+
+///
+/// Write the annotation data of a sequence of frames as an object table and per-frame deltas instead of one full json file per frame.
+/// Each stream (viewpoint and annotation feature extractor) has its own append-only sequence file, one json object per line:
+/// - Object table record, written before the frame an object first appears in, one row per object with its static fields:
+///   {"marker_index":0,"object_table":[{"index":0,"class":"Cube","instance_id":42,"object_settings":{"cuboid_dimensions":...}}]}
+/// - Frame record, the scene fields (camera_data ...) in full and only the dynamic fields of the objects which changed since the previous record:
+///   {"frame_index":12,"base_frame_index":11,"scene":{"camera_data":{...},"objects":null},"objects":[{"index":0,"location":...}],"removed_objects":[3]}
+/// The objects of a frame are listed in the order of their index unless the frame has an "object_order" list.
+/// A frame record whose base_frame_index is -1 is a key frame: it list all its objects, e.g: the first frame of a capturing session.
+/// NOTE: The frames are expanded back in the order they're written, which is not always the order of their index
+/// NOTE: A resumed session capture the frames after the last checkpoint again, the last record of a frame is the valid one
+///
+class NVSCENECAPTURER_API FNVSequenceAnnotationWriter
+{
+public:
+    FNVSequenceAnnotationWriter();
+    ~FNVSequenceAnnotationWriter();
+
+    /// Extension of the sequence files
+    static const FString SequenceFileExtension;
+
+    /// Fields of the exported objects which don't change during a sequence, they're only written in the object table
+    /// NOTE: They come first in the exported objects so the expanded objects keep the same field order
+    static const TArray<FString> StaticObjectFieldNames;
+
+    /// Start a new sequence, the sequence files are opened when their first frame is written
+    /// @param MarkerIndex - Index of the scene marker the sequence is captured at
+    /// @param bAppend - If true, keep the records already in the sequence files, otherwise start new sequence files
+    void Open(int32 MarkerIndex, bool bAppend);
+    void Close();
+    bool IsOpen() const;
+
+    /// Set the static description of the exported object classes (cuboid dimensions, fixed model transform ...), added to the object table rows
+    /// @param InObjectClassSettings - Map between an object class and its settings
+    void SetObjectClassSettings(const TMap<FString, TSharedPtr<FJsonObject>>& InObjectClassSettings);
+
+    /// Write the annotation data of a frame as a delta from the previous frame written to the same sequence file
+    /// @param SequenceFilePath - Path of the sequence file of the stream which captured the frame
+    /// @param FrameIndex - The frame when the data is captured
+    /// @param AnnotationData - The full annotation data of the frame
+    /// NOTE: This function is thread-safe
+    bool WriteFrame(const FString& SequenceFilePath, int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData);
+
+    /// Make sure all the records written so far are on the disk
+    void Flush();
+
+    /// Read a sequence file and expand its records back to the full annotation data of each frame
+    /// @param FrameCallback - Called for each frame record in the order they're written with the same data the per-frame json file would have
+    /// @return false if the file can't be read or one of its records can't be expanded
+    /// NOTE: The objects which don't change are shared between the expanded frames, the callback mustn't modify them
+    static bool ReadSequenceFile(const FString& SequenceFilePath, TFunctionRef<void(int32 FrameIndex, const TSharedPtr<FJsonObject>& AnnotationData)> FrameCallback);
+
+protected:
+    /// State of a sequence file: the objects it already has in its table and the last written data of each of them
+    struct FSequenceStream
+    {
+        TUniquePtr<IFileHandle> FileHandle;
+
+        /// Map between the key of an object and its index in the object table
+        TMap<FString, int32> ObjectIndexMap;
+
+        /// The dynamic fields of each object in the table (condensed json) as of the last written frame
+        TArray<FString> LastObjectDataList;
+
+        /// Whether each object in the table is in the last written frame
+        TBitArray<> LastObjectFlags;
+
+        int32 LastFrameIndex = INDEX_NONE;
+    };
+
+    FSequenceStream* FindOrOpenStream(const FString& SequenceFilePath);
+    static bool WriteRecord(IFileHandle& FileHandle, const TSharedRef<FJsonObject>& RecordJsonObj);
+
+protected:
+    TMap<FString, TUniquePtr<FSequenceStream>> StreamMap;
+    TMap<FString, TSharedPtr<FJsonObject>> ObjectClassSettings;
+    int32 CurrentMarkerIndex;
+    bool bIsOpen;
+    bool bAppendToSequenceFiles;
+    mutable FCriticalSection WriterLock;
+};
@@ -17,6 +17,8 @@ struct NVSCENECAPTURER_API FNVTextureReader
 {
     GENERATED_BODY()
 
+    friend class FNVSceneCaptureAtlas;
+
 public:
     FNVTextureReader();
     virtual ~FNVTextureReader();
@@ -42,6 +44,32 @@ public:
     /// NOTE: This function is sync, the pixels data is returned right away but it may cause the game to hitches since it flush the rendering commands
     virtual bool ReadPixelsData(FNVTexturePixelData &OutPixelsData);
 
+    /// Let the async readbacks stay in flight on the GPU for a few frames instead of stalling the rendering thread until they're copied
+    /// @param NewMaxPendingFrames   Number of frames a readback can stay in flight before the rendering thread wait for it, 0 mean read back right away
+    /// NOTE: This setting is shared by all the texture readers
+    static void SetMaxPendingReadbackFrames(int32 NewMaxPendingFrames);
+    static int32 GetMaxPendingReadbackFrames();
+
+    /// Invoke the callbacks of the pending readbacks which are already copied on the GPU
+    /// NOTE: Should be called every frame while there are pending readbacks, the callbacks are invoked on the rendering thread
+    static void ProcessPendingReadbacks();
+
+    /// Wait for all the pending readbacks to be copied and invoke their callbacks
+    /// NOTE: This function is sync, it flush the rendering commands
+    static void FlushPendingReadbacks();
+
+    /// Read the pixel data from a texture
+    /// NOTE: Must be called on the rendering thread, use ReadPixelsRaw on the game thread
+    /// @param MaxPendingFrames      Number of frames the readback can stay in flight before the rendering thread wait for it, 0 mean read back right away
+    static void ReadPixelsRaw_RenderThread(FRHICommandListImmediate &RHICmdList,
+                                           const FTextureRHIRef &SourceTexture,
+                                           const FIntRect &SourceRect,
+                                           EPixelFormat TargetPixelFormat,
+                                           const FIntPoint &TargetSize,
+                                           bool bIgnoreAlpha,
+                                           int32 MaxPendingFrames,
+                                           OnFinishedReadingRawPixelsCallback Callback);
+
 protected:
     /// Change the information of the texture to read from
     /// @param NewSourceTexture          The texture to read from
@@ -91,6 +119,11 @@ protected:
                               bool bIgnoreAlpha,
                               OnFinishedReadingRawPixelsCallback Callback);
 
+    /// Invoke the callbacks of the pending readbacks which are finished, or too old to keep waiting for
+    /// NOTE: Must be called on the rendering thread
+    /// @param bFlushAll             If true, wait for all the pending readbacks to finish
+    static void ProcessPendingReadbacks_RenderThread(FRHICommandListImmediate &RHICmdList, int32 MaxPendingFrames, bool bFlushAll);
+
     static FNVTexturePixelData BuildPixelData(uint8 *PixelsData, EPixelFormat PixelFormat, const FIntPoint &ImageSize, const FIntPoint &TargetSize);
     static void BuildPixelData(FNVTexturePixelData &OutPixelsData, uint8 *PixelsData, EPixelFormat PixelFormat, const FIntPoint &ImageSize, const FIntPoint &TargetSize);
 
@@ -129,6 +162,13 @@ public:
     }
     void SetTextureRenderTarget(UTextureRenderTarget2D *NewRenderTarget);
 
+    /// Get the texture of the render target and the pixel format its pixels are read back with
+    FTextureRHIRef GetRenderTargetTexture(EPixelFormat &OutReadbackPixelFormat);
+
+    /// Only read back a region of the render target
+    /// @param NewReadbackRegion     The region (in pixels) to read back, empty to read back the whole render target
+    void SetReadbackRegion(const FIntRect &NewReadbackRegion);
+
     virtual bool ReadPixelsData(FNVTexturePixelData &OutPixelData) final;
     virtual bool ReadPixelsData(OnFinishedReadingPixelsDataCallback Callback, bool bIgnoreAlpha = false) final;
 
@@ -138,4 +178,6 @@ protected:
 protected:
     UPROPERTY(Transient)
     UTextureRenderTarget2D *SourceRenderTarget;
+
+    FIntRect ReadbackRegion;
 };
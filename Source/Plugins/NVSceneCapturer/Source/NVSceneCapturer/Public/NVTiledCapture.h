@@ -0,0 +1,79 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NVSceneCapturerUtils.h"
+#include "NVTiledCapture.generated.h"
+
+/// Settings of the tiled capture mode: the images bigger than a tile are rendered tile by tile with a small render target
+USTRUCT(BlueprintType)
+struct NVSCENECAPTURER_API FNVTiledCaptureSettings
+{
+    GENERATED_BODY()
+
+public:
+    FNVTiledCaptureSettings();
+
+    /// If true, the images which are bigger than MaxTileSize are split into a grid of tiles rendered one after another
+    /// NOTE: The tiled images are streamed to disk band by band as PNG files whatever the exported image format
+    UPROPERTY(EditAnywhere, Category = "TiledCapture")
+    bool bEnabled;
+
+    /// The maximum width and height (in pixels) of a tile, it's also the size of the render target reused by all the tiles
+    UPROPERTY(EditAnywhere, Category = "TiledCapture", meta = (ClampMin = 64, EditCondition = "bEnabled"))
+    int32 MaxTileSize;
+};
+
+/// A tile of a tiled capture
+struct NVSCENECAPTURER_API FNVCaptureTile
+{
+    FNVCaptureTile();
+
+    /// Index of the tile in the grid, the tiles are ordered row by row from the top left corner
+    int32 TileIndex;
+
+    /// Number of columns and rows of tiles
+    FIntPoint GridSize;
+
+    /// The region (in pixels) of the full image the tile covers
+    /// NOTE: The tiles all have the same size so the last column and row can go past the full image
+    FIntRect Rect;
+
+    /// The 2d size (in pixels) of the full image
+    FIntPoint ImageSize;
+
+    /// The off-center projection matrix rendering only the tile's region of the full image's view
+    FMatrix ProjectionMatrix;
+
+    /// The region of the full image the tile covers, clipped to the full image
+    FIntRect GetClippedRect() const;
+};
+
+/// Helper functions to split the view of an image into a grid of off-center tiles
+struct NVSCENECAPTURER_API FNVTiledCapture
+{
+    /// Number of columns and rows of tiles needed to cover an image
+    static FIntPoint CalculateGridSize(const FIntPoint& ImageSize, int32 MaxTileSize);
+
+    /// The 2d size (in pixels) of the tiles covering an image, all the tiles have the same size
+    static FIntPoint CalculateTileSize(const FIntPoint& ImageSize, int32 MaxTileSize);
+
+    /// Split the view of the full image into tiles
+    /// @param FullProjectionMatrix  The projection matrix of the full image
+    /// @param ImageSize             The 2d size (in pixels) of the full image
+    /// @param MaxTileSize           The maximum width and height (in pixels) of a tile
+    static void BuildTiles(const FMatrix& FullProjectionMatrix, const FIntPoint& ImageSize, int32 MaxTileSize, TArray<FNVCaptureTile>& OutTiles);
+
+    /// Build the projection matrix of a tile: the full projection followed by a scale and offset in clip space
+    /// so the tile's region of the full image fill the whole tile
+    static FMatrix MakeTileProjectionMatrix(const FMatrix& FullProjectionMatrix, const FIntRect& TileRect, const FIntPoint& ImageSize);
+
+protected:
+    /// The clip space transform mapping the tile's region of the full image to the whole tile
+    static FMatrix MakeTileClipMatrix(const FIntRect& TileRect, const FIntPoint& ImageSize);
+};
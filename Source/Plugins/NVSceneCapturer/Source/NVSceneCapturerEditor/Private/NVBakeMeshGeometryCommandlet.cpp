@@ -0,0 +1,84 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#include "NVBakeMeshGeometryCommandlet.h"
+#include "NVSceneCapturerEditorModule.h"
+#include "NVMeshGeometry.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/StaticMesh.h"
+#include "StaticMeshCompiler.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+UNVBakeMeshGeometryCommandlet::UNVBakeMeshGeometryCommandlet()
+{
+    IsClient = false;
+    IsEditor = true;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UNVBakeMeshGeometryCommandlet::Main(const FString& Params)
+{
+    FString ContentPath = TEXT("/Game");
+    FParse::Value(*Params, TEXT("Path="), ContentPath);
+    const bool bForce = FParse::Param(*Params, TEXT("Force"));
+
+    IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+    AssetRegistry.SearchAllAssets(true);
+
+    FARFilter MeshFilter;
+    MeshFilter.PackagePaths.Add(FName(*ContentPath));
+    MeshFilter.bRecursivePaths = true;
+    MeshFilter.ClassPaths.Add(UStaticMesh::StaticClass()->GetClassPathName());
+
+    TArray<FAssetData> MeshAssets;
+    AssetRegistry.GetAssets(MeshFilter, MeshAssets);
+    UE_LOG(LogNVSceneCapturerEditor, Display, TEXT("Baking the geometry of %d static meshes in '%s'."), MeshAssets.Num(), *ContentPath);
+
+    int32 BakedMeshCount = 0;
+    int32 FailedMeshCount = 0;
+    for (const FAssetData& MeshAsset : MeshAssets)
+    {
+        UStaticMesh* StaticMesh = Cast<UStaticMesh>(MeshAsset.GetAsset());
+        if (!StaticMesh)
+        {
+            UE_LOG(LogNVSceneCapturerEditor, Warning, TEXT("Can't load static mesh '%s'."), *MeshAsset.GetObjectPathString());
+            FailedMeshCount++;
+            continue;
+        }
+
+        // NOTE: The render data of the mesh may still be built asynchronously
+        FStaticMeshCompilingManager::Get().FinishCompilation({ StaticMesh });
+
+        if (!FNVMeshGeometryCache::BakeMeshGeometry(StaticMesh, bForce))
+        {
+            continue;
+        }
+
+        UPackage* MeshPackage = StaticMesh->GetOutermost();
+        const FString PackageFilename = FPackageName::LongPackageNameToFilename(MeshPackage->GetName(), FPackageName::GetAssetPackageExtension());
+
+        FSavePackageArgs SaveArgs;
+        SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+        SaveArgs.Error = GError;
+        if (UPackage::SavePackage(MeshPackage, nullptr, *PackageFilename, SaveArgs))
+        {
+            UE_LOG(LogNVSceneCapturerEditor, Log, TEXT("Baked the geometry of mesh '%s'."), *StaticMesh->GetPathName());
+            BakedMeshCount++;
+        }
+        else
+        {
+            UE_LOG(LogNVSceneCapturerEditor, Error, TEXT("Can't save package '%s'."), *PackageFilename);
+            FailedMeshCount++;
+        }
+    }
+
+    UE_LOG(LogNVSceneCapturerEditor, Display, TEXT("Baked %d meshes, %d up to date, %d failed."),
+           BakedMeshCount, MeshAssets.Num() - BakedMeshCount - FailedMeshCount, FailedMeshCount);
+    return (FailedMeshCount > 0) ? 1 : 0;
+}
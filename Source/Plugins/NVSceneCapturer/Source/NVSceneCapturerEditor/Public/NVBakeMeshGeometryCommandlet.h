@@ -0,0 +1,29 @@
+/*
+* Copyright (c) 2018 NVIDIA Corporation. All rights reserved.
+* This work is licensed under a Creative Commons Attribution-NonCommercial-ShareAlike 4.0
+* International License.  (https://creativecommons.org/licenses/by-nc-sa/4.0/legalcode)
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "NVBakeMeshGeometryCommandlet.generated.h"
+
+///
+/// Bake the geometry the annotation need (PCA frame, OOBB, hull, vertex count) into the user data of all the static meshes in a content folder
+/// so it doesn't need to be computed at runtime.
+/// Usage: UnrealEditor-Cmd <Project> -run=NVBakeMeshGeometry [-Path=/Game/Folder] [-Force]
+///     -Path  : The content folder to bake the meshes in (recursively), default to /Game
+///     -Force : Rebake the meshes even if their baked geometry is up to date
+///
+UCLASS()
+class UNVBakeMeshGeometryCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UNVBakeMeshGeometryCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
@@ -18,6 +18,7 @@
 #include "DrawDebugHelpers.h"
 #include "NVSceneCapturerActor.h"
 #include "NVSceneCapturerUtils.h"
+#include "NVCaptureFarmMode.h"
 
 ANVSceneCapturerHUD::ANVSceneCapturerHUD(const FObjectInitializer& ObjectInitializer)
     : Super(ObjectInitializer)
@@ -45,6 +46,8 @@ ANVSceneCapturerHUD::ANVSceneCapturerHUD(const FObjectInitializer& ObjectInitial
     DebugCapturerPathLifeTime = 2.f;
     DebugCapturerDirectionLength = 20.f;
     DebugCapturerPathColor = FLinearColor::Green;
+
+    OverlayVisibilityBeforeCaptureFarm = ESlateVisibility::Visible;
 }
 
 void ANVSceneCapturerHUD::BeginPlay()
@@ -72,10 +75,15 @@ void ANVSceneCapturerHUD::BeginPlay()
     {
         DebugFont = GEngine->GetMediumFont();
     }
+
+    CaptureFarmModeChangedHandle = FNVCaptureFarmMode::OnCaptureFarmModeChanged().AddUObject(this, &ANVSceneCapturerHUD::OnCaptureFarmModeChanged);
 }
 
 void ANVSceneCapturerHUD::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+    FNVCaptureFarmMode::OnCaptureFarmModeChanged().Remove(CaptureFarmModeChangedHandle);
+    CaptureFarmModeChangedHandle.Reset();
+
     if (HUDOverlay)
     {
         HUDOverlay->RemoveFromParent();
@@ -111,6 +119,22 @@ void ANVSceneCapturerHUD::ToggleOverlay()
     }
 }
 
+void ANVSceneCapturerHUD::OnCaptureFarmModeChanged(bool bRenderingSuppressed)
+{
+    if (HUDOverlay)
+    {
+        if (bRenderingSuppressed)
+        {
+            OverlayVisibilityBeforeCaptureFarm = HUDOverlay->GetVisibility();
+            HUDOverlay->SetVisibility(ESlateVisibility::Collapsed);
+        }
+        else
+        {
+            HUDOverlay->SetVisibility(OverlayVisibilityBeforeCaptureFarm);
+        }
+    }
+}
+
 void ANVSceneCapturerHUD::SetShowExportActorDebug(bool bShowDebug)
 {
     bShowExportActorDebug = bShowDebug;
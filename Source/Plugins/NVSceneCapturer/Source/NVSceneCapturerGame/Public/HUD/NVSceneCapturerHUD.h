@@ -8,6 +8,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/HUD.h"
+#include "Components/SlateWrapperTypes.h"
 #include "NVSceneCapturerUtils.h"
 #include "NVSceneCapturerHUD.generated.h"
 
@@ -111,10 +112,19 @@ protected:
     void DrawProjectedLine(const FVector& Begin, const FVector& End, const FLinearColor& LineColor, float LineWidth = 1.f);
     void DrawDebugPoint2d(const FVector2D& ScreenLoc, const FLinearColor& PointColor = FLinearColor::Black, float Radius = 1.f);
 
+    /// Hide the overlay (and its PIP panel) while a capturer doesn't render the game viewport, restore it after
+    void OnCaptureFarmModeChanged(bool bRenderingSuppressed);
+
 protected: // Transient properties
     UPROPERTY(Transient)
     UNVSceneCapturerHUD_Overlay* HUDOverlay;
 
     UPROPERTY(Transient)
     FVector LastCapturerLocation;
+
+    /// The overlay's visibility before a capture farm mode hid it
+    UPROPERTY(Transient)
+    ESlateVisibility OverlayVisibilityBeforeCaptureFarm;
+
+    FDelegateHandle CaptureFarmModeChangedHandle;
 };